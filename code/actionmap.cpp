@@ -0,0 +1,167 @@
+#include "actionmap.h"
+
+#include <bit>
+#include <cstring>
+
+struct ActionMap
+{
+    ActionBinding m_Bindings[ACTIONMAP_MAX_BINDINGS];
+    u32 m_BindingCount;
+
+    // NOTE(sbalse): Compiled form. For every trigger and button, the set of bindings that require it. Only
+    // the first m_BindingWords words of each mask are used.
+    u64 m_Masks[static_cast<u32>(ActionTrigger::COUNT)][INPUT_NUM_BUTTONS][ACTIONMAP_BINDING_WORDS];
+    // NOTE(sbalse): Buttons that appear in at least one mask of the trigger, so evaluation can skip the rest.
+    u16 m_UsedButtons[static_cast<u32>(ActionTrigger::COUNT)][INPUT_NUM_BUTTONS];
+    u32 m_UsedButtonCounts[static_cast<u32>(ActionTrigger::COUNT)];
+    u64 m_ValidBindings[ACTIONMAP_BINDING_WORDS];
+    u32 m_BindingWords;
+};
+
+namespace
+{
+    bool ButtonSetTest(const InputButtonSet* set, const u32 button)
+    {
+        return (set->m_Words[button / 64] >> (button % 64)) & 1;
+    }
+
+    void SetMaskBit(ActionMap* map, const ActionTrigger trigger, const u16 button, const u32 binding)
+    {
+        map->m_Masks[static_cast<u32>(trigger)][button][binding / 64] |= 1ull << (binding % 64);
+    }
+}
+
+ActionMap* ActionMapCreate()
+{
+    ActionMap* map = new ActionMap;
+    std::memset(map, 0, sizeof(ActionMap));
+    return map;
+}
+
+void ActionMapDestroy(ActionMap* map)
+{
+    delete map;
+}
+
+bool ActionMapBind(
+    ActionMap* map,
+    const u32 action,
+    const u16 button,
+    const ActionTrigger trigger,
+    const u16* chord,
+    const u32 chordCount)
+{
+    if (map->m_BindingCount >= ACTIONMAP_MAX_BINDINGS
+        || action >= ACTIONMAP_MAX_ACTIONS
+        || button >= INPUT_NUM_BUTTONS
+        || chordCount > ACTIONMAP_MAX_CHORD)
+    {
+        return false;
+    }
+
+    ActionBinding* binding = &map->m_Bindings[map->m_BindingCount];
+    binding->m_Action = static_cast<u16>(action);
+    binding->m_Button = button;
+    binding->m_Trigger = trigger;
+    binding->m_ChordCount = chordCount;
+    for (u32 i = 0; i < chordCount; i++)
+    {
+        if (chord[i] >= INPUT_NUM_BUTTONS)
+        {
+            return false;
+        }
+        binding->m_Chord[i] = chord[i];
+    }
+
+    map->m_BindingCount++;
+    return true;
+}
+
+void ActionMapCompile(ActionMap* map)
+{
+    std::memset(map->m_Masks, 0, sizeof(map->m_Masks));
+    std::memset(map->m_UsedButtonCounts, 0, sizeof(map->m_UsedButtonCounts));
+    std::memset(map->m_ValidBindings, 0, sizeof(map->m_ValidBindings));
+
+    map->m_BindingWords = (map->m_BindingCount + 63) / 64;
+
+    for (u32 i = 0; i < map->m_BindingCount; i++)
+    {
+        const ActionBinding* binding = &map->m_Bindings[i];
+        SetMaskBit(map, binding->m_Trigger, binding->m_Button, i);
+
+        // NOTE(sbalse): Chord buttons only ever need to be held.
+        for (u32 c = 0; c < binding->m_ChordCount; c++)
+        {
+            SetMaskBit(map, ActionTrigger::HELD, binding->m_Chord[c], i);
+        }
+
+        map->m_ValidBindings[i / 64] |= 1ull << (i % 64);
+    }
+
+    for (u32 trigger = 0; trigger < static_cast<u32>(ActionTrigger::COUNT); trigger++)
+    {
+        for (u32 button = 0; button < INPUT_NUM_BUTTONS; button++)
+        {
+            bool used = false;
+            for (u32 word = 0; word < map->m_BindingWords; word++)
+            {
+                used = used || map->m_Masks[trigger][button][word] != 0;
+            }
+
+            if (used)
+            {
+                map->m_UsedButtons[trigger][map->m_UsedButtonCounts[trigger]++] = static_cast<u16>(button);
+            }
+        }
+    }
+}
+
+void ActionMapEvaluate(const ActionMap* map, const InputFrameState* input, ActionSet* result)
+{
+    std::memset(result, 0, sizeof(ActionSet));
+
+    const InputButtonSet* states[static_cast<u32>(ActionTrigger::COUNT)] =
+    {
+        &input->m_Pressed,
+        &input->m_Released,
+        &input->m_Held,
+    };
+
+    // NOTE(sbalse): A binding fires unless one of the buttons it needs is not in the required state. So OR
+    // together the masks of every required button that is *not* in its state, and whatever is left fired.
+    u64 missing[ACTIONMAP_BINDING_WORDS] = {};
+    const u32 words = map->m_BindingWords;
+
+    for (u32 trigger = 0; trigger < static_cast<u32>(ActionTrigger::COUNT); trigger++)
+    {
+        const InputButtonSet* state = states[trigger];
+        for (u32 i = 0; i < map->m_UsedButtonCounts[trigger]; i++)
+        {
+            const u16 button = map->m_UsedButtons[trigger][i];
+            if (ButtonSetTest(state, button))
+            {
+                continue;
+            }
+
+            const u64* mask = map->m_Masks[trigger][button];
+            for (u32 word = 0; word < words; word++)
+            {
+                missing[word] |= mask[word];
+            }
+        }
+    }
+
+    // NOTE(sbalse): Several bindings may map to the same action.
+    for (u32 word = 0; word < words; word++)
+    {
+        u64 fired = map->m_ValidBindings[word] & ~missing[word];
+        while (fired)
+        {
+            const u32 binding = (word * 64) + static_cast<u32>(std::countr_zero(fired));
+            const u32 action = map->m_Bindings[binding].m_Action;
+            result->m_Words[action / 64] |= 1ull << (action % 64);
+            fired &= fired - 1;
+        }
+    }
+}
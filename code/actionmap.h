@@ -0,0 +1,68 @@
+#pragma once
+#include "types.h"
+#include "input.h"
+
+/*
+* NOTE(sbalse): Maps buttons to game actions. Bindings are compiled into per-button masks over all bindings,
+* and each frame every binding is evaluated at once with wide bitwise operations over the input bit sets.
+* The cost depends on the number of distinct buttons used, not on the number of bindings, and any number
+* of actions can fire in the same frame.
+*/
+
+constexpr u32 ACTIONMAP_MAX_BINDINGS = 4096;
+constexpr u32 ACTIONMAP_MAX_ACTIONS = 1024;
+constexpr u32 ACTIONMAP_MAX_CHORD = 3; // NOTE(sbalse): Extra buttons that must be held for a binding.
+constexpr u32 ACTIONMAP_BINDING_WORDS = ACTIONMAP_MAX_BINDINGS / 64;
+constexpr u32 ACTIONMAP_ACTION_WORDS = ACTIONMAP_MAX_ACTIONS / 64;
+
+enum class ActionTrigger
+{
+    PRESSED,
+    RELEASED,
+    HELD,
+    COUNT
+};
+
+struct ActionBinding
+{
+    u16 m_Action;
+    u16 m_Button;
+    ActionTrigger m_Trigger;
+    u16 m_Chord[ACTIONMAP_MAX_CHORD];
+    u32 m_ChordCount;
+};
+
+struct ActionSet
+{
+    u64 m_Words[ACTIONMAP_ACTION_WORDS];
+};
+
+struct ActionMap;
+
+constexpr u16 ActionKey(const u8 virtualKey)
+{
+    return virtualKey;
+}
+
+constexpr u16 ActionMouse(const MouseButton button)
+{
+    return static_cast<u16>(INPUT_MOUSE_BUTTON_BASE + static_cast<u32>(button));
+}
+
+ActionMap* ActionMapCreate();
+void ActionMapDestroy(ActionMap* map);
+// NOTE(sbalse): Bindings only take effect after the next ActionMapCompile().
+bool ActionMapBind(
+    ActionMap* map,
+    const u32 action,
+    const u16 button,
+    const ActionTrigger trigger,
+    const u16* chord = nullptr,
+    const u32 chordCount = 0);
+void ActionMapCompile(ActionMap* map);
+void ActionMapEvaluate(const ActionMap* map, const InputFrameState* input, ActionSet* result);
+
+inline bool ActionSetTest(const ActionSet* set, const u32 action)
+{
+    return (set->m_Words[action / 64] >> (action % 64)) & 1;
+}
@@ -0,0 +1,866 @@
+#include "animclip.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <immintrin.h>
+
+#include "cpufeatures.h"
+#include "scenefile.h"
+#include "utils.h"
+
+namespace
+{
+    // NOTE(sbalse): The three smallest components of a unit quaternion lie within [-1/sqrt(2), 1/sqrt(2)].
+    constexpr float ANIMCLIP_ROTATION_RANGE = 0.70710678f;
+    constexpr float ANIMCLIP_ROTATION_STEP = ANIMCLIP_ROTATION_RANGE * 2.0f / 65535.0f;
+    constexpr float ANIMCLIP_TRANSLATION_STEPS = 65535.0f;
+
+    enum class AnimClipChannel
+    {
+        ROTATION,
+        TRANSLATION,
+        COUNT
+    };
+
+    constexpr u32 ANIMCLIP_CHANNEL_COUNT = static_cast<u32>(AnimClipChannel::COUNT);
+
+    constinit bool g_AnimClipSimdRequested = true;
+
+    u64 AnimClipAlign(const u64 value)
+    {
+        return (value + ANIMCLIP_ALIGNMENT - 1) & ~static_cast<u64>(ANIMCLIP_ALIGNMENT - 1);
+    }
+
+    u32 AnimClipQuantize(const float value, const float min, const float step)
+    {
+        if (step <= 0.0f)
+        {
+            return 0;
+        }
+        const float scaled = (value - min) / step + 0.5f;
+        return scaled <= 0.0f ? 0 : (scaled >= 65535.0f ? 65535 : static_cast<u32>(scaled));
+    }
+
+    // NOTE(sbalse): The largest component is left out and made positive, q and -q are the same rotation. The
+    // first word holds the first two stored components, the second the third and the index of the left out one.
+    void AnimClipQuantizeRotation(const float* rotation, u32* words)
+    {
+        const float length = std::sqrt(
+            rotation[0] * rotation[0] + rotation[1] * rotation[1]
+            + rotation[2] * rotation[2] + rotation[3] * rotation[3]);
+        const float inverseLength = length > 0.0f ? 1.0f / length : 0.0f;
+
+        u32 largest = 0;
+        for (u32 i = 1; i < 4; i++)
+        {
+            largest = std::fabs(rotation[i]) > std::fabs(rotation[largest]) ? i : largest;
+        }
+        const float sign = rotation[largest] < 0.0f ? -inverseLength : inverseLength;
+
+        u32 stored[3] = {};
+        u32 count = 0;
+        for (u32 i = 0; i < 4; i++)
+        {
+            if (i != largest)
+            {
+                stored[count++] = AnimClipQuantize(
+                    rotation[i] * sign,
+                    -ANIMCLIP_ROTATION_RANGE,
+                    ANIMCLIP_ROTATION_STEP);
+            }
+        }
+        words[0] = stored[0] | (stored[1] << 16);
+        words[1] = stored[2] | (largest << 16);
+    }
+
+    void AnimClipDecodeRotation(const u32* words, float* rotation)
+    {
+        const float a = static_cast<float>(words[0] & 0xFFFF) * ANIMCLIP_ROTATION_STEP - ANIMCLIP_ROTATION_RANGE;
+        const float b = static_cast<float>(words[0] >> 16) * ANIMCLIP_ROTATION_STEP - ANIMCLIP_ROTATION_RANGE;
+        const float c = static_cast<float>(words[1] & 0xFFFF) * ANIMCLIP_ROTATION_STEP - ANIMCLIP_ROTATION_RANGE;
+        const float wSquared = 1.0f - a * a - b * b - c * c;
+        const float w = std::sqrt(wSquared > 0.0f ? wSquared : 0.0f);
+        const u32 largest = words[1] >> 16;
+
+        rotation[0] = largest == 0 ? w : a;
+        rotation[1] = largest == 0 ? a : (largest == 1 ? w : b);
+        rotation[2] = largest <= 1 ? b : (largest == 2 ? w : c);
+        rotation[3] = largest == 3 ? w : c;
+    }
+
+    void AnimClipQuantizeTranslation(const float* translation, const AnimClipTrack* track, u32* words)
+    {
+        u32 stored[3] = {};
+        for (u32 i = 0; i < 3; i++)
+        {
+            stored[i] = AnimClipQuantize(translation[i], track->m_TranslationMin[i], track->m_TranslationStep[i]);
+        }
+        words[0] = stored[0] | (stored[1] << 16);
+        words[1] = stored[2];
+    }
+
+    void AnimClipDecodeTranslation(const u32* words, const AnimClipTrack* track, float* translation)
+    {
+        const u32 quantized[3] = { words[0] & 0xFFFF, words[0] >> 16, words[1] & 0xFFFF };
+        for (u32 i = 0; i < 3; i++)
+        {
+            const float offset = static_cast<float>(quantized[i]) * track->m_TranslationStep[i];
+            translation[i] = track->m_TranslationMin[i] + offset;
+        }
+    }
+
+    // NOTE(sbalse): Normalized lerp the short way around.
+    void AnimClipBlendRotations(const float* a, const float* b, const float t, float* result)
+    {
+        const float dot = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+        float blended[4] = {};
+        for (u32 i = 0; i < 4; i++)
+        {
+            const float target = dot < 0.0f ? -b[i] : b[i];
+            blended[i] = a[i] + (target - a[i]) * t;
+        }
+
+        const float length = std::sqrt(
+            blended[0] * blended[0] + blended[1] * blended[1] + blended[2] * blended[2] + blended[3] * blended[3]);
+        for (u32 i = 0; i < 4; i++)
+        {
+            result[i] = blended[i] / length;
+        }
+    }
+
+    void AnimClipBlendTranslations(const float* a, const float* b, const float t, float* result)
+    {
+        for (u32 i = 0; i < 3; i++)
+        {
+            result[i] = a[i] + (b[i] - a[i]) * t;
+        }
+    }
+
+    // NOTE(sbalse): Angle between two rotations. For unit quaternions on the same side |a - b| = 2 sin(angle / 4),
+    // which unlike the dot product keeps its precision for small angles.
+    float AnimClipRotationError(const float* decoded, const float* original)
+    {
+        const float length = std::sqrt(
+            original[0] * original[0] + original[1] * original[1]
+            + original[2] * original[2] + original[3] * original[3]);
+        const float dot = decoded[0] * original[0] + decoded[1] * original[1]
+            + decoded[2] * original[2] + decoded[3] * original[3];
+        const float sign = dot < 0.0f ? -1.0f / length : 1.0f / length;
+
+        float distanceSquared = 0.0f;
+        for (u32 i = 0; i < 4; i++)
+        {
+            const float difference = decoded[i] - original[i] * sign;
+            distanceSquared += difference * difference;
+        }
+        const float halfDistance = std::sqrt(distanceSquared) * 0.5f;
+        return 4.0f * std::asin(halfDistance < 1.0f ? halfDistance : 1.0f);
+    }
+
+    float AnimClipTranslationError(const float* decoded, const float* original)
+    {
+        const float x = decoded[0] - original[0];
+        const float y = decoded[1] - original[1];
+        const float z = decoded[2] - original[2];
+        return std::sqrt(x * x + y * y + z * z);
+    }
+
+    // NOTE(sbalse): Quantized value of one track at every frame, two words per frame, and what it is checked
+    // against.
+    struct AnimClipChannelFrames
+    {
+        AnimClipChannel m_Channel;
+        const u32* m_Words;
+        const AnimClipSource* m_Source;
+        const AnimClipTrack* m_Track;
+        u32 m_TrackIndex;
+        float m_Tolerance;
+    };
+
+    // NOTE(sbalse): Whether interpolating between the keys at first and last reproduces every frame in between.
+    bool AnimClipSegmentFits(const AnimClipChannelFrames* frames, const u32 first, const u32 last)
+    {
+        const u32* wordsA = frames->m_Words + (first * 2);
+        const u32* wordsB = frames->m_Words + (last * 2);
+        float a[4] = {};
+        float b[4] = {};
+        if (frames->m_Channel == AnimClipChannel::ROTATION)
+        {
+            AnimClipDecodeRotation(wordsA, a);
+            AnimClipDecodeRotation(wordsB, b);
+        }
+        else
+        {
+            AnimClipDecodeTranslation(wordsA, frames->m_Track, a);
+            AnimClipDecodeTranslation(wordsB, frames->m_Track, b);
+        }
+
+        const AnimClipSource* source = frames->m_Source;
+        for (u32 frame = first + 1; frame < last; frame++)
+        {
+            // NOTE(sbalse): The same blend factor the sampler computes.
+            const float t = (static_cast<float>(frame) - static_cast<float>(first))
+                / (static_cast<float>(last) - static_cast<float>(first));
+            const AnimTransform* original = &source->m_Frames[(frame * source->m_TrackCount) + frames->m_TrackIndex];
+
+            float blended[4] = {};
+            float error = 0.0f;
+            if (frames->m_Channel == AnimClipChannel::ROTATION)
+            {
+                AnimClipBlendRotations(a, b, t, blended);
+                error = AnimClipRotationError(blended, original->m_Rotation);
+            }
+            else
+            {
+                AnimClipBlendTranslations(a, b, t, blended);
+                error = AnimClipTranslationError(blended, original->m_Translation);
+            }
+            if (!(error <= frames->m_Tolerance))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // NOTE(sbalse): Greedy, every segment is grown until it stops fitting. Writes the frames of the kept keys and
+    // returns how many there are. The first and the last frame are always kept.
+    u32 AnimClipReduceKeys(const AnimClipChannelFrames* frames, const u32 frameCount, u16* keyFrames)
+    {
+        u32 count = 0;
+        keyFrames[count++] = 0;
+
+        u32 first = 0;
+        for (u32 last = 2; last < frameCount; last++)
+        {
+            if (!AnimClipSegmentFits(frames, first, last))
+            {
+                first = last - 1;
+                keyFrames[count++] = static_cast<u16>(first);
+            }
+        }
+
+        if (frameCount > 1)
+        {
+            keyFrames[count++] = static_cast<u16>(frameCount - 1);
+        }
+        return count;
+    }
+
+    struct AnimClipView
+    {
+        const AnimClipTrack* m_Tracks;
+        const u16* m_BlockKeys;
+        const u16* m_Frames[ANIMCLIP_CHANNEL_COUNT];
+        const u32* m_Keys[ANIMCLIP_CHANNEL_COUNT];
+    };
+
+    AnimClipView AnimClipGetView(const AnimClip* clip)
+    {
+        const u8* base = reinterpret_cast<const u8*>(clip);
+        return
+        {
+            .m_Tracks = reinterpret_cast<const AnimClipTrack*>(base + clip->m_Tracks.m_Offset),
+            .m_BlockKeys = reinterpret_cast<const u16*>(base + clip->m_BlockKeys.m_Offset),
+            .m_Frames =
+            {
+                reinterpret_cast<const u16*>(base + clip->m_RotationFrames.m_Offset),
+                reinterpret_cast<const u16*>(base + clip->m_TranslationFrames.m_Offset),
+            },
+            .m_Keys =
+            {
+                reinterpret_cast<const u32*>(base + clip->m_RotationKeys.m_Offset),
+                reinterpret_cast<const u32*>(base + clip->m_TranslationKeys.m_Offset),
+            },
+        };
+    }
+
+    // NOTE(sbalse): The two keys around position in one channel of a track, as indices into the whole clip, and
+    // how far position is from the first to the second.
+    struct AnimClipKeyPair
+    {
+        u32 m_A;
+        u32 m_B;
+        float m_T;
+    };
+
+    AnimClipKeyPair AnimClipFindKeys(
+        const AnimClip* clip,
+        const AnimClipView* view,
+        const u32 track,
+        const AnimClipChannel channel,
+        const float position)
+    {
+        const AnimClipTrack* info = &view->m_Tracks[track];
+        const bool rotation = channel == AnimClipChannel::ROTATION;
+        const u32 firstKey = rotation ? info->m_FirstRotationKey : info->m_FirstTranslationKey;
+        const u32 keyCount = rotation ? info->m_RotationKeyCount : info->m_TranslationKeyCount;
+        const u16* frames = view->m_Frames[static_cast<u32>(channel)] + firstKey;
+        const u16* blockKeys =
+            view->m_BlockKeys + ((static_cast<u64>(track) * ANIMCLIP_CHANNEL_COUNT + static_cast<u32>(channel))
+            * clip->m_BlockCount);
+
+        const u32 frame = static_cast<u32>(position);
+        u32 key = blockKeys[frame / ANIMCLIP_BLOCK_FRAMES];
+        while (key + 1 < keyCount && frames[key + 1] <= frame)
+        {
+            key++;
+        }
+        const u32 next = key + 1 < keyCount ? key + 1 : key;
+        const float from = static_cast<float>(frames[key]);
+        const float t = next == key ? 0.0f : (position - from) / (static_cast<float>(frames[next]) - from);
+        return { .m_A = firstKey + key, .m_B = firstKey + next, .m_T = t };
+    }
+
+    float AnimClipPosition(const AnimClip* clip, const float time)
+    {
+        const float position = time * clip->m_FrameRate;
+        const float last = static_cast<float>(clip->m_FrameCount - 1);
+        return position > 0.0f ? (position < last ? position : last) : 0.0f;
+    }
+
+    void AnimClipSampleScalar(
+        const AnimClip* clip,
+        const AnimClipView* view,
+        const u32 track,
+        const float time,
+        AnimTransform* pose)
+    {
+        const float position = AnimClipPosition(clip, time);
+        const AnimClipKeyPair rotation = AnimClipFindKeys(clip, view, track, AnimClipChannel::ROTATION, position);
+        const AnimClipKeyPair translation =
+            AnimClipFindKeys(clip, view, track, AnimClipChannel::TRANSLATION, position);
+
+        float a[4] = {};
+        float b[4] = {};
+        const u32* rotationKeys = view->m_Keys[static_cast<u32>(AnimClipChannel::ROTATION)];
+        AnimClipDecodeRotation(rotationKeys + (rotation.m_A * 2), a);
+        AnimClipDecodeRotation(rotationKeys + (rotation.m_B * 2), b);
+        AnimClipBlendRotations(a, b, rotation.m_T, pose->m_Rotation);
+
+        const u32* translationKeys = view->m_Keys[static_cast<u32>(AnimClipChannel::TRANSLATION)];
+        AnimClipDecodeTranslation(translationKeys + (translation.m_A * 2), &view->m_Tracks[track], a);
+        AnimClipDecodeTranslation(translationKeys + (translation.m_B * 2), &view->m_Tracks[track], b);
+        AnimClipBlendTranslations(a, b, translation.m_T, pose->m_Translation);
+    }
+
+    struct AnimClipLanes
+    {
+        __m256 m_Values[4];
+    };
+
+    CPU_AVX2 void AnimClipDecodeRotationsAvx2(const u32* keys, const u32* indices, AnimClipLanes* result)
+    {
+        const __m256i mask = _mm256_set1_epi32(0xFFFF);
+        const __m256 step = _mm256_set1_ps(ANIMCLIP_ROTATION_STEP);
+        const __m256 range = _mm256_set1_ps(ANIMCLIP_ROTATION_RANGE);
+
+        const __m256i keyIndices = _mm256_load_si256(reinterpret_cast<const __m256i*>(indices));
+        const __m256i wordIndices = _mm256_add_epi32(keyIndices, keyIndices);
+        const __m256i low = _mm256_i32gather_epi32(reinterpret_cast<const int*>(keys), wordIndices, 4);
+        const __m256i high = _mm256_i32gather_epi32(reinterpret_cast<const int*>(keys + 1), wordIndices, 4);
+
+        const __m256 a = _mm256_sub_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(low, mask)), step), range);
+        const __m256 b = _mm256_sub_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(low, 16)), step), range);
+        const __m256 c = _mm256_sub_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(high, mask)), step), range);
+        const __m256 wSquared = _mm256_sub_ps(
+            _mm256_sub_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f), _mm256_mul_ps(a, a)), _mm256_mul_ps(b, b)),
+            _mm256_mul_ps(c, c));
+        const __m256 w = _mm256_sqrt_ps(_mm256_max_ps(wSquared, _mm256_setzero_ps()));
+
+        const __m256i largest = _mm256_srli_epi32(high, 16);
+        const __m256 is0 = _mm256_castsi256_ps(_mm256_cmpeq_epi32(largest, _mm256_set1_epi32(0)));
+        const __m256 is1 = _mm256_castsi256_ps(_mm256_cmpeq_epi32(largest, _mm256_set1_epi32(1)));
+        const __m256 is2 = _mm256_castsi256_ps(_mm256_cmpeq_epi32(largest, _mm256_set1_epi32(2)));
+        const __m256 is3 = _mm256_castsi256_ps(_mm256_cmpeq_epi32(largest, _mm256_set1_epi32(3)));
+
+        result->m_Values[0] = _mm256_blendv_ps(a, w, is0);
+        result->m_Values[1] = _mm256_blendv_ps(_mm256_blendv_ps(b, w, is1), a, is0);
+        result->m_Values[2] = _mm256_blendv_ps(_mm256_blendv_ps(c, w, is2), b, _mm256_or_ps(is0, is1));
+        result->m_Values[3] = _mm256_blendv_ps(c, w, is3);
+    }
+
+    CPU_AVX2 void AnimClipDecodeTranslationsAvx2(
+        const u32* keys,
+        const AnimClipTrack* track,
+        const u32* indices,
+        AnimClipLanes* result)
+    {
+        const __m256i mask = _mm256_set1_epi32(0xFFFF);
+        const __m256i keyIndices = _mm256_load_si256(reinterpret_cast<const __m256i*>(indices));
+        const __m256i wordIndices = _mm256_add_epi32(keyIndices, keyIndices);
+        const __m256i low = _mm256_i32gather_epi32(reinterpret_cast<const int*>(keys), wordIndices, 4);
+        const __m256i high = _mm256_i32gather_epi32(reinterpret_cast<const int*>(keys + 1), wordIndices, 4);
+        const __m256i quantized[3] = { _mm256_and_si256(low, mask), _mm256_srli_epi32(low, 16), high };
+
+        for (u32 i = 0; i < 3; i++)
+        {
+            result->m_Values[i] = _mm256_add_ps(
+                _mm256_set1_ps(track->m_TranslationMin[i]),
+                _mm256_mul_ps(_mm256_cvtepi32_ps(quantized[i]), _mm256_set1_ps(track->m_TranslationStep[i])));
+        }
+    }
+
+    // NOTE(sbalse): AnimClipFindKeys() for eight times at once. Every lane walks forward from the key of its block
+    // until no lane moves anymore. The u16 gathers read two bytes past the element, which is still within the
+    // clip since the key words come after the frames and block keys.
+    CPU_AVX2 void AnimClipFindKeysAvx2(
+        const AnimClip* clip,
+        const AnimClipView* view,
+        const u32 track,
+        const AnimClipChannel channel,
+        const float* times,
+        u32* keysA,
+        u32* keysB,
+        float* t)
+    {
+        const AnimClipTrack* info = &view->m_Tracks[track];
+        const bool rotation = channel == AnimClipChannel::ROTATION;
+        const u32 firstKey = rotation ? info->m_FirstRotationKey : info->m_FirstTranslationKey;
+        const u32 keyCount = rotation ? info->m_RotationKeyCount : info->m_TranslationKeyCount;
+        const int* frames = reinterpret_cast<const int*>(view->m_Frames[static_cast<u32>(channel)] + firstKey);
+        const int* blockKeys = reinterpret_cast<const int*>(
+            view->m_BlockKeys + ((static_cast<u64>(track) * ANIMCLIP_CHANNEL_COUNT + static_cast<u32>(channel))
+            * clip->m_BlockCount));
+
+        // NOTE(sbalse): Clamped the same way as AnimClipPosition(), including what happens to NaN.
+        const __m256 scaled = _mm256_mul_ps(_mm256_loadu_ps(times), _mm256_set1_ps(clip->m_FrameRate));
+        const __m256 lastFrame = _mm256_set1_ps(static_cast<float>(clip->m_FrameCount - 1));
+        const __m256 below = _mm256_blendv_ps(lastFrame, scaled, _mm256_cmp_ps(scaled, lastFrame, _CMP_LT_OQ));
+        const __m256 position = _mm256_blendv_ps(
+            _mm256_setzero_ps(),
+            below,
+            _mm256_cmp_ps(scaled, _mm256_setzero_ps(), _CMP_GT_OQ));
+
+        const __m256i low16 = _mm256_set1_epi32(0xFFFF);
+        const __m256i one = _mm256_set1_epi32(1);
+        const __m256i lastKey = _mm256_set1_epi32(static_cast<int>(keyCount - 1));
+        const __m256i frame = _mm256_cvttps_epi32(position);
+        const __m256i block = _mm256_srli_epi32(frame, ANIMCLIP_BLOCK_SHIFT);
+        __m256i key = _mm256_and_si256(_mm256_i32gather_epi32(blockKeys, block, 2), low16);
+        __m256i next = _mm256_min_epu32(_mm256_add_epi32(key, one), lastKey);
+        __m256i nextFrame = _mm256_and_si256(_mm256_i32gather_epi32(frames, next, 2), low16);
+        for (;;)
+        {
+            const __m256i advance = _mm256_andnot_si256(
+                _mm256_cmpgt_epi32(nextFrame, frame),
+                _mm256_cmpgt_epi32(lastKey, key));
+            if (_mm256_testz_si256(advance, advance))
+            {
+                break;
+            }
+            key = _mm256_sub_epi32(key, advance);
+            next = _mm256_min_epu32(_mm256_add_epi32(key, one), lastKey);
+            nextFrame = _mm256_and_si256(_mm256_i32gather_epi32(frames, next, 2), low16);
+        }
+
+        const __m256 from = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_i32gather_epi32(frames, key, 2), low16));
+        const __m256 to = _mm256_cvtepi32_ps(nextFrame);
+        const __m256 blend = _mm256_div_ps(_mm256_sub_ps(position, from), _mm256_sub_ps(to, from));
+        const __m256 same = _mm256_castsi256_ps(_mm256_cmpeq_epi32(key, next));
+        const __m256i offset = _mm256_set1_epi32(static_cast<int>(firstKey));
+
+        _mm256_store_si256(reinterpret_cast<__m256i*>(keysA), _mm256_add_epi32(key, offset));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(keysB), _mm256_add_epi32(next, offset));
+        _mm256_store_ps(t, _mm256_blendv_ps(blend, _mm256_setzero_ps(), same));
+    }
+
+    // NOTE(sbalse): One track of eight instances.
+    CPU_AVX2 void AnimClipSampleAvx2(
+        const AnimClip* clip,
+        const AnimClipView* view,
+        const u32 track,
+        const float* times,
+        const u32 first,
+        AnimTransform* poses)
+    {
+        alignas(32) u32 keys[ANIMCLIP_CHANNEL_COUNT][2][8] = {};
+        alignas(32) float t[ANIMCLIP_CHANNEL_COUNT][8] = {};
+        for (u32 channel = 0; channel < ANIMCLIP_CHANNEL_COUNT; channel++)
+        {
+            AnimClipFindKeysAvx2(
+                clip,
+                view,
+                track,
+                static_cast<AnimClipChannel>(channel),
+                times + first,
+                keys[channel][0],
+                keys[channel][1],
+                t[channel]);
+        }
+
+        constexpr u32 rotation = static_cast<u32>(AnimClipChannel::ROTATION);
+        constexpr u32 translation = static_cast<u32>(AnimClipChannel::TRANSLATION);
+        const __m256 signBit = _mm256_set1_ps(-0.0f);
+
+        AnimClipLanes a = {};
+        AnimClipLanes b = {};
+        AnimClipDecodeRotationsAvx2(view->m_Keys[rotation], keys[rotation][0], &a);
+        AnimClipDecodeRotationsAvx2(view->m_Keys[rotation], keys[rotation][1], &b);
+        __m256 dot = _mm256_mul_ps(a.m_Values[0], b.m_Values[0]);
+        for (u32 i = 1; i < 4; i++)
+        {
+            dot = _mm256_add_ps(dot, _mm256_mul_ps(a.m_Values[i], b.m_Values[i]));
+        }
+        const __m256 flip = _mm256_and_ps(_mm256_cmp_ps(dot, _mm256_setzero_ps(), _CMP_LT_OQ), signBit);
+        const __m256 rotationT = _mm256_load_ps(t[rotation]);
+
+        __m256 blended[4] = {};
+        __m256 lengthSquared = _mm256_setzero_ps();
+        for (u32 i = 0; i < 4; i++)
+        {
+            const __m256 target = _mm256_xor_ps(b.m_Values[i], flip);
+            blended[i] = _mm256_add_ps(a.m_Values[i], _mm256_mul_ps(_mm256_sub_ps(target, a.m_Values[i]), rotationT));
+            lengthSquared = i == 0
+                ? _mm256_mul_ps(blended[i], blended[i])
+                : _mm256_add_ps(lengthSquared, _mm256_mul_ps(blended[i], blended[i]));
+        }
+        const __m256 length = _mm256_sqrt_ps(lengthSquared);
+
+        const AnimClipTrack* info = &view->m_Tracks[track];
+        AnimClipLanes translationA = {};
+        AnimClipLanes translationB = {};
+        AnimClipDecodeTranslationsAvx2(view->m_Keys[translation], info, keys[translation][0], &translationA);
+        AnimClipDecodeTranslationsAvx2(view->m_Keys[translation], info, keys[translation][1], &translationB);
+        const __m256 translationT = _mm256_load_ps(t[translation]);
+
+        alignas(32) float values[7][8] = {};
+        for (u32 i = 0; i < 4; i++)
+        {
+            _mm256_store_ps(values[i], _mm256_div_ps(blended[i], length));
+        }
+        for (u32 i = 0; i < 3; i++)
+        {
+            const __m256 from = translationA.m_Values[i];
+            const __m256 to = translationB.m_Values[i];
+            _mm256_store_ps(values[4 + i], _mm256_add_ps(from, _mm256_mul_ps(_mm256_sub_ps(to, from), translationT)));
+        }
+
+        for (u32 lane = 0; lane < 8; lane++)
+        {
+            AnimTransform* pose = &poses[(static_cast<u64>(first + lane) * clip->m_TrackCount) + track];
+            for (u32 i = 0; i < 4; i++)
+            {
+                pose->m_Rotation[i] = values[i][lane];
+            }
+            for (u32 i = 0; i < 3; i++)
+            {
+                pose->m_Translation[i] = values[4 + i][lane];
+            }
+        }
+    }
+}
+
+AnimClip* AnimClipCompress(const AnimClipSource* source, const AnimClipTolerance* tolerance)
+{
+    const u32 trackCount = source->m_TrackCount;
+    const u32 frameCount = source->m_FrameCount;
+    if (trackCount == 0 || frameCount == 0 || frameCount > ANIMCLIP_MAX_FRAMES || !(source->m_FrameRate > 0.0f))
+    {
+        return nullptr;
+    }
+
+    // NOTE(sbalse): Scratch space for the quantized frames of one track and the kept keys of all of them.
+    const u64 keyCapacity = static_cast<u64>(trackCount) * frameCount;
+    u32* frameWords = static_cast<u32*>(std::calloc(static_cast<size_t>(frameCount) * 2, sizeof(u32)));
+    u16* keyFrames[ANIMCLIP_CHANNEL_COUNT] =
+    {
+        static_cast<u16*>(std::calloc(keyCapacity, sizeof(u16))),
+        static_cast<u16*>(std::calloc(keyCapacity, sizeof(u16))),
+    };
+    u32* keyWords[ANIMCLIP_CHANNEL_COUNT] =
+    {
+        static_cast<u32*>(std::calloc(keyCapacity * 2, sizeof(u32))),
+        static_cast<u32*>(std::calloc(keyCapacity * 2, sizeof(u32))),
+    };
+    AnimClipTrack* tracks = static_cast<AnimClipTrack*>(std::calloc(trackCount, sizeof(AnimClipTrack)));
+    DEFER(std::free(frameWords));
+    DEFER(std::free(tracks));
+    DEFER(std::free(keyFrames[0]));
+    DEFER(std::free(keyFrames[1]));
+    DEFER(std::free(keyWords[0]));
+    DEFER(std::free(keyWords[1]));
+    if (!frameWords || !tracks || !keyFrames[0] || !keyFrames[1] || !keyWords[0] || !keyWords[1])
+    {
+        return nullptr;
+    }
+
+    u32 keyCounts[ANIMCLIP_CHANNEL_COUNT] = {};
+    for (u32 track = 0; track < trackCount; track++)
+    {
+        AnimClipTrack* info = &tracks[track];
+
+        // NOTE(sbalse): Translations are quantized within the range the track covers.
+        for (u32 i = 0; i < 3; i++)
+        {
+            float min = source->m_Frames[track].m_Translation[i];
+            float max = min;
+            for (u32 frame = 1; frame < frameCount; frame++)
+            {
+                const float value = source->m_Frames[(static_cast<u64>(frame) * trackCount) + track].m_Translation[i];
+                min = value < min ? value : min;
+                max = value > max ? value : max;
+            }
+            info->m_TranslationMin[i] = min;
+            info->m_TranslationStep[i] = (max - min) / ANIMCLIP_TRANSLATION_STEPS;
+        }
+
+        for (u32 channel = 0; channel < ANIMCLIP_CHANNEL_COUNT; channel++)
+        {
+            const bool rotation = static_cast<AnimClipChannel>(channel) == AnimClipChannel::ROTATION;
+            for (u32 frame = 0; frame < frameCount; frame++)
+            {
+                const AnimTransform* transform = &source->m_Frames[(static_cast<u64>(frame) * trackCount) + track];
+                if (rotation)
+                {
+                    AnimClipQuantizeRotation(transform->m_Rotation, frameWords + (frame * 2));
+                }
+                else
+                {
+                    AnimClipQuantizeTranslation(transform->m_Translation, info, frameWords + (frame * 2));
+                }
+            }
+
+            const AnimClipChannelFrames frames =
+            {
+                .m_Channel = static_cast<AnimClipChannel>(channel),
+                .m_Words = frameWords,
+                .m_Source = source,
+                .m_Track = info,
+                .m_TrackIndex = track,
+                .m_Tolerance = rotation ? tolerance->m_Rotation : tolerance->m_Translation,
+            };
+            const u32 firstKey = keyCounts[channel];
+            const u32 count = AnimClipReduceKeys(&frames, frameCount, keyFrames[channel] + firstKey);
+            for (u32 key = 0; key < count; key++)
+            {
+                const u32 frame = keyFrames[channel][firstKey + key];
+                keyWords[channel][(firstKey + key) * 2] = frameWords[frame * 2];
+                keyWords[channel][(firstKey + key) * 2 + 1] = frameWords[frame * 2 + 1];
+            }
+            keyCounts[channel] += count;
+
+            if (rotation)
+            {
+                info->m_FirstRotationKey = firstKey;
+                info->m_RotationKeyCount = count;
+            }
+            else
+            {
+                info->m_FirstTranslationKey = firstKey;
+                info->m_TranslationKeyCount = count;
+            }
+        }
+    }
+
+    // NOTE(sbalse): Lay out the sections, then fill them in.
+    const u32 blockCount = (frameCount + ANIMCLIP_BLOCK_FRAMES - 1) / ANIMCLIP_BLOCK_FRAMES;
+    const u64 sizes[6] =
+    {
+        static_cast<u64>(trackCount) * sizeof(AnimClipTrack),
+        static_cast<u64>(trackCount) * ANIMCLIP_CHANNEL_COUNT * blockCount * sizeof(u16),
+        static_cast<u64>(keyCounts[0]) * sizeof(u16),
+        static_cast<u64>(keyCounts[1]) * sizeof(u16),
+        static_cast<u64>(keyCounts[0]) * 2 * sizeof(u32),
+        static_cast<u64>(keyCounts[1]) * 2 * sizeof(u32),
+    };
+    AnimClipSection sections[6] = {};
+    u64 offset = AnimClipAlign(sizeof(AnimClip));
+    for (u32 i = 0; i < 6; i++)
+    {
+        sections[i] = { .m_Offset = offset, .m_Size = sizes[i] };
+        offset += AnimClipAlign(sizes[i]);
+    }
+
+    AnimClip* clip = static_cast<AnimClip*>(std::calloc(offset, 1));
+    if (!clip)
+    {
+        return nullptr;
+    }
+    *clip =
+    {
+        .m_Magic = ANIMCLIP_MAGIC,
+        .m_Version = ANIMCLIP_VERSION,
+        .m_Size = offset,
+        .m_Checksum = 0,
+        .m_TrackCount = trackCount,
+        .m_FrameCount = frameCount,
+        .m_FrameRate = source->m_FrameRate,
+        .m_BlockCount = blockCount,
+        .m_Tracks = sections[0],
+        .m_BlockKeys = sections[1],
+        .m_RotationFrames = sections[2],
+        .m_TranslationFrames = sections[3],
+        .m_RotationKeys = sections[4],
+        .m_TranslationKeys = sections[5],
+    };
+
+    u8* base = reinterpret_cast<u8*>(clip);
+    std::memcpy(base + clip->m_Tracks.m_Offset, tracks, sizes[0]);
+    std::memcpy(base + clip->m_RotationFrames.m_Offset, keyFrames[0], sizes[2]);
+    std::memcpy(base + clip->m_TranslationFrames.m_Offset, keyFrames[1], sizes[3]);
+    std::memcpy(base + clip->m_RotationKeys.m_Offset, keyWords[0], sizes[4]);
+    std::memcpy(base + clip->m_TranslationKeys.m_Offset, keyWords[1], sizes[5]);
+
+    // NOTE(sbalse): The last key at or before the first frame of every block.
+    u16* blockKeys = reinterpret_cast<u16*>(base + clip->m_BlockKeys.m_Offset);
+    for (u32 track = 0; track < trackCount; track++)
+    {
+        for (u32 channel = 0; channel < ANIMCLIP_CHANNEL_COUNT; channel++)
+        {
+            const bool rotation = static_cast<AnimClipChannel>(channel) == AnimClipChannel::ROTATION;
+            const u32 firstKey = rotation ? tracks[track].m_FirstRotationKey : tracks[track].m_FirstTranslationKey;
+            const u32 count = rotation ? tracks[track].m_RotationKeyCount : tracks[track].m_TranslationKeyCount;
+            const u16* frames = keyFrames[channel] + firstKey;
+            u16* blocks = blockKeys + ((static_cast<u64>(track) * ANIMCLIP_CHANNEL_COUNT + channel) * blockCount);
+
+            u32 key = 0;
+            for (u32 block = 0; block < blockCount; block++)
+            {
+                while (key + 1 < count && frames[key + 1] <= block * ANIMCLIP_BLOCK_FRAMES)
+                {
+                    key++;
+                }
+                blocks[block] = static_cast<u16>(key);
+            }
+        }
+    }
+
+    const u64 headerSize = AnimClipAlign(sizeof(AnimClip));
+    clip->m_Checksum = SceneFileChecksum(base + headerSize, clip->m_Size - headerSize);
+    return clip;
+}
+
+void AnimClipFree(AnimClip* clip)
+{
+    std::free(clip);
+}
+
+const AnimClip* AnimClipBind(const void* data, const u64 size)
+{
+    if (!data || size < sizeof(AnimClip) || reinterpret_cast<uintptr_t>(data) % ANIMCLIP_ALIGNMENT != 0)
+    {
+        return nullptr;
+    }
+
+    const AnimClip* clip = static_cast<const AnimClip*>(data);
+    if (clip->m_Magic != ANIMCLIP_MAGIC || clip->m_Version != ANIMCLIP_VERSION || clip->m_Size != size)
+    {
+        return nullptr;
+    }
+
+    const u32 blockCount = (clip->m_FrameCount + ANIMCLIP_BLOCK_FRAMES - 1) / ANIMCLIP_BLOCK_FRAMES;
+    if (clip->m_TrackCount == 0
+        || clip->m_FrameCount == 0
+        || clip->m_FrameCount > ANIMCLIP_MAX_FRAMES
+        || !(clip->m_FrameRate > 0.0f)
+        || clip->m_BlockCount != blockCount)
+    {
+        return nullptr;
+    }
+
+    const AnimClipSection* sections[6] =
+    {
+        &clip->m_Tracks,
+        &clip->m_BlockKeys,
+        &clip->m_RotationFrames,
+        &clip->m_TranslationFrames,
+        &clip->m_RotationKeys,
+        &clip->m_TranslationKeys,
+    };
+    // NOTE(sbalse): Sections have to be in order, sampling relies on the key words coming last.
+    u64 end = sizeof(AnimClip);
+    for (const AnimClipSection* section : sections)
+    {
+        if (section->m_Offset % ANIMCLIP_ALIGNMENT != 0
+            || section->m_Offset < end
+            || section->m_Offset > size
+            || section->m_Size > size - section->m_Offset)
+        {
+            return nullptr;
+        }
+        end = section->m_Offset + section->m_Size;
+    }
+
+    const u64 rotationKeyCount = clip->m_RotationFrames.m_Size / sizeof(u16);
+    const u64 translationKeyCount = clip->m_TranslationFrames.m_Size / sizeof(u16);
+    if (clip->m_Tracks.m_Size != static_cast<u64>(clip->m_TrackCount) * sizeof(AnimClipTrack)
+        || clip->m_BlockKeys.m_Size
+            != static_cast<u64>(clip->m_TrackCount) * ANIMCLIP_CHANNEL_COUNT * blockCount * sizeof(u16)
+        || clip->m_RotationKeys.m_Size != rotationKeyCount * 2 * sizeof(u32)
+        || clip->m_TranslationKeys.m_Size != translationKeyCount * 2 * sizeof(u32))
+    {
+        return nullptr;
+    }
+
+    const u64 headerSize = AnimClipAlign(sizeof(AnimClip));
+    const u8* base = static_cast<const u8*>(data);
+    if (SceneFileChecksum(base + headerSize, size - headerSize) != clip->m_Checksum)
+    {
+        return nullptr;
+    }
+
+    // NOTE(sbalse): Keys of every track have to be within the clip, sampling doesn't check.
+    const AnimClipTrack* tracks = reinterpret_cast<const AnimClipTrack*>(base + clip->m_Tracks.m_Offset);
+    for (u32 track = 0; track < clip->m_TrackCount; track++)
+    {
+        const AnimClipTrack* info = &tracks[track];
+        if (info->m_RotationKeyCount == 0
+            || info->m_TranslationKeyCount == 0
+            || info->m_FirstRotationKey > rotationKeyCount - info->m_RotationKeyCount
+            || info->m_FirstTranslationKey > translationKeyCount - info->m_TranslationKeyCount)
+        {
+            return nullptr;
+        }
+
+        const u16* blockKeys = reinterpret_cast<const u16*>(base + clip->m_BlockKeys.m_Offset)
+            + (static_cast<u64>(track) * ANIMCLIP_CHANNEL_COUNT * blockCount);
+        for (u32 block = 0; block < blockCount; block++)
+        {
+            if (blockKeys[block] >= info->m_RotationKeyCount
+                || blockKeys[blockCount + block] >= info->m_TranslationKeyCount)
+            {
+                return nullptr;
+            }
+        }
+    }
+    return clip;
+}
+
+void AnimClipSample(const AnimClip* clip, const float* times, const u32 instanceCount, AnimTransform* poses)
+{
+    const AnimClipView view = AnimClipGetView(clip);
+    const bool simd = AnimClipSimdEnabled();
+
+    // NOTE(sbalse): Instances on the outside so every group of eight fills its poses before moving on.
+    u32 i = 0;
+    if (simd)
+    {
+        for (; i + 8 <= instanceCount; i += 8)
+        {
+            for (u32 track = 0; track < clip->m_TrackCount; track++)
+            {
+                AnimClipSampleAvx2(clip, &view, track, times, i, poses);
+            }
+        }
+    }
+    for (; i < instanceCount; i++)
+    {
+        for (u32 track = 0; track < clip->m_TrackCount; track++)
+        {
+            AnimTransform* pose = &poses[(static_cast<u64>(i) * clip->m_TrackCount) + track];
+            AnimClipSampleScalar(clip, &view, track, times[i], pose);
+        }
+    }
+}
+
+void AnimClipEnableSimd(const bool enabled)
+{
+    g_AnimClipSimdRequested = enabled;
+}
+
+bool AnimClipSimdEnabled()
+{
+    return g_AnimClipSimdRequested && CpuHasAvx2();
+}
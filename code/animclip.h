@@ -0,0 +1,95 @@
+#pragma once
+#include "types.h"
+
+/*
+* NOTE(sbalse): Compressed keyframe animation. A clip holds a rotation and a translation track per bone, sampled
+* at a fixed frame rate by whatever authored it. Compressing it:
+*   - Drops every key that linear interpolation between its neighbours reproduces within the tolerance. The
+*     error is checked against the quantized keys, so the bound holds for what is actually played back.
+*   - Stores rotations as the smallest three components of the quaternion in 16 bits each, plus which one was
+*     left out, and translations in 16 bits per component within the range of their track. Every key is 8
+*     bytes, a raw frame of a bone is 28.
+*
+* A compressed clip is one block addressed by offsets from its start, with every section on an
+* ANIMCLIP_ALIGNMENT boundary, so it can be written to disk as it is and used straight out of a mapping.
+* Sampling finds the keys of one bone of eight instances and decodes them at a time with AVX2, starting from a per
+* track index of the last key before every ANIMCLIP_BLOCK_FRAMES frames. The scalar and the AVX2 path give the
+* same results bit for bit.
+*/
+
+constexpr u32 ANIMCLIP_MAGIC = 0x4D494E41; // NOTE(sbalse): "ANIM".
+constexpr u32 ANIMCLIP_VERSION = 1;
+constexpr u32 ANIMCLIP_ALIGNMENT = 64;
+constexpr u32 ANIMCLIP_BLOCK_SHIFT = 3;
+constexpr u32 ANIMCLIP_BLOCK_FRAMES = 1u << ANIMCLIP_BLOCK_SHIFT;
+constexpr u32 ANIMCLIP_MAX_FRAMES = 65535; // NOTE(sbalse): Key frames are stored in 16 bits.
+
+struct AnimTransform
+{
+    float m_Rotation[4]; // NOTE(sbalse): x, y, z, w.
+    float m_Translation[3];
+};
+
+// NOTE(sbalse): Frame f of track t is m_Frames[f * m_TrackCount + t].
+struct AnimClipSource
+{
+    const AnimTransform* m_Frames;
+    u32 m_TrackCount;
+    u32 m_FrameCount;
+    float m_FrameRate;
+};
+
+struct AnimClipTolerance
+{
+    float m_Rotation; // NOTE(sbalse): Radians.
+    float m_Translation;
+};
+
+struct AnimClipSection
+{
+    u64 m_Offset;
+    u64 m_Size;
+};
+
+struct AnimClipTrack
+{
+    float m_TranslationMin[3];
+    float m_TranslationStep[3]; // NOTE(sbalse): Size of one quantization step per component.
+    u32 m_FirstRotationKey;
+    u32 m_RotationKeyCount;
+    u32 m_FirstTranslationKey;
+    u32 m_TranslationKeyCount;
+};
+
+// NOTE(sbalse): Start of a compressed clip.
+struct AnimClip
+{
+    u32 m_Magic;
+    u32 m_Version;
+    u64 m_Size; // NOTE(sbalse): Of the whole clip.
+    u64 m_Checksum; // NOTE(sbalse): Of everything after the header.
+    u32 m_TrackCount;
+    u32 m_FrameCount;
+    float m_FrameRate;
+    u32 m_BlockCount;
+    AnimClipSection m_Tracks; // NOTE(sbalse): AnimClipTrack per track.
+    // NOTE(sbalse): u16 per block of every track, rotations then translations. Relative to the track's first key.
+    AnimClipSection m_BlockKeys;
+    AnimClipSection m_RotationFrames; // NOTE(sbalse): u16 frame of every key.
+    AnimClipSection m_TranslationFrames;
+    AnimClipSection m_RotationKeys; // NOTE(sbalse): Two u32 per key.
+    AnimClipSection m_TranslationKeys;
+};
+
+// NOTE(sbalse): Returns nullptr when the source is empty or too long. Free the result with AnimClipFree().
+AnimClip* AnimClipCompress(const AnimClipSource* source, const AnimClipTolerance* tolerance);
+void AnimClipFree(AnimClip* clip);
+// NOTE(sbalse): Validates a clip in place, for example in a mapped file. Returns nullptr when it isn't one.
+const AnimClip* AnimClipBind(const void* data, const u64 size);
+// NOTE(sbalse): Samples every track of the clip for instanceCount instances, each at its own time in seconds.
+// Times are clamped to the clip. Track t of instance i goes to poses[i * trackCount + t].
+void AnimClipSample(const AnimClip* clip, const float* times, const u32 instanceCount, AnimTransform* poses);
+
+// NOTE(sbalse): The scalar and the AVX2 path give the same results bit for bit, this only exists to compare them.
+void AnimClipEnableSimd(const bool enabled);
+bool AnimClipSimdEnabled();
@@ -0,0 +1,651 @@
+#include "broadphase.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#include <emmintrin.h>
+
+#include "jobs.h"
+
+namespace
+{
+    constexpr u32 BROADPHASE_MAX_CELLS = BROADPHASE_MAX_CELLS_PER_AXIS * BROADPHASE_MAX_CELLS_PER_AXIS;
+    // NOTE(sbalse): Extra entries after the cell lists, so the sweep can always read four at once.
+    constexpr u32 BROADPHASE_PADDING = 4;
+    constexpr u32 BROADPHASE_ENTRY_STREAMS = 6;
+    // NOTE(sbalse): Objects per batch when filling the cells, cells per batch when sweeping them.
+    constexpr u32 BROADPHASE_FILL_BATCH = 16384;
+    constexpr u32 BROADPHASE_SWEEP_BATCH = 16;
+    constexpr u32 BROADPHASE_SWEEP_BATCHES = BROADPHASE_MAX_CELLS / BROADPHASE_SWEEP_BATCH;
+    // NOTE(sbalse): The insertion sort gives up and sorts from scratch after this many moves per object, about
+    // where the radix sort gets cheaper. It isn't even tried when more than one in this many neighbours in the
+    // last order are out of order now.
+    constexpr u32 BROADPHASE_MAX_SWAPS_PER_OBJECT = 4;
+    constexpr u32 BROADPHASE_MAX_DESCENTS_DIVISOR = 8;
+    constexpr u32 BROADPHASE_RADIX_BITS = 11;
+    constexpr u32 BROADPHASE_RADIX_BUCKETS = 1u << BROADPHASE_RADIX_BITS;
+    constexpr u32 BROADPHASE_RADIX_PASSES = (32 + BROADPHASE_RADIX_BITS - 1) / BROADPHASE_RADIX_BITS;
+    // NOTE(sbalse): Another axis has to be this much more spread out before the objects are sorted along it
+    // instead, so the axis doesn't flip back and forth.
+    constexpr float BROADPHASE_AXIS_HYSTERESIS = 1.25f;
+    // NOTE(sbalse): Cells are at least this many average boxes wide, so most boxes fall into a single cell.
+    constexpr float BROADPHASE_CELL_SIZE_IN_BOXES = 4.0f;
+
+    struct BroadphasePairBuffer
+    {
+        BroadphasePair* m_Pairs;
+        u32 m_Count;
+        u32 m_Capacity;
+    };
+
+    // NOTE(sbalse): Grid over the two axes that aren't sorted along.
+    struct BroadphaseGrid
+    {
+        float m_Origin[2];
+        float m_InverseCellSize[2];
+        u32 m_Cells[2];
+    };
+
+    // NOTE(sbalse): Boxes relative to the sort axis, gathered in sorted order so the passes after it read them in
+    // a line. m_Cells holds the first and last cell the box touches on each grid axis, a byte each.
+    struct BroadphaseSorted
+    {
+        float* m_Min;
+        float* m_Max;
+        float* m_OtherMin[2];
+        float* m_OtherMax[2];
+        u32* m_Cells;
+    };
+
+    // NOTE(sbalse): Cell lists of all cells back to back, same layout as BroadphaseSorted.
+    struct BroadphaseEntries
+    {
+        u32* m_Object;
+        float* m_Min;
+        float* m_Max;
+        float* m_OtherMin[2];
+        float* m_OtherMax[2];
+        float* m_Storage;
+        u32 m_Capacity;
+    };
+}
+
+struct Broadphase
+{
+    u32 m_Capacity;
+    u32 m_Count; // NOTE(sbalse): Objects of the last update, 0 before the first one.
+    u32 m_Axis;
+    u32* m_Order; // NOTE(sbalse): Object indices, sorted by their minimum on m_Axis.
+    u32* m_SortScratch; // NOTE(sbalse): Keys and indices for the radix sort to ping pong between.
+    BroadphaseSorted m_Sorted;
+    float* m_SortedStorage;
+
+    BroadphaseGrid m_Grid;
+    BroadphaseEntries m_Entries;
+    u32* m_FillCounts; // NOTE(sbalse): Entries of every fill batch in every cell, then where the batch writes them.
+    u32 m_CellStart[BROADPHASE_MAX_CELLS + 1];
+
+    const BroadphaseBounds* m_Bounds; // NOTE(sbalse): Only during an update.
+
+    BroadphasePairBuffer m_Batches[BROADPHASE_SWEEP_BATCHES];
+    BroadphasePairBuffer m_Pairs;
+    BroadphaseStats m_Stats;
+};
+
+namespace
+{
+    u32 BroadphaseOtherAxis(const u32 axis, const u32 other)
+    {
+        return (axis + 1 + other) % 3;
+    }
+
+    // NOTE(sbalse): Picks the axis with the largest variance of the box centers, sweeping along it leaves the
+    // fewest objects in range of each other. Lays the grid over the other two.
+    void BroadphaseMeasure(Broadphase* broadphase, const BroadphaseBounds* bounds, const u32 count)
+    {
+        float variance[3] = {};
+        float low[3] = {};
+        float high[3] = {};
+        float meanSize[3] = {};
+        for (u32 axis = 0; axis < 3; axis++)
+        {
+            const float* min = bounds->m_Min[axis];
+            const float* max = bounds->m_Max[axis];
+            double sum = 0.0;
+            double sumSquares = 0.0;
+            double sumSizes = 0.0;
+            low[axis] = min[0];
+            high[axis] = max[0];
+            for (u32 i = 0; i < count; i++)
+            {
+                const double center = 0.5 * (static_cast<double>(min[i]) + max[i]);
+                sum += center;
+                sumSquares += center * center;
+                sumSizes += static_cast<double>(max[i]) - min[i];
+                low[axis] = min[i] < low[axis] ? min[i] : low[axis];
+                high[axis] = max[i] > high[axis] ? max[i] : high[axis];
+            }
+            const double mean = sum / count;
+            variance[axis] = static_cast<float>(sumSquares / count - mean * mean);
+            meanSize[axis] = static_cast<float>(sumSizes / count);
+        }
+
+        u32 best = broadphase->m_Axis;
+        for (u32 axis = 0; axis < 3; axis++)
+        {
+            if (variance[axis] > variance[best] * BROADPHASE_AXIS_HYSTERESIS)
+            {
+                best = axis;
+            }
+        }
+        broadphase->m_Axis = best;
+
+        BroadphaseGrid* grid = &broadphase->m_Grid;
+        for (u32 other = 0; other < 2; other++)
+        {
+            const u32 axis = BroadphaseOtherAxis(best, other);
+            const float range = high[axis] - low[axis];
+            const float minimumSize = range / static_cast<float>(BROADPHASE_MAX_CELLS_PER_AXIS);
+            const float preferredSize = meanSize[axis] * BROADPHASE_CELL_SIZE_IN_BOXES;
+            const float cellSize = preferredSize > minimumSize ? preferredSize : minimumSize;
+
+            u32 cells = cellSize > 0.0f ? static_cast<u32>(range / cellSize) + 1 : 1;
+            cells = cells < BROADPHASE_MAX_CELLS_PER_AXIS ? cells : BROADPHASE_MAX_CELLS_PER_AXIS;
+            grid->m_Origin[other] = low[axis];
+            grid->m_InverseCellSize[other] = cellSize > 0.0f ? 1.0f / cellSize : 0.0f;
+            grid->m_Cells[other] = cells;
+        }
+    }
+
+    u32 BroadphaseCell(const BroadphaseGrid* grid, const u32 other, const float value)
+    {
+        const float cell = (value - grid->m_Origin[other]) * grid->m_InverseCellSize[other];
+        const u32 last = grid->m_Cells[other] - 1;
+        if (!(cell > 0.0f))
+        {
+            return 0;
+        }
+        return cell < static_cast<float>(last) ? static_cast<u32>(cell) : last;
+    }
+
+    // NOTE(sbalse): Sorts the keys of the last order again, moving the object indices along. Returns false when
+    // the order changed too much for this to be cheap.
+    bool BroadphaseInsertionSort(float* keys, u32* order, const u32 count, u32* swaps)
+    {
+        const u64 budget = static_cast<u64>(count) * BROADPHASE_MAX_SWAPS_PER_OBJECT;
+        u64 moved = 0;
+        for (u32 i = 1; i < count; i++)
+        {
+            const float key = keys[i];
+            const u32 object = order[i];
+            u32 j = i;
+            while (j > 0 && keys[j - 1] > key)
+            {
+                keys[j] = keys[j - 1];
+                order[j] = order[j - 1];
+                j--;
+            }
+            keys[j] = key;
+            order[j] = object;
+
+            moved += i - j;
+            if (moved > budget)
+            {
+                return false;
+            }
+        }
+        *swaps = static_cast<u32>(moved);
+        return true;
+    }
+
+    // NOTE(sbalse): Flips the bits so the keys order as unsigned integers the way the floats order.
+    u32 BroadphaseRadixKey(const float key)
+    {
+        const u32 bits = std::bit_cast<u32>(key);
+        return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+    }
+
+    // NOTE(sbalse): Sorts the object indices by their keys from scratch, a pass per digit from the lowest. Every
+    // pass is stable, so equal keys stay in index order.
+    void BroadphaseRadixSort(const float* keys, u32* order, u32* scratch, const u32 count)
+    {
+        u32* keysA = scratch;
+        u32* keysB = scratch + count;
+        u32* orderB = scratch + (static_cast<size_t>(count) * 2);
+
+        static_assert(BROADPHASE_RADIX_PASSES == 3, "The passes below ping pong an odd number of times.");
+        u32 offsets[BROADPHASE_RADIX_PASSES][BROADPHASE_RADIX_BUCKETS] = {};
+        for (u32 i = 0; i < count; i++)
+        {
+            const u32 key = BroadphaseRadixKey(keys[i]);
+            keysA[i] = key;
+            for (u32 pass = 0; pass < BROADPHASE_RADIX_PASSES; pass++)
+            {
+                offsets[pass][(key >> (pass * BROADPHASE_RADIX_BITS)) & (BROADPHASE_RADIX_BUCKETS - 1)]++;
+            }
+        }
+        for (u32 pass = 0; pass < BROADPHASE_RADIX_PASSES; pass++)
+        {
+            u32 total = 0;
+            for (u32 bucket = 0; bucket < BROADPHASE_RADIX_BUCKETS; bucket++)
+            {
+                const u32 bucketCount = offsets[pass][bucket];
+                offsets[pass][bucket] = total;
+                total += bucketCount;
+            }
+        }
+
+        // NOTE(sbalse): The first pass starts from the identity order, the last one lands in order.
+        for (u32 i = 0; i < count; i++)
+        {
+            const u32 destination = offsets[0][keysA[i] & (BROADPHASE_RADIX_BUCKETS - 1)]++;
+            keysB[destination] = keysA[i];
+            order[destination] = i;
+        }
+        for (u32 i = 0; i < count; i++)
+        {
+            const u32 destination = offsets[1][(keysB[i] >> BROADPHASE_RADIX_BITS) & (BROADPHASE_RADIX_BUCKETS - 1)]++;
+            keysA[destination] = keysB[i];
+            orderB[destination] = order[i];
+        }
+        for (u32 i = 0; i < count; i++)
+        {
+            order[offsets[2][keysA[i] >> (2 * BROADPHASE_RADIX_BITS)]++] = orderB[i];
+        }
+    }
+
+    // NOTE(sbalse): Calls visit(cell) for every cell in a range packed by BroadphaseGatherRange.
+    template<typename Visit>
+    void BroadphaseForEachCell(const BroadphaseGrid* grid, const u32 cells, const Visit& visit)
+    {
+        const u32 first0 = cells & 0xFF;
+        const u32 last0 = (cells >> 8) & 0xFF;
+        const u32 first1 = (cells >> 16) & 0xFF;
+        const u32 last1 = cells >> 24;
+        for (u32 cell1 = first1; cell1 <= last1; cell1++)
+        {
+            for (u32 cell0 = first0; cell0 <= last0; cell0++)
+            {
+                visit((cell1 * grid->m_Cells[0]) + cell0);
+            }
+        }
+    }
+
+    u32* BroadphaseFillCounts(const Broadphase* broadphase, const u32 index)
+    {
+        return broadphase->m_FillCounts + (static_cast<size_t>(index / BROADPHASE_FILL_BATCH) * BROADPHASE_MAX_CELLS);
+    }
+
+    // NOTE(sbalse): Gathers the boxes in sorted order and counts the entries of every batch in every cell. Without
+    // workers a dispatch runs as a single range, so the batches are walked here.
+    void BroadphaseGatherRange(void* context, const u32 begin, const u32 end)
+    {
+        const Broadphase* broadphase = static_cast<const Broadphase*>(context);
+        const BroadphaseBounds* bounds = broadphase->m_Bounds;
+        const BroadphaseSorted* sorted = &broadphase->m_Sorted;
+        const BroadphaseGrid* grid = &broadphase->m_Grid;
+        const u32 axis = broadphase->m_Axis;
+        const u32 axis0 = BroadphaseOtherAxis(axis, 0);
+        const u32 axis1 = BroadphaseOtherAxis(axis, 1);
+
+        for (u32 i = begin; i < end; i++)
+        {
+            u32* counts = BroadphaseFillCounts(broadphase, i);
+            if (i % BROADPHASE_FILL_BATCH == 0)
+            {
+                std::memset(counts, 0, BROADPHASE_MAX_CELLS * sizeof(u32));
+            }
+
+            const u32 object = broadphase->m_Order[i];
+            const float min0 = bounds->m_Min[axis0][object];
+            const float max0 = bounds->m_Max[axis0][object];
+            const float min1 = bounds->m_Min[axis1][object];
+            const float max1 = bounds->m_Max[axis1][object];
+            sorted->m_Min[i] = bounds->m_Min[axis][object];
+            sorted->m_Max[i] = bounds->m_Max[axis][object];
+            sorted->m_OtherMin[0][i] = min0;
+            sorted->m_OtherMax[0][i] = max0;
+            sorted->m_OtherMin[1][i] = min1;
+            sorted->m_OtherMax[1][i] = max1;
+
+            const u32 cells = BroadphaseCell(grid, 0, min0)
+                | (BroadphaseCell(grid, 0, max0) << 8)
+                | (BroadphaseCell(grid, 1, min1) << 16)
+                | (BroadphaseCell(grid, 1, max1) << 24);
+            sorted->m_Cells[i] = cells;
+            BroadphaseForEachCell(grid, cells, [counts](const u32 cell)
+            {
+                counts[cell]++;
+            });
+        }
+    }
+
+    // NOTE(sbalse): Objects are visited in sorted order and every batch writes after the batches before it, so
+    // every cell list comes out sorted.
+    void BroadphaseFillRange(void* context, const u32 begin, const u32 end)
+    {
+        const Broadphase* broadphase = static_cast<const Broadphase*>(context);
+        const BroadphaseSorted* sorted = &broadphase->m_Sorted;
+        const BroadphaseEntries* entries = &broadphase->m_Entries;
+
+        for (u32 i = begin; i < end; i++)
+        {
+            u32* cursors = BroadphaseFillCounts(broadphase, i);
+            BroadphaseForEachCell(&broadphase->m_Grid, sorted->m_Cells[i], [&](const u32 cell)
+            {
+                const u32 entry = cursors[cell]++;
+                entries->m_Object[entry] = broadphase->m_Order[i];
+                entries->m_Min[entry] = sorted->m_Min[i];
+                entries->m_Max[entry] = sorted->m_Max[i];
+                entries->m_OtherMin[0][entry] = sorted->m_OtherMin[0][i];
+                entries->m_OtherMax[0][entry] = sorted->m_OtherMax[0][i];
+                entries->m_OtherMin[1][entry] = sorted->m_OtherMin[1][i];
+                entries->m_OtherMax[1][entry] = sorted->m_OtherMax[1][i];
+            });
+        }
+    }
+
+    // NOTE(sbalse): A failed allocation drops the pair rather than the whole update.
+    void BroadphasePush(BroadphasePairBuffer* buffer, const u32 a, const u32 b)
+    {
+        if (buffer->m_Count == buffer->m_Capacity)
+        {
+            const u32 capacity = buffer->m_Capacity ? buffer->m_Capacity * 2 : 256;
+            void* pairs = std::realloc(buffer->m_Pairs, capacity * sizeof(BroadphasePair));
+            if (!pairs)
+            {
+                return;
+            }
+            buffer->m_Pairs = static_cast<BroadphasePair*>(pairs);
+            buffer->m_Capacity = capacity;
+        }
+        buffer->m_Pairs[buffer->m_Count++] = a < b ? BroadphasePair{ a, b } : BroadphasePair{ b, a };
+    }
+
+    void BroadphaseSweepCell(const Broadphase* broadphase, const u32 cell, BroadphasePairBuffer* pairs)
+    {
+        const BroadphaseEntries* entries = &broadphase->m_Entries;
+        const BroadphaseGrid* grid = &broadphase->m_Grid;
+        const u32 begin = broadphase->m_CellStart[cell];
+        const u32 end = broadphase->m_CellStart[cell + 1];
+
+        for (u32 i = begin; i < end; i++)
+        {
+            const __m128 max = _mm_set1_ps(entries->m_Max[i]);
+            const __m128 min0 = _mm_set1_ps(entries->m_OtherMin[0][i]);
+            const __m128 max0 = _mm_set1_ps(entries->m_OtherMax[0][i]);
+            const __m128 min1 = _mm_set1_ps(entries->m_OtherMin[1][i]);
+            const __m128 max1 = _mm_set1_ps(entries->m_OtherMax[1][i]);
+
+            // NOTE(sbalse): The list is sorted, so the lanes still in range are always a prefix. Once a group isn't
+            // completely in range, nothing after it is either.
+            for (u32 j = i + 1; j < end; j += 4)
+            {
+                const __m128 inRange = _mm_cmple_ps(_mm_loadu_ps(entries->m_Min + j), max);
+                u32 rangeMask = static_cast<u32>(_mm_movemask_ps(inRange));
+                rangeMask &= end - j < 4 ? (1u << (end - j)) - 1 : 0xF;
+                if (rangeMask == 0)
+                {
+                    break;
+                }
+
+                const __m128 overlap0 = _mm_and_ps(
+                    _mm_cmple_ps(_mm_loadu_ps(entries->m_OtherMin[0] + j), max0),
+                    _mm_cmpge_ps(_mm_loadu_ps(entries->m_OtherMax[0] + j), min0));
+                const __m128 overlap1 = _mm_and_ps(
+                    _mm_cmple_ps(_mm_loadu_ps(entries->m_OtherMin[1] + j), max1),
+                    _mm_cmpge_ps(_mm_loadu_ps(entries->m_OtherMax[1] + j), min1));
+                u32 mask = rangeMask & static_cast<u32>(_mm_movemask_ps(_mm_and_ps(overlap0, overlap1)));
+                while (mask)
+                {
+                    const u32 other = j + static_cast<u32>(std::countr_zero(mask));
+                    mask &= mask - 1;
+
+                    // NOTE(sbalse): Only the cell holding the corner where the overlap starts reports the pair.
+                    const float corner0 = std::max(entries->m_OtherMin[0][i], entries->m_OtherMin[0][other]);
+                    const float corner1 = std::max(entries->m_OtherMin[1][i], entries->m_OtherMin[1][other]);
+                    const u32 owner0 = BroadphaseCell(grid, 0, corner0);
+                    const u32 owner1 = BroadphaseCell(grid, 1, corner1);
+                    if ((owner1 * grid->m_Cells[0]) + owner0 == cell)
+                    {
+                        BroadphasePush(pairs, entries->m_Object[i], entries->m_Object[other]);
+                    }
+                }
+
+                if (rangeMask != 0xF)
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    void BroadphaseSweepRange(void* context, const u32 begin, const u32 end)
+    {
+        Broadphase* broadphase = static_cast<Broadphase*>(context);
+        for (u32 cell = begin; cell < end; cell++)
+        {
+            BroadphasePairBuffer* pairs = &broadphase->m_Batches[cell / BROADPHASE_SWEEP_BATCH];
+            if (cell % BROADPHASE_SWEEP_BATCH == 0)
+            {
+                pairs->m_Count = 0;
+            }
+            BroadphaseSweepCell(broadphase, cell, pairs);
+        }
+    }
+
+    bool BroadphaseReserveEntries(BroadphaseEntries* entries, const u32 count)
+    {
+        if (count <= entries->m_Capacity)
+        {
+            return true;
+        }
+
+        // NOTE(sbalse): Grow with some headroom, the number of boxes straddling cells changes every update.
+        const u32 capacity = count + (count / 4);
+        const size_t streamSize = static_cast<size_t>(capacity) + BROADPHASE_PADDING;
+        float* storage = static_cast<float*>(std::calloc(streamSize * BROADPHASE_ENTRY_STREAMS, sizeof(float)));
+        u32* objects = static_cast<u32*>(std::calloc(streamSize, sizeof(u32)));
+        if (!storage || !objects)
+        {
+            std::free(storage);
+            std::free(objects);
+            return false;
+        }
+
+        std::free(entries->m_Storage);
+        std::free(entries->m_Object);
+        entries->m_Storage = storage;
+        entries->m_Object = objects;
+        entries->m_Min = storage;
+        entries->m_Max = entries->m_Min + streamSize;
+        entries->m_OtherMin[0] = entries->m_Max + streamSize;
+        entries->m_OtherMax[0] = entries->m_OtherMin[0] + streamSize;
+        entries->m_OtherMin[1] = entries->m_OtherMax[0] + streamSize;
+        entries->m_OtherMax[1] = entries->m_OtherMin[1] + streamSize;
+        entries->m_Capacity = capacity;
+        return true;
+    }
+}
+
+Broadphase* BroadphaseCreate(const u32 capacity)
+{
+    Broadphase* broadphase = static_cast<Broadphase*>(std::calloc(1, sizeof(Broadphase)));
+    if (!broadphase)
+    {
+        return nullptr;
+    }
+
+    const u32 fillBatches = (capacity + BROADPHASE_FILL_BATCH - 1) / BROADPHASE_FILL_BATCH;
+    const size_t streamSize = capacity > 0 ? capacity : 1;
+    broadphase->m_Capacity = capacity;
+    broadphase->m_Order = static_cast<u32*>(std::calloc(streamSize, sizeof(u32)));
+    broadphase->m_SortScratch = static_cast<u32*>(std::calloc(streamSize * 3, sizeof(u32)));
+    broadphase->m_SortedStorage =
+        static_cast<float*>(std::calloc(streamSize * BROADPHASE_ENTRY_STREAMS, sizeof(float)));
+    broadphase->m_Sorted.m_Cells = static_cast<u32*>(std::calloc(streamSize, sizeof(u32)));
+    broadphase->m_FillCounts = static_cast<u32*>(
+        std::calloc(static_cast<size_t>(fillBatches > 0 ? fillBatches : 1) * BROADPHASE_MAX_CELLS, sizeof(u32)));
+    if (!broadphase->m_Order ||
+        !broadphase->m_SortScratch ||
+        !broadphase->m_SortedStorage ||
+        !broadphase->m_Sorted.m_Cells ||
+        !broadphase->m_FillCounts ||
+        !BroadphaseReserveEntries(&broadphase->m_Entries, capacity))
+    {
+        BroadphaseDestroy(broadphase);
+        return nullptr;
+    }
+
+    BroadphaseSorted* sorted = &broadphase->m_Sorted;
+    sorted->m_Min = broadphase->m_SortedStorage;
+    sorted->m_Max = sorted->m_Min + streamSize;
+    sorted->m_OtherMin[0] = sorted->m_Max + streamSize;
+    sorted->m_OtherMax[0] = sorted->m_OtherMin[0] + streamSize;
+    sorted->m_OtherMin[1] = sorted->m_OtherMax[0] + streamSize;
+    sorted->m_OtherMax[1] = sorted->m_OtherMin[1] + streamSize;
+    return broadphase;
+}
+
+void BroadphaseDestroy(Broadphase* broadphase)
+{
+    if (!broadphase)
+    {
+        return;
+    }
+
+    for (BroadphasePairBuffer& batch : broadphase->m_Batches)
+    {
+        std::free(batch.m_Pairs);
+    }
+    std::free(broadphase->m_Pairs.m_Pairs);
+    std::free(broadphase->m_Entries.m_Storage);
+    std::free(broadphase->m_Entries.m_Object);
+    std::free(broadphase->m_FillCounts);
+    std::free(broadphase->m_Sorted.m_Cells);
+    std::free(broadphase->m_SortedStorage);
+    std::free(broadphase->m_SortScratch);
+    std::free(broadphase->m_Order);
+    std::free(broadphase);
+}
+
+u32 BroadphaseUpdate(Broadphase* broadphase, const BroadphaseBounds* bounds, const u32 count)
+{
+    const u32 objectCount = count < broadphase->m_Capacity ? count : broadphase->m_Capacity;
+    broadphase->m_Stats = {};
+    broadphase->m_Pairs.m_Count = 0;
+    if (objectCount == 0)
+    {
+        broadphase->m_Count = 0;
+        return 0;
+    }
+
+    const u32 previousAxis = broadphase->m_Axis;
+    BroadphaseMeasure(broadphase, bounds, objectCount);
+    const u32 axis = broadphase->m_Axis;
+    bool resort = objectCount != broadphase->m_Count || axis != previousAxis;
+    broadphase->m_Count = objectCount;
+    broadphase->m_Bounds = bounds;
+
+    const float* keys = bounds->m_Min[axis];
+    u32* order = broadphase->m_Order;
+    // NOTE(sbalse): The sorted minimums are rewritten by the gather below, until then they hold the sort keys.
+    float* sortedKeys = broadphase->m_Sorted.m_Min;
+
+    if (!resort)
+    {
+        u32 descents = 0;
+        for (u32 i = 0; i < objectCount; i++)
+        {
+            sortedKeys[i] = keys[order[i]];
+            descents += (i > 0 && sortedKeys[i] < sortedKeys[i - 1]) ? 1 : 0;
+        }
+        resort = descents > objectCount / BROADPHASE_MAX_DESCENTS_DIVISOR
+            || !BroadphaseInsertionSort(sortedKeys, order, objectCount, &broadphase->m_Stats.m_Swaps);
+    }
+
+    if (resort)
+    {
+        BroadphaseRadixSort(keys, order, broadphase->m_SortScratch, objectCount);
+    }
+
+    // NOTE(sbalse): Turn the counts of every batch in every cell into where each batch starts writing in each cell:
+    // cell by cell, and batch by batch inside a cell.
+    JobsWait(JobsDispatch(objectCount, BROADPHASE_FILL_BATCH, BroadphaseGatherRange, broadphase));
+
+    const u32 fillBatches = (objectCount + BROADPHASE_FILL_BATCH - 1) / BROADPHASE_FILL_BATCH;
+    const u32 cellCount = broadphase->m_Grid.m_Cells[0] * broadphase->m_Grid.m_Cells[1];
+    u32 entryCount = 0;
+    for (u32 cell = 0; cell < cellCount; cell++)
+    {
+        broadphase->m_CellStart[cell] = entryCount;
+        for (u32 batch = 0; batch < fillBatches; batch++)
+        {
+            u32* slot = &broadphase->m_FillCounts[(static_cast<size_t>(batch) * BROADPHASE_MAX_CELLS) + cell];
+            const u32 batchEntries = *slot;
+            *slot = entryCount;
+            entryCount += batchEntries;
+        }
+    }
+    broadphase->m_CellStart[cellCount] = entryCount;
+
+    if (!BroadphaseReserveEntries(&broadphase->m_Entries, entryCount))
+    {
+        broadphase->m_Bounds = nullptr;
+        return 0;
+    }
+
+    JobsWait(JobsDispatch(objectCount, BROADPHASE_FILL_BATCH, BroadphaseFillRange, broadphase));
+    JobsWait(JobsDispatch(cellCount, BROADPHASE_SWEEP_BATCH, BroadphaseSweepRange, broadphase));
+    broadphase->m_Bounds = nullptr;
+
+    // NOTE(sbalse): Join the pairs of all batches in batch order.
+    const u32 sweepBatches = (cellCount + BROADPHASE_SWEEP_BATCH - 1) / BROADPHASE_SWEEP_BATCH;
+    u32 pairCount = 0;
+    for (u32 i = 0; i < sweepBatches; i++)
+    {
+        pairCount += broadphase->m_Batches[i].m_Count;
+    }
+
+    BroadphasePairBuffer* pairs = &broadphase->m_Pairs;
+    if (pairCount > pairs->m_Capacity)
+    {
+        void* grown = std::realloc(pairs->m_Pairs, pairCount * sizeof(BroadphasePair));
+        if (grown)
+        {
+            pairs->m_Pairs = static_cast<BroadphasePair*>(grown);
+            pairs->m_Capacity = pairCount;
+        }
+    }
+
+    for (u32 i = 0; i < sweepBatches; i++)
+    {
+        const BroadphasePairBuffer* batch = &broadphase->m_Batches[i];
+        const u32 space = pairs->m_Capacity - pairs->m_Count;
+        const u32 copied = batch->m_Count < space ? batch->m_Count : space;
+        if (copied > 0)
+        {
+            std::memcpy(pairs->m_Pairs + pairs->m_Count, batch->m_Pairs, copied * sizeof(BroadphasePair));
+            pairs->m_Count += copied;
+        }
+    }
+
+    broadphase->m_Stats.m_Axis = axis;
+    broadphase->m_Stats.m_Resorted = resort;
+    broadphase->m_Stats.m_Cells = cellCount;
+    broadphase->m_Stats.m_Entries = entryCount;
+    broadphase->m_Stats.m_Pairs = pairs->m_Count;
+    return pairs->m_Count;
+}
+
+const BroadphasePair* BroadphaseGetPairs(const Broadphase* broadphase, u32* count)
+{
+    *count = broadphase->m_Pairs.m_Count;
+    return broadphase->m_Pairs.m_Pairs;
+}
+
+const BroadphaseStats* BroadphaseGetStats(const Broadphase* broadphase)
+{
+    return &broadphase->m_Stats;
+}
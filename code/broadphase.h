@@ -0,0 +1,58 @@
+#pragma once
+#include "types.h"
+
+/*
+* NOTE(sbalse): Sweep and prune broadphase. Finds every pair of axis aligned boxes that overlap.
+*
+* Objects are kept sorted by the minimum of their box on one axis, the one the box centers are spread out the
+* most along. Objects move little between updates, so the order of the last update is almost right and an
+* insertion sort fixes it up in close to linear time. When too many neighbours swapped places for that to be
+* cheap, as in a dense crowd, the order is radix sorted from scratch instead.
+*
+* Sweeping a single sorted list tests every object against everything that overlaps it on that one axis, which
+* grows with the square of the object count. So the other two axes are cut into a grid of cells, every object
+* goes into the cells its box touches, in sorted order, and each cell is swept on its own, testing the other
+* two axes four objects at a time. A pair sharing several cells is only reported by the cell holding the
+* corner where their overlap starts.
+*
+* Filling the cells and sweeping them run on the job workers. Every batch collects its pairs on its own and the
+* batches are joined in order, so the pairs come out the same whatever the number of workers.
+*/
+
+// NOTE(sbalse): Indices of two overlapping objects, m_A is always the smaller one.
+struct BroadphasePair
+{
+    u32 m_A;
+    u32 m_B;
+};
+
+// NOTE(sbalse): Boxes of all objects as structure of arrays, one array per axis and side.
+struct BroadphaseBounds
+{
+    const float* m_Min[3];
+    const float* m_Max[3];
+};
+
+struct BroadphaseStats
+{
+    u32 m_Axis; // NOTE(sbalse): Axis the objects are sorted along.
+    u32 m_Swaps; // NOTE(sbalse): Moves the insertion sort needed, a measure of how much the order changed.
+    bool m_Resorted; // NOTE(sbalse): True when the order had to be sorted from scratch.
+    u32 m_Cells;
+    u32 m_Entries; // NOTE(sbalse): Objects summed over all cells, more than the object count when boxes straddle cells.
+    u32 m_Pairs;
+};
+
+// NOTE(sbalse): Cells per axis of the grid over the two axes that aren't sorted along.
+constexpr u32 BROADPHASE_MAX_CELLS_PER_AXIS = 64;
+
+struct Broadphase;
+
+Broadphase* BroadphaseCreate(const u32 capacity);
+void BroadphaseDestroy(Broadphase* broadphase);
+// NOTE(sbalse): Finds the overlapping pairs among objects [0, count). Objects keep their index between updates,
+// a different count starts over with a full sort. Returns the number of pairs.
+u32 BroadphaseUpdate(Broadphase* broadphase, const BroadphaseBounds* bounds, const u32 count);
+// NOTE(sbalse): Pairs of the last update, in the order of the sweep. Valid until the next update.
+const BroadphasePair* BroadphaseGetPairs(const Broadphase* broadphase, u32* count);
+const BroadphaseStats* BroadphaseGetStats(const Broadphase* broadphase);
@@ -0,0 +1,94 @@
+#include "clock.h"
+
+#if _WIN32
+#include "cleanwindows.h"
+#else
+#include <time.h>
+#endif
+
+namespace
+{
+    constinit i64 s_Frequency = 0; // NOTE(sbalse): Ticks per second.
+}
+
+void ClockInit()
+{
+#if _WIN32
+    LARGE_INTEGER frequency = {};
+    QueryPerformanceFrequency(&frequency);
+    s_Frequency = frequency.QuadPart;
+#else
+    s_Frequency = 1'000'000'000; // NOTE(sbalse): clock_gettime() reports nanoseconds.
+#endif
+}
+
+i64 ClockNow()
+{
+#if _WIN32
+    LARGE_INTEGER counter = {};
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart;
+#else
+    timespec now = {};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<i64>(now.tv_sec) * 1'000'000'000 + now.tv_nsec;
+#endif
+}
+
+i64 ClockFrequency()
+{
+    return s_Frequency;
+}
+
+double ClockTicksToSeconds(const i64 ticks)
+{
+    return static_cast<double>(ticks) / static_cast<double>(s_Frequency);
+}
+
+double ClockTicksToMilliseconds(const i64 ticks)
+{
+    return ClockTicksToSeconds(ticks) * 1000.0;
+}
+
+i64 ClockSecondsToTicks(const double seconds)
+{
+    return static_cast<i64>(seconds * static_cast<double>(s_Frequency));
+}
+
+void FixedStepClockInit(FixedStepClock* clock, const double stepsPerSecond, const u32 maxStepsPerAdvance)
+{
+    clock->m_StepTicks = ClockSecondsToTicks(1.0 / stepsPerSecond);
+    clock->m_StepTicks = clock->m_StepTicks > 0 ? clock->m_StepTicks : 1;
+    clock->m_Accumulator = 0;
+    clock->m_LastTime = ClockNow();
+    clock->m_MaxStepsPerAdvance = maxStepsPerAdvance;
+    clock->m_DroppedSteps = 0;
+}
+
+u32 FixedStepClockAdvance(FixedStepClock* clock, const i64 now)
+{
+    clock->m_Accumulator += now - clock->m_LastTime;
+    clock->m_LastTime = now;
+
+    const i64 steps = clock->m_Accumulator / clock->m_StepTicks;
+    clock->m_Accumulator -= steps * clock->m_StepTicks;
+
+    if (steps > clock->m_MaxStepsPerAdvance)
+    {
+        clock->m_DroppedSteps = static_cast<u32>(steps - clock->m_MaxStepsPerAdvance);
+        return clock->m_MaxStepsPerAdvance;
+    }
+
+    clock->m_DroppedSteps = 0;
+    return static_cast<u32>(steps);
+}
+
+float FixedStepClockStepSeconds(const FixedStepClock* clock)
+{
+    return static_cast<float>(ClockTicksToSeconds(clock->m_StepTicks));
+}
+
+float FixedStepClockAlpha(const FixedStepClock* clock)
+{
+    return static_cast<float>(clock->m_Accumulator) / static_cast<float>(clock->m_StepTicks);
+}
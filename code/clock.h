@@ -0,0 +1,33 @@
+#pragma once
+#include "types.h"
+
+// NOTE(sbalse): High resolution monotonic clock. Timestamps are in ticks of the platform's performance
+// counter; use the conversion functions below to turn them into human units.
+void ClockInit();
+i64 ClockNow();
+i64 ClockFrequency();
+double ClockTicksToSeconds(const i64 ticks);
+double ClockTicksToMilliseconds(const i64 ticks);
+i64 ClockSecondsToTicks(const double seconds);
+
+/*
+* NOTE(sbalse): Fixed timestep accumulator. Real time is fed in and whole steps of a fixed length come out,
+* so the simulation runs at the same rate no matter how fast we render. When we fall too far behind, at
+* most m_MaxStepsPerAdvance steps are run and the rest of the backlog is dropped: the simulation slows
+* down instead of spiralling into ever longer frames.
+*/
+struct FixedStepClock
+{
+    i64 m_StepTicks;
+    i64 m_Accumulator;
+    i64 m_LastTime;
+    u32 m_MaxStepsPerAdvance;
+    u32 m_DroppedSteps; // NOTE(sbalse): Dropped by the last call to FixedStepClockAdvance.
+};
+
+void FixedStepClockInit(FixedStepClock* clock, const double stepsPerSecond, const u32 maxStepsPerAdvance);
+// NOTE(sbalse): Returns the number of steps to simulate to catch up with now.
+u32 FixedStepClockAdvance(FixedStepClock* clock, const i64 now);
+float FixedStepClockStepSeconds(const FixedStepClock* clock);
+// NOTE(sbalse): How far we are between the last simulated step and the next one, in [0, 1).
+float FixedStepClockAlpha(const FixedStepClock* clock);
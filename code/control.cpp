@@ -1,99 +1,426 @@
 #include "control.h"
 
+#include <cstdio>
+
 #include "cleanwindows.h"
+#include "clock.h"
+#include "coroutines.h"
+#include "deferredwork.h"
+#include "framepacer.h"
+#include "framepipeline.h"
+#include "stats.h"
+#include "telemetry.h"
 #include "graphics/graphics.h"
 #include "input.h"
+#include "jobs.h"
+#include "actionmap.h"
+#include "utils.h"
+#include "simulation.h"
+#include "taskgraph.h"
 
 namespace
 {
-    void InputTest()
+    // NOTE(sbalse): Run the simulation on its own thread, overlapped with render submission and present.
+    constexpr bool g_PipelinedSimulation = true;
+
+    // NOTE(sbalse): The simulation runs at this fixed rate regardless of the frame rate.
+    constexpr double g_SimulationStepsPerSecond = 60.0;
+    constexpr u32 g_MaxSimulationStepsPerFrame = 5;
+    // NOTE(sbalse): F6 takes the simulation back this far, once F7 started recording its history.
+    constexpr u32 g_RewindSteps = static_cast<u32>(g_SimulationStepsPerSecond * 2.0);
+
+    // NOTE(sbalse): Frame pacing. A target of 0 leaves pacing to vsync. While unfocused we either drop to the
+    // background rate or, when pausing, stop rendering until the window gets a message.
+    constexpr double g_TargetFrameRate = 60.0;
+    constexpr double g_BackgroundFrameRate = 10.0;
+    constexpr bool g_PauseWhenUnfocused = false;
+
+    // NOTE(sbalse): Share of the frame the renderer aims to use, the rest is margin for spikes. Without a target
+    // frame rate the budget is that of 60 frames per second.
+    constexpr double g_FrameBudgetFraction = 0.9;
+
+    // NOTE(sbalse): Deferred work fills the frame up to the budget, measured from the start of the frame.
+    constinit i64 g_FrameBudgetTicks = 0;
+    constinit i64 g_FrameStart = 0;
+
+    // NOTE(sbalse): Scene snapshot mapped at startup and written on first run or when saving.
+    constexpr const char* g_ScenePath = "scene.hwscene";
+    // NOTE(sbalse): Frame capture started and stopped with F9, see framecapture.h.
+    constexpr const char* g_CapturePath = "capture.hwcap";
+
+    // NOTE(sbalse): Startup timeline, kept around so it can be inspected in the debugger.
+    constinit i64 g_StartupTime = 0;
+    constinit char g_StartupReport[4096] = {};
+
+    constinit TelemetryMapping g_Telemetry = {};
+    constinit u64 g_TelemetryProcessMemory = 0;
+
+    // NOTE(sbalse): Process memory is only sampled every this many frames since it needs a syscall.
+    constexpr u64 TELEMETRY_MEMORY_SAMPLE_INTERVAL = 60;
+
+    void InitTelemetry()
     {
-        if (InputKeyboardButtonPressed(VK_ESCAPE))
+        if (!TelemetryCreate(&g_Telemetry, TELEMETRY_DEFAULT_NAME))
         {
-            OutputDebugString(L"Escape pressed\n");
-            PostQuitMessage(0); // NOTE(sbalse): Quit game on escape pressed.
+            OutputDebugStringA("Failed to create telemetry block, external monitoring is disabled\n");
+            return;
         }
-        else if (InputKeyboardButtonPressed('W'))
+
+        for (u32 i = 0; i < NUMSTATSSTAGES; i++)
         {
-            OutputDebugString(L"W pressed\n");
+            TelemetrySetStageName(g_Telemetry.m_Block, i, StatsStageName(static_cast<StatsStage>(i)));
         }
-        else if (InputKeyboardButtonReleased('W'))
+        TelemetrySetCounterName(g_Telemetry.m_Block, static_cast<u32>(StatsCounter::DRAWCALLS), "DRAWS");
+        TelemetrySetCounterName(g_Telemetry.m_Block, static_cast<u32>(StatsCounter::VISIBLEOBJECTS), "VISIBLE");
+        TelemetrySetCounterName(g_Telemetry.m_Block, static_cast<u32>(StatsCounter::BYTESUPLOADED), "UPLOADBYTES");
+        TelemetrySetCounterName(g_Telemetry.m_Block, static_cast<u32>(StatsCounter::SIMSTEPS), "SIMSTEPS");
+        TelemetrySetCounterName(g_Telemetry.m_Block, static_cast<u32>(StatsCounter::SIMSTEPSDROPPED), "SIMDROPPED");
+        TelemetrySetCounterName(g_Telemetry.m_Block, static_cast<u32>(StatsCounter::PARTICLES), "PARTICLES");
+        TelemetrySetCounterName(g_Telemetry.m_Block, static_cast<u32>(StatsCounter::OVERLAPS), "OVERLAPS");
+        TelemetrySetCounterName(g_Telemetry.m_Block, static_cast<u32>(StatsCounter::CAPTUREDROPPED), "CAPDROPPED");
+    }
+
+    void PublishTelemetry()
+    {
+        if (!g_Telemetry.m_Block)
         {
-            OutputDebugString(L"W released\n");
+            return;
         }
-        else if (InputKeyboardButtonPressed(VK_SPACE))
+
+        const StatsSummary* summary = StatsGetSummary();
+        if (summary->m_FrameIndex % TELEMETRY_MEMORY_SAMPLE_INTERVAL == 0)
         {
-            MessageBoxA(nullptr, "Something happened!", "Space Pressed", MB_OK);
+            g_TelemetryProcessMemory = TelemetryQueryProcessMemory();
         }
-        else if (InputKeyboardButtonCheck('Z'))
+
+        TelemetryStats stats =
         {
-            OutputDebugString(L"Z held\n");
+            .m_FrameIndex = summary->m_FrameIndex,
+            .m_PublishTimeUs = static_cast<u64>(ClockTicksToSeconds(ClockNow()) * 1'000'000.0),
+            .m_FrameTimeMs = summary->m_FrameTimeMs,
+            .m_FrameTimeMeanMs = summary->m_FrameTimeMeanMs,
+            .m_FrameTimeP50Ms = summary->m_FrameTimeP50Ms,
+            .m_FrameTimeP99Ms = summary->m_FrameTimeP99Ms,
+            .m_ObjectCount = static_cast<u64>(GraphicsObjectCount()),
+            .m_ProcessMemoryBytes = g_TelemetryProcessMemory,
+            .m_PipelineLatencyMeanMs = summary->m_PipelineLatencyMeanMs,
+            .m_PipelineLatencyP99Ms = summary->m_PipelineLatencyP99Ms,
+        };
+
+        static_assert(NUMSTATSSTAGES <= TELEMETRY_MAX_STAGES);
+        static_assert(NUMSTATSCOUNTERS <= TELEMETRY_MAX_COUNTERS);
+        for (u32 i = 0; i < NUMSTATSSTAGES; i++)
+        {
+            stats.m_StageTimeMeanMs[i] = summary->m_StageTimeMeanMs[i];
         }
-        else if (InputKeyboardButtonPressed(VK_LEFT))
+        for (u32 i = 0; i < NUMSTATSCOUNTERS; i++)
         {
-            OutputDebugString(L"Left pressed\n");
+            stats.m_Counters[i] = summary->m_Counters[i];
         }
-        else if (InputKeyboardButtonPressed(VK_RIGHT))
+
+        TelemetryPublish(g_Telemetry.m_Block, &stats);
+    }
+
+    enum class GameAction
+    {
+        QUIT,
+        TOGGLESTATS,
+        MESSAGEBOX,
+        SAVESCENE,
+        TOGGLECAPTURE,
+        REWIND,
+        TOGGLEREWINDRECORDING,
+        DEBUGMESSAGE, // NOTE(sbalse): First of the actions that only print their binding.
+        COUNT = DEBUGMESSAGE + 64
+    };
+
+    struct DebugBinding
+    {
+        u16 m_Button;
+        ActionTrigger m_Trigger;
+        u16 m_Chord;
+        const char* m_Message;
+    };
+
+    constexpr u16 NO_CHORD = 0;
+
+    constexpr DebugBinding g_DebugBindings[] =
+    {
+        { ActionKey(VK_ESCAPE), ActionTrigger::PRESSED, NO_CHORD, "Escape pressed\n" },
+        { ActionKey('W'), ActionTrigger::PRESSED, NO_CHORD, "W pressed\n" },
+        { ActionKey('W'), ActionTrigger::RELEASED, NO_CHORD, "W released\n" },
+        { ActionKey('Z'), ActionTrigger::HELD, NO_CHORD, "Z held\n" },
+        { ActionKey(VK_LEFT), ActionTrigger::PRESSED, NO_CHORD, "Left pressed\n" },
+        { ActionKey(VK_RIGHT), ActionTrigger::PRESSED, NO_CHORD, "Right pressed\n" },
+        { ActionKey(VK_UP), ActionTrigger::PRESSED, NO_CHORD, "Up pressed\n" },
+        { ActionKey(VK_DOWN), ActionTrigger::PRESSED, NO_CHORD, "Down pressed\n" },
+        { ActionKey('V'), ActionTrigger::HELD, ActionKey('C'), "C + V pressed\n" },
+        { ActionMouse(MouseButton::RBUTTON), ActionTrigger::PRESSED, NO_CHORD, "Mouse Right pressed\n" },
+        { ActionMouse(MouseButton::MBUTTON), ActionTrigger::PRESSED, NO_CHORD, "Mouse Middle pressed\n" },
+        { ActionMouse(MouseButton::LBUTTON), ActionTrigger::RELEASED, NO_CHORD, "Mouse Left released\n" },
+        { ActionMouse(MouseButton::RBUTTON), ActionTrigger::RELEASED, NO_CHORD, "Mouse Right released\n" },
+        { ActionMouse(MouseButton::MBUTTON), ActionTrigger::RELEASED, NO_CHORD, "Mouse Middle released\n" },
+        { ActionMouse(MouseButton::LBUTTON), ActionTrigger::HELD, NO_CHORD, "Mouse Left held\n" },
+    };
+    static_assert(
+        ArraySize(g_DebugBindings) <= static_cast<u32>(GameAction::COUNT) - static_cast<u32>(GameAction::DEBUGMESSAGE));
+
+    constinit ActionMap* g_Actions = nullptr;
+
+    bool InitActions()
+    {
+        g_Actions = ActionMapCreate();
+
+        const auto bind = [](const GameAction action, const u16 button)
+        {
+            return ActionMapBind(g_Actions, static_cast<u32>(action), button, ActionTrigger::PRESSED);
+        };
+
+        bool result = bind(GameAction::QUIT, ActionKey(VK_ESCAPE));
+        result = bind(GameAction::TOGGLESTATS, ActionKey(VK_F1)) && result;
+        result = bind(GameAction::MESSAGEBOX, ActionKey(VK_SPACE)) && result;
+        result = bind(GameAction::SAVESCENE, ActionKey(VK_F5)) && result;
+        result = bind(GameAction::TOGGLECAPTURE, ActionKey(VK_F9)) && result;
+        result = bind(GameAction::REWIND, ActionKey(VK_F6)) && result;
+        result = bind(GameAction::TOGGLEREWINDRECORDING, ActionKey(VK_F7)) && result;
+
+        for (u32 i = 0; i < ArraySize(g_DebugBindings); i++)
         {
-            OutputDebugString(L"Right pressed\n");
+            const DebugBinding* binding = &g_DebugBindings[i];
+            const u32 action = static_cast<u32>(GameAction::DEBUGMESSAGE) + i;
+            const u32 chordCount = binding->m_Chord != NO_CHORD ? 1 : 0;
+            result = ActionMapBind(
+                g_Actions,
+                action,
+                binding->m_Button,
+                binding->m_Trigger,
+                &binding->m_Chord,
+                chordCount) && result;
         }
-        else if (InputKeyboardButtonPressed(VK_UP))
+
+        ActionMapCompile(g_Actions);
+        return result;
+    }
+
+    // NOTE(sbalse): Every action is its own behaviour that sleeps until its action fires.
+    CoroutineTask DebugMessageBehaviour(const u32 binding)
+    {
+        for (;;)
         {
-            OutputDebugString(L"Up pressed\n");
+            co_await CoroutineAction(static_cast<u32>(GameAction::DEBUGMESSAGE) + binding);
+            OutputDebugStringA(g_DebugBindings[binding].m_Message);
         }
-        else if (InputKeyboardButtonPressed(VK_DOWN))
+    }
+
+    CoroutineTask ToggleStatsBehaviour()
+    {
+        for (;;)
         {
-            OutputDebugString(L"Down pressed\n");
+            co_await CoroutineAction(static_cast<u32>(GameAction::TOGGLESTATS));
+            GraphicsToggleStatsOverlay();
         }
-        else if (InputKeyboardButtonCheck('V') && InputKeyboardButtonCheck('C'))
+    }
+
+    CoroutineTask MessageBoxBehaviour()
+    {
+        for (;;)
         {
-            OutputDebugStringA("C + V pressed\n");
+            co_await CoroutineAction(static_cast<u32>(GameAction::MESSAGEBOX));
+            MessageBoxA(nullptr, "Something happened!", "Space Pressed", MB_OK);
         }
-        else if (InputMouseButtonPressed(MouseButton::RBUTTON))
+    }
+
+    CoroutineTask SaveSceneBehaviour()
+    {
+        for (;;)
         {
-            OutputDebugString(L"Mouse Right pressed\n");
+            co_await CoroutineAction(static_cast<u32>(GameAction::SAVESCENE));
+            PipelineRequestSceneSave(g_ScenePath);
+            while (PipelineGetSceneSave() == PipelineSceneSave::PENDING)
+            {
+                co_await CoroutineNextFrame();
+            }
+
+            if (PipelineGetSceneSave() == PipelineSceneSave::FAILED)
+            {
+                OutputDebugStringA("Failed to save the scene, the previous snapshot is kept\n");
+            }
         }
-        else if (InputMouseButtonPressed(MouseButton::MBUTTON))
+    }
+
+    CoroutineTask ToggleCaptureBehaviour()
+    {
+        for (;;)
         {
-            OutputDebugString(L"Mouse Middle pressed\n");
+            co_await CoroutineAction(static_cast<u32>(GameAction::TOGGLECAPTURE));
+            GraphicsToggleCapture(g_CapturePath);
         }
-        else if (InputMouseButtonReleased(MouseButton::LBUTTON))
+    }
+
+    CoroutineTask RewindBehaviour()
+    {
+        for (;;)
         {
-            OutputDebugString(L"Mouse Left released\n");
+            co_await CoroutineAction(static_cast<u32>(GameAction::REWIND));
+            PipelineRequestRewind(g_RewindSteps);
         }
-        else if (InputMouseButtonReleased(MouseButton::RBUTTON))
+    }
+
+    CoroutineTask ToggleRewindRecordingBehaviour()
+    {
+        for (;;)
         {
-            OutputDebugString(L"Mouse Right released\n");
+            co_await CoroutineAction(static_cast<u32>(GameAction::TOGGLEREWINDRECORDING));
+            const bool recording = PipelineToggleRewindRecording();
+            OutputDebugStringA(recording ? "Recording the simulation for rewind\n" : "Stopped recording for rewind\n");
         }
-        else if (InputMouseButtonReleased(MouseButton::MBUTTON))
+    }
+
+    CoroutineTask QuitBehaviour()
+    {
+        co_await CoroutineAction(static_cast<u32>(GameAction::QUIT));
+        PostQuitMessage(0); // NOTE(sbalse): Quit game on escape pressed.
+    }
+
+    bool SpawnBehaviours()
+    {
+        bool result = CoroutinesSpawn(ToggleStatsBehaviour());
+        result = CoroutinesSpawn(MessageBoxBehaviour()) && result;
+        result = CoroutinesSpawn(SaveSceneBehaviour()) && result;
+        result = CoroutinesSpawn(ToggleCaptureBehaviour()) && result;
+        result = CoroutinesSpawn(RewindBehaviour()) && result;
+        result = CoroutinesSpawn(ToggleRewindRecordingBehaviour()) && result;
+        result = CoroutinesSpawn(QuitBehaviour()) && result;
+        for (u32 i = 0; i < ArraySize(g_DebugBindings); i++)
         {
-            OutputDebugString(L"Mouse Middle released\n");
+            result = CoroutinesSpawn(DebugMessageBehaviour(i)) && result;
         }
-        else if (InputMouseButtonCheck(MouseButton::LBUTTON))
+        return result;
+    }
+
+    bool InitSimulationTask(void* /*context*/)
+    {
+        return SimulationInit(static_cast<u32>(GraphicsObjectCount()), g_ScenePath);
+    }
+
+    bool InitPipelineTask(void* /*context*/)
+    {
+        return PipelineInit(g_PipelinedSimulation, g_SimulationStepsPerSecond, g_MaxSimulationStepsPerFrame);
+    }
+
+    bool InitActionsTask(void* /*context*/)
+    {
+        return InitActions();
+    }
+
+    bool InitTelemetryTask(void* /*context*/)
+    {
+        InitTelemetry();
+        return true;
+    }
+
+    // NOTE(sbalse): Startup as a graph of tasks, so the simulation and everything else that doesn't need the
+    // device is set up while the window and device are being created.
+    bool RunInitTasks()
+    {
+        TaskGraph* graph = TaskGraphCreate();
+        DEFER(TaskGraphDestroy(graph));
+
+        const u32 graphics = GraphicsAddInitTasks(graph);
+        const u32 simulation = TaskGraphAdd(
+            graph, "Simulation", InitSimulationTask, nullptr, TaskAffinity::ANY, nullptr, 0);
+        const u32 pipeline = TaskGraphAdd(
+            graph, "Pipeline", InitPipelineTask, nullptr, TaskAffinity::ANY, &simulation, 1);
+        const u32 actions = TaskGraphAdd(
+            graph, "Actions", InitActionsTask, nullptr, TaskAffinity::ANY, nullptr, 0);
+        const u32 telemetry = TaskGraphAdd(
+            graph, "Telemetry", InitTelemetryTask, nullptr, TaskAffinity::ANY, nullptr, 0);
+        if (graphics == TASKGRAPH_INVALID_TASK
+            || simulation == TASKGRAPH_INVALID_TASK
+            || pipeline == TASKGRAPH_INVALID_TASK
+            || actions == TASKGRAPH_INVALID_TASK
+            || telemetry == TASKGRAPH_INVALID_TASK)
         {
-            OutputDebugString(L"Mouse Left held\n");
+            return false;
         }
+
+        const bool succeeded = TaskGraphRun(graph);
+
+        TaskGraphReport(graph, g_StartupReport, sizeof(g_StartupReport));
+        OutputDebugStringA(g_StartupReport);
+
+        return succeeded;
+    }
+
+    // NOTE(sbalse): Time to first frame is from ControlInit() to the end of the first present.
+    void ReportTimeToFirstFrame()
+    {
+        char message[128] = {};
+        std::snprintf(
+            message, sizeof(message),
+            "Time to first frame: %.2f ms\n",
+            ClockTicksToMilliseconds(ClockNow() - g_StartupTime));
+        OutputDebugStringA(message);
     }
 
     void GameLogic()
     {
-        InputTest();
+        InputFrameState input = {};
+        InputGetFrameState(&input);
+
+        ActionSet actions = {};
+        ActionMapEvaluate(g_Actions, &input, &actions);
+
+        CoroutinesUpdate(&actions);
     }
 
     void RunFrame()
     {
+        g_FrameStart = ClockNow();
+        StatsBeginFrame();
+
         // NOTE(sbalse): Windows messages should be processed before running the game logic.
+        StatsBeginStage(StatsStage::MESSAGES);
         GraphicsProcessWindowsMessages();
+        StatsEndStage(StatsStage::MESSAGES);
 
+        StatsBeginStage(StatsStage::GAMELOGIC);
         GameLogic();
+        StatsEndStage(StatsStage::GAMELOGIC);
 
-        GraphicsRunFrame();
+        // NOTE(sbalse): With the threaded pipeline the simulation of the next frame is already running
+        // while we submit this one.
+        const SceneSnapshot* snapshot = PipelineAcquireSnapshot();
+        GraphicsRunFrame(snapshot);
+        PipelineReleaseSnapshot(snapshot);
     }
 
     bool EndFrame()
     {
         InputEndFrame();
         const bool isRunning = GraphicsEndFrame();
+        if (StatsGetSummary()->m_FrameIndex == 0)
+        {
+            ReportTimeToFirstFrame();
+        }
+        PublishTelemetry();
+
+        // NOTE(sbalse): After present, so the deferred work can't delay this frame, only use what is left of it.
+        StatsBeginStage(StatsStage::DEFERRED);
+        DeferredRun(g_FrameStart + g_FrameBudgetTicks);
+        StatsEndStage(StatsStage::DEFERRED);
+
+        const bool focused = GraphicsWindowHasFocus();
+        PacerSetFocused(focused);
+        if (!focused && g_PauseWhenUnfocused && isRunning)
+        {
+            GraphicsWaitForWindowMessages();
+        }
+        else
+        {
+            PacerWaitForNextFrame();
+        }
+
         return isRunning;
     }
 
@@ -107,12 +434,36 @@ namespace
 
 bool ControlInit()
 {
-    if (!GraphicsInit())
+    ClockInit();
+    StatsInit();
+    g_StartupTime = ClockNow();
+
+    // NOTE(sbalse): One worker per spare hardware thread, the main thread helps out while it waits.
+    if (!JobsInit(0))
+    {
+        // TODO(sbalse): Logging
+        return false;
+    }
+
+    if (!RunInitTasks())
     {
         // TODO(sbalse): Logging
         return false;
     }
 
+    if (!CoroutinesInit() || !SpawnBehaviours())
+    {
+        // TODO(sbalse): Logging
+        return false;
+    }
+
+    PacerInit(g_TargetFrameRate, g_BackgroundFrameRate);
+    GraphicsSetVSync(g_TargetFrameRate <= 0.0);
+    const double frameRate = g_TargetFrameRate > 0.0 ? g_TargetFrameRate : 60.0;
+    const double frameBudgetSeconds = g_FrameBudgetFraction / frameRate;
+    g_FrameBudgetTicks = ClockSecondsToTicks(frameBudgetSeconds);
+    GraphicsSetFrameBudget(static_cast<float>(frameBudgetSeconds * 1000.0));
+
     return true;
 }
 
@@ -123,5 +474,12 @@ bool ControlRun()
 
 void ControlShutdown()
 {
+    TelemetryClose(&g_Telemetry);
+    CoroutinesShutdown();
+    ActionMapDestroy(g_Actions);
+    PacerShutdown();
+    PipelineShutdown();
+    SimulationDestroy();
+    JobsShutdown();
     GraphicsDestroy();
 }
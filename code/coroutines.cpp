@@ -0,0 +1,466 @@
+#include "coroutines.h"
+
+#include <bit>
+#include <cstdlib>
+#include <exception>
+
+#include "clock.h"
+
+namespace
+{
+    constexpr u32 COROUTINES_SMALL_FRAME_COUNT = COROUTINES_MAX_TASKS - COROUTINES_LARGE_FRAME_COUNT;
+
+    struct CoroutineFreeFrame
+    {
+        CoroutineFreeFrame* m_Next;
+    };
+
+    // NOTE(sbalse): First in, first out, so tasks waiting on the same thing resume in the order they started waiting.
+    struct CoroutineList
+    {
+        CoroutinePromise* m_Head;
+        CoroutinePromise* m_Tail;
+    };
+
+    struct CoroutineTimer
+    {
+        i64 m_WakeTime; // NOTE(sbalse): Clock ticks.
+        u64 m_Sequence; // NOTE(sbalse): Orders timers with the same wake time by when they were set.
+        CoroutinePromise* m_Promise;
+    };
+
+    struct CoroutineScheduler
+    {
+        u8* m_FrameMemory;
+        CoroutineFreeFrame* m_FreeSmallFrames;
+        CoroutineFreeFrame* m_FreeLargeFrames;
+
+        CoroutineList m_NextFrame;
+        CoroutineList m_Jobs;
+        CoroutineList m_Actions[ACTIONMAP_MAX_ACTIONS];
+        u64 m_WaitedActions[ACTIONMAP_ACTION_WORDS]; // NOTE(sbalse): Actions with at least one task waiting.
+
+        // NOTE(sbalse): Binary min heap by wake time. Every task waits on one thing at a time, so it never fills up.
+        CoroutineTimer m_Timers[COROUTINES_MAX_TASKS];
+        u32 m_TimerCount;
+        u64 m_TimerSequence;
+
+        i64 m_Now; // NOTE(sbalse): Clock ticks at the start of the current update.
+        CoroutineStats m_Stats;
+    };
+
+    CoroutineScheduler* g_Coroutines = nullptr;
+
+    void CoroutineListPush(CoroutineList* list, CoroutinePromise* promise)
+    {
+        promise->m_Next = nullptr;
+        if (list->m_Tail)
+        {
+            list->m_Tail->m_Next = promise;
+        }
+        else
+        {
+            list->m_Head = promise;
+        }
+        list->m_Tail = promise;
+    }
+
+    // NOTE(sbalse): Moves all of source to the end of destination.
+    void CoroutineListAppend(CoroutineList* destination, CoroutineList* source)
+    {
+        if (!source->m_Head)
+        {
+            return;
+        }
+
+        if (destination->m_Tail)
+        {
+            destination->m_Tail->m_Next = source->m_Head;
+        }
+        else
+        {
+            destination->m_Head = source->m_Head;
+        }
+        destination->m_Tail = source->m_Tail;
+        *source = {};
+    }
+
+    bool CoroutineTimerBefore(const CoroutineTimer* a, const CoroutineTimer* b)
+    {
+        return a->m_WakeTime < b->m_WakeTime || (a->m_WakeTime == b->m_WakeTime && a->m_Sequence < b->m_Sequence);
+    }
+
+    void CoroutineTimerPush(CoroutineScheduler* scheduler, const i64 wakeTime, CoroutinePromise* promise)
+    {
+        CoroutineTimer* timers = scheduler->m_Timers;
+        u32 index = scheduler->m_TimerCount++;
+        const CoroutineTimer timer =
+        {
+            .m_WakeTime = wakeTime,
+            .m_Sequence = scheduler->m_TimerSequence++,
+            .m_Promise = promise,
+        };
+
+        while (index > 0)
+        {
+            const u32 parent = (index - 1) / 2;
+            if (!CoroutineTimerBefore(&timer, &timers[parent]))
+            {
+                break;
+            }
+            timers[index] = timers[parent];
+            index = parent;
+        }
+        timers[index] = timer;
+    }
+
+    CoroutinePromise* CoroutineTimerPop(CoroutineScheduler* scheduler)
+    {
+        CoroutineTimer* timers = scheduler->m_Timers;
+        CoroutinePromise* promise = timers[0].m_Promise;
+        const CoroutineTimer last = timers[--scheduler->m_TimerCount];
+        const u32 count = scheduler->m_TimerCount;
+
+        u32 index = 0;
+        for (;;)
+        {
+            u32 child = (index * 2) + 1;
+            if (child >= count)
+            {
+                break;
+            }
+            if (child + 1 < count && CoroutineTimerBefore(&timers[child + 1], &timers[child]))
+            {
+                child++;
+            }
+            if (!CoroutineTimerBefore(&timers[child], &last))
+            {
+                break;
+            }
+            timers[index] = timers[child];
+            index = child;
+        }
+        if (count > 0)
+        {
+            timers[index] = last;
+        }
+        return promise;
+    }
+
+    std::coroutine_handle<CoroutinePromise> CoroutineHandle(CoroutinePromise* promise)
+    {
+        return std::coroutine_handle<CoroutinePromise>::from_promise(*promise);
+    }
+
+    // NOTE(sbalse): Runs the task up to its next wait, where it puts itself into a wait list, or to its end.
+    void CoroutineResume(CoroutineScheduler* scheduler, CoroutinePromise* promise)
+    {
+        const std::coroutine_handle<CoroutinePromise> handle = CoroutineHandle(promise);
+        handle.resume();
+        scheduler->m_Stats.m_Resumed++;
+        if (handle.done())
+        {
+            handle.destroy();
+            scheduler->m_Stats.m_Live--;
+        }
+    }
+
+    // NOTE(sbalse): The list is detached before any task in it runs, tasks resumed here that wait again go into
+    // the lists of the next update.
+    void CoroutineResumeList(CoroutineScheduler* scheduler, CoroutineList list)
+    {
+        CoroutinePromise* promise = list.m_Head;
+        while (promise)
+        {
+            CoroutinePromise* next = promise->m_Next;
+            CoroutineResume(scheduler, promise);
+            promise = next;
+        }
+    }
+
+    void CoroutineDestroyList(CoroutineList* list)
+    {
+        CoroutinePromise* promise = list->m_Head;
+        while (promise)
+        {
+            CoroutinePromise* next = promise->m_Next;
+            CoroutineHandle(promise).destroy();
+            promise = next;
+        }
+        *list = {};
+    }
+}
+
+CoroutineTask CoroutinePromise::get_return_object()
+{
+    return { .m_Handle = std::coroutine_handle<CoroutinePromise>::from_promise(*this) };
+}
+
+CoroutineTask CoroutinePromise::get_return_object_on_allocation_failure()
+{
+    return {};
+}
+
+std::suspend_always CoroutinePromise::initial_suspend() noexcept
+{
+    return {};
+}
+
+// NOTE(sbalse): Stays suspended at the end, so the scheduler sees the task is done and destroys it.
+std::suspend_always CoroutinePromise::final_suspend() noexcept
+{
+    return {};
+}
+
+void CoroutinePromise::return_void()
+{
+}
+
+void CoroutinePromise::unhandled_exception()
+{
+    std::terminate();
+}
+
+void* CoroutinePromise::operator new(const size_t size) noexcept
+{
+    CoroutineScheduler* scheduler = g_Coroutines;
+    if (!scheduler)
+    {
+        return nullptr;
+    }
+
+    CoroutineFreeFrame** freeFrames = nullptr;
+    if (size <= COROUTINES_SMALL_FRAME_SIZE)
+    {
+        freeFrames = scheduler->m_FreeSmallFrames
+            ? &scheduler->m_FreeSmallFrames
+            : &scheduler->m_FreeLargeFrames;
+    }
+    else if (size <= COROUTINES_LARGE_FRAME_SIZE)
+    {
+        freeFrames = &scheduler->m_FreeLargeFrames;
+    }
+
+    if (!freeFrames || !*freeFrames)
+    {
+        return nullptr;
+    }
+
+    CoroutineFreeFrame* frame = *freeFrames;
+    *freeFrames = frame->m_Next;
+    if (freeFrames == &scheduler->m_FreeSmallFrames)
+    {
+        scheduler->m_Stats.m_FreeSmallFrames--;
+    }
+    else
+    {
+        scheduler->m_Stats.m_FreeLargeFrames--;
+    }
+    return frame;
+}
+
+// NOTE(sbalse): The small frames come first in the pool memory, so the address tells which class a frame is from.
+void CoroutinePromise::operator delete(void* frame, const size_t /*size*/) noexcept
+{
+    CoroutineScheduler* scheduler = g_Coroutines;
+    CoroutineFreeFrame* freeFrame = static_cast<CoroutineFreeFrame*>(frame);
+    const u8* largeFrames = scheduler->m_FrameMemory
+        + (static_cast<size_t>(COROUTINES_SMALL_FRAME_COUNT) * COROUTINES_SMALL_FRAME_SIZE);
+    if (static_cast<const u8*>(frame) < largeFrames)
+    {
+        freeFrame->m_Next = scheduler->m_FreeSmallFrames;
+        scheduler->m_FreeSmallFrames = freeFrame;
+        scheduler->m_Stats.m_FreeSmallFrames++;
+    }
+    else
+    {
+        freeFrame->m_Next = scheduler->m_FreeLargeFrames;
+        scheduler->m_FreeLargeFrames = freeFrame;
+        scheduler->m_Stats.m_FreeLargeFrames++;
+    }
+}
+
+bool CoroutineNextFrameAwaiter::await_ready() const
+{
+    return false;
+}
+
+void CoroutineNextFrameAwaiter::await_suspend(const std::coroutine_handle<CoroutinePromise> handle) const
+{
+    CoroutineListPush(&g_Coroutines->m_NextFrame, &handle.promise());
+}
+
+void CoroutineNextFrameAwaiter::await_resume() const
+{
+}
+
+bool CoroutineSecondsAwaiter::await_ready() const
+{
+    return m_Seconds <= 0.0;
+}
+
+// NOTE(sbalse): Counted from the start of the current update, so tasks that sleep the same time in the same
+// update wake up together.
+void CoroutineSecondsAwaiter::await_suspend(const std::coroutine_handle<CoroutinePromise> handle) const
+{
+    CoroutineScheduler* scheduler = g_Coroutines;
+    CoroutineTimerPush(scheduler, scheduler->m_Now + ClockSecondsToTicks(m_Seconds), &handle.promise());
+}
+
+void CoroutineSecondsAwaiter::await_resume() const
+{
+}
+
+bool CoroutineActionAwaiter::await_ready() const
+{
+    return false;
+}
+
+void CoroutineActionAwaiter::await_suspend(const std::coroutine_handle<CoroutinePromise> handle) const
+{
+    CoroutineScheduler* scheduler = g_Coroutines;
+    CoroutineListPush(&scheduler->m_Actions[m_Action], &handle.promise());
+    scheduler->m_WaitedActions[m_Action / 64] |= 1ull << (m_Action % 64);
+}
+
+void CoroutineActionAwaiter::await_resume() const
+{
+}
+
+bool CoroutineJobAwaiter::await_ready() const
+{
+    return JobsIsDone(m_Job);
+}
+
+void CoroutineJobAwaiter::await_suspend(const std::coroutine_handle<CoroutinePromise> handle) const
+{
+    CoroutinePromise* promise = &handle.promise();
+    promise->m_Job = m_Job;
+    CoroutineListPush(&g_Coroutines->m_Jobs, promise);
+}
+
+void CoroutineJobAwaiter::await_resume() const
+{
+}
+
+bool CoroutinesInit()
+{
+    CoroutineScheduler* scheduler = static_cast<CoroutineScheduler*>(std::calloc(1, sizeof(CoroutineScheduler)));
+    if (!scheduler)
+    {
+        return false;
+    }
+
+    const size_t smallBytes = static_cast<size_t>(COROUTINES_SMALL_FRAME_COUNT) * COROUTINES_SMALL_FRAME_SIZE;
+    const size_t largeBytes = static_cast<size_t>(COROUTINES_LARGE_FRAME_COUNT) * COROUTINES_LARGE_FRAME_SIZE;
+    scheduler->m_FrameMemory = static_cast<u8*>(std::calloc(smallBytes + largeBytes, 1));
+    if (!scheduler->m_FrameMemory)
+    {
+        std::free(scheduler);
+        return false;
+    }
+
+    // NOTE(sbalse): Linked back to front, so frames are handed out in address order.
+    for (u32 i = COROUTINES_SMALL_FRAME_COUNT; i > 0; i--)
+    {
+        CoroutineFreeFrame* frame = reinterpret_cast<CoroutineFreeFrame*>(
+            scheduler->m_FrameMemory + (static_cast<size_t>(i - 1) * COROUTINES_SMALL_FRAME_SIZE));
+        frame->m_Next = scheduler->m_FreeSmallFrames;
+        scheduler->m_FreeSmallFrames = frame;
+    }
+    for (u32 i = COROUTINES_LARGE_FRAME_COUNT; i > 0; i--)
+    {
+        CoroutineFreeFrame* frame = reinterpret_cast<CoroutineFreeFrame*>(
+            scheduler->m_FrameMemory + smallBytes + (static_cast<size_t>(i - 1) * COROUTINES_LARGE_FRAME_SIZE));
+        frame->m_Next = scheduler->m_FreeLargeFrames;
+        scheduler->m_FreeLargeFrames = frame;
+    }
+
+    scheduler->m_Now = ClockNow();
+    scheduler->m_Stats.m_FreeSmallFrames = COROUTINES_SMALL_FRAME_COUNT;
+    scheduler->m_Stats.m_FreeLargeFrames = COROUTINES_LARGE_FRAME_COUNT;
+    g_Coroutines = scheduler;
+    return true;
+}
+
+void CoroutinesShutdown()
+{
+    CoroutineScheduler* scheduler = g_Coroutines;
+    if (!scheduler)
+    {
+        return;
+    }
+
+    CoroutineDestroyList(&scheduler->m_NextFrame);
+    CoroutineDestroyList(&scheduler->m_Jobs);
+    for (CoroutineList& list : scheduler->m_Actions)
+    {
+        CoroutineDestroyList(&list);
+    }
+    for (u32 i = 0; i < scheduler->m_TimerCount; i++)
+    {
+        CoroutineHandle(scheduler->m_Timers[i].m_Promise).destroy();
+    }
+
+    std::free(scheduler->m_FrameMemory);
+    std::free(scheduler);
+    g_Coroutines = nullptr;
+}
+
+bool CoroutinesSpawn(const CoroutineTask task)
+{
+    if (!task.m_Handle)
+    {
+        return false;
+    }
+
+    g_Coroutines->m_Stats.m_Live++;
+    CoroutineResume(g_Coroutines, &task.m_Handle.promise());
+    return true;
+}
+
+void CoroutinesUpdate(const ActionSet* actions)
+{
+    CoroutineScheduler* scheduler = g_Coroutines;
+    scheduler->m_Now = ClockNow();
+    scheduler->m_Stats.m_Resumed = 0;
+
+    // NOTE(sbalse): Everything that is ready is collected before anything runs, so a task can't wake up twice in
+    // one update by waiting again on something that is already over.
+    CoroutineList ready = {};
+    while (scheduler->m_TimerCount > 0 && scheduler->m_Timers[0].m_WakeTime <= scheduler->m_Now)
+    {
+        CoroutineListPush(&ready, CoroutineTimerPop(scheduler));
+    }
+
+    for (u32 word = 0; word < ACTIONMAP_ACTION_WORDS; word++)
+    {
+        u64 fired = actions->m_Words[word] & scheduler->m_WaitedActions[word];
+        scheduler->m_WaitedActions[word] &= ~fired;
+        while (fired)
+        {
+            const u32 action = (word * 64) + static_cast<u32>(std::countr_zero(fired));
+            fired &= fired - 1;
+            CoroutineListAppend(&ready, &scheduler->m_Actions[action]);
+        }
+    }
+
+    // NOTE(sbalse): Only tasks waiting on a job are looked at every update, until their job is done.
+    CoroutineList jobs = scheduler->m_Jobs;
+    scheduler->m_Jobs = {};
+    CoroutinePromise* promise = jobs.m_Head;
+    while (promise)
+    {
+        CoroutinePromise* next = promise->m_Next;
+        CoroutineListPush(JobsIsDone(promise->m_Job) ? &ready : &scheduler->m_Jobs, promise);
+        promise = next;
+    }
+
+    CoroutineListAppend(&ready, &scheduler->m_NextFrame);
+    CoroutineResumeList(scheduler, ready);
+}
+
+const CoroutineStats* CoroutinesGetStats()
+{
+    return &g_Coroutines->m_Stats;
+}
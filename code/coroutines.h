@@ -0,0 +1,137 @@
+#pragma once
+#include <coroutine>
+#include <cstddef>
+
+#include "types.h"
+#include "actionmap.h"
+#include "jobs.h"
+
+/*
+* NOTE(sbalse): Game logic written as C++20 coroutines. A behaviour that spans frames is a function returning
+* CoroutineTask that co_awaits what it is waiting for, instead of a state machine polled every frame:
+*
+*     CoroutineTask Blink()
+*     {
+*         for (;;)
+*         {
+*             co_await CoroutineAction(FIRE);
+*             ...
+*             co_await CoroutineSeconds(0.5);
+*         }
+*     }
+*
+* Spawned tasks belong to a scheduler that is updated once per frame on the main thread. Waiting tasks sit in a
+* list per kind of wait, sleeping ones in a heap ordered by wake time, and an update only touches the tasks
+* whose wait is over. Thousands of sleeping tasks cost nothing until they wake up. Coroutine frames come out of
+* a fixed pool instead of the heap; when it runs out, spawning fails.
+*
+* Everything here is main thread only.
+*/
+
+constexpr u32 COROUTINES_MAX_TASKS = 4096;
+// NOTE(sbalse): Frame pool size classes. Frames bigger than the large class can't be created at all.
+constexpr u32 COROUTINES_SMALL_FRAME_SIZE = 256;
+constexpr u32 COROUTINES_LARGE_FRAME_SIZE = 2048;
+constexpr u32 COROUTINES_LARGE_FRAME_COUNT = 256;
+
+struct CoroutinePromise;
+
+struct CoroutineTask
+{
+    using promise_type = CoroutinePromise;
+
+    std::coroutine_handle<CoroutinePromise> m_Handle; // NOTE(sbalse): Empty when the frame pool ran out.
+};
+
+struct CoroutinePromise
+{
+    CoroutinePromise* m_Next; // NOTE(sbalse): Next task in the list the task waits in.
+    JobHandle m_Job; // NOTE(sbalse): Job the task waits for, when waiting for one.
+
+    CoroutineTask get_return_object();
+    static CoroutineTask get_return_object_on_allocation_failure();
+    std::suspend_always initial_suspend() noexcept;
+    std::suspend_always final_suspend() noexcept;
+    void return_void();
+    void unhandled_exception();
+
+    static void* operator new(const size_t size) noexcept;
+    static void operator delete(void* frame, const size_t size) noexcept;
+};
+
+// NOTE(sbalse): Awaitables. Only valid inside tasks owned by the scheduler.
+struct CoroutineNextFrameAwaiter
+{
+    bool await_ready() const;
+    void await_suspend(const std::coroutine_handle<CoroutinePromise> handle) const;
+    void await_resume() const;
+};
+
+struct CoroutineSecondsAwaiter
+{
+    double m_Seconds;
+
+    bool await_ready() const;
+    void await_suspend(const std::coroutine_handle<CoroutinePromise> handle) const;
+    void await_resume() const;
+};
+
+struct CoroutineActionAwaiter
+{
+    u32 m_Action;
+
+    bool await_ready() const;
+    void await_suspend(const std::coroutine_handle<CoroutinePromise> handle) const;
+    void await_resume() const;
+};
+
+struct CoroutineJobAwaiter
+{
+    JobHandle m_Job;
+
+    bool await_ready() const;
+    void await_suspend(const std::coroutine_handle<CoroutinePromise> handle) const;
+    void await_resume() const;
+};
+
+// NOTE(sbalse): Resumes in the next update.
+inline CoroutineNextFrameAwaiter CoroutineNextFrame()
+{
+    return {};
+}
+
+// NOTE(sbalse): Resumes in the first update at least seconds from now. Doesn't suspend for 0 or less.
+inline CoroutineSecondsAwaiter CoroutineSeconds(const double seconds)
+{
+    return { .m_Seconds = seconds };
+}
+
+// NOTE(sbalse): Resumes in the next update whose action set has action in it. That is never the current update.
+inline CoroutineActionAwaiter CoroutineAction(const u32 action)
+{
+    return { .m_Action = action };
+}
+
+// NOTE(sbalse): Resumes in the first update after the job is done. Doesn't suspend if it already is.
+inline CoroutineJobAwaiter CoroutineJobDone(const JobHandle job)
+{
+    return { .m_Job = job };
+}
+
+struct CoroutineStats
+{
+    u32 m_Live;
+    u32 m_Resumed; // NOTE(sbalse): Tasks resumed by the last update.
+    u32 m_FreeSmallFrames;
+    u32 m_FreeLargeFrames;
+};
+
+bool CoroutinesInit();
+// NOTE(sbalse): Destroys every task that hasn't finished yet.
+void CoroutinesShutdown();
+// NOTE(sbalse): Takes ownership of task and runs it up to its first wait. Returns false when the task couldn't
+// be created.
+bool CoroutinesSpawn(const CoroutineTask task);
+// NOTE(sbalse): Resumes the tasks whose wait is over. actions are the actions that fired this frame.
+void CoroutinesUpdate(const ActionSet* actions);
+const CoroutineStats* CoroutinesGetStats();
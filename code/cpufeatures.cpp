@@ -0,0 +1,35 @@
+#include "cpufeatures.h"
+
+#if _MSC_VER
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    bool CpuDetectAvx2()
+    {
+#if _MSC_VER
+        int info[4] = {};
+        __cpuid(info, 0);
+        if (info[0] < 7)
+        {
+            return false;
+        }
+
+        // NOTE(sbalse): The OS also has to save the upper halves of the registers on a context switch.
+        __cpuid(info, 1);
+        const bool osSavesAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 0x6) == 0x6;
+        __cpuidex(info, 7, 0);
+        return osSavesAvx && (info[1] & (1 << 5));
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+}
+
+bool CpuHasAvx2()
+{
+    static const bool s_HasAvx2 = CpuDetectAvx2();
+    return s_HasAvx2;
+}
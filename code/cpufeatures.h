@@ -0,0 +1,16 @@
+#pragma once
+
+/*
+* NOTE(sbalse): Instruction sets beyond the SSE2 baseline, checked at runtime. Code using them lives in functions
+* marked with the matching macro and is only called when the check passes.
+*/
+
+// NOTE(sbalse): MSVC compiles AVX2 intrinsics anywhere, GCC and Clang only in functions built for it.
+#if _MSC_VER
+#define CPU_AVX2
+#else
+#define CPU_AVX2 __attribute__((target("avx2")))
+#endif
+
+// NOTE(sbalse): Checked once, the result is cached.
+bool CpuHasAvx2();
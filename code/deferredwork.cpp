@@ -0,0 +1,189 @@
+#include "deferredwork.h"
+
+#include "clock.h"
+
+namespace
+{
+    // NOTE(sbalse): Guess for the first chunk of an item, before it has been measured.
+    constexpr double DEFERRED_FIRST_CHUNK_SECONDS = 0.0001;
+    // NOTE(sbalse): How fast the longest recent chunk is forgotten, per chunk run and per frame without running.
+    constexpr double DEFERRED_ESTIMATE_DECAY = 0.95;
+
+    struct DeferredItem
+    {
+        const char* m_Name;
+        DeferredFunction m_Function;
+        void* m_Context;
+        DeferredPriority m_Priority;
+        bool m_Active;
+        bool m_Idle; // NOTE(sbalse): Returned IDLE this frame.
+        i64 m_ChunkEstimate; // NOTE(sbalse): Clock ticks, a decaying maximum of the recent chunks.
+        u64 m_LastRunFrame;
+        u64 m_LastRunSequence; // NOTE(sbalse): Orders items that last ran in the same frame.
+    };
+
+    struct DeferredScheduler
+    {
+        DeferredItem m_Items[DEFERRED_MAX_ITEMS];
+        u64 m_Frame;
+        u64 m_Sequence;
+        DeferredStats m_Stats;
+    };
+
+    constinit DeferredScheduler g_Deferred = {};
+
+    u64 DeferredWaitFrames(const DeferredItem* item)
+    {
+        return g_Deferred.m_Frame - item->m_LastRunFrame;
+    }
+
+    i64 DeferredDecay(const i64 estimate)
+    {
+        return static_cast<i64>(static_cast<double>(estimate) * DEFERRED_ESTIMATE_DECAY);
+    }
+
+    // NOTE(sbalse): Starved items first, then by priority, then the one that ran least recently.
+    bool DeferredGoesBefore(const DeferredItem* a, const DeferredItem* b)
+    {
+        const bool aStarved = DeferredWaitFrames(a) >= DEFERRED_STARVATION_FRAMES;
+        const bool bStarved = DeferredWaitFrames(b) >= DEFERRED_STARVATION_FRAMES;
+        if (aStarved != bStarved)
+        {
+            return aStarved;
+        }
+        if (a->m_Priority != b->m_Priority)
+        {
+            return a->m_Priority < b->m_Priority;
+        }
+        return a->m_LastRunSequence < b->m_LastRunSequence;
+    }
+
+    DeferredItem* DeferredPickItem(const i64 now, const i64 deadline)
+    {
+        DeferredItem* best = nullptr;
+        for (DeferredItem& item : g_Deferred.m_Items)
+        {
+            if (!item.m_Active || item.m_Idle || now + item.m_ChunkEstimate > deadline)
+            {
+                continue;
+            }
+            if (!best || DeferredGoesBefore(&item, best))
+            {
+                best = &item;
+            }
+        }
+        return best;
+    }
+
+    // NOTE(sbalse): An item whose chunks stopped fitting would never run again, so the estimate of every item that
+    // didn't run decays until it fits into the time frames usually have left.
+    void DeferredUpdateStarvation()
+    {
+        DeferredStats* stats = &g_Deferred.m_Stats;
+        stats->m_Items = 0;
+        stats->m_StarvedItems = 0;
+        stats->m_MaxWaitFrames = 0;
+        for (DeferredItem& item : g_Deferred.m_Items)
+        {
+            if (!item.m_Active)
+            {
+                continue;
+            }
+
+            const u32 waitFrames = static_cast<u32>(DeferredWaitFrames(&item));
+            if (waitFrames > 0)
+            {
+                item.m_ChunkEstimate = DeferredDecay(item.m_ChunkEstimate);
+            }
+            stats->m_Items++;
+            stats->m_StarvedItems += waitFrames >= DEFERRED_STARVATION_FRAMES ? 1 : 0;
+            stats->m_MaxWaitFrames = waitFrames > stats->m_MaxWaitFrames ? waitFrames : stats->m_MaxWaitFrames;
+        }
+    }
+}
+
+u32 DeferredSubmit(const char* name, const DeferredFunction function, void* context, const DeferredPriority priority)
+{
+    for (u32 i = 0; i < DEFERRED_MAX_ITEMS; i++)
+    {
+        DeferredItem* item = &g_Deferred.m_Items[i];
+        if (item->m_Active)
+        {
+            continue;
+        }
+
+        *item =
+        {
+            .m_Name = name,
+            .m_Function = function,
+            .m_Context = context,
+            .m_Priority = priority,
+            .m_Active = true,
+            .m_Idle = false,
+            .m_ChunkEstimate = ClockSecondsToTicks(DEFERRED_FIRST_CHUNK_SECONDS),
+            .m_LastRunFrame = g_Deferred.m_Frame,
+            .m_LastRunSequence = g_Deferred.m_Sequence++,
+        };
+        return i;
+    }
+    return DEFERRED_INVALID_ITEM;
+}
+
+void DeferredCancel(const u32 item)
+{
+    if (item < DEFERRED_MAX_ITEMS)
+    {
+        g_Deferred.m_Items[item].m_Active = false;
+    }
+}
+
+void DeferredRun(const i64 deadline)
+{
+    DeferredStats* stats = &g_Deferred.m_Stats;
+    g_Deferred.m_Frame++;
+    for (DeferredItem& item : g_Deferred.m_Items)
+    {
+        item.m_Idle = false;
+    }
+
+    const i64 start = ClockNow();
+    stats->m_BudgetMs = deadline > start ? static_cast<float>(ClockTicksToMilliseconds(deadline - start)) : 0.0f;
+    stats->m_Chunks = 0;
+
+    i64 now = start;
+    while (DeferredItem* item = DeferredPickItem(now, deadline))
+    {
+        const DeferredResult result = item->m_Function(item->m_Context);
+        const i64 end = ClockNow();
+
+        const i64 decayed = DeferredDecay(item->m_ChunkEstimate);
+        item->m_ChunkEstimate = end - now > decayed ? end - now : decayed;
+        item->m_LastRunFrame = g_Deferred.m_Frame;
+        item->m_LastRunSequence = g_Deferred.m_Sequence++;
+        item->m_Idle = result == DeferredResult::IDLE;
+        item->m_Active = result != DeferredResult::DONE;
+        stats->m_Chunks++;
+        now = end;
+    }
+
+    stats->m_UsedMs = static_cast<float>(ClockTicksToMilliseconds(now - start));
+    DeferredUpdateStarvation();
+}
+
+const DeferredStats* DeferredGetStats()
+{
+    return &g_Deferred.m_Stats;
+}
+
+const char* DeferredMostStarvedItem()
+{
+    const DeferredItem* starved = nullptr;
+    for (const DeferredItem& item : g_Deferred.m_Items)
+    {
+        if (item.m_Active && (!starved || item.m_LastRunSequence < starved->m_LastRunSequence))
+        {
+            starved = &item;
+        }
+    }
+    return starved ? starved->m_Name : nullptr;
+}
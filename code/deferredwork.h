@@ -0,0 +1,58 @@
+#pragma once
+#include "types.h"
+
+/*
+* NOTE(sbalse): Work that doesn't have to finish in any particular frame, run in whatever time the frame has
+* left. Items are split into chunks by the code that submits them; the scheduler calls one chunk at a time and
+* only starts a chunk when the longest one it has recently seen from that item still fits before the deadline,
+* so the frame time stays flat however much work is queued.
+*
+* Items run by priority. Within a priority the one that ran least recently goes first, so items share the time.
+* An item that hasn't run for DEFERRED_STARVATION_FRAMES frames counts as starved and goes before the others
+* whenever its chunk fits. The estimate of an item that doesn't run slowly decays, so an item whose chunks are
+* longer than frames ever have left still runs now and then, overshooting those frames.
+*
+* Everything here is main thread only.
+*/
+
+constexpr u32 DEFERRED_MAX_ITEMS = 64;
+constexpr u32 DEFERRED_INVALID_ITEM = ~0u;
+constexpr u32 DEFERRED_STARVATION_FRAMES = 120;
+
+enum class DeferredPriority
+{
+    HIGH,
+    NORMAL,
+    LOW,
+    COUNT
+};
+
+enum class DeferredResult
+{
+    MORE, // NOTE(sbalse): Has more to do, may be called again this frame.
+    IDLE, // NOTE(sbalse): Nothing more to do this frame, call again next frame.
+    DONE, // NOTE(sbalse): Finished, the item is removed.
+    COUNT
+};
+
+// NOTE(sbalse): Does one chunk of work. Chunks should be well under a millisecond.
+using DeferredFunction = DeferredResult (*)(void* context);
+
+struct DeferredStats
+{
+    float m_BudgetMs; // NOTE(sbalse): Time that was left of the last frame.
+    float m_UsedMs;
+    u32 m_Items;
+    u32 m_Chunks; // NOTE(sbalse): Chunks run in the last frame.
+    u32 m_StarvedItems;
+    u32 m_MaxWaitFrames; // NOTE(sbalse): Frames the longest waiting item has gone without running.
+};
+
+// NOTE(sbalse): Returns DEFERRED_INVALID_ITEM when there is no room for another item.
+u32 DeferredSubmit(const char* name, const DeferredFunction function, void* context, const DeferredPriority priority);
+void DeferredCancel(const u32 item);
+// NOTE(sbalse): Runs chunks until the next one wouldn't finish before deadline, in clock ticks.
+void DeferredRun(const i64 deadline);
+const DeferredStats* DeferredGetStats();
+// NOTE(sbalse): Name of the item that has gone the longest without running, nullptr when there are no items.
+const char* DeferredMostStarvedItem();
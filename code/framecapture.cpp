@@ -0,0 +1,499 @@
+#include "framecapture.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <semaphore>
+#include <thread>
+
+#include "jobs.h"
+#include "lz4.h"
+#include "scenefile.h"
+
+namespace
+{
+    // NOTE(sbalse): A slot goes round FREE, COPYING, ENCODING and WRITING. Only the writer thread moves a slot from
+    // WRITING to FREE, everything else happens on the thread that calls FrameCaptureUpdate().
+    enum class FrameCaptureSlotState : u32
+    {
+        FREE,
+        COPYING,
+        ENCODING,
+        WRITING,
+        COUNT
+    };
+
+    struct FrameCaptureSlot
+    {
+        std::atomic<FrameCaptureSlotState> m_State;
+        u64 m_FrameIndex;
+        const u8* m_Pixels; // NOTE(sbalse): Mapped while ENCODING.
+        u32 m_Pitch;
+        u8* m_Rows; // NOTE(sbalse): Rows packed tightly, only needed when the mapped rows are padded.
+        u8* m_Compressed; // NOTE(sbalse): Chunk i starts at i times the compress bound of a chunk.
+        FrameCaptureChunk* m_Chunks;
+        JobHandle m_Job;
+        bool m_Dropped;
+        const FrameCapture* m_Capture;
+    };
+
+    // NOTE(sbalse): Packs and compresses chunks of rows, one chunk per index.
+    void FrameCaptureEncodeRange(void* context, const u32 begin, const u32 end);
+    void FrameCaptureWriterMain(FrameCapture* capture);
+
+    bool FrameCaptureMemoryCopy(void* context, const u32 slot)
+    {
+        FrameCaptureMemorySource* source = static_cast<FrameCaptureMemorySource*>(context);
+        const size_t size = static_cast<size_t>(source->m_Pitch) * source->m_Height;
+        if (!source->m_Copies[slot])
+        {
+            source->m_Copies[slot] = static_cast<u8*>(std::malloc(size));
+            if (!source->m_Copies[slot])
+            {
+                return false;
+            }
+        }
+        std::memcpy(source->m_Copies[slot], source->m_Pixels, size);
+        return true;
+    }
+
+    bool FrameCaptureMemoryMap(void* context, const u32 slot, const u8** pixels, u32* pitch)
+    {
+        const FrameCaptureMemorySource* source = static_cast<const FrameCaptureMemorySource*>(context);
+        *pixels = source->m_Copies[slot];
+        *pitch = source->m_Pitch;
+        return true;
+    }
+
+    void FrameCaptureMemoryUnmap(void*, const u32)
+    {
+    }
+} // namespace
+
+struct FrameCapture
+{
+    FrameCaptureDesc m_Desc;
+    FrameCaptureBackend m_Backend;
+    std::FILE* m_File;
+    u32 m_RowBytes;
+    u32 m_ChunkCount;
+    u32 m_ChunkBound;
+    u64 m_FrameIndex;
+    // NOTE(sbalse): Slots are used in ring order, every stage moves through them with its own cursor.
+    u32 m_CopyCursor;
+    u32 m_ReadCursor;
+    u32 m_HandoffCursor;
+    u32 m_WriteCursor; // NOTE(sbalse): Only touched by the writer thread.
+    u64 m_Captured;
+    u64 m_Dropped;
+    std::atomic<u64> m_Written;
+    std::atomic<u64> m_RawBytes;
+    std::atomic<u64> m_FileBytes;
+    std::atomic<bool> m_WriteFailed;
+    FrameCaptureSlot m_Slots[FRAMECAPTURE_MAX_SLOTS];
+    // NOTE(sbalse): One release per slot handed to the writer, and one more to stop it.
+    std::counting_semaphore<FRAMECAPTURE_MAX_SLOTS + 1> m_Ready{ 0 };
+    std::thread m_Writer;
+};
+
+namespace
+{
+    void FrameCaptureEncodeRange(void* context, const u32 begin, const u32 end)
+    {
+        FrameCaptureSlot* slot = static_cast<FrameCaptureSlot*>(context);
+        const FrameCapture* capture = slot->m_Capture;
+        const u32 rowBytes = capture->m_RowBytes;
+        for (u32 chunk = begin; chunk < end; chunk++)
+        {
+            const u32 firstRow = chunk * FRAMECAPTURE_CHUNK_ROWS;
+            const u32 remainingRows = capture->m_Desc.m_Height - firstRow;
+            const u32 rowCount = remainingRows < FRAMECAPTURE_CHUNK_ROWS ? remainingRows : FRAMECAPTURE_CHUNK_ROWS;
+            const u32 rawSize = rowCount * rowBytes;
+
+            const u8* rows = slot->m_Pixels + (static_cast<size_t>(firstRow) * slot->m_Pitch);
+            if (slot->m_Pitch != rowBytes)
+            {
+                u8* packed = slot->m_Rows + (static_cast<size_t>(firstRow) * rowBytes);
+                for (u32 row = 0; row < rowCount; row++)
+                {
+                    std::memcpy(packed + (row * rowBytes), rows + (static_cast<size_t>(row) * slot->m_Pitch), rowBytes);
+                }
+                rows = packed;
+            }
+
+            u8* target = slot->m_Compressed + (static_cast<size_t>(chunk) * capture->m_ChunkBound);
+            slot->m_Chunks[chunk] =
+            {
+                .m_CompressedSize = Lz4Compress(rows, rawSize, target),
+                .m_RawSize = rawSize,
+                .m_Checksum = SceneFileChecksum(rows, rawSize),
+            };
+        }
+    }
+
+    void FrameCaptureWriterMain(FrameCapture* capture)
+    {
+        for (;;)
+        {
+            capture->m_Ready.acquire();
+
+            // NOTE(sbalse): Slots are handed over in ring order, a release without one to write means stop.
+            FrameCaptureSlot* slot = &capture->m_Slots[capture->m_WriteCursor];
+            if (slot->m_State.load(std::memory_order_acquire) != FrameCaptureSlotState::WRITING)
+            {
+                break;
+            }
+
+            const FrameCaptureFrameHeader header =
+            {
+                .m_Magic = FRAMECAPTURE_FRAME_MAGIC,
+                .m_ChunkCount = capture->m_ChunkCount,
+                .m_FrameIndex = slot->m_FrameIndex,
+            };
+            const size_t tableSize = capture->m_ChunkCount * sizeof(FrameCaptureChunk);
+            bool written = std::fwrite(&header, sizeof(header), 1, capture->m_File) == 1
+                && std::fwrite(slot->m_Chunks, 1, tableSize, capture->m_File) == tableSize;
+            u64 fileBytes = sizeof(header) + tableSize;
+            u64 rawBytes = 0;
+            for (u32 chunk = 0; chunk < capture->m_ChunkCount && written; chunk++)
+            {
+                const FrameCaptureChunk* entry = &slot->m_Chunks[chunk];
+                const u8* data = slot->m_Compressed + (static_cast<size_t>(chunk) * capture->m_ChunkBound);
+                written = std::fwrite(data, 1, entry->m_CompressedSize, capture->m_File) == entry->m_CompressedSize;
+                fileBytes += entry->m_CompressedSize;
+                rawBytes += entry->m_RawSize;
+            }
+
+            // NOTE(sbalse): A failed write still frees the slot so capturing doesn't stall, the stats report it.
+            if (written)
+            {
+                capture->m_Written.fetch_add(1, std::memory_order_relaxed);
+                capture->m_RawBytes.fetch_add(rawBytes, std::memory_order_relaxed);
+                capture->m_FileBytes.fetch_add(fileBytes, std::memory_order_relaxed);
+            }
+            else
+            {
+                capture->m_WriteFailed.store(true, std::memory_order_relaxed);
+            }
+
+            slot->m_State.store(FrameCaptureSlotState::FREE, std::memory_order_release);
+            capture->m_WriteCursor = (capture->m_WriteCursor + 1) % capture->m_Desc.m_SlotCount;
+        }
+    }
+
+    // NOTE(sbalse): Starts encoding the frames whose copies are due and hands encoded frames to the writer, both in
+    // the order the frames were taken. When flushing, copies are due right away and encoding is waited for.
+    void FrameCaptureAdvance(FrameCapture* capture, const bool flush)
+    {
+        const u32 slotCount = capture->m_Desc.m_SlotCount;
+        for (;;)
+        {
+            FrameCaptureSlot* slot = &capture->m_Slots[capture->m_ReadCursor];
+            if (slot->m_State.load(std::memory_order_relaxed) != FrameCaptureSlotState::COPYING
+                || (!flush && capture->m_FrameIndex - slot->m_FrameIndex < capture->m_Desc.m_Latency)
+                || !capture->m_Backend.m_Map(capture->m_Backend.m_Context, capture->m_ReadCursor, &slot->m_Pixels,
+                    &slot->m_Pitch))
+            {
+                break;
+            }
+
+            if (slot->m_Pitch != capture->m_RowBytes && !slot->m_Rows)
+            {
+                slot->m_Rows = static_cast<u8*>(
+                    std::malloc(static_cast<size_t>(capture->m_RowBytes) * capture->m_Desc.m_Height));
+            }
+
+            // NOTE(sbalse): Without room to pack the rows the frame is dropped when it's handed over, so the slots
+            // still leave in order.
+            slot->m_Dropped = slot->m_Pitch != capture->m_RowBytes && !slot->m_Rows;
+            slot->m_Job = JobsDispatch(slot->m_Dropped ? 0 : capture->m_ChunkCount, 1, FrameCaptureEncodeRange, slot);
+            slot->m_State.store(FrameCaptureSlotState::ENCODING, std::memory_order_relaxed);
+            capture->m_ReadCursor = (capture->m_ReadCursor + 1) % slotCount;
+        }
+
+        for (;;)
+        {
+            FrameCaptureSlot* slot = &capture->m_Slots[capture->m_HandoffCursor];
+            if (slot->m_State.load(std::memory_order_relaxed) != FrameCaptureSlotState::ENCODING)
+            {
+                break;
+            }
+            if (!JobsIsDone(slot->m_Job))
+            {
+                if (!flush)
+                {
+                    break;
+                }
+                JobsWait(slot->m_Job);
+            }
+
+            capture->m_Backend.m_Unmap(capture->m_Backend.m_Context, capture->m_HandoffCursor);
+            if (slot->m_Dropped)
+            {
+                slot->m_State.store(FrameCaptureSlotState::FREE, std::memory_order_relaxed);
+                capture->m_Captured--;
+                capture->m_Dropped++;
+            }
+            else
+            {
+                slot->m_State.store(FrameCaptureSlotState::WRITING, std::memory_order_release);
+                capture->m_Ready.release();
+            }
+            capture->m_HandoffCursor = (capture->m_HandoffCursor + 1) % slotCount;
+        }
+    }
+} // namespace
+
+FrameCapture* FrameCaptureCreate(const FrameCaptureDesc* desc, const FrameCaptureBackend* backend)
+{
+    if (desc->m_Width == 0 || desc->m_Height == 0
+        || desc->m_Width > FRAMECAPTURE_MAX_SIZE || desc->m_Height > FRAMECAPTURE_MAX_SIZE
+        || desc->m_SlotCount == 0 || desc->m_SlotCount > FRAMECAPTURE_MAX_SLOTS
+        || static_cast<u32>(desc->m_Format) >= static_cast<u32>(FrameCaptureFormat::COUNT))
+    {
+        return nullptr;
+    }
+
+    FrameCapture* capture = new FrameCapture();
+    capture->m_Desc = *desc;
+    capture->m_Backend = *backend;
+    capture->m_RowBytes = desc->m_Width * 4;
+    capture->m_ChunkCount = (desc->m_Height + FRAMECAPTURE_CHUNK_ROWS - 1) / FRAMECAPTURE_CHUNK_ROWS;
+    capture->m_ChunkBound = Lz4CompressBound(capture->m_RowBytes * FRAMECAPTURE_CHUNK_ROWS);
+
+    bool created = true;
+    for (u32 i = 0; i < desc->m_SlotCount; i++)
+    {
+        FrameCaptureSlot* slot = &capture->m_Slots[i];
+        slot->m_Capture = capture;
+        slot->m_Compressed = static_cast<u8*>(
+            std::malloc(static_cast<size_t>(capture->m_ChunkBound) * capture->m_ChunkCount));
+        slot->m_Chunks = static_cast<FrameCaptureChunk*>(
+            std::calloc(capture->m_ChunkCount, sizeof(FrameCaptureChunk)));
+        created = created && slot->m_Compressed && slot->m_Chunks;
+    }
+
+    const FrameCaptureFileHeader header =
+    {
+        .m_Magic = FRAMECAPTURE_MAGIC,
+        .m_Version = FRAMECAPTURE_VERSION,
+        .m_Width = desc->m_Width,
+        .m_Height = desc->m_Height,
+        .m_Format = static_cast<u32>(desc->m_Format),
+        .m_ChunkRows = FRAMECAPTURE_CHUNK_ROWS,
+    };
+    capture->m_File = created ? std::fopen(desc->m_Path, "wb") : nullptr;
+    if (!capture->m_File || std::fwrite(&header, sizeof(header), 1, capture->m_File) != 1)
+    {
+        if (capture->m_File)
+        {
+            std::fclose(capture->m_File);
+        }
+        for (u32 i = 0; i < desc->m_SlotCount; i++)
+        {
+            std::free(capture->m_Slots[i].m_Compressed);
+            std::free(capture->m_Slots[i].m_Chunks);
+        }
+        delete capture;
+        return nullptr;
+    }
+    capture->m_FileBytes.store(sizeof(header), std::memory_order_relaxed);
+
+    capture->m_Writer = std::thread(FrameCaptureWriterMain, capture);
+    return capture;
+}
+
+void FrameCaptureDestroy(FrameCapture* capture)
+{
+    // NOTE(sbalse): Copies may still be in flight on the GPU, keep polling until every frame is with the writer.
+    for (;;)
+    {
+        FrameCaptureAdvance(capture, true);
+        const FrameCaptureSlotState state = capture->m_Slots[capture->m_ReadCursor].m_State.load(
+            std::memory_order_relaxed);
+        if (state != FrameCaptureSlotState::COPYING)
+        {
+            break;
+        }
+        std::this_thread::yield();
+    }
+
+    capture->m_Ready.release();
+    capture->m_Writer.join();
+
+    std::fclose(capture->m_File);
+    for (u32 i = 0; i < capture->m_Desc.m_SlotCount; i++)
+    {
+        std::free(capture->m_Slots[i].m_Rows);
+        std::free(capture->m_Slots[i].m_Compressed);
+        std::free(capture->m_Slots[i].m_Chunks);
+    }
+    delete capture;
+}
+
+bool FrameCaptureUpdate(FrameCapture* capture, const bool captureFrame)
+{
+    FrameCaptureAdvance(capture, false);
+
+    bool result = true;
+    if (captureFrame)
+    {
+        FrameCaptureSlot* slot = &capture->m_Slots[capture->m_CopyCursor];
+        if (slot->m_State.load(std::memory_order_acquire) == FrameCaptureSlotState::FREE
+            && capture->m_Backend.m_Copy(capture->m_Backend.m_Context, capture->m_CopyCursor))
+        {
+            slot->m_FrameIndex = capture->m_FrameIndex;
+            slot->m_State.store(FrameCaptureSlotState::COPYING, std::memory_order_relaxed);
+            capture->m_CopyCursor = (capture->m_CopyCursor + 1) % capture->m_Desc.m_SlotCount;
+            capture->m_Captured++;
+        }
+        else
+        {
+            capture->m_Dropped++;
+            result = false;
+        }
+    }
+
+    capture->m_FrameIndex++;
+    return result;
+}
+
+FrameCaptureStats FrameCaptureGetStats(const FrameCapture* capture)
+{
+    const FrameCaptureStats result =
+    {
+        .m_Captured = capture->m_Captured,
+        .m_Dropped = capture->m_Dropped,
+        .m_Written = capture->m_Written.load(std::memory_order_relaxed),
+        .m_RawBytes = capture->m_RawBytes.load(std::memory_order_relaxed),
+        .m_FileBytes = capture->m_FileBytes.load(std::memory_order_relaxed),
+        .m_WriteFailed = capture->m_WriteFailed.load(std::memory_order_relaxed),
+    };
+    return result;
+}
+
+struct FrameCaptureReader
+{
+    std::FILE* m_File;
+    FrameCaptureFileHeader m_Header;
+    u32 m_ChunkCount;
+    u32 m_ChunkBound;
+    FrameCaptureChunk* m_Chunks;
+    u8* m_Compressed;
+};
+
+FrameCaptureReader* FrameCaptureReaderOpen(const char* path, FrameCaptureFileHeader* header)
+{
+    std::FILE* file = std::fopen(path, "rb");
+    if (!file)
+    {
+        return nullptr;
+    }
+
+    FrameCaptureFileHeader fileHeader = {};
+    if (std::fread(&fileHeader, sizeof(fileHeader), 1, file) != 1
+        || fileHeader.m_Magic != FRAMECAPTURE_MAGIC
+        || fileHeader.m_Version != FRAMECAPTURE_VERSION
+        || fileHeader.m_Width == 0
+        || fileHeader.m_Height == 0
+        || fileHeader.m_Width > FRAMECAPTURE_MAX_SIZE
+        || fileHeader.m_Height > FRAMECAPTURE_MAX_SIZE
+        || fileHeader.m_Format >= static_cast<u32>(FrameCaptureFormat::COUNT)
+        || fileHeader.m_ChunkRows == 0
+        || fileHeader.m_ChunkRows > fileHeader.m_Height)
+    {
+        std::fclose(file);
+        return nullptr;
+    }
+
+    FrameCaptureReader* reader = static_cast<FrameCaptureReader*>(std::calloc(1, sizeof(FrameCaptureReader)));
+    if (reader)
+    {
+        reader->m_File = file;
+        reader->m_Header = fileHeader;
+        reader->m_ChunkCount = (fileHeader.m_Height + fileHeader.m_ChunkRows - 1) / fileHeader.m_ChunkRows;
+        reader->m_ChunkBound = Lz4CompressBound(fileHeader.m_Width * 4 * fileHeader.m_ChunkRows);
+        reader->m_Chunks = static_cast<FrameCaptureChunk*>(
+            std::calloc(reader->m_ChunkCount, sizeof(FrameCaptureChunk)));
+        reader->m_Compressed = static_cast<u8*>(std::malloc(reader->m_ChunkBound));
+    }
+    if (!reader || !reader->m_Chunks || !reader->m_Compressed)
+    {
+        if (reader)
+        {
+            std::free(reader->m_Chunks);
+            std::free(reader->m_Compressed);
+            std::free(reader);
+        }
+        std::fclose(file);
+        return nullptr;
+    }
+
+    *header = fileHeader;
+    return reader;
+}
+
+void FrameCaptureReaderClose(FrameCaptureReader* reader)
+{
+    std::fclose(reader->m_File);
+    std::free(reader->m_Chunks);
+    std::free(reader->m_Compressed);
+    std::free(reader);
+}
+
+bool FrameCaptureReadFrame(FrameCaptureReader* reader, u64* frameIndex, u8* pixels)
+{
+    FrameCaptureFrameHeader header = {};
+    if (std::fread(&header, sizeof(header), 1, reader->m_File) != 1
+        || header.m_Magic != FRAMECAPTURE_FRAME_MAGIC
+        || header.m_ChunkCount != reader->m_ChunkCount
+        || std::fread(reader->m_Chunks, sizeof(FrameCaptureChunk), reader->m_ChunkCount, reader->m_File)
+            != reader->m_ChunkCount)
+    {
+        return false;
+    }
+
+    const u32 rowBytes = reader->m_Header.m_Width * 4;
+    const u32 chunkRows = reader->m_Header.m_ChunkRows;
+    for (u32 chunk = 0; chunk < reader->m_ChunkCount; chunk++)
+    {
+        const FrameCaptureChunk* entry = &reader->m_Chunks[chunk];
+        const u32 firstRow = chunk * chunkRows;
+        const u32 remainingRows = reader->m_Header.m_Height - firstRow;
+        const u32 rowCount = remainingRows < chunkRows ? remainingRows : chunkRows;
+        u8* rows = pixels + (static_cast<size_t>(firstRow) * rowBytes);
+        if (entry->m_RawSize != rowCount * rowBytes
+            || entry->m_CompressedSize > reader->m_ChunkBound
+            || std::fread(reader->m_Compressed, 1, entry->m_CompressedSize, reader->m_File) != entry->m_CompressedSize
+            || !Lz4Decompress(reader->m_Compressed, entry->m_CompressedSize, rows, entry->m_RawSize)
+            || SceneFileChecksum(rows, entry->m_RawSize) != entry->m_Checksum)
+        {
+            return false;
+        }
+    }
+
+    *frameIndex = header.m_FrameIndex;
+    return true;
+}
+
+FrameCaptureBackend FrameCaptureMemoryBackend(FrameCaptureMemorySource* source)
+{
+    const FrameCaptureBackend result =
+    {
+        .m_Context = source,
+        .m_Copy = FrameCaptureMemoryCopy,
+        .m_Map = FrameCaptureMemoryMap,
+        .m_Unmap = FrameCaptureMemoryUnmap,
+    };
+    return result;
+}
+
+void FrameCaptureMemoryFree(FrameCaptureMemorySource* source)
+{
+    for (u8*& copy : source->m_Copies)
+    {
+        std::free(copy);
+        copy = nullptr;
+    }
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include "types.h"
+
+/*
+* NOTE(sbalse): Frame capture. A captured frame is copied into one of a ring of slots and read back m_Latency
+* frames later, when the copy has long landed, so capturing never waits on the GPU. The pixels are compressed
+* with LZ4 on the job workers, FRAMECAPTURE_CHUNK_ROWS rows per batch, and a writer thread appends the frames to
+* the capture file in the order they were taken. All the frame loop does is issue copies and poll.
+*
+* When every slot is still busy, because the GPU, the workers or the disk fell behind, the frame is dropped and
+* counted rather than waited for.
+*
+* Where pixels come from is up to a backend. graphics/framecapturebackend.h reads a D3D11 texture through staging
+* textures. The memory backend here copies a framebuffer in memory, so captures work without a GPU.
+*
+* A capture file is a FrameCaptureFileHeader followed by frames. Every frame is a FrameCaptureFrameHeader, a
+* FrameCaptureChunk per chunk of rows, then the compressed chunks back to back. Chunks are LZ4 blocks of tightly
+* packed rows, the last one may have fewer rows. The checksums are of the uncompressed rows, comparing them is
+* enough to tell whether two captures rendered the same.
+*/
+
+constexpr u32 FRAMECAPTURE_MAGIC = 0x50414346; // NOTE(sbalse): "FCAP".
+constexpr u32 FRAMECAPTURE_FRAME_MAGIC = 0x454D5246; // NOTE(sbalse): "FRME".
+constexpr u32 FRAMECAPTURE_VERSION = 1;
+constexpr u32 FRAMECAPTURE_MAX_SLOTS = 8;
+constexpr u32 FRAMECAPTURE_MAX_SIZE = 16384;
+constexpr u32 FRAMECAPTURE_CHUNK_ROWS = 32;
+
+enum class FrameCaptureFormat : u32
+{
+    RGBA8,
+    BGRA8,
+    COUNT
+};
+
+struct FrameCaptureFileHeader
+{
+    u32 m_Magic;
+    u32 m_Version;
+    u32 m_Width;
+    u32 m_Height;
+    u32 m_Format; // NOTE(sbalse): A FrameCaptureFormat.
+    u32 m_ChunkRows;
+};
+
+struct FrameCaptureFrameHeader
+{
+    u32 m_Magic;
+    u32 m_ChunkCount;
+    u64 m_FrameIndex; // NOTE(sbalse): Counts every frame passed to FrameCaptureUpdate(), gaps are dropped frames.
+};
+
+struct FrameCaptureChunk
+{
+    u32 m_CompressedSize;
+    u32 m_RawSize;
+    u64 m_Checksum;
+};
+
+struct FrameCaptureBackend
+{
+    void* m_Context;
+    // NOTE(sbalse): Starts copying the current frame into slot. Returns false when it can't, the frame is dropped.
+    bool (*m_Copy)(void* context, const u32 slot);
+    // NOTE(sbalse): Returns false while the copy into slot is still in flight. Otherwise the rows are pitch bytes
+    // apart and stay readable from any thread until the slot is unmapped.
+    bool (*m_Map)(void* context, const u32 slot, const u8** pixels, u32* pitch);
+    void (*m_Unmap)(void* context, const u32 slot);
+};
+
+struct FrameCaptureDesc
+{
+    const char* m_Path;
+    u32 m_Width;
+    u32 m_Height;
+    FrameCaptureFormat m_Format;
+    u32 m_SlotCount; // NOTE(sbalse): Up to FRAMECAPTURE_MAX_SLOTS.
+    u32 m_Latency; // NOTE(sbalse): Frames between copying a frame and reading it back.
+};
+
+struct FrameCaptureStats
+{
+    u64 m_Captured;
+    u64 m_Dropped;
+    u64 m_Written;
+    u64 m_RawBytes; // NOTE(sbalse): Of the frames written.
+    u64 m_FileBytes;
+    bool m_WriteFailed;
+};
+
+struct FrameCapture;
+
+// NOTE(sbalse): Returns nullptr when the file can't be created.
+FrameCapture* FrameCaptureCreate(const FrameCaptureDesc* desc, const FrameCaptureBackend* backend);
+// NOTE(sbalse): Finishes the frames in flight, waiting for them, and closes the file.
+void FrameCaptureDestroy(FrameCapture* capture);
+// NOTE(sbalse): Once per frame, after it is rendered. Reads back, encodes and hands over frames that are due, and
+// copies this frame when captureFrame is set. Returns false when the frame was to be captured but was dropped.
+bool FrameCaptureUpdate(FrameCapture* capture, const bool captureFrame);
+// NOTE(sbalse): Written by the writer thread, the numbers may be a frame behind.
+FrameCaptureStats FrameCaptureGetStats(const FrameCapture* capture);
+
+// NOTE(sbalse): Reads capture files back. Frames come out in file order as tightly packed rows.
+struct FrameCaptureReader;
+
+FrameCaptureReader* FrameCaptureReaderOpen(const char* path, FrameCaptureFileHeader* header);
+void FrameCaptureReaderClose(FrameCaptureReader* reader);
+// NOTE(sbalse): pixels holds width * height * 4 bytes. Returns false at the end of the file or on a damaged frame.
+bool FrameCaptureReadFrame(FrameCaptureReader* reader, u64* frameIndex, u8* pixels);
+
+// NOTE(sbalse): Backend that copies a framebuffer in memory. Every slot gets a copy of the frame, the copies land
+// right away.
+struct FrameCaptureMemorySource
+{
+    const u8* m_Pixels; // NOTE(sbalse): Read when a frame is copied.
+    u32 m_Pitch;
+    u32 m_Height;
+    u8* m_Copies[FRAMECAPTURE_MAX_SLOTS]; // NOTE(sbalse): Allocated on first use.
+};
+
+FrameCaptureBackend FrameCaptureMemoryBackend(FrameCaptureMemorySource* source);
+void FrameCaptureMemoryFree(FrameCaptureMemorySource* source);
@@ -0,0 +1,180 @@
+#include "framepacer.h"
+
+#include <thread>
+
+#include "clock.h"
+#include "histogram.h"
+#include "stats.h"
+
+#if _WIN32
+#include "cleanwindows.h"
+#include <timeapi.h>
+#else
+#include <cerrno>
+#include <time.h>
+#endif
+
+namespace
+{
+    struct FramePacer
+    {
+        i64 m_TargetPeriod; // NOTE(sbalse): Ticks per frame while focused, 0 = unpaced.
+        i64 m_BackgroundPeriod; // NOTE(sbalse): Ticks per frame while unfocused, 0 = unpaced.
+        i64 m_NextDeadline;
+        i64 m_SpinTicks; // NOTE(sbalse): How much before the deadline we stop sleeping and start spinning.
+        bool m_IsFocused;
+#if _WIN32
+        HANDLE m_Timer;
+        bool m_RaisedTimerResolution; // NOTE(sbalse): timeBeginPeriod() was called for the fallback sleep.
+#endif
+    };
+
+    constinit FramePacer g_Pacer = {};
+    constinit Histogram g_PacerWakeErrors = {};
+    constinit PacerReport g_PacerReport = {};
+
+    // NOTE(sbalse): Blocks the thread in the OS until roughly the given deadline. Never oversleeps on purpose,
+    // but the OS may wake us late, which is what the spin margin is for.
+    void PacerSleepUntil(const i64 deadline)
+    {
+        const i64 remaining = deadline - ClockNow();
+        if (remaining <= 0)
+        {
+            return;
+        }
+
+#if _WIN32
+        if (g_Pacer.m_Timer)
+        {
+            // NOTE(sbalse): Negative due times are relative, in 100 nanosecond units.
+            LARGE_INTEGER dueTime = {};
+            dueTime.QuadPart = -static_cast<LONGLONG>(ClockTicksToSeconds(remaining) * 10'000'000.0);
+            if (SetWaitableTimer(g_Pacer.m_Timer, &dueTime, 0, nullptr, nullptr, FALSE))
+            {
+                WaitForSingleObject(g_Pacer.m_Timer, INFINITE);
+            }
+        }
+        else
+        {
+            // NOTE(sbalse): Whole milliseconds only, the spin margin covers what Sleep() adds on top.
+            Sleep(static_cast<DWORD>(ClockTicksToMilliseconds(remaining)));
+        }
+#else
+        // NOTE(sbalse): Clock ticks are CLOCK_MONOTONIC nanoseconds here, so we can sleep on an absolute time.
+        timespec target = {};
+        target.tv_sec = static_cast<time_t>(deadline / 1'000'000'000);
+        target.tv_nsec = static_cast<long>(deadline % 1'000'000'000);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &target, nullptr) == EINTR)
+        {
+            // NOTE(sbalse): Interrupted by a signal, go back to sleep. Any other error leaves the rest to the spin.
+        }
+#endif
+    }
+}
+
+void PacerInit(const double targetFrameRate, const double backgroundFrameRate)
+{
+    g_Pacer = {};
+    g_Pacer.m_TargetPeriod = targetFrameRate > 0.0 ? ClockSecondsToTicks(1.0 / targetFrameRate) : 0;
+    g_Pacer.m_BackgroundPeriod = backgroundFrameRate > 0.0 ? ClockSecondsToTicks(1.0 / backgroundFrameRate) : 0;
+    g_Pacer.m_IsFocused = true;
+    g_Pacer.m_NextDeadline = ClockNow();
+
+#if _WIN32
+    // NOTE(sbalse): High resolution waitable timers wake up within a fraction of a millisecond. Without one we
+    // fall back to Sleep() with the scheduler at 1 ms, which wakes up to a couple of milliseconds late, so we spin
+    // for longer. If even that can't be had, Sleep() rounds to the default 15.6 ms tick.
+    g_Pacer.m_Timer = CreateWaitableTimerExW(
+        nullptr,
+        nullptr,
+        CREATE_WAITABLE_TIMER_HIGH_RESOLUTION,
+        TIMER_ALL_ACCESS);
+    if (g_Pacer.m_Timer)
+    {
+        g_Pacer.m_SpinTicks = ClockSecondsToTicks(0.001);
+    }
+    else
+    {
+        g_Pacer.m_RaisedTimerResolution = timeBeginPeriod(1) == TIMERR_NOERROR;
+        g_Pacer.m_SpinTicks = ClockSecondsToTicks(g_Pacer.m_RaisedTimerResolution ? 0.002 : 0.016);
+    }
+#else
+    g_Pacer.m_SpinTicks = ClockSecondsToTicks(0.0002);
+#endif
+
+    HistogramReset(&g_PacerWakeErrors);
+    g_PacerReport = {};
+}
+
+void PacerShutdown()
+{
+#if _WIN32
+    if (g_Pacer.m_Timer)
+    {
+        CloseHandle(g_Pacer.m_Timer);
+    }
+    if (g_Pacer.m_RaisedTimerResolution)
+    {
+        timeEndPeriod(1);
+    }
+#endif
+    g_Pacer = {};
+}
+
+void PacerSetFocused(const bool focused)
+{
+    g_Pacer.m_IsFocused = focused;
+}
+
+void PacerWaitForNextFrame()
+{
+    const i64 period = g_Pacer.m_IsFocused ? g_Pacer.m_TargetPeriod : g_Pacer.m_BackgroundPeriod;
+
+    g_PacerReport.m_IsBackground = !g_Pacer.m_IsFocused;
+    g_PacerReport.m_TargetFrameTimeMs = static_cast<float>(ClockTicksToMilliseconds(period));
+
+    if (period == 0)
+    {
+        g_Pacer.m_NextDeadline = ClockNow();
+        return;
+    }
+
+    StatsBeginStage(StatsStage::PACE);
+
+    const i64 waitStart = ClockNow();
+    i64 deadline = g_Pacer.m_NextDeadline + period;
+
+    // NOTE(sbalse): If we missed the deadline by more than a whole frame there is no catching up, start a
+    // fresh schedule from now instead of running a burst of unpaced frames.
+    if (waitStart - deadline > period)
+    {
+        deadline = waitStart;
+    }
+
+    PacerSleepUntil(deadline - g_Pacer.m_SpinTicks);
+    const i64 sleepEnd = ClockNow();
+
+    while (ClockNow() < deadline)
+    {
+        std::this_thread::yield();
+    }
+
+    const i64 wakeTime = ClockNow();
+    g_Pacer.m_NextDeadline = deadline;
+
+    StatsEndStage(StatsStage::PACE);
+
+    const i64 lateness = wakeTime > deadline ? wakeTime - deadline : 0;
+    HistogramRecord(&g_PacerWakeErrors, static_cast<u32>(ClockTicksToSeconds(lateness) * 1'000'000.0));
+
+    const i64 waited = wakeTime - waitStart;
+    const i64 slept = sleepEnd > waitStart ? sleepEnd - waitStart : 0;
+    g_PacerReport.m_SleepFraction = waited > 0 ? static_cast<float>(slept) / static_cast<float>(waited) : 0.0f;
+    g_PacerReport.m_WakeErrorMeanUs = static_cast<float>(HistogramMean(&g_PacerWakeErrors));
+    g_PacerReport.m_WakeErrorP99Us = static_cast<float>(HistogramPercentile(&g_PacerWakeErrors, 0.99f));
+}
+
+const PacerReport* PacerGetReport()
+{
+    return &g_PacerReport;
+}
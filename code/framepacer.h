@@ -0,0 +1,27 @@
+#pragma once
+#include "types.h"
+
+/*
+* NOTE(sbalse): Paces frames to a target rate. Waiting is a hybrid: the OS sleeps for the bulk of the wait
+* and we only spin for the last bit, which is where OS sleeps are too coarse. While the window is not
+* focused the pacer drops to a much lower background rate.
+*/
+
+struct PacerReport
+{
+    float m_TargetFrameTimeMs;
+    // NOTE(sbalse): How late we woke up compared to the deadline, over recent frames.
+    float m_WakeErrorMeanUs;
+    float m_WakeErrorP99Us;
+    // NOTE(sbalse): Portion of the last wait spent asleep in the OS rather than spinning.
+    float m_SleepFraction;
+    bool m_IsBackground;
+};
+
+// NOTE(sbalse): A target frame rate of 0 means the pacer does not wait at all (e.g. when vsync paces us).
+void PacerInit(const double targetFrameRate, const double backgroundFrameRate);
+void PacerShutdown();
+void PacerSetFocused(const bool focused);
+// NOTE(sbalse): Call once per frame, after presenting. Waits until the next frame is due.
+void PacerWaitForNextFrame();
+const PacerReport* PacerGetReport();
@@ -0,0 +1,221 @@
+#include "framepipeline.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <semaphore>
+#include <thread>
+
+#include "clock.h"
+#include "simulation.h"
+#include "stats.h"
+
+namespace
+{
+    struct FramePipeline
+    {
+        SceneSnapshot m_Snapshots[PIPELINE_SNAPSHOT_COUNT];
+        float* m_SnapshotMemory;
+        FixedStepClock m_SimulationClock; // NOTE(sbalse): Only touched by the simulation side.
+        bool m_Threaded;
+        u64 m_NextFrameIndex;
+        u32 m_WriteSlot; // NOTE(sbalse): Only touched by the simulation side.
+        u32 m_ReadSlot; // NOTE(sbalse): Only touched by the render side.
+        std::atomic<bool> m_Running;
+        std::atomic<const char*> m_SceneSavePath; // NOTE(sbalse): Consumed by the simulation side.
+        std::atomic<PipelineSceneSave> m_SceneSave;
+        std::atomic<u32> m_RewindSteps; // NOTE(sbalse): Consumed by the simulation side.
+        std::atomic<bool> m_RewindRecording; // NOTE(sbalse): Followed by the simulation side.
+        std::thread m_SimulationThread;
+        // NOTE(sbalse): Slots the simulation may write into / slots the render side may read from. One extra
+        // count of headroom for the wake up on shutdown.
+        std::counting_semaphore<PIPELINE_SNAPSHOT_COUNT + 1> m_FreeSlots{ PIPELINE_SNAPSHOT_COUNT };
+        std::counting_semaphore<PIPELINE_SNAPSHOT_COUNT + 1> m_FilledSlots{ 0 };
+    };
+
+    FramePipeline* g_Pipeline = nullptr;
+
+    void SimulateIntoSnapshot(SceneSnapshot* snapshot)
+    {
+        StatsBeginStage(StatsStage::SIMULATE);
+
+        // NOTE(sbalse): Recording starts and stops between steps. When it can't start it is switched back off.
+        const bool rewindRecording = g_Pipeline->m_RewindRecording.load(std::memory_order_acquire);
+        if (rewindRecording != SimulationIsRewindRecording() && !SimulationSetRewindRecording(rewindRecording))
+        {
+            g_Pipeline->m_RewindRecording.store(false, std::memory_order_relaxed);
+        }
+
+        // NOTE(sbalse): Rewound between steps on the simulation side, the steps due this frame carry on from there.
+        const u32 rewindSteps = g_Pipeline->m_RewindSteps.exchange(0, std::memory_order_acquire);
+        if (rewindSteps > 0)
+        {
+            SimulationRewind(rewindSteps);
+        }
+
+        FixedStepClock* clock = &g_Pipeline->m_SimulationClock;
+        const u32 steps = FixedStepClockAdvance(clock, ClockNow());
+        const float stepSeconds = FixedStepClockStepSeconds(clock);
+        for (u32 i = 0; i < steps; i++)
+        {
+            SimulationStep(stepSeconds);
+        }
+        StatsAddCounter(StatsCounter::SIMSTEPS, steps);
+        StatsAddCounter(StatsCounter::OVERLAPS, SimulationFindOverlaps());
+        StatsAddCounter(StatsCounter::SIMSTEPSDROPPED, clock->m_DroppedSteps);
+
+        // NOTE(sbalse): Saved between steps on the simulation side, so it never sees a half stepped state.
+        const char* sceneSavePath = g_Pipeline->m_SceneSavePath.exchange(nullptr, std::memory_order_acquire);
+        if (sceneSavePath)
+        {
+            const bool saved = SimulationSaveScene(sceneSavePath);
+            g_Pipeline->m_SceneSave.store(
+                saved ? PipelineSceneSave::SAVED : PipelineSceneSave::FAILED,
+                std::memory_order_release);
+        }
+
+        const SimulationState* state = SimulationGetState();
+        const size_t size = state->m_Count * sizeof(float);
+        std::memcpy(snapshot->m_DistanceFromCenter, state->m_DistanceFromCenter, size);
+        std::memcpy(snapshot->m_SelfRotation, state->m_SelfRotation, size);
+        std::memcpy(snapshot->m_WorldRotation, state->m_WorldRotation, size);
+        std::memcpy(snapshot->m_PreviousSelfRotation, state->m_PreviousSelfRotation, size);
+        std::memcpy(snapshot->m_PreviousWorldRotation, state->m_PreviousWorldRotation, size);
+        snapshot->m_Alpha = FixedStepClockAlpha(clock);
+        snapshot->m_Count = state->m_Count;
+        snapshot->m_FrameIndex = g_Pipeline->m_NextFrameIndex++;
+
+        StatsEndStage(StatsStage::SIMULATE);
+
+        snapshot->m_PublishTime = ClockNow();
+    }
+
+    void SimulationThreadMain()
+    {
+        for (;;)
+        {
+            g_Pipeline->m_FreeSlots.acquire();
+            if (!g_Pipeline->m_Running.load(std::memory_order_acquire))
+            {
+                break;
+            }
+
+            SimulateIntoSnapshot(&g_Pipeline->m_Snapshots[g_Pipeline->m_WriteSlot]);
+            g_Pipeline->m_WriteSlot = (g_Pipeline->m_WriteSlot + 1) % PIPELINE_SNAPSHOT_COUNT;
+
+            g_Pipeline->m_FilledSlots.release();
+        }
+    }
+}
+
+bool PipelineInit(const bool threaded, const double simulationRate, const u32 maxStepsPerFrame)
+{
+    const SimulationState* state = SimulationGetState();
+
+    g_Pipeline = new FramePipeline();
+    g_Pipeline->m_Threaded = threaded;
+    FixedStepClockInit(&g_Pipeline->m_SimulationClock, simulationRate, maxStepsPerFrame);
+
+    g_Pipeline->m_SnapshotMemory = static_cast<float*>(std::calloc(
+        static_cast<size_t>(state->m_Count) * PIPELINE_SNAPSHOT_STREAMS * PIPELINE_SNAPSHOT_COUNT,
+        sizeof(float)));
+    if (!g_Pipeline->m_SnapshotMemory)
+    {
+        delete g_Pipeline;
+        g_Pipeline = nullptr;
+        return false;
+    }
+
+    for (u32 i = 0; i < PIPELINE_SNAPSHOT_COUNT; i++)
+    {
+        SceneSnapshot* snapshot = &g_Pipeline->m_Snapshots[i];
+        snapshot->m_Count = state->m_Count;
+        snapshot->m_DistanceFromCenter =
+            g_Pipeline->m_SnapshotMemory + (i * PIPELINE_SNAPSHOT_STREAMS * state->m_Count);
+        snapshot->m_SelfRotation = snapshot->m_DistanceFromCenter + state->m_Count;
+        snapshot->m_WorldRotation = snapshot->m_SelfRotation + state->m_Count;
+        snapshot->m_PreviousSelfRotation = snapshot->m_WorldRotation + state->m_Count;
+        snapshot->m_PreviousWorldRotation = snapshot->m_PreviousSelfRotation + state->m_Count;
+    }
+
+    if (threaded)
+    {
+        g_Pipeline->m_Running.store(true, std::memory_order_release);
+        g_Pipeline->m_SimulationThread = std::thread(SimulationThreadMain);
+    }
+
+    return true;
+}
+
+void PipelineShutdown()
+{
+    if (!g_Pipeline)
+    {
+        return;
+    }
+
+    if (g_Pipeline->m_Threaded)
+    {
+        // NOTE(sbalse): Wake the simulation thread in case it is waiting for a free slot.
+        g_Pipeline->m_Running.store(false, std::memory_order_release);
+        g_Pipeline->m_FreeSlots.release();
+        g_Pipeline->m_SimulationThread.join();
+    }
+
+    std::free(g_Pipeline->m_SnapshotMemory);
+    delete g_Pipeline;
+    g_Pipeline = nullptr;
+}
+
+const SceneSnapshot* PipelineAcquireSnapshot()
+{
+    if (!g_Pipeline->m_Threaded)
+    {
+        // NOTE(sbalse): Serial fallback: simulate right here into the only slot we use.
+        SceneSnapshot* snapshot = &g_Pipeline->m_Snapshots[0];
+        SimulateIntoSnapshot(snapshot);
+        StatsRecordPipelineLatency(ClockNow() - snapshot->m_PublishTime);
+        return snapshot;
+    }
+
+    g_Pipeline->m_FilledSlots.acquire();
+
+    const SceneSnapshot* snapshot = &g_Pipeline->m_Snapshots[g_Pipeline->m_ReadSlot];
+    g_Pipeline->m_ReadSlot = (g_Pipeline->m_ReadSlot + 1) % PIPELINE_SNAPSHOT_COUNT;
+
+    // NOTE(sbalse): How long the snapshot sat finished in the ring before the render side picked it up.
+    StatsRecordPipelineLatency(ClockNow() - snapshot->m_PublishTime);
+
+    return snapshot;
+}
+
+void PipelineReleaseSnapshot(const SceneSnapshot* /*snapshot*/)
+{
+    if (g_Pipeline->m_Threaded)
+    {
+        g_Pipeline->m_FreeSlots.release();
+    }
+}
+
+void PipelineRequestSceneSave(const char* path)
+{
+    g_Pipeline->m_SceneSave.store(PipelineSceneSave::PENDING, std::memory_order_relaxed);
+    g_Pipeline->m_SceneSavePath.store(path, std::memory_order_release);
+}
+
+PipelineSceneSave PipelineGetSceneSave()
+{
+    return g_Pipeline->m_SceneSave.load(std::memory_order_acquire);
+}
+
+void PipelineRequestRewind(const u32 steps)
+{
+    g_Pipeline->m_RewindSteps.store(steps, std::memory_order_release);
+}
+
+bool PipelineToggleRewindRecording()
+{
+    const bool recording = !g_Pipeline->m_RewindRecording.load(std::memory_order_relaxed);
+    g_Pipeline->m_RewindRecording.store(recording, std::memory_order_release);
+    return recording;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include "types.h"
+
+/*
+* NOTE(sbalse): Splits a frame into a simulation stage and a render submission stage. When threaded, the
+* simulation runs on its own thread and hands immutable snapshots of the box poses to the render side
+* through a small ring, so frame N + 1 is simulated while frame N is being submitted and presented.
+*/
+
+// NOTE(sbalse): Number of snapshots in flight. Two gives one frame of added latency; more absorbs more
+// jitter between the stages at the cost of more latency.
+constexpr u32 PIPELINE_SNAPSHOT_COUNT = 2;
+
+struct SceneSnapshot
+{
+    u64 m_FrameIndex;
+    i64 m_PublishTime; // NOTE(sbalse): Clock ticks when the simulation finished this snapshot.
+    u32 m_Count;
+    float* m_DistanceFromCenter;
+    float* m_SelfRotation;
+    float* m_WorldRotation;
+    float* m_PreviousSelfRotation;
+    float* m_PreviousWorldRotation;
+    // NOTE(sbalse): Blend factor from the previous to the current pose to render at.
+    float m_Alpha;
+};
+
+constexpr u32 PIPELINE_SNAPSHOT_STREAMS = 5; // NOTE(sbalse): Number of float arrays in SceneSnapshot.
+
+enum class PipelineSceneSave
+{
+    NONE,
+    PENDING,
+    SAVED,
+    FAILED,
+    COUNT
+};
+
+// NOTE(sbalse): The simulation runs at a fixed simulationRate steps per second, independent of the frame
+// rate, running at most maxStepsPerFrame steps to catch up before it starts dropping time.
+bool PipelineInit(const bool threaded, const double simulationRate, const u32 maxStepsPerFrame);
+void PipelineShutdown();
+// NOTE(sbalse): Render side. Blocks until the next snapshot is ready. Every acquired snapshot must be
+// released once its data has been consumed so the simulation can reuse the slot.
+const SceneSnapshot* PipelineAcquireSnapshot();
+void PipelineReleaseSnapshot(const SceneSnapshot* snapshot);
+// NOTE(sbalse): Saves the simulation state to path before the next snapshot is produced. path must stay valid
+// until then.
+void PipelineRequestSceneSave(const char* path);
+// NOTE(sbalse): Outcome of the last requested save, PENDING until the simulation side got to it.
+PipelineSceneSave PipelineGetSceneSave();
+// NOTE(sbalse): Rewinds the simulation by steps fixed steps before the next snapshot is produced. Only goes back as
+// far as recording does.
+void PipelineRequestRewind(const u32 steps);
+// NOTE(sbalse): Starts or stops recording the simulation history before the next snapshot is produced, it starts
+// off. Returns whether recording was asked for.
+bool PipelineToggleRewindRecording();
@@ -0,0 +1,364 @@
+#include "graphics/debugdraw.h"
+
+#if DEBUGDRAW_ENABLED
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <d3dcompiler.h>
+#include <malloc.h>
+
+#include "jobs.h"
+#include "stats.h"
+#include "utils.h"
+#include "graphics/resourcebackend.h"
+#include "graphics/vertex.h"
+#include "graphics/vertexinputlayout.h"
+
+namespace
+{
+    constexpr u32 DEBUGDRAW_LIST_COUNT = static_cast<u32>(DebugDrawDepth::COUNT);
+    constexpr u32 DEBUGDRAW_ARENA_MIN_VERTICES = 1024;
+
+    // NOTE(sbalse): Vertices appended by one thread, a list per depth mode. Arenas sit on their own cache lines so
+    // threads appending side by side don't share them.
+    struct alignas(64) DebugDrawArena
+    {
+        DebugDrawVertex* m_Vertices[DEBUGDRAW_LIST_COUNT];
+        u32 m_Counts[DEBUGDRAW_LIST_COUNT];
+        u32 m_Capacities[DEBUGDRAW_LIST_COUNT];
+    };
+
+    struct DebugDrawResources
+    {
+        // NOTE(sbalse): Indexed by JobsThreadIndex(), one per thread that can draw.
+        DebugDrawArena* m_Arenas;
+        u32 m_ArenaCount;
+        ResourceHandle m_VertexBuffer;
+        ResourceHandle m_ConstantBuffer;
+        ResourceHandle m_OverlayDepthStencilState;
+        ID3D11VertexShader* m_VertexShader;
+        ID3D11PixelShader* m_PixelShader;
+        ID3D11InputLayout* m_InputLayout;
+    };
+
+    struct DebugDrawConstantBuffer
+    {
+        XMMATRIX m_Projection;
+    };
+
+    constinit DebugDrawResources g_DebugDraw = {};
+
+    // NOTE(sbalse): Room for count more vertices in the calling thread's arena. Returns nullptr when the arena
+    // can't grow, the shape is dropped then.
+    DebugDrawVertex* DebugDrawReserve(const DebugDrawDepth depth, const u32 count)
+    {
+        DebugDrawArena* arena = &g_DebugDraw.m_Arenas[JobsThreadIndex()];
+        const u32 list = static_cast<u32>(depth);
+        const u32 needed = arena->m_Counts[list] + count;
+        if (needed > arena->m_Capacities[list])
+        {
+            if (needed > DEBUGDRAW_MAX_VERTICES)
+            {
+                return nullptr;
+            }
+
+            u32 capacity = arena->m_Capacities[list] ? arena->m_Capacities[list] * 2 : DEBUGDRAW_ARENA_MIN_VERTICES;
+            while (capacity < needed)
+            {
+                capacity *= 2;
+            }
+            capacity = capacity < DEBUGDRAW_MAX_VERTICES ? capacity : DEBUGDRAW_MAX_VERTICES;
+
+            DebugDrawVertex* vertices = static_cast<DebugDrawVertex*>(
+                std::realloc(arena->m_Vertices[list], capacity * sizeof(DebugDrawVertex)));
+            if (!vertices)
+            {
+                return nullptr;
+            }
+            arena->m_Vertices[list] = vertices;
+            arena->m_Capacities[list] = capacity;
+        }
+
+        DebugDrawVertex* result = arena->m_Vertices[list] + arena->m_Counts[list];
+        arena->m_Counts[list] = needed;
+        return result;
+    }
+
+    void DebugDrawSetLine(DebugDrawVertex* vertices, const float* from, const float* to, const Unorm8x4 color)
+    {
+        vertices[0] = { .m_Position = { from[0], from[1], from[2] }, .m_Color = color };
+        vertices[1] = { .m_Position = { to[0], to[1], to[2] }, .m_Color = color };
+    }
+
+    // NOTE(sbalse): The twelve edges of a box given its corners, corner i has bit 0 of i set at the far x, bit 1
+    // at the far y and bit 2 at the far z.
+    void DebugDrawBoxEdges(const float (*corners)[3], const Unorm8x4 color, const DebugDrawDepth depth)
+    {
+        constexpr u32 edges[12][2] =
+        {
+            { 0, 1 }, { 2, 3 }, { 4, 5 }, { 6, 7 },
+            { 0, 2 }, { 1, 3 }, { 4, 6 }, { 5, 7 },
+            { 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 },
+        };
+
+        DebugDrawVertex* vertices = DebugDrawReserve(depth, 24);
+        if (!vertices)
+        {
+            return;
+        }
+        for (u32 i = 0; i < 12; i++)
+        {
+            DebugDrawSetLine(vertices + (i * 2), corners[edges[i][0]], corners[edges[i][1]], color);
+        }
+    }
+} // namespace
+
+void DebugDrawInit(const DeviceResources* const deviceResources)
+{
+    g_DebugDraw.m_ArenaCount = JobsThreadCount();
+    // NOTE(sbalse): calloc only promises fundamental alignment, the arenas need their cache line alignment.
+    const size_t arenaBytes = g_DebugDraw.m_ArenaCount * sizeof(DebugDrawArena);
+    g_DebugDraw.m_Arenas = static_cast<DebugDrawArena*>(_aligned_malloc(arenaBytes, alignof(DebugDrawArena)));
+    HARDASSERT(g_DebugDraw.m_Arenas, "Failed to allocate the debug draw arenas");
+    std::memset(g_DebugDraw.m_Arenas, 0, arenaBytes);
+
+    g_DebugDraw.m_VertexBuffer = ResourceCreateBuffer(
+        deviceResources->m_Resources,
+        ResourceType::VERTEXBUFFER,
+        ResourceUsage::DYNAMIC,
+        nullptr,
+        DEBUGDRAW_MAX_VERTICES * VertexStride<DebugDrawVertex>(),
+        VertexStride<DebugDrawVertex>());
+
+    // NOTE(sbalse): The projection never changes, the constants are uploaded once.
+    const DebugDrawConstantBuffer constants =
+    {
+        .m_Projection = XMMatrixTranspose(g_ProjectionMatrix),
+    };
+    g_DebugDraw.m_ConstantBuffer = ResourceCreateBuffer(
+        deviceResources->m_Resources,
+        ResourceType::CONSTANTBUFFER,
+        ResourceUsage::IMMUTABLE,
+        &constants,
+        sizeof(constants),
+        0u);
+
+    const D3D11_DEPTH_STENCIL_DESC overlayDesc =
+    {
+        .DepthEnable = false,
+        .DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO,
+        .DepthFunc = D3D11_COMPARISON_ALWAYS,
+    };
+    g_DebugDraw.m_OverlayDepthStencilState = ResourceCreateDepthStencilState(
+        deviceResources->m_Resources,
+        &overlayDesc);
+
+    ID3DBlob* blob = nullptr;
+    DEFER(SAFE_RELEASE(blob));
+
+    HRESULT hr = D3DReadFileToBlob(L"debugdrawvertexshader.cso", &blob);
+    ValidateHRESULT(hr);
+
+    hr = deviceResources->m_Device->CreateVertexShader(
+        blob->GetBufferPointer(),
+        blob->GetBufferSize(),
+        nullptr,
+        &g_DebugDraw.m_VertexShader);
+    ValidateHRESULT(hr);
+
+    constexpr auto inputLayoutDesc = VertexInputLayout<DebugDrawVertex>();
+
+    hr = deviceResources->m_Device->CreateInputLayout(
+        inputLayoutDesc.data(),
+        static_cast<u32>(inputLayoutDesc.size()),
+        blob->GetBufferPointer(),
+        blob->GetBufferSize(),
+        &g_DebugDraw.m_InputLayout);
+    ValidateHRESULT(hr);
+
+    SAFE_RELEASE(blob);
+    hr = D3DReadFileToBlob(L"debugdrawpixelshader.cso", &blob);
+    ValidateHRESULT(hr);
+
+    hr = deviceResources->m_Device->CreatePixelShader(
+        blob->GetBufferPointer(),
+        blob->GetBufferSize(),
+        nullptr,
+        &g_DebugDraw.m_PixelShader);
+    ValidateHRESULT(hr);
+}
+
+void DebugDrawLine(const float* from, const float* to, const Unorm8x4 color, const DebugDrawDepth depth)
+{
+    DebugDrawVertex* vertices = DebugDrawReserve(depth, 2);
+    if (vertices)
+    {
+        DebugDrawSetLine(vertices, from, to, color);
+    }
+}
+
+void DebugDrawWireBox(const float* min, const float* max, const Unorm8x4 color, const DebugDrawDepth depth)
+{
+    float corners[8][3] = {};
+    for (u32 i = 0; i < 8; i++)
+    {
+        corners[i][0] = (i & 1) ? max[0] : min[0];
+        corners[i][1] = (i & 2) ? max[1] : min[1];
+        corners[i][2] = (i & 4) ? max[2] : min[2];
+    }
+    DebugDrawBoxEdges(corners, color, depth);
+}
+
+void DebugDrawSphere(const float* center, const float radius, const Unorm8x4 color, const DebugDrawDepth depth)
+{
+    DebugDrawVertex* vertices = DebugDrawReserve(depth, DEBUGDRAW_SPHERE_SEGMENTS * 6);
+    if (!vertices)
+    {
+        return;
+    }
+
+    // NOTE(sbalse): One circle around each axis.
+    for (u32 segment = 0; segment < DEBUGDRAW_SPHERE_SEGMENTS; segment++)
+    {
+        float points[2][2] = {};
+        for (u32 end = 0; end < 2; end++)
+        {
+            const float angle = static_cast<float>(segment + end) * (XM_2PI / DEBUGDRAW_SPHERE_SEGMENTS);
+            points[end][0] = std::cos(angle) * radius;
+            points[end][1] = std::sin(angle) * radius;
+        }
+
+        for (u32 axis = 0; axis < 3; axis++)
+        {
+            float line[2][3] = {};
+            for (u32 end = 0; end < 2; end++)
+            {
+                line[end][axis] = center[axis];
+                line[end][(axis + 1) % 3] = center[(axis + 1) % 3] + points[end][0];
+                line[end][(axis + 2) % 3] = center[(axis + 2) % 3] + points[end][1];
+            }
+            DebugDrawSetLine(vertices + (((axis * DEBUGDRAW_SPHERE_SEGMENTS) + segment) * 2), line[0], line[1], color);
+        }
+    }
+}
+
+void DebugDrawFrustum(const XMMATRIX* viewProjection, const Unorm8x4 color, const DebugDrawDepth depth)
+{
+    // NOTE(sbalse): The corners of clip space, depth from 0 to 1, taken back through the inverse.
+    const XMMATRIX inverse = XMMatrixInverse(nullptr, *viewProjection);
+    float corners[8][3] = {};
+    for (u32 i = 0; i < 8; i++)
+    {
+        const XMVECTOR corner = XMVector3TransformCoord(
+            XMVectorSet((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : 0.0f, 1.0f),
+            inverse);
+        corners[i][0] = XMVectorGetX(corner);
+        corners[i][1] = XMVectorGetY(corner);
+        corners[i][2] = XMVectorGetZ(corner);
+    }
+    DebugDrawBoxEdges(corners, color, depth);
+}
+
+void DebugDrawFlush(const DeviceResources* const deviceResources)
+{
+    ID3D11DeviceContext* context = deviceResources->m_DeviceContext;
+    ID3D11Buffer* vertexBuffer = ResourceGetBuffer(deviceResources->m_Resources, g_DebugDraw.m_VertexBuffer);
+
+    // NOTE(sbalse): Every arena goes into one buffer, the lists one after the other so each is one draw. What
+    // doesn't fit is dropped.
+    u32 first[DEBUGDRAW_LIST_COUNT] = {};
+    u32 counts[DEBUGDRAW_LIST_COUNT] = {};
+    u32 total = 0;
+    for (u32 list = 0; list < DEBUGDRAW_LIST_COUNT; list++)
+    {
+        first[list] = total;
+        for (u32 i = 0; i < g_DebugDraw.m_ArenaCount; i++)
+        {
+            const u32 count = g_DebugDraw.m_Arenas[i].m_Counts[list];
+            const u32 room = DEBUGDRAW_MAX_VERTICES - total - counts[list];
+            counts[list] += count < room ? count : room;
+        }
+        total += counts[list];
+    }
+
+    if (total == 0)
+    {
+        return;
+    }
+
+    D3D11_MAPPED_SUBRESOURCE mappedResource = {};
+    const HRESULT hr = context->Map(vertexBuffer, 0u, D3D11_MAP_WRITE_DISCARD, 0u, &mappedResource);
+    ValidateHRESULT(hr);
+
+    DebugDrawVertex* vertices = static_cast<DebugDrawVertex*>(mappedResource.pData);
+    for (u32 list = 0; list < DEBUGDRAW_LIST_COUNT; list++)
+    {
+        u32 written = 0;
+        for (u32 i = 0; i < g_DebugDraw.m_ArenaCount; i++)
+        {
+            DebugDrawArena* arena = &g_DebugDraw.m_Arenas[i];
+            const u32 remaining = counts[list] - written;
+            const u32 count = arena->m_Counts[list] < remaining ? arena->m_Counts[list] : remaining;
+            std::memcpy(
+                vertices + first[list] + written,
+                arena->m_Vertices[list],
+                count * sizeof(DebugDrawVertex));
+            written += count;
+            arena->m_Counts[list] = 0;
+        }
+    }
+    context->Unmap(vertexBuffer, 0u);
+
+    ID3D11Buffer* constantBuffer = ResourceGetBuffer(deviceResources->m_Resources, g_DebugDraw.m_ConstantBuffer);
+    constexpr u32 stride = VertexStride<DebugDrawVertex>();
+    constexpr u32 offset = 0u;
+    context->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_LINELIST);
+    context->IASetInputLayout(g_DebugDraw.m_InputLayout);
+    context->IASetVertexBuffers(0u, 1u, &vertexBuffer, &stride, &offset);
+    context->VSSetShader(g_DebugDraw.m_VertexShader, nullptr, 0u);
+    context->VSSetConstantBuffers(0u, 1u, &constantBuffer);
+    context->PSSetShader(g_DebugDraw.m_PixelShader, nullptr, 0u);
+
+    const ResourceHandle depthStates[DEBUGDRAW_LIST_COUNT] =
+    {
+        deviceResources->m_DepthStencilState,
+        g_DebugDraw.m_OverlayDepthStencilState,
+    };
+    for (u32 list = 0; list < DEBUGDRAW_LIST_COUNT; list++)
+    {
+        if (counts[list] == 0)
+        {
+            continue;
+        }
+
+        context->OMSetDepthStencilState(
+            ResourceGetDepthStencilState(deviceResources->m_Resources, depthStates[list]),
+            1u);
+        context->Draw(counts[list], first[list]);
+        StatsAddCounter(StatsCounter::DRAWCALLS, 1);
+    }
+    StatsAddCounter(StatsCounter::BYTESUPLOADED, total * stride);
+}
+
+void DebugDrawDestroy(const DeviceResources* const deviceResources)
+{
+    for (u32 i = 0; i < g_DebugDraw.m_ArenaCount; i++)
+    {
+        for (u32 list = 0; list < DEBUGDRAW_LIST_COUNT; list++)
+        {
+            std::free(g_DebugDraw.m_Arenas[i].m_Vertices[list]);
+        }
+    }
+    _aligned_free(g_DebugDraw.m_Arenas);
+
+    ResourceRelease(deviceResources->m_Resources, g_DebugDraw.m_OverlayDepthStencilState);
+    ResourceRelease(deviceResources->m_Resources, g_DebugDraw.m_ConstantBuffer);
+    ResourceRelease(deviceResources->m_Resources, g_DebugDraw.m_VertexBuffer);
+    SAFE_RELEASE(g_DebugDraw.m_InputLayout);
+    SAFE_RELEASE(g_DebugDraw.m_PixelShader);
+    SAFE_RELEASE(g_DebugDraw.m_VertexShader);
+    g_DebugDraw = {};
+}
+
+#endif // DEBUGDRAW_ENABLED
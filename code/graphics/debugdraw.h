@@ -0,0 +1,57 @@
+#pragma once
+
+#include "types.h"
+#include "graphics/graphicsutils.h"
+#include "graphics/quantize.h"
+
+/*
+* NOTE(sbalse): Immediate mode debug drawing of lines and wire shapes. Shapes are turned into line vertices right
+* away and appended to an arena owned by the calling thread, so job workers append without locks. Once per frame
+* DebugDrawFlush() copies every arena into one dynamic vertex buffer with a single map and draws all of it as
+* line lists, one draw call for the lines tested against the depth buffer and one for those drawn over it.
+*
+* Positions are in view space, like everything else the scene draws. Shapes may be appended from the render
+* thread and from jobs it waits on before the scene pass, not from the simulation thread.
+*
+* Release builds compile all of it out. Calls go through DEBUGDRAW(), which drops its argument unevaluated when
+* DEBUGDRAW_ENABLED is 0:
+*
+*     DEBUGDRAW(DebugDrawWireBox(min, max, color, DebugDrawDepth::TESTED));
+*/
+
+#if _DEBUG
+#define DEBUGDRAW_ENABLED 1
+#else
+#define DEBUGDRAW_ENABLED 0
+#endif // _DEBUG
+
+#if DEBUGDRAW_ENABLED
+#define DEBUGDRAW(...) __VA_ARGS__
+#else
+#define DEBUGDRAW(...)
+#endif // DEBUGDRAW_ENABLED
+
+// NOTE(sbalse): Vertices drawn per frame, appends past this are dropped.
+constexpr u32 DEBUGDRAW_MAX_VERTICES = 262144;
+constexpr u32 DEBUGDRAW_SPHERE_SEGMENTS = 24; // NOTE(sbalse): Per circle, a sphere is three circles.
+
+enum class DebugDrawDepth
+{
+    TESTED,
+    OVERLAY,
+    COUNT
+};
+
+#if DEBUGDRAW_ENABLED
+void DebugDrawInit(const DeviceResources* const deviceResources);
+void DebugDrawLine(const float* from, const float* to, const Unorm8x4 color, const DebugDrawDepth depth);
+// NOTE(sbalse): Axis aligned, min and max are opposite corners.
+void DebugDrawWireBox(const float* min, const float* max, const Unorm8x4 color, const DebugDrawDepth depth);
+void DebugDrawSphere(const float* center, const float radius, const Unorm8x4 color, const DebugDrawDepth depth);
+// NOTE(sbalse): The volume that viewProjection maps into clip space, for example g_ProjectionMatrix.
+void DebugDrawFrustum(const XMMATRIX* viewProjection, const Unorm8x4 color, const DebugDrawDepth depth);
+// NOTE(sbalse): Draws everything appended since the last flush and empties the arenas. Binds its own pipeline,
+// the caller rebinds whatever it draws next.
+void DebugDrawFlush(const DeviceResources* const deviceResources);
+void DebugDrawDestroy(const DeviceResources* const deviceResources);
+#endif // DEBUGDRAW_ENABLED
@@ -0,0 +1,113 @@
+#include "graphics/dynamicresolution.h"
+
+#include <cmath>
+
+namespace
+{
+    float DynamicResolutionClamp(const float value, const float min, const float max)
+    {
+        return value < min ? min : (value > max ? max : value);
+    }
+
+    float DynamicResolutionQuantize(const DynamicResolution* resolution, const float scale)
+    {
+        const DynamicResolutionSettings* settings = &resolution->m_Settings;
+        const float quantized = std::floor(scale / settings->m_ScaleStep + 0.5f) * settings->m_ScaleStep;
+        return DynamicResolutionClamp(quantized, settings->m_MinScale, settings->m_MaxScale);
+    }
+}
+
+void DynamicResolutionInit(DynamicResolution* resolution, const DynamicResolutionSettings* settings)
+{
+    *resolution =
+    {
+        .m_Settings = *settings,
+        .m_Scale = 0.0f,
+        .m_SmoothedMs = 0.0f,
+        .m_IntegralError = 0.0f,
+        .m_PreviousError = 0.0f,
+        .m_FramesSinceChange = 0,
+        .m_Changes = 0,
+    };
+    resolution->m_Scale = DynamicResolutionQuantize(resolution, settings->m_MaxScale);
+}
+
+float DynamicResolutionUpdate(DynamicResolution* resolution, const float frameMs)
+{
+    const DynamicResolutionSettings* settings = &resolution->m_Settings;
+
+    resolution->m_SmoothedMs = resolution->m_SmoothedMs == 0.0f
+        ? frameMs
+        : resolution->m_SmoothedMs + (frameMs - resolution->m_SmoothedMs) * settings->m_Smoothing;
+    resolution->m_FramesSinceChange++;
+
+    // NOTE(sbalse): Positive when there is time to spare.
+    const float error = (settings->m_BudgetMs - resolution->m_SmoothedMs) / settings->m_BudgetMs;
+    const float derivative = error - resolution->m_PreviousError;
+    resolution->m_PreviousError = error;
+
+    if (std::fabs(error) < settings->m_DeadBand)
+    {
+        return resolution->m_Scale;
+    }
+
+    // NOTE(sbalse): Don't wind up against a bound we can't move past.
+    const bool saturated = (error > 0.0f && resolution->m_Scale >= settings->m_MaxScale)
+        || (error < 0.0f && resolution->m_Scale <= settings->m_MinScale);
+    if (!saturated)
+    {
+        resolution->m_IntegralError = DynamicResolutionClamp(
+            resolution->m_IntegralError + error,
+            -settings->m_IntegralLimit,
+            settings->m_IntegralLimit);
+    }
+
+    const float output = settings->m_Proportional * error
+        + settings->m_Integral * resolution->m_IntegralError
+        + settings->m_Derivative * derivative;
+
+    // NOTE(sbalse): The output is a relative change in area, never more than halving or doubling it at once.
+    const float areaFactor = DynamicResolutionClamp(1.0f + output, 0.5f, 2.0f);
+    float scale = DynamicResolutionQuantize(resolution, resolution->m_Scale * std::sqrt(areaFactor));
+
+    // NOTE(sbalse): Only go up as far as the frame is predicted to stay below the dead band, otherwise the next
+    // frames would just bring us back down.
+    const float increaseLimitMs = settings->m_BudgetMs * (1.0f - settings->m_DeadBand);
+    while (scale > resolution->m_Scale)
+    {
+        const float ratio = scale / resolution->m_Scale;
+        if (resolution->m_SmoothedMs * ratio * ratio <= increaseLimitMs)
+        {
+            break;
+        }
+        scale = DynamicResolutionQuantize(resolution, scale - settings->m_ScaleStep);
+    }
+
+    const u32 holdFrames = scale > resolution->m_Scale
+        ? settings->m_IncreaseHoldFrames
+        : settings->m_DecreaseHoldFrames;
+    if (scale == resolution->m_Scale || resolution->m_FramesSinceChange < holdFrames)
+    {
+        return resolution->m_Scale;
+    }
+
+    // NOTE(sbalse): The new scale changes what the frame time means, the accumulated error is used up.
+    resolution->m_Scale = scale;
+    resolution->m_IntegralError = 0.0f;
+    resolution->m_FramesSinceChange = 0;
+    resolution->m_Changes++;
+    return resolution->m_Scale;
+}
+
+void DynamicResolutionGetSize(
+    const DynamicResolution* resolution,
+    const u32 fullWidth,
+    const u32 fullHeight,
+    u32* width,
+    u32* height)
+{
+    const u32 scaledWidth = static_cast<u32>(static_cast<float>(fullWidth) * resolution->m_Scale + 0.5f);
+    const u32 scaledHeight = static_cast<u32>(static_cast<float>(fullHeight) * resolution->m_Scale + 0.5f);
+    *width = scaledWidth > 0 ? (scaledWidth < fullWidth ? scaledWidth : fullWidth) : 1;
+    *height = scaledHeight > 0 ? (scaledHeight < fullHeight ? scaledHeight : fullHeight) : 1;
+}
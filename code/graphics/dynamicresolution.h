@@ -0,0 +1,70 @@
+#pragma once
+#include "types.h"
+
+/*
+* NOTE(sbalse): Picks the resolution scale the scene is rendered at so the frame fits a time budget. The scene
+* is rendered into the top left part of a full size target and stretched over the back buffer.
+*
+* A PID controller runs on the relative error between the budget and a smoothed frame time. Rendering cost
+* follows the pixel count, so the controller output is taken as a change in area and the scale moves by its
+* square root. Against oscillation:
+*   - Errors inside a dead band are ignored.
+*   - The applied scale only moves in steps of m_ScaleStep.
+*   - After a change the scale is held for a number of frames, longer before going up than before going
+*     down, so an overloaded frame is answered quickly and headroom has to last before it is spent.
+* Everything is plain float math on the values passed in, the same trace always gives the same scales.
+*/
+
+struct DynamicResolutionSettings
+{
+    float m_BudgetMs;
+    float m_MinScale;
+    float m_MaxScale;
+    float m_ScaleStep;
+    float m_DeadBand; // NOTE(sbalse): Relative to the budget.
+    float m_Smoothing; // NOTE(sbalse): Weight of the newest frame in the smoothed frame time.
+    float m_Proportional;
+    float m_Integral;
+    float m_Derivative;
+    float m_IntegralLimit;
+    u32 m_DecreaseHoldFrames;
+    u32 m_IncreaseHoldFrames;
+};
+
+constexpr DynamicResolutionSettings DYNAMICRESOLUTION_DEFAULT_SETTINGS =
+{
+    .m_BudgetMs = 15.0f,
+    .m_MinScale = 0.5f,
+    .m_MaxScale = 1.0f,
+    .m_ScaleStep = 1.0f / 32.0f,
+    .m_DeadBand = 0.05f,
+    .m_Smoothing = 0.2f,
+    .m_Proportional = 0.8f,
+    .m_Integral = 0.05f,
+    .m_Derivative = 0.1f,
+    .m_IntegralLimit = 4.0f,
+    .m_DecreaseHoldFrames = 4,
+    .m_IncreaseHoldFrames = 30,
+};
+
+struct DynamicResolution
+{
+    DynamicResolutionSettings m_Settings;
+    float m_Scale; // NOTE(sbalse): Applied scale of both dimensions, a multiple of m_ScaleStep.
+    float m_SmoothedMs;
+    float m_IntegralError;
+    float m_PreviousError;
+    u32 m_FramesSinceChange;
+    u32 m_Changes;
+};
+
+void DynamicResolutionInit(DynamicResolution* resolution, const DynamicResolutionSettings* settings);
+// NOTE(sbalse): Feeds the time of the last frame without idle waits, returns the scale to render the next one at.
+float DynamicResolutionUpdate(DynamicResolution* resolution, const float frameMs);
+// NOTE(sbalse): Size of the scaled part of a fullWidth x fullHeight target, at least one pixel.
+void DynamicResolutionGetSize(
+    const DynamicResolution* resolution,
+    const u32 fullWidth,
+    const u32 fullHeight,
+    u32* width,
+    u32* height);
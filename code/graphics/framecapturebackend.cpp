@@ -0,0 +1,95 @@
+#include "graphics/framecapturebackend.h"
+
+#include "graphics/graphicsutils.h"
+
+namespace
+{
+    bool FrameCaptureD3D11Copy(void* context, const u32 slot)
+    {
+        FrameCaptureD3D11Source* source = static_cast<FrameCaptureD3D11Source*>(context);
+        source->m_DeviceContext->CopyResource(source->m_Staging[slot], source->m_Texture);
+        return true;
+    }
+
+    // NOTE(sbalse): Never stalls, a copy the GPU hasn't finished yet is tried again next frame.
+    bool FrameCaptureD3D11Map(void* context, const u32 slot, const u8** pixels, u32* pitch)
+    {
+        FrameCaptureD3D11Source* source = static_cast<FrameCaptureD3D11Source*>(context);
+        D3D11_MAPPED_SUBRESOURCE mapped = {};
+        const HRESULT hr = source->m_DeviceContext->Map(
+            source->m_Staging[slot],
+            0u,
+            D3D11_MAP_READ,
+            D3D11_MAP_FLAG_DO_NOT_WAIT,
+            &mapped);
+        if (FAILED(hr))
+        {
+            return false;
+        }
+
+        *pixels = static_cast<const u8*>(mapped.pData);
+        *pitch = mapped.RowPitch;
+        return true;
+    }
+
+    void FrameCaptureD3D11Unmap(void* context, const u32 slot)
+    {
+        FrameCaptureD3D11Source* source = static_cast<FrameCaptureD3D11Source*>(context);
+        source->m_DeviceContext->Unmap(source->m_Staging[slot], 0u);
+    }
+} // namespace
+
+bool FrameCaptureD3D11Init(
+    FrameCaptureD3D11Source* source,
+    ID3D11Device* device,
+    ID3D11DeviceContext* deviceContext,
+    ID3D11Texture2D* texture,
+    const u32 slotCount)
+{
+    HARDASSERT(slotCount <= FRAMECAPTURE_MAX_SLOTS, "Too many frame capture slots");
+
+    *source = {};
+    source->m_DeviceContext = deviceContext;
+    source->m_Texture = texture;
+    source->m_Texture->AddRef();
+
+    D3D11_TEXTURE2D_DESC stagingDesc = {};
+    texture->GetDesc(&stagingDesc);
+    stagingDesc.MipLevels = 1u;
+    stagingDesc.ArraySize = 1u;
+    stagingDesc.Usage = D3D11_USAGE_STAGING;
+    stagingDesc.BindFlags = 0u;
+    stagingDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+    stagingDesc.MiscFlags = 0u;
+
+    for (u32 slot = 0; slot < slotCount; slot++)
+    {
+        if (FAILED(device->CreateTexture2D(&stagingDesc, nullptr, &source->m_Staging[slot])))
+        {
+            FrameCaptureD3D11Destroy(source);
+            return false;
+        }
+    }
+    return true;
+}
+
+void FrameCaptureD3D11Destroy(FrameCaptureD3D11Source* source)
+{
+    for (ID3D11Texture2D*& staging : source->m_Staging)
+    {
+        SAFE_RELEASE(staging);
+    }
+    SAFE_RELEASE(source->m_Texture);
+}
+
+FrameCaptureBackend FrameCaptureD3D11Backend(FrameCaptureD3D11Source* source)
+{
+    const FrameCaptureBackend result =
+    {
+        .m_Context = source,
+        .m_Copy = FrameCaptureD3D11Copy,
+        .m_Map = FrameCaptureD3D11Map,
+        .m_Unmap = FrameCaptureD3D11Unmap,
+    };
+    return result;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <d3d11.h>
+
+#include "types.h"
+#include "framecapture.h"
+
+// NOTE(sbalse): Reads a D3D11 texture back through a staging texture per slot. Copies are queued on the device
+// context, so the backend is used from the thread that renders.
+struct FrameCaptureD3D11Source
+{
+    ID3D11DeviceContext* m_DeviceContext;
+    ID3D11Texture2D* m_Texture;
+    ID3D11Texture2D* m_Staging[FRAMECAPTURE_MAX_SLOTS];
+};
+
+// NOTE(sbalse): Holds a reference to texture. Returns false when the staging textures can't be created.
+bool FrameCaptureD3D11Init(
+    FrameCaptureD3D11Source* source,
+    ID3D11Device* device,
+    ID3D11DeviceContext* deviceContext,
+    ID3D11Texture2D* texture,
+    const u32 slotCount);
+void FrameCaptureD3D11Destroy(FrameCaptureD3D11Source* source);
+FrameCaptureBackend FrameCaptureD3D11Backend(FrameCaptureD3D11Source* source);
@@ -1,20 +1,37 @@
 #include "graphics.h"
 
 #include <cmath>
-#include <random>
+#include <initializer_list>
 #include "cleanwindows.h"
 #include <d3d11.h>
 #include <d3dcompiler.h>
 #include <DirectXMath.h>
 
 #include "asserts.h"
+#include "clock.h"
+#include "deferredwork.h"
+#include "framecapture.h"
 #include "input.h"
 #include "mathutils.h"
+#include "particles.h"
+#include "stats.h"
+#include "taskgraph.h"
 #include "window.h"
 #include "utils.h"
+#include "graphics/debugdraw.h"
+#include "graphics/dynamicresolution.h"
+#include "graphics/framecapturebackend.h"
+#include "graphics/hud.h"
+#include "graphics/particlerenderer.h"
+#include "graphics/rendergraph.h"
+#include "graphics/rendergraphbackend.h"
+#include "graphics/resourcebackend.h"
+#include "graphics/resourcepool.h"
 #include "graphics/rotatingbox.h"
 #include "graphics/graphicsutils.h"
+#include "graphics/upscale.h"
 #include "graphics/vertex.h"
+#include "graphics/vertexinputlayout.h"
 
 using namespace DirectX;
 
@@ -25,101 +42,322 @@ namespace
     // NOTE(sbalse): The main window.
     constinit Window g_Window = {};
 
-    void InitDeviceAndSwapChain();
-    void InitDepthStencilAndRenderTargetView();
-    void InitShaders();
+    constinit bool g_ShowStatsOverlay = true;
 
-    void GraphicsClearBuffer(const float r, const float g, const float b);
+    constinit u32 g_PresentSyncInterval = 1;
+
+    // NOTE(sbalse): Upper bound on live and retired resources in the pool.
+    constexpr u32 GRAPHICS_MAX_RESOURCES = 4096;
+    // NOTE(sbalse): Retired resources are destroyed in the time left at the end of frames, this many at a time.
+    constexpr u32 GRAPHICS_RELEASES_PER_CHUNK = 16;
+    constinit u32 g_ReleaseResourcesItem = DEFERRED_INVALID_ITEM;
+
+    // NOTE(sbalse): Rebuilt every frame. The back buffer is imported, the depth buffer is a transient.
+    constinit RenderGraph* g_RenderGraph = nullptr;
+    constinit RenderGraphTarget g_BackBufferTarget = {};
+
+    // NOTE(sbalse): Particle effects are purely visual, they advance with the frame rather than the simulation.
+    constexpr u32 GRAPHICS_MAX_PARTICLES = 262144;
+    constexpr float GRAPHICS_PARTICLE_SIZE = 0.06f;
+    constexpr float GRAPHICS_MAX_PARTICLE_STEP = 0.1f; // NOTE(sbalse): Seconds, so a stall doesn't fling them away.
+    constexpr ParticleEmitterDesc g_FountainDesc =
+    {
+        .m_Position = { 0.0f, -6.0f, 20.0f },
+        .m_Velocity = { 0.0f, 9.0f, 0.0f },
+        .m_VelocitySpread = { 2.5f, 1.5f, 2.5f },
+        .m_LifetimeMin = 1.5f,
+        .m_LifetimeMax = 3.0f,
+        .m_Rate = 50'000.0f,
+        .m_Color = QuantizeColor(1.0f, 0.55f, 0.15f, 1.0f),
+        .m_Seed = 0x70617274,
+    };
+    constexpr ParticleForces g_ParticleForces =
+    {
+        .m_Gravity = { 0.0f, -9.8f, 0.0f },
+        .m_Drag = 0.4f,
+    };
+    constinit ParticleEmitter* g_Emitters[1] = {};
+    constinit i64 g_LastParticleUpdate = 0;
+
+    // NOTE(sbalse): Picks the size the scene is rendered at from the time the previous frame took.
+    constinit DynamicResolution g_DynamicResolution = {};
+
+    // NOTE(sbalse): Captures every presented frame while running. Frames are read back a couple of frames late so
+    // the copies never stall the GPU.
+    constexpr u32 GRAPHICS_CAPTURE_SLOTS = 4;
+    constexpr u32 GRAPHICS_CAPTURE_LATENCY = 2;
+    constinit FrameCaptureD3D11Source g_FrameCaptureSource = {};
+    constinit FrameCapture* g_FrameCapture = nullptr;
+
+    struct ScenePassData
+    {
+        RenderGraphResource m_Color;
+        RenderGraphResource m_Depth;
+        u32 m_Width; // NOTE(sbalse): Rendered part of the targets, the top left corner.
+        u32 m_Height;
+    };
+
+    struct UpscalePassData
+    {
+        RenderGraphResource m_SceneColor;
+        RenderGraphResource m_BackBuffer;
+        u32 m_SceneWidth;
+        u32 m_SceneHeight;
+        u32 m_Width;
+        u32 m_Height;
+    };
+
+    struct HudPassData
+    {
+        RenderGraphResource m_BackBuffer;
+    };
+
+    // NOTE(sbalse): Compiled shaders, read from disk while the device is still being created.
+    constinit ID3DBlob* g_VertexShaderBlob = nullptr;
+    constinit ID3DBlob* g_PixelShaderBlob = nullptr;
+
+    bool InitWindow(void* context);
+    bool InitDeviceAndSwapChain(void* context);
+    bool InitResourcePool(void* context);
+    bool InitDepthStencilAndRenderTargetView(void* context);
+    bool InitRenderGraph(void* context);
+    bool ReadShaders(void* context);
+    bool InitShaders(void* context);
+    bool InitHud(void* context);
+    bool InitUpscale(void* context);
+    bool InitParticles(void* context);
+    bool InitDebugDraw(void* context);
+    bool InitBoxes(void* context);
+    bool ShowMainWindow(void* context);
+
+    DeferredResult ReleaseResources(void* context);
+
+    void BindScenePipeline();
+    void GraphicsClearBuffer(
+        const RenderGraphTarget* color,
+        const RenderGraphTarget* depth,
+        const float r,
+        const float g,
+        const float b);
+    void GraphicsSetViewport(const u32 width, const u32 height);
+    void ExecuteScenePass(const RenderGraph* graph, void* userData);
+    void ExecuteUpscalePass(const RenderGraph* graph, void* userData);
+    void ExecuteHudPass(const RenderGraph* graph, void* userData);
 } // namespace
 
 constexpr int g_TotalNumberOfBoxes = 40;
 constinit RotatingBox g_Boxes[g_TotalNumberOfBoxes] = {};
 
-bool GraphicsInit()
+u32 GraphicsAddInitTasks(TaskGraph* graph)
 {
-    constexpr int windowWidth = 1280;
-    constexpr int windowHeight = 720;
-    constexpr LPCWSTR windowTitle = L"HW3D Engine";
+    // NOTE(sbalse): The window and everything touching the immediate context stay on the main thread. Reading
+    // the shaders only needs the file system, so it overlaps with creating the window and the device.
+    const auto add = [graph](const char* name, const TaskFunction function, const TaskAffinity affinity,
+        std::initializer_list<u32> dependencies)
+    {
+        return TaskGraphAdd(
+            graph,
+            name,
+            function,
+            nullptr,
+            affinity,
+            dependencies.begin(),
+            static_cast<u32>(dependencies.size()));
+    };
+
+    const u32 window = add("Window", InitWindow, TaskAffinity::MAIN, {});
+    const u32 readShaders = add("ReadShaders", ReadShaders, TaskAffinity::ANY, {});
+    const u32 device = add("Device", InitDeviceAndSwapChain, TaskAffinity::MAIN, { window });
+    const u32 resourcePool = add("ResourcePool", InitResourcePool, TaskAffinity::MAIN, { device });
+    const u32 renderTargets =
+        add("RenderTargets", InitDepthStencilAndRenderTargetView, TaskAffinity::MAIN, { resourcePool });
+    const u32 renderGraph = add("RenderGraph", InitRenderGraph, TaskAffinity::MAIN, { device });
+    const u32 shaders = add("Shaders", InitShaders, TaskAffinity::MAIN, { device, readShaders });
+    const u32 hud = add("Hud", InitHud, TaskAffinity::MAIN, { device });
+    const u32 upscale = add("Upscale", InitUpscale, TaskAffinity::MAIN, { resourcePool });
+    const u32 particles = add("Particles", InitParticles, TaskAffinity::MAIN, { device });
+    const u32 boxes = add("Boxes", InitBoxes, TaskAffinity::MAIN, { resourcePool });
+    const u32 debugDraw = add("DebugDraw", InitDebugDraw, TaskAffinity::MAIN, { resourcePool });
+    return add(
+        "ShowWindow",
+        ShowMainWindow,
+        TaskAffinity::MAIN,
+        { renderTargets, renderGraph, shaders, hud, upscale, particles, boxes, debugDraw });
+}
 
-    if (!g_Window.Init(windowWidth, windowHeight, windowTitle))
+void GraphicsRunFrame(const SceneSnapshot* const snapshot)
+{
+    // NOTE(sbalse): The time the pacer spent waiting is headroom, not cost, so it isn't counted. Neither is the
+    // deferred work, which only ever fills headroom.
+    const StatsSummary* summary = StatsGetSummary();
+    if (summary->m_FrameIndex > 0)
     {
-        // TODO(sbalse): Logging
-        return false;
+        DynamicResolutionUpdate(
+            &g_DynamicResolution,
+            summary->m_FrameTimeMs
+                - summary->m_StageTimeMs[static_cast<u32>(StatsStage::PACE)]
+                - summary->m_StageTimeMs[static_cast<u32>(StatsStage::DEFERRED)]);
     }
 
-    InitDeviceAndSwapChain();
+    // NOTE(sbalse): Upload the box transforms of this frame's snapshot.
+    StatsBeginStage(StatsStage::UPDATE);
+    UpdateRotatingBoxes(g_Boxes, g_TotalNumberOfBoxes, snapshot, &g_DeviceResources);
+
+    const i64 now = ClockNow();
+    const float particleStep = static_cast<float>(ClockTicksToSeconds(now - g_LastParticleUpdate));
+    g_LastParticleUpdate = now;
+    for (ParticleEmitter* emitter : g_Emitters)
+    {
+        ParticleEmitterUpdate(
+            emitter,
+            &g_ParticleForces,
+            particleStep < GRAPHICS_MAX_PARTICLE_STEP ? particleStep : GRAPHICS_MAX_PARTICLE_STEP);
+    }
 
-    InitDepthStencilAndRenderTargetView();
+    // NOTE(sbalse): Marks where the fountain spawns its particles.
+    DEBUGDRAW(DebugDrawSphere(
+        g_FountainDesc.m_Position,
+        0.25f,
+        QuantizeColor(0.2f, 1.0f, 0.2f, 1.0f),
+        DebugDrawDepth::OVERLAY));
+    StatsEndStage(StatsStage::UPDATE);
 
-    InitShaders();
+    StatsBeginStage(StatsStage::DRAW);
 
-    // Init all cube positions
-    std::random_device rd;
-    std::mt19937 rng(rd());
-    std::uniform_real_distribution<float> randomBoxPosDistribution(6.0f, 20.0f);
-    std::uniform_real_distribution<float> randomBoxWorldRotation(0.0f, 3.1415f * 2.0f);
-    std::uniform_real_distribution<float> randomBoxSelfRotationSpeed(0.01f, 0.04f);
-    std::uniform_real_distribution<float> randomBoxWorldRotationSpeed(0.001f, 0.005f);
+    // NOTE(sbalse): Declare this frame's passes.
+    RenderGraphReset(g_RenderGraph);
 
-    for (int i = 0; i < g_TotalNumberOfBoxes; i++)
+    const u32 width = static_cast<u32>(g_Window.GetWidth());
+    const u32 height = static_cast<u32>(g_Window.GetHeight());
+    const RenderGraphTextureDesc backBufferDesc =
     {
-        const float distFromCenterOfWorld = randomBoxPosDistribution(rng);
-        const float worldRot = randomBoxWorldRotation(rng);
-        const float selfRotSpeed = randomBoxSelfRotationSpeed(rng);
-        const float worldRotSpeed = randomBoxWorldRotationSpeed(rng);
-
-        g_Boxes[i] = CreateRotatingBox(
-            distFromCenterOfWorld,
-            0.0f,
-            selfRotSpeed,
-            worldRot,
-            worldRotSpeed,
-            &g_DeviceResources);
-    }
-
-    g_Window.Show();
+        .m_Width = width,
+        .m_Height = height,
+        .m_Format = RenderGraphFormat::BGRA8_UNORM,
+        .m_BindFlags = RENDERGRAPH_BIND_RENDERTARGET,
+    };
 
-    return true;
-}
+    const RenderGraphResource backBuffer = RenderGraphImportTexture(
+        g_RenderGraph,
+        "BACKBUFFER",
+        &backBufferDesc,
+        &g_BackBufferTarget,
+        RenderGraphUsage::PRESENT,
+        RenderGraphUsage::PRESENT);
+
+    u32 sceneWidth = width;
+    u32 sceneHeight = height;
+    DynamicResolutionGetSize(&g_DynamicResolution, width, height, &sceneWidth, &sceneHeight);
+    const bool scaled = sceneWidth != width || sceneHeight != height;
+
+    // NOTE(sbalse): A scaled scene goes into the corner of a full size target, so changing the scale never
+    // creates new textures. At full scale it is drawn straight into the back buffer.
+    ScenePassData scenePass =
+    {
+        .m_Color = scaled
+            ? RenderGraphCreateTexture(g_RenderGraph, "SCENECOLOR", width, height, RenderGraphFormat::RGBA8_UNORM)
+            : backBuffer,
+        .m_Depth = RenderGraphCreateTexture(g_RenderGraph, "DEPTH", width, height, RenderGraphFormat::D32_FLOAT),
+        .m_Width = sceneWidth,
+        .m_Height = sceneHeight,
+    };
 
-void GraphicsRunFrame()
-{
-    //static float i = 0;
-    //const float color = std::sinf(i) / 2.0f + 0.5f;
-    //constexpr float cauliflowerBlue[] = { 0.588f, 0.745f, 0.827f };
-    constexpr float color = 0.0f;
+    const u32 scene = RenderGraphAddPass(g_RenderGraph, "SCENE", ExecuteScenePass, &scenePass);
+    RenderGraphUse(g_RenderGraph, scene, scenePass.m_Color, RenderGraphUsage::RENDERTARGET);
+    RenderGraphUse(g_RenderGraph, scene, scenePass.m_Depth, RenderGraphUsage::DEPTHWRITE);
 
-    GraphicsClearBuffer(color, color, color);
+    UpscalePassData upscalePass =
+    {
+        .m_SceneColor = scenePass.m_Color,
+        .m_BackBuffer = backBuffer,
+        .m_SceneWidth = sceneWidth,
+        .m_SceneHeight = sceneHeight,
+        .m_Width = width,
+        .m_Height = height,
+    };
 
-    //i = PingPong(i, 0.0f, 10.0f, 0.02f); // NOTE(sbalse): Oscillate value between min and max.
+    if (scaled)
+    {
+        const u32 upscale = RenderGraphAddPass(g_RenderGraph, "UPSCALE", ExecuteUpscalePass, &upscalePass);
+        RenderGraphUse(g_RenderGraph, upscale, upscalePass.m_SceneColor, RenderGraphUsage::SHADERREAD);
+        RenderGraphUse(g_RenderGraph, upscale, upscalePass.m_BackBuffer, RenderGraphUsage::RENDERTARGET);
+    }
 
-    // NOTE(sbalse): Rotate boxes
-    UpdateRotatingBoxes(g_Boxes, g_TotalNumberOfBoxes, &g_DeviceResources);
+    HudPassData hudPass =
+    {
+        .m_BackBuffer = backBuffer,
+    };
 
-    // NOTE(sbalse): Draw boxes
-    for (int j = 0; j < g_TotalNumberOfBoxes; j++)
+    if (g_ShowStatsOverlay)
     {
-        DrawRotatingBox(&g_Boxes[j], &g_DeviceResources);
+        const u32 hud = RenderGraphAddPass(g_RenderGraph, "HUD", ExecuteHudPass, &hudPass);
+        RenderGraphUse(g_RenderGraph, hud, hudPass.m_BackBuffer, RenderGraphUsage::RENDERTARGET);
     }
+
+    const bool compiled = RenderGraphCompile(g_RenderGraph);
+    HARDASSERT(compiled, "Failed to compile the render graph");
+
+    RenderGraphExecute(g_RenderGraph);
+
+    StatsEndStage(StatsStage::DRAW);
 }
 
 bool GraphicsEndFrame()
 {
-    g_DeviceResources.m_SwapChain->Present(1, 0);
+    // NOTE(sbalse): The swap chain discards the back buffer when presenting, the copy is queued before that.
+    if (g_FrameCapture && !FrameCaptureUpdate(g_FrameCapture, true))
+    {
+        StatsAddCounter(StatsCounter::CAPTUREDROPPED, 1);
+    }
+
+    StatsBeginStage(StatsStage::PRESENT);
+    g_DeviceResources.m_SwapChain->Present(g_PresentSyncInterval, 0);
+    StatsEndStage(StatsStage::PRESENT);
+
+    // NOTE(sbalse): Resources released this frame become due for destruction once the GPU can no longer be using
+    // them. ReleaseResources() destroys them later in the frame's leftover time.
+    ResourcePoolEndFrame(g_DeviceResources.m_Resources);
 
     return g_Window.IsRunning();
 }
 
 void GraphicsDestroy()
 {
+    if (g_FrameCapture)
+    {
+        GraphicsToggleCapture(nullptr);
+    }
+
     for (int j = 0; j < g_TotalNumberOfBoxes; j++)
     {
-        DestroyRotatingBox(&g_Boxes[j]);
+        DestroyRotatingBox(&g_Boxes[j], &g_DeviceResources);
     }
 
+    UpscaleDestroy(&g_DeviceResources);
+    ParticleRendererDestroy();
+    DEBUGDRAW(DebugDrawDestroy(&g_DeviceResources));
+    for (ParticleEmitter*& emitter : g_Emitters)
+    {
+        ParticleEmitterDestroy(emitter);
+        emitter = nullptr;
+    }
+    HudDestroy(&g_DeviceResources);
+
     g_DeviceResources.m_DeviceContext->ClearState();
 
-    SAFE_RELEASE(g_DeviceResources.m_DepthStencilView);
+    RenderGraphDestroy(g_RenderGraph);
+    g_RenderGraph = nullptr;
+
+    DeferredCancel(g_ReleaseResourcesItem);
+    g_ReleaseResourcesItem = DEFERRED_INVALID_ITEM;
+
+    ResourceRelease(g_DeviceResources.m_Resources, g_DeviceResources.m_DepthStencilState);
+    ResourcePoolDestroy(g_DeviceResources.m_Resources);
+    g_DeviceResources.m_Resources = nullptr;
+
+    SAFE_RELEASE(g_DeviceResources.m_InputLayout);
+    SAFE_RELEASE(g_DeviceResources.m_PixelShader);
+    SAFE_RELEASE(g_DeviceResources.m_VertexShader);
     SAFE_RELEASE(g_DeviceResources.m_RenderTargetView);
     SAFE_RELEASE(g_DeviceResources.m_DeviceContext);
     SAFE_RELEASE(g_DeviceResources.m_SwapChain);
@@ -131,11 +369,104 @@ void GraphicsProcessWindowsMessages()
     g_Window.ProcessMessages();
 }
 
+void GraphicsToggleStatsOverlay()
+{
+    g_ShowStatsOverlay = !g_ShowStatsOverlay;
+}
+
+int GraphicsObjectCount()
+{
+    return g_TotalNumberOfBoxes;
+}
+
+bool GraphicsWindowHasFocus()
+{
+    return g_Window.IsFocused();
+}
+
+void GraphicsWaitForWindowMessages()
+{
+    g_Window.WaitForMessages();
+}
+
+bool GraphicsToggleCapture(const char* path)
+{
+    if (g_FrameCapture)
+    {
+        FrameCaptureDestroy(g_FrameCapture);
+        g_FrameCapture = nullptr;
+        FrameCaptureD3D11Destroy(&g_FrameCaptureSource);
+        return false;
+    }
+
+    ID3D11Texture2D* backBuffer = nullptr;
+    DEFER(SAFE_RELEASE(backBuffer));
+
+    const HRESULT hr = g_DeviceResources.m_SwapChain->GetBuffer(0, IID_PPV_ARGS(&backBuffer));
+    ValidateHRESULT(hr);
+
+    D3D11_TEXTURE2D_DESC backBufferDesc = {};
+    backBuffer->GetDesc(&backBufferDesc);
+    if (!FrameCaptureD3D11Init(
+        &g_FrameCaptureSource,
+        g_DeviceResources.m_Device,
+        g_DeviceResources.m_DeviceContext,
+        backBuffer,
+        GRAPHICS_CAPTURE_SLOTS))
+    {
+        return false;
+    }
+
+    const FrameCaptureDesc captureDesc =
+    {
+        .m_Path = path,
+        .m_Width = backBufferDesc.Width,
+        .m_Height = backBufferDesc.Height,
+        .m_Format = FrameCaptureFormat::BGRA8,
+        .m_SlotCount = GRAPHICS_CAPTURE_SLOTS,
+        .m_Latency = GRAPHICS_CAPTURE_LATENCY,
+    };
+    const FrameCaptureBackend backend = FrameCaptureD3D11Backend(&g_FrameCaptureSource);
+    g_FrameCapture = FrameCaptureCreate(&captureDesc, &backend);
+    if (!g_FrameCapture)
+    {
+        FrameCaptureD3D11Destroy(&g_FrameCaptureSource);
+    }
+    return g_FrameCapture != nullptr;
+}
+
+void GraphicsSetVSync(const bool enabled)
+{
+    g_PresentSyncInterval = enabled ? 1 : 0;
+}
+
+void GraphicsSetFrameBudget(const float budgetMs)
+{
+    DynamicResolutionSettings settings = DYNAMICRESOLUTION_DEFAULT_SETTINGS;
+    settings.m_BudgetMs = budgetMs;
+    DynamicResolutionInit(&g_DynamicResolution, &settings);
+}
+
+const DynamicResolution* GraphicsGetDynamicResolution()
+{
+    return &g_DynamicResolution;
+}
+
 namespace
 {
 namespace dx = DirectX;
 
-void InitDeviceAndSwapChain()
+bool InitWindow(void* /*context*/)
+{
+    constexpr int windowWidth = 1280;
+    constexpr int windowHeight = 720;
+    constexpr LPCWSTR windowTitle = L"HW3D Engine";
+
+    // TODO(sbalse): Logging
+    return g_Window.Init(windowWidth, windowHeight, windowTitle);
+}
+
+bool InitDeviceAndSwapChain(void* /*context*/)
 {
     DXGI_SWAP_CHAIN_DESC swapChainDescription =
     {
@@ -186,9 +517,33 @@ void InitDeviceAndSwapChain()
         &g_DeviceResources.m_DeviceContext         // get the device context
     );
     ValidateHRESULT(hr);
+    return SUCCEEDED(hr);
 }
 
-void InitDepthStencilAndRenderTargetView()
+bool InitResourcePool(void* /*context*/)
+{
+    const ResourceBackend resourceBackend = ResourceD3D11Backend(g_DeviceResources.m_Device);
+    g_DeviceResources.m_Resources = ResourcePoolCreate(&resourceBackend, GRAPHICS_MAX_RESOURCES);
+    if (!g_DeviceResources.m_Resources)
+    {
+        // TODO(sbalse): Logging
+        return false;
+    }
+
+    g_ReleaseResourcesItem = DeferredSubmit("ReleaseResources", ReleaseResources, nullptr, DeferredPriority::NORMAL);
+    return g_ReleaseResourcesItem != DEFERRED_INVALID_ITEM;
+}
+
+bool InitRenderGraph(void* /*context*/)
+{
+    const RenderGraphBackend renderGraphBackend = RenderGraphD3D11Backend(&g_DeviceResources);
+    g_RenderGraph = RenderGraphCreate(&renderGraphBackend);
+
+    // TODO(sbalse): Logging
+    return g_RenderGraph != nullptr;
+}
+
+bool InitDepthStencilAndRenderTargetView(void* /*context*/)
 {
     // NOTE(sbalse): Get the back buffer of the swap chain
     ID3D11Resource* backBuffer = nullptr;
@@ -204,7 +559,9 @@ void InitDepthStencilAndRenderTargetView()
         &g_DeviceResources.m_RenderTargetView);
     ValidateHRESULT(hr);
 
-    // NOTE(sbalse): Create depth stencil state.
+    g_BackBufferTarget.m_RenderTargetView = g_DeviceResources.m_RenderTargetView;
+
+    // NOTE(sbalse): Create depth stencil state. The depth buffer itself is a transient of the render graph.
     D3D11_DEPTH_STENCIL_DESC depthStencilDesc =
     {
         .DepthEnable = true,
@@ -212,152 +569,242 @@ void InitDepthStencilAndRenderTargetView()
         .DepthFunc = D3D11_COMPARISON_LESS
     };
 
-    ID3D11DepthStencilState* depthStencilState = nullptr;
-    DEFER(SAFE_RELEASE(depthStencilState));
-
-    hr = g_DeviceResources.m_Device->CreateDepthStencilState(&depthStencilDesc, &depthStencilState);
-    ValidateHRESULT(hr);
+    g_DeviceResources.m_DepthStencilState = ResourceCreateDepthStencilState(
+        g_DeviceResources.m_Resources,
+        &depthStencilDesc);
 
     // NOTE(sbalse): Bind depth state.
-    g_DeviceResources.m_DeviceContext->OMSetDepthStencilState(depthStencilState, 1u);
-
-    // NOTE(sbalse): Create depth stencil texture.
-    ID3D11Texture2D* depthStencil = nullptr;
-    DEFER(SAFE_RELEASE(depthStencil));
+    g_DeviceResources.m_DeviceContext->OMSetDepthStencilState(
+        ResourceGetDepthStencilState(g_DeviceResources.m_Resources, g_DeviceResources.m_DepthStencilState),
+        1u);
 
-    D3D11_TEXTURE2D_DESC depthDesc =
-    {
-        .Width = static_cast<u32>(g_Window.GetWidth()),
-        .Height = static_cast<u32>(g_Window.GetHeight()),
-        .MipLevels = 1u,
-        .ArraySize = 1u,
-        .Format = DXGI_FORMAT_D32_FLOAT,
-        .SampleDesc =
-        {
-            .Count = 1u,
-            .Quality = 0u,
-        },
-        .Usage = D3D11_USAGE_DEFAULT,
-        .BindFlags = D3D11_BIND_DEPTH_STENCIL,
-    };
+    // NOTE(sbalse): The viewport is set by every pass, the scene is rendered at a different size than the rest.
+    return true;
+}
 
-    hr = g_DeviceResources.m_Device->CreateTexture2D(&depthDesc, nullptr, &depthStencil);
-    HARDASSERT(depthStencil, "Failed to create a depth stencil texture");
+bool ReadShaders(void* /*context*/)
+{
+    HRESULT hr = D3DReadFileToBlob(L"vertexshader.cso", &g_VertexShaderBlob);
     ValidateHRESULT(hr);
 
-    // NOTE(sbalse): Create view of depth stencil texture.
-    D3D11_DEPTH_STENCIL_VIEW_DESC depthStencilViewDesc =
-    {
-        .Format = DXGI_FORMAT_D32_FLOAT,
-        .ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D,
-        .Texture2D =
-        {
-            .MipSlice = 0u,
-        },
-    };
-
-    hr = g_DeviceResources.m_Device->CreateDepthStencilView(
-        depthStencil,
-        &depthStencilViewDesc,
-        &g_DeviceResources.m_DepthStencilView);
+    hr = D3DReadFileToBlob(L"pixelshader.cso", &g_PixelShaderBlob);
     ValidateHRESULT(hr);
 
-    // NOTE(sbalse): Bind depth stencil view to OM.
-    g_DeviceResources.m_DeviceContext->OMSetRenderTargets(
-        1u,
-        &g_DeviceResources.m_RenderTargetView,
-        g_DeviceResources.m_DepthStencilView);
-
-    // Configure viewport
-    D3D11_VIEWPORT viewport =
-    {
-        .TopLeftX = 0,
-        .TopLeftY = 0,
-        .Width = static_cast<float>(g_Window.GetWidth()),
-        .Height = static_cast<float>(g_Window.GetHeight()),
-        .MinDepth = 0,
-        .MaxDepth = 1
-    };
-    g_DeviceResources.m_DeviceContext->RSSetViewports(1u, &viewport);
+    return SUCCEEDED(hr);
 }
 
-void InitShaders()
+bool InitShaders(void* /*context*/)
 {
-    ID3DBlob* blob = nullptr;
-    DEFER(SAFE_RELEASE(blob));
+    ID3DBlob* blob = g_VertexShaderBlob;
+    DEFER(SAFE_RELEASE(g_VertexShaderBlob));
+    DEFER(SAFE_RELEASE(g_PixelShaderBlob));
 
     // NOTE(sbalse): Create vertex shader
-    ID3D11VertexShader* vertexShader = nullptr;
-    DEFER(SAFE_RELEASE(vertexShader));
-
-    HRESULT hr = D3DReadFileToBlob(L"vertexshader.cso", &blob);
-    ValidateHRESULT(hr);
-
-    hr = g_DeviceResources.m_Device->CreateVertexShader(
+    HRESULT hr = g_DeviceResources.m_Device->CreateVertexShader(
         blob->GetBufferPointer(),
         blob->GetBufferSize(),
         nullptr,
-        &vertexShader
+        &g_DeviceResources.m_VertexShader
     );
     ValidateHRESULT(hr);
 
-    g_DeviceResources.m_DeviceContext->VSSetShader(vertexShader, nullptr, 0u);
+    g_DeviceResources.m_DeviceContext->VSSetShader(g_DeviceResources.m_VertexShader, nullptr, 0u);
 
     // NOTE(sbalse): Create Input Layout
-    ID3D11InputLayout* inputLayout = nullptr;
-    DEFER(SAFE_RELEASE(inputLayout));
-
-    const D3D11_INPUT_ELEMENT_DESC inputLayoutDesc[] =
-    {
-        {
-            .SemanticName = "Position",
-            .SemanticIndex = 0,
-            .Format = DXGI_FORMAT_R32G32B32_FLOAT,
-            .InputSlot = 0,
-            .AlignedByteOffset = 0,
-            .InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA,
-            .InstanceDataStepRate = 0
-        },
-    };
+    constexpr auto inputLayoutDesc = VertexInputLayout<Vertex>();
 
     hr = g_DeviceResources.m_Device->CreateInputLayout(
-        inputLayoutDesc,
-        static_cast<u32>(ArraySize(inputLayoutDesc)),
+        inputLayoutDesc.data(),
+        static_cast<u32>(inputLayoutDesc.size()),
         blob->GetBufferPointer(),
         blob->GetBufferSize(),
-        &inputLayout
+        &g_DeviceResources.m_InputLayout
     );
     ValidateHRESULT(hr);
 
     // NOTE(sbalse): Bind vertex layout
-    g_DeviceResources.m_DeviceContext->IASetInputLayout(inputLayout);
+    g_DeviceResources.m_DeviceContext->IASetInputLayout(g_DeviceResources.m_InputLayout);
 
     // NOTE(sbalse): Create pixel shader
-    ID3D11PixelShader* pixelShader = nullptr;
-    DEFER(SAFE_RELEASE(pixelShader));
-
-    hr = D3DReadFileToBlob(L"pixelshader.cso", &blob);
-    ValidateHRESULT(hr);
-
+    blob = g_PixelShaderBlob;
     hr = g_DeviceResources.m_Device->CreatePixelShader(
         blob->GetBufferPointer(),
         blob->GetBufferSize(),
         nullptr,
-        &pixelShader
+        &g_DeviceResources.m_PixelShader
     );
     ValidateHRESULT(hr);
 
-    g_DeviceResources.m_DeviceContext->PSSetShader(pixelShader, nullptr, 0u);
+    g_DeviceResources.m_DeviceContext->PSSetShader(g_DeviceResources.m_PixelShader, nullptr, 0u);
+
+    return true;
+}
+
+bool InitHud(void* /*context*/)
+{
+    HudInit(&g_DeviceResources);
+    return true;
+}
+
+bool InitUpscale(void* /*context*/)
+{
+    DynamicResolutionInit(&g_DynamicResolution, &DYNAMICRESOLUTION_DEFAULT_SETTINGS);
+    UpscaleInit(&g_DeviceResources);
+    return true;
+}
+
+bool InitParticles(void* /*context*/)
+{
+    ParticleRendererInit(&g_DeviceResources, GRAPHICS_MAX_PARTICLES);
+    for (ParticleEmitter*& emitter : g_Emitters)
+    {
+        emitter = ParticleEmitterCreate(
+            &g_FountainDesc,
+            GRAPHICS_MAX_PARTICLES / static_cast<u32>(ArraySize(g_Emitters)));
+        if (!emitter)
+        {
+            return false;
+        }
+    }
+    g_LastParticleUpdate = ClockNow();
+    return true;
+}
+
+bool InitDebugDraw(void* /*context*/)
+{
+    DEBUGDRAW(DebugDrawInit(&g_DeviceResources));
+    return true;
+}
+
+bool InitBoxes(void* /*context*/)
+{
+    // NOTE(sbalse): Box placement and motion is owned by the simulation, here we only create the GPU side.
+    for (int i = 0; i < g_TotalNumberOfBoxes; i++)
+    {
+        g_Boxes[i] = CreateRotatingBox(&g_DeviceResources);
+    }
+    return true;
+}
+
+bool ShowMainWindow(void* /*context*/)
+{
+    g_Window.Show();
+    return true;
+}
+
+DeferredResult ReleaseResources(void* /*context*/)
+{
+    const bool moreDue = ResourcePoolCollect(g_DeviceResources.m_Resources, GRAPHICS_RELEASES_PER_CHUNK);
+    return moreDue ? DeferredResult::MORE : DeferredResult::IDLE;
+}
+
+void BindScenePipeline()
+{
+    g_DeviceResources.m_DeviceContext->IASetInputLayout(g_DeviceResources.m_InputLayout);
+    g_DeviceResources.m_DeviceContext->VSSetShader(g_DeviceResources.m_VertexShader, nullptr, 0u);
+    g_DeviceResources.m_DeviceContext->PSSetShader(g_DeviceResources.m_PixelShader, nullptr, 0u);
+    g_DeviceResources.m_DeviceContext->OMSetDepthStencilState(
+        ResourceGetDepthStencilState(g_DeviceResources.m_Resources, g_DeviceResources.m_DepthStencilState),
+        1u);
+}
+
+void GraphicsClearBuffer(
+    const RenderGraphTarget* color,
+    const RenderGraphTarget* depth,
+    const float r,
+    const float g,
+    const float b)
+{
+    const float clearColor[] = { r, g, b, 1.0f };
+    g_DeviceResources.m_DeviceContext->ClearRenderTargetView(color->m_RenderTargetView, clearColor);
+    g_DeviceResources.m_DeviceContext->ClearDepthStencilView(depth->m_DepthStencilView, D3D11_CLEAR_DEPTH, 1.0f, 0u);
+}
+
+void GraphicsSetViewport(const u32 width, const u32 height)
+{
+    const D3D11_VIEWPORT viewport =
+    {
+        .TopLeftX = 0,
+        .TopLeftY = 0,
+        .Width = static_cast<float>(width),
+        .Height = static_cast<float>(height),
+        .MinDepth = 0,
+        .MaxDepth = 1
+    };
+    g_DeviceResources.m_DeviceContext->RSSetViewports(1u, &viewport);
+}
+
+void ExecuteScenePass(const RenderGraph* graph, void* userData)
+{
+    const ScenePassData* data = static_cast<const ScenePassData*>(userData);
+    const RenderGraphTarget* color = RenderGraphGetTarget(graph, data->m_Color);
+    const RenderGraphTarget* depth = RenderGraphGetTarget(graph, data->m_Depth);
+
+    g_DeviceResources.m_DeviceContext->OMSetRenderTargets(1u, &color->m_RenderTargetView, depth->m_DepthStencilView);
+    GraphicsSetViewport(data->m_Width, data->m_Height);
+
+    //static float i = 0;
+    //const float color = std::sinf(i) / 2.0f + 0.5f;
+    //constexpr float cauliflowerBlue[] = { 0.588f, 0.745f, 0.827f };
+    constexpr float clearColor = 0.0f;
+
+    // NOTE(sbalse): The depth buffer may share memory with other transients, it is always cleared.
+    GraphicsClearBuffer(color, depth, clearColor, clearColor, clearColor);
+
+    BindScenePipeline();
+
+    //i = PingPong(time, 0.0f, 10.0f, 1.2f); // NOTE(sbalse): Oscillate value between min and max.
+
+    // NOTE(sbalse): Draw boxes
+    for (int j = 0; j < g_TotalNumberOfBoxes; j++)
+    {
+        DrawRotatingBox(&g_Boxes[j], &g_DeviceResources);
+    }
+    StatsAddCounter(StatsCounter::VISIBLEOBJECTS, g_TotalNumberOfBoxes);
+
+    // NOTE(sbalse): Every emitter in one draw call.
+    ParticleRendererDraw(
+        g_Emitters,
+        static_cast<u32>(ArraySize(g_Emitters)),
+        GRAPHICS_PARTICLE_SIZE,
+        &g_DeviceResources);
+
+    // NOTE(sbalse): Everything appended this frame, at most two draw calls.
+    DEBUGDRAW(DebugDrawFlush(&g_DeviceResources));
+}
+
+void ExecuteUpscalePass(const RenderGraph* graph, void* userData)
+{
+    const UpscalePassData* data = static_cast<const UpscalePassData*>(userData);
+    const RenderGraphTarget* source = RenderGraphGetTarget(graph, data->m_SceneColor);
+    const RenderGraphTarget* color = RenderGraphGetTarget(graph, data->m_BackBuffer);
+
+    g_DeviceResources.m_DeviceContext->OMSetRenderTargets(1u, &color->m_RenderTargetView, nullptr);
+    GraphicsSetViewport(data->m_Width, data->m_Height);
+
+    UpscaleDraw(
+        source->m_ShaderResourceView,
+        data->m_SceneWidth,
+        data->m_SceneHeight,
+        data->m_Width,
+        data->m_Height,
+        &g_DeviceResources);
 }
 
-void GraphicsClearBuffer(const float r, const float g, const float b)
+void ExecuteHudPass(const RenderGraph* graph, void* userData)
 {
-    const float color[] = { r, g, b, 1.0f };
-    g_DeviceResources.m_DeviceContext->ClearRenderTargetView(g_DeviceResources.m_RenderTargetView, color);
-    g_DeviceResources.m_DeviceContext->ClearDepthStencilView(
-        g_DeviceResources.m_DepthStencilView,
-        D3D11_CLEAR_DEPTH,
-        1.0f,
-        0u);
+    const HudPassData* data = static_cast<const HudPassData*>(userData);
+    const RenderGraphTarget* color = RenderGraphGetTarget(graph, data->m_BackBuffer);
+
+    g_DeviceResources.m_DeviceContext->OMSetRenderTargets(1u, &color->m_RenderTargetView, nullptr);
+    GraphicsSetViewport(static_cast<u32>(g_Window.GetWidth()), static_cast<u32>(g_Window.GetHeight()));
+
+    HudDraw(
+        StatsGetSummary(),
+        RenderGraphGetStats(graph),
+        &g_DynamicResolution,
+        g_Window.GetWidth(),
+        g_Window.GetHeight(),
+        &g_DeviceResources);
 }
 } // namespace
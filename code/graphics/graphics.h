@@ -5,8 +5,28 @@
 
 using namespace DirectX;
 
-bool GraphicsInit();
-void GraphicsRunFrame();
+#include "types.h"
+
+struct DynamicResolution;
+struct SceneSnapshot;
+struct TaskGraph;
+
+// NOTE(sbalse): Adds the tasks that initialize graphics. Returns the last one, which shows the window once
+// everything else is ready.
+u32 GraphicsAddInitTasks(TaskGraph* graph);
+void GraphicsRunFrame(const SceneSnapshot* const snapshot);
 bool GraphicsEndFrame();
 void GraphicsProcessWindowsMessages();
+void GraphicsToggleStatsOverlay();
+int GraphicsObjectCount();
+bool GraphicsWindowHasFocus();
+void GraphicsWaitForWindowMessages();
+// NOTE(sbalse): Starts capturing every presented frame to path, or stops a running capture. Returns whether a
+// capture is running now.
+bool GraphicsToggleCapture(const char* path);
+// NOTE(sbalse): Turn off when something else, like the frame pacer, decides when frames are presented.
+void GraphicsSetVSync(const bool enabled);
+// NOTE(sbalse): Time a frame may take without idle waits. The scene resolution is scaled down to stay below it.
+void GraphicsSetFrameBudget(const float budgetMs);
+const DynamicResolution* GraphicsGetDynamicResolution();
 void GraphicsDestroy();
@@ -2,6 +2,7 @@
 #include <d3d11.h>
 #include <DirectXMath.h>
 #include "asserts.h"
+#include "graphics/resourcepool.h"
 
 using namespace DirectX;
 
@@ -28,7 +29,13 @@ struct DeviceResources
     ID3D11DeviceContext* m_DeviceContext;
     IDXGISwapChain* m_SwapChain;
     ID3D11RenderTargetView* m_RenderTargetView;
-    ID3D11DepthStencilView* m_DepthStencilView;
+    // NOTE(sbalse): Buffers and states are created through the pool, see resourcepool.h.
+    ResourcePool* m_Resources;
+    // NOTE(sbalse): Scene pipeline state. Kept around so it can be rebound after the overlay draws.
+    ResourceHandle m_DepthStencilState;
+    ID3D11VertexShader* m_VertexShader;
+    ID3D11PixelShader* m_PixelShader;
+    ID3D11InputLayout* m_InputLayout;
 };
 
 // NOTE(sbalse): The projection matrix used for all transformations.
@@ -0,0 +1,453 @@
+#include "graphics/hud.h"
+
+#include <cstring>
+#include <format>
+#include <d3dcompiler.h>
+
+#include "deferredwork.h"
+#include "framepacer.h"
+#include "stats.h"
+#include "types.h"
+#include "utils.h"
+#include "graphics/dynamicresolution.h"
+#include "graphics/graphicsutils.h"
+#include "graphics/rendergraph.h"
+#include "graphics/resourcebackend.h"
+#include "graphics/vertex.h"
+#include "graphics/vertexinputlayout.h"
+
+namespace
+{
+    struct HudResources
+    {
+        ID3D11Buffer* m_VertexBuffer;
+        ID3D11VertexShader* m_VertexShader;
+        ID3D11PixelShader* m_PixelShader;
+        ID3D11InputLayout* m_InputLayout;
+        ResourceHandle m_DepthStencilState;
+    };
+
+    // NOTE(sbalse): Every lit run of font pixels becomes one quad of two triangles.
+    constexpr u32 HUD_MAX_QUADS = 4096;
+    constexpr u32 HUD_MAX_VERTICES = HUD_MAX_QUADS * 6;
+    constexpr u32 HUD_MAX_LINES = 12;
+    constexpr u32 HUD_MAX_LINE_LENGTH = 96;
+    constexpr u32 HUD_STAGES_PER_LINE = 4;
+
+    constexpr int HUD_PIXEL_SCALE = 3; // NOTE(sbalse): Screen pixels per font pixel.
+    constexpr int HUD_GLYPH_WIDTH = 3;
+    constexpr int HUD_GLYPH_HEIGHT = 5;
+    constexpr int HUD_ADVANCE = (HUD_GLYPH_WIDTH + 1) * HUD_PIXEL_SCALE;
+    constexpr int HUD_LINE_HEIGHT = (HUD_GLYPH_HEIGHT + 2) * HUD_PIXEL_SCALE;
+    constexpr int HUD_MARGIN = 8;
+
+    constexpr u32 HUD_TEXT_COLOR = 0xFF00FF00; // NOTE(sbalse): Opaque green.
+    constexpr u32 HUD_PANEL_COLOR = 0xFF202020;
+
+    struct Glyph
+    {
+        char m_Char;
+        // NOTE(sbalse): One entry per row, top to bottom. Bit 2 is the leftmost pixel.
+        u8 m_Rows[HUD_GLYPH_HEIGHT];
+    };
+
+    constexpr Glyph g_Font[] =
+    {
+        { '0', { 0b111, 0b101, 0b101, 0b101, 0b111 } },
+        { '1', { 0b010, 0b110, 0b010, 0b010, 0b111 } },
+        { '2', { 0b111, 0b001, 0b111, 0b100, 0b111 } },
+        { '3', { 0b111, 0b001, 0b111, 0b001, 0b111 } },
+        { '4', { 0b101, 0b101, 0b111, 0b001, 0b001 } },
+        { '5', { 0b111, 0b100, 0b111, 0b001, 0b111 } },
+        { '6', { 0b111, 0b100, 0b111, 0b101, 0b111 } },
+        { '7', { 0b111, 0b001, 0b001, 0b001, 0b001 } },
+        { '8', { 0b111, 0b101, 0b111, 0b101, 0b111 } },
+        { '9', { 0b111, 0b101, 0b111, 0b001, 0b111 } },
+        { 'A', { 0b010, 0b101, 0b111, 0b101, 0b101 } },
+        { 'B', { 0b110, 0b101, 0b110, 0b101, 0b110 } },
+        { 'C', { 0b011, 0b100, 0b100, 0b100, 0b011 } },
+        { 'D', { 0b110, 0b101, 0b101, 0b101, 0b110 } },
+        { 'E', { 0b111, 0b100, 0b110, 0b100, 0b111 } },
+        { 'F', { 0b111, 0b100, 0b110, 0b100, 0b100 } },
+        { 'G', { 0b011, 0b100, 0b101, 0b101, 0b011 } },
+        { 'H', { 0b101, 0b101, 0b111, 0b101, 0b101 } },
+        { 'I', { 0b111, 0b010, 0b010, 0b010, 0b111 } },
+        { 'J', { 0b001, 0b001, 0b001, 0b101, 0b010 } },
+        { 'K', { 0b101, 0b101, 0b110, 0b101, 0b101 } },
+        { 'L', { 0b100, 0b100, 0b100, 0b100, 0b111 } },
+        { 'M', { 0b101, 0b111, 0b111, 0b101, 0b101 } },
+        { 'N', { 0b110, 0b101, 0b101, 0b101, 0b101 } },
+        { 'O', { 0b010, 0b101, 0b101, 0b101, 0b010 } },
+        { 'P', { 0b110, 0b101, 0b110, 0b100, 0b100 } },
+        { 'Q', { 0b010, 0b101, 0b101, 0b110, 0b011 } },
+        { 'R', { 0b110, 0b101, 0b110, 0b101, 0b101 } },
+        { 'S', { 0b011, 0b100, 0b010, 0b001, 0b110 } },
+        { 'T', { 0b111, 0b010, 0b010, 0b010, 0b010 } },
+        { 'U', { 0b101, 0b101, 0b101, 0b101, 0b111 } },
+        { 'V', { 0b101, 0b101, 0b101, 0b101, 0b010 } },
+        { 'W', { 0b101, 0b101, 0b111, 0b111, 0b101 } },
+        { 'X', { 0b101, 0b101, 0b010, 0b101, 0b101 } },
+        { 'Y', { 0b101, 0b101, 0b010, 0b010, 0b010 } },
+        { 'Z', { 0b111, 0b001, 0b010, 0b100, 0b111 } },
+        { '.', { 0b000, 0b000, 0b000, 0b000, 0b010 } },
+        { ':', { 0b000, 0b010, 0b000, 0b010, 0b000 } },
+        { '-', { 0b000, 0b000, 0b111, 0b000, 0b000 } },
+        { '/', { 0b001, 0b001, 0b010, 0b100, 0b100 } },
+        { '%', { 0b101, 0b001, 0b010, 0b100, 0b101 } },
+    };
+
+    // NOTE(sbalse): Maps an ASCII character to its index in g_Font, or -1 when it has no glyph.
+    constexpr auto g_GlyphLookup = []()
+    {
+        struct { i8 m_Index[128]; } result = {};
+        for (int i = 0; i < 128; i++)
+        {
+            result.m_Index[i] = -1;
+        }
+        for (size_t i = 0; i < ArraySize(g_Font); i++)
+        {
+            result.m_Index[static_cast<u8>(g_Font[i].m_Char)] = static_cast<i8>(i);
+        }
+        return result;
+    }();
+
+    constinit HudResources g_Hud = {};
+
+    // NOTE(sbalse): CPU side staging of the overlay geometry, uploaded with a single map each frame.
+    constinit HudVertex g_HudVertices[HUD_MAX_VERTICES] = {};
+    constinit u32 g_HudVertexCount = 0;
+
+    void PushQuad(
+        const int x,
+        const int y,
+        const int width,
+        const int height,
+        const u32 color,
+        const int screenWidth,
+        const int screenHeight)
+    {
+        if (g_HudVertexCount + 6 > HUD_MAX_VERTICES)
+        {
+            return;
+        }
+
+        // NOTE(sbalse): Pixel coordinates (origin top left) to clip space.
+        const float left = (static_cast<float>(x) / static_cast<float>(screenWidth)) * 2.0f - 1.0f;
+        const float right = (static_cast<float>(x + width) / static_cast<float>(screenWidth)) * 2.0f - 1.0f;
+        const float top = 1.0f - (static_cast<float>(y) / static_cast<float>(screenHeight)) * 2.0f;
+        const float bottom = 1.0f - (static_cast<float>(y + height) / static_cast<float>(screenHeight)) * 2.0f;
+
+        const Snorm16x2 topLeft = { QuantizeSnorm16(left), QuantizeSnorm16(top) };
+        const Snorm16x2 topRight = { QuantizeSnorm16(right), QuantizeSnorm16(top) };
+        const Snorm16x2 bottomLeft = { QuantizeSnorm16(left), QuantizeSnorm16(bottom) };
+        const Snorm16x2 bottomRight = { QuantizeSnorm16(right), QuantizeSnorm16(bottom) };
+
+        HudVertex* v = &g_HudVertices[g_HudVertexCount];
+        v[0] = { topLeft, { color } };
+        v[1] = { topRight, { color } };
+        v[2] = { bottomLeft, { color } };
+        v[3] = { topRight, { color } };
+        v[4] = { bottomRight, { color } };
+        v[5] = { bottomLeft, { color } };
+        g_HudVertexCount += 6;
+    }
+
+    void PushText(
+        const char* text,
+        const int x,
+        const int y,
+        const u32 color,
+        const int screenWidth,
+        const int screenHeight)
+    {
+        int penX = x;
+        for (const char* c = text; *c; c++, penX += HUD_ADVANCE)
+        {
+            const u8 ascii = static_cast<u8>(*c);
+            const i8 glyphIndex = ascii < 128 ? g_GlyphLookup.m_Index[ascii] : -1;
+            if (glyphIndex < 0)
+            {
+                continue;
+            }
+
+            const Glyph& glyph = g_Font[glyphIndex];
+            for (int row = 0; row < HUD_GLYPH_HEIGHT; row++)
+            {
+                // NOTE(sbalse): Merge horizontal runs of lit pixels into a single quad.
+                int column = 0;
+                while (column < HUD_GLYPH_WIDTH)
+                {
+                    const bool lit = glyph.m_Rows[row] & (1 << (HUD_GLYPH_WIDTH - 1 - column));
+                    if (!lit)
+                    {
+                        column++;
+                        continue;
+                    }
+
+                    const int runStart = column;
+                    while (column < HUD_GLYPH_WIDTH && (glyph.m_Rows[row] & (1 << (HUD_GLYPH_WIDTH - 1 - column))))
+                    {
+                        column++;
+                    }
+
+                    PushQuad(
+                        penX + runStart * HUD_PIXEL_SCALE,
+                        y + row * HUD_PIXEL_SCALE,
+                        (column - runStart) * HUD_PIXEL_SCALE,
+                        HUD_PIXEL_SCALE,
+                        color,
+                        screenWidth,
+                        screenHeight);
+                }
+            }
+        }
+    }
+} // namespace
+
+void HudInit(const DeviceResources* const deviceResources)
+{
+    const D3D11_BUFFER_DESC vertexBufferDesc =
+    {
+        .ByteWidth = sizeof(g_HudVertices),
+        .Usage = D3D11_USAGE_DYNAMIC,
+        .BindFlags = D3D11_BIND_VERTEX_BUFFER,
+        .CPUAccessFlags = D3D11_CPU_ACCESS_WRITE,
+        .MiscFlags = 0u,
+        .StructureByteStride = VertexStride<HudVertex>(),
+    };
+
+    HRESULT hr = deviceResources->m_Device->CreateBuffer(&vertexBufferDesc, nullptr, &g_Hud.m_VertexBuffer);
+    ValidateHRESULT(hr);
+
+    ID3DBlob* blob = nullptr;
+    DEFER(SAFE_RELEASE(blob));
+
+    hr = D3DReadFileToBlob(L"hudvertexshader.cso", &blob);
+    ValidateHRESULT(hr);
+
+    hr = deviceResources->m_Device->CreateVertexShader(
+        blob->GetBufferPointer(),
+        blob->GetBufferSize(),
+        nullptr,
+        &g_Hud.m_VertexShader);
+    ValidateHRESULT(hr);
+
+    constexpr auto inputLayoutDesc = VertexInputLayout<HudVertex>();
+
+    hr = deviceResources->m_Device->CreateInputLayout(
+        inputLayoutDesc.data(),
+        static_cast<u32>(inputLayoutDesc.size()),
+        blob->GetBufferPointer(),
+        blob->GetBufferSize(),
+        &g_Hud.m_InputLayout);
+    ValidateHRESULT(hr);
+
+    SAFE_RELEASE(blob);
+    hr = D3DReadFileToBlob(L"hudpixelshader.cso", &blob);
+    ValidateHRESULT(hr);
+
+    hr = deviceResources->m_Device->CreatePixelShader(
+        blob->GetBufferPointer(),
+        blob->GetBufferSize(),
+        nullptr,
+        &g_Hud.m_PixelShader);
+    ValidateHRESULT(hr);
+
+    // NOTE(sbalse): The overlay is always drawn on top of the scene.
+    const D3D11_DEPTH_STENCIL_DESC depthStencilDesc =
+    {
+        .DepthEnable = false,
+        .DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO,
+        .DepthFunc = D3D11_COMPARISON_ALWAYS
+    };
+
+    g_Hud.m_DepthStencilState = ResourceCreateDepthStencilState(deviceResources->m_Resources, &depthStencilDesc);
+}
+
+void HudDraw(
+    const StatsSummary* const summary,
+    const RenderGraphStats* const renderGraph,
+    const DynamicResolution* const resolution,
+    const int screenWidth,
+    const int screenHeight,
+    const DeviceResources* const deviceResources)
+{
+    char lines[HUD_MAX_LINES][HUD_MAX_LINE_LENGTH] = {};
+    u32 lineCount = 0;
+
+    std::format_to_n(
+        lines[lineCount++], HUD_MAX_LINE_LENGTH - 1,
+        "FRAME {:.2f} MS  AVG {:.2f}  P50 {:.2f}  P99 {:.2f}",
+        summary->m_FrameTimeMs,
+        summary->m_FrameTimeMeanMs,
+        summary->m_FrameTimeP50Ms,
+        summary->m_FrameTimeP99Ms);
+
+    // NOTE(sbalse): Mean stage times, a few stages per line.
+    for (u32 stage = 0; stage < NUMSTATSSTAGES; stage += HUD_STAGES_PER_LINE)
+    {
+        char* cursor = lines[lineCount];
+        char* const end = lines[lineCount] + HUD_MAX_LINE_LENGTH - 1;
+        for (u32 i = stage; i < stage + HUD_STAGES_PER_LINE && i < NUMSTATSSTAGES; i++)
+        {
+            cursor = std::format_to_n(
+                cursor, end - cursor,
+                "{} {:.2f}  ",
+                StatsStageName(static_cast<StatsStage>(i)),
+                summary->m_StageTimeMeanMs[i]).out;
+        }
+        lineCount++;
+    }
+
+    std::format_to_n(
+        lines[lineCount++], HUD_MAX_LINE_LENGTH - 1,
+        "PIPELINE LATENCY {:.2f} MS  P99 {:.2f}",
+        summary->m_PipelineLatencyMeanMs,
+        summary->m_PipelineLatencyP99Ms);
+
+    const PacerReport* pacer = PacerGetReport();
+    std::format_to_n(
+        lines[lineCount++], HUD_MAX_LINE_LENGTH - 1,
+        "PACING {:.2f} MS {}  LATE {:.0f} US  P99 {:.0f} US  SLEPT {:.0f}%",
+        pacer->m_TargetFrameTimeMs,
+        pacer->m_IsBackground ? "BACKGROUND" : "FOCUSED",
+        pacer->m_WakeErrorMeanUs,
+        pacer->m_WakeErrorP99Us,
+        pacer->m_SleepFraction * 100.0f);
+
+    const DeferredStats* deferred = DeferredGetStats();
+    std::format_to_n(
+        lines[lineCount++], HUD_MAX_LINE_LENGTH - 1,
+        "DEFERRED {:.2f}/{:.2f} MS  CHUNKS {}  ITEMS {}  STARVED {}  WAIT {}",
+        deferred->m_UsedMs,
+        deferred->m_BudgetMs,
+        deferred->m_Chunks,
+        deferred->m_Items,
+        deferred->m_StarvedItems,
+        deferred->m_MaxWaitFrames);
+
+    std::format_to_n(
+        lines[lineCount++], HUD_MAX_LINE_LENGTH - 1,
+        "SIM STEPS {}  DROPPED {}  OVERLAPS {}",
+        summary->m_Counters[static_cast<u32>(StatsCounter::SIMSTEPS)],
+        summary->m_Counters[static_cast<u32>(StatsCounter::SIMSTEPSDROPPED)],
+        summary->m_Counters[static_cast<u32>(StatsCounter::OVERLAPS)]);
+
+    std::format_to_n(
+        lines[lineCount++], HUD_MAX_LINE_LENGTH - 1,
+        "DRAWS {}  OBJECTS {}  PARTICLES {}  UPLOAD {:.1f} KB",
+        summary->m_Counters[static_cast<u32>(StatsCounter::DRAWCALLS)],
+        summary->m_Counters[static_cast<u32>(StatsCounter::VISIBLEOBJECTS)],
+        summary->m_Counters[static_cast<u32>(StatsCounter::PARTICLES)],
+        static_cast<float>(summary->m_Counters[static_cast<u32>(StatsCounter::BYTESUPLOADED)]) / 1024.0f);
+
+    ResourcePoolStats resources = {};
+    ResourcePoolGetStats(deviceResources->m_Resources, &resources);
+    std::format_to_n(
+        lines[lineCount++], HUD_MAX_LINE_LENGTH - 1,
+        "RESOURCES {}  {:.1f} KB  SHARED {}  SAVED {:.1f} KB  PENDING {}",
+        resources.m_LiveResources,
+        static_cast<float>(resources.m_LiveBufferBytes) / 1024.0f,
+        resources.m_SharedReferences,
+        static_cast<float>(resources.m_BufferBytesSaved) / 1024.0f,
+        resources.m_PendingDestroys);
+
+    std::format_to_n(
+        lines[lineCount++], HUD_MAX_LINE_LENGTH - 1,
+        "GRAPH PASSES {}  CULLED {}  TARGETS {}/{}  ALIASED {:.1f} MB  COMPILE {:.1f} US",
+        renderGraph->m_ExecutedPasses,
+        renderGraph->m_CulledPasses,
+        renderGraph->m_PhysicalTextures,
+        renderGraph->m_TransientTextures,
+        static_cast<float>(renderGraph->m_AliasedBytesSaved) / (1024.0f * 1024.0f),
+        renderGraph->m_CompileTimeUs);
+
+    u32 sceneWidth = 0;
+    u32 sceneHeight = 0;
+    DynamicResolutionGetSize(
+        resolution,
+        static_cast<u32>(screenWidth),
+        static_cast<u32>(screenHeight),
+        &sceneWidth,
+        &sceneHeight);
+    std::format_to_n(
+        lines[lineCount++], HUD_MAX_LINE_LENGTH - 1,
+        "RESOLUTION {:.0f}%  {}x{}  BUDGET {:.2f} MS  SMOOTHED {:.2f}  CHANGES {}",
+        resolution->m_Scale * 100.0f,
+        sceneWidth,
+        sceneHeight,
+        resolution->m_Settings.m_BudgetMs,
+        resolution->m_SmoothedMs,
+        resolution->m_Changes);
+
+    // NOTE(sbalse): Build all geometry for this frame.
+    g_HudVertexCount = 0;
+
+    size_t longestLine = 0;
+    for (u32 i = 0; i < lineCount; i++)
+    {
+        const size_t length = std::strlen(lines[i]);
+        longestLine = length > longestLine ? length : longestLine;
+    }
+
+    PushQuad(
+        0,
+        0,
+        HUD_MARGIN * 2 + static_cast<int>(longestLine) * HUD_ADVANCE,
+        HUD_MARGIN * 2 + static_cast<int>(lineCount) * HUD_LINE_HEIGHT,
+        HUD_PANEL_COLOR,
+        screenWidth,
+        screenHeight);
+
+    for (u32 i = 0; i < lineCount; i++)
+    {
+        PushText(
+            lines[i],
+            HUD_MARGIN,
+            HUD_MARGIN + static_cast<int>(i) * HUD_LINE_HEIGHT,
+            HUD_TEXT_COLOR,
+            screenWidth,
+            screenHeight);
+    }
+
+    // NOTE(sbalse): Upload everything with one map.
+    D3D11_MAPPED_SUBRESOURCE mappedResource = {};
+    const HRESULT hr = deviceResources->m_DeviceContext->Map(
+        g_Hud.m_VertexBuffer,
+        0u,
+        D3D11_MAP_WRITE_DISCARD,
+        0u,
+        &mappedResource);
+    ValidateHRESULT(hr);
+
+    const u32 uploadSize = g_HudVertexCount * sizeof(HudVertex);
+    std::memcpy(mappedResource.pData, g_HudVertices, uploadSize);
+    deviceResources->m_DeviceContext->Unmap(g_Hud.m_VertexBuffer, 0u);
+
+    // NOTE(sbalse): Draw the whole overlay in one call.
+    ID3D11DeviceContext* context = deviceResources->m_DeviceContext;
+    constexpr u32 stride = VertexStride<HudVertex>();
+    constexpr u32 offset = 0u;
+    context->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    context->IASetInputLayout(g_Hud.m_InputLayout);
+    context->IASetVertexBuffers(0u, 1u, &g_Hud.m_VertexBuffer, &stride, &offset);
+    context->VSSetShader(g_Hud.m_VertexShader, nullptr, 0u);
+    context->PSSetShader(g_Hud.m_PixelShader, nullptr, 0u);
+    context->OMSetDepthStencilState(
+        ResourceGetDepthStencilState(deviceResources->m_Resources, g_Hud.m_DepthStencilState),
+        1u);
+    context->Draw(g_HudVertexCount, 0u);
+
+    StatsAddCounter(StatsCounter::DRAWCALLS, 1);
+    StatsAddCounter(StatsCounter::BYTESUPLOADED, uploadSize);
+}
+
+void HudDestroy(const DeviceResources* const deviceResources)
+{
+    ResourceRelease(deviceResources->m_Resources, g_Hud.m_DepthStencilState);
+    g_Hud.m_DepthStencilState = RESOURCE_INVALID_HANDLE;
+    SAFE_RELEASE(g_Hud.m_InputLayout);
+    SAFE_RELEASE(g_Hud.m_PixelShader);
+    SAFE_RELEASE(g_Hud.m_VertexShader);
+    SAFE_RELEASE(g_Hud.m_VertexBuffer);
+}
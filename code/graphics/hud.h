@@ -0,0 +1,18 @@
+#pragma once
+
+#include "graphics/graphicsutils.h"
+
+struct DynamicResolution;
+struct StatsSummary;
+struct RenderGraphStats;
+
+// NOTE(sbalse): On-screen overlay that shows frame statistics. Everything is drawn with a single draw call.
+void HudInit(const DeviceResources* const deviceResources);
+void HudDraw(
+    const StatsSummary* const summary,
+    const RenderGraphStats* const renderGraph,
+    const DynamicResolution* const resolution,
+    const int screenWidth,
+    const int screenHeight,
+    const DeviceResources* const deviceResources);
+void HudDestroy(const DeviceResources* const deviceResources);
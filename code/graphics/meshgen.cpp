@@ -0,0 +1,294 @@
+#include "graphics/meshgen.h"
+
+#include <cstdlib>
+#include <emmintrin.h>
+
+namespace
+{
+    // NOTE(sbalse): Same rounding as QuantizeSnorm16(), half away from zero, so both paths agree to the bit.
+    __m128i MeshQuantizeSnorm16x4(const __m128 value)
+    {
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+        const __m128 clamped = _mm_min_ps(_mm_max_ps(value, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+        const __m128 scaled = _mm_mul_ps(clamped, _mm_set1_ps(32767.0f));
+        const __m128 half = _mm_or_ps(_mm_and_ps(scaled, signMask), _mm_set1_ps(0.5f));
+        return _mm_cvttps_epi32(_mm_add_ps(scaled, half));
+    }
+
+    // NOTE(sbalse): Four lanes of QuantizeOctahedralFast(). Returns u in the low and v in the high 16 bits.
+    __m128i MeshQuantizeOctahedralx4(const __m128 x, const __m128 y, const __m128 z)
+    {
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 minusOne = _mm_set1_ps(-1.0f);
+
+        const __m128 length = _mm_add_ps(
+            _mm_add_ps(_mm_andnot_ps(signMask, x), _mm_andnot_ps(signMask, y)),
+            _mm_andnot_ps(signMask, z));
+        const __m128 isZero = _mm_cmpeq_ps(length, zero);
+
+        const __m128 u = _mm_div_ps(x, length);
+        const __m128 v = _mm_div_ps(y, length);
+
+        const __m128 uPositive = _mm_cmpge_ps(u, zero);
+        const __m128 vPositive = _mm_cmpge_ps(v, zero);
+        const __m128 signU = _mm_or_ps(_mm_and_ps(uPositive, one), _mm_andnot_ps(uPositive, minusOne));
+        const __m128 signV = _mm_or_ps(_mm_and_ps(vPositive, one), _mm_andnot_ps(vPositive, minusOne));
+        const __m128 foldedU = _mm_mul_ps(_mm_sub_ps(one, _mm_andnot_ps(signMask, v)), signU);
+        const __m128 foldedV = _mm_mul_ps(_mm_sub_ps(one, _mm_andnot_ps(signMask, u)), signV);
+
+        const __m128 fold = _mm_cmplt_ps(z, zero);
+        const __m128 resultU = _mm_or_ps(_mm_and_ps(fold, foldedU), _mm_andnot_ps(fold, u));
+        const __m128 resultV = _mm_or_ps(_mm_and_ps(fold, foldedV), _mm_andnot_ps(fold, v));
+
+        const __m128i packed = _mm_or_si128(
+            _mm_and_si128(MeshQuantizeSnorm16x4(resultU), _mm_set1_epi32(0xFFFF)),
+            _mm_slli_epi32(MeshQuantizeSnorm16x4(resultV), 16));
+        return _mm_andnot_si128(_mm_castps_si128(isZero), packed);
+    }
+
+    // NOTE(sbalse): Vectorized MeshLatticeVertices(). Four columns of a row are computed at once, as four 32-bit
+    // words per vertex, then transposed into four MeshVertex.
+    void MeshGenerateLattice(
+        const MeshLatticeRow* rows,
+        const u32 rowCount,
+        const MeshLatticeColumn* columns,
+        const u32 columnCount,
+        MeshVertex* result)
+    {
+        static_assert(sizeof(MeshVertex) == 16);
+
+        // NOTE(sbalse): Columns are the same for every row, so split them into arrays once.
+        const u32 paddedCount = (columnCount + 3) & ~3u;
+        float* columnX = static_cast<float*>(std::calloc(paddedCount * 3, sizeof(float)));
+        float* columnZ = columnX + paddedCount;
+        u32* columnU = reinterpret_cast<u32*>(columnZ + paddedCount);
+        for (u32 i = 0; i < columnCount; i++)
+        {
+            columnX[i] = columns[i].m_X;
+            columnZ[i] = columns[i].m_Z;
+            columnU[i] = QuantizeHalf(columns[i].m_U);
+        }
+
+        const __m128i lowMask = _mm_set1_epi32(0xFFFF);
+        const u32 vectorCount = columnCount & ~3u;
+        for (u32 row = 0; row < rowCount; row++)
+        {
+            const MeshLatticeRow& latticeRow = rows[row];
+            const __m128 radius = _mm_set1_ps(latticeRow.m_Radius);
+            const __m128 offsetZ = _mm_set1_ps(latticeRow.m_OffsetZ);
+            const __m128 normalRadius = _mm_set1_ps(latticeRow.m_NormalRadius);
+            const __m128 normalY = _mm_set1_ps(latticeRow.m_NormalY);
+            const __m128i positionY = _mm_slli_epi32(MeshQuantizeSnorm16x4(_mm_set1_ps(latticeRow.m_Y)), 16);
+            const __m128i texCoordV = _mm_set1_epi32(static_cast<i32>(QuantizeHalf(latticeRow.m_V)) << 16);
+
+            MeshVertex* output = result + row * columnCount;
+            for (u32 column = 0; column < vectorCount; column += 4)
+            {
+                const __m128 x = _mm_loadu_ps(columnX + column);
+                const __m128 z = _mm_loadu_ps(columnZ + column);
+
+                const __m128i positionX = MeshQuantizeSnorm16x4(_mm_mul_ps(radius, x));
+                const __m128i positionZ = MeshQuantizeSnorm16x4(_mm_add_ps(_mm_mul_ps(radius, z), offsetZ));
+                const __m128i normal = MeshQuantizeOctahedralx4(
+                    _mm_mul_ps(normalRadius, x), normalY, _mm_mul_ps(normalRadius, z));
+                const __m128i texCoord = _mm_or_si128(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(columnU + column)), texCoordV);
+
+                const __m128i word0 = _mm_or_si128(_mm_and_si128(positionX, lowMask), positionY);
+                const __m128i word1 = _mm_and_si128(positionZ, lowMask);
+
+                const __m128i low01 = _mm_unpacklo_epi32(word0, word1);
+                const __m128i low23 = _mm_unpacklo_epi32(normal, texCoord);
+                const __m128i high01 = _mm_unpackhi_epi32(word0, word1);
+                const __m128i high23 = _mm_unpackhi_epi32(normal, texCoord);
+
+                __m128i* destination = reinterpret_cast<__m128i*>(output + column);
+                _mm_storeu_si128(destination + 0, _mm_unpacklo_epi64(low01, low23));
+                _mm_storeu_si128(destination + 1, _mm_unpackhi_epi64(low01, low23));
+                _mm_storeu_si128(destination + 2, _mm_unpacklo_epi64(high01, high23));
+                _mm_storeu_si128(destination + 3, _mm_unpackhi_epi64(high01, high23));
+            }
+
+            for (u32 column = vectorCount; column < columnCount; column++)
+            {
+                output[column] = MeshLatticeVertex(latticeRow, columns[column]);
+            }
+        }
+
+        std::free(columnX);
+    }
+
+    // NOTE(sbalse): Row and column tables live on the heap, runtime meshes can have millions of them.
+    struct MeshLatticeTables
+    {
+        MeshLatticeRow* m_Rows;
+        MeshLatticeColumn* m_Columns;
+    };
+
+    MeshLatticeTables MeshAllocateLatticeTables(const u32 columns, const u32 rows)
+    {
+        return
+        {
+            .m_Rows = static_cast<MeshLatticeRow*>(std::calloc(rows + 1, sizeof(MeshLatticeRow))),
+            .m_Columns = static_cast<MeshLatticeColumn*>(std::calloc(columns + 1, sizeof(MeshLatticeColumn))),
+        };
+    }
+
+    void MeshFreeLatticeTables(const MeshLatticeTables* tables)
+    {
+        std::free(tables->m_Columns);
+        std::free(tables->m_Rows);
+    }
+
+    // NOTE(sbalse): An edge, stored with its lower numbered vertex.
+    struct MeshEdge
+    {
+        u32 m_High;
+        u32 m_Midpoint;
+    };
+} // namespace
+
+void MeshGenerateCube(const u32 subdivisions, MeshVertex* vertices, u32* indices)
+{
+    MeshCubeData(subdivisions, vertices, indices);
+}
+
+void MeshGenerateGrid(const u32 columns, const u32 rows, MeshVertex* vertices, u32* indices)
+{
+    const MeshLatticeTables tables = MeshAllocateLatticeTables(columns, rows);
+    MeshGridRows(rows, tables.m_Rows);
+    MeshGridColumns(columns, tables.m_Columns);
+
+    MeshGenerateLattice(tables.m_Rows, rows + 1, tables.m_Columns, columns + 1, vertices);
+    MeshLatticeIndices(columns, rows, 0u, false, false, indices);
+    MeshFreeLatticeTables(&tables);
+}
+
+void MeshGenerateUvSphere(const u32 segments, const u32 rings, MeshVertex* vertices, u32* indices)
+{
+    const MeshLatticeTables tables = MeshAllocateLatticeTables(segments, rings);
+    MeshUvSphereRows(rings, tables.m_Rows);
+    MeshRevolutionColumns(segments, tables.m_Columns);
+
+    MeshGenerateLattice(tables.m_Rows, rings + 1, tables.m_Columns, segments + 1, vertices);
+    MeshLatticeIndices(segments, rings, 0u, true, true, indices);
+    MeshFreeLatticeTables(&tables);
+}
+
+void MeshGenerateCylinder(const u32 segments, const u32 rings, MeshVertex* vertices, u32* indices)
+{
+    const MeshLatticeTables tables = MeshAllocateLatticeTables(segments, rings);
+    MeshCylinderRows(rings, tables.m_Rows);
+    MeshRevolutionColumns(segments, tables.m_Columns);
+
+    MeshGenerateLattice(tables.m_Rows, rings + 1, tables.m_Columns, segments + 1, vertices);
+    MeshLatticeIndices(segments, rings, 0u, false, false, indices);
+    MeshCylinderCaps(segments, rings, tables.m_Columns, vertices, indices);
+    MeshFreeLatticeTables(&tables);
+}
+
+void MeshGenerateTorus(
+    const u32 segments,
+    const u32 sides,
+    const float tubeRadius,
+    MeshVertex* vertices,
+    u32* indices)
+{
+    const MeshLatticeTables tables = MeshAllocateLatticeTables(segments, sides);
+    MeshTorusRows(sides, tubeRadius, tables.m_Rows);
+    MeshRevolutionColumns(segments, tables.m_Columns);
+
+    MeshGenerateLattice(tables.m_Rows, sides + 1, tables.m_Columns, segments + 1, vertices);
+    MeshLatticeIndices(segments, sides, 0u, false, false, indices);
+    MeshFreeLatticeTables(&tables);
+}
+
+// NOTE(sbalse): Same subdivision as MeshIcoSphere<>(), in the same order so the output matches it, but shared
+// midpoints are found through a per vertex edge table.
+void MeshGenerateIcoSphere(const u32 level, MeshVertex* vertices, u32* indices)
+{
+    const MeshCounts counts = MeshIcoSphereCounts(level);
+    constexpr MeshCounts base = MeshIcoSphereCounts(0);
+
+    double* positions = static_cast<double*>(std::calloc(counts.m_VertexCount * 3, sizeof(double)));
+    u32* scratch = static_cast<u32*>(std::calloc(counts.m_IndexCount, sizeof(u32)));
+    MeshIcosahedron(positions, indices);
+
+    // NOTE(sbalse): No vertex has more than six neighbours, so every vertex gets six slots for the edges to its
+    // higher numbered neighbours. Lookups stay next to each other in memory as the triangles are walked.
+    constexpr u32 slotsPerVertex = 6;
+    const u32 tableVertices = level > 0 ? MeshIcoSphereCounts(level - 1).m_VertexCount : 0;
+    MeshEdge* edges = static_cast<MeshEdge*>(std::calloc(tableVertices * slotsPerVertex + 1, sizeof(MeshEdge)));
+
+    u32 vertexCount = base.m_VertexCount;
+    u32 indexCount = base.m_IndexCount;
+    for (u32 pass = 0; pass < level; pass++)
+    {
+        for (u32 i = 0; i < vertexCount * slotsPerVertex; i++)
+        {
+            edges[i].m_High = 0;
+        }
+
+        const auto midpoint = [&](const u32 first, const u32 second) -> u32
+        {
+            const u32 low = first < second ? first : second;
+            const u32 high = first < second ? second : first;
+
+            // NOTE(sbalse): high > low, so a high of 0 marks a free slot.
+            MeshEdge* slots = &edges[low * slotsPerVertex];
+            u32 slot = 0;
+            while (slots[slot].m_High != 0)
+            {
+                if (slots[slot].m_High == high)
+                {
+                    return slots[slot].m_Midpoint;
+                }
+                slot++;
+            }
+
+            const double x = positions[low * 3 + 0] + positions[high * 3 + 0];
+            const double y = positions[low * 3 + 1] + positions[high * 3 + 1];
+            const double z = positions[low * 3 + 2] + positions[high * 3 + 2];
+            const double inverseLength = 1.0 / MeshSqrt(x * x + y * y + z * z);
+            positions[vertexCount * 3 + 0] = x * inverseLength;
+            positions[vertexCount * 3 + 1] = y * inverseLength;
+            positions[vertexCount * 3 + 2] = z * inverseLength;
+            slots[slot] = { high, vertexCount };
+            return vertexCount++;
+        };
+
+        u32 written = 0;
+        for (u32 i = 0; i < indexCount; i += 3)
+        {
+            const u32 v0 = indices[i + 0];
+            const u32 v1 = indices[i + 1];
+            const u32 v2 = indices[i + 2];
+            const u32 m01 = midpoint(v0, v1);
+            const u32 m12 = midpoint(v1, v2);
+            const u32 m20 = midpoint(v2, v0);
+            const u32 split[] = { v0, m01, m20, v1, m12, m01, v2, m20, m12, m01, m12, m20 };
+            for (const u32 index : split)
+            {
+                scratch[written++] = index;
+            }
+        }
+
+        indexCount = written;
+        for (u32 i = 0; i < indexCount; i++)
+        {
+            indices[i] = scratch[i];
+        }
+    }
+
+    for (u32 i = 0; i < counts.m_VertexCount; i++)
+    {
+        const double* position = &positions[i * 3];
+        vertices[i] = MeshIcoSphereVertex(position[0], position[1], position[2]);
+    }
+
+    std::free(edges);
+    std::free(scratch);
+    std::free(positions);
+}
@@ -0,0 +1,716 @@
+#pragma once
+#include <array>
+#include <bit>
+
+#include "types.h"
+#include "graphics/quantize.h"
+#include "graphics/vertex.h"
+
+/*
+* NOTE(sbalse): Procedural primitives, produced as MeshVertex data.
+*
+* Every primitive comes in two flavours that share the same math:
+*   - MeshCube<>(), MeshUvSphere<>() and friends are constexpr and return a StaticMesh. Use them to initialize
+*     a constexpr variable and the mesh is baked into the binary, costing nothing at startup.
+*   - MeshGenerate*() run at runtime into caller owned buffers with 32-bit indices. Use them for tessellations
+*     too large for 16-bit indices or the compiler, the lattice shapes are vectorized with SSE2.
+* For the same parameters both produce the same vertices, bit for bit unless the compiler reorders float math.
+*
+* All shapes fit the unit cube so positions use the whole Snorm16 range, the world transform sets the size.
+* Triangles are clockwise seen from the outside, the Direct3D default for front faces.
+*/
+
+// NOTE(sbalse): Above this a mesh no longer fits 16-bit indices and has to be generated at runtime.
+constexpr u32 MESHGEN_MAX_STATIC_VERTICES = 65536;
+
+constexpr double MESHGEN_PI = 3.14159265358979323846;
+
+template<u32 VertexCount, u32 IndexCount>
+struct StaticMesh
+{
+    std::array<MeshVertex, VertexCount> m_Vertices;
+    std::array<u16, IndexCount> m_Indices;
+};
+
+struct MeshCounts
+{
+    u32 m_VertexCount;
+    u32 m_IndexCount;
+};
+
+// NOTE(sbalse): The shapes other than the cube and the icosphere are a lattice of rows times columns. A row
+// and a column describe a vertex as
+//     position = (radius * x, y, radius * z + offsetZ)
+//     normal   = (normalRadius * x, normalY, normalRadius * z)
+// which covers both surfaces of revolution and the flat grid.
+struct MeshLatticeRow
+{
+    float m_Radius;
+    float m_Y;
+    float m_OffsetZ;
+    float m_NormalRadius;
+    float m_NormalY;
+    float m_V;
+};
+
+struct MeshLatticeColumn
+{
+    float m_X;
+    float m_Z;
+    float m_U;
+};
+
+// NOTE(sbalse): Constant evaluation cannot call the C runtime, so the few functions the generators need are
+// implemented here. They work in double and are accurate to well below what the vertex formats can store.
+constexpr double MeshSqrt(const double value)
+{
+    if (value <= 0.0)
+    {
+        return 0.0;
+    }
+
+    // NOTE(sbalse): Halving the exponent gives a first guess within a factor of two, from above after one step.
+    const u64 bits = std::bit_cast<u64>(value);
+    double result = std::bit_cast<double>((bits >> 1) + (1023ull << 51));
+    result = 0.5 * (result + value / result);
+    for (u32 i = 0; i < 16; i++)
+    {
+        const double next = 0.5 * (result + value / result);
+        if (next >= result)
+        {
+            break;
+        }
+        result = next;
+    }
+    return result;
+}
+
+constexpr double MeshSin(double angle)
+{
+    // NOTE(sbalse): Reduce to [-pi, pi], then to [-pi / 2, pi / 2] where the series converges quickly.
+    const double turns = angle / (2.0 * MESHGEN_PI);
+    const double rounded = static_cast<double>(static_cast<i64>(turns >= 0.0 ? turns + 0.5 : turns - 0.5));
+    angle -= rounded * 2.0 * MESHGEN_PI;
+    if (angle > 0.5 * MESHGEN_PI)
+    {
+        angle = MESHGEN_PI - angle;
+    }
+    else if (angle < -0.5 * MESHGEN_PI)
+    {
+        angle = -MESHGEN_PI - angle;
+    }
+
+    const double squared = angle * angle;
+    double term = angle;
+    double result = angle;
+    for (u32 i = 1; i <= 8; i++)
+    {
+        term *= -squared / static_cast<double>((2 * i) * (2 * i + 1));
+        result += term;
+    }
+    return result;
+}
+
+constexpr double MeshCos(const double angle)
+{
+    return MeshSin(angle + 0.5 * MESHGEN_PI);
+}
+
+constexpr double MeshAtan(double value)
+{
+    const bool invert = value > 1.0 || value < -1.0;
+    if (invert)
+    {
+        value = 1.0 / value;
+    }
+
+    // NOTE(sbalse): Two half angle steps bring the argument below tan(pi / 16).
+    value = value / (1.0 + MeshSqrt(1.0 + value * value));
+    value = value / (1.0 + MeshSqrt(1.0 + value * value));
+
+    const double squared = value * value;
+    double term = value;
+    double result = value;
+    for (u32 i = 1; i <= 10; i++)
+    {
+        term *= -squared;
+        result += term / static_cast<double>(2 * i + 1);
+    }
+    result *= 4.0;
+
+    if (invert)
+    {
+        result = (result > 0.0 ? 0.5 * MESHGEN_PI : -0.5 * MESHGEN_PI) - result;
+    }
+    return result;
+}
+
+constexpr double MeshAtan2(const double y, const double x)
+{
+    if (x > 0.0)
+    {
+        return MeshAtan(y / x);
+    }
+    if (x < 0.0)
+    {
+        return MeshAtan(y / x) + (y >= 0.0 ? MESHGEN_PI : -MESHGEN_PI);
+    }
+    return y > 0.0 ? 0.5 * MESHGEN_PI : (y < 0.0 ? -0.5 * MESHGEN_PI : 0.0);
+}
+
+constexpr MeshVertex MeshEncodeVertex(
+    const float x,
+    const float y,
+    const float z,
+    const float normalX,
+    const float normalY,
+    const float normalZ,
+    const float u,
+    const float v)
+{
+    return
+    {
+        .m_Position = { QuantizeSnorm16(x), QuantizeSnorm16(y), QuantizeSnorm16(z), 0 },
+        .m_Normal = QuantizeOctahedralFast(normalX, normalY, normalZ),
+        .m_TexCoord = { QuantizeHalf(u), QuantizeHalf(v) },
+    };
+}
+
+constexpr MeshVertex MeshLatticeVertex(const MeshLatticeRow& row, const MeshLatticeColumn& column)
+{
+    return MeshEncodeVertex(
+        row.m_Radius * column.m_X,
+        row.m_Y,
+        row.m_Radius * column.m_Z + row.m_OffsetZ,
+        row.m_NormalRadius * column.m_X,
+        row.m_NormalY,
+        row.m_NormalRadius * column.m_Z,
+        column.m_U,
+        row.m_V);
+}
+
+// NOTE(sbalse): Counts of each primitive, shared by the constexpr and the runtime generators.
+constexpr MeshCounts MeshLatticeCounts(const u32 columns, const u32 rows)
+{
+    return { (columns + 1) * (rows + 1), columns * rows * 6 };
+}
+
+constexpr MeshCounts MeshCubeCounts(const u32 subdivisions)
+{
+    const MeshCounts face = MeshLatticeCounts(subdivisions, subdivisions);
+    return { face.m_VertexCount * 6, face.m_IndexCount * 6 };
+}
+
+constexpr MeshCounts MeshGridCounts(const u32 columns, const u32 rows)
+{
+    return MeshLatticeCounts(columns, rows);
+}
+
+// NOTE(sbalse): The triangles that collapse at the poles are left out.
+constexpr MeshCounts MeshUvSphereCounts(const u32 segments, const u32 rings)
+{
+    return { (segments + 1) * (rings + 1), segments * (rings - 1) * 6 };
+}
+
+constexpr MeshCounts MeshIcoSphereCounts(const u32 level)
+{
+    return { 10 * (1u << (2 * level)) + 2, 60 * (1u << (2 * level)) };
+}
+
+// NOTE(sbalse): The side is a lattice, each cap a fan around its own center vertex.
+constexpr MeshCounts MeshCylinderCounts(const u32 segments, const u32 rings)
+{
+    const MeshCounts side = MeshLatticeCounts(segments, rings);
+    return { side.m_VertexCount + 2 * (segments + 2), side.m_IndexCount + segments * 6 };
+}
+
+constexpr MeshCounts MeshTorusCounts(const u32 segments, const u32 sides)
+{
+    return MeshLatticeCounts(segments, sides);
+}
+
+// NOTE(sbalse): Row and column tables of the lattice shapes.
+constexpr void MeshRevolutionColumns(const u32 segments, MeshLatticeColumn* columns)
+{
+    for (u32 i = 0; i <= segments; i++)
+    {
+        const double angle = 2.0 * MESHGEN_PI * i / segments;
+        columns[i] =
+        {
+            .m_X = static_cast<float>(MeshCos(angle)),
+            .m_Z = static_cast<float>(MeshSin(angle)),
+            .m_U = static_cast<float>(i) / static_cast<float>(segments),
+        };
+    }
+}
+
+constexpr void MeshGridColumns(const u32 columns, MeshLatticeColumn* result)
+{
+    for (u32 i = 0; i <= columns; i++)
+    {
+        const float u = static_cast<float>(i) / static_cast<float>(columns);
+        result[i] = { .m_X = u * 2.0f - 1.0f, .m_Z = 0.0f, .m_U = u };
+    }
+}
+
+constexpr void MeshGridRows(const u32 rows, MeshLatticeRow* result)
+{
+    for (u32 i = 0; i <= rows; i++)
+    {
+        const float v = static_cast<float>(i) / static_cast<float>(rows);
+        result[i] =
+        {
+            .m_Radius = 1.0f,
+            .m_Y = 0.0f,
+            .m_OffsetZ = 1.0f - v * 2.0f,
+            .m_NormalRadius = 0.0f,
+            .m_NormalY = 1.0f,
+            .m_V = v,
+        };
+    }
+}
+
+// NOTE(sbalse): Rows run from the north pole down.
+constexpr void MeshUvSphereRows(const u32 rings, MeshLatticeRow* result)
+{
+    for (u32 i = 0; i <= rings; i++)
+    {
+        const double angle = MESHGEN_PI * i / rings;
+        const float radius = static_cast<float>(MeshSin(angle));
+        const float y = static_cast<float>(MeshCos(angle));
+        result[i] =
+        {
+            .m_Radius = radius,
+            .m_Y = y,
+            .m_OffsetZ = 0.0f,
+            .m_NormalRadius = radius,
+            .m_NormalY = y,
+            .m_V = static_cast<float>(i) / static_cast<float>(rings),
+        };
+    }
+}
+
+constexpr void MeshCylinderRows(const u32 rings, MeshLatticeRow* result)
+{
+    for (u32 i = 0; i <= rings; i++)
+    {
+        const float v = static_cast<float>(i) / static_cast<float>(rings);
+        result[i] =
+        {
+            .m_Radius = 1.0f,
+            .m_Y = 1.0f - v * 2.0f,
+            .m_OffsetZ = 0.0f,
+            .m_NormalRadius = 1.0f,
+            .m_NormalY = 0.0f,
+            .m_V = v,
+        };
+    }
+}
+
+// NOTE(sbalse): The tube is swept from the outer equator downwards so the winding matches the sphere.
+constexpr void MeshTorusRows(const u32 sides, const float tubeRadius, MeshLatticeRow* result)
+{
+    for (u32 i = 0; i <= sides; i++)
+    {
+        const double angle = 2.0 * MESHGEN_PI * i / sides;
+        const float cosine = static_cast<float>(MeshCos(angle));
+        const float sine = static_cast<float>(MeshSin(angle));
+        result[i] =
+        {
+            .m_Radius = (1.0f - tubeRadius) + tubeRadius * cosine,
+            .m_Y = -tubeRadius * sine,
+            .m_OffsetZ = 0.0f,
+            .m_NormalRadius = cosine,
+            .m_NormalY = -sine,
+            .m_V = static_cast<float>(i) / static_cast<float>(sides),
+        };
+    }
+}
+
+constexpr void MeshLatticeVertices(
+    const MeshLatticeRow* rows,
+    const u32 rowCount,
+    const MeshLatticeColumn* columns,
+    const u32 columnCount,
+    MeshVertex* result)
+{
+    for (u32 row = 0; row < rowCount; row++)
+    {
+        for (u32 column = 0; column < columnCount; column++)
+        {
+            result[row * columnCount + column] = MeshLatticeVertex(rows[row], columns[column]);
+        }
+    }
+}
+
+// NOTE(sbalse): Two triangles per cell. skipFirst and skipLast leave out the triangle that collapses when
+// the first or last row is a single point. Returns the number of indices written.
+template<typename Index>
+constexpr u32 MeshLatticeIndices(
+    const u32 columns,
+    const u32 rows,
+    const u32 baseVertex,
+    const bool skipFirst,
+    const bool skipLast,
+    Index* result)
+{
+    u32 count = 0;
+    for (u32 row = 0; row < rows; row++)
+    {
+        for (u32 column = 0; column < columns; column++)
+        {
+            const u32 a = baseVertex + row * (columns + 1) + column;
+            const u32 b = a + 1;
+            const u32 d = a + columns + 1;
+            const u32 e = d + 1;
+            if (!(skipFirst && row == 0))
+            {
+                result[count++] = static_cast<Index>(a);
+                result[count++] = static_cast<Index>(b);
+                result[count++] = static_cast<Index>(d);
+            }
+            if (!(skipLast && row == rows - 1))
+            {
+                result[count++] = static_cast<Index>(b);
+                result[count++] = static_cast<Index>(e);
+                result[count++] = static_cast<Index>(d);
+            }
+        }
+    }
+    return count;
+}
+
+// NOTE(sbalse): Faces in the order -Z, +X, +Y, +Z, -X, -Y, each a subdivisions x subdivisions lattice with
+// its triangles in a contiguous run, so face = primitive id / (2 * subdivisions * subdivisions).
+template<typename Index>
+constexpr void MeshCubeData(const u32 subdivisions, MeshVertex* vertices, Index* indices)
+{
+    struct CubeFace
+    {
+        i32 m_Normal[3];
+        i32 m_U[3];
+        i32 m_V[3];
+    };
+
+    constexpr CubeFace faces[] =
+    {
+        { { 0, 0, -1 }, { 1, 0, 0 }, { 0, -1, 0 } },
+        { { 1, 0, 0 }, { 0, 0, 1 }, { 0, -1, 0 } },
+        { { 0, 1, 0 }, { -1, 0, 0 }, { 0, 0, 1 } },
+        { { 0, 0, 1 }, { -1, 0, 0 }, { 0, -1, 0 } },
+        { { -1, 0, 0 }, { 0, 0, -1 }, { 0, -1, 0 } },
+        { { 0, -1, 0 }, { -1, 0, 0 }, { 0, 0, -1 } },
+    };
+
+    const MeshCounts face = MeshLatticeCounts(subdivisions, subdivisions);
+    for (u32 f = 0; f < 6; f++)
+    {
+        const CubeFace& cubeFace = faces[f];
+        for (u32 row = 0; row <= subdivisions; row++)
+        {
+            const float t = static_cast<float>(row) / static_cast<float>(subdivisions);
+            for (u32 column = 0; column <= subdivisions; column++)
+            {
+                const float s = static_cast<float>(column) / static_cast<float>(subdivisions);
+                float position[3] = {};
+                float normal[3] = {};
+                for (u32 axis = 0; axis < 3; axis++)
+                {
+                    normal[axis] = static_cast<float>(cubeFace.m_Normal[axis]);
+                    position[axis] = normal[axis]
+                        + static_cast<float>(cubeFace.m_U[axis]) * (s * 2.0f - 1.0f)
+                        + static_cast<float>(cubeFace.m_V[axis]) * (t * 2.0f - 1.0f);
+                }
+
+                vertices[f * face.m_VertexCount + row * (subdivisions + 1) + column] = MeshEncodeVertex(
+                    position[0], position[1], position[2], normal[0], normal[1], normal[2], s, t);
+            }
+        }
+
+        MeshLatticeIndices(
+            subdivisions, subdivisions, f * face.m_VertexCount, false, false, indices + f * face.m_IndexCount);
+    }
+}
+
+// NOTE(sbalse): The cap vertices follow the side. Each cap has its own center and segments + 1 rim vertices, so
+// it gets flat normals and planar texture coordinates.
+template<typename Index>
+constexpr void MeshCylinderCaps(
+    const u32 segments,
+    const u32 rings,
+    const MeshLatticeColumn* columns,
+    MeshVertex* vertices,
+    Index* indices)
+{
+    const MeshCounts side = MeshLatticeCounts(segments, rings);
+    for (u32 cap = 0; cap < 2; cap++)
+    {
+        const float y = cap == 0 ? 1.0f : -1.0f;
+        const u32 center = side.m_VertexCount + cap * (segments + 2);
+        vertices[center] = MeshEncodeVertex(0.0f, y, 0.0f, 0.0f, y, 0.0f, 0.5f, 0.5f);
+        for (u32 i = 0; i <= segments; i++)
+        {
+            const MeshLatticeColumn& column = columns[i];
+            vertices[center + 1 + i] = MeshEncodeVertex(
+                column.m_X,
+                y,
+                column.m_Z,
+                0.0f,
+                y,
+                0.0f,
+                0.5f + 0.5f * column.m_X,
+                0.5f - 0.5f * column.m_Z * y);
+        }
+
+        Index* capIndices = indices + side.m_IndexCount + cap * segments * 3;
+        for (u32 i = 0; i < segments; i++)
+        {
+            const u32 rim = center + 1 + i;
+            capIndices[i * 3 + 0] = static_cast<Index>(center);
+            capIndices[i * 3 + 1] = static_cast<Index>(cap == 0 ? rim + 1 : rim);
+            capIndices[i * 3 + 2] = static_cast<Index>(cap == 0 ? rim : rim + 1);
+        }
+    }
+}
+
+// NOTE(sbalse): Spherical texture coordinates of a unit direction. The triangles across the seam interpolate
+// the wrong way round, fine for the procedural test meshes this is used for.
+constexpr MeshVertex MeshIcoSphereVertex(const double x, const double y, const double z)
+{
+    const double u = 0.5 + MeshAtan2(z, x) / (2.0 * MESHGEN_PI);
+    const double v = MeshAtan2(MeshSqrt(x * x + z * z), y) / MESHGEN_PI;
+    return MeshEncodeVertex(
+        static_cast<float>(x),
+        static_cast<float>(y),
+        static_cast<float>(z),
+        static_cast<float>(x),
+        static_cast<float>(y),
+        static_cast<float>(z),
+        static_cast<float>(u),
+        static_cast<float>(v));
+}
+
+// NOTE(sbalse): The level 0 icosphere, 12 unit vectors and 20 triangles.
+template<typename Index>
+constexpr void MeshIcosahedron(double* positions, Index* indices)
+{
+    constexpr double t = 1.6180339887498948482;
+    const double length = MeshSqrt(1.0 + t * t);
+    const double a = 1.0 / length;
+    const double b = t / length;
+
+    const double corners[] =
+    {
+        -a, b, 0.0, a, b, 0.0, -a, -b, 0.0, a, -b, 0.0,
+        0.0, -a, b, 0.0, a, b, 0.0, -a, -b, 0.0, a, -b,
+        b, 0.0, -a, b, 0.0, a, -b, 0.0, -a, -b, 0.0, a,
+    };
+    constexpr u16 triangles[] =
+    {
+        0, 11, 5, 0, 5, 1, 0, 1, 7, 0, 7, 10, 0, 10, 11,
+        1, 5, 9, 5, 11, 4, 11, 10, 2, 10, 7, 6, 7, 1, 8,
+        3, 9, 4, 3, 4, 2, 3, 2, 6, 3, 6, 8, 3, 8, 9,
+        4, 9, 5, 2, 4, 11, 6, 2, 10, 8, 6, 7, 9, 8, 1,
+    };
+
+    for (u32 i = 0; i < 36; i++)
+    {
+        positions[i] = corners[i];
+    }
+    for (u32 i = 0; i < 60; i++)
+    {
+        indices[i] = static_cast<Index>(triangles[i]);
+    }
+}
+
+// NOTE(sbalse): Icosahedron with every edge split level times, midpoints pushed out to the sphere. Shared
+// midpoints are found by searching the edges of the current level, which is fine for the small levels that
+// make sense at compile time. MeshGenerateIcoSphere() hashes them instead.
+template<u32 Level>
+constexpr auto MeshIcoSphere()
+{
+    constexpr MeshCounts counts = MeshIcoSphereCounts(Level);
+    static_assert(counts.m_VertexCount <= MESHGEN_MAX_STATIC_VERTICES, "Use MeshGenerateIcoSphere()");
+
+    struct Edge
+    {
+        u32 m_A;
+        u32 m_B;
+        u32 m_Midpoint;
+    };
+
+    std::array<double, counts.m_VertexCount * 3> positions = {};
+    StaticMesh<counts.m_VertexCount, counts.m_IndexCount> result = {};
+    std::array<u16, counts.m_IndexCount> scratch = {};
+    std::array<Edge, counts.m_IndexCount / 2> edges = {};
+    MeshIcosahedron(positions.data(), result.m_Indices.data());
+
+    u32 vertexCount = MeshIcoSphereCounts(0).m_VertexCount;
+    u32 indexCount = MeshIcoSphereCounts(0).m_IndexCount;
+    for (u32 level = 0; level < Level; level++)
+    {
+        u32 edgeCount = 0;
+        const auto midpoint = [&](const u32 first, const u32 second) -> u16
+        {
+            const u32 low = first < second ? first : second;
+            const u32 high = first < second ? second : first;
+            for (u32 i = 0; i < edgeCount; i++)
+            {
+                if (edges[i].m_A == low && edges[i].m_B == high)
+                {
+                    return static_cast<u16>(edges[i].m_Midpoint);
+                }
+            }
+
+            const double x = positions[low * 3 + 0] + positions[high * 3 + 0];
+            const double y = positions[low * 3 + 1] + positions[high * 3 + 1];
+            const double z = positions[low * 3 + 2] + positions[high * 3 + 2];
+            const double inverseLength = 1.0 / MeshSqrt(x * x + y * y + z * z);
+            positions[vertexCount * 3 + 0] = x * inverseLength;
+            positions[vertexCount * 3 + 1] = y * inverseLength;
+            positions[vertexCount * 3 + 2] = z * inverseLength;
+            edges[edgeCount++] = { low, high, vertexCount };
+            return static_cast<u16>(vertexCount++);
+        };
+
+        u32 written = 0;
+        for (u32 i = 0; i < indexCount; i += 3)
+        {
+            const u16 v0 = result.m_Indices[i + 0];
+            const u16 v1 = result.m_Indices[i + 1];
+            const u16 v2 = result.m_Indices[i + 2];
+            const u16 m01 = midpoint(v0, v1);
+            const u16 m12 = midpoint(v1, v2);
+            const u16 m20 = midpoint(v2, v0);
+            const u16 split[] = { v0, m01, m20, v1, m12, m01, v2, m20, m12, m01, m12, m20 };
+            for (const u16 index : split)
+            {
+                scratch[written++] = index;
+            }
+        }
+
+        indexCount = written;
+        for (u32 i = 0; i < indexCount; i++)
+        {
+            result.m_Indices[i] = scratch[i];
+        }
+    }
+
+    for (u32 i = 0; i < counts.m_VertexCount; i++)
+    {
+        const double* position = &positions[i * 3];
+        result.m_Vertices[i] = MeshIcoSphereVertex(position[0], position[1], position[2]);
+    }
+
+    return result;
+}
+
+template<u32 Subdivisions>
+constexpr auto MeshCube()
+{
+    constexpr MeshCounts counts = MeshCubeCounts(Subdivisions);
+    static_assert(counts.m_VertexCount <= MESHGEN_MAX_STATIC_VERTICES, "Use MeshGenerateCube()");
+
+    StaticMesh<counts.m_VertexCount, counts.m_IndexCount> result = {};
+    MeshCubeData(Subdivisions, result.m_Vertices.data(), result.m_Indices.data());
+    return result;
+}
+
+// NOTE(sbalse): In the XZ plane facing +Y, row 0 at +Z.
+template<u32 Columns, u32 Rows>
+constexpr auto MeshGrid()
+{
+    constexpr MeshCounts counts = MeshGridCounts(Columns, Rows);
+    static_assert(counts.m_VertexCount <= MESHGEN_MAX_STATIC_VERTICES, "Use MeshGenerateGrid()");
+
+    MeshLatticeRow rows[Rows + 1] = {};
+    MeshLatticeColumn columns[Columns + 1] = {};
+    MeshGridRows(Rows, rows);
+    MeshGridColumns(Columns, columns);
+
+    StaticMesh<counts.m_VertexCount, counts.m_IndexCount> result = {};
+    MeshLatticeVertices(rows, Rows + 1, columns, Columns + 1, result.m_Vertices.data());
+    MeshLatticeIndices(Columns, Rows, 0u, false, false, result.m_Indices.data());
+    return result;
+}
+
+template<u32 Segments, u32 Rings>
+constexpr auto MeshUvSphere()
+{
+    static_assert(Rings >= 2, "A sphere needs at least two rings");
+    constexpr MeshCounts counts = MeshUvSphereCounts(Segments, Rings);
+    static_assert(counts.m_VertexCount <= MESHGEN_MAX_STATIC_VERTICES, "Use MeshGenerateUvSphere()");
+
+    MeshLatticeRow rows[Rings + 1] = {};
+    MeshLatticeColumn columns[Segments + 1] = {};
+    MeshUvSphereRows(Rings, rows);
+    MeshRevolutionColumns(Segments, columns);
+
+    StaticMesh<counts.m_VertexCount, counts.m_IndexCount> result = {};
+    MeshLatticeVertices(rows, Rings + 1, columns, Segments + 1, result.m_Vertices.data());
+    MeshLatticeIndices(Segments, Rings, 0u, true, true, result.m_Indices.data());
+    return result;
+}
+
+// NOTE(sbalse): Radius 1, from y = -1 to y = 1, capped.
+template<u32 Segments, u32 Rings>
+constexpr auto MeshCylinder()
+{
+    constexpr MeshCounts counts = MeshCylinderCounts(Segments, Rings);
+    static_assert(counts.m_VertexCount <= MESHGEN_MAX_STATIC_VERTICES, "Use MeshGenerateCylinder()");
+
+    MeshLatticeRow rows[Rings + 1] = {};
+    MeshLatticeColumn columns[Segments + 1] = {};
+    MeshCylinderRows(Rings, rows);
+    MeshRevolutionColumns(Segments, columns);
+
+    StaticMesh<counts.m_VertexCount, counts.m_IndexCount> result = {};
+    MeshLatticeVertices(rows, Rings + 1, columns, Segments + 1, result.m_Vertices.data());
+    MeshLatticeIndices(Segments, Rings, 0u, false, false, result.m_Indices.data());
+    MeshCylinderCaps(Segments, Rings, columns, result.m_Vertices.data(), result.m_Indices.data());
+    return result;
+}
+
+// NOTE(sbalse): Around the Y axis with an outer radius of 1. tubeRadius is a fraction of that.
+template<u32 Segments, u32 Sides>
+constexpr auto MeshTorus(const float tubeRadius)
+{
+    constexpr MeshCounts counts = MeshTorusCounts(Segments, Sides);
+    static_assert(counts.m_VertexCount <= MESHGEN_MAX_STATIC_VERTICES, "Use MeshGenerateTorus()");
+
+    MeshLatticeRow rows[Sides + 1] = {};
+    MeshLatticeColumn columns[Segments + 1] = {};
+    MeshTorusRows(Sides, tubeRadius, rows);
+    MeshRevolutionColumns(Segments, columns);
+
+    StaticMesh<counts.m_VertexCount, counts.m_IndexCount> result = {};
+    MeshLatticeVertices(rows, Sides + 1, columns, Segments + 1, result.m_Vertices.data());
+    MeshLatticeIndices(Segments, Sides, 0u, false, false, result.m_Indices.data());
+    return result;
+}
+
+// NOTE(sbalse): Drops everything but the positions, for the position only pipelines.
+template<size_t Count>
+constexpr std::array<Vertex, Count> MeshPositions(const std::array<MeshVertex, Count>& vertices)
+{
+    std::array<Vertex, Count> result = {};
+    for (size_t i = 0; i < Count; i++)
+    {
+        result[i] = { vertices[i].m_Position };
+    }
+    return result;
+}
+
+// NOTE(sbalse): Runtime generators. The buffers must hold the vertex and index counts returned by the matching
+// Mesh*Counts() function.
+void MeshGenerateCube(const u32 subdivisions, MeshVertex* vertices, u32* indices);
+void MeshGenerateGrid(const u32 columns, const u32 rows, MeshVertex* vertices, u32* indices);
+void MeshGenerateUvSphere(const u32 segments, const u32 rings, MeshVertex* vertices, u32* indices);
+void MeshGenerateIcoSphere(const u32 level, MeshVertex* vertices, u32* indices);
+void MeshGenerateCylinder(const u32 segments, const u32 rings, MeshVertex* vertices, u32* indices);
+void MeshGenerateTorus(
+    const u32 segments,
+    const u32 sides,
+    const float tubeRadius,
+    MeshVertex* vertices,
+    u32* indices);
@@ -0,0 +1,167 @@
+#include "graphics/particlerenderer.h"
+
+#include <cstring>
+#include <d3dcompiler.h>
+
+#include "particles.h"
+#include "stats.h"
+#include "utils.h"
+#include "graphics/resourcebackend.h"
+#include "graphics/vertex.h"
+#include "graphics/vertexinputlayout.h"
+
+namespace
+{
+    struct ParticleRendererResources
+    {
+        ID3D11Buffer* m_InstanceBuffer;
+        ID3D11Buffer* m_ConstantBuffer;
+        ID3D11VertexShader* m_VertexShader;
+        ID3D11PixelShader* m_PixelShader;
+        ID3D11InputLayout* m_InputLayout;
+        u32 m_MaxParticles;
+    };
+
+    struct ParticleConstantBuffer
+    {
+        XMMATRIX m_Projection;
+        float m_HalfSize[2];
+        float m_Padding[2];
+    };
+
+    constinit ParticleRendererResources g_ParticleRenderer = {};
+} // namespace
+
+void ParticleRendererInit(const DeviceResources* const deviceResources, const u32 maxParticles)
+{
+    g_ParticleRenderer.m_MaxParticles = maxParticles;
+
+    const D3D11_BUFFER_DESC instanceBufferDesc =
+    {
+        .ByteWidth = maxParticles * VertexStride<ParticleInstance>(),
+        .Usage = D3D11_USAGE_DYNAMIC,
+        .BindFlags = D3D11_BIND_VERTEX_BUFFER,
+        .CPUAccessFlags = D3D11_CPU_ACCESS_WRITE,
+        .MiscFlags = 0u,
+        .StructureByteStride = VertexStride<ParticleInstance>(),
+    };
+
+    HRESULT hr = deviceResources->m_Device->CreateBuffer(
+        &instanceBufferDesc,
+        nullptr,
+        &g_ParticleRenderer.m_InstanceBuffer);
+    ValidateHRESULT(hr);
+
+    const D3D11_BUFFER_DESC constantBufferDesc =
+    {
+        .ByteWidth = sizeof(ParticleConstantBuffer),
+        .Usage = D3D11_USAGE_DYNAMIC,
+        .BindFlags = D3D11_BIND_CONSTANT_BUFFER,
+        .CPUAccessFlags = D3D11_CPU_ACCESS_WRITE,
+        .MiscFlags = 0u,
+        .StructureByteStride = 0u,
+    };
+    hr = deviceResources->m_Device->CreateBuffer(&constantBufferDesc, nullptr, &g_ParticleRenderer.m_ConstantBuffer);
+    ValidateHRESULT(hr);
+
+    ID3DBlob* blob = nullptr;
+    DEFER(SAFE_RELEASE(blob));
+
+    hr = D3DReadFileToBlob(L"particlevertexshader.cso", &blob);
+    ValidateHRESULT(hr);
+
+    hr = deviceResources->m_Device->CreateVertexShader(
+        blob->GetBufferPointer(),
+        blob->GetBufferSize(),
+        nullptr,
+        &g_ParticleRenderer.m_VertexShader);
+    ValidateHRESULT(hr);
+
+    constexpr auto inputLayoutDesc = VertexInputLayout<ParticleInstance>(D3D11_INPUT_PER_INSTANCE_DATA);
+
+    hr = deviceResources->m_Device->CreateInputLayout(
+        inputLayoutDesc.data(),
+        static_cast<u32>(inputLayoutDesc.size()),
+        blob->GetBufferPointer(),
+        blob->GetBufferSize(),
+        &g_ParticleRenderer.m_InputLayout);
+    ValidateHRESULT(hr);
+
+    SAFE_RELEASE(blob);
+    hr = D3DReadFileToBlob(L"particlepixelshader.cso", &blob);
+    ValidateHRESULT(hr);
+
+    hr = deviceResources->m_Device->CreatePixelShader(
+        blob->GetBufferPointer(),
+        blob->GetBufferSize(),
+        nullptr,
+        &g_ParticleRenderer.m_PixelShader);
+    ValidateHRESULT(hr);
+}
+
+void ParticleRendererDraw(
+    const ParticleEmitter* const* emitters,
+    const u32 emitterCount,
+    const float particleSize,
+    const DeviceResources* const deviceResources)
+{
+    ID3D11DeviceContext* context = deviceResources->m_DeviceContext;
+
+    // NOTE(sbalse): The emitters write their instances straight into the mapped buffer, one after the other.
+    D3D11_MAPPED_SUBRESOURCE mappedResource = {};
+    HRESULT hr = context->Map(g_ParticleRenderer.m_InstanceBuffer, 0u, D3D11_MAP_WRITE_DISCARD, 0u, &mappedResource);
+    ValidateHRESULT(hr);
+
+    ParticleInstance* instances = static_cast<ParticleInstance*>(mappedResource.pData);
+    u32 instanceCount = 0;
+    for (u32 i = 0; i < emitterCount; i++)
+    {
+        instanceCount += ParticleEmitterWriteInstances(
+            emitters[i],
+            instances + instanceCount,
+            g_ParticleRenderer.m_MaxParticles - instanceCount);
+    }
+    context->Unmap(g_ParticleRenderer.m_InstanceBuffer, 0u);
+
+    if (instanceCount == 0)
+    {
+        return;
+    }
+
+    const ParticleConstantBuffer constants =
+    {
+        .m_Projection = XMMatrixTranspose(g_ProjectionMatrix),
+        .m_HalfSize = { particleSize * 0.5f, particleSize * 0.5f },
+    };
+
+    hr = context->Map(g_ParticleRenderer.m_ConstantBuffer, 0u, D3D11_MAP_WRITE_DISCARD, 0u, &mappedResource);
+    ValidateHRESULT(hr);
+    std::memcpy(mappedResource.pData, &constants, sizeof(constants));
+    context->Unmap(g_ParticleRenderer.m_ConstantBuffer, 0u);
+
+    constexpr u32 stride = VertexStride<ParticleInstance>();
+    constexpr u32 offset = 0u;
+    context->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+    context->IASetInputLayout(g_ParticleRenderer.m_InputLayout);
+    context->IASetVertexBuffers(0u, 1u, &g_ParticleRenderer.m_InstanceBuffer, &stride, &offset);
+    context->VSSetShader(g_ParticleRenderer.m_VertexShader, nullptr, 0u);
+    context->VSSetConstantBuffers(0u, 1u, &g_ParticleRenderer.m_ConstantBuffer);
+    context->PSSetShader(g_ParticleRenderer.m_PixelShader, nullptr, 0u);
+    context->OMSetDepthStencilState(
+        ResourceGetDepthStencilState(deviceResources->m_Resources, deviceResources->m_DepthStencilState),
+        1u);
+    context->DrawInstanced(4u, instanceCount, 0u, 0u);
+
+    StatsAddCounter(StatsCounter::DRAWCALLS, 1);
+    StatsAddCounter(StatsCounter::PARTICLES, instanceCount);
+    StatsAddCounter(StatsCounter::BYTESUPLOADED, instanceCount * stride + sizeof(constants));
+}
+
+void ParticleRendererDestroy()
+{
+    SAFE_RELEASE(g_ParticleRenderer.m_InputLayout);
+    SAFE_RELEASE(g_ParticleRenderer.m_PixelShader);
+    SAFE_RELEASE(g_ParticleRenderer.m_VertexShader);
+    SAFE_RELEASE(g_ParticleRenderer.m_ConstantBuffer);
+    SAFE_RELEASE(g_ParticleRenderer.m_InstanceBuffer);
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "types.h"
+#include "graphics/graphicsutils.h"
+
+struct ParticleEmitter;
+
+// NOTE(sbalse): Draws the particles of any number of emitters with one instanced draw call. Every particle is
+// one instance of a camera facing quad.
+void ParticleRendererInit(const DeviceResources* const deviceResources, const u32 maxParticles);
+void ParticleRendererDraw(
+    const ParticleEmitter* const* emitters,
+    const u32 emitterCount,
+    const float particleSize,
+    const DeviceResources* const deviceResources);
+void ParticleRendererDestroy();
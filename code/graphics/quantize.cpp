@@ -0,0 +1,150 @@
+#include "graphics/quantize.h"
+
+#include <cmath>
+
+namespace
+{
+    float QuantizeSignNotZero(const float value)
+    {
+        return value >= 0.0f ? 1.0f : -1.0f;
+    }
+}
+
+OctahedralNormal QuantizeOctahedral(const float x, const float y, const float z)
+{
+    const float length = std::fabs(x) + std::fabs(y) + std::fabs(z);
+    if (length == 0.0f)
+    {
+        return { 0, 0 };
+    }
+
+    // NOTE(sbalse): Project onto the octahedron |x| + |y| + |z| = 1, then fold the lower half over the upper.
+    float u = x / length;
+    float v = y / length;
+    if (z < 0.0f)
+    {
+        const float foldedU = (1.0f - std::fabs(v)) * QuantizeSignNotZero(u);
+        const float foldedV = (1.0f - std::fabs(u)) * QuantizeSignNotZero(v);
+        u = foldedU;
+        v = foldedV;
+    }
+
+    // NOTE(sbalse): Rounding each coordinate on its own is not the closest encoding on the sphere. Try the four
+    // surrounding grid points and keep the one that decodes closest to the input. Compare squared distances,
+    // a dot product this close to 1 has too little float precision left to rank the candidates.
+    const float inverseLength = 1.0f / std::sqrt(x * x + y * y + z * z);
+    const float normalX = x * inverseLength;
+    const float normalY = y * inverseLength;
+    const float normalZ = z * inverseLength;
+    const float baseU = std::floor(u * 32767.0f);
+    const float baseV = std::floor(v * 32767.0f);
+
+    OctahedralNormal result = { QuantizeSnorm16(u), QuantizeSnorm16(v) };
+    float bestDistance = 8.0f;
+    for (u32 i = 0; i < 4; i++)
+    {
+        const float candidateU = std::fmin(std::fmax(baseU + static_cast<float>(i & 1), -32767.0f), 32767.0f);
+        const float candidateV = std::fmin(std::fmax(baseV + static_cast<float>(i >> 1), -32767.0f), 32767.0f);
+        const OctahedralNormal candidate = { static_cast<i16>(candidateU), static_cast<i16>(candidateV) };
+
+        const Float3 decoded = DequantizeOctahedral(candidate);
+        const float dx = decoded.m_X - normalX;
+        const float dy = decoded.m_Y - normalY;
+        const float dz = decoded.m_Z - normalZ;
+        const float distance = dx * dx + dy * dy + dz * dz;
+        if (distance < bestDistance)
+        {
+            bestDistance = distance;
+            result = candidate;
+        }
+    }
+
+    return result;
+}
+
+Float3 DequantizeOctahedral(const OctahedralNormal normal)
+{
+    float x = DequantizeSnorm16(normal.m_X);
+    float y = DequantizeSnorm16(normal.m_Y);
+    const float z = 1.0f - std::fabs(x) - std::fabs(y);
+
+    // NOTE(sbalse): Unfold the lower half.
+    const float t = z < 0.0f ? -z : 0.0f;
+    x += x >= 0.0f ? -t : t;
+    y += y >= 0.0f ? -t : t;
+
+    const float inverseLength = 1.0f / std::sqrt(x * x + y * y + z * z);
+    return { x * inverseLength, y * inverseLength, z * inverseLength };
+}
+
+float QuantizePositionScale(const Float3* positions, const u32 count)
+{
+    float scale = 0.0f;
+    for (u32 i = 0; i < count; i++)
+    {
+        scale = std::fmax(scale, std::fabs(positions[i].m_X));
+        scale = std::fmax(scale, std::fabs(positions[i].m_Y));
+        scale = std::fmax(scale, std::fabs(positions[i].m_Z));
+    }
+    return scale > 0.0f ? scale : 1.0f;
+}
+
+void QuantizePositions(const Float3* positions, const u32 count, const float scale, Snorm16x4* result)
+{
+    const float inverseScale = 1.0f / scale;
+    for (u32 i = 0; i < count; i++)
+    {
+        result[i] =
+        {
+            .m_X = QuantizeSnorm16(positions[i].m_X * inverseScale),
+            .m_Y = QuantizeSnorm16(positions[i].m_Y * inverseScale),
+            .m_Z = QuantizeSnorm16(positions[i].m_Z * inverseScale),
+            .m_W = 0,
+        };
+    }
+}
+
+void DequantizePositions(const Snorm16x4* positions, const u32 count, const float scale, Float3* result)
+{
+    for (u32 i = 0; i < count; i++)
+    {
+        result[i] =
+        {
+            .m_X = DequantizeSnorm16(positions[i].m_X) * scale,
+            .m_Y = DequantizeSnorm16(positions[i].m_Y) * scale,
+            .m_Z = DequantizeSnorm16(positions[i].m_Z) * scale,
+        };
+    }
+}
+
+void QuantizeNormals(const Float3* normals, const u32 count, OctahedralNormal* result)
+{
+    for (u32 i = 0; i < count; i++)
+    {
+        result[i] = QuantizeOctahedral(normals[i].m_X, normals[i].m_Y, normals[i].m_Z);
+    }
+}
+
+void DequantizeNormals(const OctahedralNormal* normals, const u32 count, Float3* result)
+{
+    for (u32 i = 0; i < count; i++)
+    {
+        result[i] = DequantizeOctahedral(normals[i]);
+    }
+}
+
+void QuantizeTexCoords(const Float2* texCoords, const u32 count, Half2* result)
+{
+    for (u32 i = 0; i < count; i++)
+    {
+        result[i] = { QuantizeHalf(texCoords[i].m_X), QuantizeHalf(texCoords[i].m_Y) };
+    }
+}
+
+void DequantizeTexCoords(const Half2* texCoords, const u32 count, Float2* result)
+{
+    for (u32 i = 0; i < count; i++)
+    {
+        result[i] = { DequantizeHalf(texCoords[i].m_X), DequantizeHalf(texCoords[i].m_Y) };
+    }
+}
@@ -0,0 +1,226 @@
+#pragma once
+#include <bit>
+
+#include "types.h"
+
+/*
+* NOTE(sbalse): Compact encodings for vertex attributes, laid out the way the GPU reads them:
+*   - Snorm16: [-1, 1] in a signed 16-bit integer. Used for positions, with the mesh scaled into the unit
+*     cube first and the scale put back by the world transform.
+*   - Half: IEEE 754 binary16. Used for texture coordinates.
+*   - Octahedral: unit vectors folded onto an octahedron and stored as two Snorm16. Used for normals.
+* The scalar conversions are constexpr so constant vertex data can be encoded at compile time.
+*/
+
+struct Float2
+{
+    float m_X;
+    float m_Y;
+};
+
+struct Float3
+{
+    float m_X;
+    float m_Y;
+    float m_Z;
+};
+
+struct Snorm16x2
+{
+    i16 m_X;
+    i16 m_Y;
+};
+
+// NOTE(sbalse): There are no three component 16-bit vertex formats, the fourth component is padding.
+struct Snorm16x4
+{
+    i16 m_X;
+    i16 m_Y;
+    i16 m_Z;
+    i16 m_W;
+};
+
+struct Half2
+{
+    u16 m_X;
+    u16 m_Y;
+};
+
+struct OctahedralNormal
+{
+    i16 m_X;
+    i16 m_Y;
+};
+
+// NOTE(sbalse): R8G8B8A8, red in the lowest byte.
+struct Unorm8x4
+{
+    u32 m_RGBA;
+};
+
+// NOTE(sbalse): Worst case round trip errors of the encodings. The Snorm16 bound includes one float ulp at 1
+// for the rounding of the scale.
+constexpr float QUANTIZE_SNORM16_MAX_ERROR = 0.5f / 32767.0f + 1.0f / 16777216.0f;
+constexpr float QUANTIZE_HALF_MAX_RELATIVE_ERROR = 1.0f / 2048.0f; // NOTE(sbalse): For normal halfs.
+constexpr float QUANTIZE_OCTAHEDRAL_MAX_ANGLE_ERROR = 0.00005f; // NOTE(sbalse): Radians, about 0.003 degrees.
+constexpr float QUANTIZE_OCTAHEDRAL_FAST_MAX_ANGLE_ERROR = 0.00008f; // NOTE(sbalse): Radians.
+
+constexpr i16 QuantizeSnorm16(float value)
+{
+    if (value != value)
+    {
+        return 0; // NOTE(sbalse): NaN.
+    }
+
+    value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+    const float scaled = value * 32767.0f;
+    return static_cast<i16>(scaled >= 0.0f ? scaled + 0.5f : scaled - 0.5f);
+}
+
+// NOTE(sbalse): Same as the GPU. Both -32768 and -32767 decode to -1.
+constexpr float DequantizeSnorm16(const i16 value)
+{
+    const float result = static_cast<float>(value) / 32767.0f;
+    return result < -1.0f ? -1.0f : result;
+}
+
+// NOTE(sbalse): Rounds to nearest even. Overflows to infinity, keeps NaN a NaN.
+constexpr u16 QuantizeHalf(const float value)
+{
+    const u32 bits = std::bit_cast<u32>(value);
+    const u32 sign = (bits >> 16) & 0x8000;
+    const u32 exponent = (bits >> 23) & 0xFF;
+    u32 mantissa = bits & 0x7FFFFF;
+
+    if (exponent == 0xFF)
+    {
+        return static_cast<u16>(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+    }
+
+    const i32 halfExponent = static_cast<i32>(exponent) - 127 + 15;
+    if (halfExponent >= 31)
+    {
+        return static_cast<u16>(sign | 0x7C00);
+    }
+
+    if (halfExponent <= 0)
+    {
+        // NOTE(sbalse): Subnormal half, or too small to be anything but zero.
+        if (halfExponent < -10)
+        {
+            return static_cast<u16>(sign);
+        }
+
+        mantissa |= 0x800000;
+        const u32 shift = static_cast<u32>(14 - halfExponent);
+        u32 half = mantissa >> shift;
+        const u32 remainder = mantissa & ((1u << shift) - 1);
+        const u32 halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half & 1)))
+        {
+            half++;
+        }
+        return static_cast<u16>(sign | half);
+    }
+
+    u32 half = (static_cast<u32>(halfExponent) << 10) | (mantissa >> 13);
+    const u32 remainder = mantissa & 0x1FFF;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+    {
+        half++; // NOTE(sbalse): May carry into the exponent, which is still the right answer.
+    }
+    return static_cast<u16>(sign | half);
+}
+
+constexpr float DequantizeHalf(const u16 value)
+{
+    const u32 sign = static_cast<u32>(value & 0x8000) << 16;
+    const u32 exponent = (value >> 10) & 0x1F;
+    u32 mantissa = value & 0x3FF;
+
+    if (exponent == 0)
+    {
+        if (mantissa == 0)
+        {
+            return std::bit_cast<float>(sign);
+        }
+
+        // NOTE(sbalse): Subnormal half, normal float.
+        i32 normalizedExponent = 1;
+        while ((mantissa & 0x400) == 0)
+        {
+            mantissa <<= 1;
+            normalizedExponent--;
+        }
+        mantissa &= 0x3FF;
+        const u32 floatExponent = static_cast<u32>(normalizedExponent + 127 - 15);
+        return std::bit_cast<float>(sign | (floatExponent << 23) | (mantissa << 13));
+    }
+
+    if (exponent == 31)
+    {
+        return std::bit_cast<float>(sign | 0x7F800000 | (mantissa << 13));
+    }
+
+    return std::bit_cast<float>(sign | ((exponent + 127 - 15) << 23) | (mantissa << 13));
+}
+
+constexpr Unorm8x4 QuantizeColor(const float r, const float g, const float b, const float a)
+{
+    const auto channel = [](float value) -> u32
+    {
+        value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+        return static_cast<u32>(value * 255.0f + 0.5f);
+    };
+    return { channel(r) | (channel(g) << 8) | (channel(b) << 16) | (channel(a) << 24) };
+}
+
+// NOTE(sbalse): Rounds each coordinate on its own. About 1.5x the error of QuantizeOctahedral(), but it is
+// constexpr and cheap enough to vectorize, which is what generated meshes need.
+constexpr OctahedralNormal QuantizeOctahedralFast(const float x, const float y, const float z)
+{
+    const float absX = x < 0.0f ? -x : x;
+    const float absY = y < 0.0f ? -y : y;
+    const float absZ = z < 0.0f ? -z : z;
+    const float length = absX + absY + absZ;
+    if (length == 0.0f)
+    {
+        return { 0, 0 };
+    }
+
+    float u = x / length;
+    float v = y / length;
+    if (z < 0.0f)
+    {
+        const float absU = u < 0.0f ? -u : u;
+        const float absV = v < 0.0f ? -v : v;
+        const float foldedU = (1.0f - absV) * (u >= 0.0f ? 1.0f : -1.0f);
+        const float foldedV = (1.0f - absU) * (v >= 0.0f ? 1.0f : -1.0f);
+        u = foldedU;
+        v = foldedV;
+    }
+
+    return { QuantizeSnorm16(u), QuantizeSnorm16(v) };
+}
+
+// NOTE(sbalse): The direction does not need to be normalized, the result of decoding is.
+OctahedralNormal QuantizeOctahedral(const float x, const float y, const float z);
+Float3 DequantizeOctahedral(const OctahedralNormal normal);
+
+// NOTE(sbalse): Array kernels. Positions are divided by scale before encoding, so every component has to
+// lie within [-scale, scale]. Use QuantizePositionScale() to find the smallest such scale.
+float QuantizePositionScale(const Float3* positions, const u32 count);
+void QuantizePositions(const Float3* positions, const u32 count, const float scale, Snorm16x4* result);
+void DequantizePositions(const Snorm16x4* positions, const u32 count, const float scale, Float3* result);
+void QuantizeNormals(const Float3* normals, const u32 count, OctahedralNormal* result);
+void DequantizeNormals(const OctahedralNormal* normals, const u32 count, Float3* result);
+void QuantizeTexCoords(const Float2* texCoords, const u32 count, Half2* result);
+void DequantizeTexCoords(const Half2* texCoords, const u32 count, Float2* result);
+
+// NOTE(sbalse): Compile time spot checks of the scalar encodings.
+static_assert(QuantizeSnorm16(1.0f) == 32767 && QuantizeSnorm16(-1.0f) == -32767 && QuantizeSnorm16(0.0f) == 0);
+static_assert(DequantizeSnorm16(-32768) == -1.0f);
+static_assert(DequantizeSnorm16(QuantizeSnorm16(0.5f)) - 0.5f <= QUANTIZE_SNORM16_MAX_ERROR);
+static_assert(QuantizeHalf(1.0f) == 0x3C00 && QuantizeHalf(-2.0f) == 0xC000 && QuantizeHalf(65504.0f) == 0x7BFF);
+static_assert(QuantizeHalf(65520.0f) == 0x7C00 && QuantizeHalf(5.9604645e-8f) == 0x0001);
+static_assert(DequantizeHalf(QuantizeHalf(0.333333f)) == 0.333251953125f);
@@ -0,0 +1,568 @@
+#include "graphics/rendergraph.h"
+
+#include <bit>
+#include <cstdlib>
+
+#include "clock.h"
+
+namespace
+{
+    constexpr u32 RENDERGRAPH_NONE = 0xFFFFFFFF;
+
+    struct RenderGraphPassUse
+    {
+        u32 m_Texture;
+        RenderGraphUsage m_Usage;
+    };
+
+    struct RenderGraphPass
+    {
+        const char* m_Name;
+        RenderGraphExecuteFunc* m_Execute;
+        void* m_UserData;
+        RenderGraphPassUse m_Uses[RENDERGRAPH_MAX_PASS_USES];
+        u32 m_UseCount;
+        u64 m_Dependencies; // NOTE(sbalse): One bit per earlier pass that has to run first.
+        bool m_IsRoot;
+    };
+
+    struct RenderGraphTexture
+    {
+        const char* m_Name;
+        RenderGraphTextureDesc m_Desc;
+        bool m_IsImported;
+
+        // NOTE(sbalse): Imported textures only.
+        void* m_Native;
+        RenderGraphUsage m_State;
+        RenderGraphUsage m_FinalState;
+
+        // NOTE(sbalse): Filled in while declaring passes.
+        u32 m_LastWriter;
+        u64 m_ReadersSinceWrite;
+
+        // NOTE(sbalse): Filled in by compile. Positions in the execution order.
+        u32 m_FirstUse;
+        u32 m_LastUse;
+        u32 m_Physical;
+    };
+
+    struct RenderGraphPhysical
+    {
+        RenderGraphTextureDesc m_Desc;
+        void* m_Native;
+        RenderGraphUsage m_State;
+        u64 m_LastUsedFrame;
+        u32 m_BusyUntil; // NOTE(sbalse): Last use of the transient currently placed in it, during compile.
+    };
+
+    bool RenderGraphIsWrite(const RenderGraphUsage usage)
+    {
+        return usage == RenderGraphUsage::RENDERTARGET || usage == RenderGraphUsage::DEPTHWRITE;
+    }
+
+    u32 RenderGraphBindFlagsFor(const RenderGraphUsage usage)
+    {
+        switch (usage)
+        {
+            case RenderGraphUsage::RENDERTARGET: return RENDERGRAPH_BIND_RENDERTARGET;
+            case RenderGraphUsage::DEPTHWRITE: return RENDERGRAPH_BIND_DEPTHSTENCIL;
+            case RenderGraphUsage::DEPTHREAD: return RENDERGRAPH_BIND_DEPTHSTENCIL;
+            case RenderGraphUsage::SHADERREAD: return RENDERGRAPH_BIND_SHADERRESOURCE;
+            default: return 0;
+        }
+    }
+
+    bool RenderGraphSameDesc(const RenderGraphTextureDesc* a, const RenderGraphTextureDesc* b)
+    {
+        return a->m_Width == b->m_Width
+            && a->m_Height == b->m_Height
+            && a->m_Format == b->m_Format
+            && a->m_BindFlags == b->m_BindFlags;
+    }
+
+    u64 RenderGraphTextureBytes(const RenderGraphTextureDesc* desc)
+    {
+        return static_cast<u64>(desc->m_Width) * desc->m_Height * RenderGraphFormatBytesPerPixel(desc->m_Format);
+    }
+}
+
+struct RenderGraph
+{
+    RenderGraphBackend m_Backend;
+
+    RenderGraphPass m_Passes[RENDERGRAPH_MAX_PASSES];
+    u32 m_PassCount;
+    RenderGraphTexture m_Textures[RENDERGRAPH_MAX_RESOURCES];
+    u32 m_TextureCount;
+    bool m_Overflowed;
+
+    u32 m_Order[RENDERGRAPH_MAX_PASSES];
+    u32 m_OrderCount;
+    u32 m_ExecutingPosition;
+
+    RenderGraphPhysical m_Physical[RENDERGRAPH_MAX_PHYSICAL];
+    u32 m_PhysicalCount;
+
+    u64 m_Frame;
+    RenderGraphStats m_Stats;
+};
+
+namespace
+{
+    RenderGraphUsage* RenderGraphStateOf(RenderGraph* graph, RenderGraphTexture* texture)
+    {
+        return texture->m_IsImported ? &texture->m_State : &graph->m_Physical[texture->m_Physical].m_State;
+    }
+
+    void RenderGraphTransition(RenderGraph* graph, RenderGraphTexture* texture, const RenderGraphUsage usage)
+    {
+        RenderGraphUsage* state = RenderGraphStateOf(graph, texture);
+        if (*state == usage)
+        {
+            return;
+        }
+
+        void* native = RenderGraphGetNative(graph, { static_cast<u32>(texture - graph->m_Textures) });
+        graph->m_Backend.m_Transition(graph->m_Backend.m_Context, native, *state, usage);
+        *state = usage;
+        graph->m_Stats.m_Transitions++;
+    }
+
+    // NOTE(sbalse): Destroys physical textures that have not been used for a while, e.g. after a resize.
+    void RenderGraphRetirePhysical(RenderGraph* graph)
+    {
+        u32 i = 0;
+        while (i < graph->m_PhysicalCount)
+        {
+            RenderGraphPhysical* physical = &graph->m_Physical[i];
+            if (physical->m_LastUsedFrame + RENDERGRAPH_PHYSICAL_RETIRE_FRAMES < graph->m_Frame)
+            {
+                graph->m_Backend.m_DestroyTexture(graph->m_Backend.m_Context, physical->m_Native);
+                *physical = graph->m_Physical[--graph->m_PhysicalCount];
+            }
+            else
+            {
+                i++;
+            }
+        }
+    }
+
+    // NOTE(sbalse): Greedy interval allocation. Transients are placed in the order they start, each into the
+    // first matching physical texture that is free by then.
+    bool RenderGraphAllocateTransient(RenderGraph* graph, RenderGraphTexture* texture)
+    {
+        for (u32 i = 0; i < graph->m_PhysicalCount; i++)
+        {
+            RenderGraphPhysical* physical = &graph->m_Physical[i];
+            const bool isFree = physical->m_BusyUntil == RENDERGRAPH_NONE
+                || physical->m_BusyUntil < texture->m_FirstUse;
+            if (isFree && RenderGraphSameDesc(&physical->m_Desc, &texture->m_Desc))
+            {
+                // NOTE(sbalse): Count each physical texture once per frame, however many transients it backs.
+                if (physical->m_BusyUntil == RENDERGRAPH_NONE)
+                {
+                    graph->m_Stats.m_PhysicalTextures++;
+                    graph->m_Stats.m_PhysicalBytes += RenderGraphTextureBytes(&physical->m_Desc);
+                }
+
+                physical->m_BusyUntil = texture->m_LastUse;
+                physical->m_LastUsedFrame = graph->m_Frame;
+                texture->m_Physical = i;
+                return true;
+            }
+        }
+
+        if (graph->m_PhysicalCount == RENDERGRAPH_MAX_PHYSICAL)
+        {
+            return false;
+        }
+
+        void* native = graph->m_Backend.m_CreateTexture(graph->m_Backend.m_Context, &texture->m_Desc);
+        if (!native)
+        {
+            return false;
+        }
+
+        const u32 index = graph->m_PhysicalCount++;
+        graph->m_Physical[index] =
+        {
+            .m_Desc = texture->m_Desc,
+            .m_Native = native,
+            .m_State = RenderGraphUsage::UNDEFINED,
+            .m_LastUsedFrame = graph->m_Frame,
+            .m_BusyUntil = texture->m_LastUse,
+        };
+        texture->m_Physical = index;
+
+        graph->m_Stats.m_PhysicalTextures++;
+        graph->m_Stats.m_PhysicalBytes += RenderGraphTextureBytes(&texture->m_Desc);
+        return true;
+    }
+
+    void* RenderGraphNullCreateTexture(void* context, const RenderGraphTextureDesc*)
+    {
+        RenderGraphNullDevice* device = static_cast<RenderGraphNullDevice*>(context);
+        device->m_Creates++;
+        device->m_LiveTextures++;
+        return reinterpret_cast<void*>(++device->m_NextTexture);
+    }
+
+    void RenderGraphNullDestroyTexture(void* context, void*)
+    {
+        RenderGraphNullDevice* device = static_cast<RenderGraphNullDevice*>(context);
+        device->m_LiveTextures--;
+    }
+
+    void RenderGraphNullTransition(void* context, void*, const RenderGraphUsage, const RenderGraphUsage)
+    {
+        RenderGraphNullDevice* device = static_cast<RenderGraphNullDevice*>(context);
+        device->m_Transitions++;
+    }
+}
+
+RenderGraph* RenderGraphCreate(const RenderGraphBackend* backend)
+{
+    RenderGraph* graph = static_cast<RenderGraph*>(std::calloc(1, sizeof(RenderGraph)));
+    if (!graph)
+    {
+        return nullptr;
+    }
+
+    graph->m_Backend = *backend;
+    return graph;
+}
+
+void RenderGraphDestroy(RenderGraph* graph)
+{
+    if (!graph)
+    {
+        return;
+    }
+
+    for (u32 i = 0; i < graph->m_PhysicalCount; i++)
+    {
+        graph->m_Backend.m_DestroyTexture(graph->m_Backend.m_Context, graph->m_Physical[i].m_Native);
+    }
+
+    std::free(graph);
+}
+
+void RenderGraphReset(RenderGraph* graph)
+{
+    graph->m_PassCount = 0;
+    graph->m_TextureCount = 0;
+    graph->m_OrderCount = 0;
+    graph->m_Overflowed = false;
+    graph->m_Frame++;
+}
+
+RenderGraphResource RenderGraphImportTexture(
+    RenderGraph* graph,
+    const char* name,
+    const RenderGraphTextureDesc* desc,
+    void* native,
+    const RenderGraphUsage initialState,
+    const RenderGraphUsage finalState)
+{
+    if (graph->m_TextureCount == RENDERGRAPH_MAX_RESOURCES)
+    {
+        graph->m_Overflowed = true;
+        return RENDERGRAPH_INVALID_RESOURCE;
+    }
+
+    const u32 index = graph->m_TextureCount++;
+    graph->m_Textures[index] =
+    {
+        .m_Name = name,
+        .m_Desc = *desc,
+        .m_IsImported = true,
+        .m_Native = native,
+        .m_State = initialState,
+        .m_FinalState = finalState,
+        .m_LastWriter = RENDERGRAPH_NONE,
+        .m_ReadersSinceWrite = 0,
+        .m_FirstUse = RENDERGRAPH_NONE,
+        .m_LastUse = 0,
+        .m_Physical = RENDERGRAPH_NONE,
+    };
+    return { index };
+}
+
+RenderGraphResource RenderGraphCreateTexture(
+    RenderGraph* graph,
+    const char* name,
+    const u32 width,
+    const u32 height,
+    const RenderGraphFormat format)
+{
+    if (graph->m_TextureCount == RENDERGRAPH_MAX_RESOURCES)
+    {
+        graph->m_Overflowed = true;
+        return RENDERGRAPH_INVALID_RESOURCE;
+    }
+
+    const u32 index = graph->m_TextureCount++;
+    graph->m_Textures[index] =
+    {
+        .m_Name = name,
+        .m_Desc =
+        {
+            .m_Width = width,
+            .m_Height = height,
+            .m_Format = format,
+            .m_BindFlags = 0,
+        },
+        .m_IsImported = false,
+        .m_Native = nullptr,
+        .m_State = RenderGraphUsage::UNDEFINED,
+        .m_FinalState = RenderGraphUsage::UNDEFINED,
+        .m_LastWriter = RENDERGRAPH_NONE,
+        .m_ReadersSinceWrite = 0,
+        .m_FirstUse = RENDERGRAPH_NONE,
+        .m_LastUse = 0,
+        .m_Physical = RENDERGRAPH_NONE,
+    };
+    return { index };
+}
+
+u32 RenderGraphAddPass(
+    RenderGraph* graph,
+    const char* name,
+    RenderGraphExecuteFunc* execute,
+    void* userData,
+    const bool hasSideEffects)
+{
+    if (graph->m_PassCount == RENDERGRAPH_MAX_PASSES)
+    {
+        graph->m_Overflowed = true;
+        return RENDERGRAPH_INVALID_PASS;
+    }
+
+    const u32 index = graph->m_PassCount++;
+    RenderGraphPass* pass = &graph->m_Passes[index];
+    pass->m_Name = name;
+    pass->m_Execute = execute;
+    pass->m_UserData = userData;
+    pass->m_UseCount = 0;
+    pass->m_Dependencies = 0;
+    pass->m_IsRoot = hasSideEffects;
+    return index;
+}
+
+void RenderGraphUse(
+    RenderGraph* graph,
+    const u32 pass,
+    const RenderGraphResource resource,
+    const RenderGraphUsage usage)
+{
+    if (pass >= graph->m_PassCount || resource.m_Index >= graph->m_TextureCount)
+    {
+        graph->m_Overflowed = true; // NOTE(sbalse): Using something that failed to declare.
+        return;
+    }
+
+    RenderGraphPass* renderPass = &graph->m_Passes[pass];
+    if (renderPass->m_UseCount == RENDERGRAPH_MAX_PASS_USES)
+    {
+        graph->m_Overflowed = true;
+        return;
+    }
+    renderPass->m_Uses[renderPass->m_UseCount++] = { .m_Texture = resource.m_Index, .m_Usage = usage };
+
+    RenderGraphTexture* texture = &graph->m_Textures[resource.m_Index];
+    const u64 passBit = 1ull << pass;
+
+    // NOTE(sbalse): Everything runs after the last write. Writes also wait for the reads of the previous
+    // contents to finish.
+    if (texture->m_LastWriter != RENDERGRAPH_NONE)
+    {
+        renderPass->m_Dependencies |= 1ull << texture->m_LastWriter;
+    }
+
+    if (RenderGraphIsWrite(usage))
+    {
+        renderPass->m_Dependencies |= texture->m_ReadersSinceWrite;
+        texture->m_LastWriter = pass;
+        texture->m_ReadersSinceWrite = 0;
+        renderPass->m_IsRoot = renderPass->m_IsRoot || texture->m_IsImported;
+    }
+    else
+    {
+        texture->m_ReadersSinceWrite |= passBit;
+    }
+
+    renderPass->m_Dependencies &= ~passBit;
+}
+
+bool RenderGraphCompile(RenderGraph* graph)
+{
+    const i64 start = ClockNow();
+
+    const u32 passCount = graph->m_PassCount;
+    graph->m_OrderCount = 0;
+    graph->m_Stats = {};
+    graph->m_Stats.m_DeclaredPasses = passCount;
+
+    if (graph->m_Overflowed)
+    {
+        return false;
+    }
+
+    // NOTE(sbalse): Cull. Dependencies only ever point at earlier passes, so one backwards sweep finds
+    // everything the roots need.
+    u64 alive = 0;
+    for (u32 i = passCount; i-- > 0;)
+    {
+        const u64 bit = 1ull << i;
+        if (graph->m_Passes[i].m_IsRoot)
+        {
+            alive |= bit;
+        }
+        if (alive & bit)
+        {
+            alive |= graph->m_Passes[i].m_Dependencies;
+        }
+    }
+
+    // NOTE(sbalse): Topological sort, always taking the earliest declared pass that is ready.
+    u64 remaining = alive;
+    while (remaining)
+    {
+        u64 candidates = remaining;
+        u32 next = RENDERGRAPH_NONE;
+        while (candidates)
+        {
+            const u32 i = static_cast<u32>(std::countr_zero(candidates));
+            if ((graph->m_Passes[i].m_Dependencies & remaining) == 0)
+            {
+                next = i;
+                break;
+            }
+            candidates &= candidates - 1;
+        }
+
+        if (next == RENDERGRAPH_NONE)
+        {
+            return false; // NOTE(sbalse): A cycle. Can't happen with declaration order dependencies.
+        }
+
+        graph->m_Order[graph->m_OrderCount++] = next;
+        remaining &= ~(1ull << next);
+    }
+
+    // NOTE(sbalse): Texture lifetimes and, for transients, how they have to be bindable.
+    for (u32 position = 0; position < graph->m_OrderCount; position++)
+    {
+        const RenderGraphPass* pass = &graph->m_Passes[graph->m_Order[position]];
+        for (u32 i = 0; i < pass->m_UseCount; i++)
+        {
+            RenderGraphTexture* texture = &graph->m_Textures[pass->m_Uses[i].m_Texture];
+            texture->m_FirstUse = texture->m_FirstUse == RENDERGRAPH_NONE ? position : texture->m_FirstUse;
+            texture->m_LastUse = position;
+            if (!texture->m_IsImported)
+            {
+                texture->m_Desc.m_BindFlags |= RenderGraphBindFlagsFor(pass->m_Uses[i].m_Usage);
+            }
+        }
+    }
+
+    RenderGraphRetirePhysical(graph);
+    for (u32 i = 0; i < graph->m_PhysicalCount; i++)
+    {
+        graph->m_Physical[i].m_BusyUntil = RENDERGRAPH_NONE;
+    }
+
+    for (u32 position = 0; position < graph->m_OrderCount; position++)
+    {
+        const RenderGraphPass* pass = &graph->m_Passes[graph->m_Order[position]];
+        for (u32 i = 0; i < pass->m_UseCount; i++)
+        {
+            RenderGraphTexture* texture = &graph->m_Textures[pass->m_Uses[i].m_Texture];
+            const bool isPlaced = texture->m_Physical != RENDERGRAPH_NONE;
+            if (texture->m_IsImported || texture->m_FirstUse != position || isPlaced)
+            {
+                continue;
+            }
+
+            if (!RenderGraphAllocateTransient(graph, texture))
+            {
+                return false;
+            }
+
+            graph->m_Stats.m_TransientTextures++;
+            graph->m_Stats.m_TransientBytes += RenderGraphTextureBytes(&texture->m_Desc);
+        }
+    }
+
+    graph->m_Stats.m_ExecutedPasses = graph->m_OrderCount;
+    graph->m_Stats.m_CulledPasses = passCount - graph->m_OrderCount;
+    graph->m_Stats.m_AliasedBytesSaved = graph->m_Stats.m_TransientBytes - graph->m_Stats.m_PhysicalBytes;
+    graph->m_Stats.m_CompileTimeUs = static_cast<float>(ClockTicksToSeconds(ClockNow() - start) * 1'000'000.0);
+    return true;
+}
+
+void RenderGraphExecute(RenderGraph* graph)
+{
+    for (u32 position = 0; position < graph->m_OrderCount; position++)
+    {
+        const RenderGraphPass* pass = &graph->m_Passes[graph->m_Order[position]];
+        for (u32 i = 0; i < pass->m_UseCount; i++)
+        {
+            const RenderGraphPassUse* use = &pass->m_Uses[i];
+            RenderGraphTransition(graph, &graph->m_Textures[use->m_Texture], use->m_Usage);
+        }
+
+        graph->m_ExecutingPosition = position;
+        pass->m_Execute(graph, pass->m_UserData);
+    }
+
+    for (u32 i = 0; i < graph->m_TextureCount; i++)
+    {
+        RenderGraphTexture* texture = &graph->m_Textures[i];
+        if (texture->m_IsImported && texture->m_FirstUse != RENDERGRAPH_NONE)
+        {
+            RenderGraphTransition(graph, texture, texture->m_FinalState);
+        }
+    }
+}
+
+void* RenderGraphGetNative(const RenderGraph* graph, const RenderGraphResource resource)
+{
+    const RenderGraphTexture* texture = &graph->m_Textures[resource.m_Index];
+    return texture->m_IsImported ? texture->m_Native : graph->m_Physical[texture->m_Physical].m_Native;
+}
+
+bool RenderGraphIsFirstUse(const RenderGraph* graph, const RenderGraphResource resource)
+{
+    return graph->m_Textures[resource.m_Index].m_FirstUse == graph->m_ExecutingPosition;
+}
+
+const RenderGraphStats* RenderGraphGetStats(const RenderGraph* graph)
+{
+    return &graph->m_Stats;
+}
+
+u32 RenderGraphFormatBytesPerPixel(const RenderGraphFormat format)
+{
+    switch (format)
+    {
+        case RenderGraphFormat::RGBA8_UNORM: return 4;
+        case RenderGraphFormat::BGRA8_UNORM: return 4;
+        case RenderGraphFormat::RGBA16_FLOAT: return 8;
+        case RenderGraphFormat::D32_FLOAT: return 4;
+        default: return 0;
+    }
+}
+
+RenderGraphBackend RenderGraphNullBackend(RenderGraphNullDevice* device)
+{
+    const RenderGraphBackend result =
+    {
+        .m_Context = device,
+        .m_CreateTexture = RenderGraphNullCreateTexture,
+        .m_DestroyTexture = RenderGraphNullDestroyTexture,
+        .m_Transition = RenderGraphNullTransition,
+    };
+    return result;
+}
@@ -0,0 +1,149 @@
+#pragma once
+#include "types.h"
+
+/*
+* NOTE(sbalse): Frame graph. Every frame the renderer declares its passes and the textures they use, then
+* compiles and executes the graph:
+*   - Passes that contribute nothing to an output (an imported texture or a pass marked as having side
+*     effects) are culled.
+*   - Passes run in a topological order of their dependencies. Dependencies follow from declaration order:
+*     a pass depends on the last earlier writer of everything it uses, and a writer also on earlier readers.
+*   - Before each pass, textures are transitioned into the state the pass needs.
+*   - Transient textures only live between their first and last use. Transients with the same description
+*     and lifetimes that don't overlap share one physical texture. Physical textures are kept across frames
+*     and destroyed once they went unused for a while.
+*
+* Compiling does no allocations and only walks small fixed size arrays, so it is cheap enough to run every
+* frame. The GPU is reached through a RenderGraphBackend, the null backend below creates nothing.
+*/
+
+constexpr u32 RENDERGRAPH_MAX_PASSES = 64; // NOTE(sbalse): Pass dependencies are kept in one u64 per pass.
+constexpr u32 RENDERGRAPH_MAX_RESOURCES = 64;
+constexpr u32 RENDERGRAPH_MAX_PASS_USES = 8;
+constexpr u32 RENDERGRAPH_MAX_PHYSICAL = 32;
+// NOTE(sbalse): Physical textures not used for this many frames are destroyed.
+constexpr u32 RENDERGRAPH_PHYSICAL_RETIRE_FRAMES = 8;
+
+enum class RenderGraphFormat
+{
+    RGBA8_UNORM,
+    BGRA8_UNORM,
+    RGBA16_FLOAT,
+    D32_FLOAT,
+    COUNT
+};
+
+// NOTE(sbalse): How a pass uses a texture. This is also the state the texture has to be in for the pass.
+enum class RenderGraphUsage
+{
+    UNDEFINED, // NOTE(sbalse): Only a state. Transients start out like this, their contents are garbage.
+    RENDERTARGET,
+    DEPTHWRITE,
+    DEPTHREAD,
+    SHADERREAD,
+    PRESENT, // NOTE(sbalse): Only a state, used for the back buffer.
+    COUNT
+};
+
+// NOTE(sbalse): Bit flags built from the usages of a texture, used to create physical textures.
+enum RenderGraphBind : u32
+{
+    RENDERGRAPH_BIND_RENDERTARGET = 1 << 0,
+    RENDERGRAPH_BIND_DEPTHSTENCIL = 1 << 1,
+    RENDERGRAPH_BIND_SHADERRESOURCE = 1 << 2,
+};
+
+struct RenderGraphTextureDesc
+{
+    u32 m_Width;
+    u32 m_Height;
+    RenderGraphFormat m_Format;
+    u32 m_BindFlags; // NOTE(sbalse): Filled in by the graph for transients.
+};
+
+struct RenderGraphBackend
+{
+    void* m_Context;
+    void* (*m_CreateTexture)(void* context, const RenderGraphTextureDesc* desc);
+    void (*m_DestroyTexture)(void* context, void* native);
+    void (*m_Transition)(void* context, void* native, const RenderGraphUsage before, const RenderGraphUsage after);
+};
+
+struct RenderGraphStats
+{
+    u32 m_DeclaredPasses;
+    u32 m_ExecutedPasses;
+    u32 m_CulledPasses;
+    u32 m_TransientTextures;
+    u32 m_PhysicalTextures; // NOTE(sbalse): Backing the transients of this frame.
+    u32 m_Transitions;
+    u64 m_TransientBytes;
+    u64 m_PhysicalBytes;
+    u64 m_AliasedBytesSaved;
+    float m_CompileTimeUs;
+};
+
+struct RenderGraph;
+struct RenderGraphResource
+{
+    u32 m_Index;
+};
+
+constexpr u32 RENDERGRAPH_INVALID_PASS = 0xFFFFFFFF;
+constexpr RenderGraphResource RENDERGRAPH_INVALID_RESOURCE = { 0xFFFFFFFF };
+
+typedef void RenderGraphExecuteFunc(const RenderGraph* graph, void* userData);
+
+RenderGraph* RenderGraphCreate(const RenderGraphBackend* backend);
+void RenderGraphDestroy(RenderGraph* graph);
+
+// NOTE(sbalse): Starts declaring a new frame. Everything declared in the previous frame is forgotten.
+void RenderGraphReset(RenderGraph* graph);
+// NOTE(sbalse): External textures are never culled away from or aliased. They are put into finalState at
+// the end of the frame, and writes to them keep their passes alive.
+RenderGraphResource RenderGraphImportTexture(
+    RenderGraph* graph,
+    const char* name,
+    const RenderGraphTextureDesc* desc,
+    void* native,
+    const RenderGraphUsage initialState,
+    const RenderGraphUsage finalState);
+RenderGraphResource RenderGraphCreateTexture(
+    RenderGraph* graph,
+    const char* name,
+    const u32 width,
+    const u32 height,
+    const RenderGraphFormat format);
+u32 RenderGraphAddPass(
+    RenderGraph* graph,
+    const char* name,
+    RenderGraphExecuteFunc* execute,
+    void* userData,
+    const bool hasSideEffects = false);
+void RenderGraphUse(
+    RenderGraph* graph,
+    const u32 pass,
+    const RenderGraphResource resource,
+    const RenderGraphUsage usage);
+
+// NOTE(sbalse): Returns false if the frame declared more than the graph can hold.
+bool RenderGraphCompile(RenderGraph* graph);
+void RenderGraphExecute(RenderGraph* graph);
+
+// NOTE(sbalse): Only valid while the graph executes.
+void* RenderGraphGetNative(const RenderGraph* graph, const RenderGraphResource resource);
+// NOTE(sbalse): True on the first use of a transient this frame, its contents have to be cleared or
+// fully overwritten.
+bool RenderGraphIsFirstUse(const RenderGraph* graph, const RenderGraphResource resource);
+const RenderGraphStats* RenderGraphGetStats(const RenderGraph* graph);
+u32 RenderGraphFormatBytesPerPixel(const RenderGraphFormat format);
+
+struct RenderGraphNullDevice
+{
+    u64 m_NextTexture;
+    u32 m_LiveTextures;
+    u32 m_Creates;
+    u32 m_Transitions;
+};
+
+RenderGraphBackend RenderGraphNullBackend(RenderGraphNullDevice* device);
@@ -0,0 +1,148 @@
+#include "graphics/rendergraphbackend.h"
+
+namespace
+{
+    // NOTE(sbalse): Shader resource slots cleared when a texture becomes a render target again, so it is
+    // never bound for reading and writing at the same time.
+    constexpr u32 RENDERGRAPH_SHADER_RESOURCE_SLOTS = 8;
+
+    DXGI_FORMAT RenderGraphTextureFormat(const RenderGraphTextureDesc* desc)
+    {
+        switch (desc->m_Format)
+        {
+            case RenderGraphFormat::RGBA8_UNORM: return DXGI_FORMAT_R8G8B8A8_UNORM;
+            case RenderGraphFormat::BGRA8_UNORM: return DXGI_FORMAT_B8G8R8A8_UNORM;
+            case RenderGraphFormat::RGBA16_FLOAT: return DXGI_FORMAT_R16G16B16A16_FLOAT;
+            case RenderGraphFormat::D32_FLOAT:
+            {
+                // NOTE(sbalse): Depth that is also sampled needs a typeless texture with typed views.
+                const bool isSampled = desc->m_BindFlags & RENDERGRAPH_BIND_SHADERRESOURCE;
+                return isSampled ? DXGI_FORMAT_R32_TYPELESS : DXGI_FORMAT_D32_FLOAT;
+            }
+            default: return DXGI_FORMAT_UNKNOWN;
+        }
+    }
+
+    void RenderGraphD3D11DestroyTexture(void*, void* native)
+    {
+        RenderGraphTarget* target = static_cast<RenderGraphTarget*>(native);
+        SAFE_RELEASE(target->m_ShaderResourceView);
+        SAFE_RELEASE(target->m_DepthStencilView);
+        SAFE_RELEASE(target->m_RenderTargetView);
+        SAFE_RELEASE(target->m_Texture);
+        delete target;
+    }
+
+    void* RenderGraphD3D11CreateTexture(void* context, const RenderGraphTextureDesc* desc)
+    {
+        const DeviceResources* deviceResources = static_cast<const DeviceResources*>(context);
+        ID3D11Device* device = deviceResources->m_Device;
+
+        u32 bindFlags = 0;
+        bindFlags |= (desc->m_BindFlags & RENDERGRAPH_BIND_RENDERTARGET) ? D3D11_BIND_RENDER_TARGET : 0;
+        bindFlags |= (desc->m_BindFlags & RENDERGRAPH_BIND_DEPTHSTENCIL) ? D3D11_BIND_DEPTH_STENCIL : 0;
+        bindFlags |= (desc->m_BindFlags & RENDERGRAPH_BIND_SHADERRESOURCE) ? D3D11_BIND_SHADER_RESOURCE : 0;
+
+        const D3D11_TEXTURE2D_DESC textureDesc =
+        {
+            .Width = desc->m_Width,
+            .Height = desc->m_Height,
+            .MipLevels = 1u,
+            .ArraySize = 1u,
+            .Format = RenderGraphTextureFormat(desc),
+            .SampleDesc =
+            {
+                .Count = 1u,
+                .Quality = 0u,
+            },
+            .Usage = D3D11_USAGE_DEFAULT,
+            .BindFlags = bindFlags,
+        };
+
+        RenderGraphTarget* target = new RenderGraphTarget{};
+        HRESULT hr = device->CreateTexture2D(&textureDesc, nullptr, &target->m_Texture);
+
+        if (SUCCEEDED(hr) && (desc->m_BindFlags & RENDERGRAPH_BIND_RENDERTARGET))
+        {
+            hr = device->CreateRenderTargetView(target->m_Texture, nullptr, &target->m_RenderTargetView);
+        }
+
+        const bool isDepth = desc->m_Format == RenderGraphFormat::D32_FLOAT;
+        if (SUCCEEDED(hr) && (desc->m_BindFlags & RENDERGRAPH_BIND_DEPTHSTENCIL))
+        {
+            const D3D11_DEPTH_STENCIL_VIEW_DESC depthStencilViewDesc =
+            {
+                .Format = DXGI_FORMAT_D32_FLOAT,
+                .ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D,
+                .Texture2D =
+                {
+                    .MipSlice = 0u,
+                },
+            };
+            hr = device->CreateDepthStencilView(target->m_Texture, &depthStencilViewDesc, &target->m_DepthStencilView);
+        }
+
+        if (SUCCEEDED(hr) && (desc->m_BindFlags & RENDERGRAPH_BIND_SHADERRESOURCE))
+        {
+            const D3D11_SHADER_RESOURCE_VIEW_DESC shaderResourceViewDesc =
+            {
+                .Format = isDepth ? DXGI_FORMAT_R32_FLOAT : textureDesc.Format,
+                .ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D,
+                .Texture2D =
+                {
+                    .MostDetailedMip = 0u,
+                    .MipLevels = 1u,
+                },
+            };
+            hr = device->CreateShaderResourceView(
+                target->m_Texture,
+                &shaderResourceViewDesc,
+                &target->m_ShaderResourceView);
+        }
+
+        if (FAILED(hr))
+        {
+            RenderGraphD3D11DestroyTexture(context, target);
+            return nullptr;
+        }
+
+        return target;
+    }
+
+    // NOTE(sbalse): D3D11 tracks resource states itself. All we have to do is make sure a texture is never
+    // bound as an output and an input at the same time, the runtime would silently unbind one of them.
+    void RenderGraphD3D11Transition(
+        void* context,
+        void*,
+        const RenderGraphUsage before,
+        const RenderGraphUsage after)
+    {
+        const DeviceResources* deviceResources = static_cast<const DeviceResources*>(context);
+        ID3D11DeviceContext* deviceContext = deviceResources->m_DeviceContext;
+
+        const bool wasOutput = before == RenderGraphUsage::RENDERTARGET || before == RenderGraphUsage::DEPTHWRITE;
+        const bool wasInput = before == RenderGraphUsage::SHADERREAD || before == RenderGraphUsage::DEPTHREAD;
+
+        if (wasOutput && (after == RenderGraphUsage::SHADERREAD || after == RenderGraphUsage::DEPTHREAD))
+        {
+            deviceContext->OMSetRenderTargets(0u, nullptr, nullptr);
+        }
+        else if (wasInput && (after == RenderGraphUsage::RENDERTARGET || after == RenderGraphUsage::DEPTHWRITE))
+        {
+            ID3D11ShaderResourceView* const nullViews[RENDERGRAPH_SHADER_RESOURCE_SLOTS] = {};
+            deviceContext->PSSetShaderResources(0u, RENDERGRAPH_SHADER_RESOURCE_SLOTS, nullViews);
+        }
+    }
+} // namespace
+
+RenderGraphBackend RenderGraphD3D11Backend(const DeviceResources* deviceResources)
+{
+    const RenderGraphBackend result =
+    {
+        .m_Context = const_cast<DeviceResources*>(deviceResources),
+        .m_CreateTexture = RenderGraphD3D11CreateTexture,
+        .m_DestroyTexture = RenderGraphD3D11DestroyTexture,
+        .m_Transition = RenderGraphD3D11Transition,
+    };
+    return result;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <d3d11.h>
+
+#include "types.h"
+#include "graphics/graphicsutils.h"
+#include "graphics/rendergraph.h"
+
+// NOTE(sbalse): What a render graph texture is on D3D11. Views are only created for the ways the graph
+// binds the texture.
+struct RenderGraphTarget
+{
+    ID3D11Texture2D* m_Texture;
+    ID3D11RenderTargetView* m_RenderTargetView;
+    ID3D11DepthStencilView* m_DepthStencilView;
+    ID3D11ShaderResourceView* m_ShaderResourceView;
+};
+
+RenderGraphBackend RenderGraphD3D11Backend(const DeviceResources* deviceResources);
+
+inline RenderGraphTarget* RenderGraphGetTarget(const RenderGraph* graph, const RenderGraphResource resource)
+{
+    return static_cast<RenderGraphTarget*>(RenderGraphGetNative(graph, resource));
+}
@@ -0,0 +1,198 @@
+#include "graphics/resourcebackend.h"
+
+#include <cstring>
+
+#include "graphics/graphicsutils.h"
+#include "texture.h"
+
+namespace
+{
+    u32 ResourceBindFlags(const ResourceType type)
+    {
+        switch (type)
+        {
+            case ResourceType::VERTEXBUFFER: return D3D11_BIND_VERTEX_BUFFER;
+            case ResourceType::INDEXBUFFER: return D3D11_BIND_INDEX_BUFFER;
+            case ResourceType::CONSTANTBUFFER: return D3D11_BIND_CONSTANT_BUFFER;
+            default: return 0u;
+        }
+    }
+
+    DXGI_FORMAT ResourceTextureFormat(const TextureFile* texture)
+    {
+        const bool isSrgb = (texture->m_Flags & TEXTURE_FLAG_SRGB) != 0;
+        switch (static_cast<TextureFormat>(texture->m_Format))
+        {
+            case TextureFormat::RGBA8: return isSrgb ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+            case TextureFormat::BC1: return isSrgb ? DXGI_FORMAT_BC1_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM;
+            case TextureFormat::BC7: return isSrgb ? DXGI_FORMAT_BC7_UNORM_SRGB : DXGI_FORMAT_BC7_UNORM;
+            default: return DXGI_FORMAT_UNKNOWN;
+        }
+    }
+
+    // NOTE(sbalse): The levels go to the device straight from the texture file. Only the view is kept, it holds
+    // on to the texture.
+    ID3D11ShaderResourceView* ResourceD3D11CreateTexture(ID3D11Device* device, const TextureFile* texture)
+    {
+        D3D11_SUBRESOURCE_DATA initialData[TEXTURE_MAX_MIPS] = {};
+        for (u32 mip = 0; mip < texture->m_MipCount; mip++)
+        {
+            initialData[mip] =
+            {
+                .pSysMem = TextureGetMipData(texture, mip),
+                .SysMemPitch = texture->m_Mips[mip].m_RowPitch,
+                .SysMemSlicePitch = static_cast<u32>(texture->m_Mips[mip].m_Size),
+            };
+        }
+
+        const D3D11_TEXTURE2D_DESC textureDesc =
+        {
+            .Width = texture->m_Width,
+            .Height = texture->m_Height,
+            .MipLevels = texture->m_MipCount,
+            .ArraySize = 1u,
+            .Format = ResourceTextureFormat(texture),
+            .SampleDesc = { .Count = 1u, .Quality = 0u },
+            .Usage = D3D11_USAGE_IMMUTABLE,
+            .BindFlags = D3D11_BIND_SHADER_RESOURCE,
+            .CPUAccessFlags = 0u,
+            .MiscFlags = 0u,
+        };
+
+        ID3D11Texture2D* texture2D = nullptr;
+        if (FAILED(device->CreateTexture2D(&textureDesc, initialData, &texture2D)))
+        {
+            return nullptr;
+        }
+
+        ID3D11ShaderResourceView* view = nullptr;
+        const HRESULT hr = device->CreateShaderResourceView(texture2D, nullptr, &view);
+        texture2D->Release();
+        return SUCCEEDED(hr) ? view : nullptr;
+    }
+
+    void* ResourceD3D11Create(void* context, const ResourceDesc* desc)
+    {
+        ID3D11Device* device = static_cast<ID3D11Device*>(context);
+
+        if (desc->m_Type == ResourceType::TEXTURE)
+        {
+            HARDASSERT(desc->m_Size == sizeof(TextureFile), "Not a texture file");
+            return ResourceD3D11CreateTexture(device, static_cast<const TextureFile*>(desc->m_Data));
+        }
+
+        if (desc->m_Type == ResourceType::DEPTHSTENCILSTATE)
+        {
+            HARDASSERT(desc->m_Size == sizeof(D3D11_DEPTH_STENCIL_DESC), "Not a depth stencil description");
+
+            ID3D11DepthStencilState* state = nullptr;
+            const HRESULT hr = device->CreateDepthStencilState(
+                static_cast<const D3D11_DEPTH_STENCIL_DESC*>(desc->m_Data),
+                &state);
+            return SUCCEEDED(hr) ? state : nullptr;
+        }
+
+        const bool isDynamic = desc->m_Usage == ResourceUsage::DYNAMIC;
+        const D3D11_BUFFER_DESC bufferDesc =
+        {
+            .ByteWidth = desc->m_Size,
+            .Usage = isDynamic ? D3D11_USAGE_DYNAMIC : D3D11_USAGE_IMMUTABLE,
+            .BindFlags = ResourceBindFlags(desc->m_Type),
+            .CPUAccessFlags = isDynamic ? static_cast<u32>(D3D11_CPU_ACCESS_WRITE) : 0u,
+            .MiscFlags = 0u,
+            .StructureByteStride = desc->m_Stride,
+        };
+
+        const D3D11_SUBRESOURCE_DATA initialData =
+        {
+            .pSysMem = desc->m_Data,
+        };
+
+        ID3D11Buffer* buffer = nullptr;
+        const HRESULT hr = device->CreateBuffer(&bufferDesc, desc->m_Data ? &initialData : nullptr, &buffer);
+        return SUCCEEDED(hr) ? buffer : nullptr;
+    }
+
+    void ResourceD3D11Release(void*, ResourceType, void* native)
+    {
+        static_cast<IUnknown*>(native)->Release();
+    }
+} // namespace
+
+ResourceBackend ResourceD3D11Backend(ID3D11Device* device)
+{
+    const ResourceBackend result =
+    {
+        .m_Context = device,
+        .m_Create = ResourceD3D11Create,
+        .m_Release = ResourceD3D11Release,
+    };
+    return result;
+}
+
+ResourceHandle ResourceCreateBuffer(
+    ResourcePool* pool,
+    const ResourceType type,
+    const ResourceUsage usage,
+    const void* data,
+    const u32 size,
+    const u32 stride)
+{
+    const ResourceDesc desc =
+    {
+        .m_Type = type,
+        .m_Usage = usage,
+        .m_Stride = stride,
+        .m_Size = size,
+        .m_Data = data,
+    };
+
+    const ResourceHandle result = ResourceCreate(pool, &desc);
+    HARDASSERT(result.m_Value != 0, "Failed to create a buffer");
+    return result;
+}
+
+ResourceHandle ResourceCreateDepthStencilState(ResourcePool* pool, const D3D11_DEPTH_STENCIL_DESC* desc)
+{
+    // NOTE(sbalse): The description is hashed byte for byte, copy it field by field so the padding is zero.
+    D3D11_DEPTH_STENCIL_DESC key;
+    std::memset(&key, 0, sizeof(key));
+    key.DepthEnable = desc->DepthEnable;
+    key.DepthWriteMask = desc->DepthWriteMask;
+    key.DepthFunc = desc->DepthFunc;
+    key.StencilEnable = desc->StencilEnable;
+    key.StencilReadMask = desc->StencilReadMask;
+    key.StencilWriteMask = desc->StencilWriteMask;
+    key.FrontFace = desc->FrontFace;
+    key.BackFace = desc->BackFace;
+
+    const ResourceDesc resourceDesc =
+    {
+        .m_Type = ResourceType::DEPTHSTENCILSTATE,
+        .m_Usage = ResourceUsage::IMMUTABLE,
+        .m_Stride = 0u,
+        .m_Size = sizeof(key),
+        .m_Data = &key,
+    };
+
+    const ResourceHandle result = ResourceCreate(pool, &resourceDesc);
+    HARDASSERT(result.m_Value != 0, "Failed to create a depth stencil state");
+    return result;
+}
+
+ResourceHandle ResourceCreateTexture(ResourcePool* pool, const TextureFile* texture)
+{
+    // NOTE(sbalse): Only the header is hashed, the content checksum in it tells textures apart.
+    const ResourceDesc desc =
+    {
+        .m_Type = ResourceType::TEXTURE,
+        .m_Usage = ResourceUsage::IMMUTABLE,
+        .m_Stride = 0u,
+        .m_Size = sizeof(TextureFile),
+        .m_Data = texture,
+    };
+
+    const ResourceHandle result = ResourceCreate(pool, &desc);
+    HARDASSERT(result.m_Value != 0, "Failed to create a texture");
+    return result;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <d3d11.h>
+
+#include "graphics/resourcepool.h"
+
+struct TextureFile;
+
+// NOTE(sbalse): Resource pool backend that creates D3D11 objects on the given device.
+ResourceBackend ResourceD3D11Backend(ID3D11Device* device);
+
+ResourceHandle ResourceCreateBuffer(
+    ResourcePool* pool,
+    const ResourceType type,
+    const ResourceUsage usage,
+    const void* data,
+    const u32 size,
+    const u32 stride);
+// NOTE(sbalse): Depth stencil states are immutable, identical descriptions share one state object.
+ResourceHandle ResourceCreateDepthStencilState(ResourcePool* pool, const D3D11_DEPTH_STENCIL_DESC* desc);
+// NOTE(sbalse): Takes a bound texture file, see TextureBind(). The file only has to live through the call.
+ResourceHandle ResourceCreateTexture(ResourcePool* pool, const TextureFile* texture);
+
+inline ID3D11Buffer* ResourceGetBuffer(const ResourcePool* pool, const ResourceHandle handle)
+{
+    return static_cast<ID3D11Buffer*>(ResourceGetNative(pool, handle));
+}
+
+inline ID3D11DepthStencilState* ResourceGetDepthStencilState(const ResourcePool* pool, const ResourceHandle handle)
+{
+    return static_cast<ID3D11DepthStencilState*>(ResourceGetNative(pool, handle));
+}
+
+inline ID3D11ShaderResourceView* ResourceGetTexture(const ResourcePool* pool, const ResourceHandle handle)
+{
+    return static_cast<ID3D11ShaderResourceView*>(ResourceGetNative(pool, handle));
+}
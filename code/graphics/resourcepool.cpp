@@ -0,0 +1,473 @@
+#include "graphics/resourcepool.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+    constexpr u32 RESOURCE_INDEX_MASK = RESOURCE_MAX_RESOURCES - 1;
+    constexpr u32 RESOURCE_GENERATION_MASK = (1u << RESOURCE_GENERATION_BITS) - 1;
+    constexpr u32 RESOURCE_NO_SLOT = 0xFFFFFFFF;
+
+    enum class SlotState : u8
+    {
+        FREE,
+        LIVE,
+        RETIRED, // NOTE(sbalse): No references left, waiting in the destroy queue.
+    };
+
+    struct ResourceSlot
+    {
+        void* m_Native;
+        void* m_Contents; // NOTE(sbalse): Copy of the description bytes of interned slots, to confirm hash hits.
+        u64 m_Hash;
+        u32 m_RefCount;
+        u32 m_Size;
+        u32 m_Stride;
+        u32 m_NextFree;
+        u16 m_Generation;
+        ResourceType m_Type;
+        ResourceUsage m_Usage;
+        SlotState m_State;
+        bool m_Interned;
+    };
+
+    struct RetiredResource
+    {
+        u32 m_Slot;
+        u64 m_Frame;
+    };
+}
+
+struct ResourcePool
+{
+    ResourceBackend m_Backend;
+    u32 m_MaxResources;
+
+    ResourceSlot* m_Slots;
+    u32 m_SlotCount; // NOTE(sbalse): Slots ever handed out. Slots are reused through the free list.
+    u32 m_FreeList;
+
+    // NOTE(sbalse): Open addressing table from content hash to slot. Entries store slot + 1, 0 is empty.
+    u32* m_InternTable;
+    u32 m_InternMask;
+
+    // NOTE(sbalse): Ring buffer of retired slots, in the order they were retired.
+    RetiredResource* m_Retired;
+    u32 m_RetiredHead;
+    u32 m_RetiredCount;
+
+    u64 m_Frame;
+    ResourcePoolStats m_Stats;
+};
+
+namespace
+{
+    // NOTE(sbalse): 64-bit FNV-1a.
+    u64 ResourceHashBytes(u64 hash, const void* data, const size_t size)
+    {
+        const u8* bytes = static_cast<const u8*>(data);
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= 0x100000001B3ull;
+        }
+        return hash;
+    }
+
+    u64 ResourceHashDesc(const ResourceDesc* desc)
+    {
+        const u32 header[] =
+        {
+            static_cast<u32>(desc->m_Type),
+            static_cast<u32>(desc->m_Usage),
+            desc->m_Stride,
+            desc->m_Size,
+        };
+
+        u64 hash = 0xCBF29CE484222325ull;
+        hash = ResourceHashBytes(hash, header, sizeof(header));
+        hash = ResourceHashBytes(hash, desc->m_Data, desc->m_Size);
+        return hash;
+    }
+
+    bool ResourceIsBuffer(const ResourceType type)
+    {
+        return type != ResourceType::DEPTHSTENCILSTATE && type != ResourceType::TEXTURE;
+    }
+
+    bool ResourceIsInternable(const ResourceDesc* desc)
+    {
+        return desc->m_Usage == ResourceUsage::IMMUTABLE && desc->m_Data;
+    }
+
+    ResourceHandle ResourceMakeHandle(const u32 index, const u16 generation)
+    {
+        return { (static_cast<u32>(generation) << RESOURCE_INDEX_BITS) | index };
+    }
+
+    ResourceSlot* ResourceLookup(const ResourcePool* pool, const ResourceHandle handle)
+    {
+        const u32 index = handle.m_Value & RESOURCE_INDEX_MASK;
+        const u32 generation = handle.m_Value >> RESOURCE_INDEX_BITS;
+        if (handle.m_Value == 0 || index >= pool->m_SlotCount)
+        {
+            return nullptr;
+        }
+
+        ResourceSlot* slot = &pool->m_Slots[index];
+        if (slot->m_Generation != generation || slot->m_State != SlotState::LIVE)
+        {
+            return nullptr;
+        }
+        return slot;
+    }
+
+    // NOTE(sbalse): Returns the table position holding the slot with this content, or the empty position
+    // where it would go.
+    u32 ResourceFindInterned(const ResourcePool* pool, const ResourceDesc* desc, const u64 hash)
+    {
+        u32 position = static_cast<u32>(hash) & pool->m_InternMask;
+        while (pool->m_InternTable[position] != 0)
+        {
+            const ResourceSlot* slot = &pool->m_Slots[pool->m_InternTable[position] - 1];
+
+            // NOTE(sbalse): Different contents can share a hash, only the bytes themselves tell.
+            if (slot->m_Hash == hash
+                && slot->m_Type == desc->m_Type
+                && slot->m_Size == desc->m_Size
+                && slot->m_Stride == desc->m_Stride
+                && std::memcmp(slot->m_Contents, desc->m_Data, desc->m_Size) == 0)
+            {
+                return position;
+            }
+            position = (position + 1) & pool->m_InternMask;
+        }
+        return position;
+    }
+
+    // NOTE(sbalse): Backward shift deletion, so lookups never need tombstones.
+    void ResourceRemoveInterned(ResourcePool* pool, const u32 slotIndex)
+    {
+        u32 position = static_cast<u32>(pool->m_Slots[slotIndex].m_Hash) & pool->m_InternMask;
+        while (pool->m_InternTable[position] != slotIndex + 1)
+        {
+            position = (position + 1) & pool->m_InternMask;
+        }
+
+        u32 next = (position + 1) & pool->m_InternMask;
+        while (pool->m_InternTable[next] != 0)
+        {
+            const u64 nextHash = pool->m_Slots[pool->m_InternTable[next] - 1].m_Hash;
+            const u32 home = static_cast<u32>(nextHash) & pool->m_InternMask;
+
+            // NOTE(sbalse): Move the entry into the hole unless its home lies cyclically in (hole, next].
+            const bool homeInRange = position <= next
+                ? (home > position && home <= next)
+                : (home > position || home <= next);
+            if (!homeInRange)
+            {
+                pool->m_InternTable[position] = pool->m_InternTable[next];
+                position = next;
+            }
+            next = (next + 1) & pool->m_InternMask;
+        }
+        pool->m_InternTable[position] = 0;
+    }
+
+    void ResourceDestroySlot(ResourcePool* pool, const u32 index)
+    {
+        ResourceSlot* slot = &pool->m_Slots[index];
+        pool->m_Backend.m_Release(pool->m_Backend.m_Context, slot->m_Type, slot->m_Native);
+
+        slot->m_Native = nullptr;
+        slot->m_State = SlotState::FREE;
+        slot->m_NextFree = pool->m_FreeList;
+        pool->m_FreeList = index;
+    }
+
+    void ResourceRetireSlot(ResourcePool* pool, const u32 index)
+    {
+        ResourceSlot* slot = &pool->m_Slots[index];
+        if (slot->m_Interned)
+        {
+            ResourceRemoveInterned(pool, index);
+            pool->m_Stats.m_InternedResources--;
+            std::free(slot->m_Contents);
+            slot->m_Contents = nullptr;
+            slot->m_Interned = false;
+        }
+
+        pool->m_Stats.m_LiveResources--;
+        if (ResourceIsBuffer(slot->m_Type))
+        {
+            pool->m_Stats.m_LiveBufferBytes -= slot->m_Size;
+        }
+
+        // NOTE(sbalse): Outstanding handles go stale right away, the object itself lives a little longer.
+        slot->m_Generation = static_cast<u16>((slot->m_Generation % RESOURCE_GENERATION_MASK) + 1);
+        slot->m_State = SlotState::RETIRED;
+
+        const u32 tail = (pool->m_RetiredHead + pool->m_RetiredCount) % pool->m_MaxResources;
+        pool->m_Retired[tail] = { .m_Slot = index, .m_Frame = pool->m_Frame };
+        pool->m_RetiredCount++;
+        pool->m_Stats.m_PendingDestroys = pool->m_RetiredCount;
+    }
+
+    void* ResourceNullCreate(void* context, const ResourceDesc*)
+    {
+        ResourceNullDevice* device = static_cast<ResourceNullDevice*>(context);
+        device->m_Creates++;
+        device->m_LiveObjects++;
+        return reinterpret_cast<void*>(++device->m_NextObject);
+    }
+
+    void ResourceNullRelease(void* context, ResourceType, void*)
+    {
+        ResourceNullDevice* device = static_cast<ResourceNullDevice*>(context);
+        device->m_Releases++;
+        device->m_LiveObjects--;
+    }
+}
+
+ResourcePool* ResourcePoolCreate(const ResourceBackend* backend, const u32 maxResources)
+{
+    if (maxResources == 0 || maxResources > RESOURCE_MAX_RESOURCES)
+    {
+        return nullptr;
+    }
+
+    // NOTE(sbalse): Keep the intern table at most half full.
+    u32 tableSize = 2;
+    while (tableSize < maxResources * 2)
+    {
+        tableSize *= 2;
+    }
+
+    ResourcePool* pool = static_cast<ResourcePool*>(std::calloc(1, sizeof(ResourcePool)));
+    if (!pool)
+    {
+        return nullptr;
+    }
+
+    pool->m_Backend = *backend;
+    pool->m_MaxResources = maxResources;
+    pool->m_FreeList = RESOURCE_NO_SLOT;
+    pool->m_InternMask = tableSize - 1;
+    pool->m_Slots = static_cast<ResourceSlot*>(std::calloc(maxResources, sizeof(ResourceSlot)));
+    pool->m_InternTable = static_cast<u32*>(std::calloc(tableSize, sizeof(u32)));
+    pool->m_Retired = static_cast<RetiredResource*>(std::calloc(maxResources, sizeof(RetiredResource)));
+
+    if (!pool->m_Slots || !pool->m_InternTable || !pool->m_Retired)
+    {
+        ResourcePoolDestroy(pool);
+        return nullptr;
+    }
+
+    return pool;
+}
+
+void ResourcePoolDestroy(ResourcePool* pool)
+{
+    if (!pool)
+    {
+        return;
+    }
+
+    if (pool->m_Slots)
+    {
+        for (u32 i = 0; i < pool->m_SlotCount; i++)
+        {
+            const ResourceSlot* slot = &pool->m_Slots[i];
+            if (slot->m_State != SlotState::FREE)
+            {
+                pool->m_Backend.m_Release(pool->m_Backend.m_Context, slot->m_Type, slot->m_Native);
+            }
+            std::free(slot->m_Contents);
+        }
+    }
+
+    std::free(pool->m_Retired);
+    std::free(pool->m_InternTable);
+    std::free(pool->m_Slots);
+    std::free(pool);
+}
+
+void ResourcePoolEndFrame(ResourcePool* pool)
+{
+    pool->m_Frame++;
+}
+
+bool ResourcePoolCollect(ResourcePool* pool, const u32 maxReleases)
+{
+    for (u32 released = 0; pool->m_RetiredCount > 0; released++)
+    {
+        const RetiredResource* retired = &pool->m_Retired[pool->m_RetiredHead];
+        if (retired->m_Frame + RESOURCE_DESTROY_LATENCY_FRAMES > pool->m_Frame)
+        {
+            break; // NOTE(sbalse): The queue is in retire order, everything after this is younger.
+        }
+
+        if (released == maxReleases)
+        {
+            pool->m_Stats.m_PendingDestroys = pool->m_RetiredCount;
+            return true;
+        }
+
+        ResourceDestroySlot(pool, retired->m_Slot);
+        pool->m_RetiredHead = (pool->m_RetiredHead + 1) % pool->m_MaxResources;
+        pool->m_RetiredCount--;
+    }
+
+    pool->m_Stats.m_PendingDestroys = pool->m_RetiredCount;
+    return false;
+}
+
+void ResourcePoolGetStats(const ResourcePool* pool, ResourcePoolStats* stats)
+{
+    *stats = pool->m_Stats;
+}
+
+ResourceHandle ResourceCreate(ResourcePool* pool, const ResourceDesc* desc)
+{
+    pool->m_Stats.m_CreateRequests++;
+
+    bool intern = ResourceIsInternable(desc);
+    const u64 hash = intern ? ResourceHashDesc(desc) : 0;
+    u32 tablePosition = 0;
+
+    if (intern)
+    {
+        tablePosition = ResourceFindInterned(pool, desc, hash);
+        if (pool->m_InternTable[tablePosition] != 0)
+        {
+            const u32 index = pool->m_InternTable[tablePosition] - 1;
+            ResourceSlot* slot = &pool->m_Slots[index];
+            slot->m_RefCount++;
+
+            pool->m_Stats.m_DuplicateRequests++;
+            pool->m_Stats.m_SharedReferences++;
+            if (ResourceIsBuffer(slot->m_Type))
+            {
+                pool->m_Stats.m_BufferBytesSaved += slot->m_Size;
+            }
+            return ResourceMakeHandle(index, slot->m_Generation);
+        }
+    }
+
+    u32 index = pool->m_FreeList;
+    if (index != RESOURCE_NO_SLOT)
+    {
+        pool->m_FreeList = pool->m_Slots[index].m_NextFree;
+    }
+    else if (pool->m_SlotCount < pool->m_MaxResources)
+    {
+        index = pool->m_SlotCount++;
+        pool->m_Slots[index].m_Generation = 1;
+    }
+    else
+    {
+        return RESOURCE_INVALID_HANDLE;
+    }
+
+    ResourceSlot* slot = &pool->m_Slots[index];
+    slot->m_Native = pool->m_Backend.m_Create(pool->m_Backend.m_Context, desc);
+    if (!slot->m_Native)
+    {
+        slot->m_NextFree = pool->m_FreeList;
+        pool->m_FreeList = index;
+        return RESOURCE_INVALID_HANDLE;
+    }
+
+    // NOTE(sbalse): Without a copy of the contents to compare with the object can't be shared, it is still usable.
+    slot->m_Contents = intern ? std::malloc(desc->m_Size) : nullptr;
+    intern = intern && slot->m_Contents;
+    if (intern)
+    {
+        std::memcpy(slot->m_Contents, desc->m_Data, desc->m_Size);
+    }
+
+    slot->m_Hash = hash;
+    slot->m_RefCount = 1;
+    slot->m_Size = desc->m_Size;
+    slot->m_Stride = desc->m_Stride;
+    slot->m_Type = desc->m_Type;
+    slot->m_Usage = desc->m_Usage;
+    slot->m_State = SlotState::LIVE;
+    slot->m_Interned = intern;
+
+    if (intern)
+    {
+        pool->m_InternTable[tablePosition] = index + 1;
+        pool->m_Stats.m_InternedResources++;
+    }
+
+    pool->m_Stats.m_LiveResources++;
+    if (ResourceIsBuffer(desc->m_Type))
+    {
+        pool->m_Stats.m_LiveBufferBytes += desc->m_Size;
+    }
+
+    return ResourceMakeHandle(index, slot->m_Generation);
+}
+
+ResourceHandle ResourceAddRef(ResourcePool* pool, const ResourceHandle handle)
+{
+    ResourceSlot* slot = ResourceLookup(pool, handle);
+    if (!slot)
+    {
+        return RESOURCE_INVALID_HANDLE;
+    }
+
+    slot->m_RefCount++;
+    pool->m_Stats.m_SharedReferences++;
+    if (ResourceIsBuffer(slot->m_Type))
+    {
+        pool->m_Stats.m_BufferBytesSaved += slot->m_Size;
+    }
+    return handle;
+}
+
+void ResourceRelease(ResourcePool* pool, const ResourceHandle handle)
+{
+    ResourceSlot* slot = ResourceLookup(pool, handle);
+    if (!slot)
+    {
+        return;
+    }
+
+    slot->m_RefCount--;
+    if (slot->m_RefCount > 0)
+    {
+        pool->m_Stats.m_SharedReferences--;
+        if (ResourceIsBuffer(slot->m_Type))
+        {
+            pool->m_Stats.m_BufferBytesSaved -= slot->m_Size;
+        }
+        return;
+    }
+
+    ResourceRetireSlot(pool, handle.m_Value & RESOURCE_INDEX_MASK);
+}
+
+bool ResourceIsValid(const ResourcePool* pool, const ResourceHandle handle)
+{
+    return ResourceLookup(pool, handle) != nullptr;
+}
+
+void* ResourceGetNative(const ResourcePool* pool, const ResourceHandle handle)
+{
+    const ResourceSlot* slot = ResourceLookup(pool, handle);
+    return slot ? slot->m_Native : nullptr;
+}
+
+ResourceBackend ResourceNullBackend(ResourceNullDevice* device)
+{
+    const ResourceBackend result =
+    {
+        .m_Context = device,
+        .m_Create = ResourceNullCreate,
+        .m_Release = ResourceNullRelease,
+    };
+    return result;
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include "types.h"
+
+/*
+* NOTE(sbalse): Owns GPU resources behind 32-bit generational handles. Immutable resources are interned by
+* their contents, so asking for the same buffer or state twice returns the same object with one more reference.
+* Lookups go by hash, and the pool keeps a copy of the contents of every interned object to confirm a hit.
+* Objects whose last reference goes away are only released a few frames later, from ResourcePoolCollect(), so
+* nothing the GPU may still be using gets destroyed mid-frame.
+*
+* The pool itself knows nothing about D3D, the device is reached through a ResourceBackend. This way the
+* bookkeeping can run against the null backend below.
+*/
+
+constexpr u32 RESOURCE_INDEX_BITS = 20;
+constexpr u32 RESOURCE_GENERATION_BITS = 12;
+constexpr u32 RESOURCE_MAX_RESOURCES = 1u << RESOURCE_INDEX_BITS;
+// NOTE(sbalse): Frames a released object is kept alive for. Covers the frames the driver may queue up.
+constexpr u32 RESOURCE_DESTROY_LATENCY_FRAMES = 3;
+
+// NOTE(sbalse): Low bits are the slot index, high bits the generation of the slot. Zero is never valid.
+struct ResourceHandle
+{
+    u32 m_Value;
+};
+
+constexpr ResourceHandle RESOURCE_INVALID_HANDLE = {};
+
+enum class ResourceType
+{
+    VERTEXBUFFER,
+    INDEXBUFFER,
+    CONSTANTBUFFER,
+    DEPTHSTENCILSTATE,
+    TEXTURE,
+    COUNT
+};
+
+enum class ResourceUsage
+{
+    IMMUTABLE, // NOTE(sbalse): Contents are fixed at creation. These are interned.
+    DYNAMIC, // NOTE(sbalse): Rewritten by the CPU, every request gets its own object.
+};
+
+struct ResourceDesc
+{
+    ResourceType m_Type;
+    ResourceUsage m_Usage;
+    u32 m_Stride;
+    // NOTE(sbalse): For buffers the initial contents, for states the backend specific state description, for
+    // textures the header of a texture file, whose checksums stand in for its levels.
+    // All bytes take part in the content hash, so descriptions must not contain uninitialized padding.
+    u32 m_Size;
+    const void* m_Data;
+};
+
+struct ResourceBackend
+{
+    void* m_Context;
+    // NOTE(sbalse): Returns the native object or nullptr on failure.
+    void* (*m_Create)(void* context, const ResourceDesc* desc);
+    void (*m_Release)(void* context, ResourceType type, void* native);
+};
+
+struct ResourcePoolStats
+{
+    u32 m_LiveResources;
+    u64 m_LiveBufferBytes;
+    u32 m_InternedResources;
+    u32 m_PendingDestroys;
+    // NOTE(sbalse): References that were served by an existing object, and the buffer memory that saved.
+    u32 m_SharedReferences;
+    u64 m_BufferBytesSaved;
+    u64 m_CreateRequests;
+    u64 m_DuplicateRequests;
+};
+
+struct ResourcePool;
+
+ResourcePool* ResourcePoolCreate(const ResourceBackend* backend, const u32 maxResources);
+// NOTE(sbalse): Releases everything, including resources that still have references.
+void ResourcePoolDestroy(ResourcePool* pool);
+// NOTE(sbalse): Advances the frame counter. Objects retired long enough ago become due for ResourcePoolCollect().
+void ResourcePoolEndFrame(ResourcePool* pool);
+// NOTE(sbalse): Releases up to maxReleases objects that have been retired for long enough, oldest first. Returns
+// true when more are due.
+bool ResourcePoolCollect(ResourcePool* pool, const u32 maxReleases);
+void ResourcePoolGetStats(const ResourcePool* pool, ResourcePoolStats* stats);
+
+// NOTE(sbalse): Returns RESOURCE_INVALID_HANDLE if the pool is full or the backend failed.
+ResourceHandle ResourceCreate(ResourcePool* pool, const ResourceDesc* desc);
+ResourceHandle ResourceAddRef(ResourcePool* pool, const ResourceHandle handle);
+// NOTE(sbalse): Stale and invalid handles are ignored.
+void ResourceRelease(ResourcePool* pool, const ResourceHandle handle);
+bool ResourceIsValid(const ResourcePool* pool, const ResourceHandle handle);
+// NOTE(sbalse): Returns nullptr for stale and invalid handles.
+void* ResourceGetNative(const ResourcePool* pool, const ResourceHandle handle);
+
+// NOTE(sbalse): Backend that creates no GPU objects, only counts them.
+struct ResourceNullDevice
+{
+    u64 m_NextObject;
+    u32 m_LiveObjects;
+    u32 m_Creates;
+    u32 m_Releases;
+};
+
+ResourceBackend ResourceNullBackend(ResourceNullDevice* device);
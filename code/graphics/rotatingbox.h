@@ -6,31 +6,24 @@
 
 using namespace DirectX;
 
+struct SceneSnapshot;
+
+// NOTE(sbalse): GPU side of a box. Its motion lives in the simulation, see simulation.h. The geometry and
+// colors are the same for every box, so all boxes share one copy of them through the resource pool.
 struct RotatingBox
 {
-    XMFLOAT3 m_Position;
-    // NOTE(sbalse): Rotation is in the form of pitch, yaw roll.
-    XMFLOAT3 m_SelfRotation;
-    float m_SelfRotationSpeed;
-    XMFLOAT3 m_WorldRotation;
-    float m_WorldRotationSpeed;
-    ID3D11Buffer* m_VertexBuffer;
-    ID3D11Buffer* m_IndexBuffer;
-    ID3D11Buffer* m_TransformConstantBuffer;
-    ID3D11Buffer* m_FaceColorsConstantBuffer;
+    ResourceHandle m_VertexBuffer;
+    ResourceHandle m_IndexBuffer;
+    ResourceHandle m_TransformConstantBuffer;
+    ResourceHandle m_FaceColorsConstantBuffer;
 };
 
-// NOTE(sbalse): Rotation is in the form of pitch, yaw roll.
-RotatingBox CreateRotatingBox(
-    const float distanceFromCenterOfWorld,
-    const float selfRotation,
-    const float selfRotationSpeed,
-    const float worldRotation,
-    const float worldRotationSpeed,
-    const DeviceResources* const deviceResources);
+RotatingBox CreateRotatingBox(const DeviceResources* const deviceResources);
 void DrawRotatingBox(const RotatingBox* const box, const DeviceResources* const deviceResources);
-void DestroyRotatingBox(RotatingBox* box);
+void DestroyRotatingBox(RotatingBox* box, const DeviceResources* const deviceResources);
+// NOTE(sbalse): Uploads the transforms of the boxes from a simulation snapshot.
 void UpdateRotatingBoxes(
     RotatingBox* boxes,
     const size_t numberOfBoxes,
+    const SceneSnapshot* const snapshot,
     const DeviceResources* deviceResources);
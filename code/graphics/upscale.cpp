@@ -0,0 +1,151 @@
+#include "graphics/upscale.h"
+
+#include <cstring>
+#include <d3dcompiler.h>
+
+#include "stats.h"
+#include "utils.h"
+#include "graphics/resourcebackend.h"
+
+namespace
+{
+    struct UpscaleResources
+    {
+        ID3D11VertexShader* m_VertexShader;
+        ID3D11PixelShader* m_PixelShader;
+        ID3D11SamplerState* m_Sampler;
+        ID3D11Buffer* m_ConstantBuffer;
+        ResourceHandle m_DepthStencilState;
+    };
+
+    struct UpscaleConstants
+    {
+        float m_UvScale[2];
+        float m_UvMax[2];
+    };
+
+    constinit UpscaleResources g_Upscale = {};
+} // namespace
+
+void UpscaleInit(const DeviceResources* const deviceResources)
+{
+    ID3DBlob* blob = nullptr;
+    DEFER(SAFE_RELEASE(blob));
+
+    HRESULT hr = D3DReadFileToBlob(L"upscalevertexshader.cso", &blob);
+    ValidateHRESULT(hr);
+
+    hr = deviceResources->m_Device->CreateVertexShader(
+        blob->GetBufferPointer(),
+        blob->GetBufferSize(),
+        nullptr,
+        &g_Upscale.m_VertexShader);
+    ValidateHRESULT(hr);
+
+    SAFE_RELEASE(blob);
+    hr = D3DReadFileToBlob(L"upscalepixelshader.cso", &blob);
+    ValidateHRESULT(hr);
+
+    hr = deviceResources->m_Device->CreatePixelShader(
+        blob->GetBufferPointer(),
+        blob->GetBufferSize(),
+        nullptr,
+        &g_Upscale.m_PixelShader);
+    ValidateHRESULT(hr);
+
+    const D3D11_SAMPLER_DESC samplerDesc =
+    {
+        .Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR,
+        .AddressU = D3D11_TEXTURE_ADDRESS_CLAMP,
+        .AddressV = D3D11_TEXTURE_ADDRESS_CLAMP,
+        .AddressW = D3D11_TEXTURE_ADDRESS_CLAMP,
+        .MaxAnisotropy = 1u,
+        .ComparisonFunc = D3D11_COMPARISON_NEVER,
+        .MaxLOD = D3D11_FLOAT32_MAX,
+    };
+    hr = deviceResources->m_Device->CreateSamplerState(&samplerDesc, &g_Upscale.m_Sampler);
+    ValidateHRESULT(hr);
+
+    const D3D11_BUFFER_DESC constantBufferDesc =
+    {
+        .ByteWidth = sizeof(UpscaleConstants),
+        .Usage = D3D11_USAGE_DYNAMIC,
+        .BindFlags = D3D11_BIND_CONSTANT_BUFFER,
+        .CPUAccessFlags = D3D11_CPU_ACCESS_WRITE,
+        .MiscFlags = 0u,
+        .StructureByteStride = 0u,
+    };
+    hr = deviceResources->m_Device->CreateBuffer(&constantBufferDesc, nullptr, &g_Upscale.m_ConstantBuffer);
+    ValidateHRESULT(hr);
+
+    const D3D11_DEPTH_STENCIL_DESC depthStencilDesc =
+    {
+        .DepthEnable = false,
+        .DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO,
+        .DepthFunc = D3D11_COMPARISON_ALWAYS
+    };
+
+    g_Upscale.m_DepthStencilState = ResourceCreateDepthStencilState(deviceResources->m_Resources, &depthStencilDesc);
+}
+
+void UpscaleDraw(
+    ID3D11ShaderResourceView* source,
+    const u32 sourceWidth,
+    const u32 sourceHeight,
+    const u32 textureWidth,
+    const u32 textureHeight,
+    const DeviceResources* const deviceResources)
+{
+    // NOTE(sbalse): Half a texel in from the edge of the rendered part, so bilinear filtering never blends in
+    // what is left over from earlier frames outside of it.
+    const UpscaleConstants constants =
+    {
+        .m_UvScale =
+        {
+            static_cast<float>(sourceWidth) / static_cast<float>(textureWidth),
+            static_cast<float>(sourceHeight) / static_cast<float>(textureHeight),
+        },
+        .m_UvMax =
+        {
+            (static_cast<float>(sourceWidth) - 0.5f) / static_cast<float>(textureWidth),
+            (static_cast<float>(sourceHeight) - 0.5f) / static_cast<float>(textureHeight),
+        },
+    };
+
+    ID3D11DeviceContext* context = deviceResources->m_DeviceContext;
+
+    D3D11_MAPPED_SUBRESOURCE mappedResource = {};
+    const HRESULT hr = context->Map(g_Upscale.m_ConstantBuffer, 0u, D3D11_MAP_WRITE_DISCARD, 0u, &mappedResource);
+    ValidateHRESULT(hr);
+    std::memcpy(mappedResource.pData, &constants, sizeof(constants));
+    context->Unmap(g_Upscale.m_ConstantBuffer, 0u);
+
+    context->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    context->IASetInputLayout(nullptr);
+    context->VSSetShader(g_Upscale.m_VertexShader, nullptr, 0u);
+    context->PSSetShader(g_Upscale.m_PixelShader, nullptr, 0u);
+    context->PSSetConstantBuffers(0u, 1u, &g_Upscale.m_ConstantBuffer);
+    context->PSSetSamplers(0u, 1u, &g_Upscale.m_Sampler);
+    context->PSSetShaderResources(0u, 1u, &source);
+    context->OMSetDepthStencilState(
+        ResourceGetDepthStencilState(deviceResources->m_Resources, g_Upscale.m_DepthStencilState),
+        1u);
+    context->Draw(3u, 0u);
+
+    // NOTE(sbalse): The source is rendered to again next frame, it can't stay bound as an input.
+    ID3D11ShaderResourceView* nullView = nullptr;
+    context->PSSetShaderResources(0u, 1u, &nullView);
+
+    StatsAddCounter(StatsCounter::DRAWCALLS, 1);
+    StatsAddCounter(StatsCounter::BYTESUPLOADED, sizeof(constants));
+}
+
+void UpscaleDestroy(const DeviceResources* const deviceResources)
+{
+    ResourceRelease(deviceResources->m_Resources, g_Upscale.m_DepthStencilState);
+    g_Upscale.m_DepthStencilState = RESOURCE_INVALID_HANDLE;
+    SAFE_RELEASE(g_Upscale.m_ConstantBuffer);
+    SAFE_RELEASE(g_Upscale.m_Sampler);
+    SAFE_RELEASE(g_Upscale.m_PixelShader);
+    SAFE_RELEASE(g_Upscale.m_VertexShader);
+}
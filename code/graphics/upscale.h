@@ -0,0 +1,16 @@
+#pragma once
+
+#include "types.h"
+#include "graphics/graphicsutils.h"
+
+// NOTE(sbalse): Stretches the top left sourceWidth x sourceHeight texels of a texture over the bound render
+// target with bilinear filtering. Used to bring the dynamic resolution scene up to the back buffer.
+void UpscaleInit(const DeviceResources* const deviceResources);
+void UpscaleDraw(
+    ID3D11ShaderResourceView* source,
+    const u32 sourceWidth,
+    const u32 sourceHeight,
+    const u32 textureWidth,
+    const u32 textureHeight,
+    const DeviceResources* const deviceResources);
+void UpscaleDestroy(const DeviceResources* const deviceResources);
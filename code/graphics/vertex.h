@@ -1,12 +1,82 @@
 #pragma once
+#include "particles.h"
+#include "graphics/quantize.h"
+#include "graphics/vertexformat.h"
 
+// NOTE(sbalse): Position only vertex of the box. Positions are in the unit cube, the world transform
+// carries the size of the mesh. 8 bytes instead of 12 for three floats.
 struct Vertex
 {
-    // NOTE(sbalse): Position
-    struct
+    Snorm16x4 m_Position;
+};
+
+template<> struct VertexLayout<Vertex>
+{
+    static constexpr VertexAttribute ATTRIBUTES[] =
     {
-        float m_X;
-        float m_Y;
-        float m_Z;
-    } m_Pos;
+        VERTEX_ATTRIBUTE(Vertex, m_Position, "Position"),
+    };
+};
+
+// NOTE(sbalse): Lit and textured mesh vertex. 16 bytes instead of 32 for the float equivalent.
+struct MeshVertex
+{
+    Snorm16x4 m_Position;
+    OctahedralNormal m_Normal;
+    Half2 m_TexCoord;
 };
+
+template<> struct VertexLayout<MeshVertex>
+{
+    static constexpr VertexAttribute ATTRIBUTES[] =
+    {
+        VERTEX_ATTRIBUTE(MeshVertex, m_Position, "Position"),
+        VERTEX_ATTRIBUTE(MeshVertex, m_Normal, "Normal"),
+        VERTEX_ATTRIBUTE(MeshVertex, m_TexCoord, "TexCoord"),
+    };
+};
+
+// NOTE(sbalse): Overlay vertex, position already in clip space. 8 bytes instead of 12.
+struct HudVertex
+{
+    Snorm16x2 m_Position;
+    Unorm8x4 m_Color;
+};
+
+template<> struct VertexLayout<HudVertex>
+{
+    static constexpr VertexAttribute ATTRIBUTES[] =
+    {
+        VERTEX_ATTRIBUTE(HudVertex, m_Position, "Position"),
+        VERTEX_ATTRIBUTE(HudVertex, m_Color, "Color"),
+    };
+};
+
+// NOTE(sbalse): Read per instance, the corners of the particle quad come from the vertex id.
+template<> struct VertexLayout<ParticleInstance>
+{
+    static constexpr VertexAttribute ATTRIBUTES[] =
+    {
+        VERTEX_ATTRIBUTE(ParticleInstance, m_Position, "Position"),
+        VERTEX_ATTRIBUTE(ParticleInstance, m_Color, "Color"),
+    };
+};
+
+// NOTE(sbalse): Debug line vertex, in view space.
+struct DebugDrawVertex
+{
+    Float3 m_Position;
+    Unorm8x4 m_Color;
+};
+
+template<> struct VertexLayout<DebugDrawVertex>
+{
+    static constexpr VertexAttribute ATTRIBUTES[] =
+    {
+        VERTEX_ATTRIBUTE(DebugDrawVertex, m_Position, "Position"),
+        VERTEX_ATTRIBUTE(DebugDrawVertex, m_Color, "Color"),
+    };
+};
+
+static_assert(VertexStride<Vertex>() == 8 && VertexStride<MeshVertex>() == 16 && VertexStride<HudVertex>() == 8);
+static_assert(VertexStride<ParticleInstance>() == 16 && VertexStride<DebugDrawVertex>() == 16);
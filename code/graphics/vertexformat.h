@@ -0,0 +1,105 @@
+#pragma once
+#include <cstddef>
+
+#include "types.h"
+#include "graphics/quantize.h"
+
+/*
+* NOTE(sbalse): Vertex formats are described once as C++ types. Every vertex struct specializes
+* VertexLayout<> with the list of its attributes, and the input layout, stride and offsets are all
+* derived from that at compile time, so the struct and what the input assembler reads cannot drift apart.
+* Nothing here depends on a graphics API, graphics/vertexinputlayout.h turns layouts into D3D11 input layouts.
+*
+*     template<> struct VertexLayout<MyVertex>
+*     {
+*         static constexpr VertexAttribute ATTRIBUTES[] =
+*         {
+*             VERTEX_ATTRIBUTE(MyVertex, m_Position, "Position"),
+*         };
+*     };
+*/
+
+// NOTE(sbalse): How the input assembler decodes an attribute.
+enum class VertexFormat
+{
+    FLOAT2,
+    FLOAT3,
+    SNORM16X2,
+    SNORM16X4,
+    HALF2,
+    UNORM8X4,
+    COUNT
+};
+
+// NOTE(sbalse): Maps an attribute type to the format the input assembler decodes it with.
+template<typename T> struct VertexAttributeFormat;
+template<> struct VertexAttributeFormat<Float2>
+{
+    static constexpr VertexFormat FORMAT = VertexFormat::FLOAT2;
+};
+template<> struct VertexAttributeFormat<Float3>
+{
+    static constexpr VertexFormat FORMAT = VertexFormat::FLOAT3;
+};
+template<> struct VertexAttributeFormat<Snorm16x2>
+{
+    static constexpr VertexFormat FORMAT = VertexFormat::SNORM16X2;
+};
+template<> struct VertexAttributeFormat<Snorm16x4>
+{
+    static constexpr VertexFormat FORMAT = VertexFormat::SNORM16X4;
+};
+template<> struct VertexAttributeFormat<Half2>
+{
+    static constexpr VertexFormat FORMAT = VertexFormat::HALF2;
+};
+template<> struct VertexAttributeFormat<OctahedralNormal>
+{
+    static constexpr VertexFormat FORMAT = VertexFormat::SNORM16X2;
+};
+template<> struct VertexAttributeFormat<Unorm8x4>
+{
+    static constexpr VertexFormat FORMAT = VertexFormat::UNORM8X4;
+};
+
+struct VertexAttribute
+{
+    const char* m_Semantic;
+    VertexFormat m_Format;
+    u32 m_Offset;
+    u32 m_Size;
+};
+
+#define VERTEX_ATTRIBUTE(vertex, member, semantic) \
+    VertexAttribute \
+    { \
+        .m_Semantic = semantic, \
+        .m_Format = VertexAttributeFormat<decltype(vertex::member)>::FORMAT, \
+        .m_Offset = static_cast<u32>(offsetof(vertex, member)), \
+        .m_Size = static_cast<u32>(sizeof(vertex::member)), \
+    }
+
+template<typename V> struct VertexLayout;
+
+template<typename V>
+constexpr u32 VertexStride()
+{
+    return static_cast<u32>(sizeof(V));
+}
+
+// NOTE(sbalse): True when the attributes are in member order and cover the vertex without gaps, so no
+// bytes of the vertex buffer are wasted on padding the shader never reads.
+template<typename V>
+constexpr bool VertexLayoutIsTight()
+{
+    u32 offset = 0;
+    for (const VertexAttribute& attribute : VertexLayout<V>::ATTRIBUTES)
+    {
+        if (attribute.m_Offset != offset)
+        {
+            return false;
+        }
+        offset += attribute.m_Size;
+    }
+    return offset == sizeof(V);
+}
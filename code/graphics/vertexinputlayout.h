@@ -0,0 +1,47 @@
+#pragma once
+#include <array>
+#include <d3d11.h>
+
+#include "types.h"
+#include "graphics/vertexformat.h"
+
+// NOTE(sbalse): The D3D11 side of vertex layouts, kept apart so vertex.h builds without the Windows SDK.
+
+constexpr DXGI_FORMAT VertexFormatToDxgi(const VertexFormat format)
+{
+    switch (format)
+    {
+        case VertexFormat::FLOAT2: return DXGI_FORMAT_R32G32_FLOAT;
+        case VertexFormat::FLOAT3: return DXGI_FORMAT_R32G32B32_FLOAT;
+        case VertexFormat::SNORM16X2: return DXGI_FORMAT_R16G16_SNORM;
+        case VertexFormat::SNORM16X4: return DXGI_FORMAT_R16G16B16A16_SNORM;
+        case VertexFormat::HALF2: return DXGI_FORMAT_R16G16_FLOAT;
+        case VertexFormat::UNORM8X4: return DXGI_FORMAT_R8G8B8A8_UNORM;
+        default: return DXGI_FORMAT_UNKNOWN;
+    }
+}
+
+// NOTE(sbalse): With D3D11_INPUT_PER_INSTANCE_DATA the buffer advances once per instance instead of per vertex.
+template<typename V>
+constexpr auto VertexInputLayout(const D3D11_INPUT_CLASSIFICATION classification = D3D11_INPUT_PER_VERTEX_DATA)
+{
+    static_assert(VertexLayoutIsTight<V>(), "Vertex layout does not cover the vertex struct");
+
+    constexpr size_t count = std::size(VertexLayout<V>::ATTRIBUTES);
+    std::array<D3D11_INPUT_ELEMENT_DESC, count> result = {};
+    for (size_t i = 0; i < count; i++)
+    {
+        const VertexAttribute& attribute = VertexLayout<V>::ATTRIBUTES[i];
+        result[i] =
+        {
+            .SemanticName = attribute.m_Semantic,
+            .SemanticIndex = 0,
+            .Format = VertexFormatToDxgi(attribute.m_Format),
+            .InputSlot = 0,
+            .AlignedByteOffset = attribute.m_Offset,
+            .InputSlotClass = classification,
+            .InstanceDataStepRate = classification == D3D11_INPUT_PER_INSTANCE_DATA ? 1u : 0u
+        };
+    }
+    return result;
+}
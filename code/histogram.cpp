@@ -0,0 +1,102 @@
+#include "histogram.h"
+
+#include <bit>
+#include <cstring>
+
+void HistogramReset(Histogram* histogram)
+{
+    std::memset(histogram, 0, sizeof(Histogram));
+}
+
+void HistogramRecord(Histogram* histogram, const u32 value)
+{
+    // NOTE(sbalse): Evict the oldest sample once the window is full.
+    if (histogram->m_Count == HISTOGRAM_WINDOW)
+    {
+        histogram->m_Buckets[histogram->m_WindowBuckets[histogram->m_Head]]--;
+        histogram->m_WindowSum -= histogram->m_WindowValues[histogram->m_Head];
+    }
+    else
+    {
+        histogram->m_Count++;
+    }
+
+    const u32 bucketIndex = HistogramBucketIndex(value);
+    histogram->m_Buckets[bucketIndex]++;
+    histogram->m_WindowBuckets[histogram->m_Head] = static_cast<u16>(bucketIndex);
+    histogram->m_WindowValues[histogram->m_Head] = value;
+    histogram->m_WindowSum += value;
+    histogram->m_Head = (histogram->m_Head + 1) % HISTOGRAM_WINDOW;
+}
+
+u32 HistogramPercentile(const Histogram* histogram, const float percentile)
+{
+    if (histogram->m_Count == 0)
+    {
+        return 0;
+    }
+
+    // NOTE(sbalse): Rank of the sample we are looking for, 1 based.
+    u32 rank = static_cast<u32>(percentile * static_cast<float>(histogram->m_Count) + 0.5f);
+    rank = rank < 1 ? 1 : (rank > histogram->m_Count ? histogram->m_Count : rank);
+
+    u32 seen = 0;
+    for (u32 i = 0; i < HISTOGRAM_BUCKETS; i++)
+    {
+        seen += histogram->m_Buckets[i];
+        if (seen >= rank)
+        {
+            return HistogramBucketValue(i);
+        }
+    }
+
+    return HistogramBucketValue(HISTOGRAM_BUCKETS - 1);
+}
+
+u32 HistogramMean(const Histogram* histogram)
+{
+    if (histogram->m_Count == 0)
+    {
+        return 0;
+    }
+    return static_cast<u32>(histogram->m_WindowSum / histogram->m_Count);
+}
+
+u32 HistogramLast(const Histogram* histogram)
+{
+    if (histogram->m_Count == 0)
+    {
+        return 0;
+    }
+    const u32 last = (histogram->m_Head + HISTOGRAM_WINDOW - 1) % HISTOGRAM_WINDOW;
+    return histogram->m_WindowValues[last];
+}
+
+u32 HistogramBucketIndex(const u32 value)
+{
+    if (value < HISTOGRAM_SUBBUCKETS)
+    {
+        return value;
+    }
+
+    // NOTE(sbalse): Keep the top HISTOGRAM_SUBBUCKET_BITS + 1 bits of the value. The leading one picks the
+    // power of two, the bits after it pick the linear sub bucket inside of it.
+    const u32 shift = static_cast<u32>(std::bit_width(value)) - 1 - HISTOGRAM_SUBBUCKET_BITS;
+    const u32 subBucket = (value >> shift) & (HISTOGRAM_SUBBUCKETS - 1);
+    return HISTOGRAM_SUBBUCKETS + (shift * HISTOGRAM_SUBBUCKETS) + subBucket;
+}
+
+u32 HistogramBucketValue(const u32 bucketIndex)
+{
+    if (bucketIndex < HISTOGRAM_SUBBUCKETS)
+    {
+        return bucketIndex;
+    }
+
+    // NOTE(sbalse): Report the middle of the bucket's range.
+    const u32 shift = (bucketIndex - HISTOGRAM_SUBBUCKETS) / HISTOGRAM_SUBBUCKETS;
+    const u32 subBucket = (bucketIndex - HISTOGRAM_SUBBUCKETS) % HISTOGRAM_SUBBUCKETS;
+    const u64 lower = static_cast<u64>(HISTOGRAM_SUBBUCKETS + subBucket) << shift;
+    const u64 middle = lower + ((1ull << shift) >> 1);
+    return middle > 0xFFFFFFFFull ? 0xFFFFFFFFu : static_cast<u32>(middle);
+}
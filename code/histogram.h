@@ -0,0 +1,31 @@
+#pragma once
+#include "types.h"
+
+/*
+* NOTE(sbalse): Log-linear ("HDR style") histogram over a rolling window of the most recent samples.
+* Values below HISTOGRAM_SUBBUCKETS get a bucket each, every power of two above that is split into
+* HISTOGRAM_SUBBUCKETS linear buckets, so any u32 value is tracked with at most ~3% relative error.
+* All memory is inline: recording a sample never allocates and never locks.
+*/
+constexpr u32 HISTOGRAM_SUBBUCKET_BITS = 4;
+constexpr u32 HISTOGRAM_SUBBUCKETS = 1u << HISTOGRAM_SUBBUCKET_BITS;
+constexpr u32 HISTOGRAM_BUCKETS = HISTOGRAM_SUBBUCKETS * (32 - HISTOGRAM_SUBBUCKET_BITS + 1);
+constexpr u32 HISTOGRAM_WINDOW = 512; // NOTE(sbalse): Number of most recent samples the histogram covers.
+
+struct Histogram
+{
+    u32 m_Buckets[HISTOGRAM_BUCKETS];
+    u16 m_WindowBuckets[HISTOGRAM_WINDOW]; // NOTE(sbalse): Bucket of every sample in the window, to evict it.
+    u32 m_WindowValues[HISTOGRAM_WINDOW];
+    u64 m_WindowSum;
+    u32 m_Head; // NOTE(sbalse): Next slot of the window to be written.
+    u32 m_Count; // NOTE(sbalse): Number of valid samples in the window.
+};
+
+void HistogramReset(Histogram* histogram);
+void HistogramRecord(Histogram* histogram, const u32 value);
+u32 HistogramPercentile(const Histogram* histogram, const float percentile);
+u32 HistogramMean(const Histogram* histogram);
+u32 HistogramLast(const Histogram* histogram);
+u32 HistogramBucketIndex(const u32 value);
+u32 HistogramBucketValue(const u32 bucketIndex);
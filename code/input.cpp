@@ -20,6 +20,27 @@ constinit std::bitset<NUMMOUSEBUTTONS> s_MouseButtonUps; // NOTE(sbalse): 1 = bu
 constinit i32 s_MouseX = 0; // NOTE(sbalse): The current mouse pointer x-coordinate. Updated constantly.
 constinit i32 s_MouseY = 0; // NOTE(sbalse): The current mouse pointer y-coordinate. Updated constantly.
 
+namespace
+{
+    template<size_t N>
+    void InputStoreBits(const std::bitset<N>& bits, InputButtonSet* result, const u32 firstBit)
+    {
+        // NOTE(sbalse): Move the bits over 64 at a time with wide bitset operations.
+        constexpr u32 wordCount = (N + 63) / 64;
+        const std::bitset<N> wordMask(~0ull);
+        for (u32 word = 0; word < wordCount; word++)
+        {
+            const u64 value = ((bits >> (word * 64)) & wordMask).to_ullong();
+            const u32 bit = firstBit + word * 64;
+            result->m_Words[bit / 64] |= value << (bit % 64);
+            if (bit % 64 != 0 && (bit / 64) + 1 < INPUT_BUTTON_WORDS)
+            {
+                result->m_Words[(bit / 64) + 1] |= value >> (64 - (bit % 64));
+            }
+        }
+    }
+}
+
 bool InputKeyboardButtonCheck(const u8 button)
 {
     return s_ButtonState[button];
@@ -63,6 +84,19 @@ bool InputMouseButtonReleased(const MouseButton button)
     return s_MouseButtonUps[buttonInt];
 }
 
+void InputGetFrameState(InputFrameState* state)
+{
+    *state = {};
+
+    InputStoreBits(s_ButtonState, &state->m_Held, 0);
+    InputStoreBits(s_ButtonDowns & ~s_PrevButtonState, &state->m_Pressed, 0);
+    InputStoreBits(s_ButtonUps, &state->m_Released, 0);
+
+    InputStoreBits(s_MouseButtonState, &state->m_Held, INPUT_MOUSE_BUTTON_BASE);
+    InputStoreBits(s_MouseButtonDowns & ~s_PrevMouseButtonState, &state->m_Pressed, INPUT_MOUSE_BUTTON_BASE);
+    InputStoreBits(s_MouseButtonUps, &state->m_Released, INPUT_MOUSE_BUTTON_BASE);
+}
+
 void InputClear(const bool resetPrevFrameInput)
 {
     s_ButtonDowns.reset();
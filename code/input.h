@@ -18,6 +18,28 @@ bool InputMouseButtonCheck(MouseButton button);
 bool InputMouseButtonPressed(MouseButton button);
 bool InputMouseButtonReleased(MouseButton button);
 
+// NOTE(sbalse): All buttons as one flat bit set. Keyboard buttons are bits 0-255 (their virtual key codes),
+// mouse buttons follow from INPUT_MOUSE_BUTTON_BASE.
+constexpr u32 INPUT_NUM_KEYBOARD_BUTTONS = 256;
+constexpr u32 INPUT_MOUSE_BUTTON_BASE = INPUT_NUM_KEYBOARD_BUTTONS;
+constexpr u32 INPUT_NUM_BUTTONS = INPUT_MOUSE_BUTTON_BASE + static_cast<u32>(MouseButton::COUNT);
+constexpr u32 INPUT_BUTTON_WORDS = (INPUT_NUM_BUTTONS + 63) / 64;
+
+struct InputButtonSet
+{
+    u64 m_Words[INPUT_BUTTON_WORDS];
+};
+
+// NOTE(sbalse): Same meaning as the Check/Pressed/Released queries above, for every button at once.
+struct InputFrameState
+{
+    InputButtonSet m_Held;
+    InputButtonSet m_Pressed;
+    InputButtonSet m_Released;
+};
+
+void InputGetFrameState(InputFrameState* state);
+
 void InputClear(bool resetPrevFrameInput);
 void InputEndFrame();
 void InputKeyboardUpdate(u8 button, bool pressed);
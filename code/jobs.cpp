@@ -0,0 +1,288 @@
+#include "jobs.h"
+
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+    struct JobBatch
+    {
+        JobFunction m_Function;
+        void* m_Context;
+        u32 m_Begin;
+        u32 m_End;
+        u32 m_Slot;
+    };
+
+    // NOTE(sbalse): A slot is free when no batches remain. The generation tells a stale handle apart from the
+    // job that reuses its slot.
+    struct JobCounter
+    {
+        std::atomic<u32> m_Remaining;
+        std::atomic<u32> m_Generation;
+    };
+
+    struct JobSystem
+    {
+        std::thread* m_Workers;
+        u32 m_WorkerCount;
+        bool m_Running; // NOTE(sbalse): Guarded by m_Mutex.
+        std::mutex m_Mutex;
+        std::condition_variable m_WorkAvailable;
+        std::condition_variable m_JobDone; // NOTE(sbalse): For JobsWait(), signalled with m_Mutex held.
+        // NOTE(sbalse): Ring of queued batches, guarded by m_Mutex.
+        JobBatch m_Queue[JOBS_MAX_QUEUED_BATCHES];
+        u32 m_QueueHead;
+        u32 m_QueueCount;
+        JobCounter m_Counters[JOBS_MAX_PENDING];
+        std::atomic<u32> m_NextSlot;
+        std::atomic<u32> m_OtherThreadCount;
+        u32 m_Generation;
+    };
+
+    JobSystem* g_Jobs = nullptr;
+    constinit u32 g_JobsGeneration = 0;
+
+    // NOTE(sbalse): Only valid while s_JobsThreadGeneration matches the running job system, so an index handed out
+    // by an earlier one is never reused.
+    thread_local u32 s_JobsThreadIndex = 0;
+    thread_local u32 s_JobsThreadGeneration = 0;
+
+    void JobsSetThreadIndex(const u32 threadIndex)
+    {
+        s_JobsThreadIndex = threadIndex;
+        s_JobsThreadGeneration = g_Jobs->m_Generation;
+    }
+
+    void JobsRunBatch(const JobBatch* batch)
+    {
+        batch->m_Function(batch->m_Context, batch->m_Begin, batch->m_End);
+        if (g_Jobs->m_Counters[batch->m_Slot].m_Remaining.fetch_sub(1, std::memory_order_release) == 1)
+        {
+            // NOTE(sbalse): Taking the lock orders this after a waiter that just saw the job unfinished goes to sleep.
+            std::lock_guard<std::mutex> lock(g_Jobs->m_Mutex);
+            g_Jobs->m_JobDone.notify_all();
+        }
+    }
+
+    // NOTE(sbalse): m_Mutex must be held.
+    bool JobsPopBatch(JobBatch* batch)
+    {
+        if (g_Jobs->m_QueueCount == 0)
+        {
+            return false;
+        }
+
+        *batch = g_Jobs->m_Queue[g_Jobs->m_QueueHead];
+        g_Jobs->m_QueueHead = (g_Jobs->m_QueueHead + 1) % JOBS_MAX_QUEUED_BATCHES;
+        g_Jobs->m_QueueCount--;
+        return true;
+    }
+
+    void JobsWorkerMain(const u32 threadIndex)
+    {
+        JobsSetThreadIndex(threadIndex);
+
+        for (;;)
+        {
+            JobBatch batch = {};
+            {
+                std::unique_lock<std::mutex> lock(g_Jobs->m_Mutex);
+                g_Jobs->m_WorkAvailable.wait(lock, []() { return !g_Jobs->m_Running || g_Jobs->m_QueueCount > 0; });
+
+                // NOTE(sbalse): Drain what is queued before leaving, so nobody waits on a job forever.
+                if (!JobsPopBatch(&batch))
+                {
+                    return;
+                }
+            }
+
+            JobsRunBatch(&batch);
+        }
+    }
+
+    // NOTE(sbalse): Claims a free counter slot for batchCount batches. Returns JOBS_MAX_PENDING when all are busy.
+    u32 JobsClaimSlot(const u32 batchCount)
+    {
+        for (u32 attempt = 0; attempt < JOBS_MAX_PENDING; attempt++)
+        {
+            const u32 slot = g_Jobs->m_NextSlot.fetch_add(1, std::memory_order_relaxed) % JOBS_MAX_PENDING;
+            u32 expected = 0;
+            if (g_Jobs->m_Counters[slot].m_Remaining.compare_exchange_strong(
+                expected, batchCount, std::memory_order_acquire, std::memory_order_relaxed))
+            {
+                return slot;
+            }
+        }
+        return JOBS_MAX_PENDING;
+    }
+}
+
+bool JobsInit(const u32 workerCount)
+{
+    u32 count = workerCount;
+    if (count == 0)
+    {
+        const u32 hardwareThreads = std::thread::hardware_concurrency();
+        count = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+    }
+
+    g_Jobs = new JobSystem();
+    g_Jobs->m_Running = true;
+    g_Jobs->m_WorkerCount = count;
+    g_Jobs->m_Generation = ++g_JobsGeneration;
+    JobsSetThreadIndex(0);
+    g_Jobs->m_Workers = new std::thread[count];
+    for (u32 i = 0; i < count; i++)
+    {
+        g_Jobs->m_Workers[i] = std::thread(JobsWorkerMain, i + 1);
+    }
+
+    return true;
+}
+
+void JobsShutdown()
+{
+    if (!g_Jobs)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(g_Jobs->m_Mutex);
+        g_Jobs->m_Running = false;
+    }
+    g_Jobs->m_WorkAvailable.notify_all();
+
+    for (u32 i = 0; i < g_Jobs->m_WorkerCount; i++)
+    {
+        g_Jobs->m_Workers[i].join();
+    }
+
+    delete[] g_Jobs->m_Workers;
+    delete g_Jobs;
+    g_Jobs = nullptr;
+}
+
+u32 JobsWorkerCount()
+{
+    return g_Jobs ? g_Jobs->m_WorkerCount : 0;
+}
+
+u32 JobsThreadIndex()
+{
+    if (!g_Jobs)
+    {
+        return 0;
+    }
+
+    if (s_JobsThreadGeneration != g_Jobs->m_Generation)
+    {
+        const u32 otherThread = g_Jobs->m_OtherThreadCount.fetch_add(1, std::memory_order_relaxed);
+        assert(otherThread < JOBS_MAX_OTHER_THREADS && "Raise JOBS_MAX_OTHER_THREADS");
+        JobsSetThreadIndex(g_Jobs->m_WorkerCount + 1 + otherThread);
+    }
+    return s_JobsThreadIndex;
+}
+
+u32 JobsThreadCount()
+{
+    return g_Jobs ? g_Jobs->m_WorkerCount + 1 + JOBS_MAX_OTHER_THREADS : 1;
+}
+
+JobHandle JobsDispatch(const u32 count, const u32 batchSize, const JobFunction function, void* context)
+{
+    const JobHandle done = { .m_Slot = JOBS_MAX_PENDING, .m_Generation = 0 };
+    if (count == 0)
+    {
+        return done;
+    }
+
+    const u32 batchCount = (count + batchSize - 1) / batchSize;
+    const bool parallel = g_Jobs && g_Jobs->m_WorkerCount > 0;
+    const u32 slot = parallel ? JobsClaimSlot(batchCount) : JOBS_MAX_PENDING;
+    if (slot == JOBS_MAX_PENDING)
+    {
+        function(context, 0, count);
+        return done;
+    }
+
+    JobCounter* counter = &g_Jobs->m_Counters[slot];
+    const JobHandle handle =
+    {
+        .m_Slot = slot,
+        .m_Generation = counter->m_Generation.fetch_add(1, std::memory_order_relaxed) + 1,
+    };
+
+    // NOTE(sbalse): Whatever does not fit in the queue runs right here.
+    u32 batch = 0;
+    {
+        std::lock_guard<std::mutex> lock(g_Jobs->m_Mutex);
+        for (; batch < batchCount && g_Jobs->m_QueueCount < JOBS_MAX_QUEUED_BATCHES; batch++)
+        {
+            const u32 begin = batch * batchSize;
+            const u32 tail = (g_Jobs->m_QueueHead + g_Jobs->m_QueueCount) % JOBS_MAX_QUEUED_BATCHES;
+            g_Jobs->m_Queue[tail] =
+            {
+                .m_Function = function,
+                .m_Context = context,
+                .m_Begin = begin,
+                .m_End = count - begin < batchSize ? count : begin + batchSize,
+                .m_Slot = slot,
+            };
+            g_Jobs->m_QueueCount++;
+        }
+    }
+    g_Jobs->m_WorkAvailable.notify_all();
+    g_Jobs->m_JobDone.notify_all(); // NOTE(sbalse): Waiters help with any job's batches.
+
+    for (; batch < batchCount; batch++)
+    {
+        const u32 begin = batch * batchSize;
+        const JobBatch inlineBatch =
+        {
+            .m_Function = function,
+            .m_Context = context,
+            .m_Begin = begin,
+            .m_End = count - begin < batchSize ? count : begin + batchSize,
+            .m_Slot = slot,
+        };
+        JobsRunBatch(&inlineBatch);
+    }
+
+    return handle;
+}
+
+bool JobsIsDone(const JobHandle handle)
+{
+    if (handle.m_Slot >= JOBS_MAX_PENDING)
+    {
+        return true;
+    }
+
+    const JobCounter* counter = &g_Jobs->m_Counters[handle.m_Slot];
+    return counter->m_Generation.load(std::memory_order_acquire) != handle.m_Generation
+        || counter->m_Remaining.load(std::memory_order_acquire) == 0;
+}
+
+void JobsWait(const JobHandle handle)
+{
+    while (!JobsIsDone(handle))
+    {
+        JobBatch batch = {};
+        {
+            // NOTE(sbalse): Help with whatever is queued, sleep while the last batches run on the workers.
+            std::unique_lock<std::mutex> lock(g_Jobs->m_Mutex);
+            g_Jobs->m_JobDone.wait(lock, [handle]() { return JobsIsDone(handle) || g_Jobs->m_QueueCount > 0; });
+            if (JobsIsDone(handle) || !JobsPopBatch(&batch))
+            {
+                return;
+            }
+        }
+
+        JobsRunBatch(&batch);
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "types.h"
+
+/*
+* NOTE(sbalse): A pool of worker threads that runs data parallel jobs. A job is a function applied to the index
+* range [0, count), cut into batches that the workers pick up. Results must not depend on how the range was
+* cut, so a job gives the same output whatever the number of workers.
+*/
+
+// NOTE(sbalse): Processes the indices [begin, end).
+using JobFunction = void (*)(void* context, const u32 begin, const u32 end);
+
+struct JobHandle
+{
+    u32 m_Slot;
+    u32 m_Generation;
+};
+
+// NOTE(sbalse): Jobs that can be in flight at once. Dispatching more runs the job on the calling thread.
+constexpr u32 JOBS_MAX_PENDING = 256;
+constexpr u32 JOBS_MAX_QUEUED_BATCHES = 4096;
+
+// NOTE(sbalse): Threads other than the workers and the one that called JobsInit() that may ask for their index.
+constexpr u32 JOBS_MAX_OTHER_THREADS = 8;
+
+// NOTE(sbalse): A workerCount of 0 uses one worker per hardware thread, minus the calling thread.
+bool JobsInit(const u32 workerCount);
+void JobsShutdown();
+u32 JobsWorkerCount();
+// NOTE(sbalse): Unique per thread and below JobsThreadCount(), for indexing per thread data. 0 on the thread that
+// called JobsInit(), 1 to JobsWorkerCount() on the workers. Any other thread gets the next free index the first
+// time it asks.
+u32 JobsThreadIndex();
+u32 JobsThreadCount();
+
+// NOTE(sbalse): Queues function over [0, count) in batches of batchSize indices. Without workers the job runs
+// to completion before this returns.
+JobHandle JobsDispatch(const u32 count, const u32 batchSize, const JobFunction function, void* context);
+bool JobsIsDone(const JobHandle handle);
+// NOTE(sbalse): Runs queued batches on the calling thread until the job is done, then sleeps until the batches
+// still running on the workers finish.
+void JobsWait(const JobHandle handle);
@@ -0,0 +1,526 @@
+#include "lightclusters.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <immintrin.h>
+
+#include "cpufeatures.h"
+#include "jobs.h"
+
+namespace
+{
+    // NOTE(sbalse): Marks a light that misses the frustum in place of its slice range.
+    constexpr u32 LIGHTCLUSTERS_CULLED = ~0u;
+    // NOTE(sbalse): Screen coordinate of a side of a light that reaches around behind the eye.
+    constexpr float LIGHTCLUSTERS_UNBOUNDED = 2.0f;
+    // NOTE(sbalse): Spot lights narrower than 45 degrees either side are bound by the sphere through their apex and
+    // the rim of their base, wider ones by the sphere around the base.
+    constexpr float LIGHTCLUSTERS_WIDE_COSINE = 0.70710678f;
+
+    constinit bool g_LightClustersSimdRequested = true;
+
+    // NOTE(sbalse): What an update needs from the frustum. m_Scale takes the view direction x / z or y / z to
+    // screen coordinates from -1 to 1.
+    struct LightClustersView
+    {
+        float m_Scale[2];
+        float m_Near;
+        float m_Far;
+        float m_SliceStart[LIGHTCLUSTERS_SLICES];
+    };
+}
+
+struct LightClusters
+{
+    u32 m_Capacity;
+    // NOTE(sbalse): Per light, the first and last tile on x and y a byte each, and the first and last slice.
+    u32* m_Tiles;
+    u32* m_Slices;
+    u32* m_FillCounts; // NOTE(sbalse): Entries of every batch in every cluster, then where the batch writes them.
+    u16* m_Indices;
+    u32 m_IndexCapacity;
+
+    // NOTE(sbalse): Only during an update.
+    const LightClustersLights* m_Lights;
+    LightClustersView m_View;
+
+    LightClustersRange m_Ranges[LIGHTCLUSTERS_COUNT];
+    LightClustersStats m_Stats;
+};
+
+namespace
+{
+    u32 LightClustersTile(const float screen, const u32 tiles)
+    {
+        const float tile = (screen + 1.0f) * (0.5f * static_cast<float>(tiles));
+        const float last = static_cast<float>(tiles - 1);
+        return static_cast<u32>(tile > 0.0f ? (tile < last ? tile : last) : 0.0f);
+    }
+
+    // NOTE(sbalse): Tiles along one screen axis a sphere covers, from the two planes through the eye and the other
+    // screen axis that touch it. A plane touching the sphere behind the eye leaves that side unbounded.
+    u32 LightClustersTiles(
+        const float center,
+        const float depth,
+        const float radius,
+        const float scale,
+        const u32 tiles,
+        bool* outside)
+    {
+        const float distanceSquared = center * center + depth * depth;
+        const float radiusSquared = radius * radius;
+        const bool inside = distanceSquared <= radiusSquared;
+        const float difference = distanceSquared - radiusSquared;
+        const float tangent = std::sqrt(difference > 0.0f ? difference : 0.0f);
+
+        const float lowDenominator = depth * tangent + center * radius;
+        const float highDenominator = depth * tangent - center * radius;
+        const float low = inside || !(lowDenominator > 0.0f)
+            ? -LIGHTCLUSTERS_UNBOUNDED
+            : (center * tangent - depth * radius) / lowDenominator * scale;
+        const float high = inside || !(highDenominator > 0.0f)
+            ? LIGHTCLUSTERS_UNBOUNDED
+            : (center * tangent + depth * radius) / highDenominator * scale;
+
+        *outside = *outside || low > 1.0f || high < -1.0f;
+        return LightClustersTile(low, tiles) | (LightClustersTile(high, tiles) << 8);
+    }
+
+    void LightClustersBoundScalar(LightClusters* clusters, const u32 light)
+    {
+        const LightClustersLights* lights = clusters->m_Lights;
+        const LightClustersView* view = &clusters->m_View;
+
+        float center[3] = { lights->m_Position[0][light], lights->m_Position[1][light], lights->m_Position[2][light] };
+        const float range = lights->m_Range[light];
+        float radius = range;
+
+        const float cosine = lights->m_SpotCosine ? lights->m_SpotCosine[light] : -1.0f;
+        if (cosine > 0.0f)
+        {
+            const bool wide = cosine < LIGHTCLUSTERS_WIDE_COSINE;
+            const float sine = std::sqrt(1.0f - cosine * cosine);
+            const float half = range / (2.0f * cosine);
+            const float offset = wide ? range * cosine : half;
+            radius = wide ? range * sine : half;
+            for (u32 i = 0; i < 3; i++)
+            {
+                center[i] = center[i] + lights->m_Direction[i][light] * offset;
+            }
+        }
+
+        const float front = center[2] - radius;
+        const float back = center[2] + radius;
+        bool outside = back < view->m_Near || front > view->m_Far;
+        u32 firstSlice = 0;
+        u32 lastSlice = 0;
+        for (u32 slice = 1; slice < LIGHTCLUSTERS_SLICES; slice++)
+        {
+            firstSlice += front >= view->m_SliceStart[slice] ? 1 : 0;
+            lastSlice += back >= view->m_SliceStart[slice] ? 1 : 0;
+        }
+
+        const u32 tilesX =
+            LightClustersTiles(center[0], center[2], radius, view->m_Scale[0], LIGHTCLUSTERS_TILES_X, &outside);
+        const u32 tilesY =
+            LightClustersTiles(center[1], center[2], radius, view->m_Scale[1], LIGHTCLUSTERS_TILES_Y, &outside);
+        clusters->m_Tiles[light] = tilesX | (tilesY << 16);
+        clusters->m_Slices[light] = outside ? LIGHTCLUSTERS_CULLED : firstSlice | (lastSlice << 8);
+    }
+
+    CPU_AVX2 void LightClustersTileAvx2(const __m256* screen, const u32 tiles, __m256i* tile)
+    {
+        const __m256 scaled = _mm256_mul_ps(
+            _mm256_add_ps(*screen, _mm256_set1_ps(1.0f)),
+            _mm256_set1_ps(0.5f * static_cast<float>(tiles)));
+        const __m256 last = _mm256_set1_ps(static_cast<float>(tiles - 1));
+        const __m256 below = _mm256_blendv_ps(last, scaled, _mm256_cmp_ps(scaled, last, _CMP_LT_OQ));
+        const __m256 clamped = _mm256_blendv_ps(
+            _mm256_setzero_ps(),
+            below,
+            _mm256_cmp_ps(scaled, _mm256_setzero_ps(), _CMP_GT_OQ));
+        *tile = _mm256_cvttps_epi32(clamped);
+    }
+
+    // NOTE(sbalse): LightClustersTiles() for eight lights.
+    CPU_AVX2 void LightClustersTilesAvx2(
+        const __m256* center,
+        const __m256* depth,
+        const __m256* radius,
+        const float scale,
+        const u32 tiles,
+        __m256* outside,
+        __m256i* packed)
+    {
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 distanceSquared = _mm256_add_ps(_mm256_mul_ps(*center, *center), _mm256_mul_ps(*depth, *depth));
+        const __m256 radiusSquared = _mm256_mul_ps(*radius, *radius);
+        const __m256 inside = _mm256_cmp_ps(distanceSquared, radiusSquared, _CMP_LE_OQ);
+        const __m256 difference = _mm256_sub_ps(distanceSquared, radiusSquared);
+        const __m256 tangent = _mm256_sqrt_ps(
+            _mm256_blendv_ps(zero, difference, _mm256_cmp_ps(difference, zero, _CMP_GT_OQ)));
+
+        const __m256 depthTangent = _mm256_mul_ps(*depth, tangent);
+        const __m256 centerRadius = _mm256_mul_ps(*center, *radius);
+        const __m256 centerTangent = _mm256_mul_ps(*center, tangent);
+        const __m256 depthRadius = _mm256_mul_ps(*depth, *radius);
+        const __m256 lowDenominator = _mm256_add_ps(depthTangent, centerRadius);
+        const __m256 highDenominator = _mm256_sub_ps(depthTangent, centerRadius);
+        const __m256 lowBounded = _mm256_andnot_ps(inside, _mm256_cmp_ps(lowDenominator, zero, _CMP_GT_OQ));
+        const __m256 highBounded = _mm256_andnot_ps(inside, _mm256_cmp_ps(highDenominator, zero, _CMP_GT_OQ));
+        const __m256 scales = _mm256_set1_ps(scale);
+        const __m256 low = _mm256_blendv_ps(
+            _mm256_set1_ps(-LIGHTCLUSTERS_UNBOUNDED),
+            _mm256_mul_ps(_mm256_div_ps(_mm256_sub_ps(centerTangent, depthRadius), lowDenominator), scales),
+            lowBounded);
+        const __m256 high = _mm256_blendv_ps(
+            _mm256_set1_ps(LIGHTCLUSTERS_UNBOUNDED),
+            _mm256_mul_ps(_mm256_div_ps(_mm256_add_ps(centerTangent, depthRadius), highDenominator), scales),
+            highBounded);
+
+        *outside = _mm256_or_ps(
+            *outside,
+            _mm256_or_ps(
+                _mm256_cmp_ps(low, _mm256_set1_ps(1.0f), _CMP_GT_OQ),
+                _mm256_cmp_ps(high, _mm256_set1_ps(-1.0f), _CMP_LT_OQ)));
+
+        __m256i first = {};
+        __m256i last = {};
+        LightClustersTileAvx2(&low, tiles, &first);
+        LightClustersTileAvx2(&high, tiles, &last);
+        *packed = _mm256_or_si256(first, _mm256_slli_epi32(last, 8));
+    }
+
+    // NOTE(sbalse): LightClustersBoundScalar() for eight lights starting at first.
+    CPU_AVX2 void LightClustersBoundAvx2(LightClusters* clusters, const u32 first)
+    {
+        const LightClustersLights* lights = clusters->m_Lights;
+        const LightClustersView* view = &clusters->m_View;
+
+        __m256 center[3] = {};
+        for (u32 i = 0; i < 3; i++)
+        {
+            center[i] = _mm256_loadu_ps(lights->m_Position[i] + first);
+        }
+        const __m256 range = _mm256_loadu_ps(lights->m_Range + first);
+        __m256 radius = range;
+
+        if (lights->m_SpotCosine)
+        {
+            const __m256 cosine = _mm256_loadu_ps(lights->m_SpotCosine + first);
+            const __m256 spot = _mm256_cmp_ps(cosine, _mm256_setzero_ps(), _CMP_GT_OQ);
+            const __m256 wide = _mm256_cmp_ps(cosine, _mm256_set1_ps(LIGHTCLUSTERS_WIDE_COSINE), _CMP_LT_OQ);
+            const __m256 sine = _mm256_sqrt_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f), _mm256_mul_ps(cosine, cosine)));
+            const __m256 half = _mm256_div_ps(range, _mm256_mul_ps(_mm256_set1_ps(2.0f), cosine));
+            const __m256 offset = _mm256_blendv_ps(half, _mm256_mul_ps(range, cosine), wide);
+            radius = _mm256_blendv_ps(range, _mm256_blendv_ps(half, _mm256_mul_ps(range, sine), wide), spot);
+            for (u32 i = 0; i < 3; i++)
+            {
+                const __m256 direction = _mm256_loadu_ps(lights->m_Direction[i] + first);
+                center[i] = _mm256_blendv_ps(
+                    center[i],
+                    _mm256_add_ps(center[i], _mm256_mul_ps(direction, offset)),
+                    spot);
+            }
+        }
+
+        const __m256 front = _mm256_sub_ps(center[2], radius);
+        const __m256 back = _mm256_add_ps(center[2], radius);
+        __m256 outside = _mm256_or_ps(
+            _mm256_cmp_ps(back, _mm256_set1_ps(view->m_Near), _CMP_LT_OQ),
+            _mm256_cmp_ps(front, _mm256_set1_ps(view->m_Far), _CMP_GT_OQ));
+
+        // NOTE(sbalse): Compare masks are -1, so subtracting them counts.
+        __m256i firstSlice = _mm256_setzero_si256();
+        __m256i lastSlice = _mm256_setzero_si256();
+        for (u32 slice = 1; slice < LIGHTCLUSTERS_SLICES; slice++)
+        {
+            const __m256 start = _mm256_set1_ps(view->m_SliceStart[slice]);
+            firstSlice = _mm256_sub_epi32(firstSlice, _mm256_castps_si256(_mm256_cmp_ps(front, start, _CMP_GE_OQ)));
+            lastSlice = _mm256_sub_epi32(lastSlice, _mm256_castps_si256(_mm256_cmp_ps(back, start, _CMP_GE_OQ)));
+        }
+
+        __m256i tilesX = {};
+        __m256i tilesY = {};
+        LightClustersTilesAvx2(
+            &center[0], &center[2], &radius, view->m_Scale[0], LIGHTCLUSTERS_TILES_X, &outside, &tilesX);
+        LightClustersTilesAvx2(
+            &center[1], &center[2], &radius, view->m_Scale[1], LIGHTCLUSTERS_TILES_Y, &outside, &tilesY);
+
+        const __m256i slices = _mm256_blendv_epi8(
+            _mm256_or_si256(firstSlice, _mm256_slli_epi32(lastSlice, 8)),
+            _mm256_set1_epi32(static_cast<int>(LIGHTCLUSTERS_CULLED)),
+            _mm256_castps_si256(outside));
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(clusters->m_Tiles + first),
+            _mm256_or_si256(tilesX, _mm256_slli_epi32(tilesY, 16)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(clusters->m_Slices + first), slices);
+    }
+
+    // NOTE(sbalse): Calls visit(row) for the first cluster of every row of clusters a light reaches in, visit(row, x)
+    // for every cluster.
+    template<typename VisitRow>
+    void LightClustersForEachRow(const u32 tiles, const u32 slices, const VisitRow& visit)
+    {
+        if (slices == LIGHTCLUSTERS_CULLED)
+        {
+            return;
+        }
+
+        const u32 firstY = (tiles >> 16) & 0xFF;
+        const u32 lastY = tiles >> 24;
+        const u32 firstSlice = slices & 0xFF;
+        const u32 lastSlice = slices >> 8;
+        for (u32 slice = firstSlice; slice <= lastSlice; slice++)
+        {
+            for (u32 y = firstY; y <= lastY; y++)
+            {
+                visit(((slice * LIGHTCLUSTERS_TILES_Y) + y) * LIGHTCLUSTERS_TILES_X);
+            }
+        }
+    }
+
+    u32* LightClustersFillCounts(const LightClusters* clusters, const u32 light)
+    {
+        return clusters->m_FillCounts + (static_cast<size_t>(light / LIGHTCLUSTERS_BATCH) * LIGHTCLUSTERS_COUNT);
+    }
+
+    // NOTE(sbalse): Bounds the lights and counts the entries of every batch in every cluster. Without workers a
+    // dispatch runs as a single range, so the batches are walked here.
+    void LightClustersCountRange(void* context, const u32 begin, const u32 end)
+    {
+        LightClusters* clusters = static_cast<LightClusters*>(context);
+
+        u32 light = begin;
+        if (LightClustersSimdEnabled())
+        {
+            for (; light + 8 <= end; light += 8)
+            {
+                LightClustersBoundAvx2(clusters, light);
+            }
+        }
+        for (; light < end; light++)
+        {
+            LightClustersBoundScalar(clusters, light);
+        }
+
+        // NOTE(sbalse): Lights cover runs of clusters along x, so only where a run starts and where it stops is
+        // counted here. The update sums the counts along every row.
+        for (u32 i = begin; i < end; i++)
+        {
+            u32* counts = LightClustersFillCounts(clusters, i);
+            if (i % LIGHTCLUSTERS_BATCH == 0)
+            {
+                std::memset(counts, 0, LIGHTCLUSTERS_COUNT * sizeof(u32));
+            }
+
+            const u32 tiles = clusters->m_Tiles[i];
+            const u32 firstX = tiles & 0xFF;
+            const u32 stopX = ((tiles >> 8) & 0xFF) + 1;
+            LightClustersForEachRow(tiles, clusters->m_Slices[i], [=](const u32 row)
+            {
+                counts[row + firstX]++;
+                if (stopX < LIGHTCLUSTERS_TILES_X)
+                {
+                    counts[row + stopX]--;
+                }
+            });
+        }
+    }
+
+    // NOTE(sbalse): Lights are visited in order and every batch writes after the batches before it, so every list
+    // comes out in light order.
+    void LightClustersFillRange(void* context, const u32 begin, const u32 end)
+    {
+        const LightClusters* clusters = static_cast<const LightClusters*>(context);
+        u16* indices = clusters->m_Indices;
+        for (u32 i = begin; i < end; i++)
+        {
+            u32* cursors = LightClustersFillCounts(clusters, i);
+            const u32 tiles = clusters->m_Tiles[i];
+            const u32 firstX = tiles & 0xFF;
+            const u32 lastX = (tiles >> 8) & 0xFF;
+            LightClustersForEachRow(tiles, clusters->m_Slices[i], [&](const u32 row)
+            {
+                for (u32 x = firstX; x <= lastX; x++)
+                {
+                    indices[cursors[row + x]++] = static_cast<u16>(i);
+                }
+            });
+        }
+    }
+
+    bool LightClustersReserveIndices(LightClusters* clusters, const u32 count)
+    {
+        if (count <= clusters->m_IndexCapacity)
+        {
+            return true;
+        }
+
+        // NOTE(sbalse): Grow with some headroom, lights move between clusters every update.
+        const u32 capacity = count + (count / 4);
+        void* indices = std::realloc(clusters->m_Indices, static_cast<size_t>(capacity) * sizeof(u16));
+        if (!indices)
+        {
+            return false;
+        }
+        clusters->m_Indices = static_cast<u16*>(indices);
+        clusters->m_IndexCapacity = capacity;
+        return true;
+    }
+
+    LightClustersView LightClustersMakeView(const LightClustersFrustum* frustum)
+    {
+        LightClustersView view =
+        {
+            .m_Scale = { 2.0f * frustum->m_Near / frustum->m_Width, 2.0f * frustum->m_Near / frustum->m_Height },
+            .m_Near = frustum->m_Near,
+            .m_Far = frustum->m_Far,
+            .m_SliceStart = {},
+        };
+
+        // NOTE(sbalse): Every slice is the same factor deeper than the one before it.
+        const double ratio = static_cast<double>(frustum->m_Far) / frustum->m_Near;
+        for (u32 slice = 0; slice < LIGHTCLUSTERS_SLICES; slice++)
+        {
+            const double exponent = static_cast<double>(slice) / LIGHTCLUSTERS_SLICES;
+            view.m_SliceStart[slice] = static_cast<float>(frustum->m_Near * std::pow(ratio, exponent));
+        }
+        return view;
+    }
+}
+
+LightClusters* LightClustersCreate(const u32 capacity)
+{
+    LightClusters* clusters = static_cast<LightClusters*>(std::calloc(1, sizeof(LightClusters)));
+    if (!clusters)
+    {
+        return nullptr;
+    }
+
+    const u32 lightCount = capacity < LIGHTCLUSTERS_MAX_LIGHTS ? capacity : LIGHTCLUSTERS_MAX_LIGHTS;
+    const u32 batches = (lightCount + LIGHTCLUSTERS_BATCH - 1) / LIGHTCLUSTERS_BATCH;
+    const size_t streamSize = lightCount > 0 ? lightCount : 1;
+    clusters->m_Capacity = lightCount;
+    clusters->m_Tiles = static_cast<u32*>(std::calloc(streamSize, sizeof(u32)));
+    clusters->m_Slices = static_cast<u32*>(std::calloc(streamSize, sizeof(u32)));
+    clusters->m_FillCounts = static_cast<u32*>(
+        std::calloc(static_cast<size_t>(batches > 0 ? batches : 1) * LIGHTCLUSTERS_COUNT, sizeof(u32)));
+    if (!clusters->m_Tiles || !clusters->m_Slices || !clusters->m_FillCounts)
+    {
+        LightClustersDestroy(clusters);
+        return nullptr;
+    }
+    return clusters;
+}
+
+void LightClustersDestroy(LightClusters* clusters)
+{
+    if (!clusters)
+    {
+        return;
+    }
+
+    std::free(clusters->m_Indices);
+    std::free(clusters->m_FillCounts);
+    std::free(clusters->m_Slices);
+    std::free(clusters->m_Tiles);
+    std::free(clusters);
+}
+
+bool LightClustersUpdate(
+    LightClusters* clusters,
+    const LightClustersFrustum* frustum,
+    const LightClustersLights* lights,
+    const u32 count)
+{
+    const u32 lightCount = count < clusters->m_Capacity ? count : clusters->m_Capacity;
+    std::memset(clusters->m_Ranges, 0, sizeof(clusters->m_Ranges));
+    clusters->m_Stats = { .m_Lights = lightCount, .m_Visible = 0, .m_Indices = 0, .m_MaxClusterLights = 0 };
+    if (lightCount == 0)
+    {
+        return true;
+    }
+
+    clusters->m_Lights = lights;
+    clusters->m_View = LightClustersMakeView(frustum);
+    JobsWait(JobsDispatch(lightCount, LIGHTCLUSTERS_BATCH, LightClustersCountRange, clusters));
+
+    // NOTE(sbalse): Sum the counts along every row, then turn the counts of every batch in every cluster into where
+    // each batch starts writing in each cluster: cluster by cluster, and batch by batch inside a cluster.
+    const u32 batches = (lightCount + LIGHTCLUSTERS_BATCH - 1) / LIGHTCLUSTERS_BATCH;
+    for (u32 batch = 0; batch < batches; batch++)
+    {
+        u32* counts = clusters->m_FillCounts + (static_cast<size_t>(batch) * LIGHTCLUSTERS_COUNT);
+        for (u32 row = 0; row < LIGHTCLUSTERS_COUNT; row += LIGHTCLUSTERS_TILES_X)
+        {
+            for (u32 x = 1; x < LIGHTCLUSTERS_TILES_X; x++)
+            {
+                counts[row + x] += counts[row + x - 1];
+            }
+        }
+    }
+
+    u32 indexCount = 0;
+    u32 maxClusterLights = 0;
+    for (u32 cluster = 0; cluster < LIGHTCLUSTERS_COUNT; cluster++)
+    {
+        const u32 start = indexCount;
+        for (u32 batch = 0; batch < batches; batch++)
+        {
+            u32* slot = &clusters->m_FillCounts[(static_cast<size_t>(batch) * LIGHTCLUSTERS_COUNT) + cluster];
+            const u32 batchEntries = *slot;
+            *slot = indexCount;
+            indexCount += batchEntries;
+        }
+        clusters->m_Ranges[cluster] = { .m_Offset = start, .m_Count = indexCount - start };
+        maxClusterLights = indexCount - start > maxClusterLights ? indexCount - start : maxClusterLights;
+    }
+
+    if (!LightClustersReserveIndices(clusters, indexCount))
+    {
+        std::memset(clusters->m_Ranges, 0, sizeof(clusters->m_Ranges));
+        clusters->m_Lights = nullptr;
+        return false;
+    }
+
+    JobsWait(JobsDispatch(lightCount, LIGHTCLUSTERS_BATCH, LightClustersFillRange, clusters));
+    clusters->m_Lights = nullptr;
+
+    u32 visible = 0;
+    for (u32 i = 0; i < lightCount; i++)
+    {
+        visible += clusters->m_Slices[i] != LIGHTCLUSTERS_CULLED ? 1 : 0;
+    }
+    clusters->m_Stats.m_Visible = visible;
+    clusters->m_Stats.m_Indices = indexCount;
+    clusters->m_Stats.m_MaxClusterLights = maxClusterLights;
+    return true;
+}
+
+const LightClustersRange* LightClustersGetRanges(const LightClusters* clusters)
+{
+    return clusters->m_Ranges;
+}
+
+const u16* LightClustersGetIndices(const LightClusters* clusters, u32* count)
+{
+    *count = clusters->m_Stats.m_Indices;
+    return clusters->m_Indices;
+}
+
+const LightClustersStats* LightClustersGetStats(const LightClusters* clusters)
+{
+    return &clusters->m_Stats;
+}
+
+void LightClustersEnableSimd(const bool enabled)
+{
+    g_LightClustersSimdRequested = enabled;
+}
+
+bool LightClustersSimdEnabled()
+{
+    return g_LightClustersSimdRequested && CpuHasAvx2();
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include "types.h"
+
+/*
+* NOTE(sbalse): Clustered light assignment. The view frustum is cut into LIGHTCLUSTERS_TILES_X by
+* LIGHTCLUSTERS_TILES_Y tiles on screen and LIGHTCLUSTERS_SLICES slices in depth, spaced exponentially so that
+* clusters are about as deep as they are wide. Every light goes into the list of every cluster it can reach, so
+* shading a pixel only has to look at the lights of its cluster.
+*
+* A light is bound by a sphere, the cone of a spot light by the smallest sphere around it. The screen rectangle
+* the sphere covers comes from the planes through the eye that touch it, its depth range from its front and back.
+* The light goes into every cluster in that box, so clusters in the corners of the box can get lights that just
+* miss them. Shading tests the range of every light anyway.
+*
+* The bounds of eight lights are worked out at a time with AVX2 where the CPU has it, and lights are cut into
+* batches for the job workers. Like the broadphase every batch counts its entries per cluster, the counts are
+* turned into where every batch writes, and the batches fill the lists. Lists come out in light order whatever
+* the number of workers. The scalar and the AVX2 path give the same results bit for bit.
+*/
+
+constexpr u32 LIGHTCLUSTERS_TILES_X = 16;
+constexpr u32 LIGHTCLUSTERS_TILES_Y = 9;
+constexpr u32 LIGHTCLUSTERS_SLICES = 24;
+constexpr u32 LIGHTCLUSTERS_COUNT = LIGHTCLUSTERS_TILES_X * LIGHTCLUSTERS_TILES_Y * LIGHTCLUSTERS_SLICES;
+// NOTE(sbalse): Light indices are stored in 16 bits.
+constexpr u32 LIGHTCLUSTERS_MAX_LIGHTS = 65536;
+// NOTE(sbalse): Lights per batch for the job workers, a multiple of eight.
+constexpr u32 LIGHTCLUSTERS_BATCH = 1024;
+
+// NOTE(sbalse): The parameters of XMMatrixPerspectiveLH(), width and height of the view at the near plane.
+struct LightClustersFrustum
+{
+    float m_Width;
+    float m_Height;
+    float m_Near;
+    float m_Far;
+};
+
+// NOTE(sbalse): Lights as structure of arrays, in view space: x right, y up, z forward.
+struct LightClustersLights
+{
+    const float* m_Position[3];
+    const float* m_Range;
+    // NOTE(sbalse): Spot lights only. Directions are unit length, the cosine is that of half the cone angle. Lights
+    // with a cosine of 0 or less are bound like point lights, which all lights are when m_SpotCosine is null.
+    const float* m_Direction[3];
+    const float* m_SpotCosine;
+};
+
+// NOTE(sbalse): Where the lights of a cluster start in the index list and how many there are. Clusters are
+// ordered by slice, then row, then column.
+struct LightClustersRange
+{
+    u32 m_Offset;
+    u32 m_Count;
+};
+
+struct LightClustersStats
+{
+    u32 m_Lights;
+    u32 m_Visible; // NOTE(sbalse): Lights that reached at least one cluster.
+    u32 m_Indices;
+    u32 m_MaxClusterLights;
+};
+
+struct LightClusters;
+
+LightClusters* LightClustersCreate(const u32 capacity);
+void LightClustersDestroy(LightClusters* clusters);
+// NOTE(sbalse): Assigns lights [0, count) to the clusters of frustum, count is capped at the capacity. Returns
+// false when the index list couldn't grow, the clusters are empty then.
+bool LightClustersUpdate(
+    LightClusters* clusters,
+    const LightClustersFrustum* frustum,
+    const LightClustersLights* lights,
+    const u32 count);
+// NOTE(sbalse): LIGHTCLUSTERS_COUNT ranges into the index list, both valid until the next update.
+const LightClustersRange* LightClustersGetRanges(const LightClusters* clusters);
+const u16* LightClustersGetIndices(const LightClusters* clusters, u32* count);
+const LightClustersStats* LightClustersGetStats(const LightClusters* clusters);
+
+// NOTE(sbalse): The scalar and the AVX2 path give the same results bit for bit, this only exists to compare them.
+void LightClustersEnableSimd(const bool enabled);
+bool LightClustersSimdEnabled();
@@ -0,0 +1,234 @@
+#include "lz4.h"
+
+#include <bit>
+#include <cstring>
+
+namespace
+{
+    // NOTE(sbalse): Limits of the block format. The last match starts at least LZ4_MATCH_LIMIT bytes before the
+    // end of the block and the last LZ4_LAST_LITERALS bytes are always literals.
+    constexpr u32 LZ4_MIN_MATCH = 4;
+    constexpr u32 LZ4_MATCH_LIMIT = 12;
+    constexpr u32 LZ4_LAST_LITERALS = 5;
+    constexpr u32 LZ4_MAX_OFFSET = 65535;
+    constexpr u32 LZ4_HASH_BITS = 12;
+    constexpr u32 LZ4_NO_POSITION = ~0u;
+
+    u32 Lz4Read32(const u8* bytes)
+    {
+        u32 value = 0;
+        std::memcpy(&value, bytes, sizeof(value));
+        return value;
+    }
+
+    u64 Lz4Read64(const u8* bytes)
+    {
+        u64 value = 0;
+        std::memcpy(&value, bytes, sizeof(value));
+        return value;
+    }
+
+    u32 Lz4Hash(const u32 sequence)
+    {
+        return (sequence * 2654435761u) >> (32 - LZ4_HASH_BITS);
+    }
+
+    u8* Lz4WriteLength(u8* target, u32 length)
+    {
+        for (; length >= 255; length -= 255)
+        {
+            *target++ = 255;
+        }
+        *target++ = static_cast<u8>(length);
+        return target;
+    }
+
+    // NOTE(sbalse): A match length of 0 writes the last sequence, which only has literals.
+    u8* Lz4WriteSequence(
+        u8* target,
+        const u8* literals,
+        const u32 literalCount,
+        const u32 offset,
+        const u32 matchLength)
+    {
+        u8* token = target++;
+        const u32 literalCode = literalCount < 15 ? literalCount : 15;
+        if (literalCount >= 15)
+        {
+            target = Lz4WriteLength(target, literalCount - 15);
+        }
+        std::memcpy(target, literals, literalCount);
+        target += literalCount;
+
+        if (matchLength == 0)
+        {
+            *token = static_cast<u8>(literalCode << 4);
+            return target;
+        }
+
+        target[0] = static_cast<u8>(offset);
+        target[1] = static_cast<u8>(offset >> 8);
+        target += 2;
+
+        const u32 matchCode = matchLength - LZ4_MIN_MATCH;
+        *token = static_cast<u8>((literalCode << 4) | (matchCode < 15 ? matchCode : 15));
+        if (matchCode >= 15)
+        {
+            target = Lz4WriteLength(target, matchCode - 15);
+        }
+        return target;
+    }
+
+    // NOTE(sbalse): Reads the extra bytes of a literal or match length. Returns false when the block ends first.
+    bool Lz4ReadLength(const u8** source, const u8* end, u32* length)
+    {
+        u8 byte = 255;
+        while (byte == 255)
+        {
+            if (*source >= end)
+            {
+                return false;
+            }
+            byte = *(*source)++;
+            *length += byte;
+        }
+        return true;
+    }
+} // namespace
+
+u32 Lz4CompressBound(const u32 size)
+{
+    return size + (size / 255) + 16;
+}
+
+// NOTE(sbalse): Greedy, every position is looked up in a hash table of the last position its first four bytes were
+// seen at. Runs of misses skip ahead faster, so data that doesn't compress goes through quickly.
+u32 Lz4Compress(const u8* source, const u32 size, u8* target)
+{
+    u8* output = target;
+    u32 anchor = 0;
+    if (size > LZ4_MATCH_LIMIT)
+    {
+        u32 table[1u << LZ4_HASH_BITS];
+        std::memset(table, 0xFF, sizeof(table));
+
+        const u32 matchStartLimit = size - LZ4_MATCH_LIMIT;
+        const u32 matchEndLimit = size - LZ4_LAST_LITERALS;
+        u32 position = 0;
+        u32 misses = 0;
+        while (position < matchStartLimit)
+        {
+            const u32 sequence = Lz4Read32(source + position);
+            const u32 hash = Lz4Hash(sequence);
+            const u32 candidate = table[hash];
+            table[hash] = position;
+            if (candidate == LZ4_NO_POSITION
+                || position - candidate > LZ4_MAX_OFFSET
+                || Lz4Read32(source + candidate) != sequence)
+            {
+                misses++;
+                position += 1 + (misses >> 6);
+                continue;
+            }
+
+            // NOTE(sbalse): Grow the match backwards into the pending literals, then forwards eight bytes at a time.
+            const u32 offset = position - candidate;
+            u32 start = position;
+            while (start > anchor && start > offset && source[start - 1] == source[start - 1 - offset])
+            {
+                start--;
+            }
+            u32 end = position + LZ4_MIN_MATCH;
+            while (end + 8 <= matchEndLimit)
+            {
+                const u64 difference = Lz4Read64(source + end) ^ Lz4Read64(source + end - offset);
+                if (difference)
+                {
+                    end += static_cast<u32>(std::countr_zero(difference)) / 8;
+                    break;
+                }
+                end += 8;
+            }
+            if (end + 8 > matchEndLimit)
+            {
+                while (end < matchEndLimit && source[end] == source[end - offset])
+                {
+                    end++;
+                }
+            }
+
+            output = Lz4WriteSequence(output, source + anchor, start - anchor, offset, end - start);
+            position = end;
+            anchor = end;
+            misses = 0;
+            if (position < matchStartLimit)
+            {
+                table[Lz4Hash(Lz4Read32(source + position - 2))] = position - 2;
+            }
+        }
+    }
+
+    output = Lz4WriteSequence(output, source + anchor, size - anchor, 0, 0);
+    return static_cast<u32>(output - target);
+}
+
+bool Lz4Decompress(const u8* source, const u32 compressedSize, u8* target, const u32 size)
+{
+    const u8* end = source + compressedSize;
+    u32 written = 0;
+    while (source < end)
+    {
+        const u32 token = *source++;
+        u32 literalCount = token >> 4;
+        if (literalCount == 15 && !Lz4ReadLength(&source, end, &literalCount))
+        {
+            return false;
+        }
+        if (literalCount > static_cast<u32>(end - source) || literalCount > size - written)
+        {
+            return false;
+        }
+        std::memcpy(target + written, source, literalCount);
+        source += literalCount;
+        written += literalCount;
+
+        // NOTE(sbalse): The last sequence ends after its literals.
+        if (source == end)
+        {
+            break;
+        }
+
+        if (end - source < 2)
+        {
+            return false;
+        }
+        const u32 offset = source[0] | (static_cast<u32>(source[1]) << 8);
+        source += 2;
+        u32 matchLength = (token & 15) + LZ4_MIN_MATCH;
+        if ((token & 15) == 15 && !Lz4ReadLength(&source, end, &matchLength))
+        {
+            return false;
+        }
+        if (offset == 0 || offset > written || matchLength > size - written)
+        {
+            return false;
+        }
+
+        // NOTE(sbalse): Matches may overlap what they write, a short offset repeats the bytes before it.
+        u8* match = target + written;
+        const u8* from = match - offset;
+        if (offset >= matchLength)
+        {
+            std::memcpy(match, from, matchLength);
+        }
+        else
+        {
+            for (u32 i = 0; i < matchLength; i++)
+            {
+                match[i] = from[i];
+            }
+        }
+        written += matchLength;
+    }
+    return written == size;
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include "types.h"
+
+/*
+* NOTE(sbalse): LZ4 block compression, the block format only without the frame format around it. Blocks decode
+* with any LZ4 block decoder. The compressor is greedy with a single hash table, fast rather than thorough, runs
+* of zeros and repeated rows go through at memory speed.
+*/
+
+// NOTE(sbalse): Worst case compressed size of size bytes.
+u32 Lz4CompressBound(const u32 size);
+// NOTE(sbalse): target holds Lz4CompressBound(size) bytes. Returns the compressed size.
+u32 Lz4Compress(const u8* source, const u32 size, u8* target);
+// NOTE(sbalse): Returns false unless the block decompresses to exactly size bytes. Damaged blocks never read or
+// write out of bounds.
+bool Lz4Decompress(const u8* source, const u32 compressedSize, u8* target, const u32 size);
@@ -10,7 +10,10 @@ int APIENTRY WinMain(
     _In_ LPSTR /*lpCmdLine*/,
     _In_ int /*nCmdShow*/)
 {
-    ControlInit();
+    if (!ControlInit())
+    {
+        return EXIT_FAILURE;
+    }
 
     // NOTE(sbalse): Main engine loop.
     while (ControlRun())
@@ -1,20 +1,18 @@
 #include "mathutils.h"
 
-float PingPong(const float value, const float min, const float max, const float speed)
-{
-    static int direction = 1; // NOTE(sbalse): 1 = right, -1 = left
-    float result = value + (speed * direction);
+#include <cmath>
 
-    if (result >= max)
-    {
-        result = max;
-        direction = -1;
-    }
-    else if (result <= min)
+float PingPong(const float time, const float min, const float max, const float speed)
+{
+    const float range = max - min;
+    if (range <= 0.0f)
     {
-        result = min;
-        direction = 1;
+        return min;
     }
 
-    return result;
+    // NOTE(sbalse): Distance travelled, folded into one full cycle of going right and then left.
+    const float travelled = std::fmod(std::fabs(time * speed), 2.0f * range);
+    const float result = travelled <= range ? travelled : (2.0f * range) - travelled;
+
+    return min + result;
 }
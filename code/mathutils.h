@@ -1,3 +1,5 @@
 #pragma once
 
-float PingPong(const float value, const float min, const float max, const float speed);
+// NOTE(sbalse): Oscillates between min and max, moving at speed units per second. A pure function of time, so
+// any number of values can oscillate independently and the result does not depend on the frame rate.
+float PingPong(const float time, const float min, const float max, const float speed);
@@ -0,0 +1,386 @@
+#include "particles.h"
+
+#include <array>
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#include <immintrin.h>
+
+#include "cpufeatures.h"
+#include "jobs.h"
+#include "random.h"
+
+struct ParticleEmitter
+{
+    ParticleEmitterDesc m_Desc;
+    ParticlePool m_Pool;
+    float* m_Storage;
+    u32* m_BatchSurvivors; // NOTE(sbalse): Survivors of every job batch of the last update.
+    float m_SpawnCarry; // NOTE(sbalse): Fraction of a particle that was due but not spawned yet.
+    u64 m_Spawned; // NOTE(sbalse): Index of the next particle, picks its random numbers.
+};
+
+namespace
+{
+    constexpr u32 PARTICLES_STREAM_COUNT = 8;
+
+    // NOTE(sbalse): For every mask of live lanes, the lanes to gather so the live ones end up at the front.
+    struct alignas(32) ParticlesPackIndices
+    {
+        u32 m_Lanes[8];
+    };
+
+    constexpr std::array<ParticlesPackIndices, 256> ParticlesBuildPackTable()
+    {
+        std::array<ParticlesPackIndices, 256> table = {};
+        for (u32 mask = 0; mask < 256; mask++)
+        {
+            u32 count = 0;
+            for (u32 lane = 0; lane < 8; lane++)
+            {
+                if (mask & (1u << lane))
+                {
+                    table[mask].m_Lanes[count++] = lane;
+                }
+            }
+        }
+        return table;
+    }
+
+    constexpr std::array<ParticlesPackIndices, 256> g_ParticlesPackTable = ParticlesBuildPackTable();
+
+    constinit bool g_ParticlesSimdRequested = true;
+
+    void ParticlesStreams(const ParticlePool* pool, float* (&streams)[PARTICLES_STREAM_COUNT])
+    {
+        streams[0] = pool->m_PositionX;
+        streams[1] = pool->m_PositionY;
+        streams[2] = pool->m_PositionZ;
+        streams[3] = pool->m_VelocityX;
+        streams[4] = pool->m_VelocityY;
+        streams[5] = pool->m_VelocityZ;
+        streams[6] = pool->m_Age;
+        streams[7] = pool->m_Lifetime;
+    }
+
+    // NOTE(sbalse): Integrates one particle and writes it to index write, which is never past index i. The
+    // write always happens, whether the particle survived decides if the cursor moves past it.
+    u32 ParticlesIntegrateScalar(
+        ParticlePool* pool,
+        const u32 i,
+        u32 write,
+        const float gravity[3],
+        const float damping,
+        const float stepSeconds)
+    {
+        const float velocityX = (pool->m_VelocityX[i] + gravity[0] * stepSeconds) * damping;
+        const float velocityY = (pool->m_VelocityY[i] + gravity[1] * stepSeconds) * damping;
+        const float velocityZ = (pool->m_VelocityZ[i] + gravity[2] * stepSeconds) * damping;
+        const float positionX = pool->m_PositionX[i] + velocityX * stepSeconds;
+        const float positionY = pool->m_PositionY[i] + velocityY * stepSeconds;
+        const float positionZ = pool->m_PositionZ[i] + velocityZ * stepSeconds;
+        const float age = pool->m_Age[i] + stepSeconds;
+        const float lifetime = pool->m_Lifetime[i];
+
+        pool->m_PositionX[write] = positionX;
+        pool->m_PositionY[write] = positionY;
+        pool->m_PositionZ[write] = positionZ;
+        pool->m_VelocityX[write] = velocityX;
+        pool->m_VelocityY[write] = velocityY;
+        pool->m_VelocityZ[write] = velocityZ;
+        pool->m_Age[write] = age;
+        pool->m_Lifetime[write] = lifetime;
+        return write + (age < lifetime ? 1 : 0);
+    }
+
+    // NOTE(sbalse): Eight particles per iteration. The live lanes are packed to the front with one permute per
+    // stream and all eight lanes are stored, the cursor only moves past the live ones. The store never runs
+    // ahead of what was already loaded, so this works in place.
+    CPU_AVX2 u32 ParticlesIntegrateAvx2(
+        ParticlePool* pool,
+        u32 i,
+        const u32 end,
+        u32 write,
+        const float gravity[3],
+        const float damping,
+        const float stepSeconds)
+    {
+        const __m256 step = _mm256_set1_ps(stepSeconds);
+        const __m256 damp = _mm256_set1_ps(damping);
+        const __m256 gravityX = _mm256_set1_ps(gravity[0] * stepSeconds);
+        const __m256 gravityY = _mm256_set1_ps(gravity[1] * stepSeconds);
+        const __m256 gravityZ = _mm256_set1_ps(gravity[2] * stepSeconds);
+
+        for (; i + 8 <= end; i += 8)
+        {
+            __m256 values[PARTICLES_STREAM_COUNT];
+            values[3] = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(pool->m_VelocityX + i), gravityX), damp);
+            values[4] = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(pool->m_VelocityY + i), gravityY), damp);
+            values[5] = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(pool->m_VelocityZ + i), gravityZ), damp);
+            values[0] = _mm256_add_ps(_mm256_loadu_ps(pool->m_PositionX + i), _mm256_mul_ps(values[3], step));
+            values[1] = _mm256_add_ps(_mm256_loadu_ps(pool->m_PositionY + i), _mm256_mul_ps(values[4], step));
+            values[2] = _mm256_add_ps(_mm256_loadu_ps(pool->m_PositionZ + i), _mm256_mul_ps(values[5], step));
+            values[6] = _mm256_add_ps(_mm256_loadu_ps(pool->m_Age + i), step);
+            values[7] = _mm256_loadu_ps(pool->m_Lifetime + i);
+
+            const u32 mask = static_cast<u32>(_mm256_movemask_ps(_mm256_cmp_ps(values[6], values[7], _CMP_LT_OQ)));
+            const __m256i pack = _mm256_load_si256(
+                reinterpret_cast<const __m256i*>(g_ParticlesPackTable[mask].m_Lanes));
+
+            _mm256_storeu_ps(pool->m_PositionX + write, _mm256_permutevar8x32_ps(values[0], pack));
+            _mm256_storeu_ps(pool->m_PositionY + write, _mm256_permutevar8x32_ps(values[1], pack));
+            _mm256_storeu_ps(pool->m_PositionZ + write, _mm256_permutevar8x32_ps(values[2], pack));
+            _mm256_storeu_ps(pool->m_VelocityX + write, _mm256_permutevar8x32_ps(values[3], pack));
+            _mm256_storeu_ps(pool->m_VelocityY + write, _mm256_permutevar8x32_ps(values[4], pack));
+            _mm256_storeu_ps(pool->m_VelocityZ + write, _mm256_permutevar8x32_ps(values[5], pack));
+            _mm256_storeu_ps(pool->m_Age + write, _mm256_permutevar8x32_ps(values[6], pack));
+            _mm256_storeu_ps(pool->m_Lifetime + write, _mm256_permutevar8x32_ps(values[7], pack));
+            write += static_cast<u32>(std::popcount(mask));
+        }
+
+        for (; i < end; i++)
+        {
+            write = ParticlesIntegrateScalar(pool, i, write, gravity, damping, stepSeconds);
+        }
+        return write;
+    }
+
+    struct ParticlesIntegrateJob
+    {
+        ParticleEmitter* m_Emitter;
+        const ParticleForces* m_Forces;
+        float m_StepSeconds;
+    };
+
+    struct ParticlesWriteJob
+    {
+        const ParticlePool* m_Pool;
+        u32 m_Color;
+        ParticleInstance* m_Instances;
+    };
+
+    void ParticlesIntegrateRange(void* context, const u32 begin, const u32 end)
+    {
+        const ParticlesIntegrateJob* job = static_cast<const ParticlesIntegrateJob*>(context);
+        ParticleEmitter* emitter = job->m_Emitter;
+        emitter->m_BatchSurvivors[begin / PARTICLES_JOB_BATCH] =
+            ParticlesIntegrate(&emitter->m_Pool, begin, end, job->m_Forces, job->m_StepSeconds);
+    }
+
+    void ParticlesWriteRange(void* context, const u32 begin, const u32 end)
+    {
+        const ParticlesWriteJob* job = static_cast<const ParticlesWriteJob*>(context);
+        const ParticlePool* pool = job->m_Pool;
+        const u32 color = job->m_Color;
+
+        for (u32 i = begin; i < end; i++)
+        {
+            // NOTE(sbalse): Fade all four channels with the remaining life, in 8.8 fixed point.
+            const float remaining = 1.0f - pool->m_Age[i] / pool->m_Lifetime[i];
+            const u32 fade = static_cast<u32>((remaining > 0.0f ? remaining : 0.0f) * 256.0f);
+            const u32 faded =
+                ((((color & 0x00FF00FF) * fade) >> 8) & 0x00FF00FF) |
+                ((((color >> 8) & 0x00FF00FF) * fade) & 0xFF00FF00);
+
+            job->m_Instances[i] =
+            {
+                .m_Position = { pool->m_PositionX[i], pool->m_PositionY[i], pool->m_PositionZ[i] },
+                .m_Color = { faded },
+            };
+        }
+    }
+
+    void ParticlesSpawn(ParticleEmitter* emitter, const float stepSeconds)
+    {
+        const ParticleEmitterDesc* desc = &emitter->m_Desc;
+        ParticlePool* pool = &emitter->m_Pool;
+
+        emitter->m_SpawnCarry += desc->m_Rate * stepSeconds;
+        const u32 due = static_cast<u32>(emitter->m_SpawnCarry);
+        emitter->m_SpawnCarry -= static_cast<float>(due);
+
+        // NOTE(sbalse): What doesn't fit is dropped rather than delayed, so a full pool doesn't build up a
+        // burst. The index still moves on, so what does spawn doesn't depend on the capacity.
+        const u32 space = pool->m_Capacity - pool->m_Count;
+        const u32 count = due < space ? due : space;
+        const u64 first = emitter->m_Spawned;
+        emitter->m_Spawned += due;
+        if (count == 0)
+        {
+            return;
+        }
+
+        const RandomInterval intervals[4] =
+        {
+            { desc->m_Velocity[0] - desc->m_VelocitySpread[0], desc->m_Velocity[0] + desc->m_VelocitySpread[0] },
+            { desc->m_Velocity[1] - desc->m_VelocitySpread[1], desc->m_Velocity[1] + desc->m_VelocitySpread[1] },
+            { desc->m_Velocity[2] - desc->m_VelocitySpread[2], desc->m_Velocity[2] + desc->m_VelocitySpread[2] },
+            { desc->m_LifetimeMin, desc->m_LifetimeMax },
+        };
+        const u32 start = pool->m_Count;
+        float* const outputs[4] =
+        {
+            pool->m_VelocityX + start,
+            pool->m_VelocityY + start,
+            pool->m_VelocityZ + start,
+            pool->m_Lifetime + start,
+        };
+        RandomFillFloats(desc->m_Seed, first, count, intervals, outputs);
+
+        for (u32 i = start; i < start + count; i++)
+        {
+            pool->m_PositionX[i] = desc->m_Position[0];
+            pool->m_PositionY[i] = desc->m_Position[1];
+            pool->m_PositionZ[i] = desc->m_Position[2];
+            pool->m_Age[i] = 0.0f;
+        }
+        pool->m_Count += count;
+    }
+}
+
+ParticleEmitter* ParticleEmitterCreate(const ParticleEmitterDesc* desc, const u32 capacity)
+{
+    ParticleEmitter* emitter = static_cast<ParticleEmitter*>(std::calloc(1, sizeof(ParticleEmitter)));
+    const u32 batchCount = (capacity + PARTICLES_JOB_BATCH - 1) / PARTICLES_JOB_BATCH;
+    emitter->m_Storage = static_cast<float*>(
+        std::calloc(static_cast<size_t>(capacity) * PARTICLES_STREAM_COUNT, sizeof(float)));
+    emitter->m_BatchSurvivors = static_cast<u32*>(std::calloc(batchCount > 0 ? batchCount : 1, sizeof(u32)));
+    if (!emitter->m_Storage || !emitter->m_BatchSurvivors)
+    {
+        ParticleEmitterDestroy(emitter);
+        return nullptr;
+    }
+
+    emitter->m_Desc = *desc;
+
+    float* streams[PARTICLES_STREAM_COUNT] = {};
+    for (u32 i = 0; i < PARTICLES_STREAM_COUNT; i++)
+    {
+        streams[i] = emitter->m_Storage + (static_cast<size_t>(i) * capacity);
+    }
+    emitter->m_Pool =
+    {
+        .m_Count = 0,
+        .m_Capacity = capacity,
+        .m_PositionX = streams[0],
+        .m_PositionY = streams[1],
+        .m_PositionZ = streams[2],
+        .m_VelocityX = streams[3],
+        .m_VelocityY = streams[4],
+        .m_VelocityZ = streams[5],
+        .m_Age = streams[6],
+        .m_Lifetime = streams[7],
+    };
+    return emitter;
+}
+
+void ParticleEmitterDestroy(ParticleEmitter* emitter)
+{
+    if (!emitter)
+    {
+        return;
+    }
+    std::free(emitter->m_BatchSurvivors);
+    std::free(emitter->m_Storage);
+    std::free(emitter);
+}
+
+const ParticlePool* ParticleEmitterGetPool(const ParticleEmitter* emitter)
+{
+    return &emitter->m_Pool;
+}
+
+void ParticleEmitterUpdate(ParticleEmitter* emitter, const ParticleForces* forces, const float stepSeconds)
+{
+    ParticlesSpawn(emitter, stepSeconds);
+
+    ParticlePool* pool = &emitter->m_Pool;
+    const u32 count = pool->m_Count;
+    if (count <= PARTICLES_JOB_BATCH)
+    {
+        pool->m_Count = ParticlesIntegrate(pool, 0, count, forces, stepSeconds);
+        return;
+    }
+
+    ParticlesIntegrateJob job =
+    {
+        .m_Emitter = emitter,
+        .m_Forces = forces,
+        .m_StepSeconds = stepSeconds,
+    };
+    JobsWait(JobsDispatch(count, PARTICLES_JOB_BATCH, ParticlesIntegrateRange, &job));
+
+    // NOTE(sbalse): Every batch packed its survivors to its own front, close the gaps between the batches.
+    float* streams[PARTICLES_STREAM_COUNT] = {};
+    ParticlesStreams(pool, streams);
+
+    u32 live = 0;
+    for (u32 begin = 0; begin < count; begin += PARTICLES_JOB_BATCH)
+    {
+        const u32 survivors = emitter->m_BatchSurvivors[begin / PARTICLES_JOB_BATCH];
+        if (live != begin)
+        {
+            for (u32 i = 0; i < PARTICLES_STREAM_COUNT; i++)
+            {
+                std::memmove(streams[i] + live, streams[i] + begin, survivors * sizeof(float));
+            }
+        }
+        live += survivors;
+    }
+    pool->m_Count = live;
+}
+
+u32 ParticleEmitterWriteInstances(const ParticleEmitter* emitter, ParticleInstance* instances, const u32 maxInstances)
+{
+    const u32 count = emitter->m_Pool.m_Count < maxInstances ? emitter->m_Pool.m_Count : maxInstances;
+    ParticlesWriteJob job =
+    {
+        .m_Pool = &emitter->m_Pool,
+        .m_Color = emitter->m_Desc.m_Color.m_RGBA,
+        .m_Instances = instances,
+    };
+
+    if (count <= PARTICLES_JOB_BATCH)
+    {
+        ParticlesWriteRange(&job, 0, count);
+    }
+    else
+    {
+        JobsWait(JobsDispatch(count, PARTICLES_JOB_BATCH, ParticlesWriteRange, &job));
+    }
+    return count;
+}
+
+u32 ParticlesIntegrate(
+    ParticlePool* pool,
+    const u32 begin,
+    const u32 end,
+    const ParticleForces* forces,
+    const float stepSeconds)
+{
+    // NOTE(sbalse): Linear drag, never turning the velocity around on a long step.
+    const float loss = forces->m_Drag * stepSeconds;
+    const float damping = loss < 1.0f ? 1.0f - loss : 0.0f;
+
+    if (ParticlesSimdEnabled())
+    {
+        return ParticlesIntegrateAvx2(pool, begin, end, begin, forces->m_Gravity, damping, stepSeconds) - begin;
+    }
+
+    u32 write = begin;
+    for (u32 i = begin; i < end; i++)
+    {
+        write = ParticlesIntegrateScalar(pool, i, write, forces->m_Gravity, damping, stepSeconds);
+    }
+    return write - begin;
+}
+
+void ParticlesEnableSimd(const bool enabled)
+{
+    g_ParticlesSimdRequested = enabled;
+}
+
+bool ParticlesSimdEnabled()
+{
+    return g_ParticlesSimdRequested && CpuHasAvx2();
+}
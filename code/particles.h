@@ -0,0 +1,77 @@
+#pragma once
+#include "types.h"
+#include "graphics/quantize.h"
+
+/*
+* NOTE(sbalse): Particle effects. Every emitter owns a pool of particles stored as structure of arrays, so
+* eight particles are integrated at once with AVX2 where the CPU has it. Dead particles are packed out of the
+* pool in the same pass without branching on each particle. Large pools are cut into batches that run on the
+* job workers. Spawning takes its random numbers from the emitter's seed and a running particle index, so an
+* emitter plays out the same way whatever the number of workers or the instruction set.
+*/
+
+// NOTE(sbalse): Pools are cut into batches of this many particles for the job workers.
+constexpr u32 PARTICLES_JOB_BATCH = 16384;
+
+struct ParticleEmitterDesc
+{
+    float m_Position[3];
+    float m_Velocity[3];
+    float m_VelocitySpread[3]; // NOTE(sbalse): Each velocity component is jittered by up to this much.
+    float m_LifetimeMin; // NOTE(sbalse): Seconds.
+    float m_LifetimeMax;
+    float m_Rate; // NOTE(sbalse): Particles spawned per second.
+    Unorm8x4 m_Color; // NOTE(sbalse): Faded out over the lifetime of the particle.
+    u64 m_Seed;
+};
+
+// NOTE(sbalse): Forces applied to every particle of an emitter.
+struct ParticleForces
+{
+    float m_Gravity[3];
+    float m_Drag; // NOTE(sbalse): Fraction of velocity lost per second.
+};
+
+// NOTE(sbalse): Structure of arrays of the live particles, [0, m_Count) are alive.
+struct ParticlePool
+{
+    u32 m_Count;
+    u32 m_Capacity;
+    float* m_PositionX;
+    float* m_PositionY;
+    float* m_PositionZ;
+    float* m_VelocityX;
+    float* m_VelocityY;
+    float* m_VelocityZ;
+    float* m_Age;
+    float* m_Lifetime;
+};
+
+// NOTE(sbalse): What the renderer draws for each particle, one instance per particle.
+struct ParticleInstance
+{
+    Float3 m_Position;
+    Unorm8x4 m_Color;
+};
+
+struct ParticleEmitter;
+
+ParticleEmitter* ParticleEmitterCreate(const ParticleEmitterDesc* desc, const u32 capacity);
+void ParticleEmitterDestroy(ParticleEmitter* emitter);
+const ParticlePool* ParticleEmitterGetPool(const ParticleEmitter* emitter);
+// NOTE(sbalse): Spawns the particles due in stepSeconds, then integrates and removes the dead ones.
+void ParticleEmitterUpdate(ParticleEmitter* emitter, const ParticleForces* forces, const float stepSeconds);
+// NOTE(sbalse): Writes up to maxInstances instances of the live particles, returns how many were written.
+u32 ParticleEmitterWriteInstances(const ParticleEmitter* emitter, ParticleInstance* instances, const u32 maxInstances);
+
+// NOTE(sbalse): Integrates [begin, end) of a pool and packs the survivors to the front of that range. Returns the
+// number of survivors. Uses AVX2 when enabled and supported.
+u32 ParticlesIntegrate(
+    ParticlePool* pool,
+    const u32 begin,
+    const u32 end,
+    const ParticleForces* forces,
+    const float stepSeconds);
+// NOTE(sbalse): The scalar and the AVX2 path give the same results bit for bit, this only exists to compare them.
+void ParticlesEnableSimd(const bool enabled);
+bool ParticlesSimdEnabled();
@@ -0,0 +1,106 @@
+#include "random.h"
+
+#include <emmintrin.h>
+
+namespace
+{
+    // NOTE(sbalse): 32x32 -> 64-bit multiply of all four lanes, split into the high and low halves.
+    void RandomMulHiLo(const __m128i a, const __m128i b, __m128i* hi, __m128i* lo)
+    {
+        const __m128i lowMask = _mm_set_epi32(0, -1, 0, -1);
+        const __m128i even = _mm_mul_epu32(a, b);
+        const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+        *lo = _mm_or_si128(_mm_and_si128(even, lowMask), _mm_slli_epi64(odd, 32));
+        *hi = _mm_or_si128(_mm_srli_epi64(even, 32), _mm_andnot_si128(lowMask, odd));
+    }
+
+    __m128 RandomFloat4(const __m128i bits, const RandomInterval interval)
+    {
+        const __m128 unit = _mm_mul_ps(
+            _mm_cvtepi32_ps(_mm_srli_epi32(bits, 8)),
+            _mm_set1_ps(1.0f / 16777216.0f));
+        const __m128 range = _mm_set1_ps(interval.m_Max - interval.m_Min);
+        return _mm_add_ps(_mm_set1_ps(interval.m_Min), _mm_mul_ps(range, unit));
+    }
+}
+
+void RandomFillFloats(
+    const u64 seed,
+    const u64 first,
+    const u32 count,
+    const RandomInterval intervals[4],
+    float* const outputs[4])
+{
+    // NOTE(sbalse): Two independent groups of four indices per iteration, so the multiplies of one group hide
+    // the latency of the other.
+    constexpr u32 groups = 2;
+    constexpr u32 width = groups * 4;
+
+    const __m128i m0 = _mm_set1_epi32(static_cast<int>(RANDOM_PHILOX_M0));
+    const __m128i m1 = _mm_set1_epi32(static_cast<int>(RANDOM_PHILOX_M1));
+    const __m128i lane = _mm_set_epi32(3, 2, 1, 0);
+
+    u32 i = 0;
+    for (; i + width <= count; i += width)
+    {
+        __m128i c0[groups];
+        __m128i c1[groups];
+        __m128i c2[groups];
+        __m128i c3[groups];
+        for (u32 group = 0; group < groups; group++)
+        {
+            // NOTE(sbalse): Four consecutive indices, one per lane. The high word is the same for all four
+            // unless the low word wraps inside the group.
+            const u64 index = first + i + (group * 4);
+            c0[group] = _mm_add_epi32(_mm_set1_epi32(static_cast<int>(static_cast<u32>(index))), lane);
+            c1[group] = _mm_set_epi32(
+                static_cast<int>((index + 3) >> 32),
+                static_cast<int>((index + 2) >> 32),
+                static_cast<int>((index + 1) >> 32),
+                static_cast<int>(index >> 32));
+            c2[group] = _mm_setzero_si128();
+            c3[group] = _mm_setzero_si128();
+        }
+
+        u32 k0 = static_cast<u32>(seed);
+        u32 k1 = static_cast<u32>(seed >> 32);
+        for (u32 round = 0; round < RANDOM_PHILOX_ROUNDS; round++)
+        {
+            const __m128i key0 = _mm_set1_epi32(static_cast<int>(k0));
+            const __m128i key1 = _mm_set1_epi32(static_cast<int>(k1));
+            for (u32 group = 0; group < groups; group++)
+            {
+                __m128i hi0;
+                __m128i lo0;
+                __m128i hi1;
+                __m128i lo1;
+                RandomMulHiLo(m0, c0[group], &hi0, &lo0);
+                RandomMulHiLo(m1, c2[group], &hi1, &lo1);
+                c0[group] = _mm_xor_si128(_mm_xor_si128(hi1, c1[group]), key0);
+                c2[group] = _mm_xor_si128(_mm_xor_si128(hi0, c3[group]), key1);
+                c1[group] = lo1;
+                c3[group] = lo0;
+            }
+            k0 += RANDOM_PHILOX_W0;
+            k1 += RANDOM_PHILOX_W1;
+        }
+
+        for (u32 group = 0; group < groups; group++)
+        {
+            const u32 offset = i + (group * 4);
+            _mm_storeu_ps(outputs[0] + offset, RandomFloat4(c0[group], intervals[0]));
+            _mm_storeu_ps(outputs[1] + offset, RandomFloat4(c1[group], intervals[1]));
+            _mm_storeu_ps(outputs[2] + offset, RandomFloat4(c2[group], intervals[2]));
+            _mm_storeu_ps(outputs[3] + offset, RandomFloat4(c3[group], intervals[3]));
+        }
+    }
+
+    for (; i < count; i++)
+    {
+        const RandomBlock block = RandomPhilox(seed, first + i);
+        for (u32 j = 0; j < 4; j++)
+        {
+            outputs[j][i] = RandomFloat(block.m_Values[j], intervals[j]);
+        }
+    }
+}
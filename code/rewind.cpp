@@ -0,0 +1,475 @@
+#include "rewind.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+#include "jobs.h"
+#include "lz4.h"
+
+namespace
+{
+    // NOTE(sbalse): The deltas of a snapshot, back to the one before it. The blob holds the index of every changed
+    // page, then where each compressed page ends, then the compressed pages back to back. The oldest snapshot has
+    // no way further back, it never has deltas.
+    struct RewindSnapshot
+    {
+        u64 m_Step;
+        u8* m_Deltas;
+        u64 m_Size;
+        u32 m_PageCount;
+    };
+
+    struct RewindPage
+    {
+        u8* m_Data;
+        u64 m_Offset; // NOTE(sbalse): Into the copy of the state.
+        u32 m_Size; // NOTE(sbalse): Less than REWIND_PAGE_SIZE only at the end of a region.
+        bool m_Tracked;
+    };
+
+    struct RewindRestoreJob
+    {
+        Rewind* m_Rewind;
+        const RewindSnapshot* m_Snapshot;
+        std::atomic<bool> m_Failed; // NOTE(sbalse): Some page didn't decompress, it was left as it was.
+    };
+
+    // NOTE(sbalse): XORs a page with its previous content and splits the result into byte planes, the first bytes
+    // of every four byte value, then the second bytes and so on. Values that changed a little only differ in their
+    // low bytes, the planes of the high bytes turn into runs of zeros that LZ4 takes at memory speed.
+    void RewindShuffleDelta(u8* delta, const u8* current, const u8* previous, const u32 size)
+    {
+        const u32 valueCount = size / 4;
+        for (u32 i = 0; i < valueCount; i++)
+        {
+            u32 a = 0;
+            u32 b = 0;
+            std::memcpy(&a, current + (i * 4), sizeof(a));
+            std::memcpy(&b, previous + (i * 4), sizeof(b));
+            const u32 value = a ^ b;
+            delta[i] = static_cast<u8>(value);
+            delta[valueCount + i] = static_cast<u8>(value >> 8);
+            delta[(valueCount * 2) + i] = static_cast<u8>(value >> 16);
+            delta[(valueCount * 3) + i] = static_cast<u8>(value >> 24);
+        }
+        for (u32 i = valueCount * 4; i < size; i++)
+        {
+            delta[i] = current[i] ^ previous[i];
+        }
+    }
+
+    void RewindApplyDelta(u8* state, const u8* delta, const u32 size)
+    {
+        const u32 valueCount = size / 4;
+        for (u32 i = 0; i < valueCount; i++)
+        {
+            u32 value = 0;
+            std::memcpy(&value, state + (i * 4), sizeof(value));
+            value ^= static_cast<u32>(delta[i])
+                | (static_cast<u32>(delta[valueCount + i]) << 8)
+                | (static_cast<u32>(delta[(valueCount * 2) + i]) << 16)
+                | (static_cast<u32>(delta[(valueCount * 3) + i]) << 24);
+            std::memcpy(state + (i * 4), &value, sizeof(value));
+        }
+        for (u32 i = valueCount * 4; i < size; i++)
+        {
+            state[i] ^= delta[i];
+        }
+    }
+} // namespace
+
+struct Rewind
+{
+    u32 m_RegionCount;
+    RewindRegion m_Regions[REWIND_MAX_REGIONS];
+    u32 m_FirstPages[REWIND_MAX_REGIONS];
+    u64 m_Budget;
+    u64 m_StateBytes;
+    u32 m_PageCount;
+    u32 m_PageBound;
+    RewindPage* m_Pages;
+    u8* m_Changed; // NOTE(sbalse): Marks of the pages of tracked regions.
+    // NOTE(sbalse): The regions as of the newest snapshot.
+    u8* m_State;
+    // NOTE(sbalse): Compressed deltas of the snapshot being taken, page i at i times the page bound. Zero sizes are
+    // pages that didn't change.
+    u8* m_Scratch;
+    u32* m_ScratchSizes;
+    // NOTE(sbalse): Deltas are allocated in snapshot order from a ring of m_Budget bytes. The oldest are always
+    // the first to go and a restore drops the newest, so freeing is only ever moving either end.
+    u8* m_History;
+    u64 m_Head;
+    // NOTE(sbalse): Ring of snapshots, oldest first.
+    RewindSnapshot m_Snapshots[REWIND_MAX_SNAPSHOTS];
+    u32 m_First;
+    u32 m_SnapshotCount;
+    u64 m_HistoryBytes;
+    u32 m_ChangedPages;
+    u64 m_DeltaBytes;
+};
+
+namespace
+{
+    RewindSnapshot* RewindGetSnapshot(Rewind* rewind, const u32 age)
+    {
+        return &rewind->m_Snapshots[(rewind->m_First + age) % REWIND_MAX_SNAPSHOTS];
+    }
+
+    // NOTE(sbalse): Returns nullptr when there is no room between the newest and the oldest deltas.
+    u8* RewindAllocateDeltas(Rewind* rewind, const u64 size)
+    {
+        const RewindSnapshot* oldest = nullptr;
+        for (u32 age = 1; age < rewind->m_SnapshotCount && !oldest; age++)
+        {
+            const RewindSnapshot* snapshot = RewindGetSnapshot(rewind, age);
+            oldest = snapshot->m_Deltas ? snapshot : nullptr;
+        }
+
+        const u64 none = rewind->m_Budget;
+        u64 offset = none;
+        if (!oldest)
+        {
+            offset = size <= rewind->m_Budget ? 0 : none;
+        }
+        else
+        {
+            const u64 tail = static_cast<u64>(oldest->m_Deltas - rewind->m_History);
+            if (rewind->m_Head > tail)
+            {
+                const u64 wrapped = tail >= size ? 0 : none;
+                offset = rewind->m_Budget - rewind->m_Head >= size ? rewind->m_Head : wrapped;
+            }
+            else if (tail - rewind->m_Head >= size)
+            {
+                offset = rewind->m_Head;
+            }
+        }
+
+        if (offset == none)
+        {
+            return nullptr;
+        }
+        rewind->m_Head = offset + size;
+        rewind->m_HistoryBytes += size;
+        return rewind->m_History + offset;
+    }
+
+    void RewindFreeDeltas(Rewind* rewind, RewindSnapshot* snapshot)
+    {
+        rewind->m_HistoryBytes -= snapshot->m_Size;
+        snapshot->m_Deltas = nullptr;
+        snapshot->m_Size = 0;
+        snapshot->m_PageCount = 0;
+    }
+
+    // NOTE(sbalse): Once the oldest is gone the next one becomes the oldest, its deltas lead nowhere anymore.
+    void RewindForgetOldest(Rewind* rewind)
+    {
+        RewindFreeDeltas(rewind, RewindGetSnapshot(rewind, 0));
+        rewind->m_First = (rewind->m_First + 1) % REWIND_MAX_SNAPSHOTS;
+        rewind->m_SnapshotCount--;
+        if (rewind->m_SnapshotCount > 0)
+        {
+            RewindFreeDeltas(rewind, RewindGetSnapshot(rewind, 0));
+        }
+    }
+
+    // NOTE(sbalse): Pages that changed are turned into deltas against the state and compressed, then the state
+    // catches up. Pages of tracked regions that weren't marked are taken as unchanged without looking.
+    void RewindCaptureRange(void* context, const u32 begin, const u32 end)
+    {
+        Rewind* rewind = static_cast<Rewind*>(context);
+        alignas(16) u8 delta[REWIND_PAGE_SIZE];
+        for (u32 i = begin; i < end; i++)
+        {
+            const RewindPage* page = &rewind->m_Pages[i];
+            u8* state = rewind->m_State + page->m_Offset;
+            const bool unmarked = page->m_Tracked && !rewind->m_Changed[i];
+            rewind->m_Changed[i] = 0;
+            if (unmarked || std::memcmp(page->m_Data, state, page->m_Size) == 0)
+            {
+                rewind->m_ScratchSizes[i] = 0;
+                continue;
+            }
+
+            RewindShuffleDelta(delta, page->m_Data, state, page->m_Size);
+            std::memcpy(state, page->m_Data, page->m_Size);
+            u8* target = rewind->m_Scratch + (static_cast<size_t>(i) * rewind->m_PageBound);
+            rewind->m_ScratchSizes[i] = Lz4Compress(delta, page->m_Size, target);
+        }
+    }
+
+    // NOTE(sbalse): Takes the state back across one snapshot, or forward again when it was just taken back, XORing
+    // twice changes nothing. The pages of a snapshot are all different, so they are done in parallel.
+    void RewindRestoreRange(void* context, const u32 begin, const u32 end)
+    {
+        RewindRestoreJob* job = static_cast<RewindRestoreJob*>(context);
+        Rewind* rewind = job->m_Rewind;
+        const RewindSnapshot* snapshot = job->m_Snapshot;
+        const u32* pageIndices = reinterpret_cast<const u32*>(snapshot->m_Deltas);
+        const u32* ends = pageIndices + snapshot->m_PageCount;
+        const u8* deltas = reinterpret_cast<const u8*>(ends + snapshot->m_PageCount);
+
+        alignas(16) u8 delta[REWIND_PAGE_SIZE];
+        for (u32 i = begin; i < end; i++)
+        {
+            const RewindPage* page = &rewind->m_Pages[pageIndices[i]];
+            const u32 start = i > 0 ? ends[i - 1] : 0;
+            if (Lz4Decompress(deltas + start, ends[i] - start, delta, page->m_Size))
+            {
+                RewindApplyDelta(rewind->m_State + page->m_Offset, delta, page->m_Size);
+            }
+            else
+            {
+                job->m_Failed.store(true, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // NOTE(sbalse): Returns false when a page of the snapshot didn't decompress. The pages that did are applied
+    // anyway, applying the snapshot again takes exactly those back since the others fail the same way again.
+    bool RewindApplySnapshot(Rewind* rewind, const RewindSnapshot* snapshot)
+    {
+        RewindRestoreJob job = { .m_Rewind = rewind, .m_Snapshot = snapshot, .m_Failed = false };
+        JobsWait(JobsDispatch(snapshot->m_PageCount, REWIND_JOB_BATCH, RewindRestoreRange, &job));
+        return !job.m_Failed.load(std::memory_order_relaxed);
+    }
+} // namespace
+
+Rewind* RewindCreate(const RewindDesc* desc, const u64 step)
+{
+    if (desc->m_RegionCount == 0 || desc->m_RegionCount > REWIND_MAX_REGIONS)
+    {
+        return nullptr;
+    }
+
+    Rewind* rewind = static_cast<Rewind*>(std::calloc(1, sizeof(Rewind)));
+    if (!rewind)
+    {
+        return nullptr;
+    }
+
+    rewind->m_RegionCount = desc->m_RegionCount;
+    rewind->m_Budget = desc->m_Budget;
+    rewind->m_PageBound = Lz4CompressBound(REWIND_PAGE_SIZE);
+    for (u32 i = 0; i < desc->m_RegionCount; i++)
+    {
+        const RewindRegion* region = &desc->m_Regions[i];
+        rewind->m_Regions[i] = *region;
+        rewind->m_StateBytes += region->m_Size;
+        rewind->m_PageCount += static_cast<u32>((region->m_Size + REWIND_PAGE_SIZE - 1) / REWIND_PAGE_SIZE);
+    }
+
+    rewind->m_Pages = static_cast<RewindPage*>(std::calloc(rewind->m_PageCount, sizeof(RewindPage)));
+    rewind->m_Changed = static_cast<u8*>(std::calloc(rewind->m_PageCount, sizeof(u8)));
+    rewind->m_State = static_cast<u8*>(std::malloc(rewind->m_StateBytes));
+    rewind->m_Scratch = static_cast<u8*>(std::malloc(static_cast<size_t>(rewind->m_PageCount) * rewind->m_PageBound));
+    rewind->m_ScratchSizes = static_cast<u32*>(std::calloc(rewind->m_PageCount, sizeof(u32)));
+    rewind->m_History = static_cast<u8*>(std::malloc(rewind->m_Budget));
+    if (!rewind->m_Pages
+        || !rewind->m_Changed
+        || !rewind->m_State
+        || !rewind->m_Scratch
+        || !rewind->m_ScratchSizes
+        || !rewind->m_History)
+    {
+        RewindDestroy(rewind);
+        return nullptr;
+    }
+
+    u32 page = 0;
+    size_t offset = 0;
+    for (u32 i = 0; i < rewind->m_RegionCount; i++)
+    {
+        const RewindRegion* region = &rewind->m_Regions[i];
+        rewind->m_FirstPages[i] = page;
+        std::memcpy(rewind->m_State + offset, region->m_Data, region->m_Size);
+        for (size_t begin = 0; begin < region->m_Size; begin += REWIND_PAGE_SIZE)
+        {
+            const size_t size = region->m_Size - begin;
+            rewind->m_Pages[page++] =
+            {
+                .m_Data = static_cast<u8*>(region->m_Data) + begin,
+                .m_Offset = offset + begin,
+                .m_Size = static_cast<u32>(size < REWIND_PAGE_SIZE ? size : REWIND_PAGE_SIZE),
+                .m_Tracked = region->m_Tracked,
+            };
+        }
+        offset += region->m_Size;
+    }
+
+    rewind->m_Snapshots[0] = { .m_Step = step, .m_Deltas = nullptr, .m_Size = 0, .m_PageCount = 0 };
+    rewind->m_SnapshotCount = 1;
+    return rewind;
+}
+
+void RewindDestroy(Rewind* rewind)
+{
+    std::free(rewind->m_History);
+    std::free(rewind->m_Pages);
+    std::free(rewind->m_Changed);
+    std::free(rewind->m_State);
+    std::free(rewind->m_Scratch);
+    std::free(rewind->m_ScratchSizes);
+    std::free(rewind);
+}
+
+void RewindMarkChanged(Rewind* rewind, const void* data, const u64 size)
+{
+    const u8* begin = static_cast<const u8*>(data);
+    for (u32 i = 0; i < rewind->m_RegionCount && size > 0; i++)
+    {
+        const u8* region = static_cast<const u8*>(rewind->m_Regions[i].m_Data);
+        if (begin < region || begin + size > region + rewind->m_Regions[i].m_Size)
+        {
+            continue;
+        }
+
+        const u64 first = static_cast<u64>(begin - region) / REWIND_PAGE_SIZE;
+        const u64 last = (static_cast<u64>(begin - region) + size - 1) / REWIND_PAGE_SIZE;
+        std::memset(rewind->m_Changed + rewind->m_FirstPages[i] + first, 1, last - first + 1);
+        return;
+    }
+}
+
+bool RewindCapture(Rewind* rewind, const u64 step)
+{
+    if (step <= RewindGetSnapshot(rewind, rewind->m_SnapshotCount - 1)->m_Step)
+    {
+        return false;
+    }
+
+    JobsWait(JobsDispatch(rewind->m_PageCount, REWIND_JOB_BATCH, RewindCaptureRange, rewind));
+
+    u32 pageCount = 0;
+    u64 deltaBytes = 0;
+    for (u32 i = 0; i < rewind->m_PageCount; i++)
+    {
+        pageCount += rewind->m_ScratchSizes[i] != 0 ? 1 : 0;
+        deltaBytes += rewind->m_ScratchSizes[i];
+    }
+    rewind->m_ChangedPages = pageCount;
+    rewind->m_DeltaBytes = deltaBytes;
+
+    // NOTE(sbalse): Rounded up so the page indices of the next blob in the ring stay aligned.
+    const u64 size = pageCount > 0 ? ((pageCount * sizeof(u32) * 2) + deltaBytes + 3) & ~3ull : 0;
+    if (rewind->m_SnapshotCount == REWIND_MAX_SNAPSHOTS)
+    {
+        RewindForgetOldest(rewind);
+    }
+
+    // NOTE(sbalse): Without anything left to go back to the deltas aren't needed, nor when they don't fit.
+    u8* deltas = size > 0 ? RewindAllocateDeltas(rewind, size) : nullptr;
+    while (size > 0 && !deltas && rewind->m_SnapshotCount > 0)
+    {
+        RewindForgetOldest(rewind);
+        deltas = rewind->m_SnapshotCount > 0 ? RewindAllocateDeltas(rewind, size) : nullptr;
+    }
+
+    if (deltas)
+    {
+        u32* pageIndices = reinterpret_cast<u32*>(deltas);
+        u32* ends = pageIndices + pageCount;
+        u8* data = reinterpret_cast<u8*>(ends + pageCount);
+        u32 changed = 0;
+        u32 offset = 0;
+        for (u32 i = 0; i < rewind->m_PageCount; i++)
+        {
+            const u32 pageSize = rewind->m_ScratchSizes[i];
+            if (pageSize == 0)
+            {
+                continue;
+            }
+            std::memcpy(data + offset, rewind->m_Scratch + (static_cast<size_t>(i) * rewind->m_PageBound), pageSize);
+            offset += pageSize;
+            pageIndices[changed] = i;
+            ends[changed] = offset;
+            changed++;
+        }
+    }
+
+    const bool kept = rewind->m_SnapshotCount > 0;
+    *RewindGetSnapshot(rewind, rewind->m_SnapshotCount) =
+    {
+        .m_Step = step,
+        .m_Deltas = deltas,
+        .m_Size = deltas ? size : 0,
+        .m_PageCount = deltas ? pageCount : 0,
+    };
+    rewind->m_SnapshotCount++;
+    return kept;
+}
+
+bool RewindRestore(Rewind* rewind, const u64 step)
+{
+    u32 age = rewind->m_SnapshotCount;
+    for (u32 i = 0; i < rewind->m_SnapshotCount; i++)
+    {
+        if (RewindGetSnapshot(rewind, i)->m_Step == step)
+        {
+            age = i;
+            break;
+        }
+    }
+    if (age == rewind->m_SnapshotCount)
+    {
+        return false;
+    }
+
+    // NOTE(sbalse): Nothing is forgotten until every snapshot on the way came back whole. When one didn't, all of
+    // them are applied again, which leaves the state as it was, and the regions aren't touched.
+    u32 applied = 0;
+    bool failed = false;
+    while (!failed && rewind->m_SnapshotCount - 1 - applied > age)
+    {
+        failed = !RewindApplySnapshot(rewind, RewindGetSnapshot(rewind, rewind->m_SnapshotCount - 1 - applied));
+        applied++;
+    }
+    if (failed)
+    {
+        for (u32 i = 0; i < applied; i++)
+        {
+            RewindApplySnapshot(rewind, RewindGetSnapshot(rewind, rewind->m_SnapshotCount - 1 - i));
+        }
+        return false;
+    }
+
+    while (rewind->m_SnapshotCount - 1 > age)
+    {
+        RewindSnapshot* newest = RewindGetSnapshot(rewind, rewind->m_SnapshotCount - 1);
+        if (newest->m_Deltas)
+        {
+            rewind->m_Head = static_cast<u64>(newest->m_Deltas - rewind->m_History);
+        }
+        RewindFreeDeltas(rewind, newest);
+        rewind->m_SnapshotCount--;
+    }
+
+    // NOTE(sbalse): The regions may have moved on since the newest snapshot, all of them are written back.
+    size_t offset = 0;
+    for (u32 i = 0; i < rewind->m_RegionCount; i++)
+    {
+        const RewindRegion* region = &rewind->m_Regions[i];
+        std::memcpy(region->m_Data, rewind->m_State + offset, region->m_Size);
+        offset += region->m_Size;
+    }
+    return true;
+}
+
+RewindStats RewindGetStats(const Rewind* rewind)
+{
+    const u32 last = (rewind->m_First + rewind->m_SnapshotCount - 1) % REWIND_MAX_SNAPSHOTS;
+    const RewindStats result =
+    {
+        .m_SnapshotCount = rewind->m_SnapshotCount,
+        .m_OldestStep = rewind->m_Snapshots[rewind->m_First].m_Step,
+        .m_NewestStep = rewind->m_Snapshots[last].m_Step,
+        .m_PageCount = rewind->m_PageCount,
+        .m_ChangedPages = rewind->m_ChangedPages,
+        .m_StateBytes = rewind->m_StateBytes,
+        .m_DeltaBytes = rewind->m_DeltaBytes,
+        .m_HistoryBytes = rewind->m_HistoryBytes,
+    };
+    return result;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "types.h"
+
+/*
+* NOTE(sbalse): Rewind history of plain old data, like the simulation state. The memory is registered as regions
+* once and snapshotted after every step. A snapshot cuts the regions into REWIND_PAGE_SIZE pages and only looks
+* further at the pages that changed since the previous one. Those are XORed with their previous content, which
+* leaves zeros wherever bytes didn't change, and compressed with LZ4. Pages are compared and compressed on the job
+* workers.
+*
+* The newest state is kept whole. Every older snapshot is only the XOR deltas back to the one before it, so
+* restoring walks back from the newest state and recent snapshots restore fastest. The deltas are kept within a
+* byte budget, the oldest snapshots are forgotten to make room.
+*
+* Comparing pages costs a pass over all the memory, which dominates when little of it changes. Regions that are
+* tracked skip it, only the pages marked with RewindMarkChanged() since the last snapshot are looked at.
+*
+* Restoring writes the regions back in place and forgets the snapshots after the restored one. The next snapshot
+* carries on from there.
+*/
+
+constexpr u32 REWIND_PAGE_SIZE = 4096;
+constexpr u32 REWIND_MAX_REGIONS = 16;
+constexpr u32 REWIND_MAX_SNAPSHOTS = 4096;
+// NOTE(sbalse): Pages are cut into batches of this many for the job workers.
+constexpr u32 REWIND_JOB_BATCH = 16;
+
+struct RewindRegion
+{
+    void* m_Data;
+    u64 m_Size;
+    bool m_Tracked; // NOTE(sbalse): Changes are marked with RewindMarkChanged(), unmarked pages are never compared.
+};
+
+struct RewindDesc
+{
+    const RewindRegion* m_Regions;
+    u32 m_RegionCount; // NOTE(sbalse): Up to REWIND_MAX_REGIONS.
+    u64 m_Budget; // NOTE(sbalse): Bytes set aside for compressed deltas, on top of two copies of the state.
+};
+
+struct RewindStats
+{
+    u32 m_SnapshotCount;
+    u64 m_OldestStep;
+    u64 m_NewestStep;
+    u32 m_PageCount;
+    u32 m_ChangedPages; // NOTE(sbalse): Of the newest snapshot.
+    u64 m_StateBytes;
+    u64 m_DeltaBytes; // NOTE(sbalse): Compressed deltas of the newest snapshot.
+    u64 m_HistoryBytes; // NOTE(sbalse): Compressed deltas of all snapshots.
+};
+
+struct Rewind;
+
+// NOTE(sbalse): Takes the first snapshot right away, as step. Returns nullptr when out of memory.
+Rewind* RewindCreate(const RewindDesc* desc, const u64 step);
+void RewindDestroy(Rewind* rewind);
+// NOTE(sbalse): Marks size bytes at data, which lie in a tracked region, as changed for the next snapshot. Must not
+// run concurrently with itself or with RewindCapture().
+void RewindMarkChanged(Rewind* rewind, const void* data, const u64 size);
+// NOTE(sbalse): Snapshots the regions as step, which must be after the newest snapshot. Returns false when the
+// deltas alone are over the budget, the history then starts over from this snapshot.
+bool RewindCapture(Rewind* rewind, const u64 step);
+// NOTE(sbalse): Writes the snapshot of step back into the regions. Returns false, changing nothing, when there is
+// no snapshot of step or the deltas on the way back to it are damaged.
+bool RewindRestore(Rewind* rewind, const u64 step);
+RewindStats RewindGetStats(const Rewind* rewind);
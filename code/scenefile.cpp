@@ -0,0 +1,401 @@
+#include "scenefile.h"
+
+#include <cstdio>
+#include <cstring>
+
+#if _WIN32
+#include "cleanwindows.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    constexpr u64 SCENEFILE_PRIME1 = 11400714785074694791ull;
+    constexpr u64 SCENEFILE_PRIME2 = 14029467366897019727ull;
+    constexpr u64 SCENEFILE_PRIME3 = 1609587929392839161ull;
+    constexpr u64 SCENEFILE_PRIME4 = 9650029242287828579ull;
+    constexpr u64 SCENEFILE_PRIME5 = 2870177450012600261ull;
+
+    constexpr u32 SCENEFILE_MAX_PATH_LENGTH = 512;
+
+    // NOTE(sbalse): Streams are all float or u32.
+    static_assert(sizeof(float) == sizeof(u32));
+
+    u64 SceneFileRotateLeft(const u64 value, const u32 bits)
+    {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    u64 SceneFileRound(u64 accumulator, const u64 input)
+    {
+        accumulator += input * SCENEFILE_PRIME2;
+        accumulator = SceneFileRotateLeft(accumulator, 31);
+        return accumulator * SCENEFILE_PRIME1;
+    }
+
+    u64 SceneFileMerge(u64 accumulator, const u64 value)
+    {
+        accumulator ^= SceneFileRound(0, value);
+        return accumulator * SCENEFILE_PRIME1 + SCENEFILE_PRIME4;
+    }
+
+    u64 SceneFileRead64(const u8* data)
+    {
+        u64 result = 0;
+        std::memcpy(&result, data, sizeof(result));
+        return result;
+    }
+
+    u32 SceneFileRead32(const u8* data)
+    {
+        u32 result = 0;
+        std::memcpy(&result, data, sizeof(result));
+        return result;
+    }
+
+    u64 SceneFileAlign(const u64 value)
+    {
+        return (value + SCENEFILE_ALIGNMENT - 1) & ~static_cast<u64>(SCENEFILE_ALIGNMENT - 1);
+    }
+
+    u64 SceneFileHeaderChecksum(const SceneFileHeader* header)
+    {
+        SceneFileHeader copy = *header;
+        copy.m_HeaderChecksum = 0;
+        return SceneFileChecksum(&copy, sizeof(copy));
+    }
+
+    bool SceneFileSectionIsValid(const SceneFileSection* section, const u64 expectedSize, const u64 fileSize)
+    {
+        return section->m_Size == expectedSize
+            && section->m_Offset % SCENEFILE_ALIGNMENT == 0
+            && section->m_Offset >= sizeof(SceneFileHeader)
+            && section->m_Offset <= fileSize
+            && section->m_Size <= fileSize - section->m_Offset;
+    }
+
+    bool SceneFileWriteSection(std::FILE* stream, const void* data, const u64 size)
+    {
+        static constexpr u8 padding[SCENEFILE_ALIGNMENT] = {};
+
+        const u64 paddingSize = SceneFileAlign(size) - size;
+        return std::fwrite(data, 1, size, stream) == size
+            && std::fwrite(padding, 1, paddingSize, stream) == paddingSize;
+    }
+
+    // NOTE(sbalse): Maps the whole file copy on write. Returns the view and its size.
+    void* SceneFileMap(SceneFile* file, const char* path, u64* size)
+    {
+#if _WIN32
+        HANDLE handle = CreateFileA(
+            path,
+            GENERIC_READ,
+            FILE_SHARE_READ | FILE_SHARE_DELETE, // NOTE(sbalse): So a save can replace the file while it is mapped.
+            nullptr,
+            OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+            nullptr);
+        if (handle == INVALID_HANDLE_VALUE)
+        {
+            return nullptr;
+        }
+
+        LARGE_INTEGER fileSize = {};
+        constexpr LONGLONG minimumSize = sizeof(SceneFileHeader);
+        if (!GetFileSizeEx(handle, &fileSize) || fileSize.QuadPart < minimumSize)
+        {
+            CloseHandle(handle);
+            return nullptr;
+        }
+
+        HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+        if (!mapping)
+        {
+            CloseHandle(handle);
+            return nullptr;
+        }
+
+        void* view = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+        if (!view)
+        {
+            CloseHandle(mapping);
+            CloseHandle(handle);
+            return nullptr;
+        }
+
+        file->m_File = handle;
+        file->m_Mapping = mapping;
+        *size = static_cast<u64>(fileSize.QuadPart);
+        return view;
+#else
+        const int fd = open(path, O_RDONLY);
+        if (fd < 0)
+        {
+            return nullptr;
+        }
+
+        struct stat status = {};
+        if (fstat(fd, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(SceneFileHeader)))
+        {
+            close(fd);
+            return nullptr;
+        }
+
+        const size_t length = static_cast<size_t>(status.st_size);
+        void* view = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+
+        // NOTE(sbalse): The mapping keeps the file alive, the descriptor is not needed anymore.
+        close(fd);
+
+        if (view == MAP_FAILED)
+        {
+            return nullptr;
+        }
+
+        file->m_File = nullptr;
+        file->m_Mapping = nullptr;
+        *size = length;
+        return view;
+#endif
+    }
+
+    bool SceneFileReplace(const char* source, const char* destination)
+    {
+#if _WIN32
+        if (MoveFileExA(source, destination, MOVEFILE_REPLACE_EXISTING))
+        {
+            return true;
+        }
+
+        // NOTE(sbalse): Replacing a file that is still mapped fails, but renaming it does not, and the mapping
+        // keeps reading the renamed file. Move it aside, move the new file in and put the old one back if that
+        // fails too.
+        char asidePath[SCENEFILE_MAX_PATH_LENGTH + 8] = {};
+        const int length = std::snprintf(asidePath, sizeof(asidePath), "%s.old", destination);
+        if (length < 0 || length >= static_cast<int>(sizeof(asidePath)))
+        {
+            return false;
+        }
+
+        if (!MoveFileExA(destination, asidePath, MOVEFILE_REPLACE_EXISTING))
+        {
+            return false;
+        }
+
+        if (!MoveFileExA(source, destination, 0))
+        {
+            MoveFileExA(asidePath, destination, 0);
+            return false;
+        }
+
+        // NOTE(sbalse): Only marked for deletion while the old snapshot is still mapped.
+        DeleteFileA(asidePath);
+        return true;
+#else
+        return std::rename(source, destination) == 0;
+#endif
+    }
+}
+
+u64 SceneFileChecksum(const void* data, const u64 size)
+{
+    const u8* bytes = static_cast<const u8*>(data);
+    const u8* end = bytes + size;
+    u64 hash = 0;
+
+    if (size >= 32)
+    {
+        // NOTE(sbalse): Four independent lanes so the multiplies overlap.
+        u64 lane0 = SCENEFILE_PRIME1 + SCENEFILE_PRIME2;
+        u64 lane1 = SCENEFILE_PRIME2;
+        u64 lane2 = 0;
+        u64 lane3 = 0 - SCENEFILE_PRIME1;
+        for (; bytes + 32 <= end; bytes += 32)
+        {
+            lane0 = SceneFileRound(lane0, SceneFileRead64(bytes + 0));
+            lane1 = SceneFileRound(lane1, SceneFileRead64(bytes + 8));
+            lane2 = SceneFileRound(lane2, SceneFileRead64(bytes + 16));
+            lane3 = SceneFileRound(lane3, SceneFileRead64(bytes + 24));
+        }
+
+        hash = SceneFileRotateLeft(lane0, 1) + SceneFileRotateLeft(lane1, 7)
+            + SceneFileRotateLeft(lane2, 12) + SceneFileRotateLeft(lane3, 18);
+        hash = SceneFileMerge(hash, lane0);
+        hash = SceneFileMerge(hash, lane1);
+        hash = SceneFileMerge(hash, lane2);
+        hash = SceneFileMerge(hash, lane3);
+    }
+    else
+    {
+        hash = SCENEFILE_PRIME5;
+    }
+
+    hash += size;
+
+    for (; bytes + 8 <= end; bytes += 8)
+    {
+        hash ^= SceneFileRound(0, SceneFileRead64(bytes));
+        hash = SceneFileRotateLeft(hash, 27) * SCENEFILE_PRIME1 + SCENEFILE_PRIME4;
+    }
+    if (bytes + 4 <= end)
+    {
+        hash ^= SceneFileRead32(bytes) * SCENEFILE_PRIME1;
+        hash = SceneFileRotateLeft(hash, 23) * SCENEFILE_PRIME2 + SCENEFILE_PRIME3;
+        bytes += 4;
+    }
+    for (; bytes < end; bytes++)
+    {
+        hash ^= *bytes * SCENEFILE_PRIME5;
+        hash = SceneFileRotateLeft(hash, 11) * SCENEFILE_PRIME1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= SCENEFILE_PRIME2;
+    hash ^= hash >> 29;
+    hash *= SCENEFILE_PRIME3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+bool SceneFileOpen(SceneFile* file, const char* path)
+{
+    *file = {};
+
+    u64 size = 0;
+    void* view = SceneFileMap(file, path, &size);
+    if (!view)
+    {
+        return false;
+    }
+    file->m_Header = static_cast<SceneFileHeader*>(view);
+    file->m_Size = size;
+
+    const SceneFileHeader* header = file->m_Header;
+    bool valid = header->m_Magic == SCENEFILE_MAGIC
+        && header->m_Version == SCENEFILE_VERSION
+        && header->m_FileSize == size
+        && header->m_HeaderChecksum == SceneFileHeaderChecksum(header);
+
+    const u8* base = static_cast<const u8*>(view);
+    for (u32 i = 0; valid && i < SCENEFILE_STREAM_COUNT; i++)
+    {
+        const SceneFileSection* section = &header->m_Streams[i];
+        valid = SceneFileSectionIsValid(section, static_cast<u64>(header->m_ObjectCount) * sizeof(u32), size)
+            && SceneFileChecksum(base + section->m_Offset, section->m_Size) == section->m_Checksum;
+    }
+
+    const SceneFileSection* meshes = &header->m_Meshes;
+    valid = valid
+        && SceneFileSectionIsValid(meshes, static_cast<u64>(header->m_MeshCount) * sizeof(SceneFileMesh), size)
+        && SceneFileChecksum(base + meshes->m_Offset, meshes->m_Size) == meshes->m_Checksum;
+
+    if (!valid)
+    {
+        SceneFileClose(file);
+        return false;
+    }
+
+    return true;
+}
+
+void SceneFileClose(SceneFile* file)
+{
+    if (!file->m_Header)
+    {
+        return;
+    }
+
+#if _WIN32
+    UnmapViewOfFile(file->m_Header);
+    CloseHandle(static_cast<HANDLE>(file->m_Mapping));
+    CloseHandle(static_cast<HANDLE>(file->m_File));
+#else
+    munmap(file->m_Header, file->m_Size);
+#endif
+
+    *file = {};
+}
+
+void* SceneFileGetStream(const SceneFile* file, const SceneStream stream)
+{
+    u8* base = reinterpret_cast<u8*>(file->m_Header);
+    return base + file->m_Header->m_Streams[static_cast<u32>(stream)].m_Offset;
+}
+
+const SceneFileMesh* SceneFileGetMeshes(const SceneFile* file)
+{
+    const u8* base = reinterpret_cast<const u8*>(file->m_Header);
+    return reinterpret_cast<const SceneFileMesh*>(base + file->m_Header->m_Meshes.m_Offset);
+}
+
+bool SceneFileWrite(const char* path, const SceneFileContents* contents)
+{
+    // NOTE(sbalse): Lay out the sections, then checksum straight from the source arrays.
+    SceneFileHeader header =
+    {
+        .m_Magic = SCENEFILE_MAGIC,
+        .m_Version = SCENEFILE_VERSION,
+        .m_FileSize = 0,
+        .m_HeaderChecksum = 0,
+        .m_ObjectCount = contents->m_ObjectCount,
+        .m_MeshCount = contents->m_MeshCount,
+        .m_Streams = {},
+        .m_Meshes = {},
+    };
+
+    u64 offset = SceneFileAlign(sizeof(SceneFileHeader));
+    const u64 streamSize = static_cast<u64>(contents->m_ObjectCount) * sizeof(u32);
+    for (u32 i = 0; i < SCENEFILE_STREAM_COUNT; i++)
+    {
+        header.m_Streams[i] =
+        {
+            .m_Offset = offset,
+            .m_Size = streamSize,
+            .m_Checksum = SceneFileChecksum(contents->m_Streams[i], streamSize),
+        };
+        offset += SceneFileAlign(streamSize);
+    }
+
+    const u64 meshesSize = static_cast<u64>(contents->m_MeshCount) * sizeof(SceneFileMesh);
+    header.m_Meshes =
+    {
+        .m_Offset = offset,
+        .m_Size = meshesSize,
+        .m_Checksum = SceneFileChecksum(contents->m_Meshes, meshesSize),
+    };
+    header.m_FileSize = offset + SceneFileAlign(meshesSize);
+    header.m_HeaderChecksum = SceneFileHeaderChecksum(&header);
+
+    char temporaryPath[SCENEFILE_MAX_PATH_LENGTH] = {};
+    const int length = std::snprintf(temporaryPath, sizeof(temporaryPath), "%s.tmp", path);
+    if (length < 0 || length >= static_cast<int>(sizeof(temporaryPath)))
+    {
+        return false;
+    }
+
+    std::FILE* stream = std::fopen(temporaryPath, "wb");
+    if (!stream)
+    {
+        return false;
+    }
+
+    bool written = SceneFileWriteSection(stream, &header, sizeof(header));
+    for (u32 i = 0; written && i < SCENEFILE_STREAM_COUNT; i++)
+    {
+        written = SceneFileWriteSection(stream, contents->m_Streams[i], streamSize);
+    }
+    written = written && SceneFileWriteSection(stream, contents->m_Meshes, meshesSize);
+    written = std::fclose(stream) == 0 && written;
+
+    if (!written || !SceneFileReplace(temporaryPath, path))
+    {
+        std::remove(temporaryPath);
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include "types.h"
+
+/*
+* NOTE(sbalse): Binary scene snapshot, laid out so it can be memory mapped and used in place:
+*   - A fixed header, then one array per stream, then the mesh table.
+*   - Everything is addressed by offsets from the start of the file, never pointers, so the file works at
+*     whatever address it is mapped.
+*   - Every array starts on a SCENEFILE_ALIGNMENT boundary, so the mapped streams can be used directly as the
+*     structure of arrays simulation state.
+*   - Every section carries its own checksum.
+* The mapping is copy on write: writes through the stream pointers stay private to the process and only the
+* pages that are written get copied.
+*/
+
+constexpr u32 SCENEFILE_MAGIC = 0x4E435348; // NOTE(sbalse): "HSCN".
+constexpr u32 SCENEFILE_VERSION = 1;
+constexpr u32 SCENEFILE_ALIGNMENT = 64;
+constexpr u32 SCENEFILE_MAX_MESH_NAME_LENGTH = 32;
+
+// NOTE(sbalse): One array of m_ObjectCount elements each. New streams go at the end and bump the version.
+enum class SceneStream : u32
+{
+    DISTANCEFROMCENTER,
+    SELFROTATION,
+    SELFROTATIONSPEED,
+    WORLDROTATION,
+    WORLDROTATIONSPEED,
+    PREVIOUSSELFROTATION,
+    PREVIOUSWORLDROTATION,
+    MESH, // NOTE(sbalse): u32 index into the mesh table, everything else is a float.
+    COUNT
+};
+
+constexpr u32 SCENEFILE_STREAM_COUNT = static_cast<u32>(SceneStream::COUNT);
+
+struct SceneFileSection
+{
+    u64 m_Offset;
+    u64 m_Size; // NOTE(sbalse): In bytes, without the padding up to the next section.
+    u64 m_Checksum;
+};
+
+struct SceneFileHeader
+{
+    u32 m_Magic;
+    u32 m_Version;
+    u64 m_FileSize;
+    u64 m_HeaderChecksum; // NOTE(sbalse): Of the header with this field set to 0.
+    u32 m_ObjectCount;
+    u32 m_MeshCount;
+    SceneFileSection m_Streams[SCENEFILE_STREAM_COUNT];
+    SceneFileSection m_Meshes;
+};
+
+struct SceneFileMesh
+{
+    char m_Name[SCENEFILE_MAX_MESH_NAME_LENGTH];
+};
+
+struct SceneFile
+{
+    SceneFileHeader* m_Header; // NOTE(sbalse): Start of the mapped view.
+    u64 m_Size;
+    void* m_File; // NOTE(sbalse): Platform handles, unused on POSIX.
+    void* m_Mapping;
+};
+
+// NOTE(sbalse): What to write. Every stream points at m_ObjectCount elements.
+struct SceneFileContents
+{
+    u32 m_ObjectCount;
+    const void* m_Streams[SCENEFILE_STREAM_COUNT];
+    const SceneFileMesh* m_Meshes;
+    u32 m_MeshCount;
+};
+
+// NOTE(sbalse): Maps the file and validates the header and every checksum. Verifying touches every page, so
+// this is where the snapshot pages in.
+bool SceneFileOpen(SceneFile* file, const char* path);
+void SceneFileClose(SceneFile* file);
+void* SceneFileGetStream(const SceneFile* file, const SceneStream stream);
+const SceneFileMesh* SceneFileGetMeshes(const SceneFile* file);
+
+// NOTE(sbalse): Streams the sections straight from the given arrays, nothing is copied. Writes to a temporary
+// file first and moves it over path, so a crash never leaves a half written snapshot behind. A snapshot that
+// is still mapped is renamed aside first and keeps being read from there; on failure the old snapshot stays.
+bool SceneFileWrite(const char* path, const SceneFileContents* contents);
+
+// NOTE(sbalse): 64-bit hash in the style of XXH64, several GB/s so verifying costs little next to paging in.
+u64 SceneFileChecksum(const void* data, const u64 size);
@@ -0,0 +1,19 @@
+cbuffer DebugDrawConstantBuffer
+{
+    matrix Projection;
+};
+
+struct VSOut
+{
+    float4 color : Color;
+    float4 pos : SV_Position;
+};
+
+// NOTE(sbalse): Line vertices arrive in view space.
+VSOut main(float3 pos : Position, float4 color : Color)
+{
+    VSOut result;
+    result.pos = mul(float4(pos, 1.0f), Projection);
+    result.color = color;
+    return result;
+}
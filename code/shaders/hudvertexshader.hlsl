@@ -0,0 +1,14 @@
+struct VSOut
+{
+    float4 color : Color;
+    float4 pos : SV_Position;
+};
+
+// NOTE(sbalse): The overlay vertices are already in clip space.
+VSOut main(float2 pos : Position, float4 color : Color)
+{
+    VSOut result;
+    result.pos = float4(pos, 0.0f, 1.0f);
+    result.color = color;
+    return result;
+}
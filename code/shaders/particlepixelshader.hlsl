@@ -0,0 +1,4 @@
+float4 main(float4 color : Color) : SV_TARGET
+{
+    return color;
+}
@@ -0,0 +1,24 @@
+cbuffer ParticleConstantBuffer
+{
+    matrix Projection;
+    float2 HalfSize; // NOTE(sbalse): Half the width and height of a particle quad in world units.
+    float2 Padding;
+};
+
+struct VSOut
+{
+    float4 color : Color;
+    float4 pos : SV_Position;
+};
+
+// NOTE(sbalse): One instance per particle, drawn as a four vertex strip. The corner comes from the vertex id and
+// is offset in view space, so the quad always faces the camera.
+VSOut main(float3 center : Position, float4 color : Color, uint id : SV_VertexID)
+{
+    const float2 corner = float2((id & 1) ? 1.0f : -1.0f, (id & 2) ? -1.0f : 1.0f);
+
+    VSOut result;
+    result.pos = mul(float4(center + float3(corner * HalfSize, 0.0f), 1.0f), Projection);
+    result.color = color;
+    return result;
+}
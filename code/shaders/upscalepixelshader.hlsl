@@ -0,0 +1,13 @@
+Texture2D source : register(t0);
+SamplerState linearClamp : register(s0);
+
+cbuffer UpscaleConstants : register(b0)
+{
+    float2 uvScale; // NOTE(sbalse): Part of the source the scene was rendered into.
+    float2 uvMax; // NOTE(sbalse): Keeps the filter from reading texels outside of that part.
+};
+
+float4 main(float2 uv : TexCoord) : SV_TARGET
+{
+    return source.Sample(linearClamp, min(uv * uvScale, uvMax));
+}
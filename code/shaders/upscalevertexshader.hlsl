@@ -0,0 +1,14 @@
+struct VSOut
+{
+    float2 uv : TexCoord;
+    float4 pos : SV_Position;
+};
+
+// NOTE(sbalse): One triangle that covers the whole target, no vertex buffer needed.
+VSOut main(uint id : SV_VertexID)
+{
+    VSOut result;
+    result.uv = float2((id << 1) & 2, id & 2);
+    result.pos = float4(result.uv * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f), 0.0f, 1.0f);
+    return result;
+}
@@ -4,7 +4,8 @@ cbuffer TransformConstantBuffer
     matrix Transform;
 };
 
-float4 main(float3 pos : POSITION) : SV_Position
+// NOTE(sbalse): The position arrives as R16G16B16A16_SNORM, w is padding.
+float4 main(float4 pos : POSITION) : SV_Position
 {
-    return mul(float4(pos, 1.0f), Transform);
+    return mul(float4(pos.xyz, 1.0f), Transform);
 }
@@ -0,0 +1,407 @@
+#include "simulation.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include "jobs.h"
+#include "random.h"
+#include "rewind.h"
+#include "scenefile.h"
+#include "tweens.h"
+#include "utils.h"
+
+namespace
+{
+    constinit SimulationState g_Simulation = {};
+
+    // NOTE(sbalse): Backing memory of all the arrays in g_Simulation, either allocated or the mapped scene file.
+    constinit float* g_SimulationMemory = nullptr;
+    constinit SceneFile g_SimulationSceneFile = {};
+
+    // NOTE(sbalse): Bounds of all boxes as min x, y, z then max x, y, z, rebuilt for every broadphase update.
+    constinit float* g_SimulationBoundsMemory = nullptr;
+    constinit Broadphase* g_SimulationBroadphase = nullptr;
+
+    // NOTE(sbalse): Every box turns with two looping tweens, one per rotation. They target the rotation arrays.
+    constinit TweenPool* g_SimulationTweens = nullptr;
+    constexpr u32 SIMULATION_SELF_ROTATION_STREAM = 0;
+    constexpr u32 SIMULATION_WORLD_ROTATION_STREAM = 1;
+    constexpr float SIMULATION_FULL_TURN = 3.14159265f * 2.0f;
+
+    // NOTE(sbalse): While recording, every step is snapshotted so the simulation can be rewound. Steps only write
+    // the tween phases and the rotations, and the rotations are what the tweens give at their phases, so only the
+    // phases are recorded. Every box still moves every step, every snapshot compares and compresses all of them.
+    // Input isn't recorded either, no step reads it. Recording is off until asked for, the history only exists while
+    // it's on.
+    constexpr u64 SIMULATION_REWIND_BUDGET = 64ull * 1024 * 1024;
+    constinit Rewind* g_SimulationRewind = nullptr;
+    constinit u64 g_SimulationStep = 0;
+
+    // NOTE(sbalse): Every box is a cube for now.
+    constexpr SceneFileMesh g_SimulationMeshes[] =
+    {
+        { .m_Name = "CUBE" },
+    };
+
+    // NOTE(sbalse): Number of arrays in SimulationState, all of them 4 bytes per element.
+    constexpr u32 SIMULATION_STREAM_COUNT = SCENEFILE_STREAM_COUNT;
+
+    // NOTE(sbalse): Every box is a pure function of this seed and its index, so the scene is the same on every
+    // run and platform, however the work is split.
+    constexpr u64 SIMULATION_SCENE_SEED = 0x68773364;
+    constexpr u32 SIMULATION_POPULATE_BATCH_SIZE = 16384;
+    constexpr u32 SIMULATION_BOUNDS_BATCH_SIZE = 16384;
+
+    // NOTE(sbalse): Boxes are unit cubes around their center, this bounds them at any rotation.
+    constexpr float SIMULATION_BOX_HALF_EXTENT = 1.7321f;
+    // NOTE(sbalse): Must match the world offset the boxes are rendered at.
+    constexpr float SIMULATION_WORLD_OFFSET_Z = 20.0f;
+
+    void PopulateBoxRange(void* context, const u32 begin, const u32 end)
+    {
+        SimulationState* state = static_cast<SimulationState*>(context);
+
+        // NOTE(sbalse): Speeds used to be applied once per frame at 60Hz, they are now per second.
+        constexpr RandomInterval intervals[4] =
+        {
+            { .m_Min = 6.0f, .m_Max = 20.0f },
+            { .m_Min = 0.0f, .m_Max = 3.1415f * 2.0f },
+            { .m_Min = 0.6f, .m_Max = 2.4f },
+            { .m_Min = 0.06f, .m_Max = 0.3f },
+        };
+        float* const outputs[4] =
+        {
+            state->m_DistanceFromCenter + begin,
+            state->m_WorldRotation + begin,
+            state->m_SelfRotationSpeed + begin,
+            state->m_WorldRotationSpeed + begin,
+        };
+        RandomFillFloats(SIMULATION_SCENE_SEED, begin, end - begin, intervals, outputs);
+
+        const size_t size = (end - begin) * sizeof(float);
+        std::memset(state->m_SelfRotation + begin, 0, size);
+        std::memset(state->m_PreviousSelfRotation + begin, 0, size);
+        std::memcpy(state->m_PreviousWorldRotation + begin, state->m_WorldRotation + begin, size);
+        std::memset(state->m_Mesh + begin, 0, size);
+    }
+
+    void PopulateBoxes(SimulationState* state)
+    {
+        JobsWait(JobsDispatch(state->m_Count, SIMULATION_POPULATE_BATCH_SIZE, PopulateBoxRange, state));
+    }
+
+    // NOTE(sbalse): Same transform as the renderer: out along x by the distance, then rolled, pitched and yawed
+    // by the world rotation and moved by the world offset.
+    void ComputeBoundsRange(void* context, const u32 begin, const u32 end)
+    {
+        const SimulationState* state = static_cast<const SimulationState*>(context);
+        const size_t count = state->m_Count;
+
+        for (u32 i = begin; i < end; i++)
+        {
+            const float distance = state->m_DistanceFromCenter[i];
+            const float c = std::cos(state->m_WorldRotation[i]);
+            const float s = std::sin(state->m_WorldRotation[i]);
+            const float center[3] =
+            {
+                distance * ((c * c) + (s * s * s)),
+                distance * s * c,
+                (distance * ((s * s * c) - (c * s))) + SIMULATION_WORLD_OFFSET_Z,
+            };
+            for (u32 axis = 0; axis < 3; axis++)
+            {
+                g_SimulationBoundsMemory[(axis * count) + i] = center[axis] - SIMULATION_BOX_HALF_EXTENT;
+                g_SimulationBoundsMemory[((axis + 3) * count) + i] = center[axis] + SIMULATION_BOX_HALF_EXTENT;
+            }
+        }
+    }
+
+    bool SimulationCreateBroadphase(const u32 boxCount)
+    {
+        g_SimulationBoundsMemory = static_cast<float*>(std::calloc(static_cast<size_t>(boxCount) * 6, sizeof(float)));
+        g_SimulationBroadphase = BroadphaseCreate(boxCount);
+        return g_SimulationBoundsMemory && g_SimulationBroadphase;
+    }
+
+    // NOTE(sbalse): One full turn per loop, starting from the current rotation. The rotation wraps around after
+    // every turn instead of growing without bound and losing precision.
+    bool SimulationAddRotationTweens(const float* rotations, const float* speeds, const u32 count, const u32 stream)
+    {
+        for (u32 i = 0; i < count; i++)
+        {
+            // NOTE(sbalse): A box that doesn't turn still gets a tween, one that takes forever.
+            const float speed = speeds[i] > 0.0f ? speeds[i] : 1e-6f;
+            const TweenDesc desc =
+            {
+                .m_From = rotations[i],
+                .m_Delta = SIMULATION_FULL_TURN,
+                .m_Duration = SIMULATION_FULL_TURN / speed,
+                .m_Offset = 0.0f,
+                .m_Curve = TweenEaseCurve(TweenEase::LINEAR),
+                .m_Wrap = TweenWrap::LOOP,
+                .m_Stream = stream,
+                .m_Index = i,
+            };
+            if (TweenAdd(g_SimulationTweens, &desc) == TWEENS_INVALID_HANDLE)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool SimulationCreateTweens(const SimulationState* state)
+    {
+        g_SimulationTweens = TweenPoolCreate(state->m_Count * 2);
+        return g_SimulationTweens
+            && SimulationAddRotationTweens(
+                state->m_SelfRotation, state->m_SelfRotationSpeed, state->m_Count, SIMULATION_SELF_ROTATION_STREAM)
+            && SimulationAddRotationTweens(
+                state->m_WorldRotation, state->m_WorldRotationSpeed, state->m_Count, SIMULATION_WORLD_ROTATION_STREAM);
+    }
+
+    bool SimulationCreateRewind()
+    {
+        const RewindRegion regions[] =
+        {
+            {
+                .m_Data = TweenPoolGetPhases(g_SimulationTweens),
+                .m_Size = TweenPoolGetCount(g_SimulationTweens) * sizeof(float),
+                .m_Tracked = false,
+            },
+        };
+        const RewindDesc desc =
+        {
+            .m_Regions = regions,
+            .m_RegionCount = static_cast<u32>(ArraySize(regions)),
+            .m_Budget = SIMULATION_REWIND_BUDGET,
+        };
+        g_SimulationRewind = RewindCreate(&desc, g_SimulationStep);
+        return g_SimulationRewind != nullptr;
+    }
+
+    // NOTE(sbalse): Points the arrays straight into the mapping, the pages are copied on first write.
+    bool SimulationLoadScene(const char* path, const u32 boxCount)
+    {
+        SceneFile* file = &g_SimulationSceneFile;
+        if (!SceneFileOpen(file, path))
+        {
+            return false;
+        }
+
+        if (file->m_Header->m_ObjectCount != boxCount || file->m_Header->m_MeshCount != ArraySize(g_SimulationMeshes))
+        {
+            SceneFileClose(file);
+            return false;
+        }
+
+        g_Simulation.m_Count = boxCount;
+        g_Simulation.m_DistanceFromCenter =
+            static_cast<float*>(SceneFileGetStream(file, SceneStream::DISTANCEFROMCENTER));
+        g_Simulation.m_SelfRotation = static_cast<float*>(SceneFileGetStream(file, SceneStream::SELFROTATION));
+        g_Simulation.m_SelfRotationSpeed =
+            static_cast<float*>(SceneFileGetStream(file, SceneStream::SELFROTATIONSPEED));
+        g_Simulation.m_WorldRotation = static_cast<float*>(SceneFileGetStream(file, SceneStream::WORLDROTATION));
+        g_Simulation.m_WorldRotationSpeed =
+            static_cast<float*>(SceneFileGetStream(file, SceneStream::WORLDROTATIONSPEED));
+        g_Simulation.m_PreviousSelfRotation =
+            static_cast<float*>(SceneFileGetStream(file, SceneStream::PREVIOUSSELFROTATION));
+        g_Simulation.m_PreviousWorldRotation =
+            static_cast<float*>(SceneFileGetStream(file, SceneStream::PREVIOUSWORLDROTATION));
+        g_Simulation.m_Mesh = static_cast<u32*>(SceneFileGetStream(file, SceneStream::MESH));
+
+        return true;
+    }
+
+    bool SimulationGenerateScene(const u32 boxCount)
+    {
+        g_SimulationMemory = static_cast<float*>(
+            std::calloc(static_cast<size_t>(boxCount) * SIMULATION_STREAM_COUNT, sizeof(float)));
+        if (!g_SimulationMemory)
+        {
+            return false;
+        }
+
+        g_Simulation.m_Count = boxCount;
+        g_Simulation.m_DistanceFromCenter = g_SimulationMemory;
+        g_Simulation.m_SelfRotation = g_Simulation.m_DistanceFromCenter + boxCount;
+        g_Simulation.m_SelfRotationSpeed = g_Simulation.m_SelfRotation + boxCount;
+        g_Simulation.m_WorldRotation = g_Simulation.m_SelfRotationSpeed + boxCount;
+        g_Simulation.m_WorldRotationSpeed = g_Simulation.m_WorldRotation + boxCount;
+        g_Simulation.m_PreviousSelfRotation = g_Simulation.m_WorldRotationSpeed + boxCount;
+        g_Simulation.m_PreviousWorldRotation = g_Simulation.m_PreviousSelfRotation + boxCount;
+        g_Simulation.m_Mesh = reinterpret_cast<u32*>(g_Simulation.m_PreviousWorldRotation + boxCount);
+
+        PopulateBoxes(&g_Simulation);
+
+        return true;
+    }
+}
+
+bool SimulationInit(const u32 boxCount, const char* scenePath)
+{
+    if (!SimulationCreateBroadphase(boxCount))
+    {
+        return false;
+    }
+
+    if (SimulationLoadScene(scenePath, boxCount))
+    {
+        return SimulationCreateTweens(&g_Simulation);
+    }
+
+    if (!SimulationGenerateScene(boxCount))
+    {
+        return false;
+    }
+
+    // NOTE(sbalse): Failing to write only costs the next start its fast path.
+    SimulationSaveScene(scenePath);
+
+    return SimulationCreateTweens(&g_Simulation);
+}
+
+void SimulationDestroy()
+{
+    SceneFileClose(&g_SimulationSceneFile);
+    std::free(g_SimulationMemory);
+    g_SimulationMemory = nullptr;
+    BroadphaseDestroy(g_SimulationBroadphase);
+    g_SimulationBroadphase = nullptr;
+    std::free(g_SimulationBoundsMemory);
+    g_SimulationBoundsMemory = nullptr;
+    TweenPoolDestroy(g_SimulationTweens);
+    g_SimulationTweens = nullptr;
+    if (g_SimulationRewind)
+    {
+        RewindDestroy(g_SimulationRewind);
+        g_SimulationRewind = nullptr;
+    }
+    g_SimulationStep = 0;
+    g_Simulation = {};
+}
+
+bool SimulationSaveScene(const char* path)
+{
+    const SimulationState* state = &g_Simulation;
+    const SceneFileContents contents =
+    {
+        .m_ObjectCount = state->m_Count,
+        .m_Streams =
+        {
+            state->m_DistanceFromCenter,
+            state->m_SelfRotation,
+            state->m_SelfRotationSpeed,
+            state->m_WorldRotation,
+            state->m_WorldRotationSpeed,
+            state->m_PreviousSelfRotation,
+            state->m_PreviousWorldRotation,
+            state->m_Mesh,
+        },
+        .m_Meshes = g_SimulationMeshes,
+        .m_MeshCount = static_cast<u32>(ArraySize(g_SimulationMeshes)),
+    };
+    return SceneFileWrite(path, &contents);
+}
+
+SimulationState* SimulationGetState()
+{
+    return &g_Simulation;
+}
+
+void SimulationStep(const float stepSeconds)
+{
+    SimulationState* state = &g_Simulation;
+
+    const size_t size = state->m_Count * sizeof(float);
+    std::memcpy(state->m_PreviousSelfRotation, state->m_SelfRotation, size);
+    std::memcpy(state->m_PreviousWorldRotation, state->m_WorldRotation, size);
+
+    float* const outputs[2] = { state->m_SelfRotation, state->m_WorldRotation };
+    TweenPoolUpdate(g_SimulationTweens, stepSeconds, outputs);
+
+    // NOTE(sbalse): Too big a step for the budget only costs the history before it.
+    g_SimulationStep++;
+    if (g_SimulationRewind)
+    {
+        RewindCapture(g_SimulationRewind, g_SimulationStep);
+    }
+}
+
+bool SimulationSetRewindRecording(const bool recording)
+{
+    if (recording && !g_SimulationRewind)
+    {
+        return SimulationCreateRewind();
+    }
+
+    if (!recording && g_SimulationRewind)
+    {
+        RewindDestroy(g_SimulationRewind);
+        g_SimulationRewind = nullptr;
+    }
+    return true;
+}
+
+bool SimulationIsRewindRecording()
+{
+    return g_SimulationRewind != nullptr;
+}
+
+u32 SimulationRewind(const u32 steps)
+{
+    if (!g_SimulationRewind)
+    {
+        return 0;
+    }
+
+    const RewindStats stats = RewindGetStats(g_SimulationRewind);
+    const u64 held = stats.m_NewestStep - stats.m_OldestStep;
+    const u64 target = stats.m_NewestStep - (steps < held ? steps : held);
+    if (!RewindRestore(g_SimulationRewind, target))
+    {
+        return 0;
+    }
+
+    // NOTE(sbalse): A step of no time leaves the wrapped phases as they are and writes the rotations at them, the
+    // same ones the restored step wrote. There is no step before it to blend from, the previous rotations start
+    // out the same.
+    SimulationState* state = &g_Simulation;
+    float* const outputs[2] = { state->m_SelfRotation, state->m_WorldRotation };
+    TweenPoolUpdate(g_SimulationTweens, 0.0f, outputs);
+    const size_t size = state->m_Count * sizeof(float);
+    std::memcpy(state->m_PreviousSelfRotation, state->m_SelfRotation, size);
+    std::memcpy(state->m_PreviousWorldRotation, state->m_WorldRotation, size);
+    g_SimulationStep = target;
+    return static_cast<u32>(stats.m_NewestStep - target);
+}
+
+u32 SimulationFindOverlaps()
+{
+    SimulationState* state = &g_Simulation;
+    const u32 count = state->m_Count;
+    JobsWait(JobsDispatch(count, SIMULATION_BOUNDS_BATCH_SIZE, ComputeBoundsRange, state));
+
+    const BroadphaseBounds bounds =
+    {
+        .m_Min =
+        {
+            g_SimulationBoundsMemory,
+            g_SimulationBoundsMemory + count,
+            g_SimulationBoundsMemory + (static_cast<size_t>(count) * 2),
+        },
+        .m_Max =
+        {
+            g_SimulationBoundsMemory + (static_cast<size_t>(count) * 3),
+            g_SimulationBoundsMemory + (static_cast<size_t>(count) * 4),
+            g_SimulationBoundsMemory + (static_cast<size_t>(count) * 5),
+        },
+    };
+    return BroadphaseUpdate(g_SimulationBroadphase, &bounds, count);
+}
+
+const BroadphasePair* SimulationGetOverlaps(u32* count)
+{
+    return BroadphaseGetPairs(g_SimulationBroadphase, count);
+}
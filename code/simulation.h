@@ -0,0 +1,44 @@
+#pragma once
+#include "types.h"
+#include "broadphase.h"
+
+// NOTE(sbalse): Simulation state of all boxes, stored as structure of arrays.
+struct SimulationState
+{
+    u32 m_Count;
+    float* m_DistanceFromCenter;
+    // NOTE(sbalse): Rotations are applied equally as pitch, yaw and roll. Speeds are in radians per second. The
+    // rotations are driven by tweens and wrap around after every full turn.
+    float* m_SelfRotation;
+    float* m_SelfRotationSpeed;
+    float* m_WorldRotation;
+    float* m_WorldRotationSpeed;
+    // NOTE(sbalse): State before the last step, so rendering can interpolate between steps.
+    float* m_PreviousSelfRotation;
+    float* m_PreviousWorldRotation;
+    u32* m_Mesh; // NOTE(sbalse): Index into the mesh table of the scene file.
+};
+
+// NOTE(sbalse): Maps the scene snapshot at scenePath and simulates straight out of the mapping when it holds
+// boxCount boxes. Otherwise generates a new scene and writes it to scenePath, so the next start is instant.
+bool SimulationInit(const u32 boxCount, const char* scenePath);
+void SimulationDestroy();
+// NOTE(sbalse): Snapshots the current state. Must not run concurrently with SimulationStep().
+bool SimulationSaveScene(const char* path);
+SimulationState* SimulationGetState();
+// NOTE(sbalse): Advances the simulation by one fixed step of stepSeconds.
+void SimulationStep(const float stepSeconds);
+// NOTE(sbalse): Starts or stops recording the history that rewinding goes back through, it is off at init. Starting
+// takes the first snapshot and returns false when out of memory. Stopping forgets the history. Must not run
+// concurrently with SimulationStep().
+bool SimulationSetRewindRecording(const bool recording);
+bool SimulationIsRewindRecording();
+// NOTE(sbalse): Takes the simulation back by steps steps, or as far as its history goes. Returns the number of steps
+// it went back, 0 when the history was damaged and it stayed where it was. Must not run concurrently with
+// SimulationStep().
+u32 SimulationRewind(const u32 steps);
+// NOTE(sbalse): Finds the boxes whose bounds overlap at the current state with the broadphase. Returns the number
+// of pairs. Must not run concurrently with SimulationStep().
+u32 SimulationFindOverlaps();
+// NOTE(sbalse): Pairs of the last SimulationFindOverlaps(), valid until the next one.
+const BroadphasePair* SimulationGetOverlaps(u32* count);
@@ -0,0 +1,134 @@
+#include "stats.h"
+
+#include <atomic>
+
+#include "clock.h"
+#include "histogram.h"
+
+namespace
+{
+    // NOTE(sbalse): All histograms record microseconds.
+    constinit Histogram s_FrameTimes = {};
+    constinit Histogram s_StageTimes[NUMSTATSSTAGES] = {};
+    constinit Histogram s_PipelineLatencies = {};
+
+    constinit i64 s_FrameStart = 0;
+    constinit i64 s_StageStarts[NUMSTATSSTAGES] = {};
+    constinit std::atomic<i64> s_StageTicks[NUMSTATSSTAGES] = {}; // NOTE(sbalse): Accumulated this frame.
+    constinit std::atomic<u64> s_Counters[NUMSTATSCOUNTERS] = {}; // NOTE(sbalse): Accumulated this frame.
+
+    constinit StatsSummary s_Summary = {};
+
+    constexpr const char* g_StageNames[NUMSTATSSTAGES] =
+    {
+        "MSG",
+        "LOGIC",
+        "SIM",
+        "UPDATE",
+        "DRAW",
+        "PRESENT",
+        "DEFER",
+        "PACE",
+    };
+
+    u32 TicksToMicroseconds(const i64 ticks)
+    {
+        const double microseconds = ClockTicksToSeconds(ticks) * 1'000'000.0;
+        return microseconds >= 4294967295.0 ? 0xFFFFFFFFu : static_cast<u32>(microseconds);
+    }
+
+    float MicrosecondsToMilliseconds(const u32 microseconds)
+    {
+        return static_cast<float>(microseconds) / 1000.0f;
+    }
+}
+
+void StatsInit()
+{
+    HistogramReset(&s_FrameTimes);
+    HistogramReset(&s_PipelineLatencies);
+    for (u32 i = 0; i < NUMSTATSSTAGES; i++)
+    {
+        HistogramReset(&s_StageTimes[i]);
+        s_StageTicks[i].store(0, std::memory_order_relaxed);
+    }
+    for (u32 i = 0; i < NUMSTATSCOUNTERS; i++)
+    {
+        s_Counters[i].store(0, std::memory_order_relaxed);
+    }
+    s_Summary = {};
+    s_FrameStart = 0;
+}
+
+void StatsBeginFrame()
+{
+    const i64 now = ClockNow();
+
+    // NOTE(sbalse): The very first frame has nothing to close.
+    if (s_FrameStart != 0)
+    {
+        HistogramRecord(&s_FrameTimes, TicksToMicroseconds(now - s_FrameStart));
+
+        s_Summary.m_FrameIndex++;
+        s_Summary.m_FrameTimeMs = MicrosecondsToMilliseconds(HistogramLast(&s_FrameTimes));
+        s_Summary.m_FrameTimeMeanMs = MicrosecondsToMilliseconds(HistogramMean(&s_FrameTimes));
+        s_Summary.m_FrameTimeP50Ms = MicrosecondsToMilliseconds(HistogramPercentile(&s_FrameTimes, 0.5f));
+        s_Summary.m_FrameTimeP99Ms = MicrosecondsToMilliseconds(HistogramPercentile(&s_FrameTimes, 0.99f));
+
+        for (u32 i = 0; i < NUMSTATSSTAGES; i++)
+        {
+            const i64 stageTicks = s_StageTicks[i].exchange(0, std::memory_order_relaxed);
+            HistogramRecord(&s_StageTimes[i], TicksToMicroseconds(stageTicks));
+            s_Summary.m_StageTimeMs[i] = MicrosecondsToMilliseconds(HistogramLast(&s_StageTimes[i]));
+            s_Summary.m_StageTimeMeanMs[i] = MicrosecondsToMilliseconds(HistogramMean(&s_StageTimes[i]));
+        }
+
+        for (u32 i = 0; i < NUMSTATSCOUNTERS; i++)
+        {
+            s_Summary.m_Counters[i] = s_Counters[i].exchange(0, std::memory_order_relaxed);
+        }
+
+        s_Summary.m_PipelineLatencyMeanMs = MicrosecondsToMilliseconds(HistogramMean(&s_PipelineLatencies));
+        s_Summary.m_PipelineLatencyP99Ms =
+            MicrosecondsToMilliseconds(HistogramPercentile(&s_PipelineLatencies, 0.99f));
+    }
+
+    s_FrameStart = now;
+}
+
+void StatsBeginStage(const StatsStage stage)
+{
+    s_StageStarts[static_cast<u32>(stage)] = ClockNow();
+}
+
+void StatsEndStage(const StatsStage stage)
+{
+    const u32 stageIndex = static_cast<u32>(stage);
+    s_StageTicks[stageIndex].fetch_add(ClockNow() - s_StageStarts[stageIndex], std::memory_order_relaxed);
+}
+
+void StatsAddCounter(const StatsCounter counter, const u64 amount)
+{
+    s_Counters[static_cast<u32>(counter)].fetch_add(amount, std::memory_order_relaxed);
+}
+
+void StatsRecordPipelineLatency(const i64 ticks)
+{
+    // NOTE(sbalse): Only called from the render side, which also owns the summary.
+    HistogramRecord(&s_PipelineLatencies, TicksToMicroseconds(ticks));
+}
+
+const StatsSummary* StatsGetSummary()
+{
+    return &s_Summary;
+}
+
+const Histogram* StatsGetFrameTimeHistogram()
+{
+    return &s_FrameTimes;
+}
+
+const char* StatsStageName(const StatsStage stage)
+{
+    return g_StageNames[static_cast<u32>(stage)];
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "types.h"
+
+struct Histogram;
+
+enum class StatsStage
+{
+    MESSAGES,
+    GAMELOGIC,
+    SIMULATE, // NOTE(sbalse): Runs on the simulation thread when the frame pipeline is threaded.
+    UPDATE,
+    DRAW,
+    PRESENT,
+    DEFERRED, // NOTE(sbalse): Deferred work run in the time left before the next frame.
+    PACE, // NOTE(sbalse): Time the frame pacer spent waiting for the next frame.
+    COUNT
+};
+
+enum class StatsCounter
+{
+    DRAWCALLS,
+    VISIBLEOBJECTS,
+    BYTESUPLOADED,
+    SIMSTEPS,
+    SIMSTEPSDROPPED, // NOTE(sbalse): Fixed steps skipped because the simulation fell too far behind.
+    PARTICLES,
+    OVERLAPS, // NOTE(sbalse): Pairs of boxes the broadphase found overlapping.
+    CAPTUREDROPPED, // NOTE(sbalse): Frames a running frame capture had no free slot for.
+    COUNT
+};
+
+constexpr u32 NUMSTATSSTAGES = static_cast<u32>(StatsStage::COUNT);
+constexpr u32 NUMSTATSCOUNTERS = static_cast<u32>(StatsCounter::COUNT);
+
+/*
+* NOTE(sbalse): A stage is only ever timed from one thread, but different stages may be timed from different
+* threads at the same time. Stage times and counters are accumulated with relaxed atomics, so recording is
+* still lock free.
+*/
+
+// NOTE(sbalse): Numbers of the last completed frame together with rolling values over recent frames.
+struct StatsSummary
+{
+    u64 m_FrameIndex;
+    float m_FrameTimeMs;
+    float m_FrameTimeMeanMs;
+    float m_FrameTimeP50Ms;
+    float m_FrameTimeP99Ms;
+    float m_StageTimeMs[NUMSTATSSTAGES];
+    float m_StageTimeMeanMs[NUMSTATSSTAGES];
+    // NOTE(sbalse): Time between the simulation finishing a snapshot and the render side picking it up.
+    float m_PipelineLatencyMeanMs;
+    float m_PipelineLatencyP99Ms;
+    u64 m_Counters[NUMSTATSCOUNTERS];
+};
+
+void StatsInit();
+// NOTE(sbalse): Marks the start of a new frame and closes the previous one.
+void StatsBeginFrame();
+void StatsBeginStage(const StatsStage stage);
+void StatsEndStage(const StatsStage stage);
+void StatsAddCounter(const StatsCounter counter, const u64 amount);
+void StatsRecordPipelineLatency(const i64 ticks);
+const StatsSummary* StatsGetSummary();
+const Histogram* StatsGetFrameTimeHistogram();
+const char* StatsStageName(const StatsStage stage);
@@ -0,0 +1,363 @@
+#include "taskgraph.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+
+#include "clock.h"
+#include "jobs.h"
+
+namespace
+{
+    struct TaskGraphTask
+    {
+        const char* m_Name;
+        TaskFunction m_Function;
+        void* m_Context;
+        TaskAffinity m_Affinity;
+        u32 m_Dependencies[TASKGRAPH_MAX_DEPENDENCIES];
+        u32 m_DependencyCount;
+    };
+
+    // NOTE(sbalse): What a job needs to find its task again.
+    struct TaskGraphJob
+    {
+        TaskGraph* m_Graph;
+        u32 m_Task;
+    };
+}
+
+struct TaskGraph
+{
+    TaskGraphTask m_Tasks[TASKGRAPH_MAX_TASKS];
+    u32 m_TaskCount;
+
+    // NOTE(sbalse): Reverse edges, built when the graph runs.
+    u32 m_Dependents[TASKGRAPH_MAX_TASKS][TASKGRAPH_MAX_TASKS];
+    u32 m_DependentCount[TASKGRAPH_MAX_TASKS];
+
+    TaskGraphJob m_Jobs[TASKGRAPH_MAX_TASKS];
+    TaskTiming m_Timings[TASKGRAPH_MAX_TASKS];
+    std::atomic<u32> m_PendingDependencies[TASKGRAPH_MAX_TASKS];
+
+    // NOTE(sbalse): Guards everything below.
+    std::mutex m_Mutex;
+    std::condition_variable m_Changed;
+    u32 m_MainReady[TASKGRAPH_MAX_TASKS];
+    u32 m_MainReadyCount;
+    u32 m_Remaining;
+};
+
+namespace
+{
+    void TaskGraphSchedule(TaskGraph* graph, const u32 task);
+
+    void TaskGraphExecute(TaskGraph* graph, const u32 task)
+    {
+        const TaskGraphTask* record = &graph->m_Tasks[task];
+        TaskTiming* timing = &graph->m_Timings[task];
+
+        bool dependenciesSucceeded = true;
+        for (u32 i = 0; i < record->m_DependencyCount; i++)
+        {
+            dependenciesSucceeded = dependenciesSucceeded && graph->m_Timings[record->m_Dependencies[i]].m_Succeeded;
+        }
+
+        timing->m_Thread = JobsThreadIndex();
+        timing->m_Start = ClockNow();
+        timing->m_Ran = dependenciesSucceeded;
+        timing->m_Succeeded = dependenciesSucceeded && record->m_Function(record->m_Context);
+        timing->m_End = ClockNow();
+
+        // NOTE(sbalse): The release pairs with the acquire of whoever takes the count to zero, which then sees
+        // the timing written above.
+        for (u32 i = 0; i < graph->m_DependentCount[task]; i++)
+        {
+            const u32 dependent = graph->m_Dependents[task][i];
+            if (graph->m_PendingDependencies[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                TaskGraphSchedule(graph, dependent);
+            }
+        }
+
+        // NOTE(sbalse): Notify under the lock, the graph may be gone as soon as the main thread sees the last
+        // task finish.
+        std::lock_guard<std::mutex> lock(graph->m_Mutex);
+        graph->m_Remaining--;
+        graph->m_Changed.notify_all();
+    }
+
+    void TaskGraphRunJob(void* context, const u32 /*begin*/, const u32 /*end*/)
+    {
+        const TaskGraphJob* job = static_cast<const TaskGraphJob*>(context);
+        TaskGraphExecute(job->m_Graph, job->m_Task);
+    }
+
+    void TaskGraphSchedule(TaskGraph* graph, const u32 task)
+    {
+        if (graph->m_Tasks[task].m_Affinity == TaskAffinity::MAIN)
+        {
+            {
+                std::lock_guard<std::mutex> lock(graph->m_Mutex);
+                graph->m_MainReady[graph->m_MainReadyCount++] = task;
+            }
+            graph->m_Changed.notify_all();
+            return;
+        }
+
+        // NOTE(sbalse): Nobody waits on the handle, the graph tracks completion itself.
+        graph->m_Jobs[task] = { .m_Graph = graph, .m_Task = task };
+        JobsDispatch(1, 1, TaskGraphRunJob, &graph->m_Jobs[task]);
+    }
+}
+
+TaskGraph* TaskGraphCreate()
+{
+    return new TaskGraph();
+}
+
+void TaskGraphDestroy(TaskGraph* graph)
+{
+    delete graph;
+}
+
+u32 TaskGraphAdd(
+    TaskGraph* graph,
+    const char* name,
+    const TaskFunction function,
+    void* context,
+    const TaskAffinity affinity,
+    const u32* dependencies,
+    const u32 dependencyCount)
+{
+    if (graph->m_TaskCount >= TASKGRAPH_MAX_TASKS || dependencyCount > TASKGRAPH_MAX_DEPENDENCIES)
+    {
+        return TASKGRAPH_INVALID_TASK;
+    }
+
+    TaskGraphTask* task = &graph->m_Tasks[graph->m_TaskCount];
+    *task =
+    {
+        .m_Name = name,
+        .m_Function = function,
+        .m_Context = context,
+        .m_Affinity = affinity,
+        .m_Dependencies = {},
+        .m_DependencyCount = dependencyCount,
+    };
+
+    for (u32 i = 0; i < dependencyCount; i++)
+    {
+        // NOTE(sbalse): Only tasks that already exist can be depended on, which is what rules out cycles.
+        if (dependencies[i] >= graph->m_TaskCount)
+        {
+            return TASKGRAPH_INVALID_TASK;
+        }
+        task->m_Dependencies[i] = dependencies[i];
+    }
+
+    return graph->m_TaskCount++;
+}
+
+bool TaskGraphRun(TaskGraph* graph)
+{
+    const u32 taskCount = graph->m_TaskCount;
+
+    for (u32 task = 0; task < taskCount; task++)
+    {
+        graph->m_DependentCount[task] = 0;
+        graph->m_Timings[task] = {};
+    }
+    for (u32 task = 0; task < taskCount; task++)
+    {
+        const TaskGraphTask* record = &graph->m_Tasks[task];
+        for (u32 i = 0; i < record->m_DependencyCount; i++)
+        {
+            const u32 dependency = record->m_Dependencies[i];
+            graph->m_Dependents[dependency][graph->m_DependentCount[dependency]++] = task;
+        }
+        graph->m_PendingDependencies[task].store(record->m_DependencyCount, std::memory_order_relaxed);
+    }
+
+    graph->m_MainReadyCount = 0;
+    graph->m_Remaining = taskCount;
+
+    for (u32 task = 0; task < taskCount; task++)
+    {
+        if (graph->m_Tasks[task].m_DependencyCount == 0)
+        {
+            TaskGraphSchedule(graph, task);
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(graph->m_Mutex);
+    while (graph->m_Remaining > 0)
+    {
+        if (graph->m_MainReadyCount == 0)
+        {
+            graph->m_Changed.wait(lock);
+            continue;
+        }
+
+        // NOTE(sbalse): Take the earliest added task, which tends to be the one more work is waiting for.
+        u32 next = 0;
+        for (u32 i = 1; i < graph->m_MainReadyCount; i++)
+        {
+            if (graph->m_MainReady[i] < graph->m_MainReady[next])
+            {
+                next = i;
+            }
+        }
+        const u32 task = graph->m_MainReady[next];
+        graph->m_MainReady[next] = graph->m_MainReady[--graph->m_MainReadyCount];
+
+        lock.unlock();
+        TaskGraphExecute(graph, task);
+        lock.lock();
+    }
+
+    bool succeeded = true;
+    for (u32 task = 0; task < taskCount; task++)
+    {
+        succeeded = succeeded && graph->m_Timings[task].m_Succeeded;
+    }
+    return succeeded;
+}
+
+u32 TaskGraphTaskCount(const TaskGraph* graph)
+{
+    return graph->m_TaskCount;
+}
+
+const char* TaskGraphTaskName(const TaskGraph* graph, const u32 task)
+{
+    return graph->m_Tasks[task].m_Name;
+}
+
+const TaskTiming* TaskGraphTaskTiming(const TaskGraph* graph, const u32 task)
+{
+    return &graph->m_Timings[task];
+}
+
+u32 TaskGraphCriticalPath(const TaskGraph* graph, u32* tasks, const u32 maxTasks)
+{
+    const u32 taskCount = graph->m_TaskCount;
+    if (taskCount == 0)
+    {
+        return 0;
+    }
+
+    // NOTE(sbalse): Longest chain by measured duration. The order tasks were added in is topological, so every
+    // dependency is final by the time a task looks at it.
+    i64 pathTicks[TASKGRAPH_MAX_TASKS] = {};
+    u32 previous[TASKGRAPH_MAX_TASKS] = {};
+    u32 last = 0;
+    for (u32 task = 0; task < taskCount; task++)
+    {
+        const TaskGraphTask* record = &graph->m_Tasks[task];
+        i64 longest = 0;
+        previous[task] = TASKGRAPH_INVALID_TASK;
+        for (u32 i = 0; i < record->m_DependencyCount; i++)
+        {
+            const u32 dependency = record->m_Dependencies[i];
+            if (pathTicks[dependency] > longest || previous[task] == TASKGRAPH_INVALID_TASK)
+            {
+                longest = pathTicks[dependency];
+                previous[task] = dependency;
+            }
+        }
+
+        const TaskTiming* timing = &graph->m_Timings[task];
+        pathTicks[task] = longest + (timing->m_End - timing->m_Start);
+        if (pathTicks[task] > pathTicks[last])
+        {
+            last = task;
+        }
+    }
+
+    u32 count = 0;
+    for (u32 task = last; task != TASKGRAPH_INVALID_TASK; task = previous[task])
+    {
+        count++;
+    }
+
+    // NOTE(sbalse): Walk back from the end, filling the output from the back.
+    u32 index = count;
+    for (u32 task = last; task != TASKGRAPH_INVALID_TASK; task = previous[task])
+    {
+        index--;
+        if (index < maxTasks)
+        {
+            tasks[index] = task;
+        }
+    }
+
+    return count;
+}
+
+void TaskGraphReport(const TaskGraph* graph, char* buffer, const u32 bufferSize)
+{
+    const u32 taskCount = graph->m_TaskCount;
+    if (bufferSize == 0)
+    {
+        return;
+    }
+    buffer[0] = '\0';
+    if (taskCount == 0)
+    {
+        return;
+    }
+
+    bool critical[TASKGRAPH_MAX_TASKS] = {};
+    u32 path[TASKGRAPH_MAX_TASKS] = {};
+    const u32 pathCount = TaskGraphCriticalPath(graph, path, TASKGRAPH_MAX_TASKS);
+    i64 criticalTicks = 0;
+    for (u32 i = 0; i < pathCount; i++)
+    {
+        critical[path[i]] = true;
+        criticalTicks += graph->m_Timings[path[i]].m_End - graph->m_Timings[path[i]].m_Start;
+    }
+
+    i64 begin = graph->m_Timings[0].m_Start;
+    i64 end = graph->m_Timings[0].m_End;
+    i64 serialTicks = 0;
+    for (u32 task = 0; task < taskCount; task++)
+    {
+        const TaskTiming* timing = &graph->m_Timings[task];
+        begin = timing->m_Start < begin ? timing->m_Start : begin;
+        end = timing->m_End > end ? timing->m_End : end;
+        serialTicks += timing->m_End - timing->m_Start;
+    }
+
+    u32 used = 0;
+    const auto append = [&](const int written)
+    {
+        if (written > 0)
+        {
+            used += static_cast<u32>(written);
+            used = used < bufferSize ? used : bufferSize - 1;
+        }
+    };
+
+    append(std::snprintf(
+        buffer + used, bufferSize - used,
+        "Task graph: %.2f ms, critical path %.2f ms, %.2f ms if run serially\n",
+        ClockTicksToMilliseconds(end - begin),
+        ClockTicksToMilliseconds(criticalTicks),
+        ClockTicksToMilliseconds(serialTicks)));
+
+    for (u32 task = 0; task < taskCount; task++)
+    {
+        const TaskTiming* timing = &graph->m_Timings[task];
+        append(std::snprintf(
+            buffer + used, bufferSize - used,
+            "%c %-20s start %8.2f ms  took %8.2f ms  thread %2u%s\n",
+            critical[task] ? '*' : ' ',
+            graph->m_Tasks[task].m_Name,
+            ClockTicksToMilliseconds(timing->m_Start - begin),
+            ClockTicksToMilliseconds(timing->m_End - timing->m_Start),
+            timing->m_Thread,
+            !timing->m_Ran ? "  skipped" : (timing->m_Succeeded ? "" : "  failed")));
+    }
+}
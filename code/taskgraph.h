@@ -0,0 +1,58 @@
+#pragma once
+#include "types.h"
+
+/*
+* NOTE(sbalse): A one shot graph of tasks with dependencies, used to run startup in parallel. Tasks are added
+* after the tasks they depend on, so the graph can't have cycles and the order they were added in is a valid
+* order to run them in. Tasks run on the job workers as soon as their dependencies are done, except the ones
+* pinned to the main thread. Every task is timed, so after a run the graph reports a timeline and the
+* critical path, the chain of tasks that decided how long the whole thing took.
+*/
+
+constexpr u32 TASKGRAPH_MAX_TASKS = 64;
+constexpr u32 TASKGRAPH_MAX_DEPENDENCIES = 8;
+constexpr u32 TASKGRAPH_INVALID_TASK = ~0u;
+
+// NOTE(sbalse): Returns false on failure. The tasks that depend on a failed task are skipped.
+using TaskFunction = bool (*)(void* context);
+
+enum class TaskAffinity : u8
+{
+    ANY,
+    MAIN, // NOTE(sbalse): For work that has to happen on the thread that calls TaskGraphRun().
+    COUNT
+};
+
+struct TaskTiming
+{
+    i64 m_Start; // NOTE(sbalse): Clock ticks.
+    i64 m_End;
+    u32 m_Thread; // NOTE(sbalse): Job thread index, 0 is the main thread.
+    bool m_Ran; // NOTE(sbalse): False when skipped because a dependency failed.
+    bool m_Succeeded;
+};
+
+struct TaskGraph;
+
+TaskGraph* TaskGraphCreate();
+void TaskGraphDestroy(TaskGraph* graph);
+// NOTE(sbalse): Returns TASKGRAPH_INVALID_TASK when the graph is full or a dependency is invalid.
+u32 TaskGraphAdd(
+    TaskGraph* graph,
+    const char* name,
+    const TaskFunction function,
+    void* context,
+    const TaskAffinity affinity,
+    const u32* dependencies,
+    const u32 dependencyCount);
+// NOTE(sbalse): Runs every task and returns once all are done. Returns true when all succeeded.
+bool TaskGraphRun(TaskGraph* graph);
+
+u32 TaskGraphTaskCount(const TaskGraph* graph);
+const char* TaskGraphTaskName(const TaskGraph* graph, const u32 task);
+const TaskTiming* TaskGraphTaskTiming(const TaskGraph* graph, const u32 task);
+// NOTE(sbalse): Writes the tasks of the critical path of the last run, first to last. Returns the number of
+// tasks on the path, which can be more than maxTasks.
+u32 TaskGraphCriticalPath(const TaskGraph* graph, u32* tasks, const u32 maxTasks);
+// NOTE(sbalse): Human readable timeline of the last run, the tasks on the critical path are marked with a *.
+void TaskGraphReport(const TaskGraph* graph, char* buffer, const u32 bufferSize);
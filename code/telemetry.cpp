@@ -0,0 +1,251 @@
+#include "telemetry.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+#if _WIN32
+#include "cleanwindows.h"
+#include <psapi.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    void TelemetryCopyName(char* destination, const char* source)
+    {
+        std::strncpy(destination, source, TELEMETRY_MAX_NAME_LENGTH - 1);
+        destination[TELEMETRY_MAX_NAME_LENGTH - 1] = '\0';
+    }
+
+    // NOTE(sbalse): Maps the segment and stores the platform handle in mapping. Returns the mapped view.
+    void* TelemetryMapSegment(TelemetryMapping* mapping, const bool create)
+    {
+        constexpr size_t size = sizeof(TelemetryBlock);
+
+#if _WIN32
+        char fullName[96] = {};
+        std::snprintf(fullName, sizeof(fullName), "Local\\%s", mapping->m_Name);
+
+        HANDLE handle = nullptr;
+        if (create)
+        {
+            handle = CreateFileMappingA(
+                INVALID_HANDLE_VALUE,
+                nullptr,
+                PAGE_READWRITE,
+                0,
+                static_cast<DWORD>(size),
+                fullName);
+        }
+        else
+        {
+            handle = OpenFileMappingA(FILE_MAP_READ, FALSE, fullName);
+        }
+
+        if (!handle)
+        {
+            return nullptr;
+        }
+
+        void* view = MapViewOfFile(handle, create ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, 0, 0, size);
+        if (!view)
+        {
+            CloseHandle(handle);
+            return nullptr;
+        }
+
+        mapping->m_Handle = handle;
+        return view;
+#else
+        char fullName[96] = {};
+        std::snprintf(fullName, sizeof(fullName), "/%s", mapping->m_Name);
+
+        const int fd = create ? shm_open(fullName, O_CREAT | O_RDWR, 0644) : shm_open(fullName, O_RDONLY, 0);
+        if (fd < 0)
+        {
+            return nullptr;
+        }
+
+        if (create && ftruncate(fd, static_cast<off_t>(size)) != 0)
+        {
+            close(fd);
+            return nullptr;
+        }
+
+        void* view = mmap(nullptr, size, create ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+
+        // NOTE(sbalse): The mapping keeps the segment alive, the descriptor is not needed anymore.
+        close(fd);
+
+        if (view == MAP_FAILED)
+        {
+            return nullptr;
+        }
+
+        mapping->m_Handle = nullptr;
+        return view;
+#endif
+    }
+}
+
+bool TelemetryCreate(TelemetryMapping* mapping, const char* name)
+{
+    *mapping = {};
+    std::snprintf(mapping->m_Name, sizeof(mapping->m_Name), "%s", name);
+    mapping->m_IsWriter = true;
+
+    void* view = TelemetryMapSegment(mapping, true);
+    if (!view)
+    {
+        return false;
+    }
+
+    TelemetryBlock* block = static_cast<TelemetryBlock*>(view);
+    std::memset(view, 0, sizeof(TelemetryBlock));
+    block->m_Version = TELEMETRY_VERSION;
+    block->m_Size = sizeof(TelemetryBlock);
+    block->m_Sequence.store(0, std::memory_order_relaxed);
+
+    // NOTE(sbalse): Readers treat a block without magic as not ready yet, so write it last.
+    std::atomic_thread_fence(std::memory_order_release);
+    block->m_Magic = TELEMETRY_MAGIC;
+
+    mapping->m_Block = block;
+    return true;
+}
+
+bool TelemetryOpen(TelemetryMapping* mapping, const char* name)
+{
+    *mapping = {};
+    std::snprintf(mapping->m_Name, sizeof(mapping->m_Name), "%s", name);
+    mapping->m_IsWriter = false;
+
+    void* view = TelemetryMapSegment(mapping, false);
+    if (!view)
+    {
+        return false;
+    }
+
+    mapping->m_Block = static_cast<TelemetryBlock*>(view);
+
+    const TelemetryBlock* block = mapping->m_Block;
+    if (block->m_Magic != TELEMETRY_MAGIC
+        || block->m_Version != TELEMETRY_VERSION
+        || block->m_Size != sizeof(TelemetryBlock))
+    {
+        TelemetryClose(mapping);
+        return false;
+    }
+
+    return true;
+}
+
+void TelemetryClose(TelemetryMapping* mapping)
+{
+    if (!mapping->m_Block)
+    {
+        return;
+    }
+
+#if _WIN32
+    UnmapViewOfFile(mapping->m_Block);
+    CloseHandle(static_cast<HANDLE>(mapping->m_Handle));
+#else
+    munmap(mapping->m_Block, sizeof(TelemetryBlock));
+    if (mapping->m_IsWriter)
+    {
+        char fullName[96] = {};
+        std::snprintf(fullName, sizeof(fullName), "/%s", mapping->m_Name);
+        shm_unlink(fullName);
+    }
+#endif
+
+    *mapping = {};
+}
+
+u64 TelemetryQueryProcessMemory()
+{
+#if _WIN32
+    PROCESS_MEMORY_COUNTERS counters = {};
+    if (!K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return 0;
+    }
+    return counters.WorkingSetSize;
+#else
+    // NOTE(sbalse): The second field is the current resident set in pages. getrusage() only has the peak, which
+    // isn't what WorkingSetSize is on Windows.
+    FILE* file = std::fopen("/proc/self/statm", "r");
+    if (!file)
+    {
+        return 0;
+    }
+    unsigned long long size = 0;
+    unsigned long long resident = 0;
+    const int fields = std::fscanf(file, "%llu %llu", &size, &resident);
+    std::fclose(file);
+    if (fields != 2)
+    {
+        return 0;
+    }
+    return static_cast<u64>(resident) * static_cast<u64>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+void TelemetrySetStageName(TelemetryBlock* block, const u32 stage, const char* name)
+{
+    if (stage < TELEMETRY_MAX_STAGES)
+    {
+        TelemetryCopyName(block->m_StageNames[stage], name);
+        block->m_StageCount = stage + 1 > block->m_StageCount ? stage + 1 : block->m_StageCount;
+    }
+}
+
+void TelemetrySetCounterName(TelemetryBlock* block, const u32 counter, const char* name)
+{
+    if (counter < TELEMETRY_MAX_COUNTERS)
+    {
+        TelemetryCopyName(block->m_CounterNames[counter], name);
+        block->m_CounterCount = counter + 1 > block->m_CounterCount ? counter + 1 : block->m_CounterCount;
+    }
+}
+
+void TelemetryPublish(TelemetryBlock* block, const TelemetryStats* stats)
+{
+    // NOTE(sbalse): Single writer, so a plain load of our own sequence is enough.
+    const u32 sequence = block->m_Sequence.load(std::memory_order_relaxed);
+
+    block->m_Sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    std::memcpy(&block->m_Stats, stats, sizeof(TelemetryStats));
+
+    block->m_Sequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool TelemetryRead(const TelemetryBlock* block, TelemetryStats* result, const u32 maxAttempts)
+{
+    for (u32 attempt = 0; attempt < maxAttempts; attempt++)
+    {
+        const u32 before = block->m_Sequence.load(std::memory_order_acquire);
+        if (before & 1)
+        {
+            continue; // NOTE(sbalse): Writer is in the middle of an update.
+        }
+
+        std::memcpy(result, &block->m_Stats, sizeof(TelemetryStats));
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const u32 after = block->m_Sequence.load(std::memory_order_relaxed);
+        if (before == after)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include "types.h"
+#include "telemetryblock.h"
+
+struct TelemetryMapping
+{
+    TelemetryBlock* m_Block;
+    void* m_Handle; // NOTE(sbalse): Platform handle of the shared memory object.
+    bool m_IsWriter;
+    char m_Name[64];
+};
+
+// NOTE(sbalse): Creates the named segment and initialises its header. Used by the engine.
+bool TelemetryCreate(TelemetryMapping* mapping, const char* name);
+// NOTE(sbalse): Opens an existing segment read only and validates its header. Used by monitoring tools.
+bool TelemetryOpen(TelemetryMapping* mapping, const char* name);
+void TelemetryClose(TelemetryMapping* mapping);
+
+// NOTE(sbalse): Current resident memory of the calling process in bytes, not the peak. This is a syscall, don't call
+// it every frame.
+u64 TelemetryQueryProcessMemory();
+
+void TelemetrySetStageName(TelemetryBlock* block, const u32 stage, const char* name);
+void TelemetrySetCounterName(TelemetryBlock* block, const u32 counter, const char* name);
+
+// NOTE(sbalse): Wait free for the writer; never blocks on readers.
+void TelemetryPublish(TelemetryBlock* block, const TelemetryStats* stats);
+// NOTE(sbalse): Returns false if no consistent copy could be made within maxAttempts tries.
+bool TelemetryRead(const TelemetryBlock* block, TelemetryStats* result, const u32 maxAttempts);
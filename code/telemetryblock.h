@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+
+#include "types.h"
+
+/*
+* NOTE(sbalse): Layout of the telemetry block the engine publishes into shared memory for external
+* monitoring tools. The layout is fixed: only ever append fields and bump TELEMETRY_VERSION when doing so.
+* Readers must check the magic, version and size before trusting anything else in the block.
+*/
+constexpr u32 TELEMETRY_MAGIC = 0x44335748; // NOTE(sbalse): "HW3D" in little endian.
+constexpr u32 TELEMETRY_VERSION = 1;
+constexpr const char* TELEMETRY_DEFAULT_NAME = "hw3d_telemetry";
+
+constexpr u32 TELEMETRY_MAX_STAGES = 8;
+constexpr u32 TELEMETRY_MAX_COUNTERS = 8;
+constexpr u32 TELEMETRY_MAX_NAME_LENGTH = 16;
+
+struct TelemetryStats
+{
+    u64 m_FrameIndex;
+    u64 m_PublishTimeUs; // NOTE(sbalse): Engine clock, only meaningful relative to other samples.
+    float m_FrameTimeMs;
+    float m_FrameTimeMeanMs;
+    float m_FrameTimeP50Ms;
+    float m_FrameTimeP99Ms;
+    float m_StageTimeMeanMs[TELEMETRY_MAX_STAGES];
+    u64 m_Counters[TELEMETRY_MAX_COUNTERS];
+    u64 m_ObjectCount;
+    u64 m_ProcessMemoryBytes;
+    float m_PipelineLatencyMeanMs;
+    float m_PipelineLatencyP99Ms;
+};
+
+struct TelemetryBlock
+{
+    u32 m_Magic;
+    u32 m_Version;
+    u32 m_Size; // NOTE(sbalse): sizeof(TelemetryBlock) of the writer.
+    u32 m_StageCount;
+    u32 m_CounterCount;
+    // NOTE(sbalse): Seqlock guarding m_Stats. Odd while the writer is in the middle of an update.
+    std::atomic<u32> m_Sequence;
+    char m_StageNames[TELEMETRY_MAX_STAGES][TELEMETRY_MAX_NAME_LENGTH];
+    char m_CounterNames[TELEMETRY_MAX_COUNTERS][TELEMETRY_MAX_NAME_LENGTH];
+    TelemetryStats m_Stats;
+};
+
+static_assert(std::atomic<u32>::is_always_lock_free, "The seqlock must be usable across processes");
+static_assert(sizeof(TelemetryStats) % 8 == 0, "TelemetryStats must not have trailing padding");
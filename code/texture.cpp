@@ -0,0 +1,1019 @@
+#include "texture.h"
+
+#include <bit>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <emmintrin.h>
+
+#include "jobs.h"
+#include "scenefile.h"
+
+namespace
+{
+    constexpr u32 TEXTURE_TGA_HEADER_SIZE = 18;
+    constexpr u32 TEXTURE_TGA_UNCOMPRESSED = 2;
+    constexpr u32 TEXTURE_TGA_RUNLENGTH = 10;
+    constexpr u32 TEXTURE_TGA_TOP_LEFT = 1u << 5;
+
+    constexpr u32 TEXTURE_MAX_TAPS = 8;
+    // NOTE(sbalse): Shape of the Kaiser window, higher is smoother with a wider main lobe.
+    constexpr double TEXTURE_KAISER_ALPHA = 4.0;
+    // NOTE(sbalse): Rows per batch when filtering, block rows per batch when compressing.
+    constexpr u32 TEXTURE_FILTER_BATCH = 16;
+    constexpr u32 TEXTURE_COMPRESS_BATCH = 4;
+    constexpr u32 TEXTURE_SRGB_ENCODE_STEPS = 4096;
+
+    // NOTE(sbalse): Interpolation weights of BC7 4-bit indices, out of 64.
+    constexpr u32 g_TextureBc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    // NOTE(sbalse): Source taps of one target texel. Target texel i covers source texels 2i and 2i + 1, the first
+    // tap is m_First texels from 2i.
+    struct TextureKernel
+    {
+        i32 m_First;
+        u32 m_Taps;
+        float m_Weights[TEXTURE_MAX_TAPS];
+    };
+
+    struct TextureSrgbTables
+    {
+        float m_Decode[256];
+        u8 m_Encode[TEXTURE_SRGB_ENCODE_STEPS];
+    };
+
+    TextureSrgbTables TextureMakeSrgbTables()
+    {
+        TextureSrgbTables tables = {};
+        for (u32 i = 0; i < 256; i++)
+        {
+            const double value = i / 255.0;
+            tables.m_Decode[i] = static_cast<float>(
+                value <= 0.04045 ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4));
+        }
+        for (u32 i = 0; i < TEXTURE_SRGB_ENCODE_STEPS; i++)
+        {
+            const double value = static_cast<double>(i) / (TEXTURE_SRGB_ENCODE_STEPS - 1);
+            const double encoded = value <= 0.0031308 ? value * 12.92 : 1.055 * std::pow(value, 1.0 / 2.4) - 0.055;
+            tables.m_Encode[i] = static_cast<u8>(encoded * 255.0 + 0.5);
+        }
+        return tables;
+    }
+
+    const TextureSrgbTables* TextureGetSrgbTables()
+    {
+        static const TextureSrgbTables s_Tables = TextureMakeSrgbTables();
+        return &s_Tables;
+    }
+
+    // NOTE(sbalse): Zeroth order modified Bessel function of the first kind, for the Kaiser window.
+    double TextureBessel0(const double x)
+    {
+        double sum = 1.0;
+        double term = 1.0;
+        for (u32 k = 1; k < 32; k++)
+        {
+            const double factor = x / (2.0 * k);
+            term *= factor * factor;
+            sum += term;
+        }
+        return sum;
+    }
+
+    TextureKernel TextureMakeKernel(const TextureFilter filter)
+    {
+        if (filter == TextureFilter::BOX)
+        {
+            return { .m_First = 0, .m_Taps = 2, .m_Weights = { 0.5f, 0.5f } };
+        }
+
+        // NOTE(sbalse): Sinc at half the source rate, windowed to four source texels either side of the center of
+        // the target texel, which lies between the two texels it covers.
+        TextureKernel kernel = { .m_First = -3, .m_Taps = TEXTURE_MAX_TAPS, .m_Weights = {} };
+        double weights[TEXTURE_MAX_TAPS] = {};
+        double sum = 0.0;
+        for (u32 tap = 0; tap < TEXTURE_MAX_TAPS; tap++)
+        {
+            const double distance = static_cast<double>(kernel.m_First + static_cast<i32>(tap)) - 0.5;
+            const double x = distance * 0.5;
+            const double sinc = x == 0.0 ? 1.0 : std::sin(3.14159265358979 * x) / (3.14159265358979 * x);
+            const double window = distance / 4.0;
+            weights[tap] = sinc * TextureBessel0(TEXTURE_KAISER_ALPHA * std::sqrt(1.0 - window * window))
+                / TextureBessel0(TEXTURE_KAISER_ALPHA);
+            sum += weights[tap];
+        }
+        for (u32 tap = 0; tap < TEXTURE_MAX_TAPS; tap++)
+        {
+            kernel.m_Weights[tap] = static_cast<float>(weights[tap] / sum);
+        }
+        return kernel;
+    }
+
+    i32 TextureClamp(const i32 value, const i32 last)
+    {
+        return value < 0 ? 0 : (value > last ? last : value);
+    }
+
+    // NOTE(sbalse): One pass of a mip filter over float RGBA, halving either the width or the height.
+    struct TextureFilterJob
+    {
+        const float* m_Source;
+        float* m_Target;
+        u32 m_SourceWidth;
+        u32 m_SourceHeight;
+        u32 m_TargetWidth;
+        const TextureKernel* m_Kernel;
+    };
+
+    void TextureFilterRowsRange(void* context, const u32 begin, const u32 end)
+    {
+        const TextureFilterJob* job = static_cast<const TextureFilterJob*>(context);
+        const TextureKernel* kernel = job->m_Kernel;
+        const i32 last = static_cast<i32>(job->m_SourceWidth) - 1;
+        for (u32 y = begin; y < end; y++)
+        {
+            const float* source = job->m_Source + (static_cast<size_t>(y) * job->m_SourceWidth * 4);
+            float* target = job->m_Target + (static_cast<size_t>(y) * job->m_TargetWidth * 4);
+            for (u32 x = 0; x < job->m_TargetWidth; x++)
+            {
+                __m128 sum = _mm_setzero_ps();
+                const i32 first = static_cast<i32>(x * 2) + kernel->m_First;
+                for (u32 tap = 0; tap < kernel->m_Taps; tap++)
+                {
+                    const i32 column = TextureClamp(first + static_cast<i32>(tap), last);
+                    const __m128 texel = _mm_loadu_ps(source + (column * 4));
+                    sum = _mm_add_ps(sum, _mm_mul_ps(texel, _mm_set1_ps(kernel->m_Weights[tap])));
+                }
+                _mm_storeu_ps(target + (x * 4), sum);
+            }
+        }
+    }
+
+    void TextureFilterColumnsRange(void* context, const u32 begin, const u32 end)
+    {
+        const TextureFilterJob* job = static_cast<const TextureFilterJob*>(context);
+        const TextureKernel* kernel = job->m_Kernel;
+        const i32 last = static_cast<i32>(job->m_SourceHeight) - 1;
+        const size_t rowFloats = static_cast<size_t>(job->m_SourceWidth) * 4;
+        for (u32 y = begin; y < end; y++)
+        {
+            float* target = job->m_Target + (y * rowFloats);
+            const i32 first = static_cast<i32>(y * 2) + kernel->m_First;
+            for (u32 x = 0; x < job->m_SourceWidth; x++)
+            {
+                __m128 sum = _mm_setzero_ps();
+                for (u32 tap = 0; tap < kernel->m_Taps; tap++)
+                {
+                    const i32 row = TextureClamp(first + static_cast<i32>(tap), last);
+                    const __m128 texel = _mm_loadu_ps(job->m_Source + (row * rowFloats) + (x * 4));
+                    sum = _mm_add_ps(sum, _mm_mul_ps(texel, _mm_set1_ps(kernel->m_Weights[tap])));
+                }
+                _mm_storeu_ps(target + (x * 4), sum);
+            }
+        }
+    }
+
+    // NOTE(sbalse): Rounds a float level to RGBA8, through the sRGB curve for color.
+    struct TextureStoreJob
+    {
+        const float* m_Source;
+        u8* m_Target;
+        u32 m_Width;
+        const TextureSrgbTables* m_Srgb; // NOTE(sbalse): Null for linear data.
+    };
+
+    void TextureStoreRange(void* context, const u32 begin, const u32 end)
+    {
+        const TextureStoreJob* job = static_cast<const TextureStoreJob*>(context);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 linearScale = _mm_set1_ps(255.0f);
+        const __m128 srgbScale = _mm_set1_ps(static_cast<float>(TEXTURE_SRGB_ENCODE_STEPS - 1));
+
+        for (u32 y = begin; y < end; y++)
+        {
+            const float* source = job->m_Source + (static_cast<size_t>(y) * job->m_Width * 4);
+            u8* target = job->m_Target + (static_cast<size_t>(y) * job->m_Width * 4);
+            for (u32 x = 0; x < job->m_Width; x++)
+            {
+                const __m128 clamped = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(source + (x * 4)), zero), one);
+                alignas(16) i32 linear[4] = {};
+                _mm_store_si128(
+                    reinterpret_cast<__m128i*>(linear),
+                    _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(clamped, linearScale), half)));
+                if (!job->m_Srgb)
+                {
+                    for (u32 c = 0; c < 4; c++)
+                    {
+                        target[(x * 4) + c] = static_cast<u8>(linear[c]);
+                    }
+                    continue;
+                }
+
+                // NOTE(sbalse): Alpha stays linear.
+                alignas(16) i32 steps[4] = {};
+                _mm_store_si128(
+                    reinterpret_cast<__m128i*>(steps),
+                    _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(clamped, srgbScale), half)));
+                for (u32 c = 0; c < 3; c++)
+                {
+                    target[(x * 4) + c] = job->m_Srgb->m_Encode[steps[c]];
+                }
+                target[(x * 4) + 3] = static_cast<u8>(linear[3]);
+            }
+        }
+    }
+
+    // NOTE(sbalse): Largest eigenvector of a symmetric matrix stored as its upper triangle row by row, by power
+    // iteration from start. Returns false when the matrix is zero along it.
+    template<u32 N>
+    bool TexturePrincipalAxis(const float* covariance, const float* start, float* axis)
+    {
+        float matrix[N][N] = {};
+        u32 element = 0;
+        for (u32 row = 0; row < N; row++)
+        {
+            for (u32 column = row; column < N; column++)
+            {
+                matrix[row][column] = covariance[element];
+                matrix[column][row] = covariance[element];
+                element++;
+            }
+        }
+
+        float vector[N] = {};
+        std::memcpy(vector, start, sizeof(vector));
+        for (u32 iteration = 0; iteration < 8; iteration++)
+        {
+            float next[N] = {};
+            float length = 0.0f;
+            for (u32 row = 0; row < N; row++)
+            {
+                for (u32 column = 0; column < N; column++)
+                {
+                    next[row] += matrix[row][column] * vector[column];
+                }
+                length += next[row] * next[row];
+            }
+            if (!(length > 1e-12f))
+            {
+                return false;
+            }
+            const float inverse = 1.0f / std::sqrt(length);
+            for (u32 row = 0; row < N; row++)
+            {
+                vector[row] = next[row] * inverse;
+            }
+        }
+        std::memcpy(axis, vector, sizeof(vector));
+        return true;
+    }
+
+    // NOTE(sbalse): Fits a line through the texels of a block, along the axis they vary the most, and returns the
+    // two points where the texels furthest out along it project.
+    template<u32 N>
+    void TextureFitLine(const u8 (*texels)[4], float* low, float* high)
+    {
+        float mean[N] = {};
+        float min[N] = {};
+        float max[N] = {};
+        for (u32 c = 0; c < N; c++)
+        {
+            min[c] = 255.0f;
+        }
+        for (u32 i = 0; i < 16; i++)
+        {
+            for (u32 c = 0; c < N; c++)
+            {
+                const float value = texels[i][c];
+                mean[c] += value;
+                min[c] = value < min[c] ? value : min[c];
+                max[c] = value > max[c] ? value : max[c];
+            }
+        }
+        for (u32 c = 0; c < N; c++)
+        {
+            mean[c] *= 1.0f / 16.0f;
+        }
+
+        float covariance[N * (N + 1) / 2] = {};
+        for (u32 i = 0; i < 16; i++)
+        {
+            u32 element = 0;
+            for (u32 row = 0; row < N; row++)
+            {
+                for (u32 column = row; column < N; column++)
+                {
+                    covariance[element++] += (texels[i][row] - mean[row]) * (texels[i][column] - mean[column]);
+                }
+            }
+        }
+
+        // NOTE(sbalse): Start from the diagonal of the bounding box, it is close to the answer for most blocks.
+        float start[N] = {};
+        float axis[N] = {};
+        for (u32 c = 0; c < N; c++)
+        {
+            start[c] = max[c] - min[c];
+        }
+        if (!TexturePrincipalAxis<N>(covariance, start, axis))
+        {
+            std::memcpy(low, mean, sizeof(mean));
+            std::memcpy(high, mean, sizeof(mean));
+            return;
+        }
+
+        float lowest = 0.0f;
+        float highest = 0.0f;
+        for (u32 i = 0; i < 16; i++)
+        {
+            float projection = 0.0f;
+            for (u32 c = 0; c < N; c++)
+            {
+                projection += (texels[i][c] - mean[c]) * axis[c];
+            }
+            lowest = projection < lowest ? projection : lowest;
+            highest = projection > highest ? projection : highest;
+        }
+        for (u32 c = 0; c < N; c++)
+        {
+            low[c] = mean[c] + axis[c] * lowest;
+            high[c] = mean[c] + axis[c] * highest;
+        }
+    }
+
+    // NOTE(sbalse): Endpoints that best reproduce the texels for the given weights of the second endpoint, by least
+    // squares. Returns false when the weights can't tell the endpoints apart.
+    template<u32 N>
+    bool TextureSolveEndpoints(const u8 (*texels)[4], const float* weights, float* first, float* second)
+    {
+        float aa = 0.0f;
+        float ab = 0.0f;
+        float bb = 0.0f;
+        float ax[N] = {};
+        float bx[N] = {};
+        for (u32 i = 0; i < 16; i++)
+        {
+            const float b = weights[i];
+            const float a = 1.0f - b;
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+            for (u32 c = 0; c < N; c++)
+            {
+                ax[c] += a * texels[i][c];
+                bx[c] += b * texels[i][c];
+            }
+        }
+
+        const float determinant = aa * bb - ab * ab;
+        if (std::fabs(determinant) < 1e-6f)
+        {
+            return false;
+        }
+        const float inverse = 1.0f / determinant;
+        for (u32 c = 0; c < N; c++)
+        {
+            const float a = (ax[c] * bb - bx[c] * ab) * inverse;
+            const float b = (bx[c] * aa - ax[c] * ab) * inverse;
+            first[c] = a < 0.0f ? 0.0f : (a > 255.0f ? 255.0f : a);
+            second[c] = b < 0.0f ? 0.0f : (b > 255.0f ? 255.0f : b);
+        }
+        return true;
+    }
+
+    u32 TextureQuantize(const float value, const u32 maximum)
+    {
+        const float scaled = value * static_cast<float>(maximum) / 255.0f + 0.5f;
+        return scaled >= static_cast<float>(maximum) ? maximum : static_cast<u32>(scaled);
+    }
+
+    u32 TextureBc1Color(const float* color)
+    {
+        return (TextureQuantize(color[0], 31) << 11)
+            | (TextureQuantize(color[1], 63) << 5)
+            | TextureQuantize(color[2], 31);
+    }
+
+    void TextureBc1Palette(const u32 first, const u32 second, i32 (*palette)[3])
+    {
+        const u32 colors[2] = { first, second };
+        for (u32 i = 0; i < 2; i++)
+        {
+            const u32 r = (colors[i] >> 11) & 31;
+            const u32 g = (colors[i] >> 5) & 63;
+            const u32 b = colors[i] & 31;
+            palette[i][0] = static_cast<i32>((r << 3) | (r >> 2));
+            palette[i][1] = static_cast<i32>((g << 2) | (g >> 4));
+            palette[i][2] = static_cast<i32>((b << 3) | (b >> 2));
+        }
+        for (u32 c = 0; c < 3; c++)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+    }
+
+    // NOTE(sbalse): Picks the nearest palette entry for every texel. Returns the summed squared error.
+    template<u32 N, u32 Entries>
+    u32 TextureAssignIndices(const u8 (*texels)[4], const i32 (*palette)[N], u32* indices)
+    {
+        u32 total = 0;
+        for (u32 i = 0; i < 16; i++)
+        {
+            u32 best = ~0u;
+            for (u32 entry = 0; entry < Entries; entry++)
+            {
+                u32 error = 0;
+                for (u32 c = 0; c < N; c++)
+                {
+                    const i32 difference = static_cast<i32>(texels[i][c]) - palette[entry][c];
+                    error += static_cast<u32>(difference * difference);
+                }
+                if (error < best)
+                {
+                    best = error;
+                    indices[i] = entry;
+                }
+            }
+            total += best;
+        }
+        return total;
+    }
+
+    // NOTE(sbalse): Four color mode only, the first color is always the larger one. Alpha is dropped.
+    void TextureEncodeBc1(const u8 (*texels)[4], u8* block)
+    {
+        // NOTE(sbalse): Weight of the second endpoint in every palette entry.
+        constexpr float weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+        float first[3] = {};
+        float second[3] = {};
+        TextureFitLine<3>(texels, second, first);
+
+        u32 bestColors[2] = {};
+        u32 bestIndices[16] = {};
+        u32 bestError = ~0u;
+        for (u32 attempt = 0; attempt < 2; attempt++)
+        {
+            u32 colors[2] = { TextureBc1Color(first), TextureBc1Color(second) };
+            if (colors[0] < colors[1])
+            {
+                const u32 swap = colors[0];
+                colors[0] = colors[1];
+                colors[1] = swap;
+            }
+
+            i32 palette[4][3] = {};
+            TextureBc1Palette(colors[0], colors[1], palette);
+            u32 indices[16] = {};
+            const u32 error = colors[0] == colors[1]
+                ? TextureAssignIndices<3, 1>(texels, palette, indices)
+                : TextureAssignIndices<3, 4>(texels, palette, indices);
+            if (error < bestError)
+            {
+                bestError = error;
+                bestColors[0] = colors[0];
+                bestColors[1] = colors[1];
+                std::memcpy(bestIndices, indices, sizeof(indices));
+            }
+
+            // NOTE(sbalse): Refit the endpoints to the indices once.
+            float texelWeights[16] = {};
+            for (u32 i = 0; i < 16; i++)
+            {
+                texelWeights[i] = weights[indices[i]];
+            }
+            if (!TextureSolveEndpoints<3>(texels, texelWeights, first, second))
+            {
+                break;
+            }
+        }
+
+        u32 packed = 0;
+        for (u32 i = 0; i < 16; i++)
+        {
+            packed |= bestIndices[i] << (i * 2);
+        }
+        const u16 colors[2] = { static_cast<u16>(bestColors[0]), static_cast<u16>(bestColors[1]) };
+        std::memcpy(block, colors, sizeof(colors));
+        std::memcpy(block + 4, &packed, sizeof(packed));
+    }
+
+    // NOTE(sbalse): Mode 6 endpoints are 7 bits per channel plus a shared lowest bit per endpoint. Picks the lowest
+    // bit that gets closer.
+    void TextureBc7Endpoint(const float* color, i32* endpoint, u32* bit)
+    {
+        float bestError = 0.0f;
+        for (u32 candidate = 0; candidate < 2; candidate++)
+        {
+            i32 values[4] = {};
+            float error = 0.0f;
+            for (u32 c = 0; c < 4; c++)
+            {
+                const float scaled = (color[c] - static_cast<float>(candidate)) * 0.5f + 0.5f;
+                const i32 quantized = scaled <= 0.0f ? 0 : (scaled >= 127.0f ? 127 : static_cast<i32>(scaled));
+                values[c] = (quantized << 1) | static_cast<i32>(candidate);
+                const float difference = static_cast<float>(values[c]) - color[c];
+                error += difference * difference;
+            }
+            if (candidate == 0 || error < bestError)
+            {
+                bestError = error;
+                std::memcpy(endpoint, values, sizeof(values));
+                *bit = candidate;
+            }
+        }
+    }
+
+    struct TextureBits
+    {
+        u64 m_Low;
+        u64 m_High;
+        u32 m_Position;
+    };
+
+    void TextureWriteBits(TextureBits* bits, const u32 value, const u32 count)
+    {
+        const u64 wide = value;
+        if (bits->m_Position >= 64)
+        {
+            bits->m_High |= wide << (bits->m_Position - 64);
+        }
+        else
+        {
+            bits->m_Low |= wide << bits->m_Position;
+            if (bits->m_Position + count > 64)
+            {
+                bits->m_High |= wide >> (64 - bits->m_Position);
+            }
+        }
+        bits->m_Position += count;
+    }
+
+    void TextureEncodeBc7(const u8 (*texels)[4], u8* block)
+    {
+        float low[4] = {};
+        float high[4] = {};
+        TextureFitLine<4>(texels, low, high);
+
+        i32 bestEndpoints[2][4] = {};
+        u32 bestBits[2] = {};
+        u32 bestIndices[16] = {};
+        u32 bestError = ~0u;
+        for (u32 attempt = 0; attempt < 2; attempt++)
+        {
+            i32 endpoints[2][4] = {};
+            u32 bits[2] = {};
+            TextureBc7Endpoint(low, endpoints[0], &bits[0]);
+            TextureBc7Endpoint(high, endpoints[1], &bits[1]);
+
+            i32 palette[16][4] = {};
+            for (u32 entry = 0; entry < 16; entry++)
+            {
+                const i32 weight = static_cast<i32>(g_TextureBc7Weights[entry]);
+                for (u32 c = 0; c < 4; c++)
+                {
+                    palette[entry][c] = ((64 - weight) * endpoints[0][c] + weight * endpoints[1][c] + 32) >> 6;
+                }
+            }
+            u32 indices[16] = {};
+            const u32 error = TextureAssignIndices<4, 16>(texels, palette, indices);
+            if (error < bestError)
+            {
+                bestError = error;
+                std::memcpy(bestEndpoints, endpoints, sizeof(endpoints));
+                std::memcpy(bestBits, bits, sizeof(bits));
+                std::memcpy(bestIndices, indices, sizeof(indices));
+            }
+
+            float texelWeights[16] = {};
+            for (u32 i = 0; i < 16; i++)
+            {
+                texelWeights[i] = static_cast<float>(g_TextureBc7Weights[indices[i]]) / 64.0f;
+            }
+            if (!TextureSolveEndpoints<4>(texels, texelWeights, low, high))
+            {
+                break;
+            }
+        }
+
+        // NOTE(sbalse): The highest bit of the first index is implied 0, swap the endpoints when it isn't.
+        if (bestIndices[0] & 8)
+        {
+            for (u32 c = 0; c < 4; c++)
+            {
+                const i32 swap = bestEndpoints[0][c];
+                bestEndpoints[0][c] = bestEndpoints[1][c];
+                bestEndpoints[1][c] = swap;
+            }
+            const u32 swap = bestBits[0];
+            bestBits[0] = bestBits[1];
+            bestBits[1] = swap;
+            for (u32 i = 0; i < 16; i++)
+            {
+                bestIndices[i] = 15 - bestIndices[i];
+            }
+        }
+
+        TextureBits bits = {};
+        TextureWriteBits(&bits, 1u << 6, 7);
+        for (u32 c = 0; c < 4; c++)
+        {
+            TextureWriteBits(&bits, static_cast<u32>(bestEndpoints[0][c]) >> 1, 7);
+            TextureWriteBits(&bits, static_cast<u32>(bestEndpoints[1][c]) >> 1, 7);
+        }
+        TextureWriteBits(&bits, bestBits[0], 1);
+        TextureWriteBits(&bits, bestBits[1], 1);
+        TextureWriteBits(&bits, bestIndices[0], 3);
+        for (u32 i = 1; i < 16; i++)
+        {
+            TextureWriteBits(&bits, bestIndices[i], 4);
+        }
+        std::memcpy(block, &bits.m_Low, sizeof(bits.m_Low));
+        std::memcpy(block + 8, &bits.m_High, sizeof(bits.m_High));
+    }
+
+    struct TextureCompressJob
+    {
+        const u8* m_Texels;
+        u8* m_Target;
+        u32 m_Width;
+        u32 m_Height;
+        u32 m_RowPitch;
+        TextureFormat m_Format;
+    };
+
+    // NOTE(sbalse): Levels smaller than a block repeat their last row and column.
+    void TextureCompressRange(void* context, const u32 begin, const u32 end)
+    {
+        const TextureCompressJob* job = static_cast<const TextureCompressJob*>(context);
+        const u32 blockSize = job->m_Format == TextureFormat::BC1 ? 8 : 16;
+        const u32 blocksWide = (job->m_Width + 3) / 4;
+        for (u32 blockRow = begin; blockRow < end; blockRow++)
+        {
+            for (u32 blockColumn = 0; blockColumn < blocksWide; blockColumn++)
+            {
+                u8 texels[16][4] = {};
+                for (u32 i = 0; i < 16; i++)
+                {
+                    const u32 x = blockColumn * 4 + (i % 4);
+                    const u32 y = blockRow * 4 + (i / 4);
+                    const u32 column = x < job->m_Width ? x : job->m_Width - 1;
+                    const u32 row = y < job->m_Height ? y : job->m_Height - 1;
+                    std::memcpy(texels[i], job->m_Texels + ((static_cast<size_t>(row) * job->m_Width + column) * 4), 4);
+                }
+
+                u8* block = job->m_Target + (static_cast<size_t>(blockRow) * job->m_RowPitch)
+                    + (blockColumn * blockSize);
+                if (job->m_Format == TextureFormat::BC1)
+                {
+                    TextureEncodeBc1(texels, block);
+                }
+                else
+                {
+                    TextureEncodeBc7(texels, block);
+                }
+            }
+        }
+    }
+
+    u64 TextureAlign(const u64 value)
+    {
+        return (value + TEXTURE_ALIGNMENT - 1) & ~static_cast<u64>(TEXTURE_ALIGNMENT - 1);
+    }
+
+    u64 TextureHeaderChecksum(const TextureFile* texture)
+    {
+        TextureFile copy = *texture;
+        copy.m_HeaderChecksum = 0;
+        return SceneFileChecksum(&copy, sizeof(copy));
+    }
+
+    TextureMip TextureMakeMip(const TextureFormat format, const u32 width, const u32 height, const u64 offset)
+    {
+        const bool compressed = format != TextureFormat::RGBA8;
+        const u32 rowPitch = compressed ? ((width + 3) / 4) * (format == TextureFormat::BC1 ? 8 : 16) : width * 4;
+        const u32 rowCount = compressed ? (height + 3) / 4 : height;
+        return
+        {
+            .m_Offset = offset,
+            .m_Size = static_cast<u64>(rowPitch) * rowCount,
+            .m_Width = width,
+            .m_Height = height,
+            .m_RowPitch = rowPitch,
+            .m_RowCount = rowCount,
+        };
+    }
+}
+
+bool TextureDecodeTga(const void* data, const u64 size, TextureImage* image)
+{
+    *image = {};
+    const u8* bytes = static_cast<const u8*>(data);
+    if (size < TEXTURE_TGA_HEADER_SIZE)
+    {
+        return false;
+    }
+
+    const u32 idLength = bytes[0];
+    const u32 colorMapType = bytes[1];
+    const u32 imageType = bytes[2];
+    const u32 width = bytes[12] | (bytes[13] << 8);
+    const u32 height = bytes[14] | (bytes[15] << 8);
+    const u32 bitsPerPixel = bytes[16];
+    const u32 descriptor = bytes[17];
+    if (colorMapType != 0
+        || (imageType != TEXTURE_TGA_UNCOMPRESSED && imageType != TEXTURE_TGA_RUNLENGTH)
+        || (bitsPerPixel != 24 && bitsPerPixel != 32)
+        || width == 0
+        || height == 0)
+    {
+        return false;
+    }
+
+    const u32 bytesPerPixel = bitsPerPixel / 8;
+    const u64 pixelCount = static_cast<u64>(width) * height;
+    u8* pixels = static_cast<u8*>(std::calloc(pixelCount, 4));
+    if (!pixels)
+    {
+        return false;
+    }
+
+    // NOTE(sbalse): Pixels are BGR or BGRA. Run length packets hold one pixel repeated, raw packets that many
+    // pixels, and packets may run across rows.
+    u64 read = TEXTURE_TGA_HEADER_SIZE + idLength;
+    u64 pixel = 0;
+    bool valid = true;
+    while (valid && pixel < pixelCount)
+    {
+        u64 count = pixelCount - pixel;
+        bool repeat = false;
+        if (imageType == TEXTURE_TGA_RUNLENGTH)
+        {
+            if (read >= size)
+            {
+                valid = false;
+                break;
+            }
+            const u32 packet = bytes[read++];
+            repeat = (packet & 0x80) != 0;
+            count = (packet & 0x7F) + 1u;
+            count = count < pixelCount - pixel ? count : pixelCount - pixel;
+        }
+
+        const u64 sourceBytes = (repeat ? 1 : count) * bytesPerPixel;
+        if (read > size || sourceBytes > size - read)
+        {
+            valid = false;
+            break;
+        }
+        for (u64 i = 0; i < count; i++)
+        {
+            const u8* source = bytes + read + (repeat ? 0 : i * bytesPerPixel);
+            const u64 x = (pixel + i) % width;
+            const u64 y = (pixel + i) / width;
+            const u64 row = descriptor & TEXTURE_TGA_TOP_LEFT ? y : height - 1 - y;
+            u8* target = pixels + ((row * width + x) * 4);
+            target[0] = source[2];
+            target[1] = source[1];
+            target[2] = source[0];
+            target[3] = bytesPerPixel == 4 ? source[3] : 255;
+        }
+        read += sourceBytes;
+        pixel += count;
+    }
+
+    if (!valid)
+    {
+        std::free(pixels);
+        return false;
+    }
+
+    *image = { .m_Pixels = pixels, .m_Width = width, .m_Height = height };
+    return true;
+}
+
+void TextureImageFree(TextureImage* image)
+{
+    std::free(image->m_Pixels);
+    *image = {};
+}
+
+TextureFile* TextureBuild(const TextureImage* image, const TextureBuildDesc* desc)
+{
+    const u32 width = image->m_Width;
+    const u32 height = image->m_Height;
+    if (width == 0 || height == 0 || width > TEXTURE_MAX_SIZE || height > TEXTURE_MAX_SIZE
+        || !std::has_single_bit(width) || !std::has_single_bit(height)
+        || static_cast<u32>(desc->m_Format) >= static_cast<u32>(TextureFormat::COUNT))
+    {
+        return nullptr;
+    }
+
+    // NOTE(sbalse): Lay out the levels, then fill them in.
+    const u32 mipCount = static_cast<u32>(std::bit_width(width > height ? width : height));
+    TextureFile header =
+    {
+        .m_Magic = TEXTURE_MAGIC,
+        .m_Version = TEXTURE_VERSION,
+        .m_Size = 0,
+        .m_HeaderChecksum = 0,
+        .m_ContentChecksum = 0,
+        .m_Format = static_cast<u32>(desc->m_Format),
+        .m_Flags = desc->m_Srgb ? TEXTURE_FLAG_SRGB : 0u,
+        .m_Width = width,
+        .m_Height = height,
+        .m_MipCount = mipCount,
+        .m_Reserved = 0,
+        .m_Mips = {},
+    };
+    u64 offset = TextureAlign(sizeof(TextureFile));
+    for (u32 mip = 0; mip < mipCount; mip++)
+    {
+        const u32 mipWidth = width >> mip ? width >> mip : 1;
+        const u32 mipHeight = height >> mip ? height >> mip : 1;
+        header.m_Mips[mip] = TextureMakeMip(desc->m_Format, mipWidth, mipHeight, offset);
+        offset += TextureAlign(header.m_Mips[mip].m_Size);
+    }
+    header.m_Size = offset;
+
+    // NOTE(sbalse): Two float levels and the pass in between them, plus the rounded level being compressed.
+    const size_t texelCount = static_cast<size_t>(width) * height;
+    TextureFile* texture = static_cast<TextureFile*>(std::calloc(offset, 1));
+    float* levels[2] =
+    {
+        static_cast<float*>(std::calloc(texelCount * 4, sizeof(float))),
+        static_cast<float*>(std::calloc(texelCount * 4, sizeof(float))),
+    };
+    float* pass = static_cast<float*>(std::calloc(texelCount * 4, sizeof(float)));
+    u8* rounded = static_cast<u8*>(std::calloc(texelCount, 4));
+    if (!texture || !levels[0] || !levels[1] || !pass || !rounded)
+    {
+        std::free(texture);
+        std::free(levels[0]);
+        std::free(levels[1]);
+        std::free(pass);
+        std::free(rounded);
+        return nullptr;
+    }
+    *texture = header;
+
+    const TextureSrgbTables* srgb = desc->m_Srgb ? TextureGetSrgbTables() : nullptr;
+    for (size_t i = 0; i < texelCount * 4; i++)
+    {
+        const u8 value = image->m_Pixels[i];
+        levels[0][i] = srgb && i % 4 != 3 ? srgb->m_Decode[value] : static_cast<float>(value) / 255.0f;
+    }
+
+    const TextureKernel kernel = TextureMakeKernel(desc->m_Filter);
+    u8* base = reinterpret_cast<u8*>(texture);
+    for (u32 mip = 0; mip < mipCount; mip++)
+    {
+        const TextureMip* level = &texture->m_Mips[mip];
+        float* current = levels[mip % 2];
+
+        TextureStoreJob store =
+        {
+            .m_Source = current,
+            .m_Target = rounded,
+            .m_Width = level->m_Width,
+            .m_Srgb = srgb,
+        };
+        if (desc->m_Format == TextureFormat::RGBA8)
+        {
+            store.m_Target = base + level->m_Offset;
+        }
+        JobsWait(JobsDispatch(level->m_Height, TEXTURE_FILTER_BATCH, TextureStoreRange, &store));
+
+        if (desc->m_Format != TextureFormat::RGBA8)
+        {
+            TextureCompressJob compress =
+            {
+                .m_Texels = rounded,
+                .m_Target = base + level->m_Offset,
+                .m_Width = level->m_Width,
+                .m_Height = level->m_Height,
+                .m_RowPitch = level->m_RowPitch,
+                .m_Format = desc->m_Format,
+            };
+            JobsWait(JobsDispatch(level->m_RowCount, TEXTURE_COMPRESS_BATCH, TextureCompressRange, &compress));
+        }
+
+        if (mip + 1 == mipCount)
+        {
+            break;
+        }
+
+        // NOTE(sbalse): Halve the width, then the height, skipping a direction that is down to one texel.
+        const TextureMip* next = &texture->m_Mips[mip + 1];
+        float* target = levels[(mip + 1) % 2];
+        TextureFilterJob rows =
+        {
+            .m_Source = current,
+            .m_Target = next->m_Width < level->m_Width ? pass : current,
+            .m_SourceWidth = level->m_Width,
+            .m_SourceHeight = level->m_Height,
+            .m_TargetWidth = next->m_Width,
+            .m_Kernel = &kernel,
+        };
+        if (next->m_Width < level->m_Width)
+        {
+            JobsWait(JobsDispatch(level->m_Height, TEXTURE_FILTER_BATCH, TextureFilterRowsRange, &rows));
+        }
+
+        TextureFilterJob columns =
+        {
+            .m_Source = rows.m_Target,
+            .m_Target = target,
+            .m_SourceWidth = next->m_Width,
+            .m_SourceHeight = level->m_Height,
+            .m_TargetWidth = next->m_Width,
+            .m_Kernel = &kernel,
+        };
+        if (next->m_Height < level->m_Height)
+        {
+            JobsWait(JobsDispatch(next->m_Height, TEXTURE_FILTER_BATCH, TextureFilterColumnsRange, &columns));
+        }
+        else
+        {
+            const size_t floats = static_cast<size_t>(next->m_Width) * next->m_Height * 4;
+            std::memcpy(target, columns.m_Source, floats * sizeof(float));
+        }
+    }
+
+    std::free(levels[0]);
+    std::free(levels[1]);
+    std::free(pass);
+    std::free(rounded);
+
+    const u64 headerSize = TextureAlign(sizeof(TextureFile));
+    texture->m_ContentChecksum = SceneFileChecksum(base + headerSize, texture->m_Size - headerSize);
+    texture->m_HeaderChecksum = TextureHeaderChecksum(texture);
+    return texture;
+}
+
+void TextureFree(TextureFile* texture)
+{
+    std::free(texture);
+}
+
+bool TextureWrite(const char* path, const TextureFile* texture)
+{
+    std::FILE* stream = std::fopen(path, "wb");
+    if (!stream)
+    {
+        return false;
+    }
+
+    const bool written = std::fwrite(texture, 1, texture->m_Size, stream) == texture->m_Size;
+    return std::fclose(stream) == 0 && written;
+}
+
+const TextureFile* TextureBind(const void* data, const u64 size)
+{
+    if (!data || size < sizeof(TextureFile) || reinterpret_cast<uintptr_t>(data) % TEXTURE_ALIGNMENT != 0)
+    {
+        return nullptr;
+    }
+
+    const TextureFile* texture = static_cast<const TextureFile*>(data);
+    if (texture->m_Magic != TEXTURE_MAGIC
+        || texture->m_Version != TEXTURE_VERSION
+        || texture->m_Size != size
+        || texture->m_HeaderChecksum != TextureHeaderChecksum(texture)
+        || texture->m_Format >= static_cast<u32>(TextureFormat::COUNT)
+        || texture->m_MipCount == 0
+        || texture->m_MipCount > TEXTURE_MAX_MIPS
+        || texture->m_Width == 0
+        || texture->m_Height == 0)
+    {
+        return nullptr;
+    }
+
+    // NOTE(sbalse): Every level has to be the size its dimensions ask for and lie within the file.
+    const TextureFormat format = static_cast<TextureFormat>(texture->m_Format);
+    for (u32 mip = 0; mip < texture->m_MipCount; mip++)
+    {
+        const TextureMip* level = &texture->m_Mips[mip];
+        const u32 width = texture->m_Width >> mip ? texture->m_Width >> mip : 1;
+        const u32 height = texture->m_Height >> mip ? texture->m_Height >> mip : 1;
+        const TextureMip expected = TextureMakeMip(format, width, height, level->m_Offset);
+        if (std::memcmp(level, &expected, sizeof(expected)) != 0
+            || level->m_Offset % TEXTURE_ALIGNMENT != 0
+            || level->m_Offset < sizeof(TextureFile)
+            || level->m_Offset > size
+            || level->m_Size > size - level->m_Offset)
+        {
+            return nullptr;
+        }
+    }
+    return texture;
+}
+
+const void* TextureGetMipData(const TextureFile* texture, const u32 mip)
+{
+    return reinterpret_cast<const u8*>(texture) + texture->m_Mips[mip].m_Offset;
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include "types.h"
+
+/*
+* NOTE(sbalse): Texture import. Source images are decoded to RGBA8, a full mip chain is filtered down from them
+* and every level is block compressed, then everything goes into one texture file.
+*
+*   - Mips are filtered in float with SSE, one texel per register, from the float level above rather than the
+*     rounded one. Color textures are filtered in linear light. The Kaiser filter is a windowed sinc over eight
+*     texels per axis, sharper than the box filter, it can ring a little around hard edges.
+*   - BC1 stores a 4x4 block of RGB in 8 bytes and BC7 one of RGBA in 16, against 64 uncompressed. BC7 only
+*     uses mode 6, one pair of RGBA endpoints with 16 steps between them. Blocks are compressed on the job
+*     workers, one block row at a time.
+*   - A texture file is one block addressed by offsets from its start, with every level on a TEXTURE_ALIGNMENT
+*     boundary and stored the way D3D11 takes it. Loading binds it in place and hands the levels to the device
+*     as they are, nothing is touched per texel. The header checksum covers the header only for that reason.
+*
+* Width and height have to be powers of two.
+*/
+
+constexpr u32 TEXTURE_MAGIC = 0x52545854; // NOTE(sbalse): "TXTR".
+constexpr u32 TEXTURE_VERSION = 1;
+constexpr u32 TEXTURE_ALIGNMENT = 64;
+constexpr u32 TEXTURE_MAX_SIZE = 16384;
+constexpr u32 TEXTURE_MAX_MIPS = 15; // NOTE(sbalse): Down to 1x1 from TEXTURE_MAX_SIZE.
+constexpr u32 TEXTURE_FLAG_SRGB = 1u << 0;
+
+enum class TextureFormat : u32
+{
+    RGBA8,
+    BC1,
+    BC7,
+    COUNT
+};
+
+enum class TextureFilter
+{
+    BOX,
+    KAISER,
+    COUNT
+};
+
+// NOTE(sbalse): RGBA8, rows top to bottom with no padding.
+struct TextureImage
+{
+    u8* m_Pixels;
+    u32 m_Width;
+    u32 m_Height;
+};
+
+struct TextureBuildDesc
+{
+    TextureFormat m_Format;
+    TextureFilter m_Filter;
+    bool m_Srgb; // NOTE(sbalse): Color in sRGB, filtered in linear light and sampled through an sRGB format.
+};
+
+struct TextureMip
+{
+    u64 m_Offset;
+    u64 m_Size;
+    u32 m_Width;
+    u32 m_Height;
+    u32 m_RowPitch; // NOTE(sbalse): Bytes per row of texels, or per row of blocks for block compressed formats.
+    u32 m_RowCount;
+};
+
+// NOTE(sbalse): Start of a texture file.
+struct TextureFile
+{
+    u32 m_Magic;
+    u32 m_Version;
+    u64 m_Size; // NOTE(sbalse): Of the whole file.
+    u64 m_HeaderChecksum; // NOTE(sbalse): Of the header with this field set to 0.
+    // NOTE(sbalse): Of all levels. Tells textures apart without reading them, loading never checks it.
+    u64 m_ContentChecksum;
+    u32 m_Format; // NOTE(sbalse): A TextureFormat.
+    u32 m_Flags;
+    u32 m_Width;
+    u32 m_Height;
+    u32 m_MipCount;
+    u32 m_Reserved;
+    TextureMip m_Mips[TEXTURE_MAX_MIPS];
+};
+
+// NOTE(sbalse): Uncompressed or run length encoded true color TGA, 24 or 32 bits per pixel. Free the image with
+// TextureImageFree().
+bool TextureDecodeTga(const void* data, const u64 size, TextureImage* image);
+void TextureImageFree(TextureImage* image);
+
+// NOTE(sbalse): Returns nullptr when the image isn't a power of two in both directions or too large. Free the
+// result with TextureFree().
+TextureFile* TextureBuild(const TextureImage* image, const TextureBuildDesc* desc);
+void TextureFree(TextureFile* texture);
+bool TextureWrite(const char* path, const TextureFile* texture);
+// NOTE(sbalse): Validates a texture file in place, for example a mapped one. Returns nullptr when it isn't one.
+const TextureFile* TextureBind(const void* data, const u64 size);
+const void* TextureGetMipData(const TextureFile* texture, const u32 mip);
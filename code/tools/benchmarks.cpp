@@ -0,0 +1,1091 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "animclip.h"
+#include "broadphase.h"
+#include "clock.h"
+#include "coroutines.h"
+#include "framecapture.h"
+#include "jobs.h"
+#include "lightclusters.h"
+#include "particles.h"
+#include "random.h"
+#include "rewind.h"
+#include "scenefile.h"
+#include "texture.h"
+#include "tweens.h"
+#include "types.h"
+#include "utils.h"
+#include "graphics/meshgen.h"
+#include "graphics/rendergraph.h"
+
+/*
+* NOTE(sbalse): Micro benchmarks for engine systems that can run without a window or a device.
+*
+* Usage: benchmarks [name filter]
+*/
+
+namespace
+{
+    struct Benchmark
+    {
+        const char* m_Name;
+        // NOTE(sbalse): Runs the benchmarked code iterations times and returns an optional note to print.
+        const char* (*m_Run)(const u32 iterations);
+        u32 m_Iterations;
+    };
+
+    void BenchmarkRenderGraphExecute(const RenderGraph*, void*)
+    {
+    }
+
+    // NOTE(sbalse): A typical post processing chain: scene, a downsample and separable blur per bloom level,
+    // compose, and one pass nothing reads from that should get culled.
+    const char* BenchmarkRenderGraph(const u32 iterations)
+    {
+        constexpr u32 width = 1920;
+        constexpr u32 height = 1080;
+        constexpr u32 bloomLevels = 6;
+
+        static char s_Note[128] = {};
+
+        RenderGraphNullDevice device = {};
+        const RenderGraphBackend backend = RenderGraphNullBackend(&device);
+        RenderGraph* graph = RenderGraphCreate(&backend);
+        int backBuffer = 0;
+
+        for (u32 iteration = 0; iteration < iterations; iteration++)
+        {
+            RenderGraphReset(graph);
+
+            const RenderGraphTextureDesc backBufferDesc =
+            {
+                .m_Width = width,
+                .m_Height = height,
+                .m_Format = RenderGraphFormat::BGRA8_UNORM,
+                .m_BindFlags = RENDERGRAPH_BIND_RENDERTARGET,
+            };
+            const RenderGraphResource back = RenderGraphImportTexture(
+                graph,
+                "BACKBUFFER",
+                &backBufferDesc,
+                &backBuffer,
+                RenderGraphUsage::PRESENT,
+                RenderGraphUsage::PRESENT);
+            const RenderGraphResource depth = RenderGraphCreateTexture(
+                graph, "DEPTH", width, height, RenderGraphFormat::D32_FLOAT);
+            const RenderGraphResource scene = RenderGraphCreateTexture(
+                graph, "SCENE", width, height, RenderGraphFormat::RGBA16_FLOAT);
+
+            u32 pass = RenderGraphAddPass(graph, "SCENE", BenchmarkRenderGraphExecute, nullptr);
+            RenderGraphUse(graph, pass, scene, RenderGraphUsage::RENDERTARGET);
+            RenderGraphUse(graph, pass, depth, RenderGraphUsage::DEPTHWRITE);
+
+            const RenderGraphResource debug = RenderGraphCreateTexture(
+                graph, "DEBUG", width, height, RenderGraphFormat::RGBA8_UNORM);
+            pass = RenderGraphAddPass(graph, "DEBUG", BenchmarkRenderGraphExecute, nullptr);
+            RenderGraphUse(graph, pass, depth, RenderGraphUsage::SHADERREAD);
+            RenderGraphUse(graph, pass, debug, RenderGraphUsage::RENDERTARGET);
+
+            RenderGraphResource previous = scene;
+            for (u32 level = 0; level < bloomLevels; level++)
+            {
+                const u32 levelWidth = width >> (level + 1);
+                const u32 levelHeight = height >> (level + 1);
+                const RenderGraphResource down = RenderGraphCreateTexture(
+                    graph, "DOWN", levelWidth, levelHeight, RenderGraphFormat::RGBA16_FLOAT);
+                const RenderGraphResource blurX = RenderGraphCreateTexture(
+                    graph, "BLURX", levelWidth, levelHeight, RenderGraphFormat::RGBA16_FLOAT);
+                const RenderGraphResource blurY = RenderGraphCreateTexture(
+                    graph, "BLURY", levelWidth, levelHeight, RenderGraphFormat::RGBA16_FLOAT);
+
+                pass = RenderGraphAddPass(graph, "DOWNSAMPLE", BenchmarkRenderGraphExecute, nullptr);
+                RenderGraphUse(graph, pass, previous, RenderGraphUsage::SHADERREAD);
+                RenderGraphUse(graph, pass, down, RenderGraphUsage::RENDERTARGET);
+
+                pass = RenderGraphAddPass(graph, "BLURX", BenchmarkRenderGraphExecute, nullptr);
+                RenderGraphUse(graph, pass, down, RenderGraphUsage::SHADERREAD);
+                RenderGraphUse(graph, pass, blurX, RenderGraphUsage::RENDERTARGET);
+
+                pass = RenderGraphAddPass(graph, "BLURY", BenchmarkRenderGraphExecute, nullptr);
+                RenderGraphUse(graph, pass, blurX, RenderGraphUsage::SHADERREAD);
+                RenderGraphUse(graph, pass, blurY, RenderGraphUsage::RENDERTARGET);
+                previous = blurY;
+            }
+
+            pass = RenderGraphAddPass(graph, "COMPOSE", BenchmarkRenderGraphExecute, nullptr);
+            RenderGraphUse(graph, pass, scene, RenderGraphUsage::SHADERREAD);
+            RenderGraphUse(graph, pass, previous, RenderGraphUsage::SHADERREAD);
+            RenderGraphUse(graph, pass, back, RenderGraphUsage::RENDERTARGET);
+
+            RenderGraphCompile(graph);
+            RenderGraphExecute(graph);
+        }
+
+        const RenderGraphStats* stats = RenderGraphGetStats(graph);
+        std::snprintf(
+            s_Note, sizeof(s_Note),
+            "%u passes, %u culled, %u transients in %u textures, %.1f MB saved",
+            stats->m_DeclaredPasses,
+            stats->m_CulledPasses,
+            stats->m_TransientTextures,
+            stats->m_PhysicalTextures,
+            static_cast<double>(stats->m_AliasedBytesSaved) / (1024.0 * 1024.0));
+
+        RenderGraphDestroy(graph);
+        return s_Note;
+    }
+
+    // NOTE(sbalse): A stress mesh of two million triangles, generated at runtime.
+    const char* BenchmarkMeshGen(const u32 iterations)
+    {
+        constexpr u32 segments = 1024;
+        constexpr u32 sides = 1024;
+        constexpr MeshCounts counts = MeshTorusCounts(segments, sides);
+
+        static char s_Note[128] = {};
+
+        MeshVertex* vertices = static_cast<MeshVertex*>(std::calloc(counts.m_VertexCount, sizeof(MeshVertex)));
+        u32* indices = static_cast<u32*>(std::calloc(counts.m_IndexCount, sizeof(u32)));
+
+        const i64 start = ClockNow();
+        for (u32 iteration = 0; iteration < iterations; iteration++)
+        {
+            MeshGenerateTorus(segments, sides, 0.25f, vertices, indices);
+        }
+        const double seconds = ClockTicksToSeconds(ClockNow() - start);
+
+        std::snprintf(
+            s_Note, sizeof(s_Note),
+            "%u triangles, %.0f M triangles/s",
+            counts.m_IndexCount / 3,
+            static_cast<double>(counts.m_IndexCount / 3) * iterations / seconds / 1'000'000.0);
+
+        std::free(indices);
+        std::free(vertices);
+        return s_Note;
+    }
+
+    struct BenchmarkPopulateContext
+    {
+        float* m_Outputs[4];
+    };
+
+    void BenchmarkPopulateRange(void* context, const u32 begin, const u32 end)
+    {
+        const BenchmarkPopulateContext* populate = static_cast<const BenchmarkPopulateContext*>(context);
+        constexpr RandomInterval intervals[4] =
+        {
+            { .m_Min = 6.0f, .m_Max = 20.0f },
+            { .m_Min = 0.0f, .m_Max = 6.283f },
+            { .m_Min = 0.6f, .m_Max = 2.4f },
+            { .m_Min = 0.06f, .m_Max = 0.3f },
+        };
+        float* const outputs[4] =
+        {
+            populate->m_Outputs[0] + begin,
+            populate->m_Outputs[1] + begin,
+            populate->m_Outputs[2] + begin,
+            populate->m_Outputs[3] + begin,
+        };
+        RandomFillFloats(1, begin, end - begin, intervals, outputs);
+    }
+
+    // NOTE(sbalse): Populating a million boxes the way SimulationInit() does, spread over the job workers.
+    const char* BenchmarkPopulate(const u32 iterations)
+    {
+        constexpr u32 boxCount = 1'000'000;
+
+        static char s_Note[128] = {};
+
+        BenchmarkPopulateContext context = {};
+        for (u32 i = 0; i < 4; i++)
+        {
+            context.m_Outputs[i] = static_cast<float*>(std::calloc(boxCount, sizeof(float)));
+        }
+
+        const i64 start = ClockNow();
+        for (u32 iteration = 0; iteration < iterations; iteration++)
+        {
+            JobsWait(JobsDispatch(boxCount, 16384, BenchmarkPopulateRange, &context));
+        }
+        const double seconds = ClockTicksToSeconds(ClockNow() - start);
+
+        std::snprintf(
+            s_Note, sizeof(s_Note),
+            "%.0f M boxes/s with %u workers",
+            static_cast<double>(boxCount) * iterations / seconds / 1'000'000.0,
+            JobsWorkerCount());
+
+        for (u32 i = 0; i < 4; i++)
+        {
+            std::free(context.m_Outputs[i]);
+        }
+        return s_Note;
+    }
+
+    // NOTE(sbalse): Writes a scene of a million objects once, then measures mapping and verifying it, which is
+    // what startup pays. The file stays in the page cache, so this is the warm start.
+    const char* BenchmarkSceneFile(const u32 iterations)
+    {
+        constexpr u32 objectCount = 1'000'000;
+        constexpr const char* path = "benchmark.hwscene";
+
+        static char s_Note[128] = {};
+
+        constexpr size_t elementCount = static_cast<size_t>(objectCount) * SCENEFILE_STREAM_COUNT;
+        u32* streams = static_cast<u32*>(std::calloc(elementCount, sizeof(u32)));
+        SceneFileContents contents = {};
+        contents.m_ObjectCount = objectCount;
+        for (u32 i = 0; i < SCENEFILE_STREAM_COUNT; i++)
+        {
+            contents.m_Streams[i] = streams + (static_cast<size_t>(i) * objectCount);
+        }
+        for (size_t i = 0; i < elementCount; i++)
+        {
+            streams[i] = static_cast<u32>(i) * 2654435761u;
+        }
+        const SceneFileMesh mesh = { .m_Name = "CUBE" };
+        contents.m_Meshes = &mesh;
+        contents.m_MeshCount = 1;
+
+        const i64 writeStart = ClockNow();
+        const bool written = SceneFileWrite(path, &contents);
+        const double writeSeconds = ClockTicksToSeconds(ClockNow() - writeStart);
+
+        u32 opened = 0;
+        const i64 start = ClockNow();
+        for (u32 iteration = 0; written && iteration < iterations; iteration++)
+        {
+            SceneFile file = {};
+            opened += SceneFileOpen(&file, path) ? 1 : 0;
+            SceneFileClose(&file);
+        }
+        const double seconds = ClockTicksToSeconds(ClockNow() - start);
+
+        const double megabytes = static_cast<double>(elementCount * sizeof(u32)) / 1'000'000.0;
+        std::snprintf(
+            s_Note, sizeof(s_Note),
+            "%.0f MB, write %.1f ms, open %.2f ms, %u/%u valid",
+            megabytes,
+            writeSeconds * 1000.0,
+            opened ? seconds * 1000.0 / iterations : 0.0,
+            opened,
+            iterations);
+
+        std::remove(path);
+        std::free(streams);
+        return s_Note;
+    }
+
+    // NOTE(sbalse): Integrates and packs an emitter of about half a million particles at 60 Hz, with AVX2 and
+    // with the scalar path. Particles die and spawn all the time, so the packing has gaps to close.
+    const char* BenchmarkParticles(const u32 iterations)
+    {
+        constexpr u32 capacity = 1'000'000;
+        constexpr float stepSeconds = 1.0f / 60.0f;
+
+        static char s_Note[160] = {};
+
+        const ParticleEmitterDesc desc =
+        {
+            .m_Position = { 0.0f, -6.0f, 20.0f },
+            .m_Velocity = { 0.0f, 8.0f, 0.0f },
+            .m_VelocitySpread = { 3.0f, 1.0f, 3.0f },
+            .m_LifetimeMin = 1.0f,
+            .m_LifetimeMax = 9.0f,
+            .m_Rate = 200'000.0f,
+            .m_Color = QuantizeColor(1.0f, 0.6f, 0.2f, 1.0f),
+            .m_Seed = 1,
+        };
+        const ParticleForces forces =
+        {
+            .m_Gravity = { 0.0f, -9.8f, 0.0f },
+            .m_Drag = 0.3f,
+        };
+
+        double particlesPerMs[2] = {};
+        for (u32 simd = 0; simd < 2; simd++)
+        {
+            ParticlesEnableSimd(simd == 1);
+            ParticleEmitter* emitter = ParticleEmitterCreate(&desc, capacity);
+
+            // NOTE(sbalse): Fill the pool with particles of all ages first.
+            for (u32 i = 0; i < 5; i++)
+            {
+                ParticleEmitterUpdate(emitter, &forces, 1.0f);
+            }
+
+            u64 updated = 0;
+            const i64 start = ClockNow();
+            for (u32 iteration = 0; iteration < iterations; iteration++)
+            {
+                ParticleEmitterUpdate(emitter, &forces, stepSeconds);
+                updated += ParticleEmitterGetPool(emitter)->m_Count;
+            }
+            particlesPerMs[simd] = static_cast<double>(updated) / (ClockTicksToSeconds(ClockNow() - start) * 1000.0);
+
+            ParticleEmitterDestroy(emitter);
+        }
+        ParticlesEnableSimd(true);
+
+        std::snprintf(
+            s_Note, sizeof(s_Note),
+            "%.0f k particles/ms %s, %.0f k scalar, %u workers",
+            (ParticlesSimdEnabled() ? particlesPerMs[1] : particlesPerMs[0]) / 1000.0,
+            ParticlesSimdEnabled() ? "AVX2" : "(no AVX2)",
+            particlesPerMs[0] / 1000.0,
+            JobsWorkerCount());
+        return s_Note;
+    }
+
+    // NOTE(sbalse): 100k boxes drifting through a volume with a few overlaps each, updated once per iteration. The
+    // volume is crowded along the sort axis, so every box passes about twenty others there per update. That is too
+    // many moves for the insertion sort to beat sorting from scratch, the note says how many updates resorted.
+    const char* BenchmarkBroadphase(const u32 iterations)
+    {
+        constexpr u32 objectCount = 100'000;
+        constexpr float extent = 160.0f;
+        constexpr float speed = 0.05f;
+
+        static char s_Note[160] = {};
+
+        float* memory = static_cast<float*>(std::calloc(static_cast<size_t>(objectCount) * 9, sizeof(float)));
+        float* min[3] = { memory, memory + objectCount, memory + (objectCount * 2) };
+        float* max[3] = { memory + (objectCount * 3), memory + (objectCount * 4), memory + (objectCount * 5) };
+        float* velocity[3] = { memory + (objectCount * 6), memory + (objectCount * 7), memory + (objectCount * 8) };
+        for (u32 i = 0; i < objectCount; i++)
+        {
+            const RandomBlock block = RandomPhilox(1, i);
+            const float halfSize = RandomFloat(block.m_Values[3], { .m_Min = 0.5f, .m_Max = 1.5f });
+            for (u32 axis = 0; axis < 3; axis++)
+            {
+                const float center = RandomFloat(block.m_Values[axis], { .m_Min = 0.0f, .m_Max = extent });
+                min[axis][i] = center - halfSize;
+                max[axis][i] = center + halfSize;
+                velocity[axis][i] = RandomFloat(block.m_Values[(axis + 1) % 3], { .m_Min = -speed, .m_Max = speed });
+            }
+        }
+
+        const BroadphaseBounds bounds = { .m_Min = { min[0], min[1], min[2] }, .m_Max = { max[0], max[1], max[2] } };
+        Broadphase* broadphase = BroadphaseCreate(objectCount);
+        BroadphaseUpdate(broadphase, &bounds, objectCount);
+
+        i64 ticks = 0;
+        u64 pairs = 0;
+        u64 swaps = 0;
+        u32 resorts = 0;
+        for (u32 iteration = 0; iteration < iterations; iteration++)
+        {
+            for (u32 axis = 0; axis < 3; axis++)
+            {
+                for (u32 i = 0; i < objectCount; i++)
+                {
+                    min[axis][i] += velocity[axis][i];
+                    max[axis][i] += velocity[axis][i];
+                }
+            }
+
+            const i64 start = ClockNow();
+            pairs += BroadphaseUpdate(broadphase, &bounds, objectCount);
+            ticks += ClockNow() - start;
+            swaps += BroadphaseGetStats(broadphase)->m_Swaps;
+            resorts += BroadphaseGetStats(broadphase)->m_Resorted ? 1 : 0;
+        }
+
+        std::snprintf(
+            s_Note, sizeof(s_Note),
+            "%.3f ms per update, %llu pairs, %u of %u resorted, %llu swaps, %u workers",
+            ClockTicksToMilliseconds(ticks) / iterations,
+            static_cast<unsigned long long>(pairs / iterations),
+            resorts,
+            iterations,
+            static_cast<unsigned long long>(swaps / iterations),
+            JobsWorkerCount());
+
+        BroadphaseDestroy(broadphase);
+        std::free(memory);
+        return s_Note;
+    }
+
+    // NOTE(sbalse): A million tweens with every ease and wrap mixed together, driving four streams of a quarter
+    // million transforms, updated at 60 Hz with AVX2 and with the scalar path.
+    const char* BenchmarkTweens(const u32 iterations)
+    {
+        constexpr u32 tweenCount = 1'000'000;
+        constexpr u32 streamCount = 4;
+        constexpr u32 streamLength = tweenCount / streamCount;
+        constexpr float stepSeconds = 1.0f / 60.0f;
+
+        static char s_Note[160] = {};
+
+        float* memory = static_cast<float*>(std::calloc(tweenCount, sizeof(float)));
+        float* const outputs[streamCount] =
+        {
+            memory,
+            memory + streamLength,
+            memory + (streamLength * 2),
+            memory + (streamLength * 3),
+        };
+
+        const TweenKey keys[] =
+        {
+            { .m_Time = 0.0f, .m_Value = 0.0f },
+            { .m_Time = 0.25f, .m_Value = 1.2f },
+            { .m_Time = 0.6f, .m_Value = 0.8f },
+            { .m_Time = 1.0f, .m_Value = 1.0f },
+        };
+
+        double tweensPerMs[2] = {};
+        for (u32 simd = 0; simd < 2; simd++)
+        {
+            TweensEnableSimd(simd == 1);
+            TweenPool* pool = TweenPoolCreate(tweenCount);
+            const TweenCurve keyframes = TweenPoolAddCurve(pool, keys, static_cast<u32>(ArraySize(keys)));
+            for (u32 i = 0; i < tweenCount; i++)
+            {
+                const RandomBlock block = RandomPhilox(2, i);
+                const u32 curve = block.m_Values[0] % (static_cast<u32>(TweenEase::COUNT) + 1);
+                const TweenDesc desc =
+                {
+                    .m_From = RandomFloat(block.m_Values[1], { .m_Min = -10.0f, .m_Max = 10.0f }),
+                    .m_Delta = RandomFloat(block.m_Values[2], { .m_Min = -5.0f, .m_Max = 5.0f }),
+                    .m_Duration = RandomFloat(block.m_Values[3], { .m_Min = 0.25f, .m_Max = 4.0f }),
+                    .m_Offset = 0.0f,
+                    .m_Curve = curve < static_cast<u32>(TweenEase::COUNT) ? curve : keyframes,
+                    .m_Wrap = static_cast<TweenWrap>(i % static_cast<u32>(TweenWrap::COUNT)),
+                    .m_Stream = i / streamLength,
+                    .m_Index = i % streamLength,
+                };
+                TweenAdd(pool, &desc);
+            }
+
+            const i64 start = ClockNow();
+            for (u32 iteration = 0; iteration < iterations; iteration++)
+            {
+                TweenPoolUpdate(pool, stepSeconds, outputs);
+            }
+            const double milliseconds = ClockTicksToMilliseconds(ClockNow() - start);
+            tweensPerMs[simd] = static_cast<double>(tweenCount) * iterations / milliseconds;
+
+            TweenPoolDestroy(pool);
+        }
+        TweensEnableSimd(true);
+
+        std::snprintf(
+            s_Note, sizeof(s_Note),
+            "%.0f k tweens/ms %s, %.0f k scalar, %u workers",
+            (TweensSimdEnabled() ? tweensPerMs[1] : tweensPerMs[0]) / 1000.0,
+            TweensSimdEnabled() ? "AVX2" : "(no AVX2)",
+            tweensPerMs[0] / 1000.0,
+            JobsWorkerCount());
+
+        std::free(memory);
+        return s_Note;
+    }
+
+    // NOTE(sbalse): What sampling costs without compression, the two frames around the time blended the same way.
+    void BenchmarkSampleRaw(const AnimClipSource* source, const float* times, const u32 count, AnimTransform* poses)
+    {
+        const float last = static_cast<float>(source->m_FrameCount - 1);
+        for (u32 track = 0; track < source->m_TrackCount; track++)
+        {
+            for (u32 i = 0; i < count; i++)
+            {
+                const float position = times[i] * source->m_FrameRate;
+                const float clamped = position > 0.0f ? (position < last ? position : last) : 0.0f;
+                const u32 frame = static_cast<u32>(clamped);
+                const u32 next = frame + 1 < source->m_FrameCount ? frame + 1 : frame;
+                const float t = clamped - static_cast<float>(frame);
+                const AnimTransform* a = &source->m_Frames[(frame * source->m_TrackCount) + track];
+                const AnimTransform* b = &source->m_Frames[(next * source->m_TrackCount) + track];
+                AnimTransform* pose = &poses[(i * source->m_TrackCount) + track];
+
+                const float dot = a->m_Rotation[0] * b->m_Rotation[0] + a->m_Rotation[1] * b->m_Rotation[1]
+                    + a->m_Rotation[2] * b->m_Rotation[2] + a->m_Rotation[3] * b->m_Rotation[3];
+                float lengthSquared = 0.0f;
+                for (u32 j = 0; j < 4; j++)
+                {
+                    const float target = dot < 0.0f ? -b->m_Rotation[j] : b->m_Rotation[j];
+                    pose->m_Rotation[j] = a->m_Rotation[j] + (target - a->m_Rotation[j]) * t;
+                    lengthSquared += pose->m_Rotation[j] * pose->m_Rotation[j];
+                }
+                const float length = std::sqrt(lengthSquared);
+                for (u32 j = 0; j < 4; j++)
+                {
+                    pose->m_Rotation[j] /= length;
+                }
+                for (u32 j = 0; j < 3; j++)
+                {
+                    pose->m_Translation[j] = a->m_Translation[j] + (b->m_Translation[j] - a->m_Translation[j]) * t;
+                }
+            }
+        }
+    }
+
+    const char* BenchmarkAnimClip(const u32 iterations)
+    {
+        constexpr u32 trackCount = 64;
+        constexpr u32 frameCount = 600;
+        constexpr u32 instanceCount = 256;
+        constexpr float frameRate = 30.0f;
+        constexpr AnimClipTolerance tolerance = { .m_Rotation = 0.002f, .m_Translation = 0.001f };
+
+        static char s_Note[160] = {};
+
+        // NOTE(sbalse): A skeleton swinging every bone about its own axis, a quarter of the bones never move.
+        AnimTransform* frames =
+            static_cast<AnimTransform*>(std::calloc(trackCount * frameCount, sizeof(AnimTransform)));
+        for (u32 track = 0; track < trackCount; track++)
+        {
+            const RandomBlock block = RandomPhilox(3, track);
+            const float axis[3] =
+            {
+                RandomFloat(block.m_Values[0], { .m_Min = -1.0f, .m_Max = 1.0f }),
+                RandomFloat(block.m_Values[1], { .m_Min = -1.0f, .m_Max = 1.0f }),
+                RandomFloat(block.m_Values[2], { .m_Min = 0.1f, .m_Max = 1.0f }),
+            };
+            const float axisLength = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+            const float speed = RandomFloat(block.m_Values[3], { .m_Min = 0.3f, .m_Max = 1.5f });
+            const bool still = track % 4 == 0;
+
+            for (u32 frame = 0; frame < frameCount; frame++)
+            {
+                const float seconds = static_cast<float>(frame) / frameRate;
+                const float angle = still ? 0.5f : std::sin(seconds * speed) + 0.3f * std::sin(seconds * speed * 3.1f);
+                AnimTransform* transform = &frames[(frame * trackCount) + track];
+                for (u32 i = 0; i < 3; i++)
+                {
+                    transform->m_Rotation[i] = axis[i] / axisLength * std::sin(angle * 0.5f);
+                }
+                transform->m_Rotation[3] = std::cos(angle * 0.5f);
+                transform->m_Translation[0] = static_cast<float>(track) * 0.1f;
+                transform->m_Translation[1] = still ? 1.0f : 0.2f * std::sin(seconds * speed);
+                transform->m_Translation[2] = still ? 0.0f : 0.05f * seconds;
+            }
+        }
+
+        const AnimClipSource source =
+        {
+            .m_Frames = frames,
+            .m_TrackCount = trackCount,
+            .m_FrameCount = frameCount,
+            .m_FrameRate = frameRate,
+        };
+        AnimClip* clip = AnimClipCompress(&source, &tolerance);
+
+        float times[instanceCount] = {};
+        for (u32 i = 0; i < instanceCount; i++)
+        {
+            const float duration = static_cast<float>(frameCount - 1) / frameRate;
+            times[i] = RandomFloat(RandomPhilox(4, i).m_Values[0], { .m_Min = 0.0f, .m_Max = duration });
+        }
+        AnimTransform* poses =
+            static_cast<AnimTransform*>(std::calloc(trackCount * instanceCount, sizeof(AnimTransform)));
+
+        // NOTE(sbalse): Scalar, AVX2 and uncompressed.
+        double posesPerMs[3] = {};
+        for (u32 mode = 0; mode < 3; mode++)
+        {
+            AnimClipEnableSimd(mode == 1);
+            const i64 start = ClockNow();
+            for (u32 iteration = 0; iteration < iterations; iteration++)
+            {
+                if (mode == 2)
+                {
+                    BenchmarkSampleRaw(&source, times, instanceCount, poses);
+                }
+                else
+                {
+                    AnimClipSample(clip, times, instanceCount, poses);
+                }
+            }
+            const double milliseconds = ClockTicksToMilliseconds(ClockNow() - start);
+            posesPerMs[mode] = static_cast<double>(trackCount) * instanceCount * iterations / milliseconds;
+        }
+        AnimClipEnableSimd(true);
+
+        std::snprintf(
+            s_Note, sizeof(s_Note),
+            "%.0f KB from %.0f KB, %.0f k bones/ms %s, %.0f k scalar, %.0f k uncompressed",
+            static_cast<double>(clip->m_Size) / 1024.0,
+            static_cast<double>(trackCount) * frameCount * sizeof(AnimTransform) / 1024.0,
+            (AnimClipSimdEnabled() ? posesPerMs[1] : posesPerMs[0]) / 1000.0,
+            AnimClipSimdEnabled() ? "AVX2" : "(no AVX2)",
+            posesPerMs[0] / 1000.0,
+            posesPerMs[2] / 1000.0);
+
+        AnimClipFree(clip);
+        std::free(poses);
+        std::free(frames);
+        return s_Note;
+    }
+
+    const char* BenchmarkLightClusters(const u32 iterations)
+    {
+        constexpr u32 lightCount = 10'000;
+        // NOTE(sbalse): The frustum of g_ProjectionMatrix.
+        constexpr LightClustersFrustum frustum = { .m_Width = 1.0f, .m_Height = 0.75f, .m_Near = 0.5f, .m_Far = 40.0f };
+
+        static char s_Note[160] = {};
+
+        // NOTE(sbalse): Lights spread evenly through the volume of the frustum, every third one a spot light.
+        float* memory = static_cast<float*>(std::calloc(lightCount * 8, sizeof(float)));
+        float* position[3] = { memory, memory + lightCount, memory + (lightCount * 2) };
+        float* range = memory + (lightCount * 3);
+        float* direction[3] = { memory + (lightCount * 4), memory + (lightCount * 5), memory + (lightCount * 6) };
+        float* spotCosine = memory + (lightCount * 7);
+        for (u32 i = 0; i < lightCount; i++)
+        {
+            const RandomBlock block = RandomPhilox(5, i);
+            const RandomBlock shape = RandomPhilox(6, i);
+            const float depth = frustum.m_Far * std::cbrt(RandomUnitFloat(block.m_Values[0]));
+            position[2][i] = depth > 1.0f ? depth : 1.0f;
+            position[0][i] = RandomFloat(block.m_Values[1], { .m_Min = -1.0f, .m_Max = 1.0f }) * position[2][i]
+                * (frustum.m_Width * 0.5f / frustum.m_Near);
+            position[1][i] = RandomFloat(block.m_Values[2], { .m_Min = -1.0f, .m_Max = 1.0f }) * position[2][i]
+                * (frustum.m_Height * 0.5f / frustum.m_Near);
+            range[i] = RandomFloat(block.m_Values[3], { .m_Min = 0.25f, .m_Max = 1.0f });
+
+            const float z = RandomFloat(shape.m_Values[0], { .m_Min = -1.0f, .m_Max = 1.0f });
+            const float angle = RandomFloat(shape.m_Values[1], { .m_Min = 0.0f, .m_Max = 6.2831853f });
+            const float planar = std::sqrt(1.0f - z * z);
+            direction[0][i] = planar * std::cos(angle);
+            direction[1][i] = planar * std::sin(angle);
+            direction[2][i] = z;
+            spotCosine[i] = i % 3 == 0
+                ? std::cos(RandomFloat(shape.m_Values[2], { .m_Min = 0.2f, .m_Max = 1.0f }))
+                : -1.0f;
+        }
+
+        const LightClustersLights lights =
+        {
+            .m_Position = { position[0], position[1], position[2] },
+            .m_Range = range,
+            .m_Direction = { direction[0], direction[1], direction[2] },
+            .m_SpotCosine = spotCosine,
+        };
+
+        double microseconds[2] = {};
+        LightClusters* clusters = LightClustersCreate(lightCount);
+        for (u32 simd = 0; simd < 2; simd++)
+        {
+            LightClustersEnableSimd(simd == 1);
+            const i64 start = ClockNow();
+            for (u32 iteration = 0; iteration < iterations; iteration++)
+            {
+                LightClustersUpdate(clusters, &frustum, &lights, lightCount);
+            }
+            microseconds[simd] = ClockTicksToMilliseconds(ClockNow() - start) * 1000.0 / iterations;
+        }
+        LightClustersEnableSimd(true);
+
+        const LightClustersStats* stats = LightClustersGetStats(clusters);
+        std::snprintf(
+            s_Note, sizeof(s_Note),
+            "%.0f us %s, %.0f us scalar, %u visible, %.1f per cluster, %u max, %u workers",
+            LightClustersSimdEnabled() ? microseconds[1] : microseconds[0],
+            LightClustersSimdEnabled() ? "AVX2" : "(no AVX2)",
+            microseconds[0],
+            stats->m_Visible,
+            static_cast<double>(stats->m_Indices) / LIGHTCLUSTERS_COUNT,
+            stats->m_MaxClusterLights,
+            JobsWorkerCount());
+
+        LightClustersDestroy(clusters);
+        std::free(memory);
+        return s_Note;
+    }
+
+    // NOTE(sbalse): A color texture with smooth gradients, hard edges and noise. Throughput is of source bytes,
+    // mip generation is timed by building without compression.
+    const char* BenchmarkTextures(const u32 iterations)
+    {
+        constexpr u32 size = 512;
+
+        static char s_Note[160] = {};
+
+        u8* pixels = static_cast<u8*>(std::calloc(size * size, 4));
+        for (u32 y = 0; y < size; y++)
+        {
+            for (u32 x = 0; x < size; x++)
+            {
+                const RandomBlock block = RandomPhilox(7, (y * size) + x);
+                const bool checker = ((x / 32) + (y / 32)) % 2 == 0;
+                u8* pixel = pixels + (((y * size) + x) * 4);
+                pixel[0] = static_cast<u8>(128.0f + 100.0f * std::sin(static_cast<float>(x) * 0.03f));
+                pixel[1] = static_cast<u8>((y / 2) + (checker ? 0 : 40));
+                pixel[2] = static_cast<u8>(block.m_Values[0] & 31) + (checker ? 200 : 20);
+                pixel[3] = 255;
+            }
+        }
+        const TextureImage image = { .m_Pixels = pixels, .m_Width = size, .m_Height = size };
+
+        // NOTE(sbalse): RGBA8, BC1 and BC7.
+        double milliseconds[3] = {};
+        u64 bytes[3] = {};
+        for (u32 format = 0; format < 3; format++)
+        {
+            const TextureBuildDesc desc =
+            {
+                .m_Format = static_cast<TextureFormat>(format),
+                .m_Filter = TextureFilter::KAISER,
+                .m_Srgb = true,
+            };
+            const i64 start = ClockNow();
+            for (u32 iteration = 0; iteration < iterations; iteration++)
+            {
+                TextureFile* texture = TextureBuild(&image, &desc);
+                bytes[format] = texture->m_Size;
+                TextureFree(texture);
+            }
+            milliseconds[format] = ClockTicksToMilliseconds(ClockNow() - start) / iterations;
+        }
+
+        const double megabytes = static_cast<double>(size) * size * 4 / (1024.0 * 1024.0);
+        std::snprintf(
+            s_Note, sizeof(s_Note),
+            "BC1 %.1f MB/s %.1fx smaller, BC7 %.1f MB/s %.1fx smaller, mips %.1f ms, %u workers",
+            megabytes * 1000.0 / (milliseconds[1] - milliseconds[0]),
+            static_cast<double>(bytes[0]) / static_cast<double>(bytes[1]),
+            megabytes * 1000.0 / (milliseconds[2] - milliseconds[0]),
+            static_cast<double>(bytes[0]) / static_cast<double>(bytes[2]),
+            milliseconds[0],
+            JobsWorkerCount());
+
+        std::free(pixels);
+        return s_Note;
+    }
+
+    // NOTE(sbalse): Captures a 720p frame every iteration from memory, the frame loop only pays for the copy. Frames
+    // the workers and the disk couldn't keep up with are dropped and reported.
+    const char* BenchmarkFrameCapture(const u32 iterations)
+    {
+        constexpr u32 width = 1280;
+        constexpr u32 height = 720;
+        constexpr const char* path = "benchmark.hwcap";
+
+        static char s_Note[160] = {};
+
+        u8* pixels = static_cast<u8*>(std::calloc(width * height, 4));
+        FrameCaptureMemorySource source =
+        {
+            .m_Pixels = pixels,
+            .m_Pitch = width * 4,
+            .m_Height = height,
+            .m_Copies = {},
+        };
+        const FrameCaptureBackend backend = FrameCaptureMemoryBackend(&source);
+        const FrameCaptureDesc desc =
+        {
+            .m_Path = path,
+            .m_Width = width,
+            .m_Height = height,
+            .m_Format = FrameCaptureFormat::BGRA8,
+            .m_SlotCount = 4,
+            .m_Latency = 2,
+        };
+
+        FrameCapture* capture = FrameCaptureCreate(&desc, &backend);
+        if (!capture)
+        {
+            std::free(pixels);
+            return "failed to create the capture file";
+        }
+
+        double updateMilliseconds = 0.0;
+        const i64 start = ClockNow();
+        for (u32 frame = 0; frame < iterations; frame++)
+        {
+            // NOTE(sbalse): A scrolling gradient with some noise, compresses about as well as a rendered frame.
+            for (u32 y = 0; y < height; y++)
+            {
+                u8* row = pixels + (y * width * 4);
+                for (u32 x = 0; x < width; x++)
+                {
+                    const u32 noise = RandomPhilox(frame, (y * width) + x).m_Values[0];
+                    row[(x * 4) + 0] = static_cast<u8>((x + frame) / 5);
+                    row[(x * 4) + 1] = static_cast<u8>(y / 3);
+                    row[(x * 4) + 2] = static_cast<u8>((noise & 3) + ((x / 64 + y / 64) % 2 ? 180 : 40));
+                    row[(x * 4) + 3] = 255;
+                }
+            }
+
+            const i64 updateStart = ClockNow();
+            FrameCaptureUpdate(capture, true);
+            updateMilliseconds += ClockTicksToMilliseconds(ClockNow() - updateStart);
+        }
+
+        const FrameCaptureStats stats = FrameCaptureGetStats(capture);
+        FrameCaptureDestroy(capture);
+        const double seconds = ClockTicksToSeconds(ClockNow() - start);
+
+        FrameCaptureFileHeader header = {};
+        FrameCaptureReader* reader = FrameCaptureReaderOpen(path, &header);
+        u32 frames = 0;
+        u64 frameIndex = 0;
+        while (reader && FrameCaptureReadFrame(reader, &frameIndex, pixels))
+        {
+            frames++;
+        }
+        if (reader)
+        {
+            FrameCaptureReaderClose(reader);
+        }
+
+        std::FILE* file = std::fopen(path, "rb");
+        long fileBytes = 0;
+        if (file)
+        {
+            std::fseek(file, 0, SEEK_END);
+            fileBytes = std::ftell(file);
+            std::fclose(file);
+        }
+        std::remove(path);
+
+        const double rawBytes = static_cast<double>(frames) * width * height * 4;
+        std::snprintf(
+            s_Note, sizeof(s_Note),
+            "%.0f MB/s %.1fx smaller, update %.3f ms, %u written %llu dropped, %u workers",
+            rawBytes / (1024.0 * 1024.0) / seconds,
+            fileBytes ? rawBytes / static_cast<double>(fileBytes) : 0.0,
+            updateMilliseconds / iterations,
+            frames,
+            static_cast<unsigned long long>(stats.m_Dropped),
+            JobsWorkerCount());
+
+        FrameCaptureMemoryFree(&source);
+        std::free(pixels);
+        return s_Note;
+    }
+
+    // NOTE(sbalse): Steps the two tween phases of a million boxes, what the simulation records, and snapshots every
+    // step. Once with every box moving and compared, once with a packed 1% of them moving and marked as changed.
+    const char* BenchmarkRewind(const u32 iterations)
+    {
+        constexpr u32 boxCount = 1'000'000;
+        constexpr u32 rewindSteps = 60;
+        constexpr float stepSeconds = 1.0f / 60.0f;
+        constexpr double frameMs = 1000.0 / 60.0;
+
+        static char s_Note[200] = {};
+
+        // NOTE(sbalse): The self rotation phases, then the world rotation ones.
+        float* phases = static_cast<float*>(std::calloc(static_cast<size_t>(boxCount) * 2, sizeof(float)));
+        float* rate = static_cast<float*>(std::calloc(static_cast<size_t>(boxCount) * 2, sizeof(float)));
+        for (u32 i = 0; i < boxCount * 2; i++)
+        {
+            const RandomBlock block = RandomPhilox(5, i);
+            phases[i] = RandomFloat(block.m_Values[0], { .m_Min = 0.0f, .m_Max = 1.0f });
+            rate[i] = RandomFloat(block.m_Values[1], { .m_Min = 0.05f, .m_Max = 0.4f });
+        }
+
+        double captureMs[2] = {};
+        double ratio[2] = {};
+        double restoreMs = 0.0;
+        u32 heldSteps = 0;
+        for (u32 run = 0; run < 2; run++)
+        {
+            const bool tracked = run == 1;
+            const u32 moving = tracked ? boxCount / 100 : boxCount;
+            const RewindRegion regions[] =
+            {
+                { .m_Data = phases, .m_Size = boxCount * 2 * sizeof(float), .m_Tracked = tracked },
+            };
+            const RewindDesc desc =
+            {
+                .m_Regions = regions,
+                .m_RegionCount = static_cast<u32>(ArraySize(regions)),
+                .m_Budget = 256ull * 1024 * 1024,
+            };
+
+            Rewind* rewind = RewindCreate(&desc, 0);
+            u64 stateBytes = 0;
+            u64 deltaBytes = 0;
+            for (u32 step = 1; step <= iterations; step++)
+            {
+                for (u32 axis = 0; axis < 2; axis++)
+                {
+                    const size_t offset = static_cast<size_t>(axis) * boxCount;
+                    for (u32 i = 0; i < moving; i++)
+                    {
+                        const float phase = phases[offset + i] + (rate[offset + i] * stepSeconds);
+                        phases[offset + i] = phase < 1.0f ? phase : phase - 1.0f;
+                    }
+                }
+
+                const i64 start = ClockNow();
+                if (tracked)
+                {
+                    for (u32 axis = 0; axis < 2; axis++)
+                    {
+                        const size_t offset = static_cast<size_t>(axis) * boxCount;
+                        RewindMarkChanged(rewind, phases + offset, moving * sizeof(float));
+                    }
+                }
+                RewindCapture(rewind, step);
+                captureMs[run] += ClockTicksToMilliseconds(ClockNow() - start);
+
+                const RewindStats stats = RewindGetStats(rewind);
+                stateBytes += static_cast<u64>(stats.m_ChangedPages) * REWIND_PAGE_SIZE;
+                deltaBytes += stats.m_DeltaBytes;
+            }
+            captureMs[run] /= iterations;
+            ratio[run] = deltaBytes ? static_cast<double>(stateBytes) / static_cast<double>(deltaBytes) : 0.0;
+
+            if (run == 0)
+            {
+                const RewindStats stats = RewindGetStats(rewind);
+                heldSteps = static_cast<u32>(stats.m_NewestStep - stats.m_OldestStep);
+                const u64 target = stats.m_NewestStep - (rewindSteps < heldSteps ? rewindSteps : heldSteps);
+                const i64 start = ClockNow();
+                RewindRestore(rewind, target);
+                restoreMs = ClockTicksToMilliseconds(ClockNow() - start);
+            }
+            RewindDestroy(rewind);
+        }
+
+        std::snprintf(
+            s_Note, sizeof(s_Note),
+            "all moving %.2f ms (%.1f%% of a frame) %.1fx smaller, 1%% moving %.3f ms %.1fx smaller, "
+            "back %u steps %.1f ms, %u workers",
+            captureMs[0],
+            captureMs[0] * 100.0 / frameMs,
+            ratio[0],
+            captureMs[1],
+            ratio[1],
+            rewindSteps < heldSteps ? rewindSteps : heldSteps,
+            restoreMs,
+            JobsWorkerCount());
+
+        std::free(rate);
+        std::free(phases);
+        return s_Note;
+    }
+
+    CoroutineTask BenchmarkSleeperTask()
+    {
+        for (;;)
+        {
+            co_await CoroutineSeconds(3600.0);
+        }
+    }
+
+    CoroutineTask BenchmarkActionTask(const u32 action)
+    {
+        for (;;)
+        {
+            co_await CoroutineAction(action);
+        }
+    }
+
+    CoroutineTask BenchmarkFrameTask(u32* frames)
+    {
+        for (;;)
+        {
+            (*frames)++;
+            co_await CoroutineNextFrame();
+        }
+    }
+
+    // NOTE(sbalse): Thousands of tasks that sleep or wait on actions that never fire, and a few that run every
+    // frame. An update should only cost as much as the few.
+    const char* BenchmarkCoroutines(const u32 iterations)
+    {
+        constexpr u32 sleepers = 3000;
+        constexpr u32 waiters = 1000;
+        constexpr u32 runners = 16;
+
+        static char s_Note[160] = {};
+
+        CoroutinesInit();
+        u32 frames = 0;
+        for (u32 i = 0; i < sleepers; i++)
+        {
+            CoroutinesSpawn(BenchmarkSleeperTask());
+        }
+        for (u32 i = 0; i < waiters; i++)
+        {
+            CoroutinesSpawn(BenchmarkActionTask(1 + (i % (ACTIONMAP_MAX_ACTIONS - 1))));
+        }
+        for (u32 i = 0; i < runners; i++)
+        {
+            CoroutinesSpawn(BenchmarkFrameTask(&frames));
+        }
+
+        // NOTE(sbalse): Action 0 fires every frame, nothing waits on it.
+        ActionSet actions = {};
+        actions.m_Words[0] = 1;
+
+        const i64 start = ClockNow();
+        for (u32 iteration = 0; iteration < iterations; iteration++)
+        {
+            CoroutinesUpdate(&actions);
+        }
+        const double seconds = ClockTicksToSeconds(ClockNow() - start);
+
+        const CoroutineStats* stats = CoroutinesGetStats();
+        std::snprintf(
+            s_Note, sizeof(s_Note),
+            "%u tasks, %u resumed per update, %.3f us per update, %u small frames left",
+            stats->m_Live,
+            stats->m_Resumed,
+            seconds * 1'000'000.0 / iterations,
+            stats->m_FreeSmallFrames);
+
+        CoroutinesShutdown();
+        return s_Note;
+    }
+
+    constexpr Benchmark g_Benchmarks[] =
+    {
+        { "rendergraph", BenchmarkRenderGraph, 100'000 },
+        { "meshgen", BenchmarkMeshGen, 50 },
+        { "scenefile", BenchmarkSceneFile, 100 },
+        { "populate", BenchmarkPopulate, 100 },
+        { "particles", BenchmarkParticles, 200 },
+        { "broadphase", BenchmarkBroadphase, 200 },
+        { "coroutines", BenchmarkCoroutines, 100'000 },
+        { "tweens", BenchmarkTweens, 100 },
+        { "animclip", BenchmarkAnimClip, 200 },
+        { "lightclusters", BenchmarkLightClusters, 200 },
+        { "textures", BenchmarkTextures, 5 },
+        { "framecapture", BenchmarkFrameCapture, 120 },
+        { "rewind", BenchmarkRewind, 60 },
+    };
+}
+
+int main(int argc, char** argv)
+{
+    ClockInit();
+    JobsInit(0);
+
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+
+    for (u32 i = 0; i < ArraySize(g_Benchmarks); i++)
+    {
+        const Benchmark* benchmark = &g_Benchmarks[i];
+        if (filter && !std::strstr(benchmark->m_Name, filter))
+        {
+            continue;
+        }
+
+        // NOTE(sbalse): One short warm up run so caches and lazily created resources don't count.
+        benchmark->m_Run(benchmark->m_Iterations / 100 + 1);
+
+        const i64 start = ClockNow();
+        const char* note = benchmark->m_Run(benchmark->m_Iterations);
+        const double seconds = ClockTicksToSeconds(ClockNow() - start);
+
+        std::printf(
+            "%-20s %10.3f us/iteration  %s\n",
+            benchmark->m_Name,
+            seconds * 1'000'000.0 / benchmark->m_Iterations,
+            note ? note : "");
+    }
+
+    JobsShutdown();
+    return EXIT_SUCCESS;
+}
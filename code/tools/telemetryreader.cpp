@@ -0,0 +1,102 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "types.h"
+#include "telemetry.h"
+
+/*
+* NOTE(sbalse): Tails the telemetry block published by a running engine and prints one line per new frame
+* sample. Never writes to the block, so it cannot disturb the engine's frame loop.
+*
+* Usage: telemetryreader [name] [interval in ms] [--once]
+*/
+int main(int argc, char** argv)
+{
+    const char* name = TELEMETRY_DEFAULT_NAME;
+    int intervalMs = 500;
+    bool once = false;
+
+    int positional = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--once") == 0)
+        {
+            once = true;
+        }
+        else if (positional == 0)
+        {
+            name = argv[i];
+            positional++;
+        }
+        else if (positional == 1)
+        {
+            intervalMs = std::atoi(argv[i]);
+            positional++;
+        }
+    }
+
+    TelemetryMapping mapping = {};
+
+    // NOTE(sbalse): The engine may not be up yet, keep trying until it is.
+    while (!TelemetryOpen(&mapping, name))
+    {
+        if (once)
+        {
+            std::fprintf(stderr, "No telemetry block named '%s'\n", name);
+            return EXIT_FAILURE;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+    }
+
+    const TelemetryBlock* block = mapping.m_Block;
+    u64 lastFrame = ~0ull;
+
+    for (;;)
+    {
+        TelemetryStats stats = {};
+        if (TelemetryRead(block, &stats, 64) && stats.m_FrameIndex != lastFrame)
+        {
+            lastFrame = stats.m_FrameIndex;
+
+            std::printf(
+                "frame %llu  ft %.2fms  avg %.2fms  p50 %.2fms  p99 %.2fms  latency %.2fms  objects %llu  mem %.1fMB |",
+                static_cast<unsigned long long>(stats.m_FrameIndex),
+                stats.m_FrameTimeMs,
+                stats.m_FrameTimeMeanMs,
+                stats.m_FrameTimeP50Ms,
+                stats.m_FrameTimeP99Ms,
+                stats.m_PipelineLatencyMeanMs,
+                static_cast<unsigned long long>(stats.m_ObjectCount),
+                static_cast<double>(stats.m_ProcessMemoryBytes) / (1024.0 * 1024.0));
+
+            for (u32 i = 0; i < block->m_StageCount && i < TELEMETRY_MAX_STAGES; i++)
+            {
+                std::printf(" %.16s %.2fms", block->m_StageNames[i], stats.m_StageTimeMeanMs[i]);
+            }
+            std::printf(" |");
+            for (u32 i = 0; i < block->m_CounterCount && i < TELEMETRY_MAX_COUNTERS; i++)
+            {
+                std::printf(
+                    " %.16s %llu",
+                    block->m_CounterNames[i],
+                    static_cast<unsigned long long>(stats.m_Counters[i]));
+            }
+            std::printf("\n");
+            std::fflush(stdout);
+        }
+
+        if (once)
+        {
+            break;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+    }
+
+    TelemetryClose(&mapping);
+
+    return EXIT_SUCCESS;
+}
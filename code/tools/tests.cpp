@@ -0,0 +1,3064 @@
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <thread>
+
+#include "actionmap.h"
+#include "animclip.h"
+#include "broadphase.h"
+#include "clock.h"
+#include "deferredwork.h"
+#include "framecapture.h"
+#include "input.h"
+#include "jobs.h"
+#include "lightclusters.h"
+#include "particles.h"
+#include "random.h"
+#include "rewind.h"
+#include "scenefile.h"
+#include "taskgraph.h"
+#include "telemetry.h"
+#include "texture.h"
+#include "tweens.h"
+#include "types.h"
+#include "utils.h"
+#include "graphics/dynamicresolution.h"
+#include "graphics/quantize.h"
+#include "graphics/rendergraph.h"
+#include "graphics/resourcepool.h"
+
+/*
+* NOTE(sbalse): Checks for engine systems that can run without a window or a device. Prints every check that
+* failed and exits with a failure if any did.
+*
+* Usage: tests [name filter]
+*/
+
+// NOTE(sbalse): Fails the running test when expr is false.
+#define TEST_CHECK(expr) \
+do { \
+    if (expr) \
+    { \
+    } \
+    else \
+    { \
+        std::printf("    %s:%d: %s\n", __FILE__, __LINE__, #expr); \
+        return false; \
+    } \
+} while (0)
+
+namespace
+{
+    struct Test
+    {
+        const char* m_Name;
+        bool (*m_Run)();
+    };
+
+    constexpr const char* TESTS_TELEMETRY_WRITER = "--telemetry-writer";
+    constexpr const char* TESTS_TELEMETRY_NAME = "hw3d_telemetry_test";
+    constexpr u64 TESTS_TELEMETRY_FRAMES = 2'000'000;
+
+    constexpr u32 TESTS_MAX_THREADS = 64;
+
+    constinit const char* g_ExecutablePath = nullptr;
+
+    // NOTE(sbalse): Every field follows from the frame index, so a torn read doesn't match the sample of the frame
+    // it claims to be. Frame 0 is all zeros, like a block nothing was published into yet.
+    TelemetryStats TestTelemetrySample(const u64 frame)
+    {
+        TelemetryStats stats = {};
+        stats.m_FrameIndex = frame;
+        stats.m_PublishTimeUs = frame * 3;
+        stats.m_FrameTimeMs = static_cast<float>(frame % 1000);
+        for (u32 i = 0; i < TELEMETRY_MAX_STAGES; i++)
+        {
+            stats.m_StageTimeMeanMs[i] = static_cast<float>((frame * (i + 1)) % 1000);
+        }
+        for (u32 i = 0; i < TELEMETRY_MAX_COUNTERS; i++)
+        {
+            stats.m_Counters[i] = frame * (i + 1);
+        }
+        stats.m_ObjectCount = frame * 7;
+        stats.m_ProcessMemoryBytes = frame << 12;
+        return stats;
+    }
+
+    // NOTE(sbalse): Runs in the child process the telemetry test starts, in place of the engine.
+    int TestTelemetryWriter(const char* name)
+    {
+        TelemetryMapping mapping = {};
+        if (!TelemetryCreate(&mapping, name))
+        {
+            return EXIT_FAILURE;
+        }
+
+        for (u64 frame = 1; frame <= TESTS_TELEMETRY_FRAMES; frame++)
+        {
+            const TelemetryStats stats = TestTelemetrySample(frame);
+            TelemetryPublish(mapping.m_Block, &stats);
+        }
+
+        // NOTE(sbalse): Stay around so a reader that opened late still finds the last sample.
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        TelemetryClose(&mapping);
+        return EXIT_SUCCESS;
+    }
+
+    // NOTE(sbalse): A second process publishes as fast as it can while this one reads. Every read has to be one
+    // whole sample and frames never go backwards.
+    bool TestTelemetry()
+    {
+        char command[1024] = {};
+#if _WIN32
+        // NOTE(sbalse): cmd.exe strips the outer quotes, the path keeps its own.
+        constexpr const char* format = "\"\"%s\" %s %s\"";
+#else
+        constexpr const char* format = "\"%s\" %s %s";
+#endif
+        std::snprintf(command, sizeof(command), format, g_ExecutablePath, TESTS_TELEMETRY_WRITER, TESTS_TELEMETRY_NAME);
+
+        int status = -1;
+        std::thread writer([&]() { status = std::system(command); });
+
+        const i64 deadline = ClockNow() + ClockSecondsToTicks(10.0);
+        TelemetryMapping mapping = {};
+        bool opened = TelemetryOpen(&mapping, TESTS_TELEMETRY_NAME);
+        while (!opened && ClockNow() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            opened = TelemetryOpen(&mapping, TESTS_TELEMETRY_NAME);
+        }
+
+        bool whole = true;
+        bool ordered = true;
+        u64 lastFrame = 0;
+        u64 reads = 0;
+        while (opened && lastFrame < TESTS_TELEMETRY_FRAMES && ClockNow() < deadline)
+        {
+            TelemetryStats stats = {};
+            if (!TelemetryRead(mapping.m_Block, &stats, 64))
+            {
+                continue;
+            }
+
+            const TelemetryStats expected = TestTelemetrySample(stats.m_FrameIndex);
+            whole = whole && std::memcmp(&stats, &expected, sizeof(TelemetryStats)) == 0;
+            ordered = ordered && stats.m_FrameIndex >= lastFrame;
+            lastFrame = stats.m_FrameIndex;
+            reads++;
+        }
+
+        TelemetryClose(&mapping);
+        writer.join();
+
+        TEST_CHECK(opened);
+        TEST_CHECK(whole);
+        TEST_CHECK(ordered);
+        TEST_CHECK(lastFrame == TESTS_TELEMETRY_FRAMES);
+        TEST_CHECK(reads > 0);
+        TEST_CHECK(status == 0);
+        return true;
+    }
+
+    // NOTE(sbalse): The memory published is what is resident now, it has to go down again when memory is freed.
+    bool TestProcessMemory()
+    {
+        constexpr u64 size = 64ull << 20;
+
+        const u64 before = TelemetryQueryProcessMemory();
+        u8* memory = static_cast<u8*>(std::malloc(size));
+        TEST_CHECK(memory);
+        // NOTE(sbalse): Volatile so the compiler can't drop the allocation, every page has to be made resident.
+        volatile u8* pages = memory;
+        for (u64 offset = 0; offset < size; offset += 4096)
+        {
+            pages[offset] = 1;
+        }
+        const u64 touched = TelemetryQueryProcessMemory();
+        std::free(memory);
+        const u64 after = TelemetryQueryProcessMemory();
+
+        TEST_CHECK(before > 0);
+        TEST_CHECK(touched >= before + size / 2);
+        TEST_CHECK(after + size / 2 <= touched);
+        return true;
+    }
+
+    constexpr u8 TESTS_KEY_CONTROL = 0x11; // NOTE(sbalse): VK_CONTROL.
+
+    bool TestActionSetEquals(const ActionSet* set, const std::initializer_list<u32> actions)
+    {
+        ActionSet expected = {};
+        for (const u32 action : actions)
+        {
+            expected.m_Words[action / 64] |= 1ull << (action % 64);
+        }
+        return std::memcmp(set, &expected, sizeof(ActionSet)) == 0;
+    }
+
+    // NOTE(sbalse): Evaluates the input fed in since the last call, then ends the frame like the window does.
+    ActionSet TestActionMapFrame(const ActionMap* map)
+    {
+        InputFrameState input = {};
+        InputGetFrameState(&input);
+        ActionSet result = {};
+        ActionMapEvaluate(map, &input, &result);
+        InputEndFrame();
+        return result;
+    }
+
+    // NOTE(sbalse): Goes through input.cpp the way the game does. Keys send a message every frame they are held
+    // down, mouse buttons only when they change.
+    bool TestActionMap()
+    {
+        ActionMap* map = ActionMapCreate();
+        DEFER(ActionMapDestroy(map));
+        InputClear(true);
+
+        const u16 control[] = { ActionKey(TESTS_KEY_CONTROL) };
+        const u16 modifiers[] = { ActionKey('E'), ActionKey('F') };
+        TEST_CHECK(ActionMapBind(map, 0, ActionKey('A'), ActionTrigger::PRESSED));
+        TEST_CHECK(ActionMapBind(map, 1, ActionKey('A'), ActionTrigger::RELEASED));
+        TEST_CHECK(ActionMapBind(map, 2, ActionKey('A'), ActionTrigger::HELD));
+        TEST_CHECK(ActionMapBind(map, 3, ActionKey('S'), ActionTrigger::PRESSED, control, 1));
+        TEST_CHECK(ActionMapBind(map, 4, ActionMouse(MouseButton::LBUTTON), ActionTrigger::PRESSED));
+        TEST_CHECK(ActionMapBind(map, 4, ActionMouse(MouseButton::MBUTTON), ActionTrigger::RELEASED));
+        TEST_CHECK(ActionMapBind(map, 5, ActionKey('B'), ActionTrigger::PRESSED));
+        TEST_CHECK(ActionMapBind(map, 5, ActionKey('C'), ActionTrigger::PRESSED));
+        TEST_CHECK(ActionMapBind(map, ACTIONMAP_MAX_ACTIONS - 1, ActionKey('D'), ActionTrigger::HELD, modifiers, 2));
+
+        TEST_CHECK(!ActionMapBind(map, ACTIONMAP_MAX_ACTIONS, ActionKey('A'), ActionTrigger::PRESSED));
+        TEST_CHECK(!ActionMapBind(map, 0, INPUT_NUM_BUTTONS, ActionTrigger::PRESSED));
+        TEST_CHECK(!ActionMapBind(map, 0, ActionKey('A'), ActionTrigger::PRESSED, control, ACTIONMAP_MAX_CHORD + 1));
+        ActionMapCompile(map);
+
+        ActionSet result = TestActionMapFrame(map);
+        TEST_CHECK(TestActionSetEquals(&result, {}));
+
+        InputKeyboardUpdate('A', true);
+        result = TestActionMapFrame(map);
+        TEST_CHECK(TestActionSetEquals(&result, { 0, 2 }));
+
+        InputKeyboardUpdate('A', true);
+        result = TestActionMapFrame(map);
+        TEST_CHECK(TestActionSetEquals(&result, { 2 }));
+
+        InputKeyboardUpdate('A', false);
+        result = TestActionMapFrame(map);
+        TEST_CHECK(TestActionSetEquals(&result, { 1 }));
+
+        // NOTE(sbalse): A chord needs its extra buttons held in the same frame.
+        InputKeyboardUpdate('S', true);
+        result = TestActionMapFrame(map);
+        TEST_CHECK(TestActionSetEquals(&result, {}));
+        InputKeyboardUpdate('S', false);
+        result = TestActionMapFrame(map);
+        TEST_CHECK(TestActionSetEquals(&result, {}));
+        InputKeyboardUpdate(TESTS_KEY_CONTROL, true);
+        InputKeyboardUpdate('S', true);
+        result = TestActionMapFrame(map);
+        TEST_CHECK(TestActionSetEquals(&result, { 3 }));
+        InputKeyboardUpdate(TESTS_KEY_CONTROL, false);
+        InputKeyboardUpdate('S', false);
+        result = TestActionMapFrame(map);
+        TEST_CHECK(TestActionSetEquals(&result, {}));
+
+        // NOTE(sbalse): Mouse buttons sit past the keyboard in the next word of the button set.
+        InputMouseUpdate(MouseButton::LBUTTON, true);
+        InputMouseUpdate(MouseButton::MBUTTON, true);
+        result = TestActionMapFrame(map);
+        TEST_CHECK(TestActionSetEquals(&result, { 4 }));
+        result = TestActionMapFrame(map);
+        TEST_CHECK(TestActionSetEquals(&result, {}));
+        InputMouseUpdate(MouseButton::LBUTTON, false);
+        InputMouseUpdate(MouseButton::MBUTTON, false);
+        result = TestActionMapFrame(map);
+        TEST_CHECK(TestActionSetEquals(&result, { 4 }));
+
+        InputKeyboardUpdate('B', true);
+        InputKeyboardUpdate('C', true);
+        result = TestActionMapFrame(map);
+        TEST_CHECK(TestActionSetEquals(&result, { 5 }));
+        InputKeyboardUpdate('B', false);
+        InputKeyboardUpdate('C', false);
+        TestActionMapFrame(map);
+
+        InputKeyboardUpdate('D', true);
+        InputKeyboardUpdate('E', true);
+        InputKeyboardUpdate('F', true);
+        result = TestActionMapFrame(map);
+        TEST_CHECK(TestActionSetEquals(&result, { ACTIONMAP_MAX_ACTIONS - 1 }));
+        InputKeyboardUpdate('D', true);
+        InputKeyboardUpdate('E', true);
+        result = TestActionMapFrame(map);
+        TEST_CHECK(TestActionSetEquals(&result, {}));
+
+        // NOTE(sbalse): Bindings made after compiling wait for the next compile.
+        TEST_CHECK(ActionMapBind(map, 6, ActionKey('G'), ActionTrigger::HELD));
+        InputKeyboardUpdate('G', true);
+        InputFrameState input = {};
+        InputGetFrameState(&input);
+        ActionMapEvaluate(map, &input, &result);
+        TEST_CHECK(TestActionSetEquals(&result, {}));
+        ActionMapCompile(map);
+        ActionMapEvaluate(map, &input, &result);
+        TEST_CHECK(TestActionSetEquals(&result, { 6 }));
+
+        InputClear(true);
+        return true;
+    }
+
+    bool TestButtonSetTest(const InputButtonSet* set, const u32 button)
+    {
+        return (set->m_Words[button / 64] >> (button % 64)) & 1;
+    }
+
+    // NOTE(sbalse): Random bindings and input against evaluating every binding on its own.
+    bool TestActionMapRandom()
+    {
+        constexpr u32 bindingCount = 1000;
+        constexpr u32 frameCount = 2000;
+        constexpr u32 buttons = 24; // NOTE(sbalse): Few buttons, so chords get satisfied now and then.
+
+        ActionMap* map = ActionMapCreate();
+        DEFER(ActionMapDestroy(map));
+
+        ActionBinding bindings[bindingCount] = {};
+        for (u32 i = 0; i < bindingCount; i++)
+        {
+            const RandomBlock random = RandomPhilox(31, i);
+            ActionBinding* binding = &bindings[i];
+            binding->m_Action = static_cast<u16>(random.m_Values[0] % ACTIONMAP_MAX_ACTIONS);
+            binding->m_Button = static_cast<u16>(INPUT_NUM_BUTTONS - 1 - (random.m_Values[1] % buttons));
+            binding->m_Trigger = static_cast<ActionTrigger>(random.m_Values[2] % 3);
+            binding->m_ChordCount = (random.m_Values[3] % 4) == 0 ? (random.m_Values[3] >> 8) % 3 : 0;
+            for (u32 c = 0; c < binding->m_ChordCount; c++)
+            {
+                const u32 bits = RandomPhilox(32, (i * ACTIONMAP_MAX_CHORD) + c).m_Values[0];
+                binding->m_Chord[c] = static_cast<u16>(INPUT_NUM_BUTTONS - 1 - (bits % buttons));
+            }
+            TEST_CHECK(ActionMapBind(
+                map,
+                binding->m_Action,
+                binding->m_Button,
+                binding->m_Trigger,
+                binding->m_Chord,
+                binding->m_ChordCount));
+        }
+        ActionMapCompile(map);
+
+        u32 fired = 0;
+        for (u32 frame = 0; frame < frameCount; frame++)
+        {
+            InputFrameState input = {};
+            for (u32 b = 0; b < buttons; b++)
+            {
+                const u32 button = INPUT_NUM_BUTTONS - 1 - b;
+                const u32 bits = RandomPhilox(33, (frame * buttons) + b).m_Values[0];
+                input.m_Held.m_Words[button / 64] |= static_cast<u64>((bits % 3) != 0) << (button % 64);
+                input.m_Pressed.m_Words[button / 64] |= static_cast<u64>((bits % 5) == 0) << (button % 64);
+                input.m_Released.m_Words[button / 64] |= static_cast<u64>((bits % 7) == 0) << (button % 64);
+            }
+
+            ActionSet expected = {};
+            for (u32 i = 0; i < bindingCount; i++)
+            {
+                const ActionBinding* binding = &bindings[i];
+                const InputButtonSet* states[] = { &input.m_Pressed, &input.m_Released, &input.m_Held };
+                bool firing = TestButtonSetTest(states[static_cast<u32>(binding->m_Trigger)], binding->m_Button);
+                for (u32 c = 0; c < binding->m_ChordCount; c++)
+                {
+                    firing = firing && TestButtonSetTest(&input.m_Held, binding->m_Chord[c]);
+                }
+                expected.m_Words[binding->m_Action / 64] |= static_cast<u64>(firing) << (binding->m_Action % 64);
+                fired += firing ? 1 : 0;
+            }
+
+            ActionSet result = {};
+            ActionMapEvaluate(map, &input, &result);
+            TEST_CHECK(std::memcmp(&result, &expected, sizeof(ActionSet)) == 0);
+        }
+
+        TEST_CHECK(fired > 0);
+        return true;
+    }
+
+    ResourceDesc TestResourceDesc(const u32* data, const u32 count, const ResourceUsage usage)
+    {
+        return ResourceDesc
+        {
+            .m_Type = ResourceType::VERTEXBUFFER,
+            .m_Usage = usage,
+            .m_Stride = sizeof(u32),
+            .m_Size = count * static_cast<u32>(sizeof(u32)),
+            .m_Data = data,
+        };
+    }
+
+    // NOTE(sbalse): Runs frames until everything retired so far is released.
+    void TestResourceCollectAll(ResourcePool* pool)
+    {
+        for (u32 frame = 0; frame < RESOURCE_DESTROY_LATENCY_FRAMES; frame++)
+        {
+            ResourcePoolEndFrame(pool);
+        }
+        ResourcePoolCollect(pool, ~0u);
+    }
+
+    bool TestResourceInterning()
+    {
+        ResourceNullDevice device = {};
+        const ResourceBackend backend = ResourceNullBackend(&device);
+        ResourcePool* pool = ResourcePoolCreate(&backend, 16);
+        TEST_CHECK(pool);
+        DEFER(ResourcePoolDestroy(pool));
+
+        u32 first[] = { 1, 2, 3, 4 };
+        const u32 same[] = { 1, 2, 3, 4 };
+        const u32 other[] = { 1, 2, 3, 5 };
+        const ResourceDesc firstDesc = TestResourceDesc(first, 4, ResourceUsage::IMMUTABLE);
+        const ResourceDesc sameDesc = TestResourceDesc(same, 4, ResourceUsage::IMMUTABLE);
+        const ResourceDesc otherDesc = TestResourceDesc(other, 4, ResourceUsage::IMMUTABLE);
+        const ResourceDesc shorterDesc = TestResourceDesc(same, 3, ResourceUsage::IMMUTABLE);
+        const ResourceDesc dynamicDesc = TestResourceDesc(same, 4, ResourceUsage::DYNAMIC);
+
+        const ResourceHandle a = ResourceCreate(pool, &firstDesc);
+        const ResourceHandle b = ResourceCreate(pool, &sameDesc);
+        TEST_CHECK(a.m_Value != 0 && a.m_Value == b.m_Value);
+        TEST_CHECK(device.m_Creates == 1);
+
+        // NOTE(sbalse): The pool keeps its own copy, changing the caller's data afterwards changes nothing.
+        first[3] = 5;
+        const ResourceHandle c = ResourceCreate(pool, &firstDesc);
+        TEST_CHECK(c.m_Value == ResourceCreate(pool, &otherDesc).m_Value);
+        TEST_CHECK(c.m_Value != a.m_Value);
+        TEST_CHECK(ResourceCreate(pool, &shorterDesc).m_Value != a.m_Value);
+        const ResourceHandle dynamic = ResourceCreate(pool, &dynamicDesc);
+        TEST_CHECK(dynamic.m_Value != a.m_Value);
+        TEST_CHECK(ResourceCreate(pool, &dynamicDesc).m_Value != dynamic.m_Value);
+        TEST_CHECK(device.m_Creates == 5);
+
+        ResourcePoolStats stats = {};
+        ResourcePoolGetStats(pool, &stats);
+        TEST_CHECK(stats.m_LiveResources == 5);
+        TEST_CHECK(stats.m_InternedResources == 3);
+        TEST_CHECK(stats.m_SharedReferences == 2);
+        TEST_CHECK(stats.m_DuplicateRequests == 2);
+        TEST_CHECK(stats.m_BufferBytesSaved == 2 * sizeof(same));
+        TEST_CHECK(stats.m_CreateRequests == 7);
+
+        // NOTE(sbalse): Two references to a, the object stays until both are gone.
+        ResourceRelease(pool, a);
+        TEST_CHECK(ResourceIsValid(pool, a));
+        TEST_CHECK(ResourceAddRef(pool, a).m_Value == a.m_Value);
+        ResourceRelease(pool, a);
+        ResourceRelease(pool, a);
+        TEST_CHECK(!ResourceIsValid(pool, a));
+        ResourcePoolGetStats(pool, &stats);
+        TEST_CHECK(stats.m_InternedResources == 2);
+        TEST_CHECK(stats.m_SharedReferences == 1);
+        TEST_CHECK(stats.m_BufferBytesSaved == sizeof(same));
+
+        // NOTE(sbalse): Retired objects are out of the intern table, the same contents get a new object.
+        const ResourceHandle again = ResourceCreate(pool, &sameDesc);
+        TEST_CHECK(ResourceIsValid(pool, again));
+        TEST_CHECK(again.m_Value != a.m_Value);
+        TEST_CHECK(device.m_Creates == 6);
+        return true;
+    }
+
+    bool TestResourceDelayedDestroy()
+    {
+        ResourceNullDevice device = {};
+        const ResourceBackend backend = ResourceNullBackend(&device);
+        ResourcePool* pool = ResourcePoolCreate(&backend, 16);
+        TEST_CHECK(pool);
+
+        const u32 data[] = { 7, 8, 9 };
+        ResourceHandle handles[3] = {};
+        for (u32 i = 0; i < ArraySize(handles); i++)
+        {
+            const ResourceDesc desc = TestResourceDesc(data, i + 1, ResourceUsage::IMMUTABLE);
+            handles[i] = ResourceCreate(pool, &desc);
+        }
+        for (const ResourceHandle handle : handles)
+        {
+            ResourceRelease(pool, handle);
+            TEST_CHECK(!ResourceIsValid(pool, handle));
+            TEST_CHECK(!ResourceGetNative(pool, handle));
+        }
+
+        // NOTE(sbalse): Handles go stale right away, the objects are only released once the latency has passed.
+        for (u32 frame = 0; frame + 1 < RESOURCE_DESTROY_LATENCY_FRAMES; frame++)
+        {
+            ResourcePoolEndFrame(pool);
+            TEST_CHECK(!ResourcePoolCollect(pool, ~0u));
+            TEST_CHECK(device.m_Releases == 0);
+        }
+        ResourcePoolEndFrame(pool);
+
+        ResourcePoolStats stats = {};
+        ResourcePoolGetStats(pool, &stats);
+        TEST_CHECK(stats.m_PendingDestroys == 3);
+        TEST_CHECK(ResourcePoolCollect(pool, 1));
+        TEST_CHECK(device.m_Releases == 1);
+        TEST_CHECK(!ResourcePoolCollect(pool, 2));
+        TEST_CHECK(device.m_Releases == 3);
+        ResourcePoolGetStats(pool, &stats);
+        TEST_CHECK(stats.m_PendingDestroys == 0);
+        TEST_CHECK(stats.m_LiveResources == 0);
+
+        // NOTE(sbalse): Destroying the pool releases what is still referenced and what is still pending.
+        const ResourceDesc dynamicDesc = TestResourceDesc(data, 3, ResourceUsage::DYNAMIC);
+        const ResourceHandle live = ResourceCreate(pool, &dynamicDesc);
+        const ResourceHandle pending = ResourceCreate(pool, &dynamicDesc);
+        TEST_CHECK(ResourceIsValid(pool, live));
+        ResourceRelease(pool, pending);
+        ResourcePoolDestroy(pool);
+        TEST_CHECK(device.m_LiveObjects == 0);
+        TEST_CHECK(device.m_Creates == device.m_Releases);
+        return true;
+    }
+
+    bool TestResourceGenerations()
+    {
+        ResourceNullDevice device = {};
+        const ResourceBackend backend = ResourceNullBackend(&device);
+        ResourcePool* pool = ResourcePoolCreate(&backend, 1);
+        TEST_CHECK(pool);
+        DEFER(ResourcePoolDestroy(pool));
+
+        const u32 data[] = { 1 };
+        const ResourceDesc desc = TestResourceDesc(data, 1, ResourceUsage::IMMUTABLE);
+        const ResourceDesc dynamicDesc = TestResourceDesc(data, 1, ResourceUsage::DYNAMIC);
+
+        // NOTE(sbalse): One slot, reused over and over. More uses than there are generations, so they wrap.
+        ResourceHandle previous = RESOURCE_INVALID_HANDLE;
+        for (u32 use = 0; use < (1u << RESOURCE_GENERATION_BITS) * 2; use++)
+        {
+            const ResourceHandle handle = ResourceCreate(pool, &desc);
+            TEST_CHECK(handle.m_Value != 0);
+            TEST_CHECK(handle.m_Value != previous.m_Value);
+            TEST_CHECK((handle.m_Value & (RESOURCE_MAX_RESOURCES - 1)) == 0);
+            TEST_CHECK(ResourceIsValid(pool, handle));
+            TEST_CHECK(!ResourceIsValid(pool, previous));
+
+            // NOTE(sbalse): The pool is full until the slot has been collected.
+            TEST_CHECK(ResourceCreate(pool, &dynamicDesc).m_Value == 0);
+            ResourceRelease(pool, handle);
+            TEST_CHECK(ResourceCreate(pool, &desc).m_Value == 0);
+            TestResourceCollectAll(pool);
+            previous = handle;
+        }
+
+        TEST_CHECK(device.m_LiveObjects == 0);
+        return true;
+    }
+
+    constexpr u32 TESTS_QUANTIZE_SAMPLES = 1'000'000;
+
+    // NOTE(sbalse): Uniform in [min, max].
+    float TestRandomFloat(const u64 seed, const u64 index, const float min, const float max)
+    {
+        return min + (max - min) * RandomUnitFloat(RandomPhilox(seed, index).m_Values[0]);
+    }
+
+    bool TestQuantizeSnorm16()
+    {
+        // NOTE(sbalse): Every encoding decodes to a value that encodes back to it, -32768 aside which means -1.
+        for (i32 value = -32767; value <= 32767; value++)
+        {
+            TEST_CHECK(QuantizeSnorm16(DequantizeSnorm16(static_cast<i16>(value))) == value);
+        }
+
+        double maxError = 0.0;
+        for (u32 i = 0; i <= TESTS_QUANTIZE_SAMPLES; i++)
+        {
+            const float even = -1.0f + 2.0f * static_cast<float>(i) / static_cast<float>(TESTS_QUANTIZE_SAMPLES);
+            const float random = TestRandomFloat(41, i, -1.0f, 1.0f);
+            for (const float value : { even, random })
+            {
+                const double error = std::fabs(static_cast<double>(DequantizeSnorm16(QuantizeSnorm16(value))) - value);
+                maxError = error > maxError ? error : maxError;
+            }
+        }
+        TEST_CHECK(maxError <= QUANTIZE_SNORM16_MAX_ERROR);
+
+        // NOTE(sbalse): Out of range values clamp, NaN becomes zero.
+        TEST_CHECK(QuantizeSnorm16(2.0f) == 32767 && QuantizeSnorm16(-2.0f) == -32767);
+        TEST_CHECK(QuantizeSnorm16(std::nanf("")) == 0);
+        return true;
+    }
+
+    bool TestQuantizeHalf()
+    {
+        // NOTE(sbalse): Every half decodes to a float that encodes back to the same bits, NaNs stay NaN.
+        for (u32 bits = 0; bits <= 0xFFFF; bits++)
+        {
+            const u16 half = static_cast<u16>(bits);
+            const float value = DequantizeHalf(half);
+            if (value != value)
+            {
+                TEST_CHECK((QuantizeHalf(value) & 0x7C00) == 0x7C00 && (QuantizeHalf(value) & 0x3FF) != 0);
+                continue;
+            }
+            TEST_CHECK(QuantizeHalf(value) == half);
+        }
+
+        // NOTE(sbalse): Normal halfs have a relative bound, subnormals an absolute one of half their spacing.
+        constexpr double smallestNormal = 6.103515625e-5;
+        constexpr double subnormalMaxError = 2.98023223876953125e-8;
+        double maxRelativeError = 0.0;
+        double maxSubnormalError = 0.0;
+        for (u32 i = 0; i < TESTS_QUANTIZE_SAMPLES; i++)
+        {
+            // NOTE(sbalse): Spread over every exponent, not just the largest ones.
+            const float exponent = TestRandomFloat(42, i, -26.0f, 15.9f);
+            const float sign = (i & 1) ? -1.0f : 1.0f;
+            const float value = sign * std::exp2(exponent);
+            const double decoded = DequantizeHalf(QuantizeHalf(value));
+            const double error = std::fabs(decoded - value);
+            if (std::fabs(value) >= smallestNormal)
+            {
+                const double relativeError = error / std::fabs(value);
+                maxRelativeError = relativeError > maxRelativeError ? relativeError : maxRelativeError;
+            }
+            else
+            {
+                maxSubnormalError = error > maxSubnormalError ? error : maxSubnormalError;
+            }
+        }
+        TEST_CHECK(maxRelativeError <= QUANTIZE_HALF_MAX_RELATIVE_ERROR);
+        TEST_CHECK(maxSubnormalError <= subnormalMaxError);
+
+        TEST_CHECK(QuantizeHalf(1e6f) == 0x7C00 && QuantizeHalf(-1e6f) == 0xFC00);
+        return true;
+    }
+
+    // NOTE(sbalse): Angle between two unit vectors. Through the chord length, acos() loses too much near 0.
+    double TestAngleBetween(const Float3 a, const Float3 b)
+    {
+        const double dx = static_cast<double>(a.m_X) - b.m_X;
+        const double dy = static_cast<double>(a.m_Y) - b.m_Y;
+        const double dz = static_cast<double>(a.m_Z) - b.m_Z;
+        return 2.0 * std::asin(std::fmin(std::sqrt(dx * dx + dy * dy + dz * dz) * 0.5, 1.0));
+    }
+
+    // NOTE(sbalse): Uniform on the sphere.
+    Float3 TestRandomDirection(const u64 seed, const u64 index)
+    {
+        const RandomBlock random = RandomPhilox(seed, index);
+        const float z = -1.0f + 2.0f * RandomUnitFloat(random.m_Values[0]);
+        const float angle = 6.2831853f * RandomUnitFloat(random.m_Values[1]);
+        const float radius = std::sqrt(std::fmax(1.0f - z * z, 0.0f));
+        return { radius * std::cos(angle), radius * std::sin(angle), z };
+    }
+
+    bool TestQuantizeOctahedral()
+    {
+        double maxError = 0.0;
+        double maxFastError = 0.0;
+        double maxLengthError = 0.0;
+        for (u32 i = 0; i < TESTS_QUANTIZE_SAMPLES; i++)
+        {
+            Float3 direction = TestRandomDirection(43, i);
+            const double length = std::sqrt(
+                static_cast<double>(direction.m_X) * direction.m_X
+                + static_cast<double>(direction.m_Y) * direction.m_Y
+                + static_cast<double>(direction.m_Z) * direction.m_Z);
+            direction =
+            {
+                static_cast<float>(direction.m_X / length),
+                static_cast<float>(direction.m_Y / length),
+                static_cast<float>(direction.m_Z / length),
+            };
+
+            // NOTE(sbalse): The input doesn't need to be normalized, scale some of them.
+            const float scale = (i % 3) == 0 ? 7.5f : 1.0f;
+            const Float3 decoded = DequantizeOctahedral(
+                QuantizeOctahedral(direction.m_X * scale, direction.m_Y * scale, direction.m_Z * scale));
+            const Float3 fast = DequantizeOctahedral(
+                QuantizeOctahedralFast(direction.m_X * scale, direction.m_Y * scale, direction.m_Z * scale));
+
+            const double error = TestAngleBetween(decoded, direction);
+            const double fastError = TestAngleBetween(fast, direction);
+            const double lengthError = std::fabs(
+                std::sqrt(
+                    static_cast<double>(decoded.m_X) * decoded.m_X
+                    + static_cast<double>(decoded.m_Y) * decoded.m_Y
+                    + static_cast<double>(decoded.m_Z) * decoded.m_Z)
+                - 1.0);
+            maxError = error > maxError ? error : maxError;
+            maxFastError = fastError > maxFastError ? fastError : maxFastError;
+            maxLengthError = lengthError > maxLengthError ? lengthError : maxLengthError;
+        }
+        TEST_CHECK(maxError <= QUANTIZE_OCTAHEDRAL_MAX_ANGLE_ERROR);
+        TEST_CHECK(maxFastError <= QUANTIZE_OCTAHEDRAL_FAST_MAX_ANGLE_ERROR);
+        TEST_CHECK(maxLengthError <= 1e-6);
+
+        // NOTE(sbalse): The poles and the fold are where the octahedron is hardest.
+        const Float3 axes[] = { { 1, 0, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+        for (const Float3 axis : axes)
+        {
+            const Float3 decoded = DequantizeOctahedral(QuantizeOctahedral(axis.m_X, axis.m_Y, axis.m_Z));
+            TEST_CHECK(TestAngleBetween(decoded, axis) <= QUANTIZE_OCTAHEDRAL_MAX_ANGLE_ERROR);
+        }
+        return true;
+    }
+
+    // NOTE(sbalse): The array kernels against the scalar encodings, and positions against the scaled bound.
+    bool TestQuantizeKernels()
+    {
+        constexpr u32 count = 4096;
+        static Float3 positions[count];
+        static Float3 normals[count];
+        static Float2 texCoords[count];
+        for (u32 i = 0; i < count; i++)
+        {
+            positions[i] =
+            {
+                TestRandomFloat(44, i * 3, -37.0f, 37.0f),
+                TestRandomFloat(44, (i * 3) + 1, -5.0f, 5.0f),
+                TestRandomFloat(44, (i * 3) + 2, -0.5f, 80.0f),
+            };
+            normals[i] = TestRandomDirection(45, i);
+            texCoords[i] = { TestRandomFloat(46, i * 2, -4.0f, 4.0f), TestRandomFloat(46, (i * 2) + 1, 0.0f, 1.0f) };
+        }
+
+        static Snorm16x4 encodedPositions[count];
+        static OctahedralNormal encodedNormals[count];
+        static Half2 encodedTexCoords[count];
+        static Float3 decodedPositions[count];
+        static Float3 decodedNormals[count];
+        static Float2 decodedTexCoords[count];
+
+        const float scale = QuantizePositionScale(positions, count);
+        TEST_CHECK(scale == 80.0f || (scale < 80.0f && scale > 79.9f));
+        QuantizePositions(positions, count, scale, encodedPositions);
+        DequantizePositions(encodedPositions, count, scale, decodedPositions);
+        QuantizeNormals(normals, count, encodedNormals);
+        DequantizeNormals(encodedNormals, count, decodedNormals);
+        QuantizeTexCoords(texCoords, count, encodedTexCoords);
+        DequantizeTexCoords(encodedTexCoords, count, decodedTexCoords);
+
+        // NOTE(sbalse): Dividing and multiplying by the scale can each add an ulp of the result on top.
+        const double positionBound = static_cast<double>(QUANTIZE_SNORM16_MAX_ERROR) * scale + scale * 1.2e-7;
+        for (u32 i = 0; i < count; i++)
+        {
+            TEST_CHECK(encodedPositions[i].m_W == 0);
+            TEST_CHECK(std::fabs(static_cast<double>(decodedPositions[i].m_X) - positions[i].m_X) <= positionBound);
+            TEST_CHECK(std::fabs(static_cast<double>(decodedPositions[i].m_Y) - positions[i].m_Y) <= positionBound);
+            TEST_CHECK(std::fabs(static_cast<double>(decodedPositions[i].m_Z) - positions[i].m_Z) <= positionBound);
+
+            const OctahedralNormal normal = QuantizeOctahedral(normals[i].m_X, normals[i].m_Y, normals[i].m_Z);
+            TEST_CHECK(encodedNormals[i].m_X == normal.m_X && encodedNormals[i].m_Y == normal.m_Y);
+            TEST_CHECK(TestAngleBetween(decodedNormals[i], normals[i]) <= QUANTIZE_OCTAHEDRAL_MAX_ANGLE_ERROR);
+
+            TEST_CHECK(encodedTexCoords[i].m_X == QuantizeHalf(texCoords[i].m_X));
+            TEST_CHECK(encodedTexCoords[i].m_Y == QuantizeHalf(texCoords[i].m_Y));
+            TEST_CHECK(decodedTexCoords[i].m_X == DequantizeHalf(encodedTexCoords[i].m_X));
+        }
+
+        // NOTE(sbalse): Colors round to the nearest of 256 steps.
+        for (u32 i = 0; i <= 1000; i++)
+        {
+            const float value = static_cast<float>(i) / 1000.0f;
+            const u32 channel = QuantizeColor(value, 0.0f, 1.0f, 0.0f).m_RGBA;
+            TEST_CHECK(std::fabs(static_cast<double>(channel & 0xFF) / 255.0 - value) <= 0.5 / 255.0 + 1e-7);
+            TEST_CHECK((channel >> 8) == 0xFF00);
+        }
+        return true;
+    }
+
+    constexpr const char* TESTS_SCENE_PATH = "hw3d_scene_test.hwscene";
+    constexpr u32 TESTS_SCENE_OBJECTS = 1000;
+
+    bool TestSceneFileWrite(const u32 seed)
+    {
+        u32 values[SCENEFILE_STREAM_COUNT][TESTS_SCENE_OBJECTS] = {};
+        SceneFileContents contents = {};
+        contents.m_ObjectCount = TESTS_SCENE_OBJECTS;
+        for (u32 i = 0; i < SCENEFILE_STREAM_COUNT; i++)
+        {
+            for (u32 j = 0; j < TESTS_SCENE_OBJECTS; j++)
+            {
+                values[i][j] = seed * 1'000'003 + i * TESTS_SCENE_OBJECTS + j;
+            }
+            contents.m_Streams[i] = values[i];
+        }
+        const SceneFileMesh mesh = { "box" };
+        contents.m_Meshes = &mesh;
+        contents.m_MeshCount = 1;
+        return SceneFileWrite(TESTS_SCENE_PATH, &contents);
+    }
+
+    bool TestSceneFileMatches(const SceneFile* file, const u32 seed)
+    {
+        TEST_CHECK(file->m_Header->m_ObjectCount == TESTS_SCENE_OBJECTS);
+        for (u32 i = 0; i < SCENEFILE_STREAM_COUNT; i++)
+        {
+            const u32* values = static_cast<const u32*>(SceneFileGetStream(file, static_cast<SceneStream>(i)));
+            for (u32 j = 0; j < TESTS_SCENE_OBJECTS; j++)
+            {
+                TEST_CHECK(values[j] == seed * 1'000'003 + i * TESTS_SCENE_OBJECTS + j);
+            }
+        }
+        return true;
+    }
+
+    // NOTE(sbalse): Saving over the snapshot the running scene is still mapped from, like F5 does.
+    bool TestSceneFileReplace()
+    {
+        TEST_CHECK(TestSceneFileWrite(1));
+        SceneFile mapped = {};
+        TEST_CHECK(SceneFileOpen(&mapped, TESTS_SCENE_PATH));
+
+        const bool replaced = TestSceneFileWrite(2);
+        SceneFile reopened = {};
+        const bool reopenedOk = replaced && SceneFileOpen(&reopened, TESTS_SCENE_PATH);
+        const bool reopenedMatches = reopenedOk && TestSceneFileMatches(&reopened, 2);
+        if (reopenedOk)
+        {
+            SceneFileClose(&reopened);
+        }
+
+        const bool mappedMatches = TestSceneFileMatches(&mapped, 1);
+        SceneFileClose(&mapped);
+        std::remove(TESTS_SCENE_PATH);
+
+        TEST_CHECK(replaced);
+        TEST_CHECK(reopenedOk);
+        TEST_CHECK(reopenedMatches);
+        // NOTE(sbalse): The old snapshot keeps reading the old contents.
+        TEST_CHECK(mappedMatches);
+        return true;
+    }
+
+    struct TestThreadIndexContext
+    {
+        std::atomic<u32> m_Seen[TESTS_MAX_THREADS];
+        std::atomic<u32> m_Calls;
+    };
+
+    // NOTE(sbalse): Slow enough batches that every worker gets some.
+    void TestThreadIndexRange(void* context, const u32 begin, const u32 end)
+    {
+        TestThreadIndexContext* threads = static_cast<TestThreadIndexContext*>(context);
+        const u32 index = JobsThreadIndex();
+        if (index < TESTS_MAX_THREADS)
+        {
+            threads->m_Seen[index].fetch_add(end - begin, std::memory_order_relaxed);
+        }
+        threads->m_Calls.fetch_add(end - begin, std::memory_order_relaxed);
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+
+    bool TestJobsThreadIndex()
+    {
+        constexpr u32 workerCount = 3;
+        TEST_CHECK(JobsInit(workerCount));
+        TEST_CHECK(JobsThreadIndex() == 0);
+        TEST_CHECK(JobsThreadCount() == workerCount + 1 + JOBS_MAX_OTHER_THREADS);
+
+        // NOTE(sbalse): Workers only ever see their own index, the waiting thread helps as 0.
+        TestThreadIndexContext context = {};
+        JobsWait(JobsDispatch(4000, 10, TestThreadIndexRange, &context));
+        u32 indexed = 0;
+        for (u32 i = 0; i <= workerCount; i++)
+        {
+            indexed += context.m_Seen[i].load(std::memory_order_relaxed);
+        }
+        const bool workersIndexed = indexed == 4000 && context.m_Calls.load(std::memory_order_relaxed) == 4000;
+
+        // NOTE(sbalse): Threads that aren't workers each get an index of their own, after the workers.
+        u32 otherIndices[3] = {};
+        std::thread first([&otherIndices]() { otherIndices[0] = JobsThreadIndex(); });
+        first.join();
+        std::thread second([&otherIndices]()
+        {
+            otherIndices[1] = JobsThreadIndex();
+            otherIndices[2] = JobsThreadIndex();
+        });
+        second.join();
+        JobsShutdown();
+
+        TEST_CHECK(workersIndexed);
+        TEST_CHECK(otherIndices[0] == workerCount + 1);
+        TEST_CHECK(otherIndices[1] == workerCount + 2 && otherIndices[2] == otherIndices[1]);
+        return true;
+    }
+
+    // NOTE(sbalse): Particles and the broadphase both split their work over the workers. Returns a hash of
+    // everything they output.
+    u64 TestJobsWorkload()
+    {
+        constexpr u32 particleCapacity = 200'000;
+        constexpr u32 objectCount = 20'000;
+
+        const ParticleEmitterDesc desc =
+        {
+            .m_Position = { 0.0f, -6.0f, 20.0f },
+            .m_Velocity = { 0.0f, 8.0f, 0.0f },
+            .m_VelocitySpread = { 3.0f, 1.0f, 3.0f },
+            .m_LifetimeMin = 1.0f,
+            .m_LifetimeMax = 9.0f,
+            .m_Rate = 50'000.0f,
+            .m_Color = QuantizeColor(1.0f, 0.6f, 0.2f, 1.0f),
+            .m_Seed = 7,
+        };
+        const ParticleForces forces = { .m_Gravity = { 0.0f, -9.8f, 0.0f }, .m_Drag = 0.3f };
+        ParticleEmitter* emitter = ParticleEmitterCreate(&desc, particleCapacity);
+        if (!emitter)
+        {
+            return 0;
+        }
+        ParticleEmitterUpdate(emitter, &forces, 1.0f);
+        for (u32 i = 0; i < 30; i++)
+        {
+            ParticleEmitterUpdate(emitter, &forces, 1.0f / 60.0f);
+        }
+
+        const ParticlePool* pool = ParticleEmitterGetPool(emitter);
+        const size_t particleBytes = static_cast<size_t>(pool->m_Count) * sizeof(float);
+        u64 hash = pool->m_Count;
+        for (const float* stream : { pool->m_PositionX, pool->m_PositionY, pool->m_PositionZ, pool->m_VelocityX,
+            pool->m_VelocityY, pool->m_VelocityZ, pool->m_Age, pool->m_Lifetime })
+        {
+            hash = hash * 31 + SceneFileChecksum(stream, particleBytes);
+        }
+        ParticleEmitterDestroy(emitter);
+
+        float* bounds = static_cast<float*>(std::calloc(static_cast<size_t>(objectCount) * 6, sizeof(float)));
+        Broadphase* broadphase = BroadphaseCreate(objectCount);
+        if (!bounds || !broadphase)
+        {
+            std::free(bounds);
+            BroadphaseDestroy(broadphase);
+            return 0;
+        }
+
+        const BroadphaseBounds boxes =
+        {
+            .m_Min = { bounds, bounds + objectCount, bounds + (objectCount * 2) },
+            .m_Max = { bounds + (objectCount * 3), bounds + (objectCount * 4), bounds + (objectCount * 5) },
+        };
+        for (u32 step = 0; step < 3; step++)
+        {
+            for (u32 i = 0; i < objectCount; i++)
+            {
+                const RandomBlock block = RandomPhilox(step == 0 ? 11 : 12, i);
+                const float halfSize = RandomFloat(block.m_Values[3], { .m_Min = 0.5f, .m_Max = 1.5f });
+                for (u32 axis = 0; axis < 3; axis++)
+                {
+                    const float move = RandomFloat(block.m_Values[axis], { .m_Min = -0.2f, .m_Max = 0.2f });
+                    const float center = step == 0
+                        ? RandomFloat(block.m_Values[axis], { .m_Min = 0.0f, .m_Max = 60.0f })
+                        : (bounds[axis * objectCount + i] + bounds[(axis + 3) * objectCount + i]) * 0.5f + move;
+                    bounds[axis * objectCount + i] = center - halfSize;
+                    bounds[(axis + 3) * objectCount + i] = center + halfSize;
+                }
+            }
+
+            BroadphaseUpdate(broadphase, &boxes, objectCount);
+            u32 pairCount = 0;
+            const BroadphasePair* pairs = BroadphaseGetPairs(broadphase, &pairCount);
+            hash = hash * 31 + pairCount;
+            hash = hash * 31 + SceneFileChecksum(pairs, static_cast<u64>(pairCount) * sizeof(BroadphasePair));
+        }
+
+        BroadphaseDestroy(broadphase);
+        std::free(bounds);
+        return hash;
+    }
+
+    // NOTE(sbalse): Whatever the number of workers, the jobs must produce exactly the same output as running
+    // everything on the calling thread.
+    bool TestJobsDeterminism()
+    {
+        const u64 serial = TestJobsWorkload();
+        TEST_CHECK(serial != 0);
+
+        for (const u32 workerCount : { 1u, 3u, 7u })
+        {
+            TEST_CHECK(JobsInit(workerCount));
+            const u64 parallel = TestJobsWorkload();
+            JobsShutdown();
+            if (parallel != serial)
+            {
+                std::printf("    %u workers: %016llx, serial: %016llx\n", workerCount,
+                    static_cast<unsigned long long>(parallel), static_cast<unsigned long long>(serial));
+            }
+            TEST_CHECK(parallel == serial);
+        }
+        return true;
+    }
+
+    struct TestTask
+    {
+        std::atomic<u32>* m_NextSequence;
+        u32 m_Sequence;
+        u32 m_Thread;
+        u32 m_Calls;
+        u32 m_SleepMs;
+        bool m_Result;
+    };
+
+    bool TestTaskRun(void* context)
+    {
+        TestTask* task = static_cast<TestTask*>(context);
+        std::this_thread::sleep_for(std::chrono::milliseconds(task->m_SleepMs));
+        task->m_Thread = JobsThreadIndex();
+        task->m_Calls++;
+        task->m_Sequence = task->m_NextSequence->fetch_add(1, std::memory_order_relaxed);
+        return task->m_Result;
+    }
+
+    // NOTE(sbalse): Every task ran once, after everything it depends on finished.
+    bool TestTaskGraphOrdering()
+    {
+        // NOTE(sbalse): A diamond, B is slow so the critical path goes through it, E has to run on the main thread.
+        enum { A, B, C, D, E, TASK_COUNT };
+        std::atomic<u32> nextSequence = 0;
+        TestTask tasks[TASK_COUNT] = {};
+        for (TestTask& task : tasks)
+        {
+            task = { .m_NextSequence = &nextSequence, .m_Sequence = 0, .m_Thread = 0, .m_Calls = 0, .m_SleepMs = 1,
+                .m_Result = true };
+        }
+        tasks[B].m_SleepMs = 30;
+
+        TaskGraph* graph = TaskGraphCreate();
+        const u32 onA[] = { A };
+        const u32 onBC[] = { B, C };
+        const u32 onD[] = { D };
+        TEST_CHECK(TaskGraphAdd(graph, "A", TestTaskRun, &tasks[A], TaskAffinity::ANY, nullptr, 0) == A);
+        TEST_CHECK(TaskGraphAdd(graph, "B", TestTaskRun, &tasks[B], TaskAffinity::ANY, onA, 1) == B);
+        TEST_CHECK(TaskGraphAdd(graph, "C", TestTaskRun, &tasks[C], TaskAffinity::ANY, onA, 1) == C);
+        TEST_CHECK(TaskGraphAdd(graph, "D", TestTaskRun, &tasks[D], TaskAffinity::ANY, onBC, 2) == D);
+        TEST_CHECK(TaskGraphAdd(graph, "E", TestTaskRun, &tasks[E], TaskAffinity::MAIN, onD, 1) == E);
+
+        const bool succeeded = TaskGraphRun(graph);
+        u32 path[TASKGRAPH_MAX_TASKS] = {};
+        const u32 pathCount = TaskGraphCriticalPath(graph, path, TASKGRAPH_MAX_TASKS);
+        TaskTiming timings[TASK_COUNT] = {};
+        for (u32 i = 0; i < TASK_COUNT; i++)
+        {
+            timings[i] = *TaskGraphTaskTiming(graph, i);
+        }
+        TaskGraphDestroy(graph);
+
+        TEST_CHECK(succeeded);
+        for (u32 i = 0; i < TASK_COUNT; i++)
+        {
+            TEST_CHECK(tasks[i].m_Calls == 1 && timings[i].m_Ran && timings[i].m_Succeeded);
+        }
+        TEST_CHECK(tasks[A].m_Sequence < tasks[B].m_Sequence && tasks[A].m_Sequence < tasks[C].m_Sequence);
+        TEST_CHECK(tasks[B].m_Sequence < tasks[D].m_Sequence && tasks[C].m_Sequence < tasks[D].m_Sequence);
+        TEST_CHECK(tasks[D].m_Sequence < tasks[E].m_Sequence);
+        TEST_CHECK(timings[B].m_Start >= timings[A].m_End && timings[D].m_Start >= timings[B].m_End);
+        TEST_CHECK(tasks[E].m_Thread == 0 && timings[E].m_Thread == 0);
+        TEST_CHECK(pathCount == 4 && path[0] == A && path[1] == B && path[2] == D && path[3] == E);
+        return true;
+    }
+
+    // NOTE(sbalse): A failed task skips what depends on it, directly or not, and nothing else.
+    bool TestTaskGraphFailure()
+    {
+        enum { A, B, C, D, TASK_COUNT };
+        std::atomic<u32> nextSequence = 0;
+        TestTask tasks[TASK_COUNT] = {};
+        for (TestTask& task : tasks)
+        {
+            task = { .m_NextSequence = &nextSequence, .m_Sequence = 0, .m_Thread = 0, .m_Calls = 0, .m_SleepMs = 0,
+                .m_Result = true };
+        }
+        tasks[A].m_Result = false;
+
+        TaskGraph* graph = TaskGraphCreate();
+        const u32 onA[] = { A };
+        const u32 onB[] = { B };
+        TaskGraphAdd(graph, "A", TestTaskRun, &tasks[A], TaskAffinity::ANY, nullptr, 0);
+        TaskGraphAdd(graph, "B", TestTaskRun, &tasks[B], TaskAffinity::MAIN, onA, 1);
+        TaskGraphAdd(graph, "C", TestTaskRun, &tasks[C], TaskAffinity::ANY, onB, 1);
+        TaskGraphAdd(graph, "D", TestTaskRun, &tasks[D], TaskAffinity::ANY, nullptr, 0);
+
+        const bool succeeded = TaskGraphRun(graph);
+        const bool bRan = TaskGraphTaskTiming(graph, B)->m_Ran;
+        const bool cRan = TaskGraphTaskTiming(graph, C)->m_Ran;
+        const bool dSucceeded = TaskGraphTaskTiming(graph, D)->m_Succeeded;
+        TaskGraphDestroy(graph);
+
+        TEST_CHECK(!succeeded);
+        TEST_CHECK(tasks[A].m_Calls == 1 && tasks[D].m_Calls == 1 && dSucceeded);
+        TEST_CHECK(tasks[B].m_Calls == 0 && tasks[C].m_Calls == 0 && !bRan && !cRan);
+        return true;
+    }
+
+    // NOTE(sbalse): Depending on a task that doesn't exist yet, itself included, is what could close a cycle.
+    bool TestTaskGraphCycles()
+    {
+        std::atomic<u32> nextSequence = 0;
+        TestTask task = { .m_NextSequence = &nextSequence, .m_Sequence = 0, .m_Thread = 0, .m_Calls = 0,
+            .m_SleepMs = 0, .m_Result = true };
+
+        TaskGraph* graph = TaskGraphCreate();
+        const u32 first = TaskGraphAdd(graph, "first", TestTaskRun, &task, TaskAffinity::ANY, nullptr, 0);
+        const u32 onSelf[] = { 1 };
+        const u32 onLater[] = { first, 5 };
+        const u32 onInvalid[] = { TASKGRAPH_INVALID_TASK };
+        const u32 tooMany[TASKGRAPH_MAX_DEPENDENCIES + 1] = {};
+        const u32 self = TaskGraphAdd(graph, "self", TestTaskRun, &task, TaskAffinity::ANY, onSelf, 1);
+        const u32 later = TaskGraphAdd(graph, "later", TestTaskRun, &task, TaskAffinity::ANY, onLater, 2);
+        const u32 invalid = TaskGraphAdd(graph, "invalid", TestTaskRun, &task, TaskAffinity::ANY, onInvalid, 1);
+        const u32 crowded = TaskGraphAdd(
+            graph, "crowded", TestTaskRun, &task, TaskAffinity::ANY, tooMany, TASKGRAPH_MAX_DEPENDENCIES + 1);
+        const bool rejected = self == TASKGRAPH_INVALID_TASK && later == TASKGRAPH_INVALID_TASK
+            && invalid == TASKGRAPH_INVALID_TASK && crowded == TASKGRAPH_INVALID_TASK;
+        const u32 count = TaskGraphTaskCount(graph);
+
+        // NOTE(sbalse): The rejected tasks left nothing behind, the graph still runs. Running one with a cycle
+        // would never finish.
+        const bool succeeded = rejected && count == 1 && TaskGraphRun(graph);
+        TaskGraphDestroy(graph);
+
+        TEST_CHECK(first == 0);
+        TEST_CHECK(rejected);
+        TEST_CHECK(count == 1 && succeeded && task.m_Calls == 1);
+        return true;
+    }
+
+    bool TestTaskGraph()
+    {
+        // NOTE(sbalse): Serially on the calling thread, then on workers.
+        for (const u32 workerCount : { 0u, 3u })
+        {
+            if (workerCount > 0)
+            {
+                TEST_CHECK(JobsInit(workerCount));
+            }
+            const bool passed = TestTaskGraphOrdering() && TestTaskGraphFailure() && TestTaskGraphCycles();
+            if (workerCount > 0)
+            {
+                JobsShutdown();
+            }
+            TEST_CHECK(passed);
+        }
+        return true;
+    }
+
+    // NOTE(sbalse): A synthetic load, the frame time follows the pixel count like it does on the GPU.
+    struct TestResolutionPhase
+    {
+        float m_FixedMs;
+        float m_FullResolutionMs; // NOTE(sbalse): On top of the fixed part at a scale of 1.
+        u32 m_Frames;
+    };
+
+    float TestResolutionFrameMs(const TestResolutionPhase* phase, const float scale)
+    {
+        return phase->m_FixedMs + phase->m_FullResolutionMs * scale * scale;
+    }
+
+    // NOTE(sbalse): Runs the phases back to back with the frame times jittered by up to noise, relative. Each phase
+    // must bring the frame under the budget quickly and then settle: on the budget, or at a bound of the scale when
+    // the budget is out of reach, without changing the scale back and forth.
+    bool TestResolutionTrace(const TestResolutionPhase* phases, const u32 phaseCount, const float noise)
+    {
+        constexpr u32 maxSettleFrames = 30;
+
+        const DynamicResolutionSettings* settings = &DYNAMICRESOLUTION_DEFAULT_SETTINGS;
+        const float budgetMs = settings->m_BudgetMs;
+        const u32 maxSettledChanges = noise > 0.0f ? 10 : 0;
+
+        DynamicResolution resolution = {};
+        DynamicResolutionInit(&resolution, settings);
+        float scale = resolution.m_Scale;
+        u32 frame = 0;
+        for (u32 phaseIndex = 0; phaseIndex < phaseCount; phaseIndex++)
+        {
+            const TestResolutionPhase* phase = &phases[phaseIndex];
+            const u32 settledStart = phase->m_Frames / 2;
+            const float fullMs = TestResolutionFrameMs(phase, settings->m_MaxScale);
+            const float minMs = TestResolutionFrameMs(phase, settings->m_MinScale);
+            const bool overBudget = TestResolutionFrameMs(phase, scale) > budgetMs * (1.0f + settings->m_DeadBand);
+
+            u32 settleFrames = 0;
+            u32 settledChanges = 0;
+            double settledMs = 0.0;
+            for (u32 i = 0; i < phase->m_Frames; i++, frame++)
+            {
+                const RandomBlock random = RandomPhilox(47, frame);
+                const float jitter = 1.0f + noise * (2.0f * RandomUnitFloat(random.m_Values[0]) - 1.0f);
+                const u32 changes = resolution.m_Changes;
+                scale = DynamicResolutionUpdate(&resolution, TestResolutionFrameMs(phase, scale) * jitter);
+
+                const float frameMs = TestResolutionFrameMs(phase, scale);
+                if (settleFrames == 0 && frameMs <= budgetMs * (1.0f + settings->m_DeadBand))
+                {
+                    settleFrames = i + 1;
+                }
+                if (i >= settledStart)
+                {
+                    settledMs += frameMs;
+                    settledChanges += resolution.m_Changes - changes;
+                }
+            }
+            settledMs /= phase->m_Frames - settledStart;
+
+            const bool passed = (minMs > budgetMs
+                ? scale == settings->m_MinScale
+                : (fullMs <= budgetMs * (1.0f - settings->m_DeadBand)
+                    ? scale == settings->m_MaxScale
+                    : settledMs >= budgetMs * 0.85 && settledMs <= budgetMs * (1.0 + settings->m_DeadBand)))
+                && (!overBudget || minMs > budgetMs || settleFrames <= maxSettleFrames)
+                && settledChanges <= maxSettledChanges;
+            if (!passed)
+            {
+                std::printf(
+                    "    noise %.2f, phase %u: scale %.3f, settled at %.2f ms with %u changes, took %u frames\n",
+                    noise, phaseIndex, scale, settledMs, settledChanges, settleFrames);
+            }
+            TEST_CHECK(passed);
+        }
+        return true;
+    }
+
+    bool TestDynamicResolution()
+    {
+        // NOTE(sbalse): Heavy, light, heavy again, more than the lowest scale can handle, light again.
+        constexpr TestResolutionPhase phases[] =
+        {
+            { .m_FixedMs = 3.0f, .m_FullResolutionMs = 20.0f, .m_Frames = 600 },
+            { .m_FixedMs = 2.0f, .m_FullResolutionMs = 6.0f, .m_Frames = 600 },
+            { .m_FixedMs = 3.0f, .m_FullResolutionMs = 20.0f, .m_Frames = 600 },
+            { .m_FixedMs = 4.0f, .m_FullResolutionMs = 60.0f, .m_Frames = 600 },
+            { .m_FixedMs = 1.0f, .m_FullResolutionMs = 28.0f, .m_Frames = 600 },
+            { .m_FixedMs = 2.0f, .m_FullResolutionMs = 6.0f, .m_Frames = 900 },
+        };
+
+        for (const float noise : { 0.0f, 0.1f, 0.25f })
+        {
+            TEST_CHECK(TestResolutionTrace(phases, ArraySize(phases), noise));
+        }
+
+        // NOTE(sbalse): The same trace gives the same scales.
+        DynamicResolution first = {};
+        DynamicResolution second = {};
+        DynamicResolutionInit(&first, &DYNAMICRESOLUTION_DEFAULT_SETTINGS);
+        DynamicResolutionInit(&second, &DYNAMICRESOLUTION_DEFAULT_SETTINGS);
+        for (u32 i = 0; i < 2000; i++)
+        {
+            const float frameMs = 10.0f + 10.0f * RandomUnitFloat(RandomPhilox(48, i).m_Values[0]);
+            TEST_CHECK(DynamicResolutionUpdate(&first, frameMs) == DynamicResolutionUpdate(&second, frameMs));
+        }
+        TEST_CHECK(first.m_Changes == second.m_Changes && first.m_Changes > 0);
+        return true;
+    }
+
+    // NOTE(sbalse): Every pair of overlapping boxes, found the slow way, in the broadphase's pair order.
+    u32 TestBroadphaseBruteForce(const BroadphaseBounds* bounds, const u32 count, BroadphasePair* pairs)
+    {
+        u32 pairCount = 0;
+        for (u32 a = 0; a < count; a++)
+        {
+            for (u32 b = a + 1; b < count; b++)
+            {
+                bool overlap = true;
+                for (u32 axis = 0; axis < 3; axis++)
+                {
+                    overlap = overlap && bounds->m_Min[axis][a] <= bounds->m_Max[axis][b]
+                        && bounds->m_Min[axis][b] <= bounds->m_Max[axis][a];
+                }
+                if (overlap)
+                {
+                    pairs[pairCount++] = { .m_A = a, .m_B = b };
+                }
+            }
+        }
+        return pairCount;
+    }
+
+    bool TestBroadphasePairLess(const BroadphasePair& a, const BroadphasePair& b)
+    {
+        return a.m_A < b.m_A || (a.m_A == b.m_A && a.m_B < b.m_B);
+    }
+
+    // NOTE(sbalse): Boxes moving a little, which the insertion sort fixes up, and boxes jumping around, which get
+    // radix sorted from scratch, must both give exactly the pairs a brute force test finds.
+    bool TestBroadphase()
+    {
+        constexpr u32 objectCount = 2000;
+        constexpr u32 maxPairs = 64 * objectCount;
+
+        float* bounds = static_cast<float*>(std::calloc(static_cast<size_t>(objectCount) * 6, sizeof(float)));
+        BroadphasePair* expected = static_cast<BroadphasePair*>(std::calloc(maxPairs, sizeof(BroadphasePair)));
+        BroadphasePair* found = static_cast<BroadphasePair*>(std::calloc(maxPairs, sizeof(BroadphasePair)));
+        Broadphase* broadphase = BroadphaseCreate(objectCount);
+        TEST_CHECK(bounds && expected && found && broadphase);
+
+        const BroadphaseBounds boxes =
+        {
+            .m_Min = { bounds, bounds + objectCount, bounds + (objectCount * 2) },
+            .m_Max = { bounds + (objectCount * 3), bounds + (objectCount * 4), bounds + (objectCount * 5) },
+        };
+
+        bool passed = true;
+        bool sawInsertion = false;
+        bool sawResort = false;
+        for (u32 step = 0; passed && step < 20; step++)
+        {
+            // NOTE(sbalse): Every tenth step scatters the boxes, the rest nudge them.
+            const bool scatter = step % 10 == 0;
+            for (u32 i = 0; i < objectCount; i++)
+            {
+                const RandomBlock block = RandomPhilox(49, (static_cast<u64>(step) << 32) | i);
+                const float halfSize = scatter
+                    ? 0.5f + RandomUnitFloat(block.m_Values[3])
+                    : (bounds[(3 * objectCount) + i] - bounds[i]) * 0.5f;
+                for (u32 axis = 0; axis < 3; axis++)
+                {
+                    const float random = RandomUnitFloat(block.m_Values[axis]);
+                    const float center = scatter
+                        ? (random - 0.5f) * 40.0f
+                        : (bounds[axis * objectCount + i] + bounds[(axis + 3) * objectCount + i]) * 0.5f
+                            + (random - 0.5f) * 0.002f;
+                    bounds[axis * objectCount + i] = center - halfSize;
+                    bounds[(axis + 3) * objectCount + i] = center + halfSize;
+                }
+            }
+
+            const u32 pairCount = BroadphaseUpdate(broadphase, &boxes, objectCount);
+            u32 count = 0;
+            const BroadphasePair* pairs = BroadphaseGetPairs(broadphase, &count);
+            const u32 expectedCount = TestBroadphaseBruteForce(&boxes, objectCount, expected);
+            passed = pairCount == count && count == expectedCount && count <= maxPairs;
+            if (passed)
+            {
+                std::memcpy(found, pairs, count * sizeof(BroadphasePair));
+                std::sort(found, found + count, TestBroadphasePairLess);
+                passed = std::memcmp(found, expected, count * sizeof(BroadphasePair)) == 0;
+            }
+
+            const bool resorted = BroadphaseGetStats(broadphase)->m_Resorted;
+            sawResort = sawResort || (resorted && step > 0);
+            sawInsertion = sawInsertion || !resorted;
+        }
+
+        BroadphaseDestroy(broadphase);
+        std::free(found);
+        std::free(expected);
+        std::free(bounds);
+
+        TEST_CHECK(passed);
+        TEST_CHECK(sawInsertion && sawResort);
+        return true;
+    }
+
+    constexpr u32 TESTS_LIGHT_COUNT = 2000;
+    constexpr u32 TESTS_LIGHT_SAMPLES = 400;
+
+    // NOTE(sbalse): Clusters a light landed in, as a box of first and last tile and slice. m_Entries counts them.
+    struct TestLightBox
+    {
+        u32 m_First[3];
+        u32 m_Last[3];
+        u32 m_Entries;
+    };
+
+    // NOTE(sbalse): Cluster coordinates of a view space point the way the header describes them, false when the
+    // point is outside the frustum.
+    bool TestLightCluster(const LightClustersFrustum* frustum, const float* sliceStart, const Float3 point, u32* cell)
+    {
+        if (point.m_Z < frustum->m_Near || point.m_Z >= frustum->m_Far)
+        {
+            return false;
+        }
+
+        const float screen[2] =
+        {
+            point.m_X / point.m_Z * (2.0f * frustum->m_Near / frustum->m_Width),
+            point.m_Y / point.m_Z * (2.0f * frustum->m_Near / frustum->m_Height),
+        };
+        const u32 tiles[2] = { LIGHTCLUSTERS_TILES_X, LIGHTCLUSTERS_TILES_Y };
+        for (u32 axis = 0; axis < 2; axis++)
+        {
+            if (screen[axis] < -1.0f || screen[axis] > 1.0f)
+            {
+                return false;
+            }
+            const u32 tile = static_cast<u32>((screen[axis] + 1.0f) * 0.5f * static_cast<float>(tiles[axis]));
+            cell[axis] = tile < tiles[axis] ? tile : tiles[axis] - 1;
+        }
+
+        cell[2] = 0;
+        while (cell[2] + 1 < LIGHTCLUSTERS_SLICES && point.m_Z >= sliceStart[cell[2] + 1])
+        {
+            cell[2]++;
+        }
+        return true;
+    }
+
+    // NOTE(sbalse): Checks the clusters against a brute force assignment: points all over the inside of every light
+    // must land in clusters that list it. Point lights must not reach clusters that points on a sphere a little
+    // larger than theirs don't land in.
+    bool TestLightClustersAgainstSamples(
+        const LightClusters* clusters,
+        const LightClustersFrustum* frustum,
+        const LightClustersLights* lights,
+        TestLightBox* boxes)
+    {
+        for (u32 light = 0; light < TESTS_LIGHT_COUNT; light++)
+        {
+            boxes[light] = { .m_First = { ~0u, ~0u, ~0u }, .m_Last = {}, .m_Entries = 0 };
+        }
+
+        // NOTE(sbalse): Every list is in light order, and every light's clusters form a box.
+        const LightClustersRange* ranges = LightClustersGetRanges(clusters);
+        u32 indexCount = 0;
+        const u16* indices = LightClustersGetIndices(clusters, &indexCount);
+        for (u32 cluster = 0; cluster < LIGHTCLUSTERS_COUNT; cluster++)
+        {
+            const u32 cell[3] =
+            {
+                cluster % LIGHTCLUSTERS_TILES_X,
+                (cluster / LIGHTCLUSTERS_TILES_X) % LIGHTCLUSTERS_TILES_Y,
+                cluster / (LIGHTCLUSTERS_TILES_X * LIGHTCLUSTERS_TILES_Y),
+            };
+            TEST_CHECK(ranges[cluster].m_Offset + ranges[cluster].m_Count <= indexCount);
+            for (u32 i = 0; i < ranges[cluster].m_Count; i++)
+            {
+                const u32 light = indices[ranges[cluster].m_Offset + i];
+                TEST_CHECK(light < TESTS_LIGHT_COUNT);
+                TEST_CHECK(i == 0 || indices[ranges[cluster].m_Offset + i - 1] < light);
+                TestLightBox* box = &boxes[light];
+                for (u32 axis = 0; axis < 3; axis++)
+                {
+                    box->m_First[axis] = cell[axis] < box->m_First[axis] ? cell[axis] : box->m_First[axis];
+                    box->m_Last[axis] = cell[axis] > box->m_Last[axis] ? cell[axis] : box->m_Last[axis];
+                }
+                box->m_Entries++;
+            }
+        }
+
+        float sliceStart[LIGHTCLUSTERS_SLICES] = {};
+        const double ratio = static_cast<double>(frustum->m_Far) / frustum->m_Near;
+        for (u32 slice = 0; slice < LIGHTCLUSTERS_SLICES; slice++)
+        {
+            const double exponent = static_cast<double>(slice) / LIGHTCLUSTERS_SLICES;
+            sliceStart[slice] = static_cast<float>(frustum->m_Near * std::pow(ratio, exponent));
+        }
+
+        u32 visible = 0;
+        for (u32 light = 0; light < TESTS_LIGHT_COUNT; light++)
+        {
+            const TestLightBox* box = &boxes[light];
+            if (box->m_Entries > 0)
+            {
+                visible++;
+                TEST_CHECK(box->m_Entries == (box->m_Last[0] - box->m_First[0] + 1)
+                    * (box->m_Last[1] - box->m_First[1] + 1) * (box->m_Last[2] - box->m_First[2] + 1));
+            }
+
+            const Float3 position =
+            {
+                lights->m_Position[0][light], lights->m_Position[1][light], lights->m_Position[2][light],
+            };
+            const Float3 direction =
+            {
+                lights->m_Direction[0][light], lights->m_Direction[1][light], lights->m_Direction[2][light],
+            };
+            const float range = lights->m_Range[light];
+            const float cosine = lights->m_SpotCosine[light];
+
+            // NOTE(sbalse): Two unit vectors across the spot direction.
+            const Float3 helper = std::fabs(direction.m_X) < 0.9f ? Float3{ 1, 0, 0 } : Float3{ 0, 1, 0 };
+            Float3 across[2] = {};
+            across[0] =
+            {
+                direction.m_Y * helper.m_Z - direction.m_Z * helper.m_Y,
+                direction.m_Z * helper.m_X - direction.m_X * helper.m_Z,
+                direction.m_X * helper.m_Y - direction.m_Y * helper.m_X,
+            };
+            const float acrossLength = std::sqrt(
+                across[0].m_X * across[0].m_X + across[0].m_Y * across[0].m_Y + across[0].m_Z * across[0].m_Z);
+            across[0] = { across[0].m_X / acrossLength, across[0].m_Y / acrossLength, across[0].m_Z / acrossLength };
+            across[1] =
+            {
+                direction.m_Y * across[0].m_Z - direction.m_Z * across[0].m_Y,
+                direction.m_Z * across[0].m_X - direction.m_X * across[0].m_Z,
+                direction.m_X * across[0].m_Y - direction.m_Y * across[0].m_X,
+            };
+
+            for (u32 sample = 0; sample < TESTS_LIGHT_SAMPLES; sample++)
+            {
+                const RandomBlock random = RandomPhilox(51, (static_cast<u64>(light) << 32) | sample);
+                // NOTE(sbalse): A little inside the light, so rounding at its surface doesn't count.
+                const float distance = 0.99f * range * std::cbrt(RandomUnitFloat(random.m_Values[0]));
+                Float3 offset = {};
+                if (cosine > 0.0f)
+                {
+                    const float minCosine = cosine + 0.01f * (1.0f - cosine);
+                    const float pointCosine = minCosine + (1.0f - minCosine) * RandomUnitFloat(random.m_Values[1]);
+                    const float pointSine = std::sqrt(1.0f - pointCosine * pointCosine);
+                    const float angle = 6.2831853f * RandomUnitFloat(random.m_Values[2]);
+                    const float a = pointSine * std::cos(angle);
+                    const float b = pointSine * std::sin(angle);
+                    offset =
+                    {
+                        direction.m_X * pointCosine + across[0].m_X * a + across[1].m_X * b,
+                        direction.m_Y * pointCosine + across[0].m_Y * a + across[1].m_Y * b,
+                        direction.m_Z * pointCosine + across[0].m_Z * a + across[1].m_Z * b,
+                    };
+                }
+                else
+                {
+                    offset = TestRandomDirection(52, (static_cast<u64>(light) << 32) | sample);
+                }
+
+                const Float3 point =
+                {
+                    position.m_X + offset.m_X * distance,
+                    position.m_Y + offset.m_Y * distance,
+                    position.m_Z + offset.m_Z * distance,
+                };
+                u32 cell[3] = {};
+                if (!TestLightCluster(frustum, sliceStart, point, cell))
+                {
+                    continue;
+                }
+                for (u32 axis = 0; axis < 3; axis++)
+                {
+                    TEST_CHECK(box->m_Entries > 0);
+                    TEST_CHECK(cell[axis] >= box->m_First[axis] && cell[axis] <= box->m_Last[axis]);
+                }
+            }
+
+            // NOTE(sbalse): Only for lights entirely inside the frustum, the parts cut off by its sides still count for
+            // the depth range.
+            if (cosine > 0.0f || box->m_Entries == 0)
+            {
+                continue;
+            }
+            bool inside = true;
+            u32 first[3] = { ~0u, ~0u, ~0u };
+            u32 last[3] = {};
+            for (u32 sample = 0; sample < 4 * TESTS_LIGHT_SAMPLES; sample++)
+            {
+                const Float3 offset = TestRandomDirection(53, (static_cast<u64>(light) << 32) | sample);
+                const Float3 point =
+                {
+                    position.m_X + offset.m_X * range * 1.01f,
+                    position.m_Y + offset.m_Y * range * 1.01f,
+                    position.m_Z + offset.m_Z * range * 1.01f,
+                };
+                u32 cell[3] = {};
+                inside = inside && TestLightCluster(frustum, sliceStart, point, cell);
+                for (u32 axis = 0; inside && axis < 3; axis++)
+                {
+                    first[axis] = cell[axis] < first[axis] ? cell[axis] : first[axis];
+                    last[axis] = cell[axis] > last[axis] ? cell[axis] : last[axis];
+                }
+            }
+            for (u32 axis = 0; inside && axis < 3; axis++)
+            {
+                TEST_CHECK(box->m_First[axis] >= first[axis] && box->m_Last[axis] <= last[axis]);
+            }
+        }
+
+        TEST_CHECK(LightClustersGetStats(clusters)->m_Visible == visible);
+        TEST_CHECK(LightClustersGetStats(clusters)->m_Indices == indexCount);
+        return true;
+    }
+
+    // NOTE(sbalse): Point and spot lights scattered in and around the frustum, near the eye and past the far plane
+    // too, checked with the scalar and the AVX2 path and on workers.
+    bool TestLightClusters()
+    {
+        const LightClustersFrustum frustum = { .m_Width = 0.8f, .m_Height = 0.45f, .m_Near = 0.5f, .m_Far = 200.0f };
+
+        float* memory = static_cast<float*>(std::calloc(static_cast<size_t>(TESTS_LIGHT_COUNT) * 8, sizeof(float)));
+        TestLightBox* boxes = static_cast<TestLightBox*>(std::calloc(TESTS_LIGHT_COUNT, sizeof(TestLightBox)));
+        LightClusters* clusters = LightClustersCreate(TESTS_LIGHT_COUNT);
+        TEST_CHECK(memory && boxes && clusters);
+
+        LightClustersLights lights = {};
+        for (u32 i = 0; i < 3; i++)
+        {
+            lights.m_Position[i] = memory + (static_cast<size_t>(i) * TESTS_LIGHT_COUNT);
+            lights.m_Direction[i] = memory + (static_cast<size_t>(i + 3) * TESTS_LIGHT_COUNT);
+        }
+        lights.m_Range = memory + (static_cast<size_t>(6) * TESTS_LIGHT_COUNT);
+        lights.m_SpotCosine = memory + (static_cast<size_t>(7) * TESTS_LIGHT_COUNT);
+        for (u32 light = 0; light < TESTS_LIGHT_COUNT; light++)
+        {
+            const RandomBlock random = RandomPhilox(50, light);
+            const float depth = -10.0f + 230.0f * RandomUnitFloat(random.m_Values[2]);
+            const float spread = depth > 1.0f ? depth : 1.0f;
+            memory[light] = spread * (RandomUnitFloat(random.m_Values[0]) - 0.5f) * 1.4f;
+            memory[TESTS_LIGHT_COUNT + light] = spread * (RandomUnitFloat(random.m_Values[1]) - 0.5f) * 0.8f;
+            memory[(2 * TESTS_LIGHT_COUNT) + light] = depth;
+            const Float3 direction = TestRandomDirection(54, light);
+            memory[(3 * TESTS_LIGHT_COUNT) + light] = direction.m_X;
+            memory[(4 * TESTS_LIGHT_COUNT) + light] = direction.m_Y;
+            memory[(5 * TESTS_LIGHT_COUNT) + light] = direction.m_Z;
+            memory[(6 * TESTS_LIGHT_COUNT) + light] = 0.5f + 14.5f * RandomUnitFloat(random.m_Values[3]);
+            // NOTE(sbalse): Every other light is a spot, narrow and wide ones.
+            const float spotCosine = 0.1f + 0.88f * RandomUnitFloat(random.m_Values[3]);
+            memory[(7 * TESTS_LIGHT_COUNT) + light] = (light & 1) ? spotCosine : 0.0f;
+        }
+
+        bool passed = true;
+        for (u32 simd = 0; passed && simd < 2; simd++)
+        {
+            LightClustersEnableSimd(simd == 1);
+            passed = LightClustersUpdate(clusters, &frustum, &lights, TESTS_LIGHT_COUNT)
+                && TestLightClustersAgainstSamples(clusters, &frustum, &lights, boxes);
+        }
+        if (passed)
+        {
+            passed = JobsInit(3);
+            passed = passed && LightClustersUpdate(clusters, &frustum, &lights, TESTS_LIGHT_COUNT)
+                && TestLightClustersAgainstSamples(clusters, &frustum, &lights, boxes);
+            JobsShutdown();
+        }
+        LightClustersEnableSimd(true);
+
+        LightClustersDestroy(clusters);
+        std::free(boxes);
+        std::free(memory);
+        TEST_CHECK(passed);
+        return true;
+    }
+
+    constexpr const char* TESTS_CAPTURE_PATH = "hw3d_capture_test.hwcap";
+    constexpr u32 TESTS_CAPTURE_WIDTH = 75;
+    constexpr u32 TESTS_CAPTURE_HEIGHT = 70; // NOTE(sbalse): The last chunk is short.
+    constexpr u32 TESTS_CAPTURE_PITCH = (TESTS_CAPTURE_WIDTH * 4) + 20;
+    constexpr size_t TESTS_CAPTURE_BYTES = static_cast<size_t>(TESTS_CAPTURE_PITCH) * TESTS_CAPTURE_HEIGHT;
+    constexpr u32 TESTS_CAPTURE_FRAMES = 24;
+
+    // NOTE(sbalse): Left half flat runs that LZ4 matches, right half noise it has to keep as literals.
+    u8 TestCapturePixel(const u64 frame, const u32 x, const u32 y, const u32 channel)
+    {
+        if (x < TESTS_CAPTURE_WIDTH / 2)
+        {
+            return static_cast<u8>((frame * 7) + (y / 4) + channel);
+        }
+        const u32 index = (((y * TESTS_CAPTURE_WIDTH) + x) * 4) + channel;
+        return static_cast<u8>(RandomPhilox(static_cast<u32>(frame), index).m_Values[0]);
+    }
+
+    // NOTE(sbalse): Captures from padded rows in memory, skipping every fifth frame, and reads the file back.
+    // Every frame that comes out has to be the one it claims to be, in order, and every captured one has to.
+    bool TestFrameCaptureRoundTrip()
+    {
+        u8* framebuffer = static_cast<u8*>(std::malloc(TESTS_CAPTURE_BYTES));
+        u8* pixels = static_cast<u8*>(std::malloc(static_cast<size_t>(TESTS_CAPTURE_WIDTH) * TESTS_CAPTURE_HEIGHT * 4));
+        TEST_CHECK(framebuffer && pixels);
+
+        FrameCaptureMemorySource source =
+        {
+            .m_Pixels = framebuffer,
+            .m_Pitch = TESTS_CAPTURE_PITCH,
+            .m_Height = TESTS_CAPTURE_HEIGHT,
+            .m_Copies = {},
+        };
+        const FrameCaptureBackend backend = FrameCaptureMemoryBackend(&source);
+        const FrameCaptureDesc desc =
+        {
+            .m_Path = TESTS_CAPTURE_PATH,
+            .m_Width = TESTS_CAPTURE_WIDTH,
+            .m_Height = TESTS_CAPTURE_HEIGHT,
+            .m_Format = FrameCaptureFormat::RGBA8,
+            .m_SlotCount = 3,
+            .m_Latency = 2,
+        };
+        FrameCapture* capture = FrameCaptureCreate(&desc, &backend);
+        TEST_CHECK(capture);
+
+        u64 requested = 0;
+        for (u64 frame = 0; frame < TESTS_CAPTURE_FRAMES; frame++)
+        {
+            // NOTE(sbalse): The padding changes every frame too, none of it may end up in the file.
+            std::memset(framebuffer, static_cast<int>(frame), TESTS_CAPTURE_BYTES);
+            for (u32 y = 0; y < TESTS_CAPTURE_HEIGHT; y++)
+            {
+                for (u32 x = 0; x < TESTS_CAPTURE_WIDTH * 4; x++)
+                {
+                    framebuffer[(y * TESTS_CAPTURE_PITCH) + x] = TestCapturePixel(frame, x / 4, y, x % 4);
+                }
+            }
+            const bool captureFrame = frame % 5 != 4;
+            requested += captureFrame ? 1 : 0;
+            FrameCaptureUpdate(capture, captureFrame);
+        }
+        const FrameCaptureStats stats = FrameCaptureGetStats(capture);
+        FrameCaptureDestroy(capture);
+        FrameCaptureMemoryFree(&source);
+
+        FrameCaptureFileHeader header = {};
+        FrameCaptureReader* reader = FrameCaptureReaderOpen(TESTS_CAPTURE_PATH, &header);
+        u64 read = 0;
+        u64 previous = 0;
+        bool ordered = true;
+        bool matches = true;
+        u64 frameIndex = 0;
+        while (reader && FrameCaptureReadFrame(reader, &frameIndex, pixels))
+        {
+            ordered = ordered && (read == 0 || frameIndex > previous) && frameIndex % 5 != 4;
+            for (u32 i = 0; matches && i < TESTS_CAPTURE_WIDTH * TESTS_CAPTURE_HEIGHT * 4; i++)
+            {
+                const u32 x = (i / 4) % TESTS_CAPTURE_WIDTH;
+                const u32 y = (i / 4) / TESTS_CAPTURE_WIDTH;
+                matches = pixels[i] == TestCapturePixel(frameIndex, x, y, i % 4);
+            }
+            previous = frameIndex;
+            read++;
+        }
+        if (reader)
+        {
+            FrameCaptureReaderClose(reader);
+        }
+
+        std::free(pixels);
+        std::free(framebuffer);
+        std::remove(TESTS_CAPTURE_PATH);
+
+        TEST_CHECK(stats.m_Captured + stats.m_Dropped == requested);
+        TEST_CHECK(stats.m_Captured >= desc.m_SlotCount);
+        TEST_CHECK(reader);
+        TEST_CHECK(header.m_Width == TESTS_CAPTURE_WIDTH);
+        TEST_CHECK(header.m_Height == TESTS_CAPTURE_HEIGHT);
+        TEST_CHECK(header.m_Format == static_cast<u32>(FrameCaptureFormat::RGBA8));
+        TEST_CHECK(read == stats.m_Captured);
+        TEST_CHECK(ordered);
+        TEST_CHECK(matches);
+        return true;
+    }
+
+    bool TestFrameCapture()
+    {
+        TEST_CHECK(TestFrameCaptureRoundTrip());
+
+        const bool passed = JobsInit(3) && TestFrameCaptureRoundTrip();
+        JobsShutdown();
+        TEST_CHECK(passed);
+        return true;
+    }
+
+    constexpr u32 TESTS_GRAPH_MAX_PASSES = 8;
+
+    // NOTE(sbalse): What the passes of a test graph saw when they executed.
+    struct TestGraphLog
+    {
+        u32 m_Order[TESTS_GRAPH_MAX_PASSES];
+        u32 m_Count;
+        void* m_Outputs[TESTS_GRAPH_MAX_PASSES]; // NOTE(sbalse): Native texture each pass wrote, by pass.
+    };
+
+    struct TestGraphPass
+    {
+        TestGraphLog* m_Log;
+        u32 m_Id;
+        RenderGraphResource m_Output;
+    };
+
+    void TestGraphExecute(const RenderGraph* graph, void* userData)
+    {
+        const TestGraphPass* pass = static_cast<const TestGraphPass*>(userData);
+        TestGraphLog* log = pass->m_Log;
+        if (log->m_Count < TESTS_GRAPH_MAX_PASSES)
+        {
+            log->m_Order[log->m_Count++] = pass->m_Id;
+        }
+        log->m_Outputs[pass->m_Id] = RenderGraphGetNative(graph, pass->m_Output);
+    }
+
+    // NOTE(sbalse): Adds pass id writing output after reading inputs.
+    void TestGraphAddPass(
+        RenderGraph* graph,
+        TestGraphPass* passes,
+        const u32 id,
+        const RenderGraphResource output,
+        const std::initializer_list<RenderGraphResource> inputs)
+    {
+        passes[id].m_Id = id;
+        passes[id].m_Output = output;
+        const u32 pass = RenderGraphAddPass(graph, "TEST", TestGraphExecute, &passes[id]);
+        for (const RenderGraphResource input : inputs)
+        {
+            RenderGraphUse(graph, pass, input, RenderGraphUsage::SHADERREAD);
+        }
+        RenderGraphUse(graph, pass, output, RenderGraphUsage::RENDERTARGET);
+    }
+
+    RenderGraphResource TestGraphImportBackBuffer(RenderGraph* graph, int* backBuffer)
+    {
+        const RenderGraphTextureDesc desc =
+        {
+            .m_Width = 256,
+            .m_Height = 128,
+            .m_Format = RenderGraphFormat::BGRA8_UNORM,
+            .m_BindFlags = RENDERGRAPH_BIND_RENDERTARGET,
+        };
+        return RenderGraphImportTexture(
+            graph, "BACKBUFFER", &desc, backBuffer, RenderGraphUsage::PRESENT, RenderGraphUsage::PRESENT);
+    }
+
+    u32 TestGraphPosition(const TestGraphLog* log, const u32 id)
+    {
+        for (u32 i = 0; i < log->m_Count; i++)
+        {
+            if (log->m_Order[i] == id)
+            {
+                return i;
+            }
+        }
+        return TESTS_GRAPH_MAX_PASSES;
+    }
+
+    // NOTE(sbalse): A diamond, 0 feeds 1 and 2 which both feed 3 and the back buffer. Pass 4 reads 0 too, but
+    // nothing reads what it writes.
+    bool TestRenderGraphCulling()
+    {
+        RenderGraphNullDevice device = {};
+        const RenderGraphBackend backend = RenderGraphNullBackend(&device);
+        RenderGraph* graph = RenderGraphCreate(&backend);
+        TEST_CHECK(graph);
+
+        TestGraphLog log = {};
+        TestGraphPass passes[TESTS_GRAPH_MAX_PASSES] = {};
+        for (TestGraphPass& pass : passes)
+        {
+            pass.m_Log = &log;
+        }
+
+        RenderGraphReset(graph);
+        int backBuffer = 0;
+        const RenderGraphResource back = TestGraphImportBackBuffer(graph, &backBuffer);
+        RenderGraphResource textures[4] = {};
+        for (u32 i = 0; i < ArraySize(textures); i++)
+        {
+            textures[i] = RenderGraphCreateTexture(graph, "TEXTURE", 256, 128, RenderGraphFormat::RGBA8_UNORM);
+        }
+        TestGraphAddPass(graph, passes, 0, textures[0], {});
+        TestGraphAddPass(graph, passes, 1, textures[1], { textures[0] });
+        TestGraphAddPass(graph, passes, 2, textures[2], { textures[0] });
+        TestGraphAddPass(graph, passes, 4, textures[3], { textures[0] });
+        TestGraphAddPass(graph, passes, 3, back, { textures[1], textures[2] });
+
+        const bool compiled = RenderGraphCompile(graph);
+        if (compiled)
+        {
+            RenderGraphExecute(graph);
+        }
+        const RenderGraphStats stats = *RenderGraphGetStats(graph);
+        RenderGraphDestroy(graph);
+
+        TEST_CHECK(compiled);
+        TEST_CHECK(stats.m_DeclaredPasses == 5);
+        TEST_CHECK(stats.m_ExecutedPasses == 4);
+        TEST_CHECK(stats.m_CulledPasses == 1);
+        TEST_CHECK(log.m_Count == 4);
+        TEST_CHECK(TestGraphPosition(&log, 4) == TESTS_GRAPH_MAX_PASSES);
+        TEST_CHECK(TestGraphPosition(&log, 0) < TestGraphPosition(&log, 1));
+        TEST_CHECK(TestGraphPosition(&log, 0) < TestGraphPosition(&log, 2));
+        TEST_CHECK(TestGraphPosition(&log, 1) < TestGraphPosition(&log, 3));
+        TEST_CHECK(TestGraphPosition(&log, 2) < TestGraphPosition(&log, 3));
+        TEST_CHECK(log.m_Outputs[3] == &backBuffer);
+        // NOTE(sbalse): The culled pass's texture was never placed, the three in use are alive at once.
+        TEST_CHECK(stats.m_TransientTextures == 3);
+        TEST_CHECK(device.m_LiveTextures == 0);
+        return true;
+    }
+
+    // NOTE(sbalse): A chain of passes, each reading the texture the one before wrote. Textures two passes apart
+    // have disjoint lifetimes, neighbours overlap on the pass between them. The last texture has a different
+    // format, so it can't take the place of the one two passes before.
+    bool TestRenderGraphAliasing()
+    {
+        constexpr u32 width = 512;
+        constexpr u32 height = 256;
+
+        RenderGraphNullDevice device = {};
+        const RenderGraphBackend backend = RenderGraphNullBackend(&device);
+        RenderGraph* graph = RenderGraphCreate(&backend);
+        TEST_CHECK(graph);
+
+        bool passed = true;
+        for (u32 frame = 0; passed && frame < 2; frame++)
+        {
+            TestGraphLog log = {};
+            TestGraphPass passes[TESTS_GRAPH_MAX_PASSES] = {};
+            for (TestGraphPass& pass : passes)
+            {
+                pass.m_Log = &log;
+            }
+
+            RenderGraphReset(graph);
+            int backBuffer = 0;
+            const RenderGraphResource back = TestGraphImportBackBuffer(graph, &backBuffer);
+            RenderGraphResource textures[4] = {};
+            for (u32 i = 0; i < ArraySize(textures); i++)
+            {
+                const RenderGraphFormat format =
+                    i == 3 ? RenderGraphFormat::RGBA8_UNORM : RenderGraphFormat::RGBA16_FLOAT;
+                textures[i] = RenderGraphCreateTexture(graph, "TEXTURE", width, height, format);
+            }
+            TestGraphAddPass(graph, passes, 0, textures[0], {});
+            TestGraphAddPass(graph, passes, 1, textures[1], { textures[0] });
+            TestGraphAddPass(graph, passes, 2, textures[2], { textures[1] });
+            TestGraphAddPass(graph, passes, 3, textures[3], { textures[2] });
+            TestGraphAddPass(graph, passes, 4, back, { textures[3] });
+
+            passed = RenderGraphCompile(graph);
+            if (passed)
+            {
+                RenderGraphExecute(graph);
+            }
+            const RenderGraphStats* stats = RenderGraphGetStats(graph);
+            void* const* outputs = log.m_Outputs;
+            passed = passed
+                && log.m_Count == 5
+                && outputs[0] != outputs[1]
+                && outputs[1] != outputs[2]
+                && outputs[2] != outputs[3]
+                && outputs[0] == outputs[2]
+                && outputs[1] != outputs[3]
+                && stats->m_TransientTextures == 4
+                && stats->m_PhysicalTextures == 3
+                && stats->m_AliasedBytesSaved == static_cast<u64>(width) * height * 8
+                && stats->m_TransientBytes - stats->m_PhysicalBytes == stats->m_AliasedBytesSaved
+                // NOTE(sbalse): The second frame reuses the physical textures of the first.
+                && device.m_Creates == 3;
+        }
+
+        RenderGraphDestroy(graph);
+        TEST_CHECK(passed);
+        TEST_CHECK(device.m_LiveTextures == 0);
+        return true;
+    }
+
+    bool TestRenderGraph()
+    {
+        TEST_CHECK(TestRenderGraphCulling());
+        TEST_CHECK(TestRenderGraphAliasing());
+        return true;
+    }
+
+    // NOTE(sbalse): Reference decoders, written from the format descriptions rather than from the encoders.
+    void TestDecodeBc1(const u8* block, u8 (*texels)[4])
+    {
+        const u32 colors[2] =
+        {
+            static_cast<u32>(block[0] | (block[1] << 8)),
+            static_cast<u32>(block[2] | (block[3] << 8)),
+        };
+        i32 palette[4][3] = {};
+        for (u32 i = 0; i < 2; i++)
+        {
+            const u32 r = (colors[i] >> 11) & 31;
+            const u32 g = (colors[i] >> 5) & 63;
+            const u32 b = colors[i] & 31;
+            palette[i][0] = static_cast<i32>((r << 3) | (r >> 2));
+            palette[i][1] = static_cast<i32>((g << 2) | (g >> 4));
+            palette[i][2] = static_cast<i32>((b << 3) | (b >> 2));
+        }
+        for (u32 c = 0; c < 3; c++)
+        {
+            if (colors[0] > colors[1])
+            {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+            else
+            {
+                palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+                palette[3][c] = 0;
+            }
+        }
+
+        const u32 indices = block[4] | (block[5] << 8u) | (block[6] << 16u) | (static_cast<u32>(block[7]) << 24u);
+        for (u32 i = 0; i < 16; i++)
+        {
+            const u32 entry = (indices >> (i * 2)) & 3;
+            for (u32 c = 0; c < 3; c++)
+            {
+                texels[i][c] = static_cast<u8>(palette[entry][c]);
+            }
+            texels[i][3] = colors[0] <= colors[1] && entry == 3 ? 0 : 255;
+        }
+    }
+
+    u32 TestReadBits(const u8* block, u32* position, const u32 count)
+    {
+        u32 value = 0;
+        for (u32 i = 0; i < count; i++, (*position)++)
+        {
+            value |= ((block[*position / 8] >> (*position % 8)) & 1u) << i;
+        }
+        return value;
+    }
+
+    // NOTE(sbalse): Mode 6 only. Returns false for any other mode.
+    bool TestDecodeBc7(const u8* block, u8 (*texels)[4])
+    {
+        constexpr u32 weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+        u32 position = 0;
+        if (TestReadBits(block, &position, 7) != (1u << 6))
+        {
+            return false;
+        }
+
+        u32 endpoints[2][4] = {};
+        for (u32 c = 0; c < 4; c++)
+        {
+            endpoints[0][c] = TestReadBits(block, &position, 7) << 1;
+            endpoints[1][c] = TestReadBits(block, &position, 7) << 1;
+        }
+        for (u32 e = 0; e < 2; e++)
+        {
+            const u32 bit = TestReadBits(block, &position, 1);
+            for (u32 c = 0; c < 4; c++)
+            {
+                endpoints[e][c] |= bit;
+            }
+        }
+
+        for (u32 i = 0; i < 16; i++)
+        {
+            const u32 weight = weights[TestReadBits(block, &position, i == 0 ? 3 : 4)];
+            for (u32 c = 0; c < 4; c++)
+            {
+                texels[i][c] = static_cast<u8>(((64 - weight) * endpoints[0][c] + weight * endpoints[1][c] + 32) >> 6);
+            }
+        }
+        return position == 128;
+    }
+
+    // NOTE(sbalse): Compresses one 4x4 block through a texture build and decodes it again. Returns the largest
+    // difference of any channel, alpha only for BC7, or 256 when the block doesn't decode.
+    u32 TestTextureBlockError(const u8 (*source)[4], const TextureFormat format, u32* squaredError)
+    {
+        u8 pixels[16][4] = {};
+        std::memcpy(pixels, source, sizeof(pixels));
+        const TextureImage image = { .m_Pixels = &pixels[0][0], .m_Width = 4, .m_Height = 4 };
+        const TextureBuildDesc desc = { .m_Format = format, .m_Filter = TextureFilter::BOX, .m_Srgb = false };
+        TextureFile* texture = TextureBuild(&image, &desc);
+        if (!texture)
+        {
+            return 256;
+        }
+
+        u8 decoded[16][4] = {};
+        const u8* block = static_cast<const u8*>(TextureGetMipData(texture, 0));
+        bool valid = true;
+        if (format == TextureFormat::BC1)
+        {
+            TestDecodeBc1(block, decoded);
+        }
+        else
+        {
+            valid = TestDecodeBc7(block, decoded);
+        }
+        TextureFree(texture);
+
+        const u32 channels = format == TextureFormat::BC1 ? 3 : 4;
+        u32 largest = 0;
+        *squaredError = 0;
+        for (u32 i = 0; i < 16; i++)
+        {
+            for (u32 c = 0; c < channels; c++)
+            {
+                const i32 difference = static_cast<i32>(decoded[i][c]) - source[i][c];
+                const u32 error = static_cast<u32>(difference < 0 ? -difference : difference);
+                largest = error > largest ? error : largest;
+                *squaredError += error * error;
+            }
+        }
+        return valid ? largest : 256;
+    }
+
+    // NOTE(sbalse): What a plain fit gets on the block: endpoints at the corners of the bounding box, quantized
+    // like the format does, and every texel on the nearest of four or sixteen evenly spaced steps.
+    u32 TestTextureBoundingBoxError(const u8 (*source)[4], const TextureFormat format)
+    {
+        const u32 channels = format == TextureFormat::BC1 ? 3 : 4;
+        const u32 steps = format == TextureFormat::BC1 ? 4 : 16;
+        float low[4] = { 255.0f, 255.0f, 255.0f, 255.0f };
+        float high[4] = {};
+        for (u32 i = 0; i < 16; i++)
+        {
+            for (u32 c = 0; c < channels; c++)
+            {
+                low[c] = std::fmin(low[c], source[i][c]);
+                high[c] = std::fmax(high[c], source[i][c]);
+            }
+        }
+        for (u32 c = 0; c < channels; c++)
+        {
+            const float step = format == TextureFormat::BC7 ? 2.0f : (c == 1 ? 255.0f / 63.0f : 255.0f / 31.0f);
+            low[c] = std::round(low[c] / step) * step;
+            high[c] = std::round(high[c] / step) * step;
+        }
+
+        u32 total = 0;
+        for (u32 i = 0; i < 16; i++)
+        {
+            float best = 1e30f;
+            for (u32 s = 0; s < steps; s++)
+            {
+                const float t = static_cast<float>(s) / static_cast<float>(steps - 1);
+                float error = 0.0f;
+                for (u32 c = 0; c < channels; c++)
+                {
+                    const float value = std::round(low[c] + (high[c] - low[c]) * t);
+                    error += (value - source[i][c]) * (value - source[i][c]);
+                }
+                best = std::fmin(best, error);
+            }
+            total += static_cast<u32>(best);
+        }
+        return total;
+    }
+
+    bool TestTextureBlocks()
+    {
+        // NOTE(sbalse): Every channel a ramp along the same line, the case both formats are built for. Ramps
+        // across the block for BC7, one step per column for the four colors of BC1.
+        u8 gradient[16][4] = {};
+        u8 columns[16][4] = {};
+        for (u32 i = 0; i < 16; i++)
+        {
+            gradient[i][0] = static_cast<u8>(10 + (i * 14));
+            gradient[i][1] = static_cast<u8>(40 + (i * 9));
+            gradient[i][2] = static_cast<u8>(230 - (i * 12));
+            gradient[i][3] = static_cast<u8>(255 - (i * 8));
+            const u32 x = i % 4;
+            columns[i][0] = static_cast<u8>(40 + (x * 48));
+            columns[i][1] = static_cast<u8>(60 + (x * 40));
+            columns[i][2] = static_cast<u8>(200 - (x * 56));
+            columns[i][3] = 255;
+        }
+
+        u32 squaredError = 0;
+        TEST_CHECK(TestTextureBlockError(columns, TextureFormat::BC1, &squaredError) <= 6);
+        TEST_CHECK(TestTextureBlockError(gradient, TextureFormat::BC7, &squaredError) <= 3);
+
+        // NOTE(sbalse): Random colors on a random line. Half a step of the palette is the only error left, plus
+        // rounding the endpoints.
+        for (u32 seed = 0; seed < 64; seed++)
+        {
+            const RandomBlock ends = RandomPhilox(seed, 1000);
+            u8 line[16][4] = {};
+            u32 range = 0;
+            for (u32 c = 0; c < 4; c++)
+            {
+                const u32 low = ends.m_Values[c] & 0xFF;
+                const u32 high = (ends.m_Values[c] >> 8) & 0xFF;
+                range = std::max(range, low > high ? low - high : high - low);
+                for (u32 i = 0; i < 16; i++)
+                {
+                    const float t = RandomUnitFloat(RandomPhilox(seed, i).m_Values[0]);
+                    const float value = static_cast<float>(low) + (t * (static_cast<float>(high) - low));
+                    line[i][c] = static_cast<u8>(std::lround(value));
+                }
+            }
+            TEST_CHECK(TestTextureBlockError(line, TextureFormat::BC1, &squaredError) <= range / 6 + 6);
+            TEST_CHECK(TestTextureBlockError(line, TextureFormat::BC7, &squaredError) <= range / 30 + 3);
+        }
+
+        // NOTE(sbalse): Noise doesn't lie on a line, the bound only catches blocks that went badly wrong. Across
+        // the blocks the fit has to do better than the bounding box.
+        u32 fitError[2] = {};
+        u32 boxError[2] = {};
+        for (u32 seed = 0; seed < 64; seed++)
+        {
+            u8 noise[16][4] = {};
+            for (u32 i = 0; i < 16; i++)
+            {
+                const RandomBlock random = RandomPhilox(seed, i);
+                for (u32 c = 0; c < 4; c++)
+                {
+                    noise[i][c] = static_cast<u8>(random.m_Values[c]);
+                }
+            }
+
+            TEST_CHECK(TestTextureBlockError(noise, TextureFormat::BC1, &squaredError) <= 192);
+            fitError[0] += squaredError;
+            boxError[0] += TestTextureBoundingBoxError(noise, TextureFormat::BC1);
+            TEST_CHECK(TestTextureBlockError(noise, TextureFormat::BC7, &squaredError) <= 192);
+            fitError[1] += squaredError;
+            boxError[1] += TestTextureBoundingBoxError(noise, TextureFormat::BC7);
+        }
+        TEST_CHECK(fitError[0] < boxError[0]);
+        TEST_CHECK(fitError[1] < boxError[1]);
+        return true;
+    }
+
+    // NOTE(sbalse): Filtering a constant image has to give the same constant on every level, with either filter
+    // and in linear light too.
+    bool TestTextureConstantMips()
+    {
+        constexpr u32 width = 32;
+        constexpr u32 height = 8;
+        constexpr u8 color[4] = { 200, 97, 13, 128 };
+
+        u8* pixels = static_cast<u8*>(std::malloc(static_cast<size_t>(width) * height * 4));
+        TEST_CHECK(pixels);
+        for (u32 i = 0; i < width * height; i++)
+        {
+            std::memcpy(pixels + (i * 4), color, sizeof(color));
+        }
+
+        const TextureImage image = { .m_Pixels = pixels, .m_Width = width, .m_Height = height };
+        bool constant = true;
+        u32 mipCount = 0;
+        for (u32 variant = 0; constant && variant < 4; variant++)
+        {
+            const TextureBuildDesc desc =
+            {
+                .m_Format = TextureFormat::RGBA8,
+                .m_Filter = variant % 2 ? TextureFilter::KAISER : TextureFilter::BOX,
+                .m_Srgb = variant >= 2,
+            };
+            TextureFile* texture = TextureBuild(&image, &desc);
+            constant = texture != nullptr;
+            mipCount = texture ? texture->m_MipCount : 0;
+            for (u32 mip = 0; constant && mip < mipCount; mip++)
+            {
+                const TextureMip* level = &texture->m_Mips[mip];
+                const u8* texels = static_cast<const u8*>(TextureGetMipData(texture, mip));
+                for (u32 i = 0; constant && i < level->m_Width * level->m_Height; i++)
+                {
+                    constant = std::memcmp(texels + (i * 4), color, sizeof(color)) == 0;
+                }
+            }
+            TextureFree(texture);
+        }
+        std::free(pixels);
+
+        TEST_CHECK(constant);
+        TEST_CHECK(mipCount == 6);
+        return true;
+    }
+
+    bool TestTexture()
+    {
+        TEST_CHECK(TestTextureBlocks());
+        TEST_CHECK(TestTextureConstantMips());
+        return true;
+    }
+
+    constexpr u32 TESTS_ANIM_TRACKS = 12;
+    constexpr u32 TESTS_ANIM_FRAMES = 300;
+    constexpr float TESTS_ANIM_FRAME_RATE = 30.0f;
+
+    // NOTE(sbalse): Angle between two rotations, the same measure compression bounds.
+    double TestRotationAngle(const float* a, const float* b)
+    {
+        const double dot = static_cast<double>(a[0]) * b[0] + static_cast<double>(a[1]) * b[1]
+            + static_cast<double>(a[2]) * b[2] + static_cast<double>(a[3]) * b[3];
+        double distanceSquared = 0.0;
+        for (u32 i = 0; i < 4; i++)
+        {
+            const double difference = a[i] - (dot < 0.0 ? -static_cast<double>(b[i]) : b[i]);
+            distanceSquared += difference * difference;
+        }
+        return 4.0 * std::asin(std::fmin(std::sqrt(distanceSquared) * 0.5, 1.0));
+    }
+
+    // NOTE(sbalse): Every track turns about a random axis by a random walk of speeds and drifts, some tracks hold
+    // still for a stretch and some jump, so segments of every length come out of compression.
+    void TestMakeAnimFrames(AnimTransform* frames)
+    {
+        for (u32 track = 0; track < TESTS_ANIM_TRACKS; track++)
+        {
+            const RandomBlock axisBits = RandomPhilox(70, track);
+            float axis[3] = {};
+            float axisLength = 0.0f;
+            for (u32 i = 0; i < 3; i++)
+            {
+                axis[i] = RandomFloat(axisBits.m_Values[i], { .m_Min = -1.0f, .m_Max = 1.0f });
+                axisLength += axis[i] * axis[i];
+            }
+            axisLength = std::sqrt(axisLength) + 1e-6f;
+
+            float angle = 0.0f;
+            float speed = 0.0f;
+            float translation[3] = {};
+            for (u32 frame = 0; frame < TESTS_ANIM_FRAMES; frame++)
+            {
+                const RandomBlock random = RandomPhilox(71 + track, frame);
+                speed += RandomFloat(random.m_Values[0], { .m_Min = -0.01f, .m_Max = 0.01f });
+                const bool still = (frame / 50 + track) % 3 == 0;
+                const bool jump = random.m_Values[1] % 97 == 0;
+                angle += still ? 0.0f : speed + (jump ? 0.8f : 0.0f);
+                for (u32 i = 0; i < 3; i++)
+                {
+                    translation[i] += still ? 0.0f : RandomFloat(random.m_Values[2 + (i % 2)] >> (i * 4),
+                        { .m_Min = -0.02f, .m_Max = 0.02f });
+                }
+
+                AnimTransform* transform = &frames[(frame * TESTS_ANIM_TRACKS) + track];
+                for (u32 i = 0; i < 3; i++)
+                {
+                    transform->m_Rotation[i] = axis[i] / axisLength * std::sin(angle * 0.5f);
+                    transform->m_Translation[i] = translation[i] + static_cast<float>(track);
+                }
+                transform->m_Rotation[3] = std::cos(angle * 0.5f);
+            }
+        }
+    }
+
+    // NOTE(sbalse): Samples the clip at every frame, one instance per frame, with SIMD off and on. Both have to
+    // match bit for bit and stay within the tolerance of the raw frames.
+    bool TestAnimClip()
+    {
+        constexpr AnimClipTolerance tolerance = { .m_Rotation = 0.002f, .m_Translation = 0.001f };
+        constexpr size_t poseCount = static_cast<size_t>(TESTS_ANIM_FRAMES) * TESTS_ANIM_TRACKS;
+
+        AnimTransform* frames = static_cast<AnimTransform*>(std::calloc(poseCount, sizeof(AnimTransform)));
+        AnimTransform* poses[2] =
+        {
+            static_cast<AnimTransform*>(std::calloc(poseCount, sizeof(AnimTransform))),
+            static_cast<AnimTransform*>(std::calloc(poseCount, sizeof(AnimTransform))),
+        };
+        float* times = static_cast<float*>(std::calloc(TESTS_ANIM_FRAMES, sizeof(float)));
+        TEST_CHECK(frames && poses[0] && poses[1] && times);
+
+        TestMakeAnimFrames(frames);
+        const AnimClipSource source =
+        {
+            .m_Frames = frames,
+            .m_TrackCount = TESTS_ANIM_TRACKS,
+            .m_FrameCount = TESTS_ANIM_FRAMES,
+            .m_FrameRate = TESTS_ANIM_FRAME_RATE,
+        };
+        AnimClip* clip = AnimClipCompress(&source, &tolerance);
+        TEST_CHECK(clip);
+
+        for (u32 frame = 0; frame < TESTS_ANIM_FRAMES; frame++)
+        {
+            times[frame] = static_cast<float>(frame) / TESTS_ANIM_FRAME_RATE;
+        }
+        for (u32 simd = 0; simd < 2; simd++)
+        {
+            AnimClipEnableSimd(simd == 1);
+            AnimClipSample(clip, times, TESTS_ANIM_FRAMES, poses[simd]);
+        }
+        AnimClipEnableSimd(true);
+
+        // NOTE(sbalse): Frame times in seconds don't map back onto whole frames exactly in float, the blend is off by
+        // a few units in the last place. Allow that much on top of the tolerance, relative to the size of the values.
+        constexpr double slack = 8.0 * FLT_EPSILON;
+        bool rotationsWithin = true;
+        bool translationsWithin = true;
+        for (size_t i = 0; i < poseCount; i++)
+        {
+            const double angle = TestRotationAngle(poses[0][i].m_Rotation, frames[i].m_Rotation);
+            rotationsWithin = rotationsWithin && angle <= tolerance.m_Rotation + slack;
+
+            double distanceSquared = 0.0;
+            double size = 1.0;
+            for (u32 j = 0; j < 3; j++)
+            {
+                const double value = frames[i].m_Translation[j];
+                distanceSquared += (poses[0][i].m_Translation[j] - value) * (poses[0][i].m_Translation[j] - value);
+                size = std::fmax(size, std::fabs(value));
+            }
+            const double distance = std::sqrt(distanceSquared);
+            translationsWithin = translationsWithin && distance <= tolerance.m_Translation + (slack * size);
+        }
+        const bool identical = std::memcmp(poses[0], poses[1], poseCount * sizeof(AnimTransform)) == 0;
+        // NOTE(sbalse): Dropping keys has to have happened, or the bound says nothing.
+        const AnimClipTrack* tracks = reinterpret_cast<const AnimClipTrack*>(
+            reinterpret_cast<const u8*>(clip) + clip->m_Tracks.m_Offset);
+        u32 keyCount = 0;
+        for (u32 track = 0; track < TESTS_ANIM_TRACKS; track++)
+        {
+            keyCount += tracks[track].m_RotationKeyCount + tracks[track].m_TranslationKeyCount;
+        }
+
+        AnimClipFree(clip);
+        std::free(times);
+        std::free(poses[1]);
+        std::free(poses[0]);
+        std::free(frames);
+
+        TEST_CHECK(identical);
+        TEST_CHECK(rotationsWithin);
+        TEST_CHECK(translationsWithin);
+        TEST_CHECK(keyCount < 2 * TESTS_ANIM_FRAMES * TESTS_ANIM_TRACKS);
+        return true;
+    }
+
+    constexpr u32 TESTS_TWEEN_COUNT = 1003; // NOTE(sbalse): Not a multiple of eight, the tail runs scalar.
+
+    // NOTE(sbalse): Fills a pool with tweens of every curve and wrap, some far into their curves already.
+    bool TestFillTweenPool(TweenPool* pool, TweenHandle* handles)
+    {
+        constexpr TweenKey keys[] = { { 0.0f, 0.0f }, { 0.3f, 1.2f }, { 0.6f, -0.4f }, { 1.0f, 1.0f } };
+        const TweenCurve keyed = TweenPoolAddCurve(pool, keys, static_cast<u32>(ArraySize(keys)));
+        TEST_CHECK(keyed != TWEENS_INVALID_CURVE);
+
+        for (u32 i = 0; i < TESTS_TWEEN_COUNT; i++)
+        {
+            const RandomBlock random = RandomPhilox(80, i);
+            const TweenDesc desc =
+            {
+                .m_From = RandomFloat(random.m_Values[0], { .m_Min = -10.0f, .m_Max = 10.0f }),
+                .m_Delta = RandomFloat(random.m_Values[1], { .m_Min = -20.0f, .m_Max = 20.0f }),
+                .m_Duration = RandomFloat(random.m_Values[2], { .m_Min = 0.05f, .m_Max = 2.0f }),
+                .m_Offset = RandomFloat(random.m_Values[3], { .m_Min = 0.0f, .m_Max = 5.0f }),
+                .m_Curve = i % 9 == 8 ? keyed : TweenEaseCurve(static_cast<TweenEase>(i % 8)),
+                .m_Wrap = static_cast<TweenWrap>((i / 9) % 3),
+                .m_Stream = i % 2,
+                .m_Index = i / 2,
+            };
+            handles[i] = TweenAdd(pool, &desc);
+            TEST_CHECK(handles[i] != TWEENS_INVALID_HANDLE);
+        }
+        return true;
+    }
+
+    // NOTE(sbalse): Two identical pools, one updated scalar and one with AVX2, through small steps, steps that
+    // wrap several times over and removals that move tweens around. Values and phases have to match bit for bit.
+    bool TestTweensSimdMatchesScalar()
+    {
+        constexpr u32 streamSize = (TESTS_TWEEN_COUNT + 1) / 2;
+
+        TweenPool* pools[2] = { TweenPoolCreate(TESTS_TWEEN_COUNT), TweenPoolCreate(TESTS_TWEEN_COUNT) };
+        TweenHandle handles[2][TESTS_TWEEN_COUNT] = {};
+        float values[2][2][streamSize] = {};
+        TEST_CHECK(pools[0] && pools[1]);
+        TEST_CHECK(TestFillTweenPool(pools[0], handles[0]));
+        TEST_CHECK(TestFillTweenPool(pools[1], handles[1]));
+
+        bool identical = true;
+        for (u32 step = 0; identical && step < 240; step++)
+        {
+            const float stepSeconds = step % 40 == 39 ? 3.7f : 1.0f / 60.0f;
+            for (u32 mode = 0; mode < 2; mode++)
+            {
+                if (step == 120)
+                {
+                    for (u32 i = 0; i < TESTS_TWEEN_COUNT; i += 7)
+                    {
+                        TweenRemove(pools[mode], handles[mode][i]);
+                    }
+                }
+                TweensEnableSimd(mode == 1);
+                float* const outputs[2] = { values[mode][0], values[mode][1] };
+                TweenPoolUpdate(pools[mode], stepSeconds, outputs);
+            }
+            const u32 count = TweenPoolGetCount(pools[0]);
+            identical = count == TweenPoolGetCount(pools[1])
+                && std::memcmp(values[0], values[1], sizeof(values[0])) == 0
+                && std::memcmp(TweenPoolGetPhases(pools[0]), TweenPoolGetPhases(pools[1]), count * sizeof(float)) == 0;
+        }
+        TweensEnableSimd(true);
+
+        TweenPoolDestroy(pools[0]);
+        TweenPoolDestroy(pools[1]);
+        TEST_CHECK(identical);
+        return true;
+    }
+
+    // NOTE(sbalse): A linear tween from 10 to 14 over a second with every wrap, stepped in quarters of a second so
+    // every step lands on a segment of the curve exactly, through both ends twice.
+    bool TestTweensEndpoints()
+    {
+        constexpr float from = 10.0f;
+        constexpr float delta = 4.0f;
+
+        bool passed = true;
+        for (u32 mode = 0; passed && mode < 2; mode++)
+        {
+            TweensEnableSimd(mode == 1);
+            TweenPool* pool = TweenPoolCreate(static_cast<u32>(TweenWrap::COUNT));
+            TEST_CHECK(pool);
+            for (u32 wrap = 0; wrap < static_cast<u32>(TweenWrap::COUNT); wrap++)
+            {
+                const TweenDesc desc =
+                {
+                    .m_From = from,
+                    .m_Delta = delta,
+                    .m_Duration = 1.0f,
+                    .m_Offset = 0.0f,
+                    .m_Curve = TweenEaseCurve(TweenEase::LINEAR),
+                    .m_Wrap = static_cast<TweenWrap>(wrap),
+                    .m_Stream = 0,
+                    .m_Index = wrap,
+                };
+                passed = passed && TweenAdd(pool, &desc) != TWEENS_INVALID_HANDLE;
+            }
+
+            for (u32 step = 1; passed && step <= 12; step++)
+            {
+                float values[static_cast<u32>(TweenWrap::COUNT)] = {};
+                float* const outputs[1] = { values };
+                TweenPoolUpdate(pool, 0.25f, outputs);
+
+                const float seconds = static_cast<float>(step) * 0.25f;
+                const float looped = seconds - std::floor(seconds);
+                const float bounced = seconds - (2.0f * std::floor(seconds * 0.5f));
+                const float expected[] =
+                {
+                    from + (delta * std::fmin(seconds, 1.0f)),
+                    from + (delta * looped),
+                    from + (delta * (1.0f - std::fabs(bounced - 1.0f))),
+                };
+                for (u32 wrap = 0; wrap < static_cast<u32>(TweenWrap::COUNT); wrap++)
+                {
+                    passed = passed && std::fabs(values[wrap] - expected[wrap]) <= 1e-5f;
+                }
+                // NOTE(sbalse): Clamped tweens hold the end value exactly.
+                passed = passed && (seconds < 1.0f || values[0] == from + delta);
+            }
+            TweenPoolDestroy(pool);
+        }
+        TweensEnableSimd(true);
+
+        TEST_CHECK(passed);
+        return true;
+    }
+
+    bool TestTweens()
+    {
+        TEST_CHECK(TestTweensSimdMatchesScalar());
+        TEST_CHECK(TestTweensEndpoints());
+        return true;
+    }
+
+    // NOTE(sbalse): Two identical emitters, one updated scalar and one with AVX2, through steps that spawn, kill
+    // and compact. The pool grows past a job batch so the batches get stitched together too. The pools have to
+    // match bit for bit after every step.
+    bool TestParticlesSimdMatchesScalar()
+    {
+        const ParticleEmitterDesc desc =
+        {
+            .m_Position = { 1.0f, -2.0f, 3.0f },
+            .m_Velocity = { 0.5f, 6.0f, -0.5f },
+            .m_VelocitySpread = { 2.0f, 1.5f, 2.0f },
+            .m_LifetimeMin = 0.05f,
+            .m_LifetimeMax = 1.5f,
+            .m_Rate = 30'000.0f,
+            .m_Color = QuantizeColor(1.0f, 1.0f, 1.0f, 1.0f),
+            .m_Seed = 21,
+        };
+        const ParticleForces forces = { .m_Gravity = { 0.0f, -9.8f, 0.0f }, .m_Drag = 0.4f };
+        ParticleEmitter* emitters[2] = { ParticleEmitterCreate(&desc, 40'000), ParticleEmitterCreate(&desc, 40'000) };
+        TEST_CHECK(emitters[0] && emitters[1]);
+
+        bool identical = true;
+        u32 largestCount = 0;
+        for (u32 step = 0; identical && step < 90; step++)
+        {
+            const float stepSeconds = step % 15 == 14 ? 0.2f : 1.0f / 60.0f;
+            for (u32 mode = 0; mode < 2; mode++)
+            {
+                ParticlesEnableSimd(mode == 1);
+                ParticleEmitterUpdate(emitters[mode], &forces, stepSeconds);
+            }
+
+            const ParticlePool* pools[2] = { ParticleEmitterGetPool(emitters[0]), ParticleEmitterGetPool(emitters[1]) };
+            const size_t bytes = static_cast<size_t>(pools[0]->m_Count) * sizeof(float);
+            identical = pools[0]->m_Count == pools[1]->m_Count
+                && std::memcmp(pools[0]->m_PositionX, pools[1]->m_PositionX, bytes) == 0
+                && std::memcmp(pools[0]->m_PositionY, pools[1]->m_PositionY, bytes) == 0
+                && std::memcmp(pools[0]->m_PositionZ, pools[1]->m_PositionZ, bytes) == 0
+                && std::memcmp(pools[0]->m_VelocityX, pools[1]->m_VelocityX, bytes) == 0
+                && std::memcmp(pools[0]->m_VelocityY, pools[1]->m_VelocityY, bytes) == 0
+                && std::memcmp(pools[0]->m_VelocityZ, pools[1]->m_VelocityZ, bytes) == 0
+                && std::memcmp(pools[0]->m_Age, pools[1]->m_Age, bytes) == 0
+                && std::memcmp(pools[0]->m_Lifetime, pools[1]->m_Lifetime, bytes) == 0;
+            largestCount = std::max(largestCount, pools[0]->m_Count);
+        }
+        ParticlesEnableSimd(true);
+
+        ParticleEmitterDestroy(emitters[0]);
+        ParticleEmitterDestroy(emitters[1]);
+        TEST_CHECK(identical);
+        TEST_CHECK(largestCount > PARTICLES_JOB_BATCH);
+        return true;
+    }
+
+    constexpr u32 TESTS_PARTICLE_COUNT = 1003;
+    constexpr u32 TESTS_PARTICLE_BEGIN = 5;
+    constexpr u32 TESTS_PARTICLE_END = 1000; // NOTE(sbalse): Not a multiple of eight from begin, the tail runs scalar.
+    constexpr float TESTS_PARTICLE_UNTOUCHED = -1.0f;
+
+    struct TestParticleStorage
+    {
+        float m_Streams[8][TESTS_PARTICLE_COUNT];
+    };
+
+    // NOTE(sbalse): Every particle carries its index in its Y position and doesn't move on Y, so the survivors
+    // can be told apart after compaction. Particles outside the range get a value the range never has.
+    ParticlePool TestMakeParticlePool(TestParticleStorage* storage, const bool* alive)
+    {
+        ParticlePool pool =
+        {
+            .m_Count = TESTS_PARTICLE_COUNT,
+            .m_Capacity = TESTS_PARTICLE_COUNT,
+            .m_PositionX = storage->m_Streams[0],
+            .m_PositionY = storage->m_Streams[1],
+            .m_PositionZ = storage->m_Streams[2],
+            .m_VelocityX = storage->m_Streams[3],
+            .m_VelocityY = storage->m_Streams[4],
+            .m_VelocityZ = storage->m_Streams[5],
+            .m_Age = storage->m_Streams[6],
+            .m_Lifetime = storage->m_Streams[7],
+        };
+        for (u32 i = 0; i < TESTS_PARTICLE_COUNT; i++)
+        {
+            const bool inRange = i >= TESTS_PARTICLE_BEGIN && i < TESTS_PARTICLE_END;
+            pool.m_PositionX[i] = static_cast<float>(i) * 0.5f;
+            pool.m_PositionY[i] = inRange ? static_cast<float>(i) : TESTS_PARTICLE_UNTOUCHED;
+            pool.m_PositionZ[i] = -static_cast<float>(i);
+            pool.m_VelocityX[i] = 1.0f;
+            pool.m_VelocityY[i] = 0.0f;
+            pool.m_VelocityZ[i] = -2.0f;
+            // NOTE(sbalse): Dead ones land exactly on their lifetime during the step, which counts as dead.
+            pool.m_Age[i] = alive[i] ? 0.0f : 0.75f;
+            pool.m_Lifetime[i] = 1.0f;
+        }
+        return pool;
+    }
+
+    // NOTE(sbalse): Compacts a handmade pool with the scalar and the AVX2 path. Every particle that is alive has
+    // to come out exactly once and in order, nothing outside the range may be touched and both paths have to
+    // agree bit for bit.
+    bool TestParticlesCompaction()
+    {
+        const ParticleForces forces = { .m_Gravity = { 0.0f, 0.0f, 0.0f }, .m_Drag = 0.0f };
+        bool alive[TESTS_PARTICLE_COUNT] = {};
+
+        for (u32 pattern = 0; pattern < 4; pattern++)
+        {
+            u32 expectedCount = 0;
+            for (u32 i = 0; i < TESTS_PARTICLE_COUNT; i++)
+            {
+                const bool patterns[] = { true, false, i % 2 == 0, (RandomPhilox(33, i).m_Values[0] & 1) != 0 };
+                alive[i] = patterns[pattern];
+                expectedCount += i >= TESTS_PARTICLE_BEGIN && i < TESTS_PARTICLE_END && alive[i] ? 1 : 0;
+            }
+
+            static TestParticleStorage storage[2];
+            u32 counts[2] = {};
+            for (u32 mode = 0; mode < 2; mode++)
+            {
+                ParticlePool pool = TestMakeParticlePool(&storage[mode], alive);
+                ParticlesEnableSimd(mode == 1);
+                counts[mode] = ParticlesIntegrate(&pool, TESTS_PARTICLE_BEGIN, TESTS_PARTICLE_END, &forces, 0.25f);
+            }
+            ParticlesEnableSimd(true);
+            TEST_CHECK(counts[0] == expectedCount && counts[1] == expectedCount);
+
+            for (u32 mode = 0; mode < 2; mode++)
+            {
+                const float* ids = storage[mode].m_Streams[1] + TESTS_PARTICLE_BEGIN;
+                u32 next = 0;
+                bool survivorsMatch = true;
+                for (u32 i = TESTS_PARTICLE_BEGIN; i < TESTS_PARTICLE_END; i++)
+                {
+                    if (alive[i])
+                    {
+                        survivorsMatch = survivorsMatch && ids[next++] == static_cast<float>(i);
+                    }
+                }
+                TEST_CHECK(survivorsMatch);
+
+                bool untouched = true;
+                for (u32 i = 0; i < TESTS_PARTICLE_COUNT; i++)
+                {
+                    if (i < TESTS_PARTICLE_BEGIN || i >= TESTS_PARTICLE_END)
+                    {
+                        untouched = untouched
+                            && storage[mode].m_Streams[0][i] == static_cast<float>(i) * 0.5f
+                            && storage[mode].m_Streams[1][i] == TESTS_PARTICLE_UNTOUCHED
+                            && storage[mode].m_Streams[6][i] == (alive[i] ? 0.0f : 0.75f);
+                    }
+                }
+                TEST_CHECK(untouched);
+            }
+
+            bool identical = true;
+            for (u32 stream = 0; stream < 8; stream++)
+            {
+                identical = identical && std::memcmp(
+                    storage[0].m_Streams[stream] + TESTS_PARTICLE_BEGIN,
+                    storage[1].m_Streams[stream] + TESTS_PARTICLE_BEGIN,
+                    expectedCount * sizeof(float)) == 0;
+            }
+            TEST_CHECK(identical);
+        }
+        return true;
+    }
+
+    bool TestParticles()
+    {
+        TEST_CHECK(TestParticlesSimdMatchesScalar());
+        TEST_CHECK(TestParticlesCompaction());
+        return true;
+    }
+
+    constexpr u32 TESTS_DEFERRED_CHUNKS = 10;
+    constexpr u32 TESTS_DEFERRED_ORDER = 8;
+
+    struct TestDeferredItem
+    {
+        i64 m_ChunkTicks; // NOTE(sbalse): How long every chunk spins.
+        u32 m_Done; // NOTE(sbalse): Chunks finished so far.
+        u32 m_Calls;
+        u32* m_Order; // NOTE(sbalse): Where to log the call, when not null.
+        u32* m_OrderCount;
+        u32 m_Id;
+        DeferredResult m_Result;
+    };
+
+    // NOTE(sbalse): One chunk of work, finishes the item after TESTS_DEFERRED_CHUNKS of them.
+    DeferredResult TestDeferredChunk(void* context)
+    {
+        TestDeferredItem* work = static_cast<TestDeferredItem*>(context);
+        const i64 end = ClockNow() + work->m_ChunkTicks;
+        while (ClockNow() < end)
+        {
+        }
+        work->m_Done++;
+        return work->m_Done == TESTS_DEFERRED_CHUNKS ? DeferredResult::DONE : DeferredResult::MORE;
+    }
+
+    DeferredResult TestDeferredLog(void* context)
+    {
+        TestDeferredItem* work = static_cast<TestDeferredItem*>(context);
+        work->m_Calls++;
+        if (*work->m_OrderCount < TESTS_DEFERRED_ORDER)
+        {
+            work->m_Order[(*work->m_OrderCount)++] = work->m_Id;
+        }
+        return work->m_Result;
+    }
+
+    // NOTE(sbalse): Ten chunks of a quarter millisecond don't fit a budget of two milliseconds, so the item has
+    // to run over several frames and pick up where it stopped every time.
+    bool TestDeferredResume()
+    {
+        TestDeferredItem work =
+        {
+            .m_ChunkTicks = ClockSecondsToTicks(0.00025),
+            .m_Done = 0,
+            .m_Calls = 0,
+            .m_Order = nullptr,
+            .m_OrderCount = nullptr,
+            .m_Id = 0,
+            .m_Result = DeferredResult::MORE,
+        };
+        const u32 item = DeferredSubmit("resume", TestDeferredChunk, &work, DeferredPriority::NORMAL);
+        TEST_CHECK(item != DEFERRED_INVALID_ITEM);
+
+        DeferredRun(ClockNow() + ClockSecondsToTicks(0.002));
+        const DeferredStats* stats = DeferredGetStats();
+        TEST_CHECK(work.m_Done > 0 && work.m_Done < TESTS_DEFERRED_CHUNKS);
+        TEST_CHECK(stats->m_Chunks == work.m_Done && stats->m_Items == 1 && stats->m_BudgetMs > 0.0f);
+
+        // NOTE(sbalse): A frame without any time left runs nothing.
+        const u32 doneBefore = work.m_Done;
+        DeferredRun(ClockNow() - 1);
+        TEST_CHECK(work.m_Done == doneBefore && stats->m_Chunks == 0 && stats->m_BudgetMs == 0.0f);
+
+        // NOTE(sbalse): Lots of frames, in case the machine is busy and some of them get nothing done.
+        u32 frames = 0;
+        for (; frames < 200 && work.m_Done < TESTS_DEFERRED_CHUNKS; frames++)
+        {
+            DeferredRun(ClockNow() + ClockSecondsToTicks(0.002));
+        }
+        TEST_CHECK(work.m_Done == TESTS_DEFERRED_CHUNKS);
+        TEST_CHECK(stats->m_Items == 0);
+        TEST_CHECK(DeferredMostStarvedItem() == nullptr);
+        return true;
+    }
+
+    // NOTE(sbalse): Frames without time left starve everything queued. An item counts as starved once it has waited
+    // DEFERRED_STARVATION_FRAMES frames, is reported as the most starved one, and then goes before an item of
+    // higher priority that hasn't waited as long.
+    bool TestDeferredStarvation()
+    {
+        u32 order[TESTS_DEFERRED_ORDER] = {};
+        u32 orderCount = 0;
+        TestDeferredItem low =
+        {
+            .m_ChunkTicks = 0,
+            .m_Done = 0,
+            .m_Calls = 0,
+            .m_Order = order,
+            .m_OrderCount = &orderCount,
+            .m_Id = 1,
+            .m_Result = DeferredResult::IDLE,
+        };
+        TestDeferredItem high = low;
+        high.m_Id = 2;
+
+        const u32 lowItem = DeferredSubmit("low", TestDeferredLog, &low, DeferredPriority::LOW);
+        TEST_CHECK(lowItem != DEFERRED_INVALID_ITEM);
+        const DeferredStats* stats = DeferredGetStats();
+        for (u32 frame = 0; frame < DEFERRED_STARVATION_FRAMES / 2; frame++)
+        {
+            DeferredRun(ClockNow() - 1);
+        }
+        const u32 highItem = DeferredSubmit("high", TestDeferredLog, &high, DeferredPriority::HIGH);
+        TEST_CHECK(highItem != DEFERRED_INVALID_ITEM);
+        for (u32 frame = DEFERRED_STARVATION_FRAMES / 2; frame < DEFERRED_STARVATION_FRAMES - 1; frame++)
+        {
+            DeferredRun(ClockNow() - 1);
+        }
+        TEST_CHECK(stats->m_Items == 2 && stats->m_StarvedItems == 0);
+        TEST_CHECK(stats->m_MaxWaitFrames == DEFERRED_STARVATION_FRAMES - 1);
+
+        DeferredRun(ClockNow() - 1);
+        TEST_CHECK(stats->m_StarvedItems == 1 && stats->m_MaxWaitFrames == DEFERRED_STARVATION_FRAMES);
+        TEST_CHECK(DeferredMostStarvedItem() && std::strcmp(DeferredMostStarvedItem(), "low") == 0);
+        TEST_CHECK(low.m_Calls == 0 && high.m_Calls == 0);
+
+        // NOTE(sbalse): Idle items run once per frame, the starved one first.
+        DeferredRun(ClockNow() + ClockSecondsToTicks(0.01));
+        TEST_CHECK(orderCount == 2 && order[0] == low.m_Id && order[1] == high.m_Id);
+        TEST_CHECK(low.m_Calls == 1 && high.m_Calls == 1);
+        TEST_CHECK(stats->m_StarvedItems == 0 && stats->m_MaxWaitFrames == 0);
+
+        // NOTE(sbalse): With no one starved, priority decides again.
+        orderCount = 0;
+        DeferredRun(ClockNow() + ClockSecondsToTicks(0.01));
+        TEST_CHECK(orderCount == 2 && order[0] == high.m_Id && order[1] == low.m_Id);
+
+        DeferredCancel(lowItem);
+        DeferredCancel(highItem);
+        DeferredRun(ClockNow() - 1);
+        TEST_CHECK(stats->m_Items == 0);
+        return true;
+    }
+
+    bool TestDeferredWork()
+    {
+        TEST_CHECK(TestDeferredResume());
+        TEST_CHECK(TestDeferredStarvation());
+        return true;
+    }
+
+    // NOTE(sbalse): The untracked region ends in a partial page that isn't a whole number of four byte values.
+    constexpr u32 TESTS_REWIND_UNTRACKED = (3 * REWIND_PAGE_SIZE) + 101;
+    constexpr u32 TESTS_REWIND_TRACKED = 4 * REWIND_PAGE_SIZE;
+    constexpr u32 TESTS_REWIND_STATE = TESTS_REWIND_UNTRACKED + TESTS_REWIND_TRACKED;
+    constexpr u32 TESTS_REWIND_STEPS = 96;
+    constexpr u32 TESTS_REWIND_RESUMED_STEPS = 8; // NOTE(sbalse): Taken after going back to the oldest step.
+    // NOTE(sbalse): Room for about a dozen ordinary snapshots, the oldest are forgotten all along.
+    constexpr u64 TESTS_REWIND_BUDGET = 8192;
+
+    // NOTE(sbalse): The state the regions point into, the untracked one first.
+    struct TestRewindState
+    {
+        u8 m_Bytes[TESTS_REWIND_STATE];
+    };
+
+    // NOTE(sbalse): A few short runs of random bytes anywhere in the state, marking those in the tracked region. One
+    // always lands near the partial page and one across pages of the tracked region. Every tenth step also
+    // rewrites a whole page, which doesn't compress.
+    void TestRewindChange(Rewind* rewind, TestRewindState* state, const u64 step)
+    {
+        for (u32 change = 0; change < 6; change++)
+        {
+            const RandomBlock block = RandomPhilox(step, change);
+            const bool wholePage = change == 0 && step % 10 == 0;
+            u32 offset = block.m_Values[0] % TESTS_REWIND_STATE;
+            if (wholePage)
+            {
+                offset = (block.m_Values[0] % (TESTS_REWIND_STATE / REWIND_PAGE_SIZE)) * REWIND_PAGE_SIZE;
+            }
+            else if (change == 1)
+            {
+                offset = TESTS_REWIND_UNTRACKED - 1 - (block.m_Values[0] % 8);
+            }
+            else if (change == 2)
+            {
+                const u32 boundary = (1 + (block.m_Values[0] % 3)) * REWIND_PAGE_SIZE;
+                offset = TESTS_REWIND_UNTRACKED + boundary - 1 - (block.m_Values[3] % 8);
+            }
+            const u32 wanted = wholePage ? REWIND_PAGE_SIZE : 1 + (block.m_Values[1] % 48);
+            const u32 size = std::min(wanted, TESTS_REWIND_STATE - offset);
+            for (u32 i = 0; i < size; i++)
+            {
+                state->m_Bytes[offset + i] = static_cast<u8>(RandomPhilox(block.m_Values[2], i).m_Values[0]);
+            }
+
+            // NOTE(sbalse): A run can straddle both regions, only the tracked part is marked.
+            const u32 trackedBegin = std::max(offset, TESTS_REWIND_UNTRACKED);
+            if (offset + size > trackedBegin)
+            {
+                RewindMarkChanged(rewind, state->m_Bytes + trackedBegin, offset + size - trackedBegin);
+            }
+        }
+    }
+
+    // NOTE(sbalse): Takes a few dozen random steps keeping a copy of every state, restores some of them and checks
+    // them byte for byte. The budget only holds the last dozen or so, the ones before have to be refused.
+    bool TestRewindRestore()
+    {
+        TestRewindState* state = static_cast<TestRewindState*>(std::calloc(1, sizeof(TestRewindState)));
+        TestRewindState* copies = static_cast<TestRewindState*>(
+            std::calloc(TESTS_REWIND_STEPS + TESTS_REWIND_RESUMED_STEPS + 1, sizeof(TestRewindState)));
+        TEST_CHECK(state && copies);
+
+        const RewindRegion regions[] =
+        {
+            { .m_Data = state->m_Bytes, .m_Size = TESTS_REWIND_UNTRACKED, .m_Tracked = false },
+            { .m_Data = state->m_Bytes + TESTS_REWIND_UNTRACKED, .m_Size = TESTS_REWIND_TRACKED, .m_Tracked = true },
+        };
+        const RewindDesc desc =
+        {
+            .m_Regions = regions,
+            .m_RegionCount = static_cast<u32>(ArraySize(regions)),
+            .m_Budget = TESTS_REWIND_BUDGET,
+        };
+        Rewind* rewind = RewindCreate(&desc, 0);
+        TEST_CHECK(rewind);
+
+        bool captured = true;
+        bool withinBudget = true;
+        u64 allocated = 0;
+        u32 fewestKept = ~0u;
+        for (u64 step = 1; step <= TESTS_REWIND_STEPS; step++)
+        {
+            TestRewindChange(rewind, state, step);
+            copies[step] = *state;
+            captured = captured && RewindCapture(rewind, step);
+            const RewindStats stats = RewindGetStats(rewind);
+            withinBudget = withinBudget && stats.m_HistoryBytes <= TESTS_REWIND_BUDGET;
+            allocated += stats.m_DeltaBytes;
+            fewestKept = step > TESTS_REWIND_STEPS / 4 ? std::min(fewestKept, stats.m_SnapshotCount) : fewestKept;
+        }
+        TEST_CHECK(captured && withinBudget);
+        // NOTE(sbalse): Once the ring is full the deltas wrap around to its start. Forgetting everything whenever the
+        // end is reached would also stay in the budget, but leave a single snapshot now and then.
+        TEST_CHECK(fewestKept >= 6);
+        const RewindStats full = RewindGetStats(rewind);
+        // NOTE(sbalse): Far more went through the ring than it holds, with more than one snapshot kept all along.
+        TEST_CHECK(allocated > 4 * TESTS_REWIND_BUDGET);
+        TEST_CHECK(full.m_NewestStep == TESTS_REWIND_STEPS && full.m_OldestStep > 1);
+        TEST_CHECK(full.m_SnapshotCount == TESTS_REWIND_STEPS + 1 - full.m_OldestStep);
+        TEST_CHECK(full.m_SnapshotCount > 4);
+
+        // NOTE(sbalse): Steps that were forgotten are refused without touching anything, even with the regions
+        // changed since the newest snapshot.
+        TestRewindChange(rewind, state, 1000);
+        const TestRewindState changed = *state;
+        bool refused = true;
+        for (u64 step = 0; step < full.m_OldestStep; step++)
+        {
+            refused = refused && !RewindRestore(rewind, step);
+        }
+        TEST_CHECK(refused && std::memcmp(state, &changed, sizeof(changed)) == 0);
+        TEST_CHECK(RewindGetStats(rewind).m_SnapshotCount == full.m_SnapshotCount);
+
+        // NOTE(sbalse): Back a little, then all the way to the oldest kept. Restoring drops what came after.
+        const u64 targets[] = { TESTS_REWIND_STEPS, TESTS_REWIND_STEPS - 3, full.m_OldestStep + 1, full.m_OldestStep };
+        for (const u64 target : targets)
+        {
+            TEST_CHECK(RewindRestore(rewind, target));
+            TEST_CHECK(std::memcmp(state, &copies[target], sizeof(TestRewindState)) == 0);
+            TEST_CHECK(RewindGetStats(rewind).m_NewestStep == target);
+        }
+        TEST_CHECK(!RewindRestore(rewind, full.m_OldestStep + 1));
+        TEST_CHECK(RewindGetStats(rewind).m_SnapshotCount == 1);
+
+        // NOTE(sbalse): The history carries on from the restored step.
+        const u64 resumed = full.m_OldestStep;
+        for (u64 step = resumed + 1; step <= resumed + TESTS_REWIND_RESUMED_STEPS; step++)
+        {
+            TestRewindChange(rewind, state, step + 500);
+            copies[step] = *state;
+            TEST_CHECK(RewindCapture(rewind, step));
+        }
+        TestRewindChange(rewind, state, 2000);
+        for (const u64 target : { resumed + 6, resumed + 2, resumed })
+        {
+            TEST_CHECK(RewindRestore(rewind, target));
+            TEST_CHECK(std::memcmp(state, &copies[target], sizeof(TestRewindState)) == 0);
+        }
+
+        RewindDestroy(rewind);
+        std::free(copies);
+        std::free(state);
+        return true;
+    }
+
+    constexpr Test g_Tests[] =
+    {
+        { "telemetry", TestTelemetry },
+        { "processmemory", TestProcessMemory },
+        { "actionmap", TestActionMap },
+        { "actionmaprandom", TestActionMapRandom },
+        { "resourceinterning", TestResourceInterning },
+        { "resourcedestroy", TestResourceDelayedDestroy },
+        { "resourcegenerations", TestResourceGenerations },
+        { "quantizesnorm16", TestQuantizeSnorm16 },
+        { "quantizehalf", TestQuantizeHalf },
+        { "quantizeoctahedral", TestQuantizeOctahedral },
+        { "quantizekernels", TestQuantizeKernels },
+        { "scenefilereplace", TestSceneFileReplace },
+        { "jobsthreadindex", TestJobsThreadIndex },
+        { "jobsdeterminism", TestJobsDeterminism },
+        { "taskgraph", TestTaskGraph },
+        { "dynamicresolution", TestDynamicResolution },
+        { "broadphase", TestBroadphase },
+        { "lightclusters", TestLightClusters },
+        { "framecapture", TestFrameCapture },
+        { "rendergraph", TestRenderGraph },
+        { "texture", TestTexture },
+        { "animclip", TestAnimClip },
+        { "tweens", TestTweens },
+        { "particles", TestParticles },
+        { "deferredwork", TestDeferredWork },
+        { "rewind", TestRewindRestore },
+    };
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 2 && std::strcmp(argv[1], TESTS_TELEMETRY_WRITER) == 0)
+    {
+        return TestTelemetryWriter(argv[2]);
+    }
+
+    g_ExecutablePath = argv[0];
+    ClockInit();
+
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+
+    u32 failed = 0;
+    for (u32 i = 0; i < ArraySize(g_Tests); i++)
+    {
+        const Test* test = &g_Tests[i];
+        if (filter && !std::strstr(test->m_Name, filter))
+        {
+            continue;
+        }
+
+        const i64 start = ClockNow();
+        const bool passed = test->m_Run();
+        const double seconds = ClockTicksToSeconds(ClockNow() - start);
+
+        std::printf("%-20s %-6s %10.3f ms\n", test->m_Name, passed ? "ok" : "FAILED", seconds * 1'000.0);
+        failed += passed ? 0 : 1;
+    }
+
+    return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,417 @@
+#include "tweens.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <immintrin.h>
+
+#include "cpufeatures.h"
+#include "jobs.h"
+
+namespace
+{
+    // NOTE(sbalse): Both ends of every segment are stored, the last sample of a curve is its value at 1.
+    constexpr u32 TWEENS_CURVE_STRIDE = TWEENS_CURVE_SEGMENTS + 1;
+    constexpr u32 TWEENS_SLOT_BITS = 24;
+    constexpr u32 TWEENS_SLOT_MASK = (1u << TWEENS_SLOT_BITS) - 1;
+    constexpr float TWEENS_PI = 3.14159265f;
+
+    constinit bool g_TweensSimdRequested = true;
+}
+
+struct TweenPool
+{
+    u32 m_Count;
+    u32 m_Capacity;
+    u32 m_CurveCount;
+    u32 m_FreeCount;
+
+    // NOTE(sbalse): Live tweens are packed into [0, m_Count). Phase is in durations played, wrapped into [0, 1]
+    // when clamping and looping and into [0, 2) when going back and forth.
+    float* m_Phase;
+    float* m_Rate; // NOTE(sbalse): Durations per second.
+    float* m_From;
+    float* m_Delta;
+    u32* m_CurveOffset; // NOTE(sbalse): Index of the first sample of the curve.
+    u32* m_Index;
+    u8* m_Wrap;
+    u8* m_Stream;
+
+    // NOTE(sbalse): Handles name slots, which stay put while tweens are moved around to keep the pool packed.
+    u32* m_DenseToSlot;
+    u32* m_SlotToDense;
+    u32* m_FreeSlots;
+    u8* m_Generation;
+
+    u32* m_Storage;
+    u8* m_ByteStorage;
+
+    float m_Samples[TWEENS_MAX_CURVES * TWEENS_CURVE_STRIDE];
+};
+
+namespace
+{
+    struct TweensUpdateJob
+    {
+        TweenPool* m_Pool;
+        float m_StepSeconds;
+        float* const* m_Outputs;
+    };
+
+    float TweensEase(const TweenEase ease, const float t)
+    {
+        switch (ease)
+        {
+            case TweenEase::LINEAR: return t;
+            case TweenEase::INQUAD: return t * t;
+            case TweenEase::OUTQUAD: return t * (2.0f - t);
+            case TweenEase::INOUTQUAD: return t < 0.5f ? 2.0f * t * t : 1.0f - 2.0f * (1.0f - t) * (1.0f - t);
+            case TweenEase::INCUBIC: return t * t * t;
+            case TweenEase::OUTCUBIC: return 1.0f - (1.0f - t) * (1.0f - t) * (1.0f - t);
+            case TweenEase::INOUTCUBIC:
+                return t < 0.5f ? 4.0f * t * t * t : 1.0f - 4.0f * (1.0f - t) * (1.0f - t) * (1.0f - t);
+            case TweenEase::INOUTSINE: return 0.5f - std::cos(TWEENS_PI * t) * 0.5f;
+            default: return t;
+        }
+    }
+
+    // NOTE(sbalse): Where in the curve a phase is, from 0 to 1.
+    float TweensCurvePosition(const float phase, const TweenWrap wrap)
+    {
+        return wrap == TweenWrap::PINGPONG ? 1.0f - std::fabs(phase - 1.0f) : phase;
+    }
+
+    float TweensWrapPhase(const float phase, const TweenWrap wrap)
+    {
+        switch (wrap)
+        {
+            case TweenWrap::LOOP: return phase - std::floor(phase);
+            case TweenWrap::PINGPONG: return phase - 2.0f * std::floor(phase * 0.5f);
+            default: return phase < 1.0f ? phase : 1.0f;
+        }
+    }
+
+    float TweensSampleCurve(const TweenPool* pool, const u32 curveOffset, const float position)
+    {
+        const float scaled = position * static_cast<float>(TWEENS_CURVE_SEGMENTS);
+        u32 segment = static_cast<u32>(scaled);
+        segment = segment < TWEENS_CURVE_SEGMENTS - 1 ? segment : TWEENS_CURVE_SEGMENTS - 1;
+        const float t = scaled - static_cast<float>(segment);
+
+        const float a = pool->m_Samples[curveOffset + segment];
+        const float b = pool->m_Samples[curveOffset + segment + 1];
+        return a + (b - a) * t;
+    }
+
+    void TweensUpdateScalar(TweenPool* pool, const u32 i, const float stepSeconds, float* const* outputs)
+    {
+        const TweenWrap wrap = static_cast<TweenWrap>(pool->m_Wrap[i]);
+        const float phase = TweensWrapPhase(pool->m_Phase[i] + pool->m_Rate[i] * stepSeconds, wrap);
+        pool->m_Phase[i] = phase;
+
+        const float value = TweensSampleCurve(pool, pool->m_CurveOffset[i], TweensCurvePosition(phase, wrap));
+        outputs[pool->m_Stream[i]][pool->m_Index[i]] = pool->m_From[i] + pool->m_Delta[i] * value;
+    }
+
+    // NOTE(sbalse): Eight tweens per iteration, every wrap is computed and the right one picked per lane. The
+    // samples around each position are gathered, the values are scattered one lane at a time. Returns the first
+    // tween not updated.
+    CPU_AVX2 u32 TweensUpdateAvx2(
+        TweenPool* pool,
+        u32 i,
+        const u32 end,
+        const float stepSeconds,
+        float* const* outputs)
+    {
+        const __m256 step = _mm256_set1_ps(stepSeconds);
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 two = _mm256_set1_ps(2.0f);
+        const __m256 half = _mm256_set1_ps(0.5f);
+        const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+        const __m256 segments = _mm256_set1_ps(static_cast<float>(TWEENS_CURVE_SEGMENTS));
+        const __m256i lastSegment = _mm256_set1_epi32(TWEENS_CURVE_SEGMENTS - 1);
+        const __m256i loop = _mm256_set1_epi32(static_cast<int>(TweenWrap::LOOP));
+        const __m256i pingPong = _mm256_set1_epi32(static_cast<int>(TweenWrap::PINGPONG));
+
+        alignas(32) float values[8] = {};
+        for (; i + 8 <= end; i += 8)
+        {
+            const __m128i wrapBytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(pool->m_Wrap + i));
+            const __m256i wrap = _mm256_cvtepu8_epi32(wrapBytes);
+            const __m256 isLoop = _mm256_castsi256_ps(_mm256_cmpeq_epi32(wrap, loop));
+            const __m256 isPingPong = _mm256_castsi256_ps(_mm256_cmpeq_epi32(wrap, pingPong));
+
+            __m256 phase = _mm256_add_ps(
+                _mm256_loadu_ps(pool->m_Phase + i),
+                _mm256_mul_ps(_mm256_loadu_ps(pool->m_Rate + i), step));
+            const __m256 clamped = _mm256_min_ps(phase, one);
+            const __m256 looped = _mm256_sub_ps(phase, _mm256_floor_ps(phase));
+            const __m256 pingPonged = _mm256_sub_ps(
+                phase,
+                _mm256_mul_ps(two, _mm256_floor_ps(_mm256_mul_ps(phase, half))));
+            phase = _mm256_blendv_ps(clamped, looped, isLoop);
+            phase = _mm256_blendv_ps(phase, pingPonged, isPingPong);
+            _mm256_storeu_ps(pool->m_Phase + i, phase);
+
+            const __m256 folded = _mm256_sub_ps(one, _mm256_and_ps(_mm256_sub_ps(phase, one), absMask));
+            const __m256 position = _mm256_blendv_ps(phase, folded, isPingPong);
+            const __m256 scaled = _mm256_mul_ps(position, segments);
+            const __m256i segment = _mm256_min_epi32(_mm256_cvttps_epi32(scaled), lastSegment);
+            const __m256 t = _mm256_sub_ps(scaled, _mm256_cvtepi32_ps(segment));
+
+            const __m256i sample = _mm256_add_epi32(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pool->m_CurveOffset + i)),
+                segment);
+            const __m256 a = _mm256_i32gather_ps(pool->m_Samples, sample, 4);
+            const __m256 b = _mm256_i32gather_ps(pool->m_Samples + 1, sample, 4);
+            const __m256 value = _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(b, a), t));
+            _mm256_store_ps(values, _mm256_add_ps(
+                _mm256_loadu_ps(pool->m_From + i),
+                _mm256_mul_ps(_mm256_loadu_ps(pool->m_Delta + i), value)));
+
+            for (u32 lane = 0; lane < 8; lane++)
+            {
+                outputs[pool->m_Stream[i + lane]][pool->m_Index[i + lane]] = values[lane];
+            }
+        }
+        return i;
+    }
+
+    void TweensUpdateRange(void* context, const u32 begin, const u32 end)
+    {
+        const TweensUpdateJob* job = static_cast<const TweensUpdateJob*>(context);
+
+        u32 i = begin;
+        if (TweensSimdEnabled())
+        {
+            i = TweensUpdateAvx2(job->m_Pool, begin, end, job->m_StepSeconds, job->m_Outputs);
+        }
+        for (; i < end; i++)
+        {
+            TweensUpdateScalar(job->m_Pool, i, job->m_StepSeconds, job->m_Outputs);
+        }
+    }
+
+    void TweensMove(TweenPool* pool, const u32 from, const u32 to)
+    {
+        pool->m_Phase[to] = pool->m_Phase[from];
+        pool->m_Rate[to] = pool->m_Rate[from];
+        pool->m_From[to] = pool->m_From[from];
+        pool->m_Delta[to] = pool->m_Delta[from];
+        pool->m_CurveOffset[to] = pool->m_CurveOffset[from];
+        pool->m_Index[to] = pool->m_Index[from];
+        pool->m_Wrap[to] = pool->m_Wrap[from];
+        pool->m_Stream[to] = pool->m_Stream[from];
+
+        const u32 slot = pool->m_DenseToSlot[from];
+        pool->m_DenseToSlot[to] = slot;
+        pool->m_SlotToDense[slot] = to;
+    }
+}
+
+TweenPool* TweenPoolCreate(const u32 capacity)
+{
+    if (capacity > TWEENS_MAX_TWEENS)
+    {
+        return nullptr;
+    }
+
+    TweenPool* pool = static_cast<TweenPool*>(std::calloc(1, sizeof(TweenPool)));
+    if (!pool)
+    {
+        return nullptr;
+    }
+
+    // NOTE(sbalse): Nine arrays of four bytes per tween and three of one byte.
+    const size_t elements = capacity;
+    pool->m_Storage = static_cast<u32*>(std::calloc(elements * 9, sizeof(u32)));
+    pool->m_ByteStorage = static_cast<u8*>(std::calloc(elements * 3, sizeof(u8)));
+    if (!pool->m_Storage || !pool->m_ByteStorage)
+    {
+        TweenPoolDestroy(pool);
+        return nullptr;
+    }
+
+    pool->m_Capacity = capacity;
+    pool->m_Phase = reinterpret_cast<float*>(pool->m_Storage);
+    pool->m_Rate = reinterpret_cast<float*>(pool->m_Storage + elements);
+    pool->m_From = reinterpret_cast<float*>(pool->m_Storage + (elements * 2));
+    pool->m_Delta = reinterpret_cast<float*>(pool->m_Storage + (elements * 3));
+    pool->m_CurveOffset = pool->m_Storage + (elements * 4);
+    pool->m_Index = pool->m_Storage + (elements * 5);
+    pool->m_DenseToSlot = pool->m_Storage + (elements * 6);
+    pool->m_SlotToDense = pool->m_Storage + (elements * 7);
+    pool->m_FreeSlots = pool->m_Storage + (elements * 8);
+    pool->m_Wrap = pool->m_ByteStorage;
+    pool->m_Stream = pool->m_ByteStorage + elements;
+    pool->m_Generation = pool->m_ByteStorage + (elements * 2);
+
+    // NOTE(sbalse): Hand out the low slots first.
+    for (u32 i = 0; i < capacity; i++)
+    {
+        pool->m_FreeSlots[i] = capacity - 1 - i;
+    }
+    pool->m_FreeCount = capacity;
+
+    for (u32 ease = 0; ease < static_cast<u32>(TweenEase::COUNT); ease++)
+    {
+        float* samples = pool->m_Samples + (ease * TWEENS_CURVE_STRIDE);
+        for (u32 i = 0; i < TWEENS_CURVE_STRIDE; i++)
+        {
+            const float t = static_cast<float>(i) / static_cast<float>(TWEENS_CURVE_SEGMENTS);
+            samples[i] = TweensEase(static_cast<TweenEase>(ease), t);
+        }
+    }
+    pool->m_CurveCount = static_cast<u32>(TweenEase::COUNT);
+
+    return pool;
+}
+
+void TweenPoolDestroy(TweenPool* pool)
+{
+    if (!pool)
+    {
+        return;
+    }
+    std::free(pool->m_ByteStorage);
+    std::free(pool->m_Storage);
+    std::free(pool);
+}
+
+TweenCurve TweenPoolAddCurve(TweenPool* pool, const TweenKey* keys, const u32 keyCount)
+{
+    if (pool->m_CurveCount == TWEENS_MAX_CURVES || keyCount == 0)
+    {
+        return TWEENS_INVALID_CURVE;
+    }
+    for (u32 i = 1; i < keyCount; i++)
+    {
+        if (!(keys[i].m_Time >= keys[i - 1].m_Time))
+        {
+            return TWEENS_INVALID_CURVE;
+        }
+    }
+
+    const TweenCurve curve = pool->m_CurveCount++;
+    float* samples = pool->m_Samples + (curve * TWEENS_CURVE_STRIDE);
+
+    u32 key = 0;
+    for (u32 i = 0; i < TWEENS_CURVE_STRIDE; i++)
+    {
+        const float t = static_cast<float>(i) / static_cast<float>(TWEENS_CURVE_SEGMENTS);
+        while (key < keyCount && keys[key].m_Time <= t)
+        {
+            key++;
+        }
+
+        if (key == 0)
+        {
+            samples[i] = keys[0].m_Value;
+        }
+        else if (key == keyCount)
+        {
+            samples[i] = keys[keyCount - 1].m_Value;
+        }
+        else
+        {
+            const TweenKey* a = &keys[key - 1];
+            const TweenKey* b = &keys[key];
+            const float blend = (t - a->m_Time) / (b->m_Time - a->m_Time);
+            samples[i] = a->m_Value + (b->m_Value - a->m_Value) * blend;
+        }
+    }
+    return curve;
+}
+
+TweenHandle TweenAdd(TweenPool* pool, const TweenDesc* desc)
+{
+    const bool valid = desc->m_Curve < pool->m_CurveCount
+        && desc->m_Wrap < TweenWrap::COUNT
+        && desc->m_Stream < TWEENS_MAX_STREAMS
+        && desc->m_Duration > 0.0f
+        && std::isfinite(desc->m_Duration)
+        && std::isfinite(desc->m_Offset)
+        && std::isfinite(desc->m_From)
+        && std::isfinite(desc->m_Delta);
+    if (!valid || pool->m_FreeCount == 0)
+    {
+        return TWEENS_INVALID_HANDLE;
+    }
+
+    const u32 slot = pool->m_FreeSlots[--pool->m_FreeCount];
+    const u32 dense = pool->m_Count++;
+    pool->m_DenseToSlot[dense] = slot;
+    pool->m_SlotToDense[slot] = dense;
+
+    // NOTE(sbalse): A negative offset wraps around, except when clamping where the tween starts at the start.
+    const float phase = TweensWrapPhase(desc->m_Offset / desc->m_Duration, desc->m_Wrap);
+    pool->m_Phase[dense] = phase > 0.0f ? phase : 0.0f;
+    pool->m_Rate[dense] = 1.0f / desc->m_Duration;
+    pool->m_From[dense] = desc->m_From;
+    pool->m_Delta[dense] = desc->m_Delta;
+    pool->m_CurveOffset[dense] = desc->m_Curve * TWEENS_CURVE_STRIDE;
+    pool->m_Index[dense] = desc->m_Index;
+    pool->m_Wrap[dense] = static_cast<u8>(desc->m_Wrap);
+    pool->m_Stream[dense] = static_cast<u8>(desc->m_Stream);
+
+    return (static_cast<u32>(pool->m_Generation[slot]) << TWEENS_SLOT_BITS) | slot;
+}
+
+void TweenRemove(TweenPool* pool, const TweenHandle handle)
+{
+    const u32 slot = handle & TWEENS_SLOT_MASK;
+    if (slot >= pool->m_Capacity || pool->m_Generation[slot] != (handle >> TWEENS_SLOT_BITS))
+    {
+        return;
+    }
+
+    const u32 dense = pool->m_SlotToDense[slot];
+    if (dense >= pool->m_Count || pool->m_DenseToSlot[dense] != slot)
+    {
+        return; // NOTE(sbalse): The slot is free.
+    }
+
+    const u32 last = --pool->m_Count;
+    if (dense != last)
+    {
+        TweensMove(pool, last, dense);
+    }
+    pool->m_Generation[slot]++;
+    pool->m_FreeSlots[pool->m_FreeCount++] = slot;
+}
+
+u32 TweenPoolGetCount(const TweenPool* pool)
+{
+    return pool->m_Count;
+}
+
+float* TweenPoolGetPhases(TweenPool* pool)
+{
+    return pool->m_Phase;
+}
+
+void TweenPoolUpdate(TweenPool* pool, const float stepSeconds, float* const* outputs)
+{
+    TweensUpdateJob job =
+    {
+        .m_Pool = pool,
+        .m_StepSeconds = stepSeconds,
+        .m_Outputs = outputs,
+    };
+
+    if (pool->m_Count <= TWEENS_JOB_BATCH)
+    {
+        TweensUpdateRange(&job, 0, pool->m_Count);
+        return;
+    }
+    JobsWait(JobsDispatch(pool->m_Count, TWEENS_JOB_BATCH, TweensUpdateRange, &job));
+}
+
+void TweensEnableSimd(const bool enabled)
+{
+    g_TweensSimdRequested = enabled;
+}
+
+bool TweensSimdEnabled()
+{
+    return g_TweensSimdRequested && CpuHasAvx2();
+}
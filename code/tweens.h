@@ -0,0 +1,100 @@
+#pragma once
+#include "types.h"
+
+/*
+* NOTE(sbalse): Tweens animate one float each, from a start value by some delta along a curve, over a duration.
+* At the end a tween either holds, starts over or plays backwards. Curves are easing functions or keyframes and
+* any number of tweens share one curve.
+*
+* The state of every tween, including where it is in its curve, lives in a pool stored as structure of arrays.
+* An update advances and evaluates eight tweens at a time with AVX2 where the CPU has it, large pools are cut
+* into batches for the job workers, and the values are written straight into the float streams the tweens
+* target. The scalar and the AVX2 path give the same results bit for bit.
+*
+* Curves are resampled into TWEENS_CURVE_SEGMENTS linear segments when they are created, so all curves cost the
+* same to evaluate. The easing curves stay within 2e-4 of the exact functions, keyframes closer together than a
+* segment get rounded off.
+*/
+
+constexpr u32 TWEENS_CURVE_SEGMENTS = 64;
+constexpr u32 TWEENS_MAX_CURVES = 64;
+// NOTE(sbalse): Handles keep the slot in their low 24 bits.
+constexpr u32 TWEENS_MAX_TWEENS = (1u << 24) - 1;
+constexpr u32 TWEENS_MAX_STREAMS = 256;
+// NOTE(sbalse): Pools are cut into batches of this many tweens for the job workers.
+constexpr u32 TWEENS_JOB_BATCH = 16384;
+
+using TweenHandle = u32;
+using TweenCurve = u32;
+
+constexpr TweenHandle TWEENS_INVALID_HANDLE = ~0u;
+constexpr TweenCurve TWEENS_INVALID_CURVE = ~0u;
+
+// NOTE(sbalse): Every pool starts out with these curves, the curve of an ease is its value.
+enum class TweenEase
+{
+    LINEAR,
+    INQUAD,
+    OUTQUAD,
+    INOUTQUAD,
+    INCUBIC,
+    OUTCUBIC,
+    INOUTCUBIC,
+    INOUTSINE,
+    COUNT
+};
+
+enum class TweenWrap
+{
+    CLAMP, // NOTE(sbalse): Holds the end value.
+    LOOP, // NOTE(sbalse): Jumps back to the start value.
+    PINGPONG, // NOTE(sbalse): Plays backwards to the start value, then forwards again.
+    COUNT
+};
+
+struct TweenKey
+{
+    float m_Time; // NOTE(sbalse): From 0 at the start of the tween to 1 at the end.
+    float m_Value; // NOTE(sbalse): 0 is the start value of the tween and 1 the end value.
+};
+
+struct TweenDesc
+{
+    float m_From;
+    float m_Delta; // NOTE(sbalse): The end value is m_From + m_Delta.
+    float m_Duration; // NOTE(sbalse): Seconds, one way.
+    float m_Offset; // NOTE(sbalse): Seconds already played when the tween is added.
+    TweenCurve m_Curve;
+    TweenWrap m_Wrap;
+    // NOTE(sbalse): The value is written to element m_Index of stream m_Stream of the outputs of every update.
+    u32 m_Stream;
+    u32 m_Index;
+};
+
+struct TweenPool;
+
+constexpr TweenCurve TweenEaseCurve(const TweenEase ease)
+{
+    return static_cast<TweenCurve>(ease);
+}
+
+TweenPool* TweenPoolCreate(const u32 capacity);
+void TweenPoolDestroy(TweenPool* pool);
+// NOTE(sbalse): Keys must be in order of time. The curve is linear between keys and holds the first and the last
+// key before and after them. Returns TWEENS_INVALID_CURVE when the keys are invalid or the pool has no room.
+TweenCurve TweenPoolAddCurve(TweenPool* pool, const TweenKey* keys, const u32 keyCount);
+// NOTE(sbalse): Returns TWEENS_INVALID_HANDLE when the pool is full or the description is invalid.
+TweenHandle TweenAdd(TweenPool* pool, const TweenDesc* desc);
+// NOTE(sbalse): Stale handles are ignored.
+void TweenRemove(TweenPool* pool, const TweenHandle handle);
+u32 TweenPoolGetCount(const TweenPool* pool);
+// NOTE(sbalse): Where the TweenPoolGetCount() live tweens are in their curves. Updates change nothing else, so
+// saving the phases and writing them back later rewinds the pool, as long as no tweens were added or removed.
+float* TweenPoolGetPhases(TweenPool* pool);
+// NOTE(sbalse): Advances every tween by stepSeconds and writes its value to its element of outputs. No two tweens
+// may target the same element, batches of the pool write to them concurrently.
+void TweenPoolUpdate(TweenPool* pool, const float stepSeconds, float* const* outputs);
+
+// NOTE(sbalse): The scalar and the AVX2 path give the same results bit for bit, this only exists to compare them.
+void TweensEnableSimd(const bool enabled);
+bool TweensSimdEnabled();
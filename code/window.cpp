@@ -21,17 +21,37 @@ LRESULT Window::WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
         return 0;
     } break;
 
+    case WM_SETFOCUS:
+    {
+        Window* window = reinterpret_cast<Window*>(GetWindowLongPtr(hWnd, GWLP_USERDATA));
+        if (window)
+        {
+            window->m_IsFocused = true;
+        }
+    } break;
+
     case WM_KILLFOCUS:
     {
         // NOTE(sbalse): Clear all input state when window loses focus so we don't have zombie key presses
         // hanging around.
         bool clearPrevFrameInput = true;
         InputClear(clearPrevFrameInput);
+
+        Window* window = reinterpret_cast<Window*>(GetWindowLongPtr(hWnd, GWLP_USERDATA));
+        if (window)
+        {
+            window->m_IsFocused = false;
+        }
     } break;
 
     case WM_ACTIVATEAPP:
     {
-        OutputDebugStringA("WM_ACTIVATEAPP\n");
+        // NOTE(sbalse): wParam is TRUE when one of our windows is being activated.
+        Window* window = reinterpret_cast<Window*>(GetWindowLongPtr(hWnd, GWLP_USERDATA));
+        if (window)
+        {
+            window->m_IsFocused = (wParam != FALSE);
+        }
     } break;
 
     case WM_SYSKEYDOWN:
@@ -192,6 +212,11 @@ void Window::SetApplicationName(const LPCWSTR name) const
     SetWindowText(m_WindowHandle, name);
 }
 
+void Window::WaitForMessages() const
+{
+    WaitMessage();
+}
+
 void Window::ProcessMessages()
 {
     MSG msg = {};
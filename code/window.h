@@ -11,6 +11,7 @@ private:
     LPCWSTR m_ApplicationName;
     HWND m_WindowHandle;
     bool m_IsRunning;
+    bool m_IsFocused;
 
     static LRESULT CALLBACK WndProc(HWND window, UINT msg, WPARAM wParam, LPARAM lParam);
 
@@ -21,6 +22,7 @@ public:
         , m_ApplicationName{ nullptr }
         , m_WindowHandle{ nullptr }
         , m_IsRunning{ false }
+        , m_IsFocused{ false }
     {
     }
 
@@ -29,8 +31,11 @@ public:
     void Destroy();
     void SetApplicationName(const LPCWSTR name) const;
     void ProcessMessages();
+    // NOTE(sbalse): Blocks until the window receives a message.
+    void WaitForMessages() const;
     HWND GetWindowHandle() const { return m_WindowHandle; }
     int GetWidth() const { return m_Width; }
     int GetHeight() const { return m_Height; }
     bool IsRunning() const { return m_IsRunning; }
+    bool IsFocused() const { return m_IsFocused; }
 };